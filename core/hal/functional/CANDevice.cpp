@@ -19,16 +19,44 @@
 
 #include "CANDevice.h"
 
+#include <time.h>
+
+#include <QMetaMethod>
+#include <QThread>
+#include <cstring>
+
 #include "../../services/logging/Logger.h"
+#include "../transport/SocketCANTransport.h"
+
+namespace {
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+}  // namespace
 
 CANDevice::CANDevice(Transport* transport, QObject* parent)
     : FunctionalDevice(transport, parent),
       m_state(DeviceState::OFFLINE),
-      m_bitRate(500000) {  // Default 500 kbps
-
-  // Connect to transport signals
-  if (m_transport) {
-    connect(m_transport, &Transport::dataReceived, this, &CANDevice::onTransportDataReceived);
+      m_bitRate(500000),  // Default 500 kbps
+      m_socketCAN(qobject_cast<SocketCANTransport*>(transport)),
+      m_handoffHead(0),
+      m_handoffTail(0),
+      m_handoffPosted(false),
+      m_handoffDropped(0) {
+  // Connect to transport signals. Direct, so a transport on an I/O reactor
+  // has its data decoded on the reactor thread; see publish().
+  if (m_socketCAN) {
+    // Native frames: no encoding, one wakeup per drained batch
+    connect(m_socketCAN, &SocketCANTransport::framesReceived, this, &CANDevice::onSocketCANFrames,
+            Qt::DirectConnection);
+    connect(m_socketCAN, &Transport::errorOccurred, this, &CANDevice::busError);
+  } else if (m_transport) {
+    connect(m_transport, &Transport::dataReceived, this, &CANDevice::onTransportDataReceived,
+            Qt::DirectConnection);
   }
 }
 
@@ -103,26 +131,61 @@ QVariant CANDevice::getConfig(const QString& key) const {
 }
 
 bool CANDevice::sendMessage(const CANMessage& message) {
+  const int maxLength = message.fd ? CANFrame::kMaxFdLength : CANFrame::kMaxClassicLength;
+  if (message.data.size() > maxLength) {
+    return false;
+  }
+
+  CANFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.id = message.id;
+  frame.length = static_cast<quint8>(message.data.size());
+  frame.extended = message.extended;
+  frame.rtr = message.rtr;
+  frame.fd = message.fd;
+  frame.bitRateSwitch = message.fd && message.bitRateSwitch;
+  memcpy(frame.data, message.data.constData(), message.data.size());
+  return sendFrame(frame);
+}
+
+bool CANDevice::sendFrame(const CANFrame& frame) {
   if (!isOnline() || !m_transport) {
     return false;
   }
 
-  // Encode CAN message based on transport protocol
-  // USB-CAN adapters might use ASCII commands (e.g., "t1230112233445566\r")
-  // SPI-CAN controllers use binary register writes
-  // Native CAN uses SocketCAN frame format
+  if (m_socketCAN) {
+    return sendSocketCAN(frame);
+  }
+
+  // SPI-CAN controllers would need binary register writes; USB-CAN adapters
+  // take SLCAN commands (e.g., "t1230112233445566\r")
+  char command[SlcanParser::kMaxLineLength + 1];
+  const int length = SlcanParser::encode(frame, command);
+  if (length == 0) {
+    return false;
+  }
+  return m_transport->write(QByteArray::fromRawData(command, length)) == length;
+}
 
-  QByteArray encoded;
-  // TODO: Implement encoding based on transport type
-  // For now, simple example:
-  QString cmd = QString("t%1%2%3\r")
-                    .arg(message.id, 3, 16, QChar('0'))
-                    .arg(message.data.size(), 1, 16)
-                    .arg(QString::fromLatin1(message.data.toHex()));
-  encoded = cmd.toLatin1();
+bool CANDevice::sendSocketCAN(const CANFrame& frame) {
+  if (frame.length > (frame.fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN)) {
+    return false;
+  }
 
-  qint64 written = m_transport->write(encoded);
-  return written == encoded.size();
+  SocketCANTransport::Frame native;
+  memset(&native, 0, sizeof(native));
+  native.fd = frame.fd;
+  native.frame.can_id = frame.extended ? ((frame.id & CAN_EFF_MASK) | CAN_EFF_FLAG)
+                                       : (frame.id & CAN_SFF_MASK);
+  if (frame.rtr && !frame.fd) {
+    native.frame.can_id |= CAN_RTR_FLAG;
+  }
+  native.frame.len = frame.length;
+  if (frame.fd && frame.bitRateSwitch) {
+    native.frame.flags = CANFD_BRS;
+  }
+  memcpy(native.frame.data, frame.data, frame.length);
+  return m_socketCAN->writeFrames(&native, 1) == 1;
 }
 
 bool CANDevice::setBitRate(quint32 bitRate) {
@@ -151,65 +214,122 @@ void CANDevice::onTransportDataReceived() {
     return;
   }
 
-  // Read available data from transport
-  QByteArray data = m_transport->read();
-  if (data.isEmpty()) {
-    return;
+  // USB-CAN adapters send SLCAN text (e.g., "t12301122334455\r"). Lines
+  // split across reads stay in the parser's ring until the rest arrives.
+  const qint64 now = monotonicNs();
+  qint64 size = 0;
+  while ((size = m_transport->readInto(m_readBuffer)) > 0) {
+    const char* bytes = m_readBuffer;
+    int remaining = static_cast<int>(size);
+    while (remaining > 0) {
+      const int accepted = m_parser.append(bytes, remaining);
+      bytes += accepted;
+      remaining -= accepted;
+
+      int count = 0;
+      while ((count = m_parser.parse(m_frames, kBatchFrames, now)) > 0) {
+        publish(m_frames, count);
+      }
+      if (accepted == 0) {
+        break;  // ring full of an unterminated line; the parser drops it
+      }
+    }
   }
+}
 
-  // Append to buffer and parse
-  m_buffer.append(data);
-  parseCANData(m_buffer);
-}
-
-void CANDevice::parseCANData(const QByteArray& data) {
-  // Parse CAN frames based on transport protocol
-  // USB-CAN adapters typically send ASCII frames (e.g., "t12301122334455\r\n")
-  // SPI-CAN controllers provide binary data in registers
-  // Native CAN provides SocketCAN frame structures
-
-  // Example for ASCII protocol (Lawicel/SLCAN):
-  int start = 0;
-  int end = m_buffer.indexOf('\r', start);
-
-  while (end != -1) {
-    QByteArray frame = m_buffer.mid(start, end - start);
-
-    if (frame.startsWith('t') || frame.startsWith('T')) {
-      // Standard or extended CAN frame
-      CANMessage message;
-      message.extended = frame.startsWith('T');
-      message.rtr = false;
-      message.fd = false;
-      message.timestamp = QDateTime::currentDateTime();
-
-      // Parse: t123811223344556677
-      //        ^id  ^len  ^data...
-      QString frameStr = QString::fromLatin1(frame);
-      bool ok;
-      message.id = frameStr.mid(1, message.extended ? 8 : 3).toUInt(&ok, 16);
-      quint8 len = frameStr.mid(message.extended ? 9 : 4, 1).toUInt(&ok, 16);
-      QString dataStr = frameStr.mid(message.extended ? 10 : 5, len * 2);
-      message.data = QByteArray::fromHex(dataStr.toLatin1());
-
-      Logger::instance().info(
-          QString("CANDevice: Received message ID 0x%1").arg(message.id, 0, 16));
-      emit messageReceived(message);
+void CANDevice::onSocketCANFrames() {
+  SocketCANTransport::Frame native[kBatchFrames];
+  int count = 0;
+  while ((count = m_socketCAN->readFrames(native, kBatchFrames)) > 0) {
+    for (int i = 0; i < count; ++i) {
+      const canfd_frame& raw = native[i].frame;
+      CANFrame& frame = m_frames[i];
+      frame.extended = raw.can_id & CAN_EFF_FLAG;
+      frame.rtr = raw.can_id & CAN_RTR_FLAG;
+      frame.fd = native[i].fd;
+      frame.bitRateSwitch = native[i].fd && (raw.flags & CANFD_BRS);
+      frame.id = raw.can_id & (frame.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+      frame.length = frame.rtr ? 0 : raw.len;
+      memcpy(frame.data, raw.data, frame.length);
+      frame.timestampNs = native[i].timestampNs;
     }
+    publish(m_frames, count);
+  }
+}
 
-    // Move to next frame
-    start = end + 1;
-    end = m_buffer.indexOf('\r', start);
+void CANDevice::publish(const CANFrame* frames, int count) {
+  if (QThread::currentThread() == thread()) {
+    deliver(frames, count);
+  } else {
+    handOff(frames, count);
   }
+}
 
-  // Remove processed data from buffer
-  if (start > 0) {
-    m_buffer.remove(0, start);
+void CANDevice::handOff(const CANFrame* frames, int count) {
+  if (m_handoff.isEmpty()) {
+    m_handoff.resize(kHandoffFrames);  // published to the reader by the queued call
   }
+  const quint32 head = m_handoffHead.load(std::memory_order_acquire);
+  const quint32 tail = m_handoffTail.load(std::memory_order_relaxed);
+  const int accepted = qMin(count, kHandoffFrames - static_cast<int>(tail - head));
+  for (int i = 0; i < accepted; ++i) {
+    m_handoff[(tail + i) & (kHandoffFrames - 1)] = frames[i];
+  }
+  m_handoffTail.store(tail + accepted, std::memory_order_release);
+  if (accepted < count) {
+    m_handoffDropped.fetch_add(count - accepted, std::memory_order_relaxed);
+  }
+
+  // One queued call covers every batch pushed before it runs
+  if (accepted > 0 && !m_handoffPosted.exchange(true, std::memory_order_acq_rel)) {
+    QMetaObject::invokeMethod(this, &CANDevice::drainHandoff, Qt::QueuedConnection);
+  }
+}
 
-  // Prevent buffer overflow
-  if (m_buffer.size() > 4096) {
-    Logger::instance().info("CANDevice: Buffer overflow, clearing");
-    m_buffer.clear();
+void CANDevice::drainHandoff() {
+  // Batches pushed from here on queue another call
+  m_handoffPosted.store(false, std::memory_order_release);
+  quint32 head = m_handoffHead.load(std::memory_order_relaxed);
+  const quint32 tail = m_handoffTail.load(std::memory_order_acquire);
+  while (head != tail) {
+    // Contiguous runs, straight out of the ring
+    const int start = static_cast<int>(head & (kHandoffFrames - 1));
+    const int count = qMin(static_cast<int>(tail - head), kHandoffFrames - start);
+    deliver(m_handoff.constData() + start, count);
+    head += count;
+    m_handoffHead.store(head, std::memory_order_release);
   }
 }
+
+void CANDevice::deliver(const CANFrame* frames, int count) {
+  emit framesReceived(frames, count);
+
+  // The per-frame compatibility signal costs a QByteArray and a QDateTime
+  // each, so only pay for it when someone listens
+  static const QMetaMethod messageSignal = QMetaMethod::fromSignal(&CANDevice::messageReceived);
+  if (!isSignalConnected(messageSignal)) {
+    return;
+  }
+  const qint64 nowNs = monotonicNs();
+  const QDateTime now = QDateTime::currentDateTime();
+  for (int i = 0; i < count; ++i) {
+    const CANFrame& frame = frames[i];
+    CANMessage message;
+    message.id = frame.id;
+    message.data = QByteArray(reinterpret_cast<const char*>(frame.data), frame.length);
+    message.extended = frame.extended;
+    message.rtr = frame.rtr;
+    message.fd = frame.fd;
+    message.bitRateSwitch = frame.bitRateSwitch;
+    message.timestamp = now.addMSecs(-(nowNs - frame.timestampNs) / 1000000);
+    emit messageReceived(message);
+  }
+}
+
+SlcanParser::Stats CANDevice::parserStats() const {
+  return m_parser.stats();
+}
+
+quint64 CANDevice::handoffDropped() const {
+  return m_handoffDropped.load(std::memory_order_relaxed);
+}
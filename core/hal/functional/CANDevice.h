@@ -20,19 +20,29 @@
 #pragma once
 
 #include <QDateTime>
+#include <QVector>
+#include <atomic>
 
+#include "CANFrame.h"
 #include "FunctionalDevice.h"
+#include "SlcanParser.h"
+
+class SocketCANTransport;
 
 /**
  * @brief CAN message structure
+ *
+ * Convenience form of CANFrame with a heap payload and wall-clock time.
+ * High-rate consumers should use CANDevice::framesReceived instead.
  */
 struct CANMessage {
-  quint32 id;           // CAN identifier (11-bit or 29-bit)
-  QByteArray data;      // Data payload (0-8 bytes for CAN 2.0, up to 64 for CAN FD)
-  bool extended;        // Extended frame format (29-bit ID)
-  bool rtr;             // Remote transmission request
-  bool fd;              // CAN FD frame
-  QDateTime timestamp;  // Reception/transmission time
+  quint32 id;                 // CAN identifier (11-bit or 29-bit)
+  QByteArray data;            // Data payload (0-8 bytes for CAN 2.0, up to 64 for CAN FD)
+  bool extended;              // Extended frame format (29-bit ID)
+  bool rtr;                   // Remote transmission request
+  bool fd;                    // CAN FD frame
+  bool bitRateSwitch{false};  // CAN FD data phase at the higher bit rate (BRS)
+  QDateTime timestamp;        // Reception/transmission time
 };
 
 /**
@@ -51,9 +61,15 @@ struct CANMessage {
  *   auto spi = new SPITransport(0, 0);  // SPI bus 0, chip select 0
  *   auto can = new CANDevice(spi);
  *
- *   // Native CAN interface (e.g., SocketCAN on Linux)
- *   auto native = new CANTransport("can0");
+ *   // Native CAN interface (SocketCAN on Linux), frames moved in batches
+ *   auto native = new SocketCANTransport("can0");
  *   auto can = new CANDevice(native);
+ *
+ * Frames are decoded on whichever thread the transport receives on. With an
+ * IoReactor that is the HAL thread: decoded batches are handed to the
+ * device's own thread through a lock-free ring, with one queued call for
+ * however many batches are waiting, so framesReceived() is always emitted
+ * on the device's thread.
  */
 class CANDevice : public FunctionalDevice {
   Q_OBJECT
@@ -89,6 +105,11 @@ class CANDevice : public FunctionalDevice {
    */
   bool sendMessage(const CANMessage& message);
 
+  /**
+   * @brief Send CAN frame without building an intermediate message
+   */
+  bool sendFrame(const CANFrame& frame);
+
   /**
    * @brief Set CAN bus bit rate
    */
@@ -99,9 +120,30 @@ class CANDevice : public FunctionalDevice {
    */
   quint32 getBitRate() const;
 
+  /**
+   * @brief SLCAN decode counters (frames, malformed lines, overflow)
+   */
+  SlcanParser::Stats parserStats() const;
+
+  /**
+   * @brief Frames dropped because the device's thread fell a whole hand-off
+   *        ring behind the receiving thread
+   */
+  quint64 handoffDropped() const;
+
  signals:
+  /**
+   * @brief Emitted once per decoded batch of frames
+   *
+   * frames points into the device's own buffer and is only valid during the
+   * emission: connect with a direct connection and copy what you keep.
+   */
+  void framesReceived(const CANFrame* frames, int count);
+
   /**
    * @brief Emitted when CAN message received
+   *
+   * Built per frame only while something is connected to it.
    */
   void messageReceived(const CANMessage& message);
 
@@ -117,12 +159,31 @@ class CANDevice : public FunctionalDevice {
 
  private slots:
   void onTransportDataReceived();
+  void onSocketCANFrames();
+  void drainHandoff();
 
  private:
-  void parseCANData(const QByteArray& data);
+  static constexpr int kBatchFrames = 64;
+  static constexpr int kReadChunk = 4096;
+  static constexpr int kHandoffFrames = 1024;  // power of two
+
+  void publish(const CANFrame* frames, int count);
+  void handOff(const CANFrame* frames, int count);
+  void deliver(const CANFrame* frames, int count);
+  bool sendSocketCAN(const CANFrame& frame);
 
   DeviceState m_state;
   quint32 m_bitRate;
-  QByteArray m_buffer;
   QVariantMap m_config;
+  SocketCANTransport* m_socketCAN;  // set when the transport is native SocketCAN
+  SlcanParser m_parser;
+  CANFrame m_frames[kBatchFrames];  // decode buffer handed out by framesReceived
+  char m_readBuffer[kReadChunk];
+
+  // Receiving thread to device thread; head and tail only grow, masked on access
+  QVector<CANFrame> m_handoff;  // sized by the receiving thread on first use
+  std::atomic<quint32> m_handoffHead;
+  std::atomic<quint32> m_handoffTail;
+  std::atomic<bool> m_handoffPosted;  // a drainHandoff() call is queued
+  std::atomic<quint64> m_handoffDropped;
 };
@@ -0,0 +1,71 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QMetaType>
+#include <QtGlobal>
+#include <type_traits>
+
+/**
+ * @brief Fixed-size CAN / CAN FD frame
+ *
+ * Plain data: the payload is stored inline and the timestamp is a
+ * CLOCK_MONOTONIC nanosecond count, so frames can be parsed into arrays,
+ * copied with memcpy and handed around in batches without touching the heap.
+ */
+struct CANFrame {
+  static constexpr int kMaxClassicLength = 8;
+  static constexpr int kMaxFdLength = 64;
+
+  quint32 id;          // CAN identifier (11-bit or 29-bit), no flag bits
+  quint8 length;       // Payload length in bytes (0-8, or up to 64 for CAN FD)
+  bool extended;       // Extended frame format (29-bit ID)
+  bool rtr;            // Remote transmission request
+  bool fd;             // CAN FD frame
+  bool bitRateSwitch;  // CAN FD data phase at the higher bit rate
+  quint8 data[kMaxFdLength];
+  qint64 timestampNs;  // Reception time, CLOCK_MONOTONIC
+};
+
+static_assert(std::is_trivially_copyable<CANFrame>::value, "CANFrame must stay plain data");
+
+/**
+ * @brief CAN FD data length code to payload length (DLC 9-15 map to 12-64 bytes)
+ */
+constexpr int canFdDlcToLength(int dlc) {
+  constexpr int kLengths[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+  return dlc >= 0 && dlc < 16 ? kLengths[dlc] : -1;
+}
+
+/**
+ * @brief Smallest data length code whose payload holds length bytes
+ */
+constexpr int canFdLengthToDlc(int length) {
+  return length <= 8    ? length
+         : length <= 12 ? 9
+         : length <= 16 ? 10
+         : length <= 20 ? 11
+         : length <= 24 ? 12
+         : length <= 32 ? 13
+         : length <= 48 ? 14
+                        : 15;
+}
+
+Q_DECLARE_METATYPE(CANFrame)
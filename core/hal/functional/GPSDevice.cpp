@@ -19,10 +19,35 @@
 
 #include "GPSDevice.h"
 
+#include <time.h>
+
+#include <QTimeZone>
+
 #include "../../services/logging/Logger.h"
 
+namespace {
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+QDateTime utcTime(const QDate& date, qint64 msecsOfDay) {
+  const qint64 days = date.toJulianDay() - QDate(1970, 1, 1).toJulianDay();
+  return QDateTime::fromMSecsSinceEpoch(days * 86400000LL + msecsOfDay, QTimeZone::utc());
+}
+
+}  // namespace
+
 GPSDevice::GPSDevice(Transport* transport, QObject* parent)
-    : FunctionalDevice(transport, parent), m_state(DeviceState::OFFLINE) {
+    : FunctionalDevice(transport, parent),
+      m_state(DeviceState::OFFLINE),
+      m_hasNavDop(false),
+      m_navPvtSeen(false),
+      m_ubxConfigured(false),
+      m_protocol(Protocol::Unknown),
+      m_nmeaOnly(false) {
   // Initialize location with invalid values
   m_currentLocation.latitude = 0.0;
   m_currentLocation.longitude = 0.0;
@@ -33,10 +58,17 @@ GPSDevice::GPSDevice(Transport* transport, QObject* parent)
   m_currentLocation.fixType = "none";
   m_currentLocation.hdop = 99.9;
   m_currentLocation.vdop = 99.9;
+  m_currentLocation.receivedNs = 0;
 
-  // Connect to transport signals
+  m_config["protocol"] = "auto";
+  m_config["updateRateHz"] = 10;
+  m_config["disableNmea"] = true;
+
+  // Connect to transport signals. Direct, so a transport on an I/O reactor
+  // has its data parsed on the reactor thread rather than this one.
   if (m_transport) {
-    connect(m_transport, &Transport::dataReceived, this, &GPSDevice::onTransportDataReceived);
+    connect(m_transport, &Transport::dataReceived, this, &GPSDevice::onTransportDataReceived,
+            Qt::DirectConnection);
   }
 }
 
@@ -73,6 +105,15 @@ bool GPSDevice::initialize() {
 
   m_state = DeviceState::ONLINE;
   emit stateChanged(m_state);
+
+  const QString protocol = m_config.value("protocol").toString();
+  if (protocol == "ubx") {
+    configureUbx();
+  } else if (protocol != "nmea") {
+    // A u-blox receiver answers in UBX, which configures it; others ignore it
+    m_transport->write(UbxParser::frame(UbxParser::kClassMon, UbxParser::kIdMonVer));
+  }
+
   Logger::instance().info("GPSDevice: Initialization complete");
   return true;
 }
@@ -83,12 +124,23 @@ void GPSDevice::shutdown() {
   }
 
   Logger::instance().info("GPSDevice: Shutting down");
+  m_parser.clear();
+  m_ubx.clear();
+  m_hasNavDop = false;
+  m_navPvtSeen = false;
+  m_ubxConfigured = false;
   m_state = DeviceState::OFFLINE;
   emit stateChanged(m_state);
 }
 
 bool GPSDevice::setConfig(const QString& key, const QVariant& value) {
   m_config[key] = value;
+  if (key == "protocol") {
+    m_nmeaOnly.store(value.toString() == "nmea");
+  }
+  if ((key == "updateRateHz" || key == "disableNmea") && m_ubxConfigured) {
+    return configureUbx();
+  }
   return true;
 }
 
@@ -106,60 +158,245 @@ quint8 GPSDevice::getSatelliteCount() const {
   return m_currentLocation.satellites;
 }
 
+NmeaParser::Stats GPSDevice::parserStats() const {
+  return m_parser.stats();
+}
+
+UbxParser::Stats GPSDevice::ubxStats() const {
+  return m_ubx.stats();
+}
+
+GPSDevice::Protocol GPSDevice::protocol() const {
+  return m_protocol.load();
+}
+
+bool GPSDevice::configureUbx() {
+  if (!m_transport || !m_transport->isOpen()) {
+    return false;
+  }
+  const bool disableNmea = m_config.value("disableNmea").toBool();
+  const int requestedHz = qBound(1, m_config.value("updateRateHz").toInt(), 25);
+  const qint32 baudRate = m_transport->getConfiguration("baudRate").toInt();
+  const int rateHz = qMin(requestedHz, UbxParser::maxRateHz(baudRate, disableNmea));
+  if (rateHz < requestedHz) {
+    Logger::instance().warning(
+        QString("GPSDevice: %1 baud carries at most %2 Hz of UBX output; %3 Hz requested")
+            .arg(baudRate)
+            .arg(rateHz)
+            .arg(requestedHz));
+  }
+  const QByteArray commands = UbxParser::configuration(rateHz, disableNmea);
+  if (m_transport->write(commands) != commands.size()) {
+    Logger::instance().warning("GPSDevice: Failed to send UBX configuration");
+    return false;
+  }
+  m_ubxConfigured = true;
+  Logger::instance().info(QString("GPSDevice: Configured u-blox receiver for NAV-PVT at %1 Hz%2")
+                              .arg(rateHz)
+                              .arg(disableNmea ? ", NMEA off" : ""));
+  return true;
+}
+
 void GPSDevice::onTransportDataReceived() {
   if (!m_transport) {
     return;
   }
 
-  // Read available data from transport
-  QByteArray data = m_transport->read();
-  if (data.isEmpty()) {
-    return;
+  // Read available data from transport, a buffer at a time
+  const bool nmeaOnly = m_nmeaOnly.load();
+  qint64 size = 0;
+  while ((size = m_transport->readInto(m_readBuffer)) > 0) {
+    const char* bytes = m_readBuffer;
+    int remaining = static_cast<int>(size);
+    if (nmeaOnly) {
+      feedNmea(bytes, remaining);
+      continue;
+    }
+
+    // Split UBX frames from the NMEA text around them, a slice at a time
+    char text[kTextChunk];
+    while (remaining > 0) {
+      const int slice = qMin(remaining, kTextChunk);
+      int textSize = 0;
+      int offset = 0;
+      while (offset < slice) {
+        bool frameReady = false;
+        offset += m_ubx.feed(bytes + offset, slice - offset, text, &textSize, &frameReady);
+        if (frameReady) {
+          handleUbx(m_ubx.message());
+        }
+      }
+      feedNmea(text, textSize);
+      bytes += slice;
+      remaining -= slice;
+    }
   }
+}
 
-  // Append to buffer and parse
-  m_buffer.append(data);
-  parseNMEA(m_buffer);
+void GPSDevice::feedNmea(const char* data, int size) {
+  // Sentences split across reads stay in the parser until the rest arrives
+  while (size > 0) {
+    const int accepted = m_parser.append(data, size);
+    data += accepted;
+    size -= accepted;
+
+    int count = 0;
+    while ((count = m_parser.parse(m_epochs, kBatchEpochs)) > 0) {
+      for (int i = 0; i < count; ++i) {
+        applyEpoch(m_epochs[i]);
+      }
+    }
+    if (accepted == 0) {
+      break;  // buffer full of an unterminated line; the parser drops it
+    }
+  }
 }
 
-void GPSDevice::parseNMEA(const QByteArray& data) {
-  // Look for complete NMEA sentences (lines ending with \r\n)
-  int start = 0;
-  int end = m_buffer.indexOf("\r\n", start);
+void GPSDevice::handleUbx(const UbxParser::Message& message) {
+  if (m_protocol.load() != Protocol::UBX) {
+    setProtocol(Protocol::UBX);
+    // Writes belong to the device's thread, which may not be this one
+    QMetaObject::invokeMethod(this, [this]() {
+      if (!m_ubxConfigured) {
+        configureUbx();
+      }
+    });
+  }
+
+  UbxParser::NavPvt pvt;
+  if (UbxParser::decodeNavDop(message, &m_navDop)) {
+    m_hasNavDop = true;
+  } else if (UbxParser::decodeNavPvt(message, &pvt)) {
+    m_navPvtSeen = true;
+    applyNavPvt(pvt);
+  }
+  // ACK/NAK of the configuration and MON-VER need nothing further: each
+  // receiver generation NAKs the commands meant for the other
+}
 
-  while (end != -1) {
-    QByteArray sentence = m_buffer.mid(start, end - start);
+void GPSDevice::setProtocol(Protocol protocol) {
+  m_protocol.store(protocol);
+  Logger::instance().info(
+      QString("GPSDevice: Receiver speaks %1").arg(protocol == Protocol::UBX ? "UBX" : "NMEA"));
+  emit protocolDetected(protocol);
+}
 
-    // Process NMEA sentence
-    QString line = QString::fromLatin1(sentence).trimmed();
-    if (line.startsWith("$GPGGA") || line.startsWith("$GNGGA")) {
-      // Parse GGA sentence for location and satellite count
-      // TODO: Implement NMEA parsing
-      Logger::instance().info(QString("GPSDevice: Received GGA: %1").arg(line));
+void GPSDevice::applyEpoch(const NmeaParser::Epoch& epoch) {
+  if (m_protocol.load() == Protocol::Unknown) {
+    setProtocol(Protocol::NMEA);
+  }
+  if (m_navPvtSeen) {
+    return;  // left over until the receiver stops sending NMEA
+  }
 
-      // Example: Update location (simplified)
-      QMutexLocker locker(&m_mutex);
-      m_currentLocation.satellites = 8;  // Would parse from sentence
-      m_currentLocation.fixType = "3D";
-      m_currentLocation.timestamp = QDateTime::currentDateTime();
+  GPSLocation location;
+  bool satelliteCountChanged = false;
+  {
+    QMutexLocker locker(&m_mutex);
+    GPSLocation& current = m_currentLocation;
 
-      emit locationUpdated(m_currentLocation);
-      emit satellitesChanged(m_currentLocation.satellites);
+    // Fields no sentence of this epoch carried keep their last value
+    if (epoch.fields & NmeaParser::Position) {
+      current.latitude = epoch.latitude;
+      current.longitude = epoch.longitude;
+    }
+    if (epoch.fields & NmeaParser::Altitude) {
+      current.altitude = epoch.altitude;
+    }
+    if (epoch.fields & NmeaParser::Speed) {
+      current.speed = epoch.speed;
+    }
+    if (epoch.fields & NmeaParser::Course) {
+      current.heading = epoch.course;
+    }
+    if ((epoch.fields & NmeaParser::Satellites) && epoch.satellites != current.satellites) {
+      current.satellites = epoch.satellites;
+      satelliteCountChanged = true;
+    }
+    if (epoch.fields & NmeaParser::Dop) {
+      if (epoch.hdop > 0) {
+        current.hdop = epoch.hdop;
+      }
+      if (epoch.vdop > 0) {
+        current.vdop = epoch.vdop;
+      }
+    }
+
+    if (epoch.fields & NmeaParser::FixMode) {
+      current.fixType = epoch.fixMode == 3 ? "3D" : epoch.fixMode == 2 ? "2D" : "none";
+    } else if (epoch.fields & NmeaParser::Quality) {
+      // GGA alone: a fix with an altitude is a 3D one
+      if (epoch.quality == 0) {
+        current.fixType = "none";
+      } else {
+        current.fixType = (epoch.fields & NmeaParser::Altitude) ? "3D" : "2D";
+      }
     }
 
-    // Move to next sentence
-    start = end + 2;  // Skip \r\n
-    end = m_buffer.indexOf("\r\n", start);
+    if (epoch.fields & NmeaParser::Time) {
+      // Without RMC there is no date; assume the fix is from today (UTC)
+      const QDate date = (epoch.fields & NmeaParser::Date)
+                             ? QDate(epoch.year, epoch.month, epoch.day)
+                             : QDateTime::currentDateTimeUtc().date();
+      current.timestamp = utcTime(date, epoch.timeMs);
+    } else {
+      current.timestamp = QDateTime::currentDateTimeUtc();
+    }
+    current.receivedNs = monotonicNs();
+    location = current;
   }
 
-  // Remove processed data from buffer
-  if (start > 0) {
-    m_buffer.remove(0, start);
+  publish(location, satelliteCountChanged);
+}
+
+void GPSDevice::applyNavPvt(const UbxParser::NavPvt& pvt) {
+  GPSLocation location;
+  bool satelliteCountChanged = false;
+  {
+    QMutexLocker locker(&m_mutex);
+    GPSLocation& current = m_currentLocation;
+
+    // Dead reckoning only (1) and time only (5) are not position fixes
+    const bool fix = pvt.gnssFixOk && pvt.fixType >= 2 && pvt.fixType <= 4;
+    if (fix) {
+      current.latitude = pvt.latitude;
+      current.longitude = pvt.longitude;
+      current.speed = pvt.speed;
+      current.heading = pvt.heading;
+      if (pvt.fixType != 2) {
+        current.altitude = pvt.altitude;
+      }
+      current.fixType = pvt.fixType == 2 ? "2D" : "3D";
+    } else {
+      current.fixType = "none";
+    }
+    if (pvt.satellites != current.satellites) {
+      current.satellites = pvt.satellites;
+      satelliteCountChanged = true;
+    }
+    // NAV-DOP of the same epoch comes just before NAV-PVT
+    if (m_hasNavDop && m_navDop.iTowMs == pvt.iTowMs) {
+      current.hdop = m_navDop.hdop;
+      current.vdop = m_navDop.vdop;
+    }
+
+    if (pvt.validDate && pvt.validTime) {
+      const qint64 msecsOfDay = ((pvt.hour * 60 + pvt.minute) * 60 + pvt.second) * 1000LL +
+                                pvt.nanoseconds / 1000000;
+      current.timestamp = utcTime(QDate(pvt.year, pvt.month, pvt.day), msecsOfDay);
+    } else {
+      current.timestamp = QDateTime::currentDateTimeUtc();
+    }
+    current.receivedNs = monotonicNs();
+    location = current;
   }
 
-  // Prevent buffer from growing indefinitely
-  if (m_buffer.size() > 4096) {
-    Logger::instance().info("GPSDevice: Buffer overflow, clearing");
-    m_buffer.clear();
+  publish(location, satelliteCountChanged);
+}
+
+void GPSDevice::publish(const GPSLocation& location, bool satelliteCountChanged) {
+  emit locationUpdated(location);
+  if (satelliteCountChanged) {
+    emit satellitesChanged(location.satellites);
   }
 }
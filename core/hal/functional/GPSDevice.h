@@ -20,8 +20,11 @@
 #pragma once
 
 #include <QDateTime>
+#include <atomic>
 
 #include "FunctionalDevice.h"
+#include "NmeaParser.h"
+#include "UbxParser.h"
 
 /**
  * @brief GPS location data structure
@@ -37,6 +40,7 @@ struct GPSLocation {
   double hdop;          // Horizontal dilution of precision
   double vdop;          // Vertical dilution of precision
   QDateTime timestamp;  // Time of fix
+  qint64 receivedNs;    // When the fix was decoded, CLOCK_MONOTONIC
 };
 
 /**
@@ -58,11 +62,36 @@ struct GPSLocation {
  *   // GPS over USB (USB GPS dongle)
  *   auto usb = new USBTransport("/dev/ttyACM0");
  *   auto gps = new GPSDevice(usb);
+ *
+ * NMEA is decoded by NmeaParser. The sentences of one fix (GGA, RMC, VTG,
+ * GSA from any talker) are merged, so locationUpdated() is emitted once per
+ * epoch rather than once per sentence.
+ *
+ * u-blox receivers are switched to the binary UBX protocol (NAV-PVT and
+ * NAV-DOP), which needs a fraction of NMEA's bandwidth and parsing per fix
+ * and allows 10-25 Hz at 115200 baud. In "auto" mode a
+ * MON-VER poll is sent on initialize(); a receiver that answers in UBX is
+ * configured for the update rate and, by default, has its NMEA output turned
+ * off. UBX frames and NMEA text may be interleaved on one transport.
+ *
+ * Parsing runs on whichever thread the transport emits dataReceived() on:
+ * with an IoReactor that is the HAL thread, and locationUpdated() reaches
+ * receivers on other threads queued, once per epoch. Writes to the receiver
+ * are always made on the device's own thread.
+ *
+ * Configuration keys:
+ *   - "protocol": "auto" (default), "nmea" or "ubx"
+ *   - "updateRateHz": UBX navigation rate, 1-25 (default 10); lowered to what
+ *                     the transport's "baudRate" can carry (e.g. 7 Hz at 9600)
+ *   - "disableNmea": Turn the receiver's NMEA output off (default true)
  */
 class GPSDevice : public FunctionalDevice {
   Q_OBJECT
 
  public:
+  enum class Protocol { Unknown, NMEA, UBX };
+  Q_ENUM(Protocol)
+
   explicit GPSDevice(Transport* transport, QObject* parent = nullptr);
   ~GPSDevice() override;
 
@@ -98,9 +127,22 @@ class GPSDevice : public FunctionalDevice {
    */
   quint8 getSatelliteCount() const;
 
+  NmeaParser::Stats parserStats() const;
+  UbxParser::Stats ubxStats() const;
+
+  /**
+   * @brief Protocol the receiver has been seen to speak
+   */
+  Protocol protocol() const;
+
+  /**
+   * @brief Send the UBX rate and message configuration now
+   */
+  bool configureUbx();
+
  signals:
   /**
-   * @brief Emitted when location updates
+   * @brief Emitted once per receiver epoch with the merged fix
    */
   void locationUpdated(const GPSLocation& location);
 
@@ -109,14 +151,37 @@ class GPSDevice : public FunctionalDevice {
    */
   void satellitesChanged(quint8 count);
 
+  /**
+   * @brief Emitted when the receiver's protocol is first recognised or changes
+   */
+  void protocolDetected(GPSDevice::Protocol protocol);
+
  private slots:
   void onTransportDataReceived();
 
  private:
-  void parseNMEA(const QByteArray& data);
+  void feedNmea(const char* data, int size);
+  void handleUbx(const UbxParser::Message& message);
+  void setProtocol(Protocol protocol);
+  void applyEpoch(const NmeaParser::Epoch& epoch);
+  void applyNavPvt(const UbxParser::NavPvt& pvt);
+  void publish(const GPSLocation& location, bool satelliteCountChanged);
+
+  static constexpr int kBatchEpochs = 8;
+  static constexpr int kTextChunk = 1024;
+  static constexpr int kReadChunk = 4096;
 
   DeviceState m_state;
   GPSLocation m_currentLocation;
-  QByteArray m_buffer;  // Buffer for incomplete NMEA sentences
+  NmeaParser m_parser;  // holds incomplete sentences between reads
+  NmeaParser::Epoch m_epochs[kBatchEpochs];
+  UbxParser m_ubx;
+  UbxParser::NavDop m_navDop;
+  bool m_hasNavDop;
+  bool m_navPvtSeen;  // UBX fixes arrive; NMEA epochs no longer move the location
+  bool m_ubxConfigured;
+  std::atomic<Protocol> m_protocol;  // set on the parsing thread
   QVariantMap m_config;
+  std::atomic<bool> m_nmeaOnly;  // "protocol" is "nmea"; read on the parsing thread
+  char m_readBuffer[kReadChunk];
 };
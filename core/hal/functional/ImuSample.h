@@ -0,0 +1,45 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QMetaType>
+#include <QtGlobal>
+#include <type_traits>
+
+/**
+ * @brief One inertial measurement, in the vehicle frame
+ *
+ * Axes follow ISO 8855: x forward, y left, z up. Acceleration is specific
+ * force in m/s² (a level, stationary vehicle reads +9.81 on z) and angular
+ * rate is rad/s, positive counter-clockwise about each axis, so a left turn
+ * reads positive gyro[2]. IMU drivers rotate their mounting into this frame
+ * before emitting samples. The timestamp is a CLOCK_MONOTONIC nanosecond
+ * count of the sample instant, comparable with CANFrame::timestampNs.
+ */
+struct ImuSample {
+  float accel[3];      // m/s²
+  float gyro[3];       // rad/s
+  qint64 timestampNs;  // Sample time, CLOCK_MONOTONIC
+};
+
+static_assert(std::is_trivially_copyable<ImuSample>::value, "ImuSample must stay plain data");
+
+Q_DECLARE_METATYPE(ImuSample)
@@ -0,0 +1,486 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NmeaParser.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr double kKnotsToMps = 1852.0 / 3600.0;
+constexpr double kKmhToMps = 1000.0 / 3600.0;
+constexpr double kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8, 1e9,
+                                   1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+constexpr int kMaxDigits = 18;  // what a quint64 mantissa holds exactly
+
+inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+bool parseUnsigned(std::string_view text, int* value) {
+  if (text.empty() || text.size() > 9) {
+    return false;
+  }
+  int result = 0;
+  for (char c : text) {
+    if (!isDigit(c)) {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  *value = result;
+  return true;
+}
+
+int twoDigits(std::string_view text, size_t at) {
+  if (at + 2 > text.size() || !isDigit(text[at]) || !isDigit(text[at + 1])) {
+    return -1;
+  }
+  return (text[at] - '0') * 10 + (text[at + 1] - '0');
+}
+
+// "hhmmss" with an optional fraction, to milliseconds since midnight
+bool parseTime(std::string_view text, qint32* milliseconds) {
+  const int hours = twoDigits(text, 0);
+  const int minutes = twoDigits(text, 2);
+  const int seconds = twoDigits(text, 4);
+  if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59 || seconds < 0 || seconds > 60) {
+    return false;
+  }
+  int fraction = 0;
+  if (text.size() > 6) {
+    if (text[6] != '.') {
+      return false;
+    }
+    int scale = 100;
+    for (size_t i = 7; i < text.size(); ++i) {
+      if (!isDigit(text[i])) {
+        return false;
+      }
+      fraction += (text[i] - '0') * scale;
+      scale /= 10;
+    }
+  }
+  *milliseconds = ((hours * 60 + minutes) * 60 + seconds) * 1000 + fraction;
+  return true;
+}
+
+}  // namespace
+
+NmeaParser::NmeaParser() {
+  clear();
+}
+
+int NmeaParser::append(const char* data, int size) {
+  const int accepted = qMin(size, kCapacity - m_size);
+  if (accepted < size) {
+    m_stats.overflowBytes += static_cast<quint64>(size - accepted);
+  }
+  memcpy(m_buffer + m_size, data, static_cast<size_t>(accepted));
+  m_size += accepted;
+  return accepted;
+}
+
+int NmeaParser::parse(Epoch* epochs, int maxEpochs) {
+  int produced = 0;
+  int start = 0;  // first byte of the current line
+
+  while (produced < maxEpochs) {
+    int end = m_scan;
+    while (end < m_size && m_buffer[end] != '\n' && m_buffer[end] != '\r') {
+      ++end;
+    }
+    if (end == m_size) {
+      m_scan = m_size;
+      if (m_size - start > kMaxSentenceLength) {
+        ++m_stats.malformed;
+        m_discarding = true;
+        start = m_size;
+        m_scan = m_size;
+      }
+      break;
+    }
+
+    const std::string_view line(m_buffer + start, static_cast<size_t>(end - start));
+    start = end + 1;
+    m_scan = start;
+    if (m_discarding) {
+      m_discarding = false;
+      continue;
+    }
+    if (line.empty()) {
+      continue;  // the other half of CR LF
+    }
+    if (line.size() > static_cast<size_t>(kMaxSentenceLength)) {
+      ++m_stats.malformed;
+      continue;
+    }
+    produced += processSentence(line, &epochs[produced], maxEpochs - produced);
+  }
+
+  // Keep only the unterminated tail, which is short
+  if (start > 0) {
+    memmove(m_buffer, m_buffer + start, static_cast<size_t>(m_size - start));
+    m_size -= start;
+    m_scan -= start;
+  }
+  return produced;
+}
+
+bool NmeaParser::finishEpoch(Epoch* epoch) {
+  if (m_epochEmitted || m_epoch.fields == 0) {
+    return false;
+  }
+  *epoch = m_epoch;
+  m_epochEmitted = true;
+  ++m_stats.epochs;
+  return true;
+}
+
+int NmeaParser::buffered() const {
+  return m_size;
+}
+
+void NmeaParser::clear() {
+  m_size = 0;
+  m_scan = 0;
+  m_discarding = false;
+  m_enderType = -1;
+  m_enderCount = 0;
+  startEpoch();
+}
+
+NmeaParser::Stats NmeaParser::stats() const {
+  return m_stats;
+}
+
+void NmeaParser::startEpoch() {
+  m_epoch = Epoch();
+  m_epochEmitted = false;
+  m_lastType = -1;
+  for (int& count : m_counts) {
+    count = 0;
+  }
+}
+
+bool NmeaParser::verifyChecksum(std::string_view sentence) {
+  if (sentence.size() < 4 || sentence[0] != '$') {
+    return false;
+  }
+  const size_t star = sentence.size() - 3;
+  if (sentence[star] != '*') {
+    return false;
+  }
+  const int high = hexValue(sentence[star + 1]);
+  const int low = hexValue(sentence[star + 2]);
+  if (high < 0 || low < 0) {
+    return false;
+  }
+  quint8 checksum = 0;
+  for (size_t i = 1; i < star; ++i) {
+    checksum ^= static_cast<quint8>(sentence[i]);
+  }
+  return checksum == ((high << 4) | low);
+}
+
+bool NmeaParser::parseDecimal(std::string_view text, double* value) {
+  size_t i = 0;
+  bool negative = false;
+  if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+    negative = text[i] == '-';
+    ++i;
+  }
+
+  quint64 mantissa = 0;
+  int digits = 0;
+  int fractionDigits = 0;
+  bool seenDigit = false;
+  bool seenPoint = false;
+  for (; i < text.size(); ++i) {
+    const char c = text[i];
+    if (c == '.' && !seenPoint) {
+      seenPoint = true;
+      continue;
+    }
+    if (!isDigit(c)) {
+      return false;
+    }
+    seenDigit = true;
+    if (digits == kMaxDigits) {
+      if (!seenPoint) {
+        return false;  // far outside anything NMEA carries
+      }
+      continue;  // beyond double precision anyway
+    }
+    if (mantissa != 0 || c != '0') {
+      ++digits;
+    }
+    mantissa = mantissa * 10 + static_cast<quint64>(c - '0');
+    if (seenPoint) {
+      ++fractionDigits;
+    }
+  }
+  if (!seenDigit) {
+    return false;
+  }
+
+  const double result = static_cast<double>(mantissa) / kPowersOfTen[qMin(fractionDigits, 18)];
+  *value = negative ? -result : result;
+  return true;
+}
+
+bool NmeaParser::parseCoordinate(std::string_view value, std::string_view hemisphere,
+                                 double* degrees) {
+  double raw;
+  if (hemisphere.size() != 1 || !parseDecimal(value, &raw) || raw < 0) {
+    return false;
+  }
+  const double whole = static_cast<double>(static_cast<int>(raw / 100));
+  const double minutes = raw - whole * 100;
+  if (minutes >= 60.0 || whole > 180.0) {
+    return false;
+  }
+  double result = whole + minutes / 60.0;
+  switch (hemisphere[0]) {
+    case 'N':
+    case 'E':
+      break;
+    case 'S':
+    case 'W':
+      result = -result;
+      break;
+    default:
+      return false;
+  }
+  *degrees = result;
+  return true;
+}
+
+int NmeaParser::processSentence(std::string_view sentence, Epoch* completed, int room) {
+  // Leading noise from a half-received line
+  const size_t dollar = sentence.find('$');
+  if (dollar == std::string_view::npos || sentence.size() - dollar < 4 ||
+      sentence[sentence.size() - 3] != '*') {
+    ++m_stats.malformed;
+    return 0;
+  }
+  sentence.remove_prefix(dollar);
+  if (!verifyChecksum(sentence)) {
+    ++m_stats.checksumErrors;
+    return 0;
+  }
+
+  std::string_view fields[kMaxFields];
+  int count = 0;
+  std::string_view body = sentence.substr(1, sentence.size() - 4);
+  for (;;) {
+    const size_t comma = body.find(',');
+    if (count < kMaxFields) {
+      fields[count++] = body.substr(0, comma);
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    body.remove_prefix(comma + 1);
+  }
+
+  // Address: two-letter talker (GP, GN, GL, GA, BD, ...) and sentence type
+  const std::string_view address = fields[0];
+  int type = kSentenceTypes;
+  int minFields = 0;
+  if (address.size() == 5) {
+    const std::string_view formatter = address.substr(2);
+    if (formatter == "GGA") {
+      type = GGA;
+      minFields = 10;
+    } else if (formatter == "RMC") {
+      type = RMC;
+      minFields = 10;
+    } else if (formatter == "VTG") {
+      type = VTG;
+      minFields = 8;
+    } else if (formatter == "GSA") {
+      type = GSA;
+      minFields = 18;
+    }
+  }
+  if (type == kSentenceTypes) {
+    ++m_stats.ignored;
+    return 0;
+  }
+  if (count < minFields) {
+    ++m_stats.malformed;
+    return 0;
+  }
+
+  // GGA and RMC come once per epoch and carry its time
+  int done = 0;
+  if (type == GGA || type == RMC) {
+    qint32 timeMs = -1;
+    parseTime(fields[1], &timeMs);
+    const bool newTime = (m_epoch.fields & Time) && timeMs >= 0 && timeMs != m_epoch.timeMs;
+    if (m_counts[type] > 0 || newTime) {
+      if (!m_epochEmitted && m_epoch.fields != 0) {
+        completed[done++] = m_epoch;
+        ++m_stats.epochs;
+      }
+      if (m_lastType >= 0) {
+        m_enderType = m_lastType;
+        m_enderCount = m_counts[m_lastType];
+      }
+      startEpoch();
+    }
+  }
+
+  switch (type) {
+    case GGA:
+      mergeGga(fields, count);
+      break;
+    case RMC:
+      mergeRmc(fields, count);
+      break;
+    case VTG:
+      mergeVtg(fields, count);
+      break;
+    default:
+      mergeGsa(fields, count);
+      break;
+  }
+  ++m_stats.sentences;
+  ++m_counts[type];
+  m_lastType = type;
+
+  // The sentence that closed the previous cycles closes this one too. Without
+  // room the epoch is completed when the next one starts instead.
+  if (!m_epochEmitted && type == m_enderType && m_counts[type] == m_enderCount && done < room) {
+    completed[done++] = m_epoch;
+    m_epochEmitted = true;
+    ++m_stats.epochs;
+  }
+  return done;
+}
+
+void NmeaParser::mergeGga(const std::string_view* fields, int count) {
+  Q_UNUSED(count);
+  // 1 time, 2-5 position, 6 quality, 7 satellites, 8 HDOP, 9 altitude
+  if (parseTime(fields[1], &m_epoch.timeMs)) {
+    m_epoch.fields |= Time;
+  }
+  int value;
+  if (parseUnsigned(fields[6], &value)) {
+    m_epoch.quality = static_cast<quint8>(value);
+    m_epoch.fields |= Quality;
+  }
+  if (parseUnsigned(fields[7], &value)) {
+    m_epoch.satellites = static_cast<quint8>(qMin(value, 255));
+    m_epoch.fields |= Satellites;
+  }
+  if (parseDecimal(fields[8], &m_epoch.hdop)) {
+    m_epoch.fields |= Dop;
+  }
+  if (m_epoch.quality == 0) {
+    return;  // no fix: the position fields are stale or empty
+  }
+  if (parseCoordinate(fields[2], fields[3], &m_epoch.latitude) &&
+      parseCoordinate(fields[4], fields[5], &m_epoch.longitude)) {
+    m_epoch.fields |= Position;
+  }
+  if (parseDecimal(fields[9], &m_epoch.altitude)) {
+    m_epoch.fields |= Altitude;
+  }
+}
+
+void NmeaParser::mergeRmc(const std::string_view* fields, int count) {
+  Q_UNUSED(count);
+  // 1 time, 2 status, 3-6 position, 7 knots, 8 course, 9 date (ddmmyy)
+  if (parseTime(fields[1], &m_epoch.timeMs)) {
+    m_epoch.fields |= Time;
+  }
+  const int day = twoDigits(fields[9], 0);
+  const int month = twoDigits(fields[9], 2);
+  const int year = twoDigits(fields[9], 4);
+  if (fields[9].size() == 6 && day >= 1 && day <= 31 && month >= 1 && month <= 12 && year >= 0) {
+    m_epoch.day = static_cast<quint8>(day);
+    m_epoch.month = static_cast<quint8>(month);
+    m_epoch.year = static_cast<quint16>(year < 80 ? 2000 + year : 1900 + year);
+    m_epoch.fields |= Date;
+  }
+  if (fields[2] != "A") {
+    return;  // void: no fix
+  }
+  if (parseCoordinate(fields[3], fields[4], &m_epoch.latitude) &&
+      parseCoordinate(fields[5], fields[6], &m_epoch.longitude)) {
+    m_epoch.fields |= Position;
+  }
+  double knots;
+  if (parseDecimal(fields[7], &knots)) {
+    m_epoch.speed = knots * kKnotsToMps;
+    m_epoch.fields |= Speed;
+  }
+  if (parseDecimal(fields[8], &m_epoch.course)) {
+    m_epoch.fields |= Course;
+  }
+}
+
+void NmeaParser::mergeVtg(const std::string_view* fields, int count) {
+  // 1 course true, 3 course magnetic, 5 knots, 7 km/h, 9 mode (NMEA 2.3+)
+  if (count > 9 && fields[9] == "N") {
+    return;  // not valid
+  }
+  if (parseDecimal(fields[1], &m_epoch.course)) {
+    m_epoch.fields |= Course;
+  }
+  double speed;
+  if (parseDecimal(fields[7], &speed)) {
+    m_epoch.speed = speed * kKmhToMps;
+    m_epoch.fields |= Speed;
+  } else if (parseDecimal(fields[5], &speed)) {
+    m_epoch.speed = speed * kKnotsToMps;
+    m_epoch.fields |= Speed;
+  }
+}
+
+void NmeaParser::mergeGsa(const std::string_view* fields, int count) {
+  Q_UNUSED(count);
+  // 1 selection mode, 2 fix mode, 3-14 satellite ids, 15 PDOP, 16 HDOP, 17 VDOP
+  int mode;
+  if (parseUnsigned(fields[2], &mode) && mode >= 1 && mode <= 3) {
+    m_epoch.fixMode = static_cast<quint8>(mode);
+    m_epoch.fields |= FixMode;
+  }
+  const bool pdop = parseDecimal(fields[15], &m_epoch.pdop);
+  const bool hdop = parseDecimal(fields[16], &m_epoch.hdop);
+  const bool vdop = parseDecimal(fields[17], &m_epoch.vdop);
+  if (pdop || hdop || vdop) {
+    m_epoch.fields |= Dop;
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+#include <string_view>
+
+/**
+ * @brief Streaming NMEA 0183 parser that merges sentences into epochs
+ *
+ * Bytes from the transport are appended to a fixed buffer; parse() walks the
+ * complete sentences in place as std::string_view slices, validates their
+ * checksums and decodes GGA, RMC, VTG and GSA fields with hand-rolled number
+ * parsing (no locale, no strings, no heap allocations). Any talker is
+ * accepted, so GP, GN (combined), GL, GA and BD receivers all work.
+ *
+ * A receiver sends several sentences per fix (an epoch). Their fields are
+ * merged into one Epoch, which is completed when a new epoch starts (a
+ * different UTC time, or a second GGA/RMC). After the first full cycle the
+ * parser knows which sentence ends an epoch and completes each one as soon
+ * as that sentence arrives, so nothing waits for the next fix.
+ */
+class NmeaParser {
+ public:
+  static constexpr int kCapacity = 4096;
+  // The standard allows 82 bytes; some receivers run over with extra fields
+  static constexpr int kMaxSentenceLength = 160;
+  static constexpr int kMaxFields = 24;
+
+  enum Field : quint32 {
+    Time = 1 << 0,
+    Date = 1 << 1,
+    Position = 1 << 2,
+    Altitude = 1 << 3,
+    Speed = 1 << 4,
+    Course = 1 << 5,
+    Satellites = 1 << 6,
+    Dop = 1 << 7,
+    FixMode = 1 << 8,
+    Quality = 1 << 9,
+  };
+
+  struct Epoch {
+    quint32 fields{0};    // Field bits that some sentence of the epoch set
+    qint32 timeMs{-1};    // UTC milliseconds since midnight
+    quint16 year{0};
+    quint8 month{0};
+    quint8 day{0};
+    double latitude{0};   // degrees, south negative
+    double longitude{0};  // degrees, west negative
+    double altitude{0};   // metres above mean sea level
+    double speed{0};      // m/s over ground
+    double course{0};     // degrees true
+    double hdop{0};
+    double vdop{0};
+    double pdop{0};
+    quint8 satellites{0};  // used in the fix (GGA)
+    quint8 quality{0};     // GGA fix quality, 0 = no fix
+    quint8 fixMode{0};     // GSA: 1 = none, 2 = 2D, 3 = 3D
+  };
+
+  struct Stats {
+    quint64 sentences{0};       // decoded
+    quint64 epochs{0};
+    quint64 checksumErrors{0};
+    quint64 malformed{0};       // no '$', no checksum, bad fields or overlong
+    quint64 ignored{0};         // valid but not a supported sentence type
+    quint64 overflowBytes{0};   // dropped because the buffer was full
+  };
+
+  NmeaParser();
+
+  /**
+   * @brief Add received bytes to the buffer
+   * @return Bytes accepted; anything beyond the free space is dropped
+   */
+  int append(const char* data, int size);
+
+  /**
+   * @brief Decode every complete sentence, writing up to maxEpochs epochs
+   *
+   * Sentences whose epochs would not fit stay buffered for the next call.
+   * @return Number of epochs written to epochs
+   */
+  int parse(Epoch* epochs, int maxEpochs);
+
+  /**
+   * @brief Complete the current epoch now, e.g. when the receiver goes quiet
+   * @return false if no sentence has been merged since the last epoch
+   */
+  bool finishEpoch(Epoch* epoch);
+
+  int buffered() const;
+  void clear();
+  Stats stats() const;
+
+  /**
+   * @brief Check "$...*hh" against the XOR of the bytes between them
+   */
+  static bool verifyChecksum(std::string_view sentence);
+
+  /**
+   * @brief Parse a plain decimal ("-12.345") without locale or allocation
+   * @return false on an empty field or any other character
+   */
+  static bool parseDecimal(std::string_view text, double* value);
+
+  /**
+   * @brief Parse an NMEA coordinate ("4807.038" with "N") into degrees
+   */
+  static bool parseCoordinate(std::string_view value, std::string_view hemisphere,
+                              double* degrees);
+
+ private:
+  enum SentenceType { GGA, RMC, VTG, GSA, kSentenceTypes };
+
+  // Writes epochs the sentence completed (at most room) and returns how many
+  int processSentence(std::string_view sentence, Epoch* completed, int room);
+  void mergeGga(const std::string_view* fields, int count);
+  void mergeRmc(const std::string_view* fields, int count);
+  void mergeVtg(const std::string_view* fields, int count);
+  void mergeGsa(const std::string_view* fields, int count);
+  void startEpoch();
+
+  char m_buffer[kCapacity];
+  int m_size;
+  int m_scan;         // next byte to look at for a terminator
+  bool m_discarding;  // inside an overlong line; skip to the next terminator
+
+  Epoch m_epoch;
+  bool m_epochEmitted;
+  int m_counts[kSentenceTypes];  // sentences of each type in this epoch
+  int m_lastType;
+  int m_enderType;    // last sentence type of a cycle, -1 until learned
+  int m_enderCount;   // ...and how many of it a cycle has
+  Stats m_stats;
+};
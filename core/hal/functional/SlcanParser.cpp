@@ -0,0 +1,233 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SlcanParser.h"
+
+#include <array>
+#include <cstring>
+
+namespace {
+
+static_assert((SlcanParser::kCapacity & (SlcanParser::kCapacity - 1)) == 0,
+              "ring capacity must be a power of two");
+
+// Hex digit value per byte, -1 for anything else
+constexpr std::array<qint8, 256> makeHexTable() {
+  std::array<qint8, 256> table{};
+  for (int i = 0; i < 256; ++i) {
+    table[i] = -1;
+  }
+  for (int i = 0; i < 10; ++i) {
+    table['0' + i] = static_cast<qint8>(i);
+  }
+  for (int i = 0; i < 6; ++i) {
+    table['a' + i] = static_cast<qint8>(10 + i);
+    table['A' + i] = static_cast<qint8>(10 + i);
+  }
+  return table;
+}
+
+constexpr std::array<qint8, 256> kHexValue = makeHexTable();
+constexpr char kHexDigit[] = "0123456789ABCDEF";
+
+inline int hexValue(char c) {
+  return kHexValue[static_cast<quint8>(c)];
+}
+
+bool isFrameCommand(char c) {
+  switch (c) {
+    case 't':
+    case 'T':
+    case 'r':
+    case 'R':
+    case 'd':
+    case 'D':
+    case 'b':
+    case 'B':
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+SlcanParser::SlcanParser() : m_head(0), m_scan(0), m_tail(0), m_discarding(false) {}
+
+int SlcanParser::append(const char* data, int size) {
+  const int space = kCapacity - buffered();
+  const int accepted = qMin(size, space);
+  if (accepted < size) {
+    m_stats.overflowBytes += static_cast<quint64>(size - accepted);
+  }
+
+  // At most two contiguous copies around the wrap point
+  const int offset = static_cast<int>(m_tail & (kCapacity - 1));
+  const int first = qMin(accepted, kCapacity - offset);
+  memcpy(m_ring + offset, data, first);
+  memcpy(m_ring, data + first, accepted - first);
+  m_tail += static_cast<quint32>(accepted);
+  return accepted;
+}
+
+int SlcanParser::parse(CANFrame* frames, int maxFrames, qint64 timestampNs) {
+  int count = 0;
+  while (count < maxFrames && m_scan != m_tail) {
+    const char c = at(m_scan);
+    if (c != '\r' && c != '\a') {
+      ++m_scan;
+      if (!m_discarding && static_cast<int>(m_scan - m_head) > kMaxLineLength) {
+        // No terminator in sight: drop what we have and resync on the next one
+        ++m_stats.malformed;
+        m_discarding = true;
+      }
+      if (m_discarding) {
+        m_head = m_scan;
+      }
+      continue;
+    }
+
+    const quint32 start = m_head;
+    const int length = static_cast<int>(m_scan - m_head);
+    ++m_scan;
+    m_head = m_scan;
+    if (m_discarding) {
+      m_discarding = false;
+      continue;
+    }
+    if (c == '\a') {
+      ++m_stats.errorResponses;
+      continue;
+    }
+    if (length == 0) {
+      continue;  // "\r" command acknowledgement
+    }
+
+    if (!isFrameCommand(at(start))) {
+      continue;  // "z", "Z", version and status responses
+    }
+    CANFrame& frame = frames[count];
+    if (decodeLine(start, length, &frame)) {
+      frame.timestampNs = timestampNs;
+      ++count;
+      ++m_stats.frames;
+    } else {
+      ++m_stats.malformed;
+    }
+  }
+  return count;
+}
+
+bool SlcanParser::decodeLine(quint32 start, int length, CANFrame* frame) const {
+  const char type = at(start);
+  frame->extended = type >= 'A' && type <= 'Z';
+  frame->rtr = type == 'r' || type == 'R';
+  frame->fd = type == 'd' || type == 'D' || type == 'b' || type == 'B';
+  frame->bitRateSwitch = type == 'b' || type == 'B';
+
+  const int idDigits = frame->extended ? 8 : 3;
+  if (length < 1 + idDigits + 1) {
+    return false;
+  }
+
+  quint32 id = 0;
+  for (int i = 1; i <= idDigits; ++i) {
+    const int digit = hexValue(at(start + i));
+    if (digit < 0) {
+      return false;
+    }
+    id = (id << 4) | static_cast<quint32>(digit);
+  }
+  if (id > (frame->extended ? 0x1FFFFFFFu : 0x7FFu)) {
+    return false;
+  }
+  frame->id = id;
+
+  const int dlc = hexValue(at(start + 1 + idDigits));
+  if (dlc < 0 || (!frame->fd && dlc > 8)) {
+    return false;
+  }
+  frame->length = static_cast<quint8>(frame->fd ? canFdDlcToLength(dlc) : dlc);
+
+  // Remote frames carry no data; an adapter timestamp may follow either way
+  const int dataDigits = frame->rtr ? 0 : 2 * frame->length;
+  const int expected = 1 + idDigits + 1 + dataDigits;
+  if (length != expected && length != expected + 4) {
+    return false;
+  }
+
+  quint32 position = start + static_cast<quint32>(1 + idDigits + 1);
+  for (int i = 0; i < dataDigits / 2; ++i) {
+    const int high = hexValue(at(position));
+    const int low = hexValue(at(position + 1));
+    if ((high | low) < 0) {
+      return false;
+    }
+    frame->data[i] = static_cast<quint8>((high << 4) | low);
+    position += 2;
+  }
+  return true;
+}
+
+int SlcanParser::buffered() const {
+  return static_cast<int>(m_tail - m_head);
+}
+
+void SlcanParser::clear() {
+  m_head = m_scan = m_tail = 0;
+  m_discarding = false;
+}
+
+SlcanParser::Stats SlcanParser::stats() const {
+  return m_stats;
+}
+
+int SlcanParser::encode(const CANFrame& frame, char* out) {
+  if (frame.length > (frame.fd ? CANFrame::kMaxFdLength : CANFrame::kMaxClassicLength) ||
+      (frame.fd && frame.rtr) ||
+      frame.id > (frame.extended ? 0x1FFFFFFFu : 0x7FFu)) {
+    return 0;
+  }
+
+  char type = frame.rtr ? 'r' : 't';
+  if (frame.fd) {
+    type = frame.bitRateSwitch ? 'b' : 'd';
+  }
+  int position = 0;
+  out[position++] = frame.extended ? static_cast<char>(type - 'a' + 'A') : type;
+
+  const int idDigits = frame.extended ? 8 : 3;
+  for (int i = idDigits - 1; i >= 0; --i) {
+    out[position++] = kHexDigit[(frame.id >> (4 * i)) & 0xF];
+  }
+
+  const int dlc = frame.fd ? canFdLengthToDlc(frame.length) : frame.length;
+  out[position++] = kHexDigit[dlc];
+  if (!frame.rtr) {
+    // FD payloads are padded with zeros up to the DLC's length
+    const int length = frame.fd ? canFdDlcToLength(dlc) : frame.length;
+    for (int i = 0; i < length; ++i) {
+      const quint8 byte = i < frame.length ? frame.data[i] : 0;
+      out[position++] = kHexDigit[byte >> 4];
+      out[position++] = kHexDigit[byte & 0xF];
+    }
+  }
+  out[position++] = '\r';
+  return position;
+}
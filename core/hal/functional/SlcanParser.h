@@ -0,0 +1,91 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include "CANFrame.h"
+
+/**
+ * @brief Allocation-free SLCAN (Lawicel ASCII) tokenizer
+ *
+ * Bytes from the transport are appended to a fixed ring buffer; parse()
+ * decodes every complete line straight out of the ring into caller-owned
+ * CANFrame storage using a hex lookup table. No strings, copies or heap
+ * allocations are made per frame.
+ *
+ * Frames: t/T (data), r/R (remote), d/D (CAN FD), b/B (CAN FD with bit rate
+ * switch), lower case for 11-bit and upper case for 29-bit identifiers,
+ * optionally followed by a 4-digit adapter timestamp, which is ignored in
+ * favour of the host receive time. Command responses ("\r", "z\r", version
+ * strings) are skipped; BEL (error response) is counted.
+ */
+class SlcanParser {
+ public:
+  static constexpr int kCapacity = 4096;  // power of two
+  // 'T' + 8 id digits + DLC + 64 data bytes + 4 timestamp digits
+  static constexpr int kMaxLineLength = 1 + 8 + 1 + 2 * CANFrame::kMaxFdLength + 4;
+
+  struct Stats {
+    quint64 frames{0};
+    quint64 malformed{0};       // frame lines that did not decode
+    quint64 overflowBytes{0};   // dropped because the ring was full
+    quint64 errorResponses{0};  // BEL from the adapter
+  };
+
+  SlcanParser();
+
+  /**
+   * @brief Add received bytes to the ring
+   * @return Bytes accepted; anything beyond the free space is dropped
+   */
+  int append(const char* data, int size);
+
+  /**
+   * @brief Decode up to maxFrames complete lines
+   * @param timestampNs Receive time stamped on every decoded frame
+   * @return Number of frames written to frames
+   */
+  int parse(CANFrame* frames, int maxFrames, qint64 timestampNs);
+
+  int buffered() const;
+  void clear();
+  Stats stats() const;
+
+  /**
+   * @brief Encode a frame as an SLCAN transmit command, including the '\r'
+   * @param out At least kMaxLineLength + 1 bytes
+   * @return Bytes written, or 0 if the frame cannot be expressed
+   */
+  static int encode(const CANFrame& frame, char* out);
+
+ private:
+  char at(quint32 position) const {
+    return m_ring[position & (kCapacity - 1)];
+  }
+  bool decodeLine(quint32 start, int length, CANFrame* frame) const;
+
+  char m_ring[kCapacity];
+  quint32 m_head;  // first unparsed byte
+  quint32 m_scan;  // next byte to look at for a terminator
+  quint32 m_tail;  // one past the last byte appended
+  bool m_discarding;  // inside an overlong line; skip to the next terminator
+  Stats m_stats;
+};
@@ -0,0 +1,318 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UbxParser.h"
+
+#include <cstring>
+
+namespace {
+
+// CFG-VALSET keys (u-blox M9/M10 interface description)
+constexpr quint32 kKeyRateMeas = 0x30210001;  // U2, ms
+constexpr quint32 kKeyNavPvtUart1 = 0x20910007;
+constexpr quint32 kKeyNavPvtUsb = 0x20910009;
+constexpr quint32 kKeyNavDopUart1 = 0x20910039;
+constexpr quint32 kKeyNavDopUsb = 0x2091003b;
+// NMEA GGA, GLL, GSA, GSV, RMC, VTG; the USB key is UART1 + 2
+constexpr quint32 kKeyNmeaUart1[] = {0x209100bb, 0x209100ca, 0x209100c0,
+                                     0x209100c5, 0x209100ac, 0x209100b1};
+// Legacy CFG-MSG ids of the same sentences (class 0xF0)
+constexpr quint8 kNmeaClass = 0xF0;
+constexpr quint8 kNmeaIds[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05};
+
+inline quint16 u2(const quint8* p) {
+  return static_cast<quint16>(p[0] | (p[1] << 8));
+}
+
+inline quint32 u4(const quint8* p) {
+  return static_cast<quint32>(p[0]) | (static_cast<quint32>(p[1]) << 8) |
+         (static_cast<quint32>(p[2]) << 16) | (static_cast<quint32>(p[3]) << 24);
+}
+
+inline qint32 i4(const quint8* p) {
+  return static_cast<qint32>(u4(p));
+}
+
+void appendU1(QByteArray& out, quint8 value) {
+  out.append(static_cast<char>(value));
+}
+
+void appendU2(QByteArray& out, quint16 value) {
+  out.append(static_cast<char>(value & 0xFF));
+  out.append(static_cast<char>(value >> 8));
+}
+
+void appendU4(QByteArray& out, quint32 value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    out.append(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+int measurementPeriodMs(int rateHz) {
+  return 1000 / qBound(1, rateHz, 25);
+}
+
+}  // namespace
+
+UbxParser::UbxParser() {
+  clear();
+}
+
+void UbxParser::clear() {
+  m_state = State::Sync1;
+  m_class = 0;
+  m_id = 0;
+  m_length = 0;
+  m_received = 0;
+  m_checksumA = 0;
+  m_checksumB = 0;
+  m_skipping = false;
+  m_message = Message();
+}
+
+UbxParser::Stats UbxParser::stats() const {
+  return m_stats;
+}
+
+int UbxParser::feed(const char* data, int size, char* text, int* textSize, bool* frameReady) {
+  *frameReady = false;
+  int i = 0;
+  while (i < size) {
+    const quint8 byte = static_cast<quint8>(data[i++]);
+
+    // Everything but sync and payload feeds the checksum the same way
+    if (m_state != State::Sync1 && m_state != State::Sync2 && m_state != State::ChecksumA &&
+        m_state != State::ChecksumB) {
+      m_checksumA = static_cast<quint8>(m_checksumA + byte);
+      m_checksumB = static_cast<quint8>(m_checksumB + m_checksumA);
+    }
+
+    switch (m_state) {
+      case State::Sync1:
+        if (byte == kSync1) {
+          m_state = State::Sync2;
+        } else {
+          text[(*textSize)++] = static_cast<char>(byte);
+          ++m_stats.textBytes;
+        }
+        break;
+      case State::Sync2:
+        if (byte == kSync2) {
+          m_state = State::Class;
+          m_checksumA = 0;
+          m_checksumB = 0;
+        } else {
+          // Not a frame after all; the held 0xB5 was text
+          text[(*textSize)++] = static_cast<char>(kSync1);
+          ++m_stats.textBytes;
+          m_state = State::Sync1;
+          --i;  // look at this byte again
+        }
+        break;
+      case State::Class:
+        m_class = byte;
+        m_state = State::Id;
+        break;
+      case State::Id:
+        m_id = byte;
+        m_state = State::Length1;
+        break;
+      case State::Length1:
+        m_length = byte;
+        m_state = State::Length2;
+        break;
+      case State::Length2:
+        m_length |= byte << 8;
+        m_received = 0;
+        m_skipping = m_length > kMaxPayload;
+        if (m_skipping) {
+          ++m_stats.oversized;
+        }
+        m_state = m_length > 0 ? State::Payload : State::ChecksumA;
+        break;
+      case State::Payload:
+        if (!m_skipping) {
+          m_payload[m_received] = byte;
+        }
+        if (++m_received == m_length) {
+          m_state = State::ChecksumA;
+        }
+        break;
+      case State::ChecksumA:
+        if (byte != m_checksumA) {
+          ++m_stats.checksumErrors;
+          m_state = State::Sync1;
+        } else {
+          m_state = State::ChecksumB;
+        }
+        break;
+      case State::ChecksumB:
+        m_state = State::Sync1;
+        if (byte != m_checksumB) {
+          ++m_stats.checksumErrors;
+        } else if (!m_skipping) {
+          m_message.messageClass = m_class;
+          m_message.id = m_id;
+          m_message.length = static_cast<quint16>(m_length);
+          m_message.payload = m_payload;
+          ++m_stats.frames;
+          *frameReady = true;
+          return i;
+        }
+        break;
+    }
+  }
+  return i;
+}
+
+bool UbxParser::decodeNavPvt(const Message& message, NavPvt* pvt) {
+  if (message.messageClass != kClassNav || message.id != kIdNavPvt ||
+      message.length < kNavPvtLength) {
+    return false;
+  }
+  const quint8* p = message.payload;
+  pvt->iTowMs = u4(p);
+  pvt->year = u2(p + 4);
+  pvt->month = p[6];
+  pvt->day = p[7];
+  pvt->hour = p[8];
+  pvt->minute = p[9];
+  pvt->second = p[10];
+  pvt->validDate = p[11] & 0x01;
+  pvt->validTime = p[11] & 0x02;
+  pvt->nanoseconds = i4(p + 16);
+  pvt->fixType = p[20];
+  pvt->gnssFixOk = p[21] & 0x01;
+  pvt->satellites = p[23];
+  pvt->longitude = i4(p + 24) * 1e-7;
+  pvt->latitude = i4(p + 28) * 1e-7;
+  pvt->altitude = i4(p + 36) / 1000.0;
+  pvt->horizontalAccuracy = u4(p + 40) / 1000.0;
+  pvt->speed = i4(p + 60) / 1000.0;
+  pvt->heading = i4(p + 64) * 1e-5;
+  pvt->pdop = u2(p + 76) * 0.01;
+  return true;
+}
+
+bool UbxParser::decodeNavDop(const Message& message, NavDop* dop) {
+  if (message.messageClass != kClassNav || message.id != kIdNavDop ||
+      message.length < kNavDopLength) {
+    return false;
+  }
+  const quint8* p = message.payload;
+  dop->iTowMs = u4(p);
+  dop->pdop = u2(p + 6) * 0.01;
+  dop->vdop = u2(p + 10) * 0.01;
+  dop->hdop = u2(p + 12) * 0.01;
+  return true;
+}
+
+int UbxParser::encode(quint8 messageClass, quint8 id, const quint8* payload, int length,
+                      quint8* out) {
+  out[0] = kSync1;
+  out[1] = kSync2;
+  out[2] = messageClass;
+  out[3] = id;
+  out[4] = static_cast<quint8>(length & 0xFF);
+  out[5] = static_cast<quint8>(length >> 8);
+  if (length > 0) {
+    memcpy(out + 6, payload, static_cast<size_t>(length));
+  }
+  quint8 a = 0;
+  quint8 b = 0;
+  for (int i = 2; i < 6 + length; ++i) {
+    a = static_cast<quint8>(a + out[i]);
+    b = static_cast<quint8>(b + a);
+  }
+  out[6 + length] = a;
+  out[7 + length] = b;
+  return length + kOverhead;
+}
+
+QByteArray UbxParser::frame(quint8 messageClass, quint8 id, const QByteArray& payload) {
+  QByteArray out(payload.size() + kOverhead, Qt::Uninitialized);
+  encode(messageClass, id, reinterpret_cast<const quint8*>(payload.constData()),
+         static_cast<int>(payload.size()), reinterpret_cast<quint8*>(out.data()));
+  return out;
+}
+
+QByteArray UbxParser::cfgRate(int rateHz) {
+  QByteArray payload;
+  appendU2(payload, static_cast<quint16>(measurementPeriodMs(rateHz)));
+  appendU2(payload, 1);  // one navigation solution per measurement
+  appendU2(payload, 1);  // aligned to GPS time
+  return frame(kClassCfg, kIdCfgRate, payload);
+}
+
+QByteArray UbxParser::cfgMsg(quint8 messageClass, quint8 id, quint8 rate) {
+  // Short form: rate on the port the command arrives on
+  QByteArray payload;
+  appendU1(payload, messageClass);
+  appendU1(payload, id);
+  appendU1(payload, rate);
+  return frame(kClassCfg, kIdCfgMsg, payload);
+}
+
+QByteArray UbxParser::cfgValset(int rateHz, bool disableNmea) {
+  QByteArray payload;
+  appendU1(payload, 0);     // version
+  appendU1(payload, 0x01);  // RAM layer
+  appendU2(payload, 0);     // reserved
+
+  appendU4(payload, kKeyRateMeas);
+  appendU2(payload, static_cast<quint16>(measurementPeriodMs(rateHz)));
+  for (quint32 key : {kKeyNavPvtUart1, kKeyNavPvtUsb, kKeyNavDopUart1, kKeyNavDopUsb}) {
+    appendU4(payload, key);
+    appendU1(payload, 1);
+  }
+  if (disableNmea) {
+    for (quint32 key : kKeyNmeaUart1) {
+      appendU4(payload, key);
+      appendU1(payload, 0);
+      appendU4(payload, key + 2);
+      appendU1(payload, 0);
+    }
+  }
+  return frame(kClassCfg, kIdCfgValset, payload);
+}
+
+QByteArray UbxParser::configuration(int rateHz, bool disableNmea) {
+  QByteArray out = cfgRate(rateHz);
+  out += cfgMsg(kClassNav, kIdNavPvt, 1);
+  out += cfgMsg(kClassNav, kIdNavDop, 1);
+  if (disableNmea) {
+    for (quint8 id : kNmeaIds) {
+      out += cfgMsg(kNmeaClass, id, 0);
+    }
+  }
+  out += cfgValset(rateHz, disableNmea);
+  return out;
+}
+
+int UbxParser::maxRateHz(qint32 baudRate, bool disableNmea) {
+  if (baudRate <= 0) {
+    return 25;
+  }
+  const int bytesPerSecond = baudRate / 10;  // start, 8 data and stop bits
+  int bytesPerEpoch = kNavPvtLength + kNavDopLength + 2 * kOverhead;
+  if (!disableNmea) {
+    bytesPerEpoch += kNmeaEpochBytes;
+  }
+  return qBound(1, bytesPerSecond / bytesPerEpoch, 25);
+}
@@ -0,0 +1,180 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+
+/**
+ * @brief u-blox UBX binary protocol framer, decoder and encoder
+ *
+ * feed() runs the framing state machine (sync 0xB5 0x62, class, id,
+ * little-endian length, payload, Fletcher-8 checksum) over received bytes.
+ * Complete frames are exposed one at a time through message(); every byte
+ * outside a frame is copied to the caller's text buffer, so NMEA sentences
+ * interleaved on the same port can go on to NmeaParser. NMEA is 7-bit ASCII
+ * and never contains the 0xB5 sync byte.
+ *
+ * The payload buffer is fixed; frames longer than kMaxPayload are skipped
+ * and counted. Nothing is allocated.
+ */
+class UbxParser {
+ public:
+  static constexpr int kMaxPayload = 1024;
+  static constexpr int kOverhead = 8;  // sync, class, id, length, checksum
+  static constexpr quint8 kSync1 = 0xB5;
+  static constexpr quint8 kSync2 = 0x62;
+
+  // Message classes and ids used here
+  static constexpr quint8 kClassNav = 0x01;
+  static constexpr quint8 kClassAck = 0x05;
+  static constexpr quint8 kClassCfg = 0x06;
+  static constexpr quint8 kClassMon = 0x0A;
+  static constexpr quint8 kIdNavDop = 0x04;
+  static constexpr quint8 kIdNavPvt = 0x07;
+  static constexpr quint8 kIdAckNak = 0x00;
+  static constexpr quint8 kIdAckAck = 0x01;
+  static constexpr quint8 kIdCfgMsg = 0x01;
+  static constexpr quint8 kIdCfgRate = 0x08;
+  static constexpr quint8 kIdCfgValset = 0x8A;
+  static constexpr quint8 kIdMonVer = 0x04;
+
+  static constexpr int kNavPvtLength = 92;
+  static constexpr int kNavDopLength = 18;
+  // Default NMEA set (GGA, GLL, GSA, 3x GSV, RMC, VTG) per epoch, roughly
+  static constexpr int kNmeaEpochBytes = 480;
+
+  struct Message {
+    quint8 messageClass{0};
+    quint8 id{0};
+    quint16 length{0};
+    const quint8* payload{nullptr};  // valid until the next feed()
+  };
+
+  // UBX-NAV-PVT, scaled to SI units
+  struct NavPvt {
+    quint32 iTowMs{0};  // GPS time of week of the epoch
+    quint16 year{0};
+    quint8 month{0};
+    quint8 day{0};
+    quint8 hour{0};
+    quint8 minute{0};
+    quint8 second{0};
+    qint32 nanoseconds{0};  // may be negative
+    bool validDate{false};
+    bool validTime{false};
+    quint8 fixType{0};  // 0 none, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + DR, 5 time only
+    bool gnssFixOk{false};
+    quint8 satellites{0};
+    double latitude{0};   // degrees
+    double longitude{0};  // degrees
+    double altitude{0};   // metres above mean sea level
+    double speed{0};      // m/s over ground
+    double heading{0};    // degrees, heading of motion
+    double horizontalAccuracy{0};  // metres
+    double pdop{0};
+  };
+
+  // UBX-NAV-DOP, sent before NAV-PVT in each epoch
+  struct NavDop {
+    quint32 iTowMs{0};
+    double pdop{0};
+    double hdop{0};
+    double vdop{0};
+  };
+
+  struct Stats {
+    quint64 frames{0};
+    quint64 checksumErrors{0};
+    quint64 oversized{0};   // length above kMaxPayload
+    quint64 textBytes{0};   // passed through as non-UBX
+  };
+
+  UbxParser();
+
+  /**
+   * @brief Run the state machine until a frame completes or data runs out
+   * @param text Receives the bytes outside frames; room for size bytes
+   * @param textSize Incremented by the number of bytes written to text
+   * @param frameReady Set when message() holds a complete, verified frame
+   * @return Bytes of data consumed
+   */
+  int feed(const char* data, int size, char* text, int* textSize, bool* frameReady);
+
+  const Message& message() const {
+    return m_message;
+  }
+  void clear();
+  Stats stats() const;
+
+  static bool decodeNavPvt(const Message& message, NavPvt* pvt);
+  static bool decodeNavDop(const Message& message, NavDop* dop);
+
+  /**
+   * @brief Frame a message, adding sync bytes, length and checksum
+   * @param out At least length + kOverhead bytes
+   * @return Bytes written
+   */
+  static int encode(quint8 messageClass, quint8 id, const quint8* payload, int length,
+                    quint8* out);
+
+  // Ready-to-send configuration frames
+  static QByteArray frame(quint8 messageClass, quint8 id, const QByteArray& payload = {});
+  static QByteArray cfgRate(int rateHz);
+  static QByteArray cfgMsg(quint8 messageClass, quint8 id, quint8 rate);
+
+  /**
+   * @brief CFG-VALSET (M9 and later) in the RAM layer
+   *
+   * Sets the measurement rate, NAV-PVT and NAV-DOP output on UART1 and USB
+   * and, with disableNmea, turns the standard NMEA sentences off there.
+   */
+  static QByteArray cfgValset(int rateHz, bool disableNmea);
+
+  /**
+   * @brief The whole setup sequence for any generation of receiver
+   *
+   * Legacy CFG-RATE and CFG-MSG (up to M8) followed by CFG-VALSET (M9 and
+   * later); each receiver acknowledges what it knows and NAKs the rest.
+   */
+  static QByteArray configuration(int rateHz, bool disableNmea);
+
+  /**
+   * @brief Highest navigation rate whose output fits a UART at baudRate (8N1)
+   *
+   * Counts NAV-PVT and NAV-DOP per epoch, plus the NMEA sentences when they
+   * stay on. At least 1; 25 when the baud rate is unknown (0).
+   */
+  static int maxRateHz(qint32 baudRate, bool disableNmea);
+
+ private:
+  enum class State { Sync1, Sync2, Class, Id, Length1, Length2, Payload, ChecksumA, ChecksumB };
+
+  State m_state;
+  quint8 m_class;
+  quint8 m_id;
+  int m_length;
+  int m_received;
+  quint8 m_checksumA;
+  quint8 m_checksumB;
+  bool m_skipping;  // oversized: count the payload through without storing it
+  quint8 m_payload[kMaxPayload];
+  Message m_message;
+  Stats m_stats;
+};
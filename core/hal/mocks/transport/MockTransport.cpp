@@ -161,8 +161,14 @@ void MockTransport::onAutoInjectTimer() {
   m_autoInjectCounter++;
 
   // Example: Inject NMEA sentence for GPS
-  QString nmea = QString("$GPGGA,%1,5140.1234,N,00009.5678,W,1,08,0.9,100.0,M,47.0,M,,*47\r\n")
-                     .arg(QTime::currentTime().toString("hhmmss.zzz"));
+  const QByteArray body = QString("GPGGA,%1,5140.1234,N,00009.5678,W,1,08,0.9,100.0,M,47.0,M,,")
+                              .arg(QTime::currentTime().toString("hhmmss.zzz"))
+                              .toLatin1();
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
 
-  injectData(nmea.toLatin1());
+  injectData("$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+             "\r\n");
 }
@@ -23,6 +23,7 @@
 #include <cmath>
 #include <cstring>
 
+#include "../../services/diagnostics/FlightRecorder.h"
 #include "../../services/logging/Logger.h"
 
 AudioMixer::AudioMixer(QObject* parent) : IAudioMixer(parent) {
@@ -235,6 +236,16 @@ void AudioMixer::mixBuffers() {
     for (auto it = m_channels.begin(); it != m_channels.end(); ++it) {
       if (it->active && it->buffer.size() >= mixBufferSize) {
         sortedChannels.append(it.key());
+        it->starved = false;
+      } else if (it->active && !it->starved) {
+        // Active but starved: this channel drops out of the mix (underrun).
+        // Recorded once per underrun, not on every tick it lasts
+        it->starved = true;
+        crankshaft::diagnostics::FlightRecorder::instance().record(
+            crankshaft::diagnostics::flight::Event::MixerUnderrun,
+            static_cast<uint16_t>(it.key()),
+            static_cast<uint32_t>(mixBufferSize - it->buffer.size()),
+            static_cast<uint64_t>(it->buffer.size()));
       }
     }
 
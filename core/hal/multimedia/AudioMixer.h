@@ -69,6 +69,7 @@ class AudioMixer : public IAudioMixer {
     ChannelConfig config;
     QByteArray buffer;  // Buffered audio data
     bool active{false};
+    bool starved{false};  // underrun already recorded; cleared once it mixes again
   };
 
   QByteArray convertFormat(const QByteArray& input, const AudioFormat& inputFormat,
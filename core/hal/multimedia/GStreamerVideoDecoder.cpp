@@ -21,6 +21,8 @@
 
 #include <QMutexLocker>
 
+#include "../../services/diagnostics/FlightRecorder.h"
+#include "../../services/extensions/DataChannelHub.h"
 #include "../../services/logging/Logger.h"
 
 GStreamerVideoDecoder::GStreamerVideoDecoder(QObject* parent) : IVideoDecoder(parent) {
@@ -41,6 +43,10 @@ bool GStreamerVideoDecoder::initialize(const DecoderConfig& config) {
 
   m_config = config;
 
+  // Subscribers' rings are sized for a whole RGBA frame at this resolution
+  m_frameTopic = DataChannelHub::instance().registerTopic(
+      QStringLiteral("media/video/frame"), static_cast<quint32>(config.width * config.height * 4));
+
   if (!createPipeline()) {
     Logger::instance().error("Failed to create GStreamer pipeline");
     emit errorOccurred("Failed to create decoder pipeline");
@@ -274,6 +280,9 @@ bool GStreamerVideoDecoder::decodeFrame(const QByteArray& encodedData) {
     return false;
   }
 
+  crankshaft::diagnostics::FlightRecorder::instance().record(
+      crankshaft::diagnostics::flight::Event::DecoderPush, 0,
+      static_cast<uint32_t>(encodedData.size()), ++m_pushedFrames);
   return true;
 }
 
@@ -319,10 +328,23 @@ GstFlowReturn GStreamerVideoDecoder::onNewSample(GstAppSink* appsink, gpointer u
   // Emit decoded frame signal
   QMutexLocker locker(&decoder->m_mutex);
   decoder->m_decodedFrames++;
+  crankshaft::diagnostics::FlightRecorder::instance().record(
+      crankshaft::diagnostics::flight::Event::DecoderPop, 0,
+      (static_cast<uint32_t>(width) << 16) | static_cast<uint32_t>(height & 0xffff),
+      static_cast<uint64_t>(decoder->m_decodedFrames));
 
   // Emit signal with frame data
   emit decoder->frameDecoded(width, height, map.data, map.size);
 
+  // Extensions subscribed over a data channel get the frame straight from here
+  DataChannelHub& dataChannels = DataChannelHub::instance();
+  if (dataChannels.hasSubscribers(decoder->m_frameTopic)) {
+    dataChannels.publish(
+        decoder->m_frameTopic, datachannel::Kind::Blob, map.data, static_cast<quint32>(map.size),
+        datachannel::kFormatRgba,
+        (static_cast<uint32_t>(width) << 16) | static_cast<uint32_t>(height & 0xffff));
+  }
+
   // Emit statistics every 30 frames
   if (decoder->m_decodedFrames % 30 == 0) {
     emit decoder->statsUpdated(decoder->m_decodedFrames, decoder->m_droppedFrames,
@@ -68,6 +68,7 @@ class GStreamerVideoDecoder : public IVideoDecoder {
 
   DecoderConfig m_config;
   bool m_isInitialized{false};
+  int m_frameTopic{-1};  // media/video/frame on the data channels
 
   // GStreamer pipeline elements
   GstElement* m_pipeline{nullptr};
@@ -80,5 +81,6 @@ class GStreamerVideoDecoder : public IVideoDecoder {
   // Statistics
   int m_decodedFrames{0};
   int m_droppedFrames{0};
+  quint64 m_pushedFrames{0};
   QMutex m_mutex;
 };
@@ -0,0 +1,231 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IoReactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "../../services/logging/Logger.h"
+
+namespace {
+
+qint64 monotonicNs() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<qint64>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+}  // namespace
+
+IoReactor::IoReactor() {
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (m_epollFd < 0 || m_wakeFd < 0) {
+    Logger::instance().warning(QString("[IoReactor] epoll setup failed (%1)")
+                                   .arg(QString::fromLocal8Bit(strerror(errno))));
+    return;
+  }
+
+  epoll_event wake{};
+  wake.events = EPOLLIN;
+  wake.data.u64 = kWakeToken;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &wake);
+
+  m_thread = std::thread([this]() { run(); });
+}
+
+IoReactor::~IoReactor() {
+  if (m_thread.joinable()) {
+    m_stopping.store(true);
+    wake();
+    m_thread.join();
+  }
+  for (int fd : {m_wakeFd, m_epollFd}) {
+    if (fd >= 0) ::close(fd);
+  }
+}
+
+IoReactor& IoReactor::instance() {
+  static IoReactor reactor;
+  return reactor;
+}
+
+bool IoReactor::isValid() const {
+  return m_thread.joinable();
+}
+
+bool IoReactor::isReactorThread() const {
+  return std::this_thread::get_id() == m_thread.get_id();
+}
+
+bool IoReactor::add(int fd, Handler* handler) {
+  if (!isValid() || fd < 0 || !handler) {
+    return false;
+  }
+  QMutexLocker locker(&m_mutex);
+  if (m_entries.contains(fd)) {
+    return false;
+  }
+  Entry entry;
+  entry.handler = handler;
+  entry.token = (++m_generation << 32) | static_cast<quint32>(fd);
+  if (!arm(fd, entry)) {
+    Logger::instance().warning(QString("[IoReactor] cannot watch fd %1: %2")
+                                   .arg(fd)
+                                   .arg(QString::fromLocal8Bit(strerror(errno))));
+    return false;
+  }
+  m_entries.insert(fd, entry);
+  return true;
+}
+
+void IoReactor::remove(int fd) {
+  // Blocks while the reactor thread is inside a handler
+  QMutexLocker locker(&m_mutex);
+  auto it = m_entries.find(fd);
+  if (it == m_entries.end()) {
+    return;
+  }
+  if (it->armed) {
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+  }
+  m_entries.erase(it);
+}
+
+void IoReactor::rest(int fd, qint64 delayNs) {
+  if (delayNs <= 0) {
+    return;
+  }
+  QMutexLocker locker(&m_mutex);
+  auto it = m_entries.find(fd);
+  if (it == m_entries.end() || it->restUntilNs == kForeverNs) {
+    return;
+  }
+  if (it->armed) {
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    it->armed = false;
+  }
+  it->restUntilNs = monotonicNs() + delayNs;
+  ++m_stats.rests;
+  if (!isReactorThread()) {
+    wake();  // the wait timeout has to account for the new deadline
+  }
+}
+
+IoReactor::Stats IoReactor::stats() const {
+  QMutexLocker locker(&m_mutex);
+  return m_stats;
+}
+
+void IoReactor::wake() {
+  const uint64_t one = 1;
+  [[maybe_unused]] const ssize_t written = ::write(m_wakeFd, &one, sizeof(one));
+}
+
+bool IoReactor::arm(int fd, const Entry& entry) {
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = entry.token;
+  return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void IoReactor::rearmDue(qint64 nowNs) {
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+    if (it->armed || it->restUntilNs > nowNs) {
+      continue;
+    }
+    if (arm(it.key(), it.value())) {
+      it->armed = true;
+    } else {
+      it->restUntilNs = kForeverNs;  // closed under us; wait for remove()
+    }
+  }
+}
+
+int IoReactor::waitTimeoutMs(qint64 nowNs) const {
+  qint64 nearest = kForeverNs;
+  for (const Entry& entry : m_entries) {
+    if (!entry.armed) {
+      nearest = qMin(nearest, entry.restUntilNs);
+    }
+  }
+  if (nearest == kForeverNs) {
+    return -1;
+  }
+  // Rounded up: waking before the deadline would only wait again
+  return static_cast<int>(qMax<qint64>(0, nearest - nowNs + 999999) / 1000000);
+}
+
+void IoReactor::run() {
+  epoll_event events[kMaxEvents];
+  while (!m_stopping.load()) {
+    int timeoutMs;
+    {
+      QMutexLocker locker(&m_mutex);
+      timeoutMs = waitTimeoutMs(monotonicNs());
+    }
+    const int count = epoll_wait(m_epollFd, events, kMaxEvents, timeoutMs);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (count > 0) {
+      ++m_stats.wakeups;
+    }
+    for (int i = 0; i < count; ++i) {
+      const quint64 token = events[i].data.u64;
+      if (token == kWakeToken) {
+        uint64_t value = 0;
+        [[maybe_unused]] const ssize_t drained = ::read(m_wakeFd, &value, sizeof(value));
+        continue;
+      }
+      // Removed (or removed and reused) since epoll_wait returned
+      const int fd = static_cast<int>(token & 0xffffffffu);
+      auto it = m_entries.constFind(fd);
+      if (it == m_entries.constEnd() || it->token != token) {
+        continue;
+      }
+      ++m_stats.dispatches;
+      it->handler->onReactorReadable();
+
+      if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+        // The handler saw the end of the stream; stop spinning on it
+        auto entry = m_entries.find(fd);
+        if (entry != m_entries.end() && entry->token == token) {
+          if (entry->armed) {
+            epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            entry->armed = false;
+          }
+          entry->restUntilNs = kForeverNs;
+          ++m_stats.hangups;
+          entry->handler->onReactorHangup();
+        }
+      }
+    }
+    rearmDue(monotonicNs());
+  }
+}
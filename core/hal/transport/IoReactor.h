@@ -0,0 +1,137 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QRecursiveMutex>
+#include <QtGlobal>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+/**
+ * @brief One epoll thread for the receive side of every HAL transport
+ *
+ * Transports register their descriptors here instead of creating a
+ * QSocketNotifier each, so a stream of GPS sentences and CAN frames wakes
+ * one HAL thread rather than the UI thread. Each readable descriptor's
+ * Handler is called on that thread; it drains the descriptor into its own
+ * receive buffer, lets the parsers run, and hands batched results to their
+ * owners with queued calls.
+ *
+ * Descriptors are level triggered. rest() takes one out of the set for a
+ * while so a busy port is read in batches; the wait timeout is the nearest
+ * rest deadline, so nothing else polls. A descriptor that reports a hangup
+ * or an error gets one last handler call, then onReactorHangup(), and is
+ * left out until it is removed.
+ *
+ * Handlers run with the reactor's lock held: remove() returns only once no
+ * handler call for that descriptor is in flight, so a transport can close
+ * its descriptor and free its buffers straight after. Handlers must never
+ * block on the thread that calls remove().
+ */
+class IoReactor {
+ public:
+  class Handler {
+   public:
+    virtual ~Handler() = default;
+
+    /**
+     * @brief The descriptor is readable (or hung up); called on the reactor thread
+     */
+    virtual void onReactorReadable() = 0;
+
+    /**
+     * @brief The descriptor hung up and is no longer watched; called on the reactor thread
+     *
+     * The owner should close the descriptor (from its own thread) and report the loss.
+     */
+    virtual void onReactorHangup() {}
+  };
+
+  struct Stats {
+    quint64 wakeups{0};     // epoll_wait() returns with events
+    quint64 dispatches{0};  // handler calls
+    quint64 rests{0};
+    quint64 hangups{0};
+  };
+
+  IoReactor();
+  ~IoReactor();
+
+  IoReactor(const IoReactor&) = delete;
+  IoReactor& operator=(const IoReactor&) = delete;
+
+  /**
+   * @brief The process-wide HAL reactor, started on first use
+   */
+  static IoReactor& instance();
+
+  bool isValid() const;
+
+  /**
+   * @brief Watch fd for input; handler is called on the reactor thread
+   * @return false if fd is already watched or epoll refuses it
+   */
+  bool add(int fd, Handler* handler);
+
+  /**
+   * @brief Stop watching fd, waiting for a handler call in flight to return
+   */
+  void remove(int fd);
+
+  /**
+   * @brief Leave fd out of the set for delayNs, then watch it again
+   */
+  void rest(int fd, qint64 delayNs);
+
+  bool isReactorThread() const;
+
+  Stats stats() const;
+
+ private:
+  struct Entry {
+    Handler* handler{nullptr};
+    quint64 token{0};
+    bool armed{true};
+    qint64 restUntilNs{0};  // while not armed; kForeverNs after a hangup
+  };
+
+  static constexpr quint64 kWakeToken = 0;
+  static constexpr int kMaxEvents = 32;
+  static constexpr qint64 kForeverNs = std::numeric_limits<qint64>::max();
+
+  void run();
+  void wake();
+  bool arm(int fd, const Entry& entry);
+  void rearmDue(qint64 nowNs);
+  int waitTimeoutMs(qint64 nowNs) const;
+
+  int m_epollFd{-1};
+  int m_wakeFd{-1};
+  std::thread m_thread;
+  std::atomic<bool> m_stopping{false};
+
+  // Held by the reactor thread while it dispatches
+  mutable QRecursiveMutex m_mutex;
+  QHash<int, Entry> m_entries;
+  quint64 m_generation{0};  // token = generation << 32 | fd, so reused fds are told apart
+  Stats m_stats;
+};
@@ -0,0 +1,294 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReplayTransport.h"
+
+#include <QTimer>
+#include <cstring>
+
+#include "../../services/logging/Logger.h"
+#include "../functional/SlcanParser.h"
+
+namespace {
+
+constexpr int kDefaultMaxBatchBytes = 64 * 1024;
+constexpr int kMaxRecordsPerPass = 1024;
+
+}  // namespace
+
+using crankshaft::diagnostics::CaptureReader;
+namespace capture = crankshaft::diagnostics::capture;
+
+ReplayTransport::ReplayTransport(const QString& capturePath, const QString& streamName,
+                                 QObject* parent)
+    : Transport(parent),
+      m_capturePath(capturePath),
+      m_streamName(streamName),
+      m_state(TransportState::DISCONNECTED),
+      m_timer(new QTimer(this)),
+      m_stream(-1),
+      m_canFrames(false),
+      m_hasPending(false),
+      m_finished(false),
+      m_rxOffset(0) {
+  m_config["speed"] = 1.0;
+  m_config["loop"] = false;
+  m_config["maxBatchBytes"] = kDefaultMaxBatchBytes;
+
+  m_timer->setSingleShot(true);
+  m_timer->setTimerType(Qt::PreciseTimer);
+  connect(m_timer, &QTimer::timeout, this, &ReplayTransport::onReplayTimer);
+}
+
+ReplayTransport::~ReplayTransport() {
+  close();
+}
+
+QString ReplayTransport::getName() const {
+  return QString("Replay(%1)").arg(m_streamName.isEmpty() ? m_capturePath : m_streamName);
+}
+
+bool ReplayTransport::open() {
+  if (isOpen()) {
+    return true;
+  }
+  setState(TransportState::CONNECTING);
+
+  QString error;
+  if (!m_reader.open(m_capturePath, &error)) {
+    setState(TransportState::ERROR);
+    emit errorOccurred(QString("Replay: %1").arg(error));
+    return false;
+  }
+
+  m_stream = -1;
+  for (const capture::StreamInfo& info : m_reader.streams()) {
+    const auto kind = static_cast<capture::StreamKind>(info.kind);
+    if (kind != capture::StreamKind::Bytes && kind != capture::StreamKind::CanFrames) {
+      continue;
+    }
+    if (m_streamName.isEmpty() || QString::fromUtf8(info.name) == m_streamName) {
+      m_stream = info.id;
+      m_canFrames = kind == capture::StreamKind::CanFrames;
+      break;
+    }
+  }
+  if (m_stream < 0) {
+    m_reader.close();
+    setState(TransportState::ERROR);
+    emit errorOccurred(QString("Replay: %1 has no byte or CAN stream %2")
+                           .arg(m_capturePath, m_streamName));
+    return false;
+  }
+
+  Logger::instance().info(QString("Replay: playing %1 from %2 (%3 s, speed %4)")
+                              .arg(getName(), m_capturePath)
+                              .arg(m_reader.durationNs() / 1e9, 0, 'f', 1)
+                              .arg(m_config.value("speed").toDouble()));
+  m_rxBuffer.clear();
+  m_rxOffset = 0;
+  m_finished = false;
+  restart();
+  setState(TransportState::CONNECTED);
+  emit connected();
+  m_timer->start(0);
+  return true;
+}
+
+void ReplayTransport::close() {
+  if (m_state == TransportState::DISCONNECTED) {
+    return;
+  }
+  m_timer->stop();
+  m_reader.close();
+  m_hasPending = false;
+  m_rxBuffer.clear();
+  m_rxOffset = 0;
+  setState(TransportState::DISCONNECTED);
+  emit disconnected();
+}
+
+bool ReplayTransport::isOpen() const {
+  return m_state == TransportState::CONNECTED;
+}
+
+TransportState ReplayTransport::getState() const {
+  return m_state;
+}
+
+void ReplayTransport::setState(TransportState state) {
+  if (m_state != state) {
+    m_state = state;
+    emit stateChanged(state);
+  }
+}
+
+void ReplayTransport::restart() {
+  m_reader.rewind();
+  m_hasPending = m_reader.next(&m_pending, m_stream);
+  m_clock.start(m_hasPending ? m_pending.timestampNs : 0,
+                m_config.value("speed").toDouble());
+}
+
+void ReplayTransport::onReplayTimer() {
+  if (!isOpen()) {
+    return;
+  }
+
+  // As fast as possible still waits for the reader to catch up
+  const qint64 maxBatchBytes = qMax(1, m_config.value("maxBatchBytes").toInt());
+  if (!m_clock.isPaced() && bytesAvailable() >= maxBatchBytes) {
+    m_timer->start(1);
+    return;
+  }
+
+  const qint64 before = m_stats.bytesDelivered;
+  int records = 0;
+  while (m_hasPending) {
+    const qint64 waitNs = m_clock.untilDue(m_pending.timestampNs);
+    if (waitNs > 0) {
+      m_timer->start(static_cast<int>((waitNs + 999999) / 1000000));
+      break;
+    }
+
+    deliver(m_pending);
+    m_hasPending = m_reader.next(&m_pending, m_stream);
+    if (!m_hasPending && m_config.value("loop").toBool()) {
+      ++m_stats.loops;
+      restart();
+    }
+    if (m_stats.bytesDelivered - before >= static_cast<quint64>(maxBatchBytes) ||
+        ++records >= kMaxRecordsPerPass) {
+      m_timer->start(0);  // let the event loop, and the reader, run
+      break;
+    }
+  }
+
+  if (m_stats.bytesDelivered > before) {
+    emit dataReceived();
+    if (!isOpen()) {
+      return;  // closed by a reader
+    }
+  }
+  if (!m_hasPending && !m_finished) {
+    m_finished = true;
+    Logger::instance().info(QString("Replay: %1 finished after %2 records")
+                                .arg(getName())
+                                .arg(m_stats.records));
+    emit replayFinished();
+  }
+}
+
+void ReplayTransport::deliver(const CaptureReader::Record& record) {
+  // Drop what has been read before it is worth keeping
+  if (m_rxOffset > 0 && m_rxOffset >= m_rxBuffer.size() / 2) {
+    m_rxBuffer.remove(0, m_rxOffset);
+    m_rxOffset = 0;
+  }
+
+  const qsizetype before = m_rxBuffer.size();
+  if (!m_canFrames) {
+    m_rxBuffer.append(record.data, record.size);
+  } else {
+    char line[SlcanParser::kMaxLineLength + 1];
+    const quint32 count = record.size / sizeof(capture::CanFrameRecord);
+    for (quint32 i = 0; i < count; ++i) {
+      capture::CanFrameRecord recorded;
+      memcpy(&recorded, record.data + i * sizeof(recorded), sizeof(recorded));
+      CANFrame frame{};
+      frame.id = recorded.id;
+      frame.length = qMin<quint8>(recorded.length, CANFrame::kMaxFdLength);
+      frame.extended = recorded.flags & capture::kCanExtended;
+      frame.rtr = recorded.flags & capture::kCanRtr;
+      frame.fd = recorded.flags & capture::kCanFd;
+      frame.bitRateSwitch = recorded.flags & capture::kCanBitRateSwitch;
+      memcpy(frame.data, recorded.data, frame.length);
+      const int length = SlcanParser::encode(frame, line);
+      m_rxBuffer.append(line, length);
+    }
+  }
+  ++m_stats.records;
+  m_stats.bytesDelivered += static_cast<quint64>(m_rxBuffer.size() - before);
+}
+
+qint64 ReplayTransport::write(const QByteArray& data) {
+  if (!isOpen()) {
+    return -1;
+  }
+  m_stats.bytesWritten += static_cast<quint64>(data.size());
+  return data.size();
+}
+
+QByteArray ReplayTransport::read(qint64 maxSize) {
+  const qint64 available = bytesAvailable();
+  const qint64 size = maxSize > 0 ? qMin(maxSize, available) : available;
+  QByteArray data(size, Qt::Uninitialized);
+  const qint64 count = readInto(std::span<char>(data.data(), static_cast<size_t>(size)));
+  data.truncate(qMax<qint64>(0, count));
+  return data;
+}
+
+qint64 ReplayTransport::readInto(std::span<char> buffer) {
+  if (!isOpen()) {
+    return -1;
+  }
+  const qint64 count = qMin(static_cast<qint64>(buffer.size()), bytesAvailable());
+  if (count > 0) {
+    memcpy(buffer.data(), m_rxBuffer.constData() + m_rxOffset, static_cast<size_t>(count));
+    m_rxOffset += count;
+  }
+  return count;
+}
+
+qint64 ReplayTransport::bytesAvailable() const {
+  return m_rxBuffer.size() - m_rxOffset;
+}
+
+void ReplayTransport::flush() {}
+
+bool ReplayTransport::configure(const QString& key, const QVariant& value) {
+  if (key == "speed") {
+    m_config[key] = value.toDouble();
+    if (m_hasPending) {
+      m_clock.start(m_pending.timestampNs, value.toDouble());  // from here on
+    }
+    return true;
+  }
+  if (key == "loop") {
+    m_config[key] = value.toBool();
+    return true;
+  }
+  if (key == "maxBatchBytes") {
+    m_config[key] = qMax(1, value.toInt());
+    return true;
+  }
+  return false;
+}
+
+QVariant ReplayTransport::getConfiguration(const QString& key) const {
+  return m_config.value(key);
+}
+
+ReplayTransport::Stats ReplayTransport::stats() const {
+  return m_stats;
+}
+
+bool ReplayTransport::isFinished() const {
+  return m_finished;
+}
@@ -0,0 +1,130 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+
+#include "../../services/diagnostics/CaptureReader.h"
+#include "Transport.h"
+
+class QTimer;
+
+/**
+ * @brief Transport that plays back a stream recorded with setCapture()
+ *
+ * Lets GPSDevice, CANDevice and anything else built on a Transport run
+ * against a drive recorded in the field. Byte streams come back exactly as
+ * they were read; CAN frame streams (from SocketCANTransport) are turned
+ * into SLCAN lines, which CANDevice parses like a serial adapter's. Data is
+ * delivered on the transport's thread from a timer, at the recorded pace
+ * scaled by "speed", or as fast as the reader takes it with "speed" 0.
+ * Writes are accepted and discarded.
+ *
+ * Configuration keys:
+ *   - "speed": 1.0 for real time (default), 2.0 for twice as fast, 0 for as
+ *              fast as possible
+ *   - "loop": Start over at the end instead of finishing (bool, default false)
+ *   - "maxBatchBytes": Bytes delivered per event-loop pass and most held
+ *                      unread when replaying as fast as possible (default 64 KiB)
+ *
+ * Example:
+ *   auto replay = new ReplayTransport("/data/drive.cap", "UART(/dev/ttyACM0)");
+ *   replay->configure("speed", 0);
+ *   auto gps = new GPSDevice(replay);
+ */
+class ReplayTransport : public Transport {
+  Q_OBJECT
+
+ public:
+  struct Stats {
+    quint64 records{0};         // capture records delivered
+    quint64 bytesDelivered{0};  // bytes made available to read
+    quint64 bytesWritten{0};    // written and discarded
+    quint64 loops{0};
+  };
+
+  /**
+   * @param capturePath Capture file
+   * @param streamName Stream to play; the first byte or CAN stream if empty
+   */
+  explicit ReplayTransport(const QString& capturePath, const QString& streamName = QString(),
+                           QObject* parent = nullptr);
+  ~ReplayTransport() override;
+
+  TransportType getType() const override {
+    return TransportType::VIRTUAL;
+  }
+  QString getName() const override;
+
+  bool open() override;
+  void close() override;
+  bool isOpen() const override;
+  TransportState getState() const override;
+
+  qint64 write(const QByteArray& data) override;
+  QByteArray read(qint64 maxSize = 0) override;
+  qint64 readInto(std::span<char> buffer) override;
+  qint64 bytesAvailable() const override;
+  void flush() override;
+
+  bool configure(const QString& key, const QVariant& value) override;
+  QVariant getConfiguration(const QString& key) const override;
+
+  Stats stats() const;
+
+  /**
+   * @brief True once the last record has been delivered (never with "loop")
+   */
+  bool isFinished() const;
+
+ signals:
+  /**
+   * @brief Emitted after the last record has been delivered
+   */
+  void replayFinished();
+
+ private slots:
+  void onReplayTimer();
+
+ private:
+  void deliver(const crankshaft::diagnostics::CaptureReader::Record& record);
+  void restart();
+  void setState(TransportState state);
+
+  QString m_capturePath;
+  QString m_streamName;
+  TransportState m_state;
+  QVariantMap m_config;
+  crankshaft::diagnostics::CaptureReader m_reader;
+  crankshaft::diagnostics::ReplayClock m_clock;
+  QTimer* m_timer;
+  int m_stream;
+  bool m_canFrames;
+
+  // Next record, read ahead while it is not yet due
+  crankshaft::diagnostics::CaptureReader::Record m_pending;
+  bool m_hasPending;
+  bool m_finished;
+
+  // Delivered and not yet read; m_rxOffset bytes of it are consumed
+  QByteArray m_rxBuffer;
+  qsizetype m_rxOffset;
+  Stats m_stats;
+};
@@ -0,0 +1,736 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SocketCANTransport.h"
+
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+
+#include "../../services/diagnostics/CaptureWriter.h"
+#include "../../services/logging/Logger.h"
+
+namespace {
+
+constexpr int kDefaultBatchSize = 64;
+constexpr int kDefaultRxQueueFrames = 4096;
+constexpr int kMaxTxQueueFrames = 4096;
+
+// Room for SCM_TIMESTAMPING and SO_RXQ_OVFL per received frame
+constexpr size_t kControlSpace =
+    CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(quint32));
+
+qint64 clockNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+qint64 toNs(const timespec& ts) {
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+bool parseHex(const QString& text, quint32* value) {
+  bool ok = false;
+  *value = text.trimmed().toUInt(&ok, 16);
+  return ok;
+}
+
+}  // namespace
+
+SocketCANTransport::SocketCANTransport(const QString& interfaceName, QObject* parent)
+    : Transport(parent),
+      m_interfaceName(interfaceName),
+      m_state(TransportState::DISCONNECTED),
+      m_fd(-1),
+      m_readNotifier(nullptr),
+      m_writeNotifier(nullptr),
+      m_reactor(nullptr),
+      m_capture(nullptr),
+      m_captureStream(-1),
+      m_fdFrames(false),
+      m_batchSize(kDefaultBatchSize),
+      m_rxQueueFrames(kDefaultRxQueueFrames),
+      m_rxHead(0),
+      m_framesReceived(0),
+      m_receiveCalls(0),
+      m_queueDropped(0),
+      m_kernelDropped(0),
+      m_errorFrames(0) {
+  // Set default configuration
+  m_config["interface"] = interfaceName;
+  m_config["fd"] = false;
+  m_config["errorMask"] = static_cast<quint32>(CAN_ERR_TX_TIMEOUT | CAN_ERR_CRTL | CAN_ERR_BUSOFF |
+                                               CAN_ERR_BUSERROR | CAN_ERR_RESTARTED);
+  m_config["receiveOwnMessages"] = false;
+  m_config["batchSize"] = kDefaultBatchSize;
+  m_config["rxQueueFrames"] = kDefaultRxQueueFrames;
+  resizeBatch();
+}
+
+SocketCANTransport::~SocketCANTransport() {
+  close();
+}
+
+QString SocketCANTransport::getName() const {
+  return QString("SocketCAN(%1)").arg(m_interfaceName);
+}
+
+bool SocketCANTransport::open() {
+  if (m_state == TransportState::CONNECTED) {
+    return true;
+  }
+
+  setState(TransportState::CONNECTING);
+
+  m_fd = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+  if (m_fd < 0) {
+    const QString error = QString("SocketCAN: socket() failed: %1").arg(strerror(errno));
+    Logger::instance().warning(error);
+    setState(TransportState::ERROR);
+    emit errorOccurred(error);
+    return false;
+  }
+
+  sockaddr_can addr{};
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = static_cast<int>(if_nametoindex(m_interfaceName.toLocal8Bit().constData()));
+  if (addr.can_ifindex == 0 || !applySocketOptions() ||
+      ::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    const QString error =
+        QString("SocketCAN: cannot open %1: %2").arg(m_interfaceName, strerror(errno));
+    Logger::instance().warning(error);
+    ::close(m_fd);
+    m_fd = -1;
+    setState(TransportState::ERROR);
+    emit errorOccurred(error);
+    return false;
+  }
+
+  m_readNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+  connect(m_readNotifier, &QSocketNotifier::activated, this, &SocketCANTransport::onReadable);
+  m_writeNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Write, this);
+  m_writeNotifier->setEnabled(false);
+  connect(m_writeNotifier, &QSocketNotifier::activated, this, &SocketCANTransport::onWritable);
+  watchReads();
+
+  Logger::instance().info(QString("SocketCAN: %1 open (%2, %3 filters)")
+                              .arg(m_interfaceName, m_fdFrames ? "CAN FD" : "CAN 2.0")
+                              .arg(m_filters.size()));
+  setState(TransportState::CONNECTED);
+  emit connected();
+  return true;
+}
+
+void SocketCANTransport::close() {
+  if (m_state == TransportState::DISCONNECTED) {
+    return;
+  }
+
+  if (m_reactor && m_fd >= 0) {
+    m_reactor->remove(m_fd);
+  }
+  delete m_readNotifier;
+  m_readNotifier = nullptr;
+  delete m_writeNotifier;
+  m_writeNotifier = nullptr;
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  m_rxQueue.clear();
+  m_rxHead = 0;
+  m_txQueue.clear();
+
+  const bool wasConnected = m_state == TransportState::CONNECTED;
+  setState(TransportState::DISCONNECTED);
+  if (wasConnected) {
+    emit disconnected();
+  }
+}
+
+bool SocketCANTransport::isOpen() const {
+  return m_state == TransportState::CONNECTED;
+}
+
+TransportState SocketCANTransport::getState() const {
+  return m_state;
+}
+
+void SocketCANTransport::setState(TransportState state) {
+  if (m_state != state) {
+    m_state = state;
+    emit stateChanged(m_state);
+  }
+}
+
+bool SocketCANTransport::applySocketOptions() {
+  const int fdFrames = m_fdFrames ? 1 : 0;
+  if (::setsockopt(m_fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &fdFrames, sizeof(fdFrames)) < 0 &&
+      m_fdFrames) {
+    return false;  // the kernel or interface has no CAN FD
+  }
+
+  const int recvOwn = m_config.value("receiveOwnMessages").toBool() ? 1 : 0;
+  ::setsockopt(m_fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &recvOwn, sizeof(recvOwn));
+
+  const can_err_mask_t errorMask = m_config.value("errorMask").toUInt();
+  ::setsockopt(m_fd, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errorMask, sizeof(errorMask));
+
+  // Hardware timestamps where the driver has them, software ones otherwise
+  const int timestamping = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                           SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+  ::setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPING, &timestamping, sizeof(timestamping));
+
+  // Count frames the kernel dropped because we fell behind
+  const int overflow = 1;
+  ::setsockopt(m_fd, SOL_SOCKET, SO_RXQ_OVFL, &overflow, sizeof(overflow));
+
+  if (m_config.contains("receiveBufferBytes")) {
+    const int bytes = m_config.value("receiveBufferBytes").toInt();
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+  }
+
+  return applyFilters();
+}
+
+bool SocketCANTransport::applyFilters() {
+  if (m_fd < 0) {
+    return true;  // applied on open
+  }
+  // No filters: the kernel default of receiving everything
+  if (m_filters.isEmpty()) {
+    const can_filter all{0, 0};
+    return ::setsockopt(m_fd, SOL_CAN_RAW, CAN_RAW_FILTER, &all, sizeof(all)) == 0;
+  }
+  return ::setsockopt(m_fd, SOL_CAN_RAW, CAN_RAW_FILTER, m_filters.constData(),
+                      static_cast<socklen_t>(m_filters.size() * sizeof(can_filter))) == 0;
+}
+
+void SocketCANTransport::resizeBatch() {
+  m_rxBuffers.resize(m_batchSize);
+  m_rxIov.resize(m_batchSize);
+  m_rxHeaders.resize(m_batchSize);
+  m_rxControl.resize(static_cast<int>(kControlSpace) * m_batchSize);
+  m_txIov.resize(m_batchSize);
+  m_txHeaders.resize(m_batchSize);
+  for (int i = 0; i < m_batchSize; ++i) {
+    m_rxIov[i].iov_base = &m_rxBuffers[i];
+    m_rxIov[i].iov_len = sizeof(canfd_frame);
+  }
+}
+
+void SocketCANTransport::onReadable() {
+  int received = 0;
+  for (;;) {
+    for (int i = 0; i < m_batchSize; ++i) {
+      msghdr& header = m_rxHeaders[i].msg_hdr;
+      header = msghdr{};
+      header.msg_iov = &m_rxIov[i];
+      header.msg_iovlen = 1;
+      header.msg_control = m_rxControl.data() + i * kControlSpace;
+      header.msg_controllen = kControlSpace;
+    }
+
+    const int count = ::recvmmsg(m_fd, m_rxHeaders.data(), m_batchSize, MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        emit errorOccurred(QString("SocketCAN: recvmmsg failed: %1").arg(strerror(errno)));
+      }
+      break;
+    }
+    m_receiveCalls.fetch_add(1, std::memory_order_relaxed);
+
+    // Software timestamps are CLOCK_REALTIME; one offset per batch is plenty
+    const qint64 realtimeToMonotonic = clockNs(CLOCK_MONOTONIC) - clockNs(CLOCK_REALTIME);
+    for (int i = 0; i < count; ++i) {
+      const msghdr& header = m_rxHeaders[i].msg_hdr;
+      const canfd_frame& raw = m_rxBuffers[i];
+      const unsigned int size = m_rxHeaders[i].msg_len;
+      if (size != CAN_MTU && size != CANFD_MTU) {
+        continue;
+      }
+
+      Frame frame;
+      frame.frame = raw;
+      frame.fd = size == CANFD_MTU;
+      frame.timestampNs = 0;
+      frame.hardwareTimestampNs = 0;
+      for (cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&header), cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+          continue;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+          scm_timestamping stamps;
+          memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+          if (stamps.ts[0].tv_sec != 0 || stamps.ts[0].tv_nsec != 0) {
+            frame.timestampNs = toNs(stamps.ts[0]) + realtimeToMonotonic;
+          }
+          frame.hardwareTimestampNs = toNs(stamps.ts[2]);
+        } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+          quint32 dropped = 0;
+          memcpy(&dropped, CMSG_DATA(cmsg), sizeof(dropped));
+          // A running total kept by the socket
+          m_kernelDropped.store(dropped, std::memory_order_relaxed);
+        }
+      }
+      if (frame.timestampNs == 0) {
+        frame.timestampNs = clockNs(CLOCK_MONOTONIC);
+      }
+
+      if (raw.can_id & CAN_ERR_FLAG) {
+        m_errorFrames.fetch_add(1, std::memory_order_relaxed);
+        can_frame error{};
+        memcpy(&error, &raw, CAN_MTU);
+        const QString description = describeErrorFrame(error);
+        Logger::instance().warning(
+            QString("SocketCAN: %1 bus error: %2").arg(m_interfaceName, description));
+        emit errorOccurred(description);
+        continue;
+      }
+
+      m_rxQueue.append(frame);
+      ++received;
+    }
+
+    if (count < m_batchSize) {
+      break;  // drained
+    }
+  }
+
+  if (m_capture && received > 0) {
+    captureFrames(received);
+  }
+
+  // Bound the queue by dropping the oldest frames
+  const int queued = m_rxQueue.size() - m_rxHead;
+  if (queued > m_rxQueueFrames) {
+    const int drop = queued - m_rxQueueFrames;
+    consumeFrames(drop);
+    m_queueDropped.fetch_add(static_cast<quint64>(drop), std::memory_order_relaxed);
+  }
+
+  if (received > 0) {
+    m_framesReceived.fetch_add(static_cast<quint64>(received), std::memory_order_relaxed);
+    emit framesReceived(received);
+    emit dataReceived();
+  }
+}
+
+int SocketCANTransport::readFrames(Frame* frames, int maxFrames) {
+  Q_ASSERT(onReadThread());
+  const int count = qMin(maxFrames, m_rxQueue.size() - m_rxHead);
+  if (count <= 0) {
+    return 0;
+  }
+  memcpy(frames, m_rxQueue.constData() + m_rxHead, sizeof(Frame) * count);
+  consumeFrames(count);
+  return count;
+}
+
+void SocketCANTransport::consumeFrames(int count) {
+  m_rxHead += count;
+  if (m_rxHead == m_rxQueue.size()) {
+    m_rxQueue.resize(0);  // keeps the capacity
+    m_rxHead = 0;
+  } else if (m_rxHead > m_rxQueue.size() / 2) {
+    m_rxQueue.remove(0, m_rxHead);
+    m_rxHead = 0;
+  }
+}
+
+int SocketCANTransport::framesAvailable() const {
+  Q_ASSERT(onReadThread());
+  return m_rxQueue.size() - m_rxHead;
+}
+
+int SocketCANTransport::writeFrames(const Frame* frames, int count) {
+  if (!isOpen()) {
+    return -1;
+  }
+
+  int sent = 0;
+  if (m_txQueue.isEmpty()) {
+    sent = sendBatch(frames, count);
+  }
+
+  // Keep order: once anything is queued, later frames queue behind it
+  int accepted = sent;
+  for (int i = sent; i < count; ++i) {
+    if (m_txQueue.size() >= kMaxTxQueueFrames) {
+      m_stats.transmitDropped += static_cast<quint64>(count - i);
+      break;
+    }
+    m_txQueue.append(frames[i]);
+    ++accepted;
+  }
+  if (!m_txQueue.isEmpty() && m_writeNotifier) {
+    m_writeNotifier->setEnabled(true);
+  }
+  return accepted;
+}
+
+int SocketCANTransport::sendBatch(const Frame* frames, int count) {
+  int sent = 0;
+  QVector<iovec>& iov = m_txIov;
+  QVector<mmsghdr>& headers = m_txHeaders;
+  while (sent < count) {
+    const int batch = qMin(count - sent, m_batchSize);
+    int usable = 0;
+    for (int i = 0; i < batch; ++i) {
+      const Frame& frame = frames[sent + i];
+      if (frame.fd && !m_fdFrames) {
+        break;  // the socket would reject it; stop so order is kept
+      }
+      iov[i].iov_base = const_cast<canfd_frame*>(&frame.frame);
+      iov[i].iov_len = frame.fd ? CANFD_MTU : CAN_MTU;
+      headers[i] = mmsghdr{};
+      headers[i].msg_hdr.msg_iov = &iov[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+      ++usable;
+    }
+    if (usable == 0) {
+      ++m_stats.transmitDropped;
+      ++sent;  // an FD frame on a classic socket can never be sent
+      continue;
+    }
+
+    const int result = ::sendmmsg(m_fd, headers.data(), usable, MSG_DONTWAIT);
+    ++m_stats.sendCalls;
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+        emit errorOccurred(QString("SocketCAN: sendmmsg failed: %1").arg(strerror(errno)));
+      }
+      break;
+    }
+    sent += result;
+    m_stats.framesSent += static_cast<quint64>(result);
+    if (result < usable) {
+      break;  // the interface's transmit queue is full
+    }
+  }
+  return sent;
+}
+
+void SocketCANTransport::onWritable() {
+  const int sent = sendBatch(m_txQueue.constData(), m_txQueue.size());
+  m_txQueue.remove(0, sent);
+  if (m_txQueue.isEmpty()) {
+    m_writeNotifier->setEnabled(false);
+  }
+}
+
+qint64 SocketCANTransport::write(const QByteArray& data) {
+  if (!isOpen()) {
+    return -1;
+  }
+
+  const int mtu = m_fdFrames ? CANFD_MTU : CAN_MTU;
+  const int count = data.size() / mtu;
+  QVector<Frame> frames(count);
+  for (int i = 0; i < count; ++i) {
+    Frame& frame = frames[i];
+    memset(&frame, 0, sizeof(frame));
+    memcpy(&frame.frame, data.constData() + i * mtu, mtu);
+    frame.fd = m_fdFrames;
+  }
+  const int accepted = writeFrames(frames.constData(), count);
+  return accepted < 0 ? -1 : static_cast<qint64>(accepted) * mtu;
+}
+
+QByteArray SocketCANTransport::read(qint64 maxSize) {
+  if (!isOpen()) {
+    return QByteArray();
+  }
+
+  const int mtu = m_fdFrames ? CANFD_MTU : CAN_MTU;
+  int count = framesAvailable();
+  if (maxSize > 0) {
+    count = qMin(count, static_cast<int>(maxSize / mtu));
+  }
+  QByteArray data(count * mtu, Qt::Uninitialized);
+  for (int i = 0; i < count; ++i) {
+    memcpy(data.data() + i * mtu, &m_rxQueue[m_rxHead + i].frame, mtu);
+  }
+  consumeFrames(count);
+  return data;
+}
+
+qint64 SocketCANTransport::readInto(std::span<char> buffer) {
+  if (!isOpen()) {
+    return -1;
+  }
+
+  // Whole records only
+  const int mtu = m_fdFrames ? CANFD_MTU : CAN_MTU;
+  const int count = static_cast<int>(
+      qMin<size_t>(static_cast<size_t>(framesAvailable()), buffer.size() / mtu));
+  for (int i = 0; i < count; ++i) {
+    memcpy(buffer.data() + i * mtu, &m_rxQueue[m_rxHead + i].frame, mtu);
+  }
+  consumeFrames(count);
+  return static_cast<qint64>(count) * mtu;
+}
+
+qint64 SocketCANTransport::bytesAvailable() const {
+  if (!isOpen()) {
+    return 0;
+  }
+  return static_cast<qint64>(framesAvailable()) * (m_fdFrames ? CANFD_MTU : CAN_MTU);
+}
+
+void SocketCANTransport::flush() {
+  if (!isOpen() || m_txQueue.isEmpty()) {
+    return;
+  }
+  onWritable();
+}
+
+bool SocketCANTransport::configure(const QString& key, const QVariant& value) {
+  if (key == "filters") {
+    QVector<can_filter> filters;
+    QString error;
+    if (!parseFilters(value, &filters, &error)) {
+      Logger::instance().warning(QString("SocketCAN: %1").arg(error));
+      return false;
+    }
+    m_config[key] = value;
+    m_filters = filters;
+    return applyFilters();
+  }
+
+  m_config[key] = value;
+
+  if (key == "interface") {
+    m_interfaceName = value.toString();
+  } else if (key == "fd") {
+    m_fdFrames = value.toBool();
+  } else if (key == "batchSize") {
+    m_batchSize = qBound(1, value.toInt(), 1024);
+    m_config[key] = m_batchSize;
+    // The reactor thread receives into these buffers
+    const bool watched = m_reactor && m_fd >= 0;
+    if (watched) {
+      m_reactor->remove(m_fd);
+    }
+    resizeBatch();
+    if (watched) {
+      watchReads();
+    }
+    return true;
+  } else if (key == "rxQueueFrames") {
+    m_rxQueueFrames = qMax(1, value.toInt());
+    return true;
+  }
+
+  // Socket options take effect at once on an open socket
+  if (m_fd >= 0 && (key == "fd" || key == "errorMask" || key == "receiveOwnMessages" ||
+                    key == "receiveBufferBytes")) {
+    return applySocketOptions();
+  }
+  return true;
+}
+
+QVariant SocketCANTransport::getConfiguration(const QString& key) const {
+  return m_config.value(key);
+}
+
+bool SocketCANTransport::setReactor(IoReactor* reactor) {
+  if (reactor == m_reactor) {
+    return true;
+  }
+  if (m_reactor && m_fd >= 0) {
+    m_reactor->remove(m_fd);
+  }
+  m_reactor = reactor;
+  if (m_fd >= 0) {
+    watchReads();
+  }
+  return m_reactor == reactor;
+}
+
+bool SocketCANTransport::setCapture(crankshaft::diagnostics::CaptureWriter* writer,
+                                    const QString& streamName) {
+  int stream = -1;
+  if (writer) {
+    stream = writer->addStream(crankshaft::diagnostics::capture::StreamKind::CanFrames,
+                               streamName.isEmpty() ? getName() : streamName,
+                               {m_fdFrames ? 1 : 0, 0, 0, 0});
+    if (stream < 0) {
+      return false;
+    }
+  }
+
+  // Take the socket off the reactor so no drain is using the old writer
+  const bool watched = m_reactor && m_fd >= 0;
+  if (watched) {
+    m_reactor->remove(m_fd);
+  }
+  m_capture = writer;
+  m_captureStream = stream;
+  if (watched) {
+    watchReads();
+  }
+  return true;
+}
+
+void SocketCANTransport::captureFrames(int count) {
+  namespace capture = crankshaft::diagnostics::capture;
+
+  // One record per drained batch: the newest count frames of the queue
+  m_captureFrames.resize(count);
+  const Frame* frames = m_rxQueue.constData() + m_rxQueue.size() - count;
+  for (int i = 0; i < count; ++i) {
+    const canfd_frame& raw = frames[i].frame;
+    capture::CanFrameRecord& record = m_captureFrames[i];
+    record = capture::CanFrameRecord{};
+    record.timestampNs = static_cast<uint64_t>(frames[i].timestampNs);
+    const bool extended = raw.can_id & CAN_EFF_FLAG;
+    const bool rtr = raw.can_id & CAN_RTR_FLAG;
+    record.id = raw.can_id & (extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+    record.length = rtr ? 0 : raw.len;
+    record.flags = (extended ? capture::kCanExtended : 0) | (rtr ? capture::kCanRtr : 0) |
+                   (frames[i].fd ? capture::kCanFd : 0) |
+                   (frames[i].fd && (raw.flags & CANFD_BRS) ? capture::kCanBitRateSwitch : 0);
+    memcpy(record.data, raw.data, record.length);
+  }
+  m_capture->append(m_captureStream,
+                    {reinterpret_cast<const char*>(m_captureFrames.constData()),
+                     static_cast<size_t>(count) * sizeof(capture::CanFrameRecord)});
+}
+
+void SocketCANTransport::watchReads() {
+  if (m_reactor && !m_reactor->add(m_fd, this)) {
+    Logger::instance().warning(
+        QString("SocketCAN: %1 stays on its own thread, the reactor refused it")
+            .arg(m_interfaceName));
+    m_reactor = nullptr;
+  }
+  m_readNotifier->setEnabled(m_reactor == nullptr);
+}
+
+void SocketCANTransport::onReactorReadable() {
+  onReadable();
+}
+
+SocketCANTransport::Stats SocketCANTransport::stats() const {
+  Stats stats = m_stats;
+  stats.framesReceived = m_framesReceived.load(std::memory_order_relaxed);
+  stats.receiveCalls = m_receiveCalls.load(std::memory_order_relaxed);
+  stats.queueDropped = m_queueDropped.load(std::memory_order_relaxed);
+  stats.kernelDropped = m_kernelDropped.load(std::memory_order_relaxed);
+  stats.errorFrames = m_errorFrames.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool SocketCANTransport::onReadThread() const {
+  // The queue has a single owner: the reactor thread while one is set
+  return !m_reactor || m_reactor->isReactorThread();
+}
+
+bool SocketCANTransport::parseFilters(const QVariant& value, QVector<can_filter>* filters,
+                                      QString* error) {
+  filters->clear();
+  const QVariantList entries = value.toList();
+  for (const QVariant& entry : entries) {
+    quint32 id = 0;
+    quint32 mask = CAN_SFF_MASK;
+    bool extended = false;
+    bool invert = false;
+
+    if (entry.typeId() == QMetaType::QVariantMap) {
+      const QVariantMap map = entry.toMap();
+      bool ok = true;
+      id = map.value("id").toString().toUInt(&ok, 0);
+      if (ok && map.contains("mask")) {
+        mask = map.value("mask").toString().toUInt(&ok, 0);
+      }
+      extended = map.value("extended", id > CAN_SFF_MASK).toBool();
+      invert = map.value("invert").toBool();
+      if (!ok) {
+        if (error) *error = QString("Malformed CAN filter entry");
+        return false;
+      }
+      if (extended && !map.contains("mask")) {
+        mask = CAN_EFF_MASK;
+      }
+    } else {
+      // candump syntax: <id>:<mask> matches, <id>~<mask> matches everything else
+      const QString text = entry.toString();
+      int separator = text.indexOf(':');
+      if (separator < 0) {
+        separator = text.indexOf('~');
+        invert = separator >= 0;
+      }
+      if (separator < 0 || !parseHex(text.left(separator), &id) ||
+          !parseHex(text.mid(separator + 1), &mask)) {
+        if (error) *error = QString("Malformed CAN filter \"%1\"").arg(text);
+        return false;
+      }
+      extended = text.left(separator).trimmed().size() > 3 || id > CAN_SFF_MASK;
+    }
+
+    can_filter filter{};
+    // Match the frame format too, so an 11-bit filter never matches a 29-bit ID
+    const quint32 idMask = extended ? CAN_EFF_MASK : CAN_SFF_MASK;
+    filter.can_id = (id & idMask) | (extended ? CAN_EFF_FLAG : 0);
+    filter.can_mask = (mask & idMask) | CAN_EFF_FLAG;
+    if (invert) {
+      filter.can_id |= CAN_INV_FILTER;
+    }
+    filters->append(filter);
+  }
+  return true;
+}
+
+QString SocketCANTransport::describeErrorFrame(const can_frame& frame) {
+  QStringList parts;
+  const canid_t error = frame.can_id & CAN_ERR_MASK;
+  if (error & CAN_ERR_TX_TIMEOUT) parts << "TX timeout";
+  if (error & CAN_ERR_LOSTARB) parts << "lost arbitration";
+  if (error & CAN_ERR_CRTL) {
+    const quint8 status = frame.data[1];
+    if (status & (CAN_ERR_CRTL_RX_OVERFLOW | CAN_ERR_CRTL_TX_OVERFLOW)) parts << "buffer overflow";
+    if (status & (CAN_ERR_CRTL_RX_WARNING | CAN_ERR_CRTL_TX_WARNING)) parts << "error warning";
+    if (status & (CAN_ERR_CRTL_RX_PASSIVE | CAN_ERR_CRTL_TX_PASSIVE)) parts << "error passive";
+    if (status == 0) parts << "controller problem";
+  }
+  if (error & CAN_ERR_PROT) parts << "protocol violation";
+  if (error & CAN_ERR_TRX) parts << "transceiver";
+  if (error & CAN_ERR_ACK) parts << "no ACK";
+  if (error & CAN_ERR_BUSOFF) parts << "bus-off";
+  if (error & CAN_ERR_BUSERROR) parts << "bus error";
+  if (error & CAN_ERR_RESTARTED) parts << "controller restarted";
+  return parts.isEmpty() ? QString("unknown error") : parts.join(", ");
+}
@@ -0,0 +1,211 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <linux/can.h>
+#include <sys/socket.h>
+
+#include <QVector>
+#include <atomic>
+
+#include "../../services/diagnostics/CaptureFormat.h"
+#include "IoReactor.h"
+#include "Transport.h"
+
+class QSocketNotifier;
+
+/**
+ * @brief Native Linux CAN transport over a raw AF_CAN socket (SocketCAN)
+ *
+ * Frames are moved in batches: every readable notification drains the
+ * socket with recvmmsg() into a receive queue, and writeFrames() hands a
+ * whole batch to sendmmsg(). Filtering happens in the kernel
+ * (CAN_RAW_FILTER), so frames nobody asked for never wake the process.
+ * Each received frame carries the kernel's receive timestamp, converted to
+ * CLOCK_MONOTONIC, and the controller's hardware timestamp when the driver
+ * provides one (SO_TIMESTAMPING).
+ *
+ * The frame API (readFrames/writeFrames) is the fast path. The byte-level
+ * Transport API carries raw struct can_frame (CAN_MTU) records, or struct
+ * canfd_frame (CANFD_MTU) records when "fd" is enabled.
+ *
+ * With setReactor() the socket is drained on an IoReactor thread, and
+ * framesReceived()/dataReceived() are emitted there. The receive queue then
+ * belongs to that thread: it is read from those signals (connected
+ * directly), as CANDevice does. Writes stay on the transport's thread;
+ * stats() may be called from either. With setCapture() each drained batch is also recorded
+ * as one capture record of CanFrameRecords (params: 1 for CAN FD).
+ *
+ * Configuration keys (from the device's profile settings):
+ *   - "interface": Network interface (e.g., "can0", "vcan0")
+ *   - "fd": Enable CAN FD frames (bool, default false)
+ *   - "filters": List of "id:mask" or "id~mask" (inverted) hex strings, or
+ *                maps {id, mask, extended, invert}; empty receives all
+ *   - "errorMask": CAN_ERR_* classes reported through errorOccurred()
+ *   - "receiveOwnMessages": Also receive frames sent on this socket (bool)
+ *   - "batchSize": Frames per recvmmsg/sendmmsg call (default 64)
+ *   - "rxQueueFrames": Receive queue bound; oldest frames drop first (default 4096)
+ *   - "receiveBufferBytes": SO_RCVBUF (default: kernel default)
+ *
+ * Example:
+ *   auto can0 = new SocketCANTransport("can0");
+ *   can0->configure("filters", QStringList{"0C9:7FF", "3E9:7FF"});
+ *   auto can = new CANDevice(can0);
+ */
+class SocketCANTransport : public Transport, private IoReactor::Handler {
+  Q_OBJECT
+
+ public:
+  struct Frame {
+    canfd_frame frame;           // kernel layout; frame.len is the payload length
+    bool fd;                     // a CAN FD frame
+    qint64 timestampNs;          // kernel receive time, CLOCK_MONOTONIC
+    qint64 hardwareTimestampNs;  // controller clock, 0 if the driver has none
+  };
+
+  struct Stats {
+    quint64 framesReceived{0};
+    quint64 framesSent{0};
+    quint64 receiveCalls{0};     // recvmmsg() calls that returned frames
+    quint64 sendCalls{0};        // sendmmsg() calls
+    quint64 queueDropped{0};     // receive queue overflow
+    quint64 kernelDropped{0};    // socket buffer overflow (SO_RXQ_OVFL)
+    quint64 transmitDropped{0};  // transmit queue full
+    quint64 errorFrames{0};
+  };
+
+  explicit SocketCANTransport(const QString& interfaceName, QObject* parent = nullptr);
+  ~SocketCANTransport() override;
+
+  TransportType getType() const override {
+    return TransportType::CAN;
+  }
+  QString getName() const override;
+
+  bool open() override;
+  void close() override;
+  bool isOpen() const override;
+  TransportState getState() const override;
+
+  qint64 write(const QByteArray& data) override;
+  QByteArray read(qint64 maxSize = 0) override;
+  qint64 readInto(std::span<char> buffer) override;
+  qint64 bytesAvailable() const override;
+  void flush() override;
+
+  bool configure(const QString& key, const QVariant& value) override;
+  QVariant getConfiguration(const QString& key) const override;
+  bool setReactor(IoReactor* reactor) override;
+  bool setCapture(crankshaft::diagnostics::CaptureWriter* writer,
+                  const QString& streamName = QString()) override;
+
+  /**
+   * @brief Take up to maxFrames received frames, oldest first
+   * @return Number of frames copied to frames
+   */
+  int readFrames(Frame* frames, int maxFrames);
+
+  /**
+   * @brief Frames waiting in the receive queue
+   */
+  int framesAvailable() const;
+
+  /**
+   * @brief Send frames, batchSize per sendmmsg() call
+   *
+   * Frames the socket cannot take right now (ENOBUFS/EAGAIN) are queued and
+   * sent when it becomes writable.
+   * @return Number of frames sent or queued, -1 if not open
+   */
+  int writeFrames(const Frame* frames, int count);
+
+  Stats stats() const;
+
+  /**
+   * @brief Parse a "filters" setting into kernel filters
+   * @return false with error set on a malformed entry
+   */
+  static bool parseFilters(const QVariant& value, QVector<can_filter>* filters,
+                           QString* error = nullptr);
+
+  /**
+   * @brief Describe an error frame's CAN_ERR_* classes
+   */
+  static QString describeErrorFrame(const can_frame& frame);
+
+ signals:
+  /**
+   * @brief Emitted once per drained batch
+   * @param count Frames added to the receive queue
+   */
+  void framesReceived(int count);
+
+ private slots:
+  void onReadable();
+  void onWritable();
+
+ private:
+  void onReactorReadable() override;
+  void watchReads();
+  bool applySocketOptions();
+  bool applyFilters();
+  void resizeBatch();
+  int sendBatch(const Frame* frames, int count);
+  void consumeFrames(int count);
+  void captureFrames(int count);
+  void setState(TransportState state);
+  bool onReadThread() const;
+
+  QString m_interfaceName;
+  TransportState m_state;
+  QVariantMap m_config;
+  int m_fd;
+  QSocketNotifier* m_readNotifier;
+  QSocketNotifier* m_writeNotifier;
+  IoReactor* m_reactor;
+  crankshaft::diagnostics::CaptureWriter* m_capture;  // records each drained batch when set
+  int m_captureStream;
+  QVector<crankshaft::diagnostics::capture::CanFrameRecord> m_captureFrames;
+
+  bool m_fdFrames;
+  int m_batchSize;
+  int m_rxQueueFrames;
+  QVector<can_filter> m_filters;
+
+  // recvmmsg() batch buffers, reused for every call
+  QVector<canfd_frame> m_rxBuffers;
+  QVector<iovec> m_rxIov;
+  QVector<mmsghdr> m_rxHeaders;
+  QByteArray m_rxControl;
+  QVector<iovec> m_txIov;
+  QVector<mmsghdr> m_txHeaders;
+
+  QVector<Frame> m_rxQueue;
+  int m_rxHead;
+  QVector<Frame> m_txQueue;
+  Stats m_stats;  // send side; the receive side's counters follow
+
+  // Bumped by whichever thread drains the socket, read by stats()
+  std::atomic<quint64> m_framesReceived;
+  std::atomic<quint64> m_receiveCalls;
+  std::atomic<quint64> m_queueDropped;
+  std::atomic<quint64> m_kernelDropped;
+  std::atomic<quint64> m_errorFrames;
+};
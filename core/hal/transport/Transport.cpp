@@ -19,4 +19,28 @@
 
 #include "Transport.h"
 
+#include <cstring>
+
 Transport::Transport(QObject* parent) : QObject(parent) {}
+
+qint64 Transport::readInto(std::span<char> buffer) {
+  if (!isOpen()) {
+    return -1;
+  }
+  if (buffer.empty()) {
+    return 0;
+  }
+  const QByteArray data = read(static_cast<qint64>(buffer.size()));
+  memcpy(buffer.data(), data.constData(), data.size());
+  return data.size();
+}
+
+bool Transport::setReactor(IoReactor* reactor) {
+  return reactor == nullptr;
+}
+
+bool Transport::setCapture(crankshaft::diagnostics::CaptureWriter* writer,
+                           const QString& streamName) {
+  Q_UNUSED(streamName);
+  return writer == nullptr;
+}
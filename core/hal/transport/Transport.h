@@ -23,6 +23,15 @@
 #include <QObject>
 #include <QString>
 #include <QVariantMap>
+#include <span>
+
+class IoReactor;
+
+namespace crankshaft {
+namespace diagnostics {
+class CaptureWriter;
+}
+}  // namespace crankshaft
 
 /**
  * @brief Transport layer types
@@ -118,6 +127,16 @@ class Transport : public QObject {
    */
   virtual QByteArray read(qint64 maxSize = 0) = 0;
 
+  /**
+   * @brief Read data into a caller-owned buffer
+   *
+   * The allocation-free form of read(). Transports with their own receive
+   * buffer copy straight out of it; the default goes through read().
+   * @param buffer Destination; at most buffer.size() bytes are taken
+   * @return Bytes copied, 0 if nothing is waiting, -1 if not open
+   */
+  virtual qint64 readInto(std::span<char> buffer);
+
   /**
    * @brief Check if data is available to read
    * @return Number of bytes available
@@ -144,6 +163,33 @@ class Transport : public QObject {
    */
   virtual QVariant getConfiguration(const QString& key) const = 0;
 
+  /**
+   * @brief Move the receive side onto an I/O reactor thread
+   *
+   * While set, the reactor watches the transport's descriptor instead of a
+   * QSocketNotifier: input is drained on the reactor thread and
+   * dataReceived() is emitted there, so readers connected with
+   * Qt::DirectConnection parse there too. Writes, configuration and the
+   * state signals stay on the transport's own thread. Close the transport or
+   * detach it before destroying such a reader.
+   * @param reactor Reactor to use, nullptr for the transport's own thread
+   * @return false if this transport has nothing a reactor can watch
+   */
+  virtual bool setReactor(IoReactor* reactor);
+
+  /**
+   * @brief Record everything received into a capture
+   *
+   * Adds a stream to writer and appends each read to it as it comes off
+   * the descriptor, on whichever thread drains it; ReplayTransport plays
+   * the stream back. Detach (nullptr) or close the transport before
+   * destroying the writer.
+   * @param streamName Stream to record into; the transport's name if empty
+   * @return false if this transport cannot record
+   */
+  virtual bool setCapture(crankshaft::diagnostics::CaptureWriter* writer,
+                          const QString& streamName = QString());
+
  signals:
   /**
    * @brief Emitted when data is received
@@ -19,8 +19,71 @@
 
 #include "UARTTransport.h"
 
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+
+#include "../../services/diagnostics/CaptureWriter.h"
+#include "../../services/logging/Logger.h"
+
+namespace {
+
+constexpr int kDefaultRxBufferBytes = 64 * 1024;
+constexpr int kDefaultReadBatchIntervalMs = 5;
+constexpr int kDefaultWriteCoalesceBytes = 4096;
+constexpr int kMaxTxBufferBytes = 256 * 1024;
+constexpr int kFlushTimeoutMs = 500;
+
+int roundUpToPowerOfTwo(int value) {
+  int power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+
+// FTDI-style USB serial adapters hold received bytes for this many ms
+void setUsbLatencyTimer(const QString& portName, int milliseconds) {
+  const QString device = QFileInfo(QFileInfo(portName).canonicalFilePath()).fileName();
+  QFile timer(QString("/sys/bus/usb-serial/devices/%1/latency_timer").arg(device));
+  if (timer.exists() && timer.open(QIODevice::WriteOnly)) {
+    timer.write(QByteArray::number(milliseconds));
+  }
+}
+
+}  // namespace
+
 UARTTransport::UARTTransport(const QString& portName, QObject* parent)
-    : Transport(parent), m_portName(portName), m_state(TransportState::DISCONNECTED) {
+    : Transport(parent),
+      m_portName(portName),
+      m_state(TransportState::DISCONNECTED),
+      m_fd(-1),
+      m_readNotifier(nullptr),
+      m_writeNotifier(nullptr),
+      m_readBatchTimer(new QTimer(this)),
+      m_flushTimer(new QTimer(this)),
+      m_reactor(nullptr),
+      m_readRestNs(0),
+      m_capture(nullptr),
+      m_captureStream(-1),
+      m_rxHead(0),
+      m_rxTail(0),
+      m_txOffset(0),
+      m_bytesRead(0),
+      m_readWakeups(0),
+      m_overflowBytes(0) {
   // Set default configuration
   m_config["port"] = portName;
   m_config["baudRate"] = 9600;
@@ -28,6 +91,17 @@ UARTTransport::UARTTransport(const QString& portName, QObject* parent)
   m_config["parity"] = "none";
   m_config["stopBits"] = 1;
   m_config["flowControl"] = "none";
+  m_config["lowLatency"] = false;
+  m_config["readBatchIntervalMs"] = kDefaultReadBatchIntervalMs;
+  m_config["rxBufferBytes"] = kDefaultRxBufferBytes;
+  m_config["writeCoalesceBytes"] = kDefaultWriteCoalesceBytes;
+
+  resizeRing(kDefaultRxBufferBytes);
+  updateReadRest();
+  m_readBatchTimer->setSingleShot(true);
+  connect(m_readBatchTimer, &QTimer::timeout, this, &UARTTransport::onReadBatchTimeout);
+  m_flushTimer->setSingleShot(true);
+  connect(m_flushTimer, &QTimer::timeout, this, &UARTTransport::flushPending);
 }
 
 UARTTransport::~UARTTransport() {
@@ -43,14 +117,32 @@ bool UARTTransport::open() {
     return true;
   }
 
-  m_state = TransportState::CONNECTING;
-  emit stateChanged(m_state);
+  setState(TransportState::CONNECTING);
 
-  // TODO: Implement actual serial port opening
-  // This would use platform-specific APIs or Qt SerialPort
+  m_fd = ::open(m_portName.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (m_fd < 0) {
+    fail(QString("UART: cannot open %1: %2").arg(m_portName, strerror(errno)));
+    return false;
+  }
+  if (!applyTermios()) {
+    fail(QString("UART: cannot configure %1: %2").arg(m_portName, strerror(errno)));
+    return false;
+  }
+  applyLowLatency();
+  tcflush(m_fd, TCIOFLUSH);  // nothing from before we were listening
 
-  m_state = TransportState::CONNECTED;
-  emit stateChanged(m_state);
+  m_readNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+  connect(m_readNotifier, &QSocketNotifier::activated, this, &UARTTransport::onReadable);
+  m_writeNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Write, this);
+  m_writeNotifier->setEnabled(false);
+  connect(m_writeNotifier, &QSocketNotifier::activated, this, &UARTTransport::onWritable);
+  watchReads();
+
+  Logger::instance().info(QString("UART: %1 open at %2 baud%3")
+                              .arg(m_portName)
+                              .arg(m_config.value("baudRate").toInt())
+                              .arg(m_config.value("lowLatency").toBool() ? ", low latency" : ""));
+  setState(TransportState::CONNECTED);
   emit connected();
   return true;
 }
@@ -60,11 +152,29 @@ void UARTTransport::close() {
     return;
   }
 
-  // TODO: Implement actual serial port closing
+  // First, so no reactor call is left touching the ring or the descriptor
+  if (m_reactor && m_fd >= 0) {
+    m_reactor->remove(m_fd);
+  }
+  m_readBatchTimer->stop();
+  m_flushTimer->stop();
+  delete m_readNotifier;
+  m_readNotifier = nullptr;
+  delete m_writeNotifier;
+  m_writeNotifier = nullptr;
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  m_rxHead = m_rxTail = 0;
+  m_txBuffer.clear();
+  m_txOffset = 0;
 
-  m_state = TransportState::DISCONNECTED;
-  emit stateChanged(m_state);
-  emit disconnected();
+  const bool wasConnected = m_state == TransportState::CONNECTED;
+  setState(TransportState::DISCONNECTED);
+  if (wasConnected) {
+    emit disconnected();
+  }
 }
 
 bool UARTTransport::isOpen() const {
@@ -75,13 +185,393 @@ TransportState UARTTransport::getState() const {
   return m_state;
 }
 
+void UARTTransport::setState(TransportState state) {
+  if (m_state != state) {
+    m_state = state;
+    emit stateChanged(m_state);
+  }
+}
+
+void UARTTransport::fail(const QString& error) {
+  Logger::instance().warning(error);
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  setState(TransportState::ERROR);
+  emit errorOccurred(error);
+}
+
+bool UARTTransport::applyTermios() {
+  if (m_fd < 0) {
+    return true;  // applied on open
+  }
+
+  termios tio{};
+  if (tcgetattr(m_fd, &tio) < 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+
+  tio.c_cflag &= ~CSIZE;
+  switch (m_config.value("dataBits").toInt()) {
+    case 5:
+      tio.c_cflag |= CS5;
+      break;
+    case 6:
+      tio.c_cflag |= CS6;
+      break;
+    case 7:
+      tio.c_cflag |= CS7;
+      break;
+    default:
+      tio.c_cflag |= CS8;
+      break;
+  }
+
+  const QString parity = m_config.value("parity").toString();
+  tio.c_cflag &= ~(PARENB | PARODD);
+  if (parity == "even") {
+    tio.c_cflag |= PARENB;
+  } else if (parity == "odd") {
+    tio.c_cflag |= PARENB | PARODD;
+  }
+
+  if (m_config.value("stopBits").toInt() == 2) {
+    tio.c_cflag |= CSTOPB;
+  } else {
+    tio.c_cflag &= ~CSTOPB;
+  }
+
+  const QString flowControl = m_config.value("flowControl").toString();
+  tio.c_cflag &= ~CRTSCTS;
+  tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+  if (flowControl == "hardware") {
+    tio.c_cflag |= CRTSCTS;
+  } else if (flowControl == "software") {
+    tio.c_iflag |= IXON | IXOFF;
+  }
+
+  const speed_t speed = speedFor(m_config.value("baudRate").toInt());
+  if (speed == 0) {
+    errno = EINVAL;
+    return false;
+  }
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+
+  // Readable as soon as one byte is in; batching is done by resting the
+  // notifier, which never leaves a short tail stranded in the kernel
+  tio.c_cc[VMIN] = 1;
+  tio.c_cc[VTIME] = 0;
+
+  return tcsetattr(m_fd, TCSANOW, &tio) == 0;
+}
+
+void UARTTransport::applyLowLatency() {
+  if (m_fd < 0) {
+    return;
+  }
+  const bool lowLatency = m_config.value("lowLatency").toBool();
+
+  // Best effort: ptys and some USB drivers have no serial_struct
+  serial_struct serial{};
+  if (ioctl(m_fd, TIOCGSERIAL, &serial) == 0) {
+    if (lowLatency) {
+      serial.flags |= ASYNC_LOW_LATENCY;
+    } else {
+      serial.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    ioctl(m_fd, TIOCSSERIAL, &serial);
+  }
+  setUsbLatencyTimer(m_portName, lowLatency ? 1 : 16);
+}
+
+quint32 UARTTransport::speedFor(qint32 baudRate) {
+  switch (baudRate) {
+    case 1200:
+      return B1200;
+    case 2400:
+      return B2400;
+    case 4800:
+      return B4800;
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    case 38400:
+      return B38400;
+    case 57600:
+      return B57600;
+    case 115200:
+      return B115200;
+    case 230400:
+      return B230400;
+    case 460800:
+      return B460800;
+    case 500000:
+      return B500000;
+    case 576000:
+      return B576000;
+    case 921600:
+      return B921600;
+    case 1000000:
+      return B1000000;
+    case 1500000:
+      return B1500000;
+    case 2000000:
+      return B2000000;
+    case 3000000:
+      return B3000000;
+    case 4000000:
+      return B4000000;
+    default:
+      return 0;
+  }
+}
+
+void UARTTransport::resizeRing(int capacity) {
+  const int size = roundUpToPowerOfTwo(qMax(256, capacity));
+  if (size == m_rxRing.size()) {
+    return;
+  }
+  // Keep the newest bytes that fit
+  QVector<char> ring(size);
+  const quint64 keep = qMin<quint64>(m_rxTail - m_rxHead, static_cast<quint64>(size));
+  const quint64 oldMask = static_cast<quint64>(m_rxRing.size()) - 1;
+  for (quint64 i = 0; i < keep; ++i) {
+    ring[static_cast<int>(i)] = m_rxRing[static_cast<int>((m_rxTail - keep + i) & oldMask)];
+  }
+  m_rxRing = ring;
+  m_rxHead = 0;
+  m_rxTail = keep;
+}
+
+qint64 UARTTransport::drainPort(bool* hungUp) {
+  *hungUp = false;
+  const quint64 capacity = static_cast<quint64>(m_rxRing.size());
+  const quint64 mask = capacity - 1;
+  qint64 total = 0;
+  for (;;) {
+    if (m_rxTail - m_rxHead == capacity) {
+      // Full: make room by dropping the oldest quarter
+      const quint64 drop = capacity / 4;
+      m_rxHead += drop;
+      m_overflowBytes.fetch_add(drop, std::memory_order_relaxed);
+    }
+
+    // The free space is at most two contiguous runs
+    const quint64 free = capacity - (m_rxTail - m_rxHead);
+    const quint64 start = m_rxTail & mask;
+    const quint64 first = qMin(free, capacity - start);
+    iovec iov[2];
+    iov[0].iov_base = m_rxRing.data() + start;
+    iov[0].iov_len = first;
+    iov[1].iov_base = m_rxRing.data();
+    iov[1].iov_len = free - first;
+
+    const ssize_t count = ::readv(m_fd, iov, free > first ? 2 : 1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EIO || errno == ENXIO) {
+        *hungUp = true;  // the device is gone
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        emit errorOccurred(QString("UART: read from %1 failed: %2").arg(m_portName,
+                                                                         strerror(errno)));
+      }
+      break;
+    }
+    if (count == 0) {
+      *hungUp = true;  // e.g. USB adapter unplugged
+      break;
+    }
+    m_rxTail += static_cast<quint64>(count);
+    total += count;
+    if (m_capture) {
+      const size_t head = qMin(static_cast<size_t>(count), static_cast<size_t>(first));
+      m_capture->append(m_captureStream, {m_rxRing.constData() + start, head},
+                        {m_rxRing.constData(), static_cast<size_t>(count) - head});
+    }
+    if (static_cast<quint64>(count) < free) {
+      break;  // short read: the kernel buffer is empty
+    }
+  }
+  if (total == 0 && !*hungUp) {
+    // A tty can report a hangup without an end-of-file read
+    pollfd pfd{m_fd, POLLIN, 0};
+    if (::poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR))) {
+      *hungUp = true;
+    }
+  }
+  m_bytesRead.fetch_add(static_cast<quint64>(total), std::memory_order_relaxed);
+  return total;
+}
+
+void UARTTransport::onHangup() {
+  if (m_state != TransportState::CONNECTED) {
+    return;  // closed meanwhile
+  }
+  const QString error = QString("UART: %1 hung up").arg(m_portName);
+  Logger::instance().warning(error);
+  close();
+  emit errorOccurred(error);
+}
+
+void UARTTransport::onReadable() {
+  bool hungUp = false;
+  const qint64 count = drainPort(&hungUp);
+  if (count > 0) {
+    m_readWakeups.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (hungUp) {
+    // Close from a queued call; close() deletes the notifier this runs under
+    m_readNotifier->setEnabled(false);
+    QMetaObject::invokeMethod(this, &UARTTransport::onHangup, Qt::QueuedConnection);
+    if (count > 0) {
+      emit dataReceived();
+    }
+    return;
+  }
+
+  // Rest the notifier so the next bytes are picked up in one batch
+  const int intervalMs = m_config.value("lowLatency").toBool()
+                             ? 0
+                             : m_config.value("readBatchIntervalMs").toInt();
+  if (intervalMs > 0 && m_readNotifier) {
+    m_readNotifier->setEnabled(false);
+    m_readBatchTimer->start(intervalMs);
+  }
+
+  if (count > 0) {
+    emit dataReceived();
+  }
+}
+
+void UARTTransport::onReactorReadable() {
+  bool hungUp = false;
+  const qint64 count = drainPort(&hungUp);
+  if (count > 0) {
+    m_readWakeups.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (hungUp) {
+    // Closing takes the reactor's lock, so it is left to the transport's thread
+    QMetaObject::invokeMethod(this, &UARTTransport::onHangup, Qt::QueuedConnection);
+  } else {
+    m_reactor->rest(m_fd, m_readRestNs.load(std::memory_order_relaxed));
+  }
+  if (count > 0) {
+    emit dataReceived();
+  }
+}
+
+void UARTTransport::onReactorHangup() {
+  QMetaObject::invokeMethod(this, &UARTTransport::onHangup, Qt::QueuedConnection);
+}
+
+void UARTTransport::onReadBatchTimeout() {
+  if (!m_readNotifier) {
+    return;
+  }
+  m_readNotifier->setEnabled(true);
+  // Whatever arrived while resting; an idle port stops here
+  bool hungUp = false;
+  const qint64 count = drainPort(&hungUp);
+  if (hungUp) {
+    // Close from a queued call; close() deletes the notifier this runs under
+    m_readNotifier->setEnabled(false);
+    QMetaObject::invokeMethod(this, &UARTTransport::onHangup, Qt::QueuedConnection);
+    if (count > 0) {
+      emit dataReceived();
+    }
+    return;
+  }
+  if (count > 0) {
+    m_readWakeups.fetch_add(1, std::memory_order_relaxed);
+    m_readNotifier->setEnabled(false);
+    m_readBatchTimer->start(m_config.value("readBatchIntervalMs").toInt());
+    emit dataReceived();
+  }
+}
+
 qint64 UARTTransport::write(const QByteArray& data) {
   if (!isOpen()) {
     return -1;
   }
+  if (data.isEmpty()) {
+    return 0;
+  }
 
-  // TODO: Implement actual serial write
-  return data.size();
+  const qint64 pending = m_txBuffer.size() - m_txOffset;
+  const qint64 accepted = qMin<qint64>(data.size(), kMaxTxBufferBytes - pending);
+  if (accepted <= 0) {
+    return 0;
+  }
+  m_txBuffer.append(data.constData(), accepted);
+
+  // Coalesce: small writes in one event-loop pass go out in one syscall
+  if (m_config.value("lowLatency").toBool() ||
+      pending + accepted >= m_config.value("writeCoalesceBytes").toInt()) {
+    writePending();
+  } else if (!m_flushTimer->isActive() && !m_writeNotifier->isEnabled()) {
+    m_flushTimer->start(0);
+  }
+  return accepted;
+}
+
+qint64 UARTTransport::writePending() {
+  m_flushTimer->stop();
+  qint64 written = 0;
+  while (m_txOffset < m_txBuffer.size()) {
+    const ssize_t count =
+        ::write(m_fd, m_txBuffer.constData() + m_txOffset, m_txBuffer.size() - m_txOffset);
+    ++m_stats.writeCalls;
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EIO || errno == ENXIO) {
+        // The device is gone: drop the queue rather than re-arm a dead descriptor
+        m_txBuffer.resize(0);
+        m_txOffset = 0;
+        m_stats.bytesWritten += static_cast<quint64>(written);
+        QMetaObject::invokeMethod(this, &UARTTransport::onHangup, Qt::QueuedConnection);
+        return written;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        emit errorOccurred(QString("UART: write to %1 failed: %2").arg(m_portName,
+                                                                        strerror(errno)));
+        m_txBuffer.resize(0);
+        m_txOffset = 0;
+        return written;
+      }
+      break;
+    }
+    m_txOffset += static_cast<int>(count);
+    written += count;
+  }
+  m_stats.bytesWritten += static_cast<quint64>(written);
+
+  if (m_txOffset == m_txBuffer.size()) {
+    m_txBuffer.resize(0);  // keeps the capacity
+    m_txOffset = 0;
+    m_writeNotifier->setEnabled(false);
+  } else {
+    m_writeNotifier->setEnabled(true);  // the port's buffer is full
+  }
+  return written;
+}
+
+void UARTTransport::flushPending() {
+  if (isOpen()) {
+    writePending();
+  }
+}
+
+void UARTTransport::onWritable() {
+  writePending();
 }
 
 QByteArray UARTTransport::read(qint64 maxSize) {
@@ -89,17 +579,38 @@ QByteArray UARTTransport::read(qint64 maxSize) {
     return QByteArray();
   }
 
-  // TODO: Implement actual serial read
-  return QByteArray();
+  qint64 count = static_cast<qint64>(m_rxTail - m_rxHead);
+  if (maxSize > 0) {
+    count = qMin(count, maxSize);
+  }
+  QByteArray data(count, Qt::Uninitialized);
+  readInto(std::span<char>(data.data(), static_cast<size_t>(count)));
+  return data;
+}
+
+qint64 UARTTransport::readInto(std::span<char> buffer) {
+  if (!isOpen()) {
+    return -1;
+  }
+  Q_ASSERT(onReadThread());
+
+  const qint64 count =
+      static_cast<qint64>(qMin<quint64>(m_rxTail - m_rxHead, buffer.size()));
+  const quint64 capacity = static_cast<quint64>(m_rxRing.size());
+  const quint64 start = m_rxHead & (capacity - 1);
+  const qint64 first = qMin<qint64>(count, static_cast<qint64>(capacity - start));
+  memcpy(buffer.data(), m_rxRing.constData() + start, first);
+  memcpy(buffer.data() + first, m_rxRing.constData(), count - first);
+  m_rxHead += static_cast<quint64>(count);
+  return count;
 }
 
 qint64 UARTTransport::bytesAvailable() const {
   if (!isOpen()) {
     return 0;
   }
-
-  // TODO: Implement actual bytes available check
-  return 0;
+  Q_ASSERT(onReadThread());
+  return static_cast<qint64>(m_rxTail - m_rxHead);
 }
 
 void UARTTransport::flush() {
@@ -107,7 +618,15 @@ void UARTTransport::flush() {
     return;
   }
 
-  // TODO: Implement actual flush
+  // Push out everything coalesced so far, waiting briefly for a full port
+  QElapsedTimer timer;
+  timer.start();
+  writePending();
+  while (m_txOffset < m_txBuffer.size() && timer.elapsed() < kFlushTimeoutMs) {
+    pollfd descriptor{m_fd, POLLOUT, 0};
+    ::poll(&descriptor, 1, static_cast<int>(kFlushTimeoutMs - timer.elapsed()));
+    writePending();
+  }
 }
 
 bool UARTTransport::configure(const QString& key, const QVariant& value) {
@@ -123,6 +642,23 @@ bool UARTTransport::configure(const QString& key, const QVariant& value) {
     return setStopBits(value.toUInt());
   } else if (key == "flowControl") {
     return setFlowControl(value.toString());
+  } else if (key == "lowLatency") {
+    return setLowLatency(value.toBool());
+  } else if (key == "readBatchIntervalMs") {
+    updateReadRest();
+  } else if (key == "rxBufferBytes") {
+    // The reactor thread reads into the ring
+    const bool watched = m_reactor && m_fd >= 0;
+    if (watched) {
+      m_reactor->remove(m_fd);
+    }
+    resizeRing(value.toInt());
+    m_config[key] = m_rxRing.size();
+    if (watched) {
+      watchReads();
+    }
+  } else if (key == "port") {
+    m_portName = value.toString();
   }
 
   return true;
@@ -132,32 +668,129 @@ QVariant UARTTransport::getConfiguration(const QString& key) const {
   return m_config.value(key);
 }
 
+bool UARTTransport::setReactor(IoReactor* reactor) {
+  if (reactor == m_reactor) {
+    return true;
+  }
+  if (m_reactor && m_fd >= 0) {
+    m_reactor->remove(m_fd);
+  }
+  m_reactor = reactor;
+  if (m_fd >= 0) {
+    watchReads();
+  }
+  return m_reactor == reactor;
+}
+
+bool UARTTransport::setCapture(crankshaft::diagnostics::CaptureWriter* writer,
+                               const QString& streamName) {
+  int stream = -1;
+  if (writer) {
+    stream = writer->addStream(crankshaft::diagnostics::capture::StreamKind::Bytes,
+                               streamName.isEmpty() ? getName() : streamName,
+                               {m_config.value("baudRate").toInt(), 0, 0, 0});
+    if (stream < 0) {
+      return false;
+    }
+  }
+
+  // Take the port off the reactor so no drain is using the old writer
+  const bool watched = m_reactor && m_fd >= 0;
+  if (watched) {
+    m_reactor->remove(m_fd);
+  }
+  m_capture = writer;
+  m_captureStream = stream;
+  if (watched) {
+    watchReads();
+  }
+  return true;
+}
+
+void UARTTransport::watchReads() {
+  m_readBatchTimer->stop();
+  if (m_reactor && !m_reactor->add(m_fd, this)) {
+    Logger::instance().warning(
+        QString("UART: %1 stays on its own thread, the reactor refused it").arg(m_portName));
+    m_reactor = nullptr;
+  }
+  m_readNotifier->setEnabled(m_reactor == nullptr);
+}
+
+void UARTTransport::updateReadRest() {
+  const qint64 intervalMs = m_config.value("lowLatency").toBool()
+                                ? 0
+                                : m_config.value("readBatchIntervalMs").toInt();
+  m_readRestNs.store(intervalMs * 1000000, std::memory_order_relaxed);
+}
+
 bool UARTTransport::setBaudRate(qint32 baudRate) {
+  if (speedFor(baudRate) == 0) {
+    Logger::instance().warning(QString("UART: unsupported baud rate %1").arg(baudRate));
+    return false;
+  }
   m_config["baudRate"] = baudRate;
-  // TODO: Apply to actual serial port
-  return true;
+  return applyTermios();
 }
 
 bool UARTTransport::setDataBits(quint8 dataBits) {
+  if (dataBits < 5 || dataBits > 8) {
+    return false;
+  }
   m_config["dataBits"] = dataBits;
-  // TODO: Apply to actual serial port
-  return true;
+  return applyTermios();
 }
 
 bool UARTTransport::setParity(const QString& parity) {
+  if (parity != "none" && parity != "even" && parity != "odd") {
+    return false;
+  }
   m_config["parity"] = parity;
-  // TODO: Apply to actual serial port
-  return true;
+  return applyTermios();
 }
 
 bool UARTTransport::setStopBits(quint8 stopBits) {
+  if (stopBits != 1 && stopBits != 2) {
+    return false;
+  }
   m_config["stopBits"] = stopBits;
-  // TODO: Apply to actual serial port
-  return true;
+  return applyTermios();
 }
 
 bool UARTTransport::setFlowControl(const QString& flowControl) {
+  if (flowControl != "none" && flowControl != "hardware" && flowControl != "software") {
+    return false;
+  }
   m_config["flowControl"] = flowControl;
-  // TODO: Apply to actual serial port
+  return applyTermios();
+}
+
+bool UARTTransport::setLowLatency(bool enabled) {
+  m_config["lowLatency"] = enabled;
+  applyLowLatency();
+  updateReadRest();
+  if (enabled) {
+    // Nothing may wait behind a resting notifier or a pending coalesce
+    m_readBatchTimer->stop();
+    if (m_readNotifier && !m_reactor) {
+      m_readNotifier->setEnabled(true);
+    }
+    if (isOpen()) {
+      writePending();
+    }
+  }
   return true;
 }
+
+UARTTransport::Stats UARTTransport::stats() const {
+  Stats stats = m_stats;
+  stats.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+  stats.readWakeups = m_readWakeups.load(std::memory_order_relaxed);
+  stats.overflowBytes = m_overflowBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool UARTTransport::onReadThread() const {
+  // The ring has a single owner: the reactor thread while one is set
+  return !m_reactor || m_reactor->isReactorThread();
+}
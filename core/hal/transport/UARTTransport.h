@@ -19,26 +19,70 @@
 
 #pragma once
 
+#include <QVector>
+#include <atomic>
+
+#include "IoReactor.h"
 #include "Transport.h"
 
+class QSocketNotifier;
+class QTimer;
+
 /**
  * @brief UART/Serial transport implementation
  *
  * Provides serial communication for devices that use UART/RS232.
  * Can be used by: GPS receivers, CAN adapters, debug consoles, etc.
  *
+ * The port is opened non-blocking and configured through termios (raw
+ * mode, VMIN 1 / VTIME 0). Readiness comes from QSocketNotifiers on the
+ * transport's thread, so an idle port costs nothing. Each wakeup reads
+ * straight into a ring buffer with readv(); after one, the read notifier
+ * rests for readBatchIntervalMs so a busy port is drained in batches
+ * rather than woken per byte. (A VMIN above 1 would batch in the kernel
+ * instead, but strands any tail shorter than VMIN until more data comes.)
+ * Writes issued within one event-loop pass are coalesced into a single
+ * write() call.
+ *
+ * With setReactor() the read side moves to an IoReactor instead: the
+ * reactor rests the descriptor the same way, and dataReceived() is emitted
+ * on the reactor thread. The receive ring then belongs to that thread:
+ * read(), readInto() and bytesAvailable() are called from dataReceived()
+ * (connected directly), as the functional devices do. Writes stay on the
+ * transport's thread; stats() may be called from either.
+ *
+ * When the port hangs up (end of file, EIO/ENXIO or POLLHUP, e.g. a USB
+ * adapter unplugged) the transport closes itself, emitting disconnected()
+ * and then errorOccurred(), on its own thread.
+ *
+ * With setCapture() every read is also recorded, as it left the kernel,
+ * into a capture stream of raw bytes (params: baud rate).
+ *
  * Configuration keys:
  *   - "port": Serial port path (e.g., "/dev/ttyUSB0")
- *   - "baudRate": Baud rate (e.g., 9600, 115200)
+ *   - "baudRate": Baud rate (e.g., 9600, 115200, 921600)
  *   - "dataBits": Data bits (5, 6, 7, 8)
  *   - "parity": Parity ("none", "even", "odd")
  *   - "stopBits": Stop bits (1, 2)
  *   - "flowControl": Flow control ("none", "hardware", "software")
+ *   - "lowLatency": ASYNC_LOW_LATENCY, 1 ms USB latency timer, no write
+ *                   coalescing and no read batching (bool, default false)
+ *   - "readBatchIntervalMs": Minimum time between read wakeups (default 5)
+ *   - "rxBufferBytes": Receive ring size; oldest bytes drop first (default 64 KiB)
+ *   - "writeCoalesceBytes": Write at once when this much is pending (default 4096)
  */
-class UARTTransport : public Transport {
+class UARTTransport : public Transport, private IoReactor::Handler {
   Q_OBJECT
 
  public:
+  struct Stats {
+    quint64 bytesRead{0};
+    quint64 bytesWritten{0};
+    quint64 readWakeups{0};    // readable notifications that returned data
+    quint64 writeCalls{0};     // write() system calls
+    quint64 overflowBytes{0};  // dropped from a full receive ring
+  };
+
   explicit UARTTransport(const QString& portName, QObject* parent = nullptr);
   ~UARTTransport() override;
 
@@ -54,11 +98,15 @@ class UARTTransport : public Transport {
 
   qint64 write(const QByteArray& data) override;
   QByteArray read(qint64 maxSize = 0) override;
+  qint64 readInto(std::span<char> buffer) override;
   qint64 bytesAvailable() const override;
   void flush() override;
 
   bool configure(const QString& key, const QVariant& value) override;
   QVariant getConfiguration(const QString& key) const override;
+  bool setReactor(IoReactor* reactor) override;
+  bool setCapture(crankshaft::diagnostics::CaptureWriter* writer,
+                  const QString& streamName = QString()) override;
 
   // UART-specific configuration helpers
   bool setBaudRate(qint32 baudRate);
@@ -66,12 +114,60 @@ class UARTTransport : public Transport {
   bool setParity(const QString& parity);
   bool setStopBits(quint8 stopBits);
   bool setFlowControl(const QString& flowControl);
+  bool setLowLatency(bool enabled);
+
+  Stats stats() const;
+
+  /**
+   * @brief termios speed constant for a baud rate, 0 if unsupported
+   */
+  static quint32 speedFor(qint32 baudRate);
+
+ private slots:
+  void onReadable();
+  void onWritable();
+  void onReadBatchTimeout();
+  void onHangup();
+  void flushPending();
 
  private:
+  bool applyTermios();
+  void applyLowLatency();
+  void onReactorReadable() override;
+  void onReactorHangup() override;
+  void watchReads();
+  void updateReadRest();
+  void setState(TransportState state);
+  void fail(const QString& error);
+  qint64 drainPort(bool* hungUp);
+  void resizeRing(int capacity);
+  qint64 writePending();
+  bool onReadThread() const;
+
   QString m_portName;
   TransportState m_state;
   QVariantMap m_config;
+  int m_fd;
+  QSocketNotifier* m_readNotifier;
+  QSocketNotifier* m_writeNotifier;
+  QTimer* m_readBatchTimer;
+  QTimer* m_flushTimer;
+  IoReactor* m_reactor;
+  std::atomic<qint64> m_readRestNs;  // read batching rest, for the reactor thread
+  crankshaft::diagnostics::CaptureWriter* m_capture;  // records each read when set
+  int m_captureStream;
+
+  // Receive ring; m_rxHead and m_rxTail only grow, masked on access
+  QVector<char> m_rxRing;
+  quint64 m_rxHead;
+  quint64 m_rxTail;
+
+  QByteArray m_txBuffer;
+  int m_txOffset;  // bytes of m_txBuffer already written
+  Stats m_stats;   // write side; the read side's counters follow
 
-  // Platform-specific serial port handle would go here
-  // void* m_serialHandle;
+  // Bumped by whichever thread drains the port, read by stats()
+  std::atomic<quint64> m_bytesRead;
+  std::atomic<quint64> m_readWakeups;
+  std::atomic<quint64> m_overflowBytes;
 };
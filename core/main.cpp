@@ -23,15 +23,26 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QHostAddress>
+#include <QJsonObject>
 #include <QString>
 #include <aasdk/Common/ModernLogger.hpp>
+#include <optional>
 
 #include "services/android_auto/AndroidAutoService.h"
 #include "services/config/ConfigService.h"
+#include "services/diagnostics/FlightRecorder.h"
+#include "services/diagnostics/MetricsHttpServer.h"
+#include "services/diagnostics/SamplingProfiler.h"
+#include "services/diagnostics/StallWatchdog.h"
+#include "services/diagnostics/StartupTracer.h"
+#include "services/driving_mode/DrivingModeService.h"
 #include "services/eventbus/EventBus.h"
 #include "services/logging/Logger.h"
 #include "services/profile/ProfileManager.h"
 #include "services/service_manager/ServiceManager.h"
+#include "services/state/StateSnapshotService.h"
+#include "services/vehicle/SensorFusionService.h"
 #include "services/websocket/WebSocketServer.h"
 #if defined(__has_include)
 #if __has_include("build_info.h")
@@ -53,10 +64,13 @@ int main(int argc, char* argv[]) {
   QElapsedTimer startupTimer;
   startupTimer.start();
   const qint64 startTimestampMs = QDateTime::currentMSecsSinceEpoch();
+  StartupTracer& tracer = StartupTracer::instance();  // trace origin
+  qint64 phaseStartNs = StartupTracer::nowNs();
 
   QCoreApplication app(argc, argv);
   QCoreApplication::setApplicationName("Crankshaft Core");
   QCoreApplication::setApplicationVersion("0.1.0");
+  tracer.record("QCoreApplication", phaseStartNs, StartupTracer::nowNs());
 
   // Log startup initiation with timestamp
   qInfo() << "[STARTUP]" << startTimestampMs << "ms: Core main() entry";
@@ -91,6 +105,18 @@ int main(int argc, char* argv[]) {
       "Enable verbose AASDK USB logging (or use env AASDK_VERBOSE_USB=1)");
   parser.addOption(verboseUsbOption);
 
+  QCommandLineOption startupModeOption(
+      QStringList() << "startup-mode",
+      "Service startup mode: parallel or sequential (default: core.services.startupMode)",
+      "mode");
+  parser.addOption(startupModeOption);
+
+  QCommandLineOption startupTraceOption(
+      QStringList() << "startup-trace",
+      "Write a Chrome trace of startup phases to this file (or env CRANKSHAFT_STARTUP_TRACE)",
+      "file");
+  parser.addOption(startupTraceOption);
+
   parser.process(app);
 
   // Enable AASDK verbose USB logging if requested via env var, CLI option or raw argv
@@ -126,13 +152,45 @@ int main(int argc, char* argv[]) {
           .arg(QString::fromUtf8(CRANKSHAFT_GIT_BRANCH)));
 
   // Load configuration
+  phaseStartNs = StartupTracer::nowNs();
   QString configPath = parser.value(configOption);
   if (!ConfigService::instance().load(configPath)) {
     Logger::instance().warning("Using default configuration");
   }
+  tracer.record("Configuration", phaseStartNs, StartupTracer::nowNs());
   Logger::instance().info(
       QString("[STARTUP] %1ms elapsed: Configuration loaded").arg(startupTimer.elapsed()));
 
+  // The flight recorder always runs; this only adds the crash dump
+  if (ConfigService::instance().get("core.flightRecorder.crashDump", true).toBool()) {
+    auto& recorder = crankshaft::diagnostics::FlightRecorder::instance();
+    recorder.installCrashHandler(
+        ConfigService::instance().get("core.flightRecorder.directory", QString()).toString());
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &app,
+                     [&recorder]() { recorder.removeCrashFile(); });
+  }
+
+  // Stall watchdog: the main loop, plus loops services register (AASDKThread)
+  if (ConfigService::instance().get("core.watchdog.enabled", true).toBool()) {
+    auto& watchdog = crankshaft::diagnostics::StallWatchdog::instance();
+    crankshaft::diagnostics::StallWatchdog::Options options;
+    options.heartbeatMs =
+        ConfigService::instance().get("core.watchdog.heartbeatMs", options.heartbeatMs).toInt();
+    options.thresholdMs =
+        ConfigService::instance().get("core.watchdog.thresholdMs", options.thresholdMs).toInt();
+    options.dumpFlightRecorder =
+        ConfigService::instance()
+            .get("core.watchdog.dumpFlightRecorder", options.dumpFlightRecorder)
+            .toBool();
+    QObject::connect(&watchdog, &crankshaft::diagnostics::StallWatchdog::stallEnded, &app,
+                     [](const QVariantMap& stall) {
+                       EventBus::instance().publish("diagnostics/stall", stall);
+                     });
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &app,
+                     [&watchdog]() { watchdog.stop(); });
+    watchdog.start(options);
+  }
+
   // Get port from config or command line
   quint16 port = parser.value(portOption).toUInt();
   if (port == 0) {
@@ -142,13 +200,19 @@ int main(int argc, char* argv[]) {
   // Initialise services
   Logger::instance().info(
       QString("[STARTUP] %1ms elapsed: Initialising core services...").arg(startupTimer.elapsed()));
+  phaseStartNs = StartupTracer::nowNs();
   EventBus::instance();  // Initialise event bus
+  tracer.record("EventBus", phaseStartNs, StartupTracer::nowNs());
   Logger::instance().info(
       QString("[STARTUP] %1ms elapsed: Event bus initialised").arg(startupTimer.elapsed()));
 
   // Initialise ProfileManager
   Logger::instance().info(QString("[STARTUP] %1ms elapsed: Initialising ProfileManager...")
                               .arg(startupTimer.elapsed()));
+  // Top-level phases that contain StartupPhase scopes of their own are scopes
+  // too, so the inner ones nest under them instead of counting twice
+  std::optional<StartupPhase> phase;
+  phase.emplace("ProfileManager");
   QString profileConfigDir = ConfigService::instance()
                                  .get("core.profile.configDir", "/etc/crankshaft/profiles")
                                  .toString();
@@ -157,16 +221,38 @@ int main(int argc, char* argv[]) {
   if (!profileManager.loadProfiles()) {
     Logger::instance().warning("Failed to load profiles, using default profiles");
   }
+  phase.reset();
+
+  // Profile writes are coalesced in the background; make sure nothing pending
+  // is lost when the event loop stops.
+  QObject::connect(&app, &QCoreApplication::aboutToQuit, &profileManager,
+                   [&profileManager]() { profileManager.flush(); });
 
   HostProfile activeProfile = profileManager.getActiveHostProfile();
   Logger::instance().info(QString("[STARTUP] %1ms elapsed: Active host profile: %2 (%3)")
                               .arg(startupTimer.elapsed())
                               .arg(activeProfile.name, activeProfile.id));
 
+  // Last-known UI state from the previous run, served to clients on connect
+  phase.emplace("StateSnapshot");
+  StateSnapshotService stateSnapshot(
+      ConfigService::instance().get("core.snapshot.path", QString()).toString());
+  const QStringList snapshotTopics =
+      ConfigService::instance().get("core.snapshot.topics").toStringList();
+  if (!snapshotTopics.isEmpty()) {
+    stateSnapshot.setTrackedTopics(snapshotTopics);
+  }
+  stateSnapshot.load();
+  QObject::connect(&app, &QCoreApplication::aboutToQuit, &stateSnapshot,
+                   [&stateSnapshot]() { stateSnapshot.save(); });
+  phase.reset();
+
   // Create WebSocket server
   Logger::instance().info(
       QString("[STARTUP] %1ms elapsed: Creating WebSocket server...").arg(startupTimer.elapsed()));
+  phase.emplace("WebSocketServer");
   WebSocketServer server(port);
+  phase.reset();
   if (!server.isListening()) {
     Logger::instance().error("Failed to start WebSocket server on port " + QString::number(port));
     return 1;
@@ -178,30 +264,123 @@ int main(int argc, char* argv[]) {
   // Connect EventBus to WebSocket server (broadcasts all events)
   QObject::connect(&EventBus::instance(), &EventBus::messagePublished, &server,
                    &WebSocketServer::broadcastEvent);
+  server.setStateSnapshot(&stateSnapshot);
+
+  // Prometheus/CSV scrape endpoint for external collectors (off by default)
+  crankshaft::diagnostics::MetricsHttpServer metricsServer(
+      crankshaft::diagnostics::MetricsRegistry::instance());
+  if (ConfigService::instance().get("core.metrics.http.enabled", false).toBool()) {
+    const QHostAddress metricsAddress(
+        ConfigService::instance().get("core.metrics.http.host", "127.0.0.1").toString());
+    const quint16 metricsPort =
+        ConfigService::instance().get("core.metrics.http.port", 9464).toUInt();
+    metricsServer.listen(metricsAddress, metricsPort);
+  }
+
+  // Sampling profiler, idle until a client sends profile_start
+  crankshaft::diagnostics::SamplingProfiler profiler;
+  QObject::connect(&profiler, &crankshaft::diagnostics::SamplingProfiler::finished, &app,
+                   [](const QJsonObject& result) {
+                     EventBus::instance().publish("diagnostics/profile/finished",
+                                                  result.toVariantMap());
+                   });
+  server.setProfiler(&profiler);
+
+  // Keep the active profile in the snapshot; it is live state, never restored
+  auto publishActiveProfile = [&profileManager]() {
+    const HostProfile profile = profileManager.getActiveHostProfile();
+    EventBus::instance().publish("profiles/host/active",
+                                 {{"id", profile.id}, {"name", profile.name}});
+  };
+  publishActiveProfile();
+  QObject::connect(&profileManager, &ProfileManager::hostProfileChanged, &app,
+                   publishActiveProfile);
 
   // Create ServiceManager and start services
   Logger::instance().info(QString("[STARTUP] %1ms elapsed: Initialising ServiceManager...")
                               .arg(startupTimer.elapsed()));
+  // Open until the last service has settled in the event loop
+  phase.emplace("Services");
   ServiceManager serviceManager(&profileManager, &app);
 
   // Register ServiceManager with WebSocketServer for remote control
   server.setServiceManager(&serviceManager);
 
-  Logger::instance().info(QString("[STARTUP] %1ms elapsed: Starting services based on profile...")
-                              .arg(startupTimer.elapsed()));
-  if (!serviceManager.startAllServices()) {
-    Logger::instance().warning("No services started successfully");
+  // Vehicle state and driving mode for the Android Auto sensor channel. The
+  // fusion step only runs when enabled; GPS and CAN devices attach to it.
+  SensorFusionService sensorFusion;
+  DrivingModeService drivingMode;
+  QObject::connect(&sensorFusion, &SensorFusionService::vehicleSpeedUpdated, &drivingMode,
+                   &DrivingModeService::onVehicleSpeedUpdated);
+  QObject::connect(&sensorFusion, &SensorFusionService::stateUpdated, &serviceManager,
+                   &ServiceManager::updateVehicleState);
+  QObject::connect(&drivingMode, &DrivingModeService::drivingModeChanged, &serviceManager,
+                   &ServiceManager::setDriving);
+  // Also on the bus, so UIs and the state snapshot follow it
+  auto publishDrivingMode = [](bool driving) {
+    EventBus::instance().publish("driving-mode/status", {{"driving", driving}});
+  };
+  publishDrivingMode(drivingMode.isDrivingMode());
+  QObject::connect(&drivingMode, &DrivingModeService::drivingModeChanged, &app,
+                   publishDrivingMode);
+  if (ConfigService::instance().get("core.vehicle.fusion.enabled", false).toBool()) {
+    sensorFusion.start();
   }
-  Logger::instance().info(QString("[STARTUP] %1ms elapsed: Service initialisation complete")
-                              .arg(startupTimer.elapsed()));
 
-  // Initialize WebSocket connections to services (after services are started)
-  server.initializeServiceConnections();
+  const QString startupMode =
+      parser.isSet(startupModeOption)
+          ? parser.value(startupModeOption)
+          : ConfigService::instance().get("core.services.startupMode", "parallel").toString();
+  serviceManager.setStartupMode(startupMode == "sequential" ? ServiceStartupGraph::Mode::Sequential
+                                                            : ServiceStartupGraph::Mode::Parallel);
+
+  QString startupTracePath = parser.value(startupTraceOption);
+  if (startupTracePath.isEmpty()) {
+    startupTracePath = qEnvironmentVariable("CRANKSHAFT_STARTUP_TRACE");
+  }
+
+  // Services settle independently; READY is reported once the last one has
+  QObject::connect(
+      &serviceManager, &ServiceManager::allServicesStarted, &app,
+      [&startupTimer, &tracer, &phase, startupMode, startupTracePath](int succeeded, int failed,
+                                                                     qint64) {
+        phase.reset();
+        tracer.mark("READY");
+        tracer.finish();
+
+        Logger::instance().info(
+            QString("[STARTUP] %1ms elapsed: Service initialisation complete (%2 started, %3 "
+                    "failed)")
+                .arg(startupTimer.elapsed())
+                .arg(succeeded)
+                .arg(failed));
+        Logger::instance().info(
+            QString("[STARTUP] %1ms elapsed: Crankshaft Core started successfully")
+                .arg(startupTimer.elapsed()));
+        Logger::instance().info(QString("[STARTUP] READY - Total startup time: %1ms (mode: %2)")
+                                    .arg(startupTimer.elapsed())
+                                    .arg(startupMode));
+
+        if (!startupTracePath.isEmpty()) {
+          if (tracer.writeChromeTrace(startupTracePath)) {
+            Logger::instance().info(
+                QString("[STARTUP] Startup trace written to %1").arg(startupTracePath));
+          } else {
+            Logger::instance().warning(
+                QString("[STARTUP] Failed to write startup trace to %1").arg(startupTracePath));
+          }
+        }
+        EventBus::instance().publish("system/startup/summary", tracer.summary());
+      },
+      Qt::SingleShotConnection);
 
-  Logger::instance().info(QString("[STARTUP] %1ms elapsed: Crankshaft Core started successfully")
-                              .arg(startupTimer.elapsed()));
   Logger::instance().info(
-      QString("[STARTUP] READY - Total startup time: %1ms").arg(startupTimer.elapsed()));
+      QString("[STARTUP] %1ms elapsed: Starting services based on profile (%2)...")
+          .arg(startupTimer.elapsed())
+          .arg(startupMode));
+  if (!serviceManager.startAllServices()) {
+    Logger::instance().warning("No services scheduled to start");
+  }
 
   return app.exec();
 }
@@ -25,11 +25,14 @@
 #include <QJsonDocument>
 #include <QTimer>
 
+#include "../../hal/multimedia/AudioMixer.h"
+#include "../../hal/multimedia/GStreamerVideoDecoder.h"
 #include "../../hal/multimedia/MediaPipeline.h"
 #include "../logging/Logger.h"
 #include "../profile/ProfileManager.h"
 #include "MockAndroidAutoService.h"
 #include "RealAndroidAutoService.h"
+#include "ReplayAndroidAutoService.h"
 
 class AndroidAutoServiceImpl : public AndroidAutoService {
   Q_OBJECT
@@ -291,23 +294,19 @@ class AndroidAutoServiceImpl : public AndroidAutoService {
   int latency_ms_;
 };
 
-// Base class constructor
-AndroidAutoService::AndroidAutoService(QObject* parent) : QObject(parent) {}
-
-// Base class destructor
-AndroidAutoService::~AndroidAutoService() {}
-
 // Static factory function
 AndroidAutoService* AndroidAutoService::create(MediaPipeline* mediaPipeline,
                                                ProfileManager* profileManager, QObject* parent) {
   // Check ProfileManager for AndroidAuto device configuration
   bool useMock = true;  // Default to mock if profile not found
+  QString replayFile;
 
   if (profileManager) {
     HostProfile activeProfile = profileManager->getActiveHostProfile();
     for (const auto& device : activeProfile.devices) {
       if (device.name == "AndroidAuto" || device.type == "AndroidAuto") {
         useMock = device.useMock;
+        replayFile = device.settings.value("replay.file").toString();
         Logger::instance().info(QString("AndroidAuto device found in profile '%1': useMock=%2")
                                     .arg(activeProfile.name)
                                     .arg(useMock ? "true" : "false"));
@@ -321,7 +320,14 @@ AndroidAutoService* AndroidAutoService::create(MediaPipeline* mediaPipeline,
 
   AndroidAutoService* service = nullptr;
 
-  if (useMock) {
+  if (!replayFile.isEmpty()) {
+    // A recorded session through the real decoder and mixer
+    Logger::instance().info(QString("Creating Replay Android Auto service (%1)").arg(replayFile));
+    auto* replay = new ReplayAndroidAutoService(parent);
+    replay->setVideoDecoder(new GStreamerVideoDecoder(replay));
+    replay->setAudioMixer(new AudioMixer(replay));
+    service = replay;
+  } else if (useMock) {
     Logger::instance().info("Creating Mock Android Auto service (profile setting)");
     service = new MockAndroidAutoService(parent);
   } else {
@@ -28,6 +28,7 @@
 // Forward declarations
 class MediaPipeline;
 class ProfileManager;
+class SensorFeeder;
 
 /**
  * @brief Android Auto projection service
@@ -64,8 +65,15 @@ class AndroidAutoService : public QObject {
     ProjectionMode projectionMode = ProjectionMode::PROJECTION;
   };
 
-  explicit AndroidAutoService(QObject* parent = nullptr);
-  ~AndroidAutoService() override;
+  // Stream names in a session capture ("capture.file", "replay.file")
+  static constexpr char kCaptureVideoStream[] = "aa.video";
+  static constexpr char kCaptureMediaAudioStream[] = "aa.audio.media";
+  static constexpr char kCaptureSystemAudioStream[] = "aa.audio.system";
+  static constexpr char kCaptureSpeechAudioStream[] = "aa.audio.speech";
+  static constexpr char kCaptureInputStream[] = "aa.input";
+
+  explicit AndroidAutoService(QObject* parent = nullptr) : QObject(parent) {}
+  ~AndroidAutoService() override = default;
 
   /**
    * @brief Factory method to create Android Auto service
@@ -195,6 +203,13 @@ class AndroidAutoService : public QObject {
    */
   virtual QJsonObject getAudioConfig() const = 0;
 
+  /**
+   * @brief Source of the sensor channel's data, nullptr if there is no sensor channel
+   */
+  virtual SensorFeeder* sensorFeeder() const {
+    return nullptr;
+  }
+
  signals:
   /**
    * @brief Emitted when connection state changes
@@ -113,5 +113,49 @@ aap_protobuf::service::control::message::AudioFocusNotification createAudioFocus
   return notification;
 }
 
+aap_protobuf::service::sensorsource::message::SensorStartResponseMessage
+createSensorStartResponse(bool success) {
+  aap_protobuf::service::sensorsource::message::SensorStartResponseMessage response;
+  response.set_status(success ? aap_protobuf::shared::MessageStatus::STATUS_SUCCESS
+                              : aap_protobuf::shared::MessageStatus::STATUS_INVALID_SENSOR);
+  return response;
+}
+
+void encodeSensorBatch(const SensorFeeder::Batch& batch,
+                       aap_protobuf::service::sensorsource::message::SensorBatch* message) {
+  using Batch = SensorFeeder::Batch;
+  message->Clear();
+
+  if (batch.fields & Batch::HasLocation) {
+    auto* location = message->add_location_data();
+    location->set_timestamp(batch.timestampMs);
+    location->set_latitude_e7(batch.latitudeE7);
+    location->set_longitude_e7(batch.longitudeE7);
+    location->set_accuracy_e3(batch.accuracyE3);
+    if (batch.fields & Batch::SpeedValid) {
+      location->set_speed_e3(batch.speedE3);
+    }
+    if (batch.fields & Batch::BearingValid) {
+      location->set_bearing_e6(batch.bearingE6);
+    }
+  }
+
+  if ((batch.fields & Batch::HasCompass) && (batch.fields & Batch::BearingValid)) {
+    message->add_compass_data()->set_bearing_e6(batch.bearingE6);
+  }
+
+  if ((batch.fields & Batch::HasSpeed) && (batch.fields & Batch::SpeedValid)) {
+    message->add_speed_data()->set_speed_e3(batch.speedE3);
+  }
+
+  if (batch.fields & Batch::HasNightMode) {
+    message->add_night_mode_data()->set_night_mode(batch.nightMode);
+  }
+
+  if (batch.fields & Batch::HasDrivingStatus) {
+    message->add_driving_status_data()->set_status(batch.drivingStatus);
+  }
+}
+
 }  // namespace protocol
 }  // namespace crankshaft
@@ -24,9 +24,13 @@
 #include <aap_protobuf/service/inputsource/message/InputReport.pb.h>
 #include <aap_protobuf/service/inputsource/message/KeyEvent.pb.h>
 #include <aap_protobuf/service/inputsource/message/TouchEvent.pb.h>
+#include <aap_protobuf/service/sensorsource/message/SensorBatch.pb.h>
+#include <aap_protobuf/service/sensorsource/message/SensorStartResponseMessage.pb.h>
 
 #include <aasdk/Common/Data.hpp>
 
+#include "SensorFeeder.h"
+
 namespace crankshaft {
 namespace protocol {
 
@@ -88,6 +92,26 @@ aap_protobuf::service::inputsource::message::InputReport createKeyInputReport(
 aap_protobuf::service::control::message::AudioFocusNotification createAudioFocusNotification(
     AudioFocusState focusState);
 
+/**
+ * @brief Create a sensor start response message
+ * @param success Whether the sensor will be reported
+ * @return SensorStartResponseMessage protobuf message
+ */
+aap_protobuf::service::sensorsource::message::SensorStartResponseMessage
+createSensorStartResponse(bool success);
+
+/**
+ * @brief Encode a feeder batch into a reusable SensorBatch message
+ *
+ * The message is cleared first. Protobuf keeps cleared repeated entries for
+ * the next add_*(), so encoding into the same message every time does not
+ * allocate once each entry type has been used.
+ * @param batch Values from SensorFeeder::batchReady()
+ * @param message Message to overwrite
+ */
+void encodeSensorBatch(const SensorFeeder::Batch& batch,
+                       aap_protobuf::service::sensorsource::message::SensorBatch* message);
+
 /**
  * @brief Get current timestamp in microseconds
  * @return Timestamp suitable for input events
@@ -21,18 +21,26 @@
 
 #include <QImage>
 #include <QJsonObject>
+#include <QPointer>
 #include <QTimer>
 #include <QUuid>
 
 #include "../../hal/multimedia/AudioMixer.h"
 #include "../../hal/multimedia/GStreamerVideoDecoder.h"
 #include "../audio/AudioRouter.h"
+#include "../diagnostics/CaptureWriter.h"
+#include "../diagnostics/FlightRecorder.h"
+#include "../diagnostics/StallWatchdog.h"
 #include "../eventbus/EventBus.h"
 #include "../logging/Logger.h"
 #include "../session/SessionStore.h"
 #include "ProtocolHelpers.h"
 
 // AASDK includes
+#include <aap_protobuf/service/control/message/ChannelOpenRequest.pb.h>
+#include <aap_protobuf/service/control/message/ChannelOpenResponse.pb.h>
+#include <aap_protobuf/service/sensorsource/message/SensorRequest.pb.h>
+#include <aap_protobuf/shared/MessageStatus.pb.h>
 #include <aasdk/Channel/Bluetooth/BluetoothService.hpp>
 #include <aasdk/Channel/Control/ControlServiceChannel.hpp>
 #include <aasdk/Channel/InputSource/InputSourceService.hpp>
@@ -40,6 +48,7 @@
 #include <aasdk/Channel/MediaSink/Audio/Channel/MediaAudioChannel.hpp>
 #include <aasdk/Channel/MediaSink/Audio/Channel/SystemAudioChannel.hpp>
 #include <aasdk/Channel/MediaSink/Video/Channel/VideoChannel.hpp>
+#include <aasdk/Channel/SensorSource/ISensorSourceServiceEventHandler.hpp>
 #include <aasdk/Channel/SensorSource/SensorSourceService.hpp>
 #include <aasdk/Messenger/Cryptor.hpp>
 #include <aasdk/Messenger/MessageInStream.hpp>
@@ -58,6 +67,8 @@
 #include <aasdk/USB/USBWrapper.hpp>
 #include <boost/asio.hpp>
 #include <chrono>
+#include <ctime>
+#include <functional>
 #include <iomanip>
 #include <sstream>
 
@@ -76,6 +87,15 @@ static std::string getTimestamp() {
   return oss.str();
 }
 
+/**
+ * @brief Current CLOCK_MONOTONIC time, the clock vehicle state is stamped with
+ */
+static qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
 /**
  * @brief Log info message with timestamp prefix
  */
@@ -94,6 +114,77 @@ static void logError(const std::string& msg) {
           .arg(QString::fromStdString(getTimestamp()), QString::fromStdString(msg)));
 }
 
+namespace {
+
+/**
+ * @brief Sensor channel events, called on the strand
+ *
+ * Opens the channel and hands each sensor start request to the callback,
+ * then waits for the next message.
+ */
+class SensorSourceServiceEventHandler
+    : public aasdk::channel::sensorsource::ISensorSourceServiceEventHandler,
+      public std::enable_shared_from_this<SensorSourceServiceEventHandler> {
+ public:
+  using RequestCallback = std::function<void(int sensorType, qint64 minUpdatePeriodMs)>;
+  using ErrorCallback = std::function<void(const QString& error)>;
+
+  SensorSourceServiceEventHandler(
+      const std::shared_ptr<aasdk::channel::sensorsource::SensorSourceService>& channel,
+      boost::asio::io_service::strand& strand, RequestCallback onRequest, ErrorCallback onError)
+      : m_channel(channel),
+        m_strand(strand),
+        m_onRequest(std::move(onRequest)),
+        m_onError(std::move(onError)) {}
+
+  void start() {
+    receive();
+  }
+
+  void onChannelOpenRequest(
+      const aap_protobuf::service::control::message::ChannelOpenRequest&) override {
+    auto channel = m_channel.lock();
+    if (!channel) {
+      return;
+    }
+    aap_protobuf::service::control::message::ChannelOpenResponse response;
+    response.set_status(aap_protobuf::shared::MessageStatus::STATUS_SUCCESS);
+    auto promise = aasdk::channel::SendPromise::defer(m_strand);
+    promise->then([]() {},
+                  [self = shared_from_this()](const aasdk::error::Error& error) {
+                    self->onChannelError(error);
+                  });
+    channel->sendChannelOpenResponse(response, std::move(promise));
+    receive();
+  }
+
+  void onSensorStartRequest(
+      const aap_protobuf::service::sensorsource::message::SensorRequest& request) override {
+    m_onRequest(static_cast<int>(request.type()),
+                static_cast<qint64>(request.min_update_period()));
+    receive();
+  }
+
+  void onChannelError(const aasdk::error::Error& error) override {
+    m_onError(QString::fromStdString(error.what()));
+  }
+
+ private:
+  void receive() {
+    // The channel holds the handler while a receive is pending, not the reverse
+    if (auto channel = m_channel.lock()) {
+      channel->receive(shared_from_this());
+    }
+  }
+
+  std::weak_ptr<aasdk::channel::sensorsource::SensorSourceService> m_channel;
+  boost::asio::io_service::strand& m_strand;
+  RequestCallback m_onRequest;
+  ErrorCallback m_onError;
+};
+
+}  // namespace
+
 RealAndroidAutoService::RealAndroidAutoService(MediaPipeline* mediaPipeline, QObject* parent)
     : AndroidAutoService(parent), m_mediaPipeline(mediaPipeline) {
   // Create AASDK thread
@@ -118,6 +209,13 @@ RealAndroidAutoService::RealAndroidAutoService(MediaPipeline* mediaPipeline, QOb
     Logger::instance().warning(
         "[RealAndroidAutoService] Failed to initialize AudioRouter - audio may not work");
   }
+
+  // Sensor channel data: vehicle state paced to the rates the phone asks for
+  m_sensorFeeder = new SensorFeeder(this);
+  m_sensorBatchMessage =
+      std::make_shared<aap_protobuf::service::sensorsource::message::SensorBatch>();
+  connect(m_sensorFeeder, &SensorFeeder::batchReady, this,
+          &RealAndroidAutoService::sendSensorBatch);
 }
 
 RealAndroidAutoService::~RealAndroidAutoService() {
@@ -125,6 +223,7 @@ RealAndroidAutoService::~RealAndroidAutoService() {
   deinitialise();
 
   if (m_aasdkThread && m_aasdkThread->isRunning()) {
+    crankshaft::diagnostics::StallWatchdog::instance().unwatchThread(m_aasdkThread.get());
     m_aasdkThread->quit();
     m_aasdkThread->wait();
   }
@@ -159,6 +258,50 @@ void RealAndroidAutoService::configureTransport(const QMap<QString, QVariant>& s
                                   .arg(m_wirelessPort));
     }
   }
+
+  const QString captureFile = settings.value("capture.file").toString();
+  if (!captureFile.isEmpty()) {
+    startCapture(captureFile);
+  }
+}
+
+void RealAndroidAutoService::startCapture(const QString& path) {
+  using crankshaft::diagnostics::capture::StreamKind;
+
+  auto writer = std::make_unique<crankshaft::diagnostics::CaptureWriter>();
+  QString error;
+  if (!writer->open(path, crankshaft::diagnostics::capture::kDefaultChunkBytes, &error)) {
+    Logger::instance().warning(
+        QString("[RealAndroidAutoService] Session capture disabled: %1").arg(error));
+    return;
+  }
+  m_captureVideoStream = writer->addStream(StreamKind::Video, kCaptureVideoStream,
+                                           {m_resolution.width(), m_resolution.height(), m_fps, 0});
+  m_captureMediaAudioStream =
+      writer->addStream(StreamKind::Audio, kCaptureMediaAudioStream, {48000, 2, 16, 0});
+  m_captureSystemAudioStream =
+      writer->addStream(StreamKind::Audio, kCaptureSystemAudioStream, {16000, 1, 16, 0});
+  m_captureSpeechAudioStream =
+      writer->addStream(StreamKind::Audio, kCaptureSpeechAudioStream, {16000, 1, 16, 0});
+  m_captureInputStream = writer->addStream(StreamKind::Input, kCaptureInputStream);
+  m_capture = std::move(writer);
+  Logger::instance().info(QString("[RealAndroidAutoService] Recording session to %1").arg(path));
+}
+
+void RealAndroidAutoService::capturePayload(int stream, const QByteArray& data) {
+  if (m_capture) {
+    m_capture->append(stream, {data.constData(), static_cast<size_t>(data.size())});
+  }
+}
+
+void RealAndroidAutoService::captureInput(quint16 type, int action, int x, int y, int keyCode) {
+  if (!m_capture) {
+    return;
+  }
+  const crankshaft::diagnostics::capture::InputEvent event{type, static_cast<uint16_t>(action), x,
+                                                           y, keyCode};
+  m_capture->append(m_captureInputStream,
+                    {reinterpret_cast<const char*>(&event), sizeof(event)});
 }
 
 bool RealAndroidAutoService::initialise() {
@@ -226,6 +369,8 @@ void RealAndroidAutoService::setupAASDK() {
 
   // Start AASDK thread
   m_aasdkThread->start();
+  crankshaft::diagnostics::StallWatchdog::instance().watchThread(m_aasdkThread.get(),
+                                                                 "AASDKThread");
 
   // Integrate io_service with Qt event loop via periodic polling
   if (m_ioServiceTimer == nullptr) {
@@ -387,6 +532,7 @@ void RealAndroidAutoService::setupChannels() {
     if (m_channelConfig.sensorEnabled) {
       m_sensorChannel = std::make_shared<aasdk::channel::sensorsource::SensorSourceService>(
           *m_strand, m_messenger);
+      startSensorChannel();
       Logger::instance().info("Sensor channel enabled");
     }
 
@@ -558,6 +704,7 @@ void RealAndroidAutoService::setupChannelsWithTransport() {
     if (m_channelConfig.sensorEnabled) {
       m_sensorChannel = std::make_shared<aasdk::channel::sensorsource::SensorSourceService>(
           *m_strand, m_messenger);
+      startSensorChannel();
       Logger::instance().info("Sensor channel enabled (TCP)");
     }
 
@@ -727,6 +874,8 @@ void RealAndroidAutoService::cleanupChannels() {
   m_systemAudioChannel.reset();
   m_speechAudioChannel.reset();
   m_inputChannel.reset();
+  m_sensorFeeder->stopAll();
+  m_sensorHandler.reset();
   m_sensorChannel.reset();
   m_bluetoothChannel.reset();
   m_controlChannel.reset();
@@ -952,6 +1101,8 @@ bool RealAndroidAutoService::sendTouchInput(int x, int y, int action) {
     Logger::instance().warning("Cannot send touch input: not connected or input channel disabled");
     return false;
   }
+  captureInput(static_cast<quint16>(crankshaft::diagnostics::capture::InputType::Touch), action, x,
+               y, 0);
 
   try {
     using namespace crankshaft::protocol;
@@ -1001,6 +1152,8 @@ bool RealAndroidAutoService::sendKeyInput(int key_code, int action) {
     Logger::instance().warning("Cannot send key input: not connected or input channel disabled");
     return false;
   }
+  captureInput(static_cast<quint16>(crankshaft::diagnostics::capture::InputType::Key), action, 0, 0,
+               key_code);
 
   try {
     using namespace crankshaft::protocol;
@@ -1430,6 +1583,9 @@ void RealAndroidAutoService::transitionToState(ConnectionState newState) {
     return;
   }
 
+  crankshaft::diagnostics::FlightRecorder::instance().record(
+      crankshaft::diagnostics::flight::Event::AaState, static_cast<uint16_t>(newState),
+      static_cast<uint32_t>(m_state));
   m_state = newState;
   emit connectionStateChanged(newState);
 
@@ -1592,6 +1748,7 @@ void RealAndroidAutoService::updateSessionHeartbeat() {
 }
 
 void RealAndroidAutoService::onVideoChannelUpdate(const QByteArray& data, int width, int height) {
+  capturePayload(m_captureVideoStream, data);
   if (!m_channelConfig.videoEnabled) {
     return;
   }
@@ -1618,6 +1775,7 @@ void RealAndroidAutoService::onVideoChannelUpdate(const QByteArray& data, int wi
 }
 
 void RealAndroidAutoService::onMediaAudioChannelUpdate(const QByteArray& data) {
+  capturePayload(m_captureMediaAudioStream, data);
   if (!m_channelConfig.mediaAudioEnabled || !m_audioEnabled) {
     return;
   }
@@ -1637,6 +1795,7 @@ void RealAndroidAutoService::onMediaAudioChannelUpdate(const QByteArray& data) {
 }
 
 void RealAndroidAutoService::onSystemAudioChannelUpdate(const QByteArray& data) {
+  capturePayload(m_captureSystemAudioStream, data);
   if (!m_channelConfig.systemAudioEnabled || !m_audioEnabled) {
     return;
   }
@@ -1656,6 +1815,7 @@ void RealAndroidAutoService::onSystemAudioChannelUpdate(const QByteArray& data)
 }
 
 void RealAndroidAutoService::onSpeechAudioChannelUpdate(const QByteArray& data) {
+  capturePayload(m_captureSpeechAudioStream, data);
   if (!m_channelConfig.speechAudioEnabled || !m_audioEnabled) {
     return;
   }
@@ -1674,14 +1834,100 @@ void RealAndroidAutoService::onSpeechAudioChannelUpdate(const QByteArray& data)
   }
 }
 
-void RealAndroidAutoService::onSensorRequest() {
-  if (!m_channelConfig.sensorEnabled) {
+void RealAndroidAutoService::startSensorChannel() {
+  // The handler runs on the strand; the feeder and the service live on this object's thread
+  QPointer<RealAndroidAutoService> self(this);
+  auto handler = std::make_shared<SensorSourceServiceEventHandler>(
+      m_sensorChannel, *m_strand,
+      [self](int sensorType, qint64 minUpdatePeriodMs) {
+        QMetaObject::invokeMethod(
+            self.data(),
+            [self, sensorType, minUpdatePeriodMs]() {
+              if (self) {
+                self->onSensorRequest(sensorType, minUpdatePeriodMs);
+              }
+            },
+            Qt::QueuedConnection);
+      },
+      [self](const QString& error) {
+        QMetaObject::invokeMethod(
+            self.data(),
+            [self, error]() {
+              if (self) {
+                self->onChannelError("sensor", error);
+              }
+            },
+            Qt::QueuedConnection);
+      });
+  handler->start();
+  m_sensorHandler = handler;
+}
+
+void RealAndroidAutoService::onSensorRequest(int sensorType, qint64 minUpdatePeriodMs) {
+  if (!m_channelConfig.sensorEnabled || !m_sensorChannel) {
     return;
   }
 
   // Android device is requesting sensor data (GPS, speed, night mode, etc)
-  // TODO: Implement sensor data collection and transmission
-  Logger::instance().debug("Sensor data requested by Android device");
+  const auto sensor = static_cast<SensorFeeder::Sensor>(sensorType);
+  const bool supported = m_sensorFeeder->requestSensor(sensor, minUpdatePeriodMs);
+  Logger::instance().debug(QString("Sensor %1 requested by Android device every %2 ms%3")
+                               .arg(sensorType)
+                               .arg(minUpdatePeriodMs)
+                               .arg(supported ? "" : " (not available)"));
+
+  try {
+    using namespace crankshaft::protocol;
+
+    auto promise = aasdk::channel::SendPromise::defer(*m_strand);
+    promise->then([]() {},
+                  [sensorType](const aasdk::error::Error& error) {
+                    Logger::instance().warning(
+                        QString("Failed to send sensor %1 start response: %2")
+                            .arg(sensorType)
+                            .arg(QString::fromStdString(error.what())));
+                  });
+    m_sensorChannel->sendSensorStartResponse(createSensorStartResponse(supported),
+                                             std::move(promise));
+  } catch (const std::exception& e) {
+    Logger::instance().error(QString("Failed to answer sensor request: %1").arg(e.what()));
+    return;
+  }
+
+  // The current value follows the response
+  if (supported) {
+    m_sensorFeeder->flush(monotonicNs());
+  }
+}
+
+void RealAndroidAutoService::sendSensorBatch(const SensorFeeder::Batch& batch) {
+  if (!m_sensorChannel || !m_strand) {
+    return;
+  }
+
+  // The handler owns copies of the batch, the channel and the message:
+  // cleanupChannels() resets the members on this thread while it may still
+  // be queued. Encoding and sending both happen on the strand, so the reused
+  // message is never touched from two threads.
+  auto* strand = m_strand.get();
+  strand->dispatch([strand, batch, channel = m_sensorChannel,
+                    message = m_sensorBatchMessage]() {
+    try {
+      using namespace crankshaft::protocol;
+
+      encodeSensorBatch(batch, message.get());
+
+      auto promise = aasdk::channel::SendPromise::defer(*strand);
+      promise->then([]() {},
+                    [](const aasdk::error::Error& error) {
+                      Logger::instance().warning(QString("Failed to send sensor batch: %1")
+                                                     .arg(QString::fromStdString(error.what())));
+                    });
+      channel->sendSensorEventIndication(*message, std::move(promise));
+    } catch (const std::exception& e) {
+      Logger::instance().error(QString("Failed to send sensor batch: %1").arg(e.what()));
+    }
+  });
 }
 
 void RealAndroidAutoService::onBluetoothPairingRequest(const QString& deviceName) {
@@ -27,6 +27,7 @@ class QTimer;
 #include "../../hal/multimedia/IAudioMixer.h"
 #include "../../hal/multimedia/IVideoDecoder.h"
 #include "AndroidAutoService.h"
+#include "SensorFeeder.h"
 
 // Forward declarations
 class SessionStore;
@@ -85,6 +86,22 @@ class ControlServiceChannel;
 }  // namespace channel
 }  // namespace aasdk
 
+namespace aap_protobuf {
+namespace service {
+namespace sensorsource {
+namespace message {
+class SensorBatch;
+}  // namespace message
+}  // namespace sensorsource
+}  // namespace service
+}  // namespace aap_protobuf
+
+namespace crankshaft {
+namespace diagnostics {
+class CaptureWriter;
+}
+}  // namespace crankshaft
+
 // Boost.Asio types included via headers
 
 class MediaPipeline;
@@ -116,6 +133,16 @@ class RealAndroidAutoService : public AndroidAutoService {
     m_eventBus = eventBus;
   }
 
+  /**
+   * @brief Source of the sensor channel's data
+   *
+   * ServiceManager connects the vehicle state, night mode and driving mode
+   * to it; the phone picks which sensors it wants and how often.
+   */
+  SensorFeeder* sensorFeeder() const override {
+    return m_sensorFeeder;
+  }
+
   bool initialise() override;
   void deinitialise() override;
 
@@ -209,10 +236,19 @@ class RealAndroidAutoService : public AndroidAutoService {
   void onMediaAudioChannelUpdate(const QByteArray& data);
   void onSystemAudioChannelUpdate(const QByteArray& data);
   void onSpeechAudioChannelUpdate(const QByteArray& data);
-  void onSensorRequest();
+  void onSensorRequest(int sensorType, qint64 minUpdatePeriodMs);
   void onBluetoothPairingRequest(const QString& deviceName);
   void onChannelError(const QString& channelName, const QString& error);
 
+  // Sensor channel: requests come in on the strand, output is encoded and sent there
+  void startSensorChannel();
+  void sendSensorBatch(const SensorFeeder::Batch& batch);
+
+  // Session recording ("capture.file"), replayed by ReplayAndroidAutoService
+  void startCapture(const QString& path);
+  void capturePayload(int stream, const QByteArray& data);
+  void captureInput(quint16 type, int action, int x, int y, int keyCode);
+
   // Audio routing for AA channels
   void routeMediaAudioToVehicle(const QByteArray& audioData);
   void routeGuidanceAudioToVehicle(const QByteArray& audioData);
@@ -263,6 +299,14 @@ class RealAndroidAutoService : public AndroidAutoService {
   quint16 m_wirelessPort{5277};
   bool m_wirelessEnabled{false};
 
+  // Session capture; appended to from whichever thread delivers a payload
+  std::unique_ptr<crankshaft::diagnostics::CaptureWriter> m_capture;
+  int m_captureVideoStream{-1};
+  int m_captureMediaAudioStream{-1};
+  int m_captureSystemAudioStream{-1};
+  int m_captureSpeechAudioStream{-1};
+  int m_captureInputStream{-1};
+
   // Strands for channel operations
   std::unique_ptr<boost::asio::io_service::strand> m_strand;
 
@@ -292,7 +336,12 @@ class RealAndroidAutoService : public AndroidAutoService {
       m_speechAudioChannel;
   std::shared_ptr<aasdk::channel::inputsource::InputSourceService> m_inputChannel;
   std::shared_ptr<aasdk::channel::sensorsource::SensorSourceService> m_sensorChannel;
+  std::shared_ptr<aasdk::channel::sensorsource::ISensorSourceServiceEventHandler> m_sensorHandler;
   std::shared_ptr<aasdk::channel::bluetooth::BluetoothService> m_bluetoothChannel;
+  SensorFeeder* m_sensorFeeder{nullptr};
+  // Reused for every sensor batch; only touched on m_strand, which holds its own reference
+  std::shared_ptr<aap_protobuf::service::sensorsource::message::SensorBatch>
+      m_sensorBatchMessage;
   std::shared_ptr<aasdk::channel::control::ControlServiceChannel> m_controlChannel;
 
   // Multimedia components
@@ -0,0 +1,403 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReplayAndroidAutoService.h"
+
+#include <QFileInfo>
+#include <QJsonObject>
+#include <cstring>
+
+#include "../../hal/multimedia/IAudioMixer.h"
+#include "../../hal/multimedia/IVideoDecoder.h"
+#include "../logging/Logger.h"
+
+namespace {
+
+constexpr int kMaxRecordsPerPass = 64;
+
+constexpr IAudioMixer::ChannelId kAudioChannels[3] = {
+    IAudioMixer::ChannelId::MEDIA, IAudioMixer::ChannelId::SYSTEM, IAudioMixer::ChannelId::SPEECH};
+
+}  // namespace
+
+using crankshaft::diagnostics::CaptureReader;
+namespace capture = crankshaft::diagnostics::capture;
+
+ReplayAndroidAutoService::ReplayAndroidAutoService(QObject* parent) : AndroidAutoService(parent) {
+  m_device.manufacturer = "Crankshaft";
+  m_device.model = "Session replay";
+  m_device.connected = false;
+  m_device.projectionMode = ProjectionMode::PROJECTION;
+
+  m_replayTimer = new QTimer(this);
+  m_replayTimer->setSingleShot(true);
+  m_replayTimer->setTimerType(Qt::PreciseTimer);
+  m_statsTimer = new QTimer(this);
+
+  connect(m_replayTimer, &QTimer::timeout, this, &ReplayAndroidAutoService::onReplayTimer);
+  connect(m_statsTimer, &QTimer::timeout, this, &ReplayAndroidAutoService::onStatsTimer);
+}
+
+ReplayAndroidAutoService::~ReplayAndroidAutoService() {
+  deinitialise();
+}
+
+void ReplayAndroidAutoService::configureTransport(const QMap<QString, QVariant>& settings) {
+  m_replayFile = settings.value("replay.file").toString();
+  m_speed = settings.value("replay.speed", 1.0).toDouble();
+  m_loop = settings.value("replay.loop", false).toBool();
+  Logger::instance().info(QString("[ReplayAndroidAutoService] Replaying %1 (speed %2%3)")
+                              .arg(m_replayFile)
+                              .arg(m_speed)
+                              .arg(m_loop ? ", looping" : ""));
+}
+
+bool ReplayAndroidAutoService::initialise() {
+  if (m_reader.isOpen()) {
+    return false;
+  }
+
+  QString error;
+  if (!m_reader.open(m_replayFile, &error)) {
+    Logger::instance().error(QString("[ReplayAndroidAutoService] %1").arg(error));
+    emit errorOccurred(QString("Replay failed: %1").arg(error));
+    return false;
+  }
+
+  m_videoStream = m_reader.streamId(kCaptureVideoStream);
+  m_audioStreams[0] = m_reader.streamId(kCaptureMediaAudioStream);
+  m_audioStreams[1] = m_reader.streamId(kCaptureSystemAudioStream);
+  m_audioStreams[2] = m_reader.streamId(kCaptureSpeechAudioStream);
+  m_inputStream = m_reader.streamId(kCaptureInputStream);
+  if (m_videoStream >= 0) {
+    const capture::StreamInfo& video = m_reader.streams().at(m_videoStream);
+    if (video.params[0] > 0 && video.params[1] > 0) {
+      m_resolution = QSize(video.params[0], video.params[1]);
+    }
+    if (video.params[2] > 0) {
+      m_fps = video.params[2];
+    }
+  }
+
+  m_device.serialNumber = QString("REPLAY:%1").arg(QFileInfo(m_replayFile).fileName());
+  Logger::instance().info(
+      QString("[ReplayAndroidAutoService] %1: %2 s, %3 chunks, video %4x%5@%6%7")
+          .arg(m_replayFile)
+          .arg(m_reader.durationNs() / 1e9, 0, 'f', 1)
+          .arg(m_reader.chunks().size())
+          .arg(m_resolution.width())
+          .arg(m_resolution.height())
+          .arg(m_fps)
+          .arg(m_reader.hadIndex() ? "" : " (index rebuilt)"));
+  return true;
+}
+
+void ReplayAndroidAutoService::deinitialise() {
+  stopSearching();
+  if (isConnected()) {
+    disconnect();
+  }
+  m_reader.close();
+  m_hasPending = false;
+  transitionToState(ConnectionState::DISCONNECTED);
+}
+
+bool ReplayAndroidAutoService::startSearching() {
+  if (!m_reader.isOpen() ||
+      (m_state != ConnectionState::DISCONNECTED && m_state != ConnectionState::SEARCHING)) {
+    return false;
+  }
+
+  transitionToState(ConnectionState::SEARCHING);
+
+  // The recorded phone is always there: find it and connect straight away
+  QTimer::singleShot(0, this, [this]() {
+    if (m_state == ConnectionState::SEARCHING) {
+      emit deviceFound(m_device);
+      connectToDevice(m_device.serialNumber);
+    }
+  });
+  return true;
+}
+
+void ReplayAndroidAutoService::stopSearching() {
+  if (m_state == ConnectionState::SEARCHING) {
+    transitionToState(ConnectionState::DISCONNECTED);
+  }
+}
+
+bool ReplayAndroidAutoService::connectToDevice(const QString& serial) {
+  if (m_state != ConnectionState::SEARCHING && m_state != ConnectionState::DISCONNECTED) {
+    return false;
+  }
+  if (!m_reader.isOpen() || serial != m_device.serialNumber) {
+    emit errorOccurred("Unknown device: " + serial);
+    return false;
+  }
+
+  transitionToState(ConnectionState::CONNECTING);
+  setupMedia();
+  m_device.connected = true;
+  transitionToState(ConnectionState::CONNECTED);
+  emit connected(m_device);
+
+  m_finished = false;
+  m_droppedFrames = 0;
+  m_framesSinceStats = 0;
+  restart();
+  m_replayTimer->start(0);
+  m_statsTimer->start(1000);
+  return true;
+}
+
+bool ReplayAndroidAutoService::disconnect() {
+  if (m_state == ConnectionState::DISCONNECTED) {
+    return false;
+  }
+
+  m_replayTimer->stop();
+  m_statsTimer->stop();
+  transitionToState(ConnectionState::DISCONNECTING);
+  m_device.connected = false;
+  transitionToState(ConnectionState::DISCONNECTED);
+  emit disconnected();
+  return true;
+}
+
+bool ReplayAndroidAutoService::setDisplayResolution(const QSize& resolution) {
+  if (resolution.width() <= 0 || resolution.height() <= 0) {
+    return false;
+  }
+  m_resolution = resolution;
+  return true;
+}
+
+bool ReplayAndroidAutoService::setFramerate(int fps) {
+  if (fps <= 0 || fps > 60) {
+    return false;
+  }
+  m_fps = fps;
+  return true;
+}
+
+bool ReplayAndroidAutoService::sendTouchInput(int x, int y, int action) {
+  Q_UNUSED(x);
+  Q_UNUSED(y);
+  Q_UNUSED(action);
+  return isConnected();  // nobody on the other end to send it to
+}
+
+bool ReplayAndroidAutoService::sendKeyInput(int key_code, int action) {
+  Q_UNUSED(key_code);
+  Q_UNUSED(action);
+  return isConnected();
+}
+
+bool ReplayAndroidAutoService::requestAudioFocus() {
+  return isConnected();
+}
+
+bool ReplayAndroidAutoService::abandonAudioFocus() {
+  return isConnected();
+}
+
+bool ReplayAndroidAutoService::setAudioEnabled(bool enabled) {
+  m_audioEnabled = enabled;
+  return true;
+}
+
+QJsonObject ReplayAndroidAutoService::getAudioConfig() const {
+  QJsonObject config;
+  config["sampleRate"] = 48000;
+  config["channels"] = 2;
+  config["bitsPerSample"] = 16;
+  config["codec"] = "PCM";
+  return config;
+}
+
+void ReplayAndroidAutoService::setVideoDecoder(IVideoDecoder* decoder) {
+  if (m_videoDecoder) {
+    QObject::disconnect(m_videoDecoder, nullptr, this, nullptr);
+  }
+  m_videoDecoder = decoder;
+  m_mediaReady = false;
+}
+
+void ReplayAndroidAutoService::setAudioMixer(IAudioMixer* mixer) {
+  if (m_audioMixer) {
+    QObject::disconnect(m_audioMixer, nullptr, this, nullptr);
+  }
+  m_audioMixer = mixer;
+  m_mediaReady = false;
+}
+
+void ReplayAndroidAutoService::setupMedia() {
+  if (m_mediaReady) {
+    return;
+  }
+  m_mediaReady = true;
+
+  if (m_videoDecoder && m_videoStream >= 0) {
+    IVideoDecoder::DecoderConfig config;
+    config.codec = IVideoDecoder::CodecType::H264;
+    config.width = m_resolution.width();
+    config.height = m_resolution.height();
+    config.fps = m_fps;
+    config.outputFormat = IVideoDecoder::PixelFormat::RGBA;
+    config.hardwareAcceleration = true;
+    if (m_videoDecoder->isReady() || m_videoDecoder->initialize(config)) {
+      connect(m_videoDecoder, &IVideoDecoder::frameDecoded, this,
+              [this](int width, int height, const uint8_t* data, int size) {
+                emit videoFrameReady(width, height, data, size);
+              });
+    } else {
+      Logger::instance().warning(
+          "[ReplayAndroidAutoService] Video decoder failed to initialise; emitting raw units");
+    }
+  }
+
+  if (m_audioMixer) {
+    IAudioMixer::AudioFormat master;  // 48 kHz stereo, as RealAndroidAutoService
+    if (!m_audioMixer->initialize(master)) {
+      Logger::instance().warning(
+          "[ReplayAndroidAutoService] Audio mixer failed to initialise; emitting raw audio");
+      m_audioMixer = nullptr;
+      return;
+    }
+    for (int i = 0; i < 3; ++i) {
+      if (m_audioStreams[i] < 0) {
+        continue;
+      }
+      const capture::StreamInfo& stream = m_reader.streams().at(m_audioStreams[i]);
+      IAudioMixer::ChannelConfig channel;
+      channel.id = kAudioChannels[i];
+      channel.priority = i + 1;
+      if (stream.params[0] > 0) {
+        channel.format = {stream.params[0], stream.params[1], stream.params[2]};
+      }
+      m_audioMixer->addChannel(channel);
+    }
+    connect(m_audioMixer, &IAudioMixer::audioMixed, this,
+            &ReplayAndroidAutoService::audioDataReady);
+  }
+}
+
+void ReplayAndroidAutoService::restart() {
+  m_reader.rewind();
+  m_hasPending = m_reader.next(&m_pending);
+  m_clock.start(m_hasPending ? m_pending.timestampNs : 0, m_speed);
+}
+
+void ReplayAndroidAutoService::onReplayTimer() {
+  int records = 0;
+  while (isConnected() && m_hasPending) {
+    const qint64 waitNs = m_clock.untilDue(m_pending.timestampNs);
+    if (waitNs > 0) {
+      m_replayTimer->start(static_cast<int>((waitNs + 999999) / 1000000));
+      return;
+    }
+
+    // Read ahead first: dispatching may disconnect, which stops the replay
+    const CaptureReader::Record record = m_pending;
+    m_hasPending = m_reader.next(&m_pending);
+    if (!m_hasPending && m_loop) {
+      ++m_stats.loops;
+      restart();
+    }
+    dispatch(record);
+
+    if (++records >= kMaxRecordsPerPass) {
+      if (isConnected()) {
+        m_replayTimer->start(0);  // let the event loop and the decoder run
+      }
+      return;
+    }
+  }
+
+  if (isConnected() && !m_hasPending && !m_finished) {
+    m_finished = true;
+    Logger::instance().info(QString("[ReplayAndroidAutoService] Replay finished: %1 video units, "
+                                    "%2 audio chunks, %3 input events")
+                                .arg(m_stats.videoUnits)
+                                .arg(m_stats.audioChunks)
+                                .arg(m_stats.inputEvents));
+    emit replayFinished();
+  }
+}
+
+void ReplayAndroidAutoService::dispatch(const CaptureReader::Record& record) {
+  m_stats.bytes += record.size;
+
+  if (record.stream == m_videoStream) {
+    ++m_stats.videoUnits;
+    ++m_framesSinceStats;
+    if (m_videoDecoder && m_videoDecoder->isReady()) {
+      if (!m_videoDecoder->decodeFrame(QByteArray(record.data, record.size))) {
+        ++m_droppedFrames;
+      }
+    } else {
+      emit videoFrameReady(m_resolution.width(), m_resolution.height(),
+                           reinterpret_cast<const uint8_t*>(record.data),
+                           static_cast<int>(record.size));
+    }
+    return;
+  }
+
+  if (record.stream == m_inputStream && record.size >= sizeof(capture::InputEvent)) {
+    ++m_stats.inputEvents;
+    capture::InputEvent event;
+    memcpy(&event, record.data, sizeof(event));
+    if (static_cast<capture::InputType>(event.type) == capture::InputType::Touch) {
+      emit touchReplayed(event.x, event.y, event.action);
+    } else {
+      emit keyReplayed(event.keyCode, event.action);
+    }
+    return;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    if (record.stream != m_audioStreams[i]) {
+      continue;
+    }
+    ++m_stats.audioChunks;
+    if (!m_audioEnabled) {
+      return;
+    }
+    const QByteArray chunk(record.data, record.size);
+    if (m_audioMixer) {
+      m_audioMixer->mixAudioData(kAudioChannels[i], chunk);
+    } else {
+      emit audioDataReady(chunk);
+    }
+    return;
+  }
+}
+
+void ReplayAndroidAutoService::onStatsTimer() {
+  emit statsUpdated(m_framesSinceStats, 0, m_droppedFrames);
+  m_framesSinceStats = 0;
+}
+
+void ReplayAndroidAutoService::transitionToState(ConnectionState newState) {
+  if (m_state == newState) {
+    return;
+  }
+  m_state = newState;
+  emit connectionStateChanged(newState);
+}
@@ -0,0 +1,166 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QTimer>
+
+#include "../diagnostics/CaptureReader.h"
+#include "AndroidAutoService.h"
+
+class IVideoDecoder;
+class IAudioMixer;
+
+/**
+ * @brief Android Auto service that plays back a recorded session
+ *
+ * Replays a capture taken by RealAndroidAutoService ("capture.file"): video
+ * access units go to the video decoder, audio chunks to the mixer on their
+ * channels, and recorded input events come back as touchReplayed() and
+ * keyReplayed(). The session connects on its own once searching starts, so
+ * the rest of the system sees a phone that plugged in and started
+ * projecting. Pacing is the recorded one scaled by "replay.speed", or as
+ * fast as possible with 0, for benchmarks and deterministic tests.
+ *
+ * Without a decoder or mixer the payloads are emitted raw: videoFrameReady()
+ * then carries the encoded access unit and audioDataReady() the PCM chunk.
+ *
+ * Settings (configureTransport):
+ *   - "replay.file": Capture to play
+ *   - "replay.speed": 1.0 for real time (default), 0 for as fast as possible
+ *   - "replay.loop": Start over at the end (bool, default false)
+ */
+class ReplayAndroidAutoService : public AndroidAutoService {
+  Q_OBJECT
+
+ public:
+  struct Stats {
+    quint64 videoUnits{0};
+    quint64 audioChunks{0};
+    quint64 inputEvents{0};
+    quint64 bytes{0};
+    quint64 loops{0};
+  };
+
+  explicit ReplayAndroidAutoService(QObject* parent = nullptr);
+  ~ReplayAndroidAutoService() override;
+
+  void configureTransport(const QMap<QString, QVariant>& settings) override;
+
+  bool initialise() override;
+  void deinitialise() override;
+
+  ConnectionState getConnectionState() const override {
+    return m_state;
+  }
+  bool isConnected() const override {
+    return m_state == ConnectionState::CONNECTED;
+  }
+  AndroidDevice getConnectedDevice() const override {
+    return m_device;
+  }
+
+  bool startSearching() override;
+  void stopSearching() override;
+  bool connectToDevice(const QString& serial) override;
+  bool disconnect() override;
+
+  bool setDisplayResolution(const QSize& resolution) override;
+  QSize getDisplayResolution() const override {
+    return m_resolution;
+  }
+
+  bool setFramerate(int fps) override;
+  int getFramerate() const override {
+    return m_fps;
+  }
+
+  bool sendTouchInput(int x, int y, int action) override;
+  bool sendKeyInput(int key_code, int action) override;
+
+  bool requestAudioFocus() override;
+  bool abandonAudioFocus() override;
+
+  int getFrameDropCount() const override {
+    return m_droppedFrames;
+  }
+  int getLatency() const override {
+    return 0;
+  }
+
+  bool setAudioEnabled(bool enabled) override;
+  QJsonObject getAudioConfig() const override;
+
+  // Sinks for the replayed payloads, initialised on connect; not owned
+  void setVideoDecoder(IVideoDecoder* decoder);
+  void setAudioMixer(IAudioMixer* mixer);
+
+  Stats replayStats() const {
+    return m_stats;
+  }
+
+ signals:
+  void touchReplayed(int x, int y, int action);
+  void keyReplayed(int keyCode, int action);
+
+  /**
+   * @brief Emitted after the last record; the session stays connected
+   */
+  void replayFinished();
+
+ private slots:
+  void onReplayTimer();
+  void onStatsTimer();
+
+ private:
+  void restart();
+  void setupMedia();
+  void dispatch(const crankshaft::diagnostics::CaptureReader::Record& record);
+  void transitionToState(ConnectionState newState);
+
+  ConnectionState m_state{ConnectionState::DISCONNECTED};
+  AndroidDevice m_device;
+  QSize m_resolution{1024, 600};
+  int m_fps{30};
+  bool m_audioEnabled{true};
+
+  QString m_replayFile;
+  double m_speed{1.0};
+  bool m_loop{false};
+
+  crankshaft::diagnostics::CaptureReader m_reader;
+  crankshaft::diagnostics::ReplayClock m_clock;
+  crankshaft::diagnostics::CaptureReader::Record m_pending;
+  bool m_hasPending{false};
+  bool m_finished{false};
+  int m_videoStream{-1};
+  int m_audioStreams[3]{-1, -1, -1};  // media, system, speech
+  int m_inputStream{-1};
+
+  IVideoDecoder* m_videoDecoder{nullptr};
+  IAudioMixer* m_audioMixer{nullptr};
+  bool m_mediaReady{false};
+
+  int m_droppedFrames{0};
+  int m_framesSinceStats{0};
+  Stats m_stats;
+
+  QTimer* m_replayTimer{nullptr};
+  QTimer* m_statsTimer{nullptr};
+};
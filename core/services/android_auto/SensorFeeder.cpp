@@ -0,0 +1,235 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SensorFeeder.h"
+
+#include <time.h>
+
+#include <cmath>
+
+#include "../logging/Logger.h"
+
+namespace {
+
+// Used when the phone leaves the period at 0
+constexpr qint64 kDefaultLocationPeriodMs = 200;
+constexpr qint64 kDefaultCompassPeriodMs = 200;
+constexpr qint64 kDefaultSpeedPeriodMs = 100;
+
+qint64 clockNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+qint64 monotonicNs() {
+  return clockNs(CLOCK_MONOTONIC);
+}
+
+qint32 scaled(double value, double scale) {
+  return static_cast<qint32>(std::lround(value * scale));
+}
+
+}  // namespace
+
+SensorFeeder::SensorFeeder(QObject* parent)
+    : QObject(parent),
+      m_state{},
+      m_stateSerial(0),
+      m_nightMode(false),
+      m_driving(false),
+      m_batch{} {
+  qRegisterMetaType<SensorFeeder::Batch>();
+}
+
+SensorFeeder::~SensorFeeder() = default;
+
+bool SensorFeeder::isSupported(Sensor sensor) {
+  return slotFor(sensor) >= 0;
+}
+
+int SensorFeeder::slotFor(Sensor sensor) {
+  switch (sensor) {
+    case Sensor::Location:
+      return LocationSlot;
+    case Sensor::Compass:
+      return CompassSlot;
+    case Sensor::Speed:
+      return SpeedSlot;
+    case Sensor::NightMode:
+      return NightModeSlot;
+    case Sensor::DrivingStatus:
+      return DrivingStatusSlot;
+  }
+  return -1;
+}
+
+bool SensorFeeder::requestSensor(Sensor sensor, qint64 minPeriodMs) {
+  const int slot = slotFor(sensor);
+  if (slot < 0) {
+    Logger::instance().debug(
+        QString("[SensorFeeder] Sensor type %1 not provided").arg(static_cast<int>(sensor)));
+    return false;
+  }
+
+  if (minPeriodMs <= 0) {
+    minPeriodMs = slot == LocationSlot  ? kDefaultLocationPeriodMs
+                  : slot == CompassSlot ? kDefaultCompassPeriodMs
+                                        : kDefaultSpeedPeriodMs;
+  }
+
+  Subscription& subscription = m_subscriptions[slot];
+  subscription.active = true;
+  subscription.periodNs = qMax(minPeriodMs, kMinPeriodMs) * 1000000LL;
+  subscription.nextDueNs = 0;
+  subscription.sentSerial = 0;
+  // Event sensors report their current value straight away
+  subscription.pending = slot == NightModeSlot || slot == DrivingStatusSlot;
+
+  Logger::instance().info(QString("[SensorFeeder] Sensor type %1 started, every %2 ms")
+                              .arg(static_cast<int>(sensor))
+                              .arg(subscription.periodNs / 1000000));
+  return true;
+}
+
+void SensorFeeder::stopSensor(Sensor sensor) {
+  const int slot = slotFor(sensor);
+  if (slot >= 0) {
+    m_subscriptions[slot] = Subscription{};
+  }
+}
+
+void SensorFeeder::stopAll() {
+  m_subscriptions.fill(Subscription{});
+}
+
+bool SensorFeeder::isActive(Sensor sensor) const {
+  const int slot = slotFor(sensor);
+  return slot >= 0 && m_subscriptions[slot].active;
+}
+
+qint64 SensorFeeder::periodMs(Sensor sensor) const {
+  const int slot = slotFor(sensor);
+  return slot >= 0 ? m_subscriptions[slot].periodNs / 1000000 : 0;
+}
+
+SensorFeeder::Stats SensorFeeder::stats() const {
+  return m_stats;
+}
+
+void SensorFeeder::updateVehicleState(const VehicleState& state) {
+  m_state = state;
+  ++m_stateSerial;
+  ++m_stats.stateUpdates;
+  flush(state.timestampNs);
+}
+
+void SensorFeeder::setNightMode(bool night) {
+  if (night == m_nightMode) {
+    return;
+  }
+  m_nightMode = night;
+  m_subscriptions[NightModeSlot].pending = m_subscriptions[NightModeSlot].active;
+  flush(monotonicNs());
+}
+
+void SensorFeeder::setDriving(bool driving) {
+  if (driving == m_driving) {
+    return;
+  }
+  m_driving = driving;
+  m_subscriptions[DrivingStatusSlot].pending = m_subscriptions[DrivingStatusSlot].active;
+  flush(monotonicNs());
+}
+
+bool SensorFeeder::periodicDue(Subscription& subscription, qint64 nowNs, bool valid) {
+  if (!subscription.active || !valid || subscription.sentSerial == m_stateSerial ||
+      nowNs < subscription.nextDueNs) {
+    return false;
+  }
+  subscription.sentSerial = m_stateSerial;
+  subscription.nextDueNs = nowNs + subscription.periodNs - kScheduleSlackNs;
+  return true;
+}
+
+void SensorFeeder::fillLocation(Batch& batch) const {
+  // The state is stamped on the monotonic clock; the phone wants wall time
+  const qint64 ageNs = monotonicNs() - m_state.timestampNs;
+  batch.timestampMs = static_cast<quint64>((clockNs(CLOCK_REALTIME) - ageNs) / 1000000);
+  batch.latitudeE7 = scaled(m_state.latitude, 1e7);
+  batch.longitudeE7 = scaled(m_state.longitude, 1e7);
+  batch.accuracyE3 = static_cast<quint32>(std::lround(m_state.positionAccuracy * 1e3));
+}
+
+void SensorFeeder::flush(qint64 nowNs) {
+  Batch& batch = m_batch;
+  batch.fields = 0;
+  int samples = 0;
+
+  const bool positionValid = m_state.flags & VehicleState::PositionValid;
+  const bool headingValid = m_state.flags & VehicleState::HeadingValid;
+  const bool speedValid = m_state.flags & VehicleState::SpeedValid;
+
+  if (periodicDue(m_subscriptions[LocationSlot], nowNs, positionValid)) {
+    batch.fields |= Batch::HasLocation;
+    fillLocation(batch);
+    ++samples;
+  }
+  if (periodicDue(m_subscriptions[CompassSlot], nowNs, headingValid)) {
+    batch.fields |= Batch::HasCompass;
+    ++samples;
+  }
+  if (periodicDue(m_subscriptions[SpeedSlot], nowNs, speedValid)) {
+    batch.fields |= Batch::HasSpeed;
+    ++samples;
+  }
+  // Location carries speed and bearing too, whenever they are valid
+  if ((batch.fields & (Batch::HasLocation | Batch::HasSpeed)) && speedValid) {
+    batch.fields |= Batch::SpeedValid;
+    batch.speedE3 = scaled(m_state.speed, 1e3);
+  }
+  if ((batch.fields & (Batch::HasLocation | Batch::HasCompass)) && headingValid) {
+    batch.fields |= Batch::BearingValid;
+    batch.bearingE6 = scaled(m_state.heading, 1e6);
+  }
+
+  Subscription& night = m_subscriptions[NightModeSlot];
+  if (night.active && night.pending) {
+    night.pending = false;
+    batch.fields |= Batch::HasNightMode;
+    batch.nightMode = m_nightMode;
+    ++samples;
+  }
+  Subscription& driving = m_subscriptions[DrivingStatusSlot];
+  if (driving.active && driving.pending) {
+    driving.pending = false;
+    batch.fields |= Batch::HasDrivingStatus;
+    batch.drivingStatus = m_driving ? kDrivingFullyRestricted : kDrivingUnrestricted;
+    ++samples;
+  }
+
+  if (samples == 0) {
+    return;
+  }
+  batch.timestampNs = nowNs;
+  ++m_stats.batches;
+  m_stats.samples += samples;
+  emit batchReady(batch);
+}
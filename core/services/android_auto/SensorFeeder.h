@@ -0,0 +1,175 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QMetaType>
+#include <QObject>
+#include <array>
+#include <type_traits>
+
+#include "../vehicle/VehicleStateFilter.h"
+
+/**
+ * @brief Paces vehicle sensor data for the Android Auto sensor channel
+ *
+ * The phone starts each sensor it wants with a minimum update period. The
+ * feeder keeps the latest fused VehicleState, night mode and driving state,
+ * and hands the sensors that are due to batchReady() as one plain Batch,
+ * which the AA service encodes into a single SensorBatch message.
+ *
+ * Location, compass and speed are periodic: each is sent once per its
+ * period (never more than kScheduleSlackNs early), only while the state
+ * says the value is valid and only when a newer state has arrived. Their
+ * schedules run on the state timestamps, so sensors with harmonic periods
+ * land in the same batch. Night mode and driving status are sent once when
+ * started and then on every change.
+ * A flush never touches the heap.
+ *
+ * Example:
+ *   connect(sensorFusion, &SensorFusionService::stateUpdated,
+ *           feeder, &SensorFeeder::updateVehicleState);
+ *   connect(drivingMode, &DrivingModeService::drivingModeChanged,
+ *           feeder, &SensorFeeder::setDriving);
+ *   connect(videoManager, &VideoManager::nightModeChanged,
+ *           feeder, &SensorFeeder::setNightMode);
+ *   // SensorRequest from the phone:
+ *   feeder->requestSensor(SensorFeeder::Sensor::Location, request.min_update_period());
+ */
+class SensorFeeder : public QObject {
+  Q_OBJECT
+
+ public:
+  // Values are the AA protocol's SensorType numbers
+  enum class Sensor : int {
+    Location = 1,
+    Compass = 2,
+    Speed = 3,
+    NightMode = 10,
+    DrivingStatus = 13,
+  };
+
+  // AA DrivingStatus values sent for parked and driving
+  static constexpr int kDrivingUnrestricted = 0;
+  static constexpr int kDrivingFullyRestricted = 31;
+
+  // Floor for requested periods: the fusion service's step
+  static constexpr qint64 kMinPeriodMs = 20;
+  // A periodic sensor counts as due this much early, so step timer jitter
+  // does not push every send back by a whole step
+  static constexpr qint64 kScheduleSlackNs = 5000000;
+
+  /**
+   * @brief One SensorBatch worth of values, already in AA units
+   */
+  struct Batch {
+    enum Field : quint8 {
+      HasLocation = 0x01,
+      HasCompass = 0x02,
+      HasSpeed = 0x04,
+      HasNightMode = 0x08,
+      HasDrivingStatus = 0x10,
+      SpeedValid = 0x20,    // speedE3 holds a value
+      BearingValid = 0x40,  // bearingE6 holds a value
+    };
+
+    quint8 fields;
+    quint64 timestampMs;  // Location time, milliseconds since the epoch
+    qint32 latitudeE7;    // Degrees * 1e7
+    qint32 longitudeE7;
+    quint32 accuracyE3;  // Metres * 1e3, one sigma
+    qint32 speedE3;      // m/s * 1e3, location and speed sensors
+    qint32 bearingE6;    // Degrees clockwise from north * 1e6
+    bool nightMode;
+    qint32 drivingStatus;
+    qint64 timestampNs;  // CLOCK_MONOTONIC time the batch was put together
+  };
+
+  struct Stats {
+    quint64 batches{0};
+    quint64 samples{0};  // sensor entries over all batches
+    quint64 stateUpdates{0};
+  };
+
+  explicit SensorFeeder(QObject* parent = nullptr);
+  ~SensorFeeder() override;
+
+  /**
+   * @brief Start a sensor the phone asked for
+   * @param minPeriodMs Phone's minimum update period; 0 picks a default
+   * @return False if the sensor is not one the feeder provides
+   */
+  bool requestSensor(Sensor sensor, qint64 minPeriodMs);
+  void stopSensor(Sensor sensor);
+  void stopAll();  // session ended
+  bool isActive(Sensor sensor) const;
+  qint64 periodMs(Sensor sensor) const;
+
+  static bool isSupported(Sensor sensor);
+
+  /**
+   * @brief Emit whatever is due at nowNs
+   *
+   * The input slots call this themselves; the AA service calls it after
+   * answering a sensor start so the first sample follows the response.
+   */
+  void flush(qint64 nowNs);
+
+  Stats stats() const;
+
+ public slots:
+  // Flushes at the state's own timestamp
+  void updateVehicleState(const VehicleState& state);
+  void setNightMode(bool night);
+  void setDriving(bool driving);
+
+ signals:
+  // Emitted synchronously; the receiver must encode the batch before returning
+  // or copy it
+  void batchReady(const SensorFeeder::Batch& batch);
+
+ private:
+  enum Slot { LocationSlot, CompassSlot, SpeedSlot, NightModeSlot, DrivingStatusSlot, kSlotCount };
+
+  struct Subscription {
+    bool active{false};
+    bool pending{false};  // event sensors: value to send
+    qint64 periodNs{0};
+    qint64 nextDueNs{0};
+    quint64 sentSerial{0};  // state serial last sent, periodic sensors
+  };
+
+  static int slotFor(Sensor sensor);
+  bool periodicDue(Subscription& subscription, qint64 nowNs, bool valid);
+  void fillLocation(Batch& batch) const;
+
+  std::array<Subscription, kSlotCount> m_subscriptions;
+  VehicleState m_state;
+  quint64 m_stateSerial;
+  bool m_nightMode;
+  bool m_driving;
+  Batch m_batch;
+  Stats m_stats;
+};
+
+static_assert(std::is_trivially_copyable<SensorFeeder::Batch>::value,
+              "SensorFeeder::Batch must stay plain data");
+
+Q_DECLARE_METATYPE(SensorFeeder::Batch)
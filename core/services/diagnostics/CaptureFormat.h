@@ -0,0 +1,166 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// On-disk layout of record/replay captures. Deliberately free of Qt so an
+// offline tool can share it, like FlightRecordFormat.h.
+//
+// A capture is a FileHeader followed by chunks written back to back. Each
+// chunk is a ChunkHeader and its records; a record is a RecordHeader and a
+// payload padded to 8 bytes, so every header in a mapped file is aligned
+// and can be read in place. Records never straddle chunks: one larger than
+// the chunk size gets a chunk of its own. Streams are declared in-band by a
+// record on kDefinitionStream carrying a StreamInfo, so a capture cut short
+// by a crash still decodes. A clean close appends an index (IndexHeader,
+// ChunkIndex entries, then StreamInfo entries) and points the file header
+// at it; without one, a reader rebuilds it by walking the chunk headers.
+// All fields are in host byte order.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace crankshaft {
+namespace diagnostics {
+namespace capture {
+
+enum class StreamKind : uint16_t {
+  Bytes = 0,      // raw transport bytes (UART, SLCAN, ...)
+  CanFrames = 1,  // CanFrameRecord array per record
+  Video = 2,      // one encoded access unit per record; params: width, height, fps
+  Audio = 3,      // PCM chunk per record; params: sample rate, channels, bits
+  Input = 4,      // one InputEvent per record
+};
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t chunkBytes;         // nominal chunk size, headers included
+  uint64_t startMonotonicNs;   // CLOCK_MONOTONIC at open; record times are relative to it
+  uint64_t startRealtimeNs;    // CLOCK_REALTIME at open, for humans
+  uint64_t indexOffset;        // 0 until closed cleanly
+  uint32_t chunkCount;         // valid with indexOffset
+  uint32_t pid;
+  uint64_t reserved[2];
+};
+static_assert(sizeof(FileHeader) == 64, "header layout is part of the file format");
+
+struct ChunkHeader {
+  char magic[4];
+  uint32_t records;
+  uint32_t bytes;  // record bytes following this header
+  uint32_t reserved;
+  uint64_t firstNs;
+  uint64_t lastNs;
+};
+static_assert(sizeof(ChunkHeader) == 32, "chunk layout is part of the file format");
+
+struct RecordHeader {
+  uint64_t timestampNs;  // since FileHeader::startMonotonicNs
+  uint32_t size;         // payload bytes, before padding
+  uint16_t stream;
+  uint16_t flags;
+};
+static_assert(sizeof(RecordHeader) == 16, "record layout is part of the file format");
+
+struct StreamInfo {
+  uint16_t id;
+  uint16_t kind;  // StreamKind
+  uint32_t reserved;
+  int32_t params[4];
+  char name[40];  // NUL-terminated
+};
+static_assert(sizeof(StreamInfo) == 64, "stream layout is part of the file format");
+
+struct IndexHeader {
+  char magic[8];
+  uint32_t chunks;
+  uint32_t streams;
+};
+static_assert(sizeof(IndexHeader) == 16, "index layout is part of the file format");
+
+struct ChunkIndex {
+  uint64_t offset;  // of the ChunkHeader
+  uint64_t firstNs;
+  uint64_t lastNs;
+  uint32_t records;
+  uint32_t bytes;
+};
+static_assert(sizeof(ChunkIndex) == 32, "index layout is part of the file format");
+
+struct CanFrameRecord {
+  uint64_t timestampNs;  // receive time, CLOCK_MONOTONIC of the recording host
+  uint32_t id;           // no flag bits
+  uint8_t length;
+  uint8_t flags;  // kCanExtended | kCanRtr | kCanFd | kCanBitRateSwitch
+  uint16_t reserved;
+  uint8_t data[64];
+};
+static_assert(sizeof(CanFrameRecord) == 80, "frame layout is part of the file format");
+static_assert(std::is_trivially_copyable_v<CanFrameRecord>);
+
+inline constexpr uint8_t kCanExtended = 0x01;
+inline constexpr uint8_t kCanRtr = 0x02;
+inline constexpr uint8_t kCanFd = 0x04;
+inline constexpr uint8_t kCanBitRateSwitch = 0x08;
+
+enum class InputType : uint16_t { Touch = 0, Key = 1 };
+
+struct InputEvent {
+  uint16_t type;    // InputType
+  uint16_t action;  // as passed to sendTouchInput()/sendKeyInput()
+  int32_t x;
+  int32_t y;
+  int32_t keyCode;
+};
+static_assert(sizeof(InputEvent) == 16, "input layout is part of the file format");
+
+inline constexpr char kMagic[8] = {'C', 'S', 'C', 'A', 'P', 'T', 'U', 'R'};
+inline constexpr char kChunkMagic[4] = {'C', 'H', 'N', 'K'};
+inline constexpr char kIndexMagic[8] = {'C', 'S', 'C', 'A', 'P', 'I', 'D', 'X'};
+inline constexpr uint32_t kVersion = 1;
+inline constexpr uint16_t kDefinitionStream = 0xffff;
+inline constexpr uint16_t kMaxStreams = 256;
+inline constexpr uint32_t kDefaultChunkBytes = 1024 * 1024;
+
+// 64-bit, so a corrupt size near 4 GiB cannot wrap to a small one
+constexpr uint64_t paddedSize(uint64_t size) {
+  return (size + 7u) & ~uint64_t{7};
+}
+
+inline const char* kindName(uint16_t kind) {
+  switch (static_cast<StreamKind>(kind)) {
+    case StreamKind::Bytes:
+      return "bytes";
+    case StreamKind::CanFrames:
+      return "can";
+    case StreamKind::Video:
+      return "video";
+    case StreamKind::Audio:
+      return "audio";
+    case StreamKind::Input:
+      return "input";
+  }
+  return "unknown";
+}
+
+}  // namespace capture
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,289 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CaptureReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+}  // namespace
+
+CaptureReader::~CaptureReader() {
+  close();
+}
+
+bool CaptureReader::open(const QString& path, QString* error) {
+  close();
+  auto fail = [this, error](const QString& message) {
+    if (error) *error = message;
+    close();
+    return false;
+  };
+
+  const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return fail(QString("cannot open %1: %2").arg(path, strerror(errno)));
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(m_header)) {
+    ::close(fd);
+    return fail(QString("%1 is not a capture").arg(path));
+  }
+  void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return fail(QString("cannot map %1: %2").arg(path, strerror(errno)));
+  }
+  ::madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+  m_path = path;
+  m_data = static_cast<const char*>(data);
+  m_size = static_cast<size_t>(info.st_size);
+
+  memcpy(&m_header, m_data, sizeof(m_header));
+  if (memcmp(m_header.magic, capture::kMagic, sizeof(capture::kMagic)) != 0) {
+    return fail(QString("%1 is not a capture").arg(path));
+  }
+  if (m_header.version != capture::kVersion) {
+    return fail(QString("%1 has unsupported capture version %2").arg(path).arg(m_header.version));
+  }
+
+  m_hadIndex = m_header.indexOffset != 0 && loadIndex();
+  if (!m_hadIndex) {
+    rebuildIndex();
+  }
+  rewind();
+  return true;
+}
+
+void CaptureReader::close() {
+  if (m_data) {
+    ::munmap(const_cast<char*>(m_data), m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_header = capture::FileHeader{};
+  m_streams.clear();
+  m_chunks.clear();
+  m_hadIndex = false;
+  rewind();
+}
+
+bool CaptureReader::isOpen() const {
+  return m_data != nullptr;
+}
+
+const capture::FileHeader& CaptureReader::header() const {
+  return m_header;
+}
+
+const QVector<capture::StreamInfo>& CaptureReader::streams() const {
+  return m_streams;
+}
+
+const QVector<capture::ChunkIndex>& CaptureReader::chunks() const {
+  return m_chunks;
+}
+
+int CaptureReader::streamId(const QString& name) const {
+  const QByteArray utf8 = name.toUtf8();
+  for (const capture::StreamInfo& stream : m_streams) {
+    if (qstrncmp(stream.name, utf8.constData(), sizeof(stream.name)) == 0) {
+      return stream.id;
+    }
+  }
+  return -1;
+}
+
+bool CaptureReader::hadIndex() const {
+  return m_hadIndex;
+}
+
+quint64 CaptureReader::durationNs() const {
+  return m_chunks.isEmpty() ? 0 : m_chunks.last().lastNs;
+}
+
+bool CaptureReader::loadIndex() {
+  const quint64 offset = m_header.indexOffset;
+  capture::IndexHeader index;
+  if (offset < sizeof(m_header) || offset + sizeof(index) > m_size) {
+    return false;
+  }
+  memcpy(&index, m_data + offset, sizeof(index));
+  const quint64 entries = offset + sizeof(index);
+  const quint64 streams = entries + quint64(index.chunks) * sizeof(capture::ChunkIndex);
+  if (memcmp(index.magic, capture::kIndexMagic, sizeof(index.magic)) != 0 ||
+      index.streams > capture::kMaxStreams ||
+      streams + quint64(index.streams) * sizeof(capture::StreamInfo) > m_size) {
+    return false;
+  }
+
+  m_chunks.resize(index.chunks);
+  memcpy(m_chunks.data(), m_data + entries, index.chunks * sizeof(capture::ChunkIndex));
+  for (const capture::ChunkIndex& chunk : m_chunks) {
+    if (chunk.offset < sizeof(m_header) ||
+        chunk.offset + sizeof(capture::ChunkHeader) + chunk.bytes > offset) {
+      m_chunks.clear();
+      return false;
+    }
+  }
+  m_streams.resize(index.streams);
+  memcpy(m_streams.data(), m_data + streams, index.streams * sizeof(capture::StreamInfo));
+  return true;
+}
+
+bool CaptureReader::rebuildIndex() {
+  m_chunks.clear();
+  m_streams.clear();
+  quint64 offset = sizeof(m_header);
+  while (offset + sizeof(capture::ChunkHeader) <= m_size) {
+    capture::ChunkHeader chunk;
+    memcpy(&chunk, m_data + offset, sizeof(chunk));
+    const quint64 begin = offset + sizeof(chunk);
+    const quint64 end = begin + chunk.bytes;
+    if (memcmp(chunk.magic, capture::kChunkMagic, sizeof(chunk.magic)) != 0 || end > m_size) {
+      break;  // the index, or a chunk the writer never finished
+    }
+    m_chunks.append({offset, chunk.firstNs, chunk.lastNs, chunk.records, chunk.bytes});
+
+    // Stream definitions are the only records the index needs
+    for (quint64 record = begin; record + sizeof(capture::RecordHeader) <= end;) {
+      capture::RecordHeader header;
+      memcpy(&header, m_data + record, sizeof(header));
+      const quint64 payload = record + sizeof(header);
+      record = payload + capture::paddedSize(header.size);
+      if (record > end) {
+        break;  // corrupt size: the chunk's remaining records are lost
+      }
+      if (header.stream == capture::kDefinitionStream &&
+          header.size == sizeof(capture::StreamInfo)) {
+        capture::StreamInfo info;
+        memcpy(&info, m_data + payload, sizeof(info));
+        info.name[sizeof(info.name) - 1] = '\0';
+        m_streams.append(info);
+      }
+    }
+    offset = end;
+  }
+  return !m_chunks.isEmpty();
+}
+
+bool CaptureReader::next(Record* record, int stream) {
+  for (;;) {
+    if (m_offset >= m_chunkEnd) {
+      if (m_chunk + 1 >= m_chunks.size()) {
+        return false;
+      }
+      const capture::ChunkIndex& chunk = m_chunks.at(++m_chunk);
+      m_offset = chunk.offset + sizeof(capture::ChunkHeader);
+      m_chunkEnd = m_offset + chunk.bytes;
+      continue;
+    }
+
+    // Corrupt record (header or payload past the chunk): give up on the rest of the chunk
+    capture::RecordHeader header;
+    if (m_offset + sizeof(header) > m_chunkEnd) {
+      m_offset = m_chunkEnd;
+      continue;
+    }
+    memcpy(&header, m_data + m_offset, sizeof(header));
+    const quint64 payload = m_offset + sizeof(header);
+    const quint64 next = payload + capture::paddedSize(header.size);
+    if (next > m_chunkEnd) {
+      m_offset = m_chunkEnd;
+      continue;
+    }
+    m_offset = next;
+    if (header.stream == capture::kDefinitionStream || (stream >= 0 && header.stream != stream)) {
+      continue;
+    }
+
+    record->timestampNs = header.timestampNs;
+    record->stream = header.stream;
+    record->flags = header.flags;
+    record->data = m_data + payload;
+    record->size = header.size;
+    return true;
+  }
+}
+
+void CaptureReader::rewind() {
+  m_chunk = -1;
+  m_offset = 0;
+  m_chunkEnd = 0;
+}
+
+void CaptureReader::seek(quint64 timestampNs) {
+  const auto chunk = std::partition_point(
+      m_chunks.cbegin(), m_chunks.cend(),
+      [timestampNs](const capture::ChunkIndex& entry) { return entry.lastNs < timestampNs; });
+  rewind();
+  if (chunk == m_chunks.cend()) {
+    m_chunk = static_cast<int>(m_chunks.size());
+    return;
+  }
+  m_chunk = static_cast<int>(chunk - m_chunks.cbegin());
+  m_offset = chunk->offset + sizeof(capture::ChunkHeader);
+  m_chunkEnd = m_offset + chunk->bytes;
+
+  // Skip the chunk's records that are still too early
+  while (m_offset + sizeof(capture::RecordHeader) <= m_chunkEnd) {
+    capture::RecordHeader header;
+    memcpy(&header, m_data + m_offset, sizeof(header));
+    if (header.timestampNs >= timestampNs) {
+      break;
+    }
+    m_offset += sizeof(header) + capture::paddedSize(header.size);
+  }
+}
+
+void ReplayClock::start(quint64 firstNs, double speed) {
+  m_firstNs = firstNs;
+  m_startNs = monotonicNs();
+  m_speed = speed;
+}
+
+qint64 ReplayClock::untilDue(quint64 recordNs) const {
+  if (m_speed <= 0.0 || recordNs <= m_firstNs) {
+    return 0;
+  }
+  const qint64 due = m_startNs + static_cast<qint64>((recordNs - m_firstNs) / m_speed);
+  return qMax<qint64>(0, due - monotonicNs());
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
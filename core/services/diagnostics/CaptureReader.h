@@ -0,0 +1,131 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include "CaptureFormat.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Reads a capture written by CaptureWriter
+ *
+ * The file is mapped read-only and records are returned in place, so
+ * replaying a capture copies nothing until a consumer does. The index is
+ * used when the capture was closed cleanly; otherwise it is rebuilt by
+ * walking the chunk headers, and a torn last chunk is ignored.
+ */
+class CaptureReader {
+ public:
+  struct Record {
+    quint64 timestampNs{0};  // since the start of the capture
+    quint16 stream{0};
+    quint16 flags{0};
+    const char* data{nullptr};  // valid until close()
+    quint32 size{0};
+  };
+
+  CaptureReader() = default;
+  ~CaptureReader();
+  CaptureReader(const CaptureReader&) = delete;
+  CaptureReader& operator=(const CaptureReader&) = delete;
+
+  bool open(const QString& path, QString* error = nullptr);
+  void close();
+  bool isOpen() const;
+
+  const capture::FileHeader& header() const;
+  const QVector<capture::StreamInfo>& streams() const;
+  const QVector<capture::ChunkIndex>& chunks() const;
+
+  /**
+   * @brief Id of the stream called name, -1 if there is none
+   */
+  int streamId(const QString& name) const;
+
+  /**
+   * @brief False when the index had to be rebuilt (the writer did not close)
+   */
+  bool hadIndex() const;
+  quint64 durationNs() const;
+
+  /**
+   * @brief Next record, in time order
+   * @param stream Only this stream, or -1 for all
+   * @return false at the end of the capture
+   */
+  bool next(Record* record, int stream = -1);
+
+  void rewind();
+
+  /**
+   * @brief Continue from the first record at or after timestampNs
+   */
+  void seek(quint64 timestampNs);
+
+ private:
+  bool rebuildIndex();
+  bool loadIndex();
+
+  QString m_path;
+  const char* m_data{nullptr};
+  size_t m_size{0};
+  capture::FileHeader m_header{};
+  QVector<capture::StreamInfo> m_streams;
+  QVector<capture::ChunkIndex> m_chunks;
+  bool m_hadIndex{false};
+
+  int m_chunk{0};        // index into m_chunks
+  quint64 m_offset{0};   // of the next record in the file
+  quint64 m_chunkEnd{0};
+};
+
+/**
+ * @brief Maps capture time onto the monotonic clock for paced replay
+ */
+class ReplayClock {
+ public:
+  /**
+   * @brief Start replaying at the record stamped firstNs
+   * @param speed 1.0 for real time, 2.0 for twice as fast; 0 or less for as
+   *              fast as possible
+   */
+  void start(quint64 firstNs, double speed);
+
+  /**
+   * @brief Nanoseconds until the record stamped recordNs is due, 0 if now
+   */
+  qint64 untilDue(quint64 recordNs) const;
+
+  bool isPaced() const {
+    return m_speed > 0.0;
+  }
+
+ private:
+  quint64 m_firstNs{0};
+  qint64 m_startNs{0};
+  double m_speed{1.0};
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,294 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CaptureWriter.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <cerrno>
+#include <cstring>
+
+#include "../logging/Logger.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+// A partly filled chunk is written out after this long, bounding what a
+// crash can lose on a quiet stream
+constexpr unsigned long kFlushIntervalMs = 1000;
+constexpr quint32 kMinChunkBytes = 4096;
+
+quint64 clockNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<quint64>(ts.tv_sec) * 1000000000ULL + static_cast<quint64>(ts.tv_nsec);
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+}  // namespace
+
+CaptureWriter::~CaptureWriter() {
+  close();
+}
+
+bool CaptureWriter::open(const QString& path, quint32 chunkBytes, QString* error) {
+  close();
+
+  const int fd = ::open(QFile::encodeName(path).constData(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    if (error) *error = QString("cannot create %1: %2").arg(path, strerror(errno));
+    return false;
+  }
+
+  capture::FileHeader header{};
+  memcpy(header.magic, capture::kMagic, sizeof(header.magic));
+  header.version = capture::kVersion;
+  header.chunkBytes = qMax(chunkBytes, kMinChunkBytes);
+  header.startMonotonicNs = clockNs(CLOCK_MONOTONIC);
+  header.startRealtimeNs = clockNs(CLOCK_REALTIME);
+  header.pid = static_cast<uint32_t>(::getpid());
+  if (!writeAll(fd, &header, sizeof(header))) {
+    if (error) *error = QString("cannot write %1: %2").arg(path, strerror(errno));
+    ::close(fd);
+    return false;
+  }
+
+  QMutexLocker locker(&m_mutex);
+  m_path = path;
+  m_fd = fd;
+  m_header = header;
+  m_streams.clear();
+  m_chunk.clear();
+  m_chunk.reserve(header.chunkBytes);
+  m_chunk.resize(sizeof(capture::ChunkHeader));
+  m_chunkRecords = 0;
+  m_lastNs = 0;
+  m_queue.clear();
+  m_stopping = false;
+  m_stats = Stats();
+  m_fileOffset = sizeof(header);
+  m_index.clear();
+  m_writeFailed = false;
+  m_thread = std::thread(&CaptureWriter::writerLoop, this);
+  return true;
+}
+
+void CaptureWriter::close() {
+  {
+    QMutexLocker locker(&m_mutex);
+    if (m_fd < 0 || m_stopping) {
+      return;
+    }
+    sealChunkLocked();
+    m_stopping = true;
+    m_queued.wakeAll();
+  }
+  m_thread.join();
+
+  // The writer thread is gone; its index is ours now
+  QMutexLocker locker(&m_mutex);
+  capture::IndexHeader index{};
+  memcpy(index.magic, capture::kIndexMagic, sizeof(index.magic));
+  index.chunks = static_cast<uint32_t>(m_index.size());
+  index.streams = static_cast<uint32_t>(m_streams.size());
+  const bool indexed =
+      !m_writeFailed && writeAll(m_fd, &index, sizeof(index)) &&
+      writeAll(m_fd, m_index.constData(), m_index.size() * sizeof(capture::ChunkIndex)) &&
+      writeAll(m_fd, m_streams.constData(), m_streams.size() * sizeof(capture::StreamInfo));
+  if (indexed) {
+    m_header.indexOffset = m_fileOffset;
+    m_header.chunkCount = index.chunks;
+    if (::pwrite(m_fd, &m_header, sizeof(m_header), 0) != sizeof(m_header)) {
+      m_header.indexOffset = 0;
+    }
+  }
+  if (m_header.indexOffset == 0) {
+    Logger::instance().warning(
+        QString("[Capture] %1 closed without an index; readers will rebuild it").arg(m_path));
+  }
+  ::close(m_fd);
+  m_fd = -1;
+  m_stopping = false;
+  m_chunk.clear();
+  m_queue.clear();
+  m_index.clear();
+}
+
+bool CaptureWriter::isOpen() const {
+  QMutexLocker locker(&m_mutex);
+  return m_fd >= 0 && !m_stopping;
+}
+
+QString CaptureWriter::path() const {
+  QMutexLocker locker(&m_mutex);
+  return m_path;
+}
+
+int CaptureWriter::addStream(capture::StreamKind kind, const QString& name,
+                             const std::array<qint32, 4>& params) {
+  QMutexLocker locker(&m_mutex);
+  if (m_fd < 0 || m_stopping || m_streams.size() >= capture::kMaxStreams) {
+    return -1;
+  }
+
+  capture::StreamInfo info{};
+  info.id = static_cast<uint16_t>(m_streams.size());
+  info.kind = static_cast<uint16_t>(kind);
+  for (size_t i = 0; i < params.size(); ++i) {
+    info.params[i] = params[i];
+  }
+  const QByteArray utf8 = name.toUtf8().left(sizeof(info.name) - 1);
+  memcpy(info.name, utf8.constData(), static_cast<size_t>(utf8.size()));
+  m_streams.append(info);
+
+  // Definitions are never dropped: a record without one cannot be decoded
+  appendLocked(capture::kDefinitionStream,
+               std::span<const char>(reinterpret_cast<const char*>(&info), sizeof(info)), {}, 0,
+               true);
+  return info.id;
+}
+
+bool CaptureWriter::append(int stream, std::span<const char> data, std::span<const char> more,
+                           quint16 flags) {
+  QMutexLocker locker(&m_mutex);
+  if (m_fd < 0 || m_stopping || stream < 0 || stream >= m_streams.size()) {
+    return false;
+  }
+  return appendLocked(static_cast<quint16>(stream), data, more, flags, false);
+}
+
+bool CaptureWriter::appendLocked(quint16 stream, std::span<const char> data,
+                                 std::span<const char> more, quint16 flags, bool force) {
+  const size_t size = data.size() + more.size();
+  if (size > 0x7fffffff) {
+    ++m_stats.droppedRecords;
+    return false;
+  }
+  const quint32 padded = static_cast<quint32>(capture::paddedSize(size));
+  const qsizetype recordBytes = static_cast<qsizetype>(sizeof(capture::RecordHeader) + padded);
+  if (m_chunkRecords > 0 && m_chunk.size() + recordBytes > m_header.chunkBytes) {
+    if (!force && m_queue.size() >= kMaxQueuedChunks) {
+      ++m_stats.droppedRecords;
+      return false;
+    }
+    sealChunkLocked();
+  }
+
+  // Monotonic, and taken under the lock, so file order is time order
+  const quint64 now = qMax(clockNs(CLOCK_MONOTONIC) - m_header.startMonotonicNs, m_lastNs);
+  if (m_chunkRecords == 0) {
+    m_chunkFirstNs = now;
+  }
+  capture::RecordHeader header{now, static_cast<uint32_t>(size), stream, flags};
+  static const char kPadding[8] = {};
+  m_chunk.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  m_chunk.append(data.data(), static_cast<qsizetype>(data.size()));
+  m_chunk.append(more.data(), static_cast<qsizetype>(more.size()));
+  m_chunk.append(kPadding, static_cast<qsizetype>(padded - size));
+  ++m_chunkRecords;
+  m_lastNs = now;
+  if (stream != capture::kDefinitionStream) {
+    ++m_stats.records;
+    m_stats.bytes += size;
+  }
+  return true;
+}
+
+void CaptureWriter::sealChunkLocked() {
+  if (m_chunkRecords == 0) {
+    return;
+  }
+  capture::ChunkHeader header{};
+  memcpy(header.magic, capture::kChunkMagic, sizeof(header.magic));
+  header.records = m_chunkRecords;
+  header.bytes = static_cast<uint32_t>(m_chunk.size() - sizeof(header));
+  header.firstNs = m_chunkFirstNs;
+  header.lastNs = m_lastNs;
+  memcpy(m_chunk.data(), &header, sizeof(header));
+
+  m_queue.append(m_chunk);
+  m_chunk = QByteArray();
+  m_chunk.reserve(m_header.chunkBytes);
+  m_chunk.resize(sizeof(capture::ChunkHeader));
+  m_chunkRecords = 0;
+  m_queued.wakeOne();
+}
+
+CaptureWriter::Stats CaptureWriter::stats() const {
+  QMutexLocker locker(&m_mutex);
+  return m_stats;
+}
+
+void CaptureWriter::writerLoop() {
+  for (;;) {
+    QByteArray chunk;
+    {
+      QMutexLocker locker(&m_mutex);
+      while (m_queue.isEmpty() && !m_stopping) {
+        if (!m_queued.wait(&m_mutex, kFlushIntervalMs)) {
+          sealChunkLocked();
+        }
+      }
+      if (m_queue.isEmpty()) {
+        return;  // stopping, and everything is on disk
+      }
+      chunk = m_queue.takeFirst();
+    }
+
+    if (m_writeFailed) {
+      continue;  // keep draining so producers do not back up
+    }
+    if (!writeAll(m_fd, chunk.constData(), static_cast<size_t>(chunk.size()))) {
+      m_writeFailed = true;
+      Logger::instance().warning(
+          QString("[Capture] Writing %1 failed: %2").arg(m_path, strerror(errno)));
+      continue;
+    }
+
+    capture::ChunkHeader header;
+    memcpy(&header, chunk.constData(), sizeof(header));
+    m_index.append({m_fileOffset, header.firstNs, header.lastNs, header.records, header.bytes});
+    m_fileOffset += static_cast<quint64>(chunk.size());
+
+    QMutexLocker locker(&m_mutex);
+    ++m_stats.chunks;
+  }
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
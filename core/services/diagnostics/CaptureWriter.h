@@ -0,0 +1,129 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <array>
+#include <span>
+#include <thread>
+
+#include "CaptureFormat.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Writes a record/replay capture (CaptureFormat.h) from any thread
+ *
+ * append() stamps a record, copies it into the current chunk under a short
+ * lock and returns; it never touches the disk. Full chunks go to a writer
+ * thread through a bounded queue. When the disk cannot keep up the queue
+ * fills and further records are dropped and counted rather than stalling
+ * the transport or media thread that produced them.
+ *
+ * Typical use: a transport records what it reads (Transport::setCapture()),
+ * RealAndroidAutoService records channel payloads ("capture.file"), and
+ * CaptureReader, ReplayTransport or ReplayAndroidAutoService play it back.
+ */
+class CaptureWriter {
+ public:
+  struct Stats {
+    quint64 records{0};
+    quint64 bytes{0};           // payload bytes appended
+    quint64 chunks{0};          // chunks written to disk
+    quint64 droppedRecords{0};  // queue full or oversized
+  };
+
+  static constexpr int kMaxQueuedChunks = 16;
+
+  CaptureWriter() = default;
+  ~CaptureWriter();
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  /**
+   * @brief Create or truncate path and start the writer thread
+   * @param chunkBytes Nominal chunk size; at least 4 KiB
+   */
+  bool open(const QString& path, quint32 chunkBytes = capture::kDefaultChunkBytes,
+            QString* error = nullptr);
+
+  /**
+   * @brief Flush the last chunk, append the index and close the file
+   */
+  void close();
+  bool isOpen() const;
+  QString path() const;
+
+  /**
+   * @brief Declare a stream
+   * @return Stream id for append(), or -1 if not open or out of ids
+   */
+  int addStream(capture::StreamKind kind, const QString& name,
+                const std::array<qint32, 4>& params = {});
+
+  /**
+   * @brief Append one record stamped now; thread-safe
+   *
+   * The payload is data followed by more, so a read that wrapped around a
+   * ring buffer is still one record.
+   * @return false if not open or the record was dropped
+   */
+  bool append(int stream, std::span<const char> data, std::span<const char> more = {},
+              quint16 flags = 0);
+
+  Stats stats() const;
+
+ private:
+  bool appendLocked(quint16 stream, std::span<const char> data, std::span<const char> more,
+                    quint16 flags, bool force);
+  void sealChunkLocked();
+  void writerLoop();
+
+  mutable QMutex m_mutex;
+  QWaitCondition m_queued;
+  QString m_path;
+  int m_fd{-1};
+  capture::FileHeader m_header{};
+  QVector<capture::StreamInfo> m_streams;
+
+  // Chunk being filled; its ChunkHeader is filled in on sealing
+  QByteArray m_chunk;
+  quint32 m_chunkRecords{0};
+  quint64 m_chunkFirstNs{0};
+  quint64 m_lastNs{0};
+  QList<QByteArray> m_queue;
+  bool m_stopping{false};
+  Stats m_stats;
+
+  // Owned by the writer thread until it is joined
+  std::thread m_thread;
+  quint64 m_fileOffset{0};
+  QVector<capture::ChunkIndex> m_index;
+  bool m_writeFailed{false};
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -25,13 +25,13 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QProcess>
 #include <QSysInfo>
 
 #include "../eventbus/EventBus.h"
 #include "../extensions/ExtensionManager.h"
 #include "../logging/Logger.h"
 #include "../service_manager/ServiceManager.h"
+#include "ProcStatSampler.h"
 
 #ifndef CRANKSHAFT_VERSION
 #define CRANKSHAFT_VERSION "unknown"
@@ -45,6 +45,9 @@ DiagnosticsEndpoint::DiagnosticsEndpoint(EventBus* eventBus, ServiceManager* ser
       m_logger(logger),
       m_extensionManager(nullptr),
       m_startTime(QDateTime::currentMSecsSinceEpoch()) {
+  // Take the baseline sample now so the first /metrics request has an interval
+  crankshaft::diagnostics::ProcStatSampler::instance().sample();
+
   if (m_logger) {
     m_logger->info(QStringLiteral("DiagnosticsEndpoint constructed"));
   }
@@ -149,6 +152,17 @@ QJsonObject DiagnosticsEndpoint::gatherMetrics() {
   QJsonObject performance;
   performance[QStringLiteral("cpu_usage_percent")] = calculateCpuUsage();
   performance[QStringLiteral("memory_usage_mb")] = calculateMemoryUsage();
+
+  const auto process = crankshaft::diagnostics::ProcStatSampler::instance().lastSample();
+  QJsonObject threads;
+  for (auto it = process.cpuByGroup.constBegin(); it != process.cpuByGroup.constEnd(); ++it) {
+    threads[it.key()] = it.value();
+  }
+  performance[QStringLiteral("thread_cpu_percent")] = threads;
+  performance[QStringLiteral("thread_count")] = process.threadCount;
+  performance[QStringLiteral("major_faults")] = static_cast<qint64>(process.majorFaults);
+  performance[QStringLiteral("context_switches")] =
+      static_cast<qint64>(process.voluntarySwitches + process.involuntarySwitches);
   metrics[QStringLiteral("performance")] = performance;
 
   // Event bus metrics
@@ -197,59 +211,13 @@ QJsonObject DiagnosticsEndpoint::gatherExtensionsList() {
 }
 
 float DiagnosticsEndpoint::calculateCpuUsage() {
-  // Placeholder implementation
-  // In production, read from /proc/stat or use QProcess to run 'ps' command
-  QProcess ps;
-  ps.start(QStringLiteral("ps"), QStringList() << QStringLiteral("aux"));
-  ps.waitForFinished();
-
-  QString output = QString::fromLocal8Bit(ps.readAll());
-  QStringList lines = output.split('\n');
-
-  // Find Crankshaft process and extract CPU percentage
-  for (const auto& line : lines) {
-    if (line.contains(QStringLiteral("crankshaft"))) {
-      QStringList parts = line.split(QRegularExpression(QStringLiteral("\\s+")));
-      if (parts.size() >= 3) {
-        bool ok = false;
-        float cpuPercent = parts[2].toFloat(&ok);
-        if (ok) {
-          return cpuPercent;
-        }
-      }
-    }
-  }
-
-  return 0.0f;
+  // Delta against the previous sample; the sampler keeps its procfs fds open
+  return static_cast<float>(
+      crankshaft::diagnostics::ProcStatSampler::instance().sample().processCpuPercent);
 }
 
 float DiagnosticsEndpoint::calculateMemoryUsage() {
-  // Placeholder implementation
-  // In production, read from /proc/self/status or use system memory info
-  QFile statusFile(QStringLiteral("/proc/self/status"));
-  if (!statusFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    return 0.0f;
-  }
-
-  QTextStream stream(&statusFile);
-  QString line;
-  while (stream.readLineInto(&line)) {
-    if (line.startsWith(QStringLiteral("VmRSS:"))) {
-      QStringList parts = line.split(QRegularExpression(QStringLiteral("\\s+")));
-      if (parts.size() >= 2) {
-        bool ok = false;
-        // VmRSS is in KB, convert to MB
-        float memoryKb = parts[1].toFloat(&ok);
-        if (ok) {
-          statusFile.close();
-          return memoryKb / 1024.0f;
-        }
-      }
-    }
-  }
-
-  statusFile.close();
-  return 0.0f;
+  return static_cast<float>(crankshaft::diagnostics::ProcStatSampler::instance().sample().rssMb);
 }
 
 QJsonObject DiagnosticsEndpoint::handleExtensionsInstallRequest(const QJsonObject& requestBody) {
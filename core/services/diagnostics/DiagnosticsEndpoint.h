@@ -141,12 +141,13 @@ class DiagnosticsEndpoint : public QObject {
   QJsonObject gatherExtensionsList();
 
   /**
-   * Calculate CPU usage percentage
+   * Calculate process CPU usage percentage since the previous sample
+   * (read from procfs by ProcStatSampler; 100 = one core fully busy)
    */
   float calculateCpuUsage();
 
   /**
-   * Calculate memory usage in MB
+   * Calculate resident memory usage in MB
    */
   float calculateMemoryUsage();
 
@@ -0,0 +1,192 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// On-disk and in-memory layout of flight recorder records. Deliberately free
+// of Qt so the offline decoder (tools/flight_recorder) can share it.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace crankshaft {
+namespace diagnostics {
+namespace flight {
+
+enum class Event : uint16_t {
+  Marker = 0,           // code: DumpReason, a: detail (signal number, stall ms)
+  AaState = 1,          // code: new ConnectionState, a: previous state
+  DecoderPush = 2,      // a: encoded bytes, b: frames pushed so far
+  DecoderPop = 3,       // a: width << 16 | height, b: frames decoded so far
+  MixerUnderrun = 4,    // code: ChannelId, a: bytes missing, b: bytes buffered
+  WsQueue = 5,          // code: clients sent to, a: message bytes, b: bytes queued
+  EventBusPublish = 6,  // a: topicHash(topic), b: publishes so far
+  LoopStall = 7,        // a: ms since the loop's last heartbeat, b: its thread id
+};
+
+enum class DumpReason : uint16_t {
+  Manual = 0,
+  Crash = 1,
+  Stall = 2,
+};
+
+/**
+ * @brief One 32-byte event record
+ *
+ * sequence is the low 32 bits of (index + 1) and is stored last with release
+ * ordering; it reads 0 while the slot is being rewritten. It sits first so a
+ * reader copying the ring sees it before the fields it guards.
+ */
+struct Record {
+  uint32_t sequence;
+  uint32_t tid;
+  uint64_t timestampNs;  // CLOCK_MONOTONIC
+  uint16_t event;
+  uint16_t code;
+  uint32_t a;
+  uint64_t b;
+};
+static_assert(sizeof(Record) == 32, "records must stay 32 bytes");
+static_assert(std::is_trivially_copyable_v<Record>);
+
+/**
+ * @brief Dump file header; the raw ring of `capacity` records follows
+ *
+ * Fields are in host byte order. `head` is the number of records ever
+ * written, read after the ring was copied.
+ */
+struct DumpHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint64_t capacity;
+  uint64_t head;
+  uint64_t dumpMonotonicNs;
+  uint64_t dumpRealtimeNs;
+  uint32_t pid;
+  uint16_t reason;
+  uint16_t detail;
+};
+static_assert(sizeof(DumpHeader) == 56, "header layout is part of the file format");
+
+inline constexpr char kMagic[8] = {'C', 'S', 'F', 'L', 'I', 'G', 'H', 'T'};
+inline constexpr uint32_t kVersion = 1;
+
+/**
+ * @brief FNV-1a over the code units of a topic name
+ *
+ * Hashing code units (not bytes) gives the same value for a QString's
+ * UTF-16 data and for a plain ASCII char string.
+ */
+template <typename Char>
+constexpr uint32_t topicHash(const Char* data, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<uint32_t>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+inline const char* eventName(uint16_t event) {
+  switch (static_cast<Event>(event)) {
+    case Event::Marker:
+      return "marker";
+    case Event::AaState:
+      return "aa_state";
+    case Event::DecoderPush:
+      return "decoder_push";
+    case Event::DecoderPop:
+      return "decoder_pop";
+    case Event::MixerUnderrun:
+      return "mixer_underrun";
+    case Event::WsQueue:
+      return "ws_queue";
+    case Event::EventBusPublish:
+      return "eventbus_publish";
+    case Event::LoopStall:
+      return "loop_stall";
+  }
+  return "unknown";
+}
+
+inline const char* reasonName(uint16_t reason) {
+  switch (static_cast<DumpReason>(reason)) {
+    case DumpReason::Manual:
+      return "manual";
+    case DumpReason::Crash:
+      return "crash";
+    case DumpReason::Stall:
+      return "stall";
+  }
+  return "unknown";
+}
+
+/**
+ * @brief Read a dump and return its complete records, oldest first
+ *
+ * Slots that were being rewritten while the dump was taken, or that were
+ * never written, fail the sequence check and are skipped.
+ */
+inline bool readDump(const std::string& path, DumpHeader* header, std::vector<Record>* records,
+                     std::string* error) {
+  auto fail = [error](const std::string& message) {
+    if (error) *error = message;
+    return false;
+  };
+
+  FILE* file = std::fopen(path.c_str(), "rb");
+  if (!file) return fail("cannot open " + path);
+
+  DumpHeader h{};
+  const bool headerOk = std::fread(&h, sizeof(h), 1, file) == 1;
+  if (!headerOk || std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+    std::fclose(file);
+    return fail("not a flight recorder dump");
+  }
+  if (h.version != kVersion || h.recordSize != sizeof(Record) || h.capacity == 0 ||
+      (h.capacity & (h.capacity - 1)) != 0) {
+    std::fclose(file);
+    return fail("unsupported dump version or layout");
+  }
+
+  std::vector<Record> ring(h.capacity);
+  const size_t read = std::fread(ring.data(), sizeof(Record), ring.size(), file);
+  std::fclose(file);
+  if (read != ring.size()) return fail("dump is truncated");
+
+  records->clear();
+  records->reserve(h.head < h.capacity ? h.head : h.capacity);
+  const uint64_t first = h.head > h.capacity ? h.head - h.capacity : 0;
+  for (uint64_t index = first; index < h.head; ++index) {
+    const Record& record = ring[index & (h.capacity - 1)];
+    if (record.sequence == static_cast<uint32_t>(index + 1)) records->push_back(record);
+  }
+  *header = h;
+  return true;
+}
+
+}  // namespace flight
+}  // namespace diagnostics
+}  // namespace crankshaft
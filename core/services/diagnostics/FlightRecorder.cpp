@@ -0,0 +1,216 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FlightRecorder.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <cerrno>
+#include <cstring>
+
+#include "../logging/Logger.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+constexpr int kFatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+constexpr size_t kAltStackSize = 64 * 1024;
+
+// Crash state, prepared by installCrashHandler() for use inside the handler
+int g_crashFd = -1;
+char g_pendingPath[4096];
+char g_crashPath[4096];
+std::atomic<bool> g_crashDumped{false};
+struct sigaction g_previousActions[NSIG];
+QString g_dumpDirectory;
+
+bool writeAll(int fd, const void* data, size_t size) noexcept {
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+uint64_t realtimeNs() noexcept {
+  timespec ts{};
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void onFatalSignal(int signo, siginfo_t*, void*) {
+  const int savedErrno = errno;
+  // Only the first fatal signal dumps; a second one while dumping just dies
+  if (!g_crashDumped.exchange(true)) {
+    FlightRecorder::instance().dumpCrashFile(flight::DumpReason::Crash,
+                                             static_cast<uint16_t>(signo));
+  }
+  // Hand the signal to whoever had it before (default: terminate with a core)
+  sigaction(signo, &g_previousActions[signo], nullptr);
+  errno = savedErrno;
+  raise(signo);
+}
+
+}  // namespace
+
+bool FlightRecorder::writeDump(int fd, flight::DumpReason reason, uint16_t detail) noexcept {
+  record(flight::Event::Marker, static_cast<uint16_t>(reason), detail);
+
+  flight::DumpHeader header{};
+  memcpy(header.magic, flight::kMagic, sizeof(header.magic));
+  header.version = flight::kVersion;
+  header.recordSize = sizeof(flight::Record);
+  header.capacity = kCapacity;
+  header.pid = static_cast<uint32_t>(getpid());
+  header.reason = static_cast<uint16_t>(reason);
+  header.detail = detail;
+
+  if (ftruncate(fd, 0) != 0 && errno != EINVAL) return false;  // EINVAL: not a regular file
+  if (lseek(fd, 0, SEEK_SET) < 0) return false;
+  if (!writeAll(fd, &header, sizeof(header))) return false;
+  if (!writeAll(fd, m_ring, sizeof(m_ring))) return false;
+
+  // head is read after the copy, so slots rewritten during it fall outside
+  // the window the decoder accepts
+  header.head = m_head.load(std::memory_order_acquire);
+  header.dumpMonotonicNs = monotonicNs();
+  header.dumpRealtimeNs = realtimeNs();
+  if (lseek(fd, 0, SEEK_SET) < 0) return false;
+  return writeAll(fd, &header, sizeof(header));
+}
+
+bool FlightRecorder::dumpCrashFile(flight::DumpReason reason, uint16_t detail) noexcept {
+  if (g_crashFd < 0) return false;
+  if (!writeDump(g_crashFd, reason, detail)) return false;
+  fsync(g_crashFd);
+  return rename(g_pendingPath, g_crashPath) == 0;
+}
+
+QString FlightRecorder::dump(const QString& path, flight::DumpReason reason, QString* error) {
+  QString target = path;
+  if (target.isEmpty()) {
+    // Milliseconds, so two dumps in the same second do not overwrite each other
+    const QString time = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz");
+    target = dumpDirectory() + QString("/%1-%2.bin")
+                                   .arg(flight::reasonName(static_cast<uint16_t>(reason)))
+                                   .arg(time);
+  }
+  QDir().mkpath(QFileInfo(target).absolutePath());
+
+  const int fd = ::open(QFile::encodeName(target).constData(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    if (error) *error = QString("%1: %2").arg(target, QString::fromLocal8Bit(strerror(errno)));
+    return QString();
+  }
+  const bool ok = writeDump(fd, reason, 0);
+  ::close(fd);
+  if (!ok) {
+    if (error) *error = QString("%1: write failed").arg(target);
+    QFile::remove(target);
+    return QString();
+  }
+
+  Logger::instance().info(QString("[FlightRecorder] Dumped %1 records to %2")
+                              .arg(qMin<uint64_t>(recordCount(), kCapacity))
+                              .arg(target));
+  return target;
+}
+
+QString FlightRecorder::dumpDirectory() const {
+  if (!g_dumpDirectory.isEmpty()) return g_dumpDirectory;
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/flight";
+}
+
+bool FlightRecorder::installCrashHandler(const QString& directory) {
+  if (g_crashFd >= 0) return true;
+
+  g_dumpDirectory = directory.isEmpty() ? dumpDirectory() : directory;
+  if (!QDir().mkpath(g_dumpDirectory)) {
+    Logger::instance().warning(
+        QString("[FlightRecorder] Cannot create %1; crash dumps disabled").arg(g_dumpDirectory));
+    return false;
+  }
+
+  const QByteArray pending =
+      QFile::encodeName(g_dumpDirectory + QString("/.crash-%1.pending").arg(getpid()));
+  const QByteArray crash = QFile::encodeName(
+      g_dumpDirectory +
+      QString("/crash-%1.bin").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz")));
+  if (pending.size() >= static_cast<int>(sizeof(g_pendingPath)) ||
+      crash.size() >= static_cast<int>(sizeof(g_crashPath))) {
+    Logger::instance().warning("[FlightRecorder] Dump directory path too long");
+    return false;
+  }
+  memcpy(g_pendingPath, pending.constData(), pending.size() + 1);
+  memcpy(g_crashPath, crash.constData(), crash.size() + 1);
+
+  g_crashFd = ::open(g_pendingPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (g_crashFd < 0) {
+    Logger::instance().warning(QString("[FlightRecorder] Cannot open %1: %2")
+                                   .arg(QString::fromLocal8Bit(g_pendingPath))
+                                   .arg(QString::fromLocal8Bit(strerror(errno))));
+    return false;
+  }
+
+  // Stack overflows fault on the main thread's stack; give the handler its own
+  static char altStack[kAltStackSize];
+  stack_t stack{};
+  stack.ss_sp = altStack;
+  stack.ss_size = sizeof(altStack);
+  sigaltstack(&stack, nullptr);
+
+  struct sigaction action {};
+  action.sa_sigaction = onFatalSignal;
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+  for (int signo : kFatalSignals) {
+    sigaction(signo, &action, &g_previousActions[signo]);
+  }
+
+  Logger::instance().info(
+      QString("[FlightRecorder] Crash dumps go to %1").arg(QString::fromLocal8Bit(g_crashPath)));
+  return true;
+}
+
+void FlightRecorder::removeCrashFile() {
+  if (g_crashFd < 0) return;
+  ::close(g_crashFd);
+  g_crashFd = -1;
+  // Still pending means nothing was dumped into it
+  unlink(g_pendingPath);
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
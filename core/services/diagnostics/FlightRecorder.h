@@ -0,0 +1,130 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QString>
+#include <atomic>
+
+#include "FlightRecordFormat.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Always-on binary ring of recent hot-path events
+ *
+ * record() claims a slot with one relaxed fetch_add, fills 32 bytes and
+ * publishes them with a release store: no locks, no allocation, no logging.
+ * The ring holds the last kCapacity records and is written out in the
+ * FlightRecordFormat.h layout on demand or by a watchdog (dump()), and from
+ * the fatal signal handler installed by installCrashHandler().
+ * tools/flight_recorder turns a dump into a timeline.
+ */
+class FlightRecorder {
+ public:
+  static constexpr uint64_t kCapacity = 16384;  // 512 KiB of records
+  static_assert((kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of two");
+
+  static FlightRecorder& instance() noexcept {
+    static FlightRecorder recorder;  // constant-initialised: no guard on the hot path
+    return recorder;
+  }
+
+  constexpr FlightRecorder() = default;
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  void record(flight::Event event, uint16_t code = 0, uint32_t a = 0, uint64_t b = 0) noexcept {
+    const uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+    flight::Record& slot = m_ring[index & (kCapacity - 1)];
+    std::atomic_ref<uint32_t> sequence(slot.sequence);
+    sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.tid = currentTid();
+    slot.timestampNs = monotonicNs();
+    slot.event = static_cast<uint16_t>(event);
+    slot.code = code;
+    slot.a = a;
+    slot.b = b;
+    sequence.store(static_cast<uint32_t>(index + 1), std::memory_order_release);
+  }
+
+  static uint32_t topicHash(const QString& topic) noexcept {
+    return flight::topicHash(topic.utf16(), static_cast<size_t>(topic.size()));
+  }
+
+  /**
+   * @brief Records written since start, including those already overwritten
+   */
+  uint64_t recordCount() const noexcept {
+    return m_head.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Write the ring to a file (empty path: a timestamped file in dumpDirectory())
+   * @return Path written, or an empty string on failure
+   */
+  QString dump(const QString& path = QString(),
+               flight::DumpReason reason = flight::DumpReason::Manual, QString* error = nullptr);
+
+  /**
+   * @brief Pre-open the crash file in directory and dump on fatal signals
+   *
+   * The file is opened now because open() and path handling are not safe
+   * in a signal handler; it is renamed to crash-<start time>.bin when a
+   * dump lands in it and removed on a clean exit.
+   */
+  bool installCrashHandler(const QString& directory);
+  void removeCrashFile();
+  QString dumpDirectory() const;
+
+  /**
+   * @brief Dump into the pre-opened crash file; async-signal-safe, used once
+   */
+  bool dumpCrashFile(flight::DumpReason reason, uint16_t detail) noexcept;
+
+  /**
+   * @brief Write header and ring to fd; async-signal-safe
+   */
+  bool writeDump(int fd, flight::DumpReason reason, uint16_t detail) noexcept;
+
+ private:
+  static uint64_t monotonicNs() noexcept {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+  }
+
+  static uint32_t currentTid() noexcept {
+    static thread_local uint32_t tid = 0;
+    if (tid == 0) tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+  }
+
+  alignas(64) std::atomic<uint64_t> m_head{0};
+  alignas(64) flight::Record m_ring[kCapacity]{};
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
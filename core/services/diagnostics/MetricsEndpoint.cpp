@@ -21,162 +21,47 @@
 
 #include <unistd.h>
 
+#include <QBuffer>
 #include <QDebug>
 #include <QFile>
-#include <QTextStream>
-#include <algorithm>
-#include <fstream>
-#include <sstream>
 
 namespace crankshaft {
 namespace diagnostics {
 
-// ============================================================================
-// MetricTimeSeries Implementation
-// ============================================================================
-
-MetricTimeSeries::MetricTimeSeries(const QString& name, const QString& unit, int maxSamples)
-    : m_name(name), m_unit(unit), m_maxSamples(maxSamples) {
-  m_samples.reserve(maxSamples);
-}
-
-void MetricTimeSeries::addSample(double value) {
-  addSample(QDateTime::currentMSecsSinceEpoch(), value);
-}
-
-void MetricTimeSeries::addSample(qint64 timestamp, double value) {
-  QMutexLocker locker(&m_mutex);
-
-  // Add sample
-  m_samples.append(MetricSample(timestamp, value, m_unit));
-
-  // Circular buffer: remove oldest if exceeds max
-  if (m_samples.size() > m_maxSamples) {
-    m_samples.removeFirst();
-  }
-}
-
-QJsonObject MetricTimeSeries::toJson(int lastN) const {
-  QMutexLocker locker(&m_mutex);
-
-  QJsonObject json;
-  json["name"] = m_name;
-  json["unit"] = m_unit;
-  json["sample_count"] = m_samples.size();
-
-  // Determine samples to include
-  int startIdx = 0;
-  if (lastN > 0 && lastN < m_samples.size()) {
-    startIdx = m_samples.size() - lastN;
-  }
-
-  QJsonArray samples;
-  for (int i = startIdx; i < m_samples.size(); ++i) {
-    QJsonObject sample;
-    sample["timestamp"] = m_samples[i].timestamp;
-    sample["value"] = m_samples[i].value;
-    samples.append(sample);
-  }
-
-  json["samples"] = samples;
-  json["latest"] = getLatest();
-  json["average"] = getAverage(lastN);
-  json["min"] = getMin(lastN);
-  json["max"] = getMax(lastN);
-
-  return json;
-}
-
-double MetricTimeSeries::getLatest() const {
-  QMutexLocker locker(&m_mutex);
-  return m_samples.isEmpty() ? 0.0 : m_samples.last().value;
-}
-
-double MetricTimeSeries::getAverage(int lastN) const {
-  QMutexLocker locker(&m_mutex);
-
-  if (m_samples.isEmpty()) return 0.0;
-
-  int startIdx = 0;
-  if (lastN > 0 && lastN < m_samples.size()) {
-    startIdx = m_samples.size() - lastN;
-  }
-
-  double sum = 0.0;
-  for (int i = startIdx; i < m_samples.size(); ++i) {
-    sum += m_samples[i].value;
-  }
-
-  return sum / (m_samples.size() - startIdx);
-}
-
-double MetricTimeSeries::getMin(int lastN) const {
-  QMutexLocker locker(&m_mutex);
-
-  if (m_samples.isEmpty()) return 0.0;
-
-  int startIdx = 0;
-  if (lastN > 0 && lastN < m_samples.size()) {
-    startIdx = m_samples.size() - lastN;
-  }
-
-  double minVal = m_samples[startIdx].value;
-  for (int i = startIdx + 1; i < m_samples.size(); ++i) {
-    if (m_samples[i].value < minVal) {
-      minVal = m_samples[i].value;
-    }
-  }
-
-  return minVal;
-}
-
-double MetricTimeSeries::getMax(int lastN) const {
-  QMutexLocker locker(&m_mutex);
-
-  if (m_samples.isEmpty()) return 0.0;
-
-  int startIdx = 0;
-  if (lastN > 0 && lastN < m_samples.size()) {
-    startIdx = m_samples.size() - lastN;
-  }
-
-  double maxVal = m_samples[startIdx].value;
-  for (int i = startIdx + 1; i < m_samples.size(); ++i) {
-    if (m_samples[i].value > maxVal) {
-      maxVal = m_samples[i].value;
-    }
-  }
-
-  return maxVal;
-}
-
-int MetricTimeSeries::getSampleCount() const {
-  QMutexLocker locker(&m_mutex);
-  return m_samples.size();
-}
-
 // ============================================================================
 // MetricsEndpoint Implementation
 // ============================================================================
 
 MetricsEndpoint::MetricsEndpoint(QObject* parent)
+    : MetricsEndpoint(MetricsRegistry::instance(), parent) {
+}
+
+MetricsEndpoint::MetricsEndpoint(MetricsRegistry& registry, QObject* parent)
     : QObject(parent),
-      m_collectionInterval(60000)  // 1 minute default
-      ,
+      m_registry(registry),
+      m_memoryGauge(registry.gauge("memory_usage_mb", "Process memory usage in megabytes")),
+      m_cpuGauge(registry.gauge("cpu_usage_percent", "Process CPU usage percentage")),
+      m_activeConnectionsGauge(
+          registry.gauge("websocket_active_connections", "Active WebSocket connections")),
+      m_totalConnectionsGauge(
+          registry.gauge("websocket_total_connections", "Total WebSocket connections")),
+      m_memoryUsage(registry.timeSeries("memory_usage", "MB", 1440)),
+      m_cpuUsage(registry.timeSeries("cpu_usage", "%", 1440)),
+      m_activeConnections(registry.timeSeries("active_connections", "count", 1440)),
+      m_totalConnections(registry.timeSeries("total_connections", "count", 1440)),
+      m_requestLatency(registry.timeSeries("request_latency", "ms", 1440)),
+      m_collectionInterval(60000),  // 1 minute default
       m_isCollecting(false),
-      m_maxHistorySamples(1440)  // 24 hours at 1-minute intervals
-      ,
+      m_maxHistorySamples(1440),  // 24 hours at 1-minute intervals
       m_prometheusEnabled(false),
       m_startTime(QDateTime::currentMSecsSinceEpoch()) {
-  // Initialize time series
-  m_memoryUsage = std::make_unique<MetricTimeSeries>("memory_usage", "MB", m_maxHistorySamples);
-  m_cpuUsage = std::make_unique<MetricTimeSeries>("cpu_usage", "%", m_maxHistorySamples);
-  m_activeConnections =
-      std::make_unique<MetricTimeSeries>("active_connections", "count", m_maxHistorySamples);
-  m_totalConnections =
-      std::make_unique<MetricTimeSeries>("total_connections", "count", m_maxHistorySamples);
-  m_requestLatency =
-      std::make_unique<MetricTimeSeries>("request_latency", "ms", m_maxHistorySamples);
+  // One sampler per registry, so process counters are not double-counted
+  if (&registry == &MetricsRegistry::instance()) {
+    m_procStat = &ProcStatSampler::instance();
+  } else {
+    m_ownedProcStat = std::make_unique<ProcStatSampler>(&registry);
+    m_procStat = m_ownedProcStat.get();
+  }
 
   // Setup collection timer
   m_collectionTimer = new QTimer(this);
@@ -229,16 +114,20 @@ bool MetricsEndpoint::isCollecting() const {
 }
 
 void MetricsEndpoint::recordMemoryUsage(double memoryMB) {
-  m_memoryUsage->addSample(memoryMB);
+  m_memoryGauge.set(memoryMB);
+  m_memoryUsage.append(memoryMB);
 }
 
 void MetricsEndpoint::recordCpuUsage(double cpuPercent) {
-  m_cpuUsage->addSample(cpuPercent);
+  m_cpuGauge.set(cpuPercent);
+  m_cpuUsage.append(cpuPercent);
 }
 
 void MetricsEndpoint::recordWebSocketConnections(int active, int total) {
-  m_activeConnections->addSample(static_cast<double>(active));
-  m_totalConnections->addSample(static_cast<double>(total));
+  m_activeConnectionsGauge.set(active);
+  m_totalConnectionsGauge.set(total);
+  m_activeConnections.append(static_cast<double>(active));
+  m_totalConnections.append(static_cast<double>(total));
 }
 
 void MetricsEndpoint::recordExtensionStatus(const QString& extensionId, const QString& status) {
@@ -246,40 +135,21 @@ void MetricsEndpoint::recordExtensionStatus(const QString& extensionId, const QS
   m_extensionStatus[extensionId] = status;
 }
 
-void MetricsEndpoint::recordRequestLatency(const QString& endpoint, double latencyMs) {
+Histogram& MetricsEndpoint::latencyHistogram(const QString& endpoint) {
   QMutexLocker locker(&m_latencyMutex);
-
-  // Store recent latency samples (max 100 per endpoint)
-  if (!m_latencyByEndpoint.contains(endpoint)) {
-    m_latencyByEndpoint[endpoint] = QVector<double>();
-  }
-
-  QVector<double>& latencies = m_latencyByEndpoint[endpoint];
-  latencies.append(latencyMs);
-
-  // Keep only last 100 samples
-  if (latencies.size() > 100) {
-    latencies.removeFirst();
-  }
-
-  // Update global latency metric (average across all endpoints)
-  double totalLatency = 0.0;
-  int sampleCount = 0;
-  for (const auto& samples : m_latencyByEndpoint) {
-    for (double latency : samples) {
-      totalLatency += latency;
-      ++sampleCount;
-    }
+  Histogram*& histogram = m_latencyByEndpoint[endpoint];
+  if (!histogram) {
+    histogram = &m_registry.histogram("request_latency_ms", "Request latency in milliseconds",
+                                      {{"endpoint", endpoint}});
   }
+  return *histogram;
+}
 
-  if (sampleCount > 0) {
-    m_requestLatency->addSample(totalLatency / sampleCount);
-  }
+void MetricsEndpoint::recordRequestLatency(const QString& endpoint, double latencyMs) {
+  latencyHistogram(endpoint).record(latencyMs);
 }
 
 QJsonObject MetricsEndpoint::getMetrics(int lastN) const {
-  QMutexLocker locker(&m_mutex);
-
   QJsonObject metrics;
   metrics["timestamp"] = QDateTime::currentMSecsSinceEpoch();
   metrics["uptime_ms"] = QDateTime::currentMSecsSinceEpoch() - m_startTime;
@@ -287,11 +157,14 @@ QJsonObject MetricsEndpoint::getMetrics(int lastN) const {
   metrics["collection_interval_ms"] = m_collectionInterval;
 
   // Time series metrics
-  metrics["memory"] = m_memoryUsage->toJson(lastN);
-  metrics["cpu"] = m_cpuUsage->toJson(lastN);
-  metrics["websocket_active"] = m_activeConnections->toJson(lastN);
-  metrics["websocket_total"] = m_totalConnections->toJson(lastN);
-  metrics["latency"] = m_requestLatency->toJson(lastN);
+  metrics["memory"] = m_memoryUsage.toJson(lastN);
+  metrics["cpu"] = m_cpuUsage.toJson(lastN);
+  metrics["websocket_active"] = m_activeConnections.toJson(lastN);
+  metrics["websocket_total"] = m_totalConnections.toJson(lastN);
+  metrics["latency"] = m_requestLatency.toJson(lastN);
+
+  // Most recent procfs sample: per-thread CPU, faults and context switches
+  metrics["process"] = m_procStat->lastSample().toJson();
 
   // Extension status
   QJsonObject extensions;
@@ -303,33 +176,24 @@ QJsonObject MetricsEndpoint::getMetrics(int lastN) const {
   }
   metrics["extensions"] = extensions;
 
-  // Latency breakdown by endpoint
+  // Latency breakdown by endpoint; percentiles come from the histogram buckets
   QJsonObject latencyBreakdown;
   {
     QMutexLocker latencyLocker(&m_latencyMutex);
     for (auto it = m_latencyByEndpoint.begin(); it != m_latencyByEndpoint.end(); ++it) {
-      const QVector<double>& samples = it.value();
-      if (!samples.isEmpty()) {
-        QJsonObject endpointLatency;
-
-        // Calculate percentiles
-        QVector<double> sorted = samples;
-        std::sort(sorted.begin(), sorted.end());
-
-        int p50Idx = sorted.size() / 2;
-        int p95Idx = static_cast<int>(sorted.size() * 0.95);
-        int p99Idx = static_cast<int>(sorted.size() * 0.99);
-
-        endpointLatency["p50"] = sorted[p50Idx];
-        endpointLatency["p95"] = sorted[p95Idx];
-        endpointLatency["p99"] = sorted[p99Idx];
-        endpointLatency["count"] = samples.size();
-
-        latencyBreakdown[it.key()] = endpointLatency;
-      }
+      const Histogram::Snapshot snapshot = it.value()->snapshot();
+      if (snapshot.count == 0) continue;
+
+      QJsonObject endpointLatency;
+      endpointLatency["p50"] = snapshot.percentile(0.50);
+      endpointLatency["p95"] = snapshot.percentile(0.95);
+      endpointLatency["p99"] = snapshot.percentile(0.99);
+      endpointLatency["count"] = static_cast<qint64>(snapshot.count);
+      latencyBreakdown[it.key()] = endpointLatency;
     }
   }
   metrics["latency_breakdown"] = latencyBreakdown;
+  metrics["registry"] = m_registry.toJson();
 
   return metrics;
 }
@@ -340,18 +204,18 @@ QJsonObject MetricsEndpoint::getMetricsSummary() const {
   summary["uptime_seconds"] = (QDateTime::currentMSecsSinceEpoch() - m_startTime) / 1000;
 
   // Latest values
-  summary["memory_mb"] = m_memoryUsage->getLatest();
-  summary["cpu_percent"] = m_cpuUsage->getLatest();
-  summary["active_connections"] = static_cast<int>(m_activeConnections->getLatest());
-  summary["total_connections"] = static_cast<int>(m_totalConnections->getLatest());
-  summary["avg_latency_ms"] = m_requestLatency->getLatest();
+  summary["memory_mb"] = m_memoryGauge.value();
+  summary["cpu_percent"] = m_cpuGauge.value();
+  summary["active_connections"] = static_cast<int>(m_activeConnectionsGauge.value());
+  summary["total_connections"] = static_cast<int>(m_totalConnectionsGauge.value());
+  summary["avg_latency_ms"] = m_requestLatency.latest();
 
   // Statistics (last hour: 60 samples at 1-minute intervals)
   QJsonObject stats;
-  stats["memory_avg"] = m_memoryUsage->getAverage(60);
-  stats["memory_max"] = m_memoryUsage->getMax(60);
-  stats["cpu_avg"] = m_cpuUsage->getAverage(60);
-  stats["cpu_max"] = m_cpuUsage->getMax(60);
+  stats["memory_avg"] = m_memoryUsage.average(60);
+  stats["memory_max"] = m_memoryUsage.max(60);
+  stats["cpu_avg"] = m_cpuUsage.average(60);
+  stats["cpu_max"] = m_cpuUsage.max(60);
   summary["last_hour"] = stats;
 
   // Active alerts
@@ -368,16 +232,7 @@ QJsonArray MetricsEndpoint::getAlerts() const {
   for (const MetricAlert& alert : m_alerts) {
     if (!alert.enabled) continue;
 
-    double currentValue = 0.0;
-    if (alert.metricName == "memory_usage") {
-      currentValue = m_memoryUsage->getLatest();
-    } else if (alert.metricName == "cpu_usage") {
-      currentValue = m_cpuUsage->getLatest();
-    } else if (alert.metricName == "active_connections") {
-      currentValue = m_activeConnections->getLatest();
-    } else if (alert.metricName == "request_latency") {
-      currentValue = m_requestLatency->getLatest();
-    }
+    const double currentValue = latestValue(alert.metricName);
 
     if (currentValue >= alert.warningThreshold) {
       QJsonObject alertObj;
@@ -454,9 +309,15 @@ void MetricsEndpoint::setCollectionInterval(int intervalMs) {
 }
 
 void MetricsEndpoint::setMaxHistorySamples(int maxSamples) {
+  if (maxSamples <= 0 || maxSamples == m_maxHistorySamples) {
+    return;
+  }
   m_maxHistorySamples = maxSamples;
-  // Note: This doesn't retroactively change existing time series
-  // New time series will use this limit
+  m_memoryUsage.setCapacity(maxSamples);
+  m_cpuUsage.setCapacity(maxSamples);
+  m_activeConnections.setCapacity(maxSamples);
+  m_totalConnections.setCapacity(maxSamples);
+  m_requestLatency.setCapacity(maxSamples);
 }
 
 void MetricsEndpoint::setPrometheusEnabled(bool enabled) {
@@ -468,31 +329,14 @@ QString MetricsEndpoint::exportPrometheus() const {
     return QString();
   }
 
-  QString output;
-  QTextStream stream(&output);
-
-  // Memory usage
-  stream << "# HELP crankshaft_memory_usage_mb Process memory usage in megabytes\n";
-  stream << "# TYPE crankshaft_memory_usage_mb gauge\n";
-  stream << "crankshaft_memory_usage_mb " << m_memoryUsage->getLatest() << "\n\n";
-
-  // CPU usage
-  stream << "# HELP crankshaft_cpu_usage_percent Process CPU usage percentage\n";
-  stream << "# TYPE crankshaft_cpu_usage_percent gauge\n";
-  stream << "crankshaft_cpu_usage_percent " << m_cpuUsage->getLatest() << "\n\n";
-
-  // Active connections
-  stream << "# HELP crankshaft_websocket_active_connections Active WebSocket connections\n";
-  stream << "# TYPE crankshaft_websocket_active_connections gauge\n";
-  stream << "crankshaft_websocket_active_connections " << m_activeConnections->getLatest()
-         << "\n\n";
-
-  // Request latency
-  stream << "# HELP crankshaft_request_latency_ms Average request latency in milliseconds\n";
-  stream << "# TYPE crankshaft_request_latency_ms gauge\n";
-  stream << "crankshaft_request_latency_ms " << m_requestLatency->getLatest() << "\n\n";
+  QBuffer buffer;
+  buffer.open(QIODevice::WriteOnly);
+  writePrometheus(&buffer);
+  return QString::fromUtf8(buffer.data());
+}
 
-  return output;
+qint64 MetricsEndpoint::writePrometheus(QIODevice* device) const {
+  return MetricsExporter(m_registry).writePrometheus(device);
 }
 
 QJsonObject MetricsEndpoint::exportJson() const {
@@ -500,34 +344,44 @@ QJsonObject MetricsEndpoint::exportJson() const {
 }
 
 QString MetricsEndpoint::exportCsv() const {
-  QString csv;
-  QTextStream stream(&csv);
-
-  // Header
-  stream << "timestamp,memory_mb,cpu_percent,active_connections,total_connections,latency_ms\n";
-
-  // Data rows
-  int sampleCount = m_memoryUsage->getSampleCount();
-  for (int i = 0; i < sampleCount; ++i) {
-    // Note: This is simplified - would need access to individual samples
-    // In production, implement iterator or accessor for time series
-  }
+  QBuffer buffer;
+  buffer.open(QIODevice::WriteOnly);
+  writeCsv(&buffer);
+  return QString::fromUtf8(buffer.data());
+}
 
-  return csv;
+qint64 MetricsEndpoint::writeCsv(QIODevice* device) const {
+  return MetricsExporter(m_registry).writeCsv(device);
 }
 
 void MetricsEndpoint::collectMetrics() {
   // Collect system metrics
-  double memoryMB = getCurrentMemoryUsageMB();
-  double cpuPercent = getCurrentCpuPercent();
+  const ProcStatSampler::Sample process = m_procStat->sample();
+  double memoryMB = process.rssMb;
+  double cpuPercent = process.processCpuPercent;
   int activeConns = getActiveWebSocketConnections();
   int totalConns = getTotalWebSocketConnections();
 
   // Record samples
-  m_memoryUsage->addSample(memoryMB);
-  m_cpuUsage->addSample(cpuPercent);
-  m_activeConnections->addSample(static_cast<double>(activeConns));
-  m_totalConnections->addSample(static_cast<double>(totalConns));
+  recordMemoryUsage(memoryMB);
+  recordCpuUsage(cpuPercent);
+  recordWebSocketConnections(activeConns, totalConns);
+
+  // Mean request latency over the interval since the previous collection
+  quint64 latencyCount = 0;
+  double latencySum = 0.0;
+  {
+    QMutexLocker latencyLocker(&m_latencyMutex);
+    for (const Histogram* histogram : std::as_const(m_latencyByEndpoint)) {
+      const Histogram::Snapshot latency = histogram->snapshot();
+      latencyCount += latency.count;
+      latencySum += latency.sum;
+    }
+  }
+  const quint64 newRequests = latencyCount - m_lastLatencyCount;
+  m_requestLatency.append(newRequests > 0 ? (latencySum - m_lastLatencySum) / newRequests : 0.0);
+  m_lastLatencyCount = latencyCount;
+  m_lastLatencySum = latencySum;
 
   // Check alerts
   checkAlerts();
@@ -541,60 +395,12 @@ void MetricsEndpoint::checkAlerts() {
   for (const MetricAlert& alert : m_alerts) {
     if (!alert.enabled) continue;
 
-    double currentValue = 0.0;
-    if (alert.metricName == "memory_usage") {
-      currentValue = m_memoryUsage->getLatest();
-    } else if (alert.metricName == "cpu_usage") {
-      currentValue = m_cpuUsage->getLatest();
-    } else if (alert.metricName == "active_connections") {
-      currentValue = m_activeConnections->getLatest();
-    } else if (alert.metricName == "request_latency") {
-      currentValue = m_requestLatency->getLatest();
-    }
+    const double currentValue = latestValue(alert.metricName);
 
     evaluateAlert(alert, currentValue);
   }
 }
 
-double MetricsEndpoint::getCurrentMemoryUsageMB() const {
-  // Read from /proc/self/status
-  std::ifstream status("/proc/self/status");
-  if (!status.is_open()) {
-    return 0.0;
-  }
-
-  std::string line;
-  while (std::getline(status, line)) {
-    if (line.find("VmRSS:") == 0) {
-      std::istringstream iss(line);
-      std::string label;
-      int valueKB;
-      std::string unit;
-      iss >> label >> valueKB >> unit;
-      return valueKB / 1024.0;  // Convert KB to MB
-    }
-  }
-
-  return 0.0;
-}
-
-double MetricsEndpoint::getCurrentCpuPercent() const {
-  // Read from /proc/self/stat
-  std::ifstream stat("/proc/self/stat");
-  if (!stat.is_open()) {
-    return 0.0;
-  }
-
-  // Parse CPU times (simplified)
-  std::string line;
-  std::getline(stat, line);
-
-  // In production, calculate CPU percentage from utime + stime
-  // This requires tracking previous values and time deltas
-  // For now, return placeholder
-  return 0.0;
-}
-
 int MetricsEndpoint::getActiveWebSocketConnections() const {
   // TODO: Query WebSocketServer for active connection count
   return 0;
@@ -605,6 +411,19 @@ int MetricsEndpoint::getTotalWebSocketConnections() const {
   return 0;
 }
 
+double MetricsEndpoint::latestValue(const QString& metricName) const {
+  if (metricName == "memory_usage") {
+    return m_memoryGauge.value();
+  } else if (metricName == "cpu_usage") {
+    return m_cpuGauge.value();
+  } else if (metricName == "active_connections") {
+    return m_activeConnectionsGauge.value();
+  } else if (metricName == "request_latency") {
+    return m_requestLatency.latest();
+  }
+  return 0.0;
+}
+
 void MetricsEndpoint::evaluateAlert(const MetricAlert& alert, double currentValue) {
   if (currentValue >= alert.criticalThreshold) {
     emit alertTriggered(alert.metricName, "CRITICAL", currentValue);
@@ -23,61 +23,21 @@
 #include <QDateTime>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QMap>
 #include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QTimer>
 #include <QVector>
-#include <chrono>
 #include <memory>
 
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+#include "ProcStatSampler.h"
+
 namespace crankshaft {
 namespace diagnostics {
 
-/**
- * @brief Metric data point with timestamp and value
- */
-struct MetricSample {
-  qint64 timestamp;  // Unix timestamp (milliseconds)
-  double value;      // Metric value
-  QString unit;      // Unit of measurement (MB, %, ms, etc.)
-
-  MetricSample(qint64 ts, double val, const QString& u) : timestamp(ts), value(val), unit(u) {}
-};
-
-/**
- * @brief Metric time series with circular buffer
- */
-class MetricTimeSeries {
- public:
-  explicit MetricTimeSeries(const QString& name, const QString& unit, int maxSamples = 1440);
-
-  void addSample(double value);
-  void addSample(qint64 timestamp, double value);
-
-  QJsonObject toJson(int lastN = -1) const;
-
-  double getLatest() const;
-  double getAverage(int lastN = -1) const;
-  double getMin(int lastN = -1) const;
-  double getMax(int lastN = -1) const;
-  int getSampleCount() const;
-
-  const QString& getName() const {
-    return m_name;
-  }
-  const QString& getUnit() const {
-    return m_unit;
-  }
-
- private:
-  QString m_name;
-  QString m_unit;
-  int m_maxSamples;
-  QVector<MetricSample> m_samples;
-  mutable QMutex m_mutex;
-};
-
 /**
  * @brief Alert configuration for metric thresholds
  */
@@ -101,14 +61,19 @@ struct MetricAlert {
  *
  * Provides REST API endpoint (/metrics) for retrieving system metrics:
  * - Memory usage (RSS, heap)
- * - CPU utilization (process, system)
+ * - CPU utilization (process, per named thread)
  * - WebSocket connections (active, total)
  * - Extension status (running, crashed)
  * - Request latency (p50, p95, p99)
  *
+ * All values live in a MetricsRegistry (the process-wide one by default):
+ * gauges for the latest values, ring-buffer time series for history and
+ * log-linear histograms for latency, so recording is O(1) and percentiles
+ * are only computed when metrics are read.
+ *
  * Features:
  * - Automatic metric collection (configurable interval)
- * - Historical data with circular buffer
+ * - Historical data with fixed-capacity ring buffers
  * - Alert thresholds with warning/critical levels
  * - JSON export for dashboards
  * - Prometheus-compatible format (optional)
@@ -118,6 +83,7 @@ class MetricsEndpoint : public QObject {
 
  public:
   explicit MetricsEndpoint(QObject* parent = nullptr);
+  explicit MetricsEndpoint(MetricsRegistry& registry, QObject* parent = nullptr);
   ~MetricsEndpoint() override;
 
   // Metric collection control
@@ -132,6 +98,14 @@ class MetricsEndpoint : public QObject {
   void recordExtensionStatus(const QString& extensionId, const QString& status);
   void recordRequestLatency(const QString& endpoint, double latencyMs);
 
+  /**
+   * @brief Per-endpoint latency histogram; hot paths should keep the reference
+   */
+  Histogram& latencyHistogram(const QString& endpoint);
+  MetricsRegistry& registry() const {
+    return m_registry;
+  }
+
   // Metric retrieval
   QJsonObject getMetrics(int lastN = -1) const;
   QJsonObject getMetricsSummary() const;
@@ -145,13 +119,16 @@ class MetricsEndpoint : public QObject {
 
   // Configuration
   void setCollectionInterval(int intervalMs);
-  void setMaxHistorySamples(int maxSamples);
+  void setMaxHistorySamples(int maxSamples);  // Resizing drops existing history
   void setPrometheusEnabled(bool enabled);
 
-  // Export formats
+  // Export formats; the QString variants build the whole document in memory,
+  // the QIODevice variants stream it in chunks (see MetricsExporter)
   QString exportPrometheus() const;
   QJsonObject exportJson() const;
   QString exportCsv() const;
+  qint64 writePrometheus(QIODevice* device) const;
+  qint64 writeCsv(QIODevice* device) const;
 
  signals:
   void metricsCollected();
@@ -165,20 +142,29 @@ class MetricsEndpoint : public QObject {
 
  private:
   // System metrics collection
-  double getCurrentMemoryUsageMB() const;
-  double getCurrentCpuPercent() const;
   int getActiveWebSocketConnections() const;
   int getTotalWebSocketConnections() const;
 
   // Alert evaluation
   void evaluateAlert(const MetricAlert& alert, double currentValue);
+  double latestValue(const QString& metricName) const;
 
-  // Time series storage
-  std::unique_ptr<MetricTimeSeries> m_memoryUsage;
-  std::unique_ptr<MetricTimeSeries> m_cpuUsage;
-  std::unique_ptr<MetricTimeSeries> m_activeConnections;
-  std::unique_ptr<MetricTimeSeries> m_totalConnections;
-  std::unique_ptr<MetricTimeSeries> m_requestLatency;
+  MetricsRegistry& m_registry;
+
+  // Latest values (scraped) and history (one ring per metric)
+  Gauge& m_memoryGauge;
+  Gauge& m_cpuGauge;
+  Gauge& m_activeConnectionsGauge;
+  Gauge& m_totalConnectionsGauge;
+  TimeSeries& m_memoryUsage;
+  TimeSeries& m_cpuUsage;
+  TimeSeries& m_activeConnections;
+  TimeSeries& m_totalConnections;
+  TimeSeries& m_requestLatency;
+
+  // procfs sampling (shared when using the process-wide registry)
+  ProcStatSampler* m_procStat{nullptr};
+  std::unique_ptr<ProcStatSampler> m_ownedProcStat;
 
   // Collection control
   QTimer* m_collectionTimer;
@@ -199,11 +185,10 @@ class MetricsEndpoint : public QObject {
   mutable QMutex m_extensionMutex;
 
   // Request latency tracking
-  QMap<QString, QVector<double>> m_latencyByEndpoint;  // endpoint -> latency samples
+  QMap<QString, Histogram*> m_latencyByEndpoint;  // endpoint -> registry histogram
   mutable QMutex m_latencyMutex;
-
-  // Thread safety
-  mutable QMutex m_mutex;
+  quint64 m_lastLatencyCount{0};  // all endpoints, for the per-interval mean
+  double m_lastLatencySum{0.0};
 };
 
 }  // namespace diagnostics
@@ -0,0 +1,240 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsExporter.h"
+
+#include <QStringList>
+#include <algorithm>
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+/**
+ * @brief Group each metric family together; Prometheus requires families to be contiguous
+ *
+ * Registry order is by key, where "name|label=..." sorts after "name_suffix".
+ */
+template <typename T>
+QList<const T*> byFamily(QList<const T*> metrics) {
+  std::stable_sort(metrics.begin(), metrics.end(),
+                   [](const T* a, const T* b) { return a->name() < b->name(); });
+  return metrics;
+}
+
+QByteArray number(double value) {
+  return QByteArray::number(value, 'g', 12);
+}
+
+QByteArray escapeLabelValue(QString value) {
+  value.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+  return value.toUtf8();
+}
+
+QByteArray prometheusLabels(const MetricLabels& labels, const char* extraKey = nullptr,
+                            const QByteArray& extraValue = QByteArray()) {
+  if (labels.isEmpty() && !extraKey) return QByteArray();
+
+  QByteArray out = "{";
+  bool first = true;
+  for (auto it = labels.constBegin(); it != labels.constEnd(); ++it) {
+    if (!first) out += ',';
+    first = false;
+    out += it.key().toUtf8() + "=\"" + escapeLabelValue(it.value()) + '"';
+  }
+  if (extraKey) {
+    if (!first) out += ',';
+    out += QByteArray(extraKey) + "=\"" + extraValue + '"';
+  }
+  out += '}';
+  return out;
+}
+
+QByteArray csvField(const QString& text) {
+  QByteArray field = text.toUtf8();
+  if (field.contains(',') || field.contains('"') || field.contains('\n')) {
+    field.replace('"', "\"\"");
+    field = '"' + field + '"';
+  }
+  return field;
+}
+
+QByteArray csvLabels(const MetricLabels& labels) {
+  QStringList parts;
+  for (auto it = labels.constBegin(); it != labels.constEnd(); ++it) {
+    parts.append(it.key() + '=' + it.value());
+  }
+  return csvField(parts.join(';'));
+}
+
+}  // namespace
+
+MetricsExporter::MetricsExporter(const MetricsRegistry& registry, const QByteArray& prefix)
+    : m_registry(registry), m_prefix(prefix), m_bounds(defaultHistogramBounds()) {
+}
+
+QVector<double> MetricsExporter::defaultHistogramBounds() {
+  // Milliseconds: covers frame times through slow service calls
+  return {0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+}
+
+void MetricsExporter::setHistogramBounds(const QVector<double>& bounds) {
+  m_bounds = bounds;
+  std::sort(m_bounds.begin(), m_bounds.end());
+}
+
+qint64 MetricsExporter::writePrometheus(QIODevice* device) const {
+  return write(stream(Format::Prometheus), device);
+}
+
+qint64 MetricsExporter::writeCsv(QIODevice* device) const {
+  return write(stream(Format::Csv), device);
+}
+
+qint64 MetricsExporter::write(Stream stream, QIODevice* device) {
+  qint64 written = 0;
+  while (!stream.atEnd()) {
+    const QByteArray chunk = stream.next();
+    if (device->write(chunk) != chunk.size()) return -1;
+    written += chunk.size();
+  }
+  return written;
+}
+
+MetricsExporter::Stream::Stream(const MetricsExporter& exporter, Format format)
+    : m_prefix(exporter.m_prefix),
+      m_bounds(exporter.m_bounds),
+      m_phase(format == Format::Csv ? Phase::Series : Phase::Counters) {
+  if (format == Format::Csv) {
+    m_series = exporter.m_registry.timeSeries();
+    m_csvHeader = true;
+  } else {
+    m_counters = byFamily(exporter.m_registry.counters());
+    m_gauges = byFamily(exporter.m_registry.gauges());
+    m_histograms = byFamily(exporter.m_registry.histograms());
+  }
+}
+
+QByteArray MetricsExporter::Stream::next() {
+  QByteArray out;
+  out.reserve(kChunkSize + 512);
+  if (m_csvHeader) {
+    out += "metric,labels,unit,timestamp,value\n";
+    m_csvHeader = false;
+  }
+  while (m_phase != Phase::Done && out.size() < kChunkSize) {
+    if (m_phase == Phase::Series) {
+      appendCsv(out);
+    } else {
+      appendPrometheus(out);
+    }
+  }
+  return out;
+}
+
+void MetricsExporter::Stream::describe(QByteArray& out, const Metric& metric, const char* type) {
+  if (m_described.contains(metric.name())) return;
+  m_described.insert(metric.name());
+  const QByteArray name = m_prefix + metric.name().toUtf8();
+  if (!metric.help().isEmpty()) {
+    out += "# HELP " + name + ' ' + metric.help().toUtf8() + '\n';
+  }
+  out += "# TYPE " + name + ' ' + type + '\n';
+}
+
+void MetricsExporter::Stream::appendPrometheus(QByteArray& out) {
+  // One metric per call; a histogram is a few hundred bytes at most
+  if (m_phase == Phase::Counters) {
+    if (m_index >= m_counters.size()) {
+      m_phase = Phase::Gauges;
+      m_index = 0;
+      return;
+    }
+    const Counter* counter = m_counters.at(m_index++);
+    describe(out, *counter, "counter");
+    out += m_prefix + counter->name().toUtf8() + prometheusLabels(counter->labels()) + ' ' +
+           QByteArray::number(counter->value()) + '\n';
+    return;
+  }
+
+  if (m_phase == Phase::Gauges) {
+    if (m_index >= m_gauges.size()) {
+      m_phase = Phase::Histograms;
+      m_index = 0;
+      return;
+    }
+    const Gauge* gauge = m_gauges.at(m_index++);
+    describe(out, *gauge, "gauge");
+    out += m_prefix + gauge->name().toUtf8() + prometheusLabels(gauge->labels()) + ' ' +
+           number(gauge->value()) + '\n';
+    return;
+  }
+
+  if (m_index >= m_histograms.size()) {
+    m_phase = Phase::Done;
+    return;
+  }
+  const Histogram* histogram = m_histograms.at(m_index++);
+  describe(out, *histogram, "histogram");
+  const Histogram::Snapshot snapshot = histogram->snapshot();
+  const QByteArray name = m_prefix + histogram->name().toUtf8();
+
+  // Walk fine buckets and bounds together; both are ascending
+  quint64 cumulative = 0;
+  int bucket = 0;
+  for (double bound : m_bounds) {
+    while (bucket < snapshot.buckets.size() && snapshot.buckets[bucket].upperBound <= bound) {
+      cumulative += snapshot.buckets[bucket].count;
+      ++bucket;
+    }
+    out += name + "_bucket" + prometheusLabels(histogram->labels(), "le", number(bound)) + ' ' +
+           QByteArray::number(qMin(cumulative, snapshot.count)) + '\n';
+  }
+  out += name + "_bucket" + prometheusLabels(histogram->labels(), "le", "+Inf") + ' ' +
+         QByteArray::number(snapshot.count) + '\n';
+  out += name + "_sum" + prometheusLabels(histogram->labels()) + ' ' + number(snapshot.sum) +
+         '\n';
+  out += name + "_count" + prometheusLabels(histogram->labels()) + ' ' +
+         QByteArray::number(snapshot.count) + '\n';
+}
+
+void MetricsExporter::Stream::appendCsv(QByteArray& out) {
+  if (m_sample >= m_samples.size()) {
+    if (m_index >= m_series.size()) {
+      m_phase = Phase::Done;
+      return;
+    }
+    // Prefix columns are the same for every row of a series
+    const TimeSeries* series = m_series.at(m_index++);
+    m_rowPrefix = csvField(series->name()) + ',' + csvLabels(series->labels()) + ',' +
+                  csvField(series->unit()) + ',';
+    m_samples = series->samples();
+    m_sample = 0;
+    return;
+  }
+
+  while (m_sample < m_samples.size() && out.size() < kChunkSize) {
+    const TimeSeries::Sample& sample = m_samples.at(m_sample++);
+    out += m_rowPrefix + QByteArray::number(sample.timestamp) + ',' + number(sample.value) + '\n';
+  }
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,130 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QSet>
+#include <QVector>
+
+#include "MetricsRegistry.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Streams a MetricsRegistry as Prometheus text or CSV
+ *
+ * Output is produced in UTF-8 chunks of about kChunkSize bytes, so exporting
+ * long histories never materialises the whole document. The writers push
+ * every chunk into a device and return the number of bytes written, or -1 if
+ * the device reported an error; a Stream hands out one chunk at a time for
+ * callers that must wait for the device to drain (sockets).
+ */
+class MetricsExporter {
+ public:
+  static constexpr int kChunkSize = 16 * 1024;
+
+  enum class Format { Prometheus, Csv };
+
+  /**
+   * @brief Resumable export; each next() call renders the following chunk
+   *
+   * The metric list is taken when the stream is created; values are read as
+   * each metric is reached. The registry must outlive the stream.
+   */
+  class Stream {
+   public:
+    Stream(const MetricsExporter& exporter, Format format);
+
+    bool atEnd() const {
+      return m_phase == Phase::Done;
+    }
+
+    /**
+     * @brief The next chunk of about kChunkSize bytes; empty once atEnd()
+     */
+    QByteArray next();
+
+   private:
+    enum class Phase { Counters, Gauges, Histograms, Series, Done };
+
+    void appendPrometheus(QByteArray& out);
+    void appendCsv(QByteArray& out);
+    void describe(QByteArray& out, const Metric& metric, const char* type);
+
+    QByteArray m_prefix;
+    QVector<double> m_bounds;
+    QList<const Counter*> m_counters;
+    QList<const Gauge*> m_gauges;
+    QList<const Histogram*> m_histograms;
+    QList<const TimeSeries*> m_series;
+    Phase m_phase;
+    int m_index{0};
+    QSet<QString> m_described;  // Prometheus families with HELP/TYPE written
+    QVector<TimeSeries::Sample> m_samples;  // CSV: the series being written
+    int m_sample{0};
+    QByteArray m_rowPrefix;
+    bool m_csvHeader{false};
+  };
+
+  explicit MetricsExporter(const MetricsRegistry& registry,
+                           const QByteArray& prefix = "crankshaft_");
+
+  /**
+   * @brief Upper bounds (in recorded units) of the exported histogram buckets
+   *
+   * The registry histograms keep ~1000 fine buckets; Prometheus gets these
+   * cumulative buckets plus +Inf. A fine bucket is counted under the first
+   * bound at or above its upper edge, so counts never overstate a bound.
+   */
+  void setHistogramBounds(const QVector<double>& bounds);
+  static QVector<double> defaultHistogramBounds();
+
+  /**
+   * @brief Prometheus text exposition format (0.0.4)
+   *
+   * Counters and gauges as-is; histograms as cumulative _bucket series with
+   * _sum and _count. Time series are history and are left to CSV.
+   */
+  qint64 writePrometheus(QIODevice* device) const;
+
+  /**
+   * @brief Long-format CSV of every time series sample
+   *
+   * Columns: metric,labels,unit,timestamp,value. Labels are "key=value"
+   * pairs joined with ';'.
+   */
+  qint64 writeCsv(QIODevice* device) const;
+
+  Stream stream(Format format) const {
+    return Stream(*this, format);
+  }
+
+ private:
+  static qint64 write(Stream stream, QIODevice* device);
+
+  const MetricsRegistry& m_registry;
+  QByteArray m_prefix;
+  QVector<double> m_bounds;
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,193 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsHttpServer.h"
+
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "../logging/Logger.h"
+#include "ProcStatSampler.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+// Scrapers send a request line and a few headers; anything larger is not one
+constexpr int kMaxRequestBytes = 8 * 1024;
+
+}  // namespace
+
+MetricsHttpServer::MetricsHttpServer(MetricsRegistry& registry, QObject* parent)
+    : QObject(parent), m_registry(registry) {
+  connect(&m_server, &QTcpServer::newConnection, this, &MetricsHttpServer::onNewConnection);
+}
+
+MetricsHttpServer::~MetricsHttpServer() {
+  close();
+}
+
+bool MetricsHttpServer::listen(const QHostAddress& address, quint16 port) {
+  if (!m_server.listen(address, port)) {
+    Logger::instance().error(QString("[Metrics] Failed to listen on %1:%2: %3")
+                                 .arg(address.toString())
+                                 .arg(port)
+                                 .arg(m_server.errorString()));
+    return false;
+  }
+  Logger::instance().info(QString("[Metrics] Scrape endpoint on http://%1:%2/metrics")
+                              .arg(address.toString())
+                              .arg(m_server.serverPort()));
+  return true;
+}
+
+void MetricsHttpServer::close() {
+  m_server.close();
+  // abort() emits disconnected() synchronously, which edits m_pending
+  QList<QTcpSocket*> sockets = m_pending.keys();
+  sockets += m_responses.keys();
+  m_pending.clear();
+  m_responses.clear();
+  for (QTcpSocket* socket : sockets) {
+    socket->abort();
+  }
+}
+
+bool MetricsHttpServer::isListening() const {
+  return m_server.isListening();
+}
+
+quint16 MetricsHttpServer::port() const {
+  return m_server.serverPort();
+}
+
+void MetricsHttpServer::setRequestTimeout(int timeoutMs) {
+  m_requestTimeoutMs = timeoutMs;
+}
+
+void MetricsHttpServer::onNewConnection() {
+  while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+    m_pending.insert(socket, QByteArray());
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleReadyRead(socket); });
+    connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() { writeResponse(socket); });
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+      m_pending.remove(socket);
+      m_responses.remove(socket);
+      socket->deleteLater();
+    });
+    QTimer::singleShot(m_requestTimeoutMs, socket, [this, socket]() {
+      if (m_pending.contains(socket)) socket->abort();
+    });
+  }
+}
+
+void MetricsHttpServer::handleReadyRead(QTcpSocket* socket) {
+  auto it = m_pending.find(socket);
+  if (it == m_pending.end()) {
+    socket->readAll();  // already answered; ignore anything further
+    return;
+  }
+
+  it->append(socket->readAll());
+  const int headerEnd = it->indexOf("\r\n\r\n");
+  if (headerEnd < 0) {
+    if (it->size() > kMaxRequestBytes) {
+      m_pending.erase(it);
+      sendError(socket, 431, "Request Header Fields Too Large");
+    }
+    return;
+  }
+
+  const QByteArray requestLine = it->left(it->indexOf("\r\n"));
+  m_pending.erase(it);
+
+  const QList<QByteArray> parts = requestLine.split(' ');
+  if (parts.size() != 3 || !parts[2].startsWith("HTTP/")) {
+    sendError(socket, 400, "Bad Request");
+    return;
+  }
+  respond(socket, parts[0], parts[1]);
+}
+
+void MetricsHttpServer::respond(QTcpSocket* socket, const QByteArray& method,
+                                const QByteArray& target) {
+  if (method != "GET") {
+    sendError(socket, 405, "Method Not Allowed");
+    return;
+  }
+
+  const int query = target.indexOf('?');
+  const QByteArray path = query >= 0 ? target.left(query) : target;
+  const bool prometheus = path == "/metrics";
+  if (!prometheus && path != "/metrics.csv") {
+    sendError(socket, 404, "Not Found");
+    return;
+  }
+
+  // Refresh process gauges so every scrape sees current CPU and memory
+  if (&m_registry == &MetricsRegistry::instance()) {
+    ProcStatSampler::instance().sample();
+  }
+
+  socket->write("HTTP/1.0 200 OK\r\nContent-Type: ");
+  socket->write(prometheus ? "text/plain; version=0.0.4; charset=utf-8"
+                           : "text/csv; charset=utf-8");
+  socket->write("\r\nConnection: close\r\n\r\n");
+
+  const MetricsExporter exporter(m_registry);
+  m_responses.insert(socket, std::make_shared<Response>(Response{
+                                 QString::fromLatin1(path),
+                                 exporter.stream(prometheus ? MetricsExporter::Format::Prometheus
+                                                            : MetricsExporter::Format::Csv)}));
+  writeResponse(socket);
+}
+
+void MetricsHttpServer::writeResponse(QTcpSocket* socket) {
+  const std::shared_ptr<Response> response = m_responses.value(socket);
+  if (!response) return;
+
+  // Render only what the socket can take; bytesWritten() brings us back
+  while (!response->stream.atEnd() && socket->bytesToWrite() < kMaxBufferedBytes) {
+    const QByteArray chunk = response->stream.next();
+    if (socket->write(chunk) != chunk.size()) {
+      m_responses.remove(socket);
+      socket->abort();
+      return;
+    }
+    response->bytes += chunk.size();
+  }
+
+  if (response->stream.atEnd()) {
+    m_responses.remove(socket);
+    socket->disconnectFromHost();  // flushes what is still buffered
+    emit scraped(response->path, response->bytes);
+  }
+}
+
+void MetricsHttpServer::sendError(QTcpSocket* socket, int status, const QByteArray& reason) {
+  const QByteArray body = reason + '\n';
+  socket->write("HTTP/1.0 " + QByteArray::number(status) + ' ' + reason +
+                "\r\nContent-Type: text/plain\r\nContent-Length: " +
+                QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+  socket->disconnectFromHost();
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,91 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QTcpServer>
+#include <memory>
+
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+
+class QTcpSocket;
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Minimal in-process HTTP endpoint for metric scrapers
+ *
+ * Serves GET /metrics (Prometheus text) and GET /metrics.csv (time series
+ * history) from a MetricsRegistry. Each response is rendered one
+ * MetricsExporter chunk at a time as the socket drains, so a slow scraper
+ * never holds more than kMaxBufferedBytes in the socket. The connection is
+ * closed afterwards (HTTP/1.0 semantics), so no keep-alive or chunked
+ * encoding is needed. Runs on the thread that owns it.
+ */
+class MetricsHttpServer : public QObject {
+  Q_OBJECT
+
+ public:
+  static constexpr qint64 kMaxBufferedBytes = 2 * MetricsExporter::kChunkSize;
+
+  explicit MetricsHttpServer(MetricsRegistry& registry, QObject* parent = nullptr);
+  ~MetricsHttpServer() override;
+
+  bool listen(const QHostAddress& address = QHostAddress::LocalHost, quint16 port = 9464);
+  void close();
+  bool isListening() const;
+  quint16 port() const;
+
+  /**
+   * @brief Close clients that have not sent a full request within this time
+   */
+  void setRequestTimeout(int timeoutMs);
+
+ signals:
+  void scraped(const QString& path, qint64 bytes);
+
+ private slots:
+  void onNewConnection();
+
+ private:
+  void handleReadyRead(QTcpSocket* socket);
+  void respond(QTcpSocket* socket, const QByteArray& method, const QByteArray& target);
+  void writeResponse(QTcpSocket* socket);
+  static void sendError(QTcpSocket* socket, int status, const QByteArray& reason);
+
+  struct Response {
+    QString path;
+    MetricsExporter::Stream stream;
+    qint64 bytes{0};
+  };
+
+  MetricsRegistry& m_registry;
+  QTcpServer m_server;
+  QHash<QTcpSocket*, QByteArray> m_pending;  // request bytes received so far
+  QHash<QTcpSocket*, std::shared_ptr<Response>> m_responses;  // bodies still being sent
+  int m_requestTimeoutMs{5000};
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
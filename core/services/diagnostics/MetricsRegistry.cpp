@@ -0,0 +1,390 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsRegistry.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+// Threads are spread over counter shards round-robin on first use
+int currentShard(int shards) {
+  static std::atomic<int> nextShard{0};
+  thread_local const int shard = nextShard.fetch_add(1, std::memory_order_relaxed);
+  return shard % shards;
+}
+
+}  // namespace
+
+// ============================================================================
+// Counter / Gauge
+// ============================================================================
+
+void Counter::add(quint64 delta) {
+  m_shards[currentShard(kShards)].value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+quint64 Counter::value() const {
+  quint64 total = 0;
+  for (const auto& shard : m_shards) {
+    total += shard.value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void Gauge::add(double delta) {
+  double current = m_value.load(std::memory_order_relaxed);
+  while (!m_value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+  }
+}
+
+// ============================================================================
+// Histogram
+// ============================================================================
+
+Histogram::Histogram(const QString& name, const QString& help, const MetricLabels& labels,
+                     double scale)
+    : Metric(name, help, labels), m_scale(scale > 0.0 ? scale : 1.0) {
+}
+
+int Histogram::bucketIndex(quint64 raw) {
+  if (raw < static_cast<quint64>(kSubBuckets)) {
+    return static_cast<int>(raw);
+  }
+  const int msb = 63 - std::countl_zero(raw);
+  const int shift = msb - kSubBucketBits;
+  const int mantissa = static_cast<int>(raw >> shift);  // in [kSubBuckets, 2 * kSubBuckets)
+  return (shift + 1) * kSubBuckets + (mantissa - kSubBuckets);
+}
+
+quint64 Histogram::bucketUpperBound(int index) {
+  if (index < kSubBuckets) {
+    return static_cast<quint64>(index);
+  }
+  const int shift = index / kSubBuckets - 1;
+  const quint64 mantissa = static_cast<quint64>(kSubBuckets + index % kSubBuckets);
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void Histogram::record(double value) {
+  constexpr quint64 kMaxRaw = (quint64(1) << kMaxValueBits) - 1;
+  const double scaled = value * m_scale;
+  const quint64 raw =
+      scaled <= 0.0 ? 0 : std::min<quint64>(static_cast<quint64>(std::llround(scaled)), kMaxRaw);
+
+  m_buckets[bucketIndex(raw)].fetch_add(1, std::memory_order_relaxed);
+  m_sumRaw.fetch_add(raw, std::memory_order_relaxed);
+
+  quint64 seen = m_minRaw.load(std::memory_order_relaxed);
+  while (raw < seen && !m_minRaw.compare_exchange_weak(seen, raw, std::memory_order_relaxed)) {
+  }
+  seen = m_maxRaw.load(std::memory_order_relaxed);
+  while (raw > seen && !m_maxRaw.compare_exchange_weak(seen, raw, std::memory_order_relaxed)) {
+  }
+
+  // Count last, with release: a snapshot() that acquires this count also sees
+  // the bucket, sum and min/max updates of every sample it includes
+  m_count.fetch_add(1, std::memory_order_release);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+  Snapshot snapshot;
+  snapshot.count = m_count.load(std::memory_order_acquire);
+  if (snapshot.count == 0) {
+    return snapshot;
+  }
+
+  snapshot.sum = static_cast<double>(m_sumRaw.load(std::memory_order_relaxed)) / m_scale;
+  snapshot.min = static_cast<double>(m_minRaw.load(std::memory_order_relaxed)) / m_scale;
+  snapshot.max = static_cast<double>(m_maxRaw.load(std::memory_order_relaxed)) / m_scale;
+
+  for (int i = 0; i < kBucketCount; ++i) {
+    const quint64 count = m_buckets[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      snapshot.buckets.append({static_cast<double>(bucketUpperBound(i)) / m_scale, count});
+    }
+  }
+  return snapshot;
+}
+
+double Histogram::Snapshot::percentile(double p) const {
+  if (count == 0 || buckets.isEmpty()) {
+    return 0.0;
+  }
+
+  quint64 total = 0;
+  for (const auto& bucket : buckets) {
+    total += bucket.count;
+  }
+  const quint64 rank =
+      std::max<quint64>(1, static_cast<quint64>(std::ceil(std::clamp(p, 0.0, 1.0) * total)));
+
+  quint64 seen = 0;
+  for (const auto& bucket : buckets) {
+    seen += bucket.count;
+    if (seen >= rank) {
+      // The bucket bound overestimates by up to one sub-bucket; the observed
+      // extremes are exact, so never report outside them.
+      return std::clamp(bucket.upperBound, min, max);
+    }
+  }
+  return max;
+}
+
+// ============================================================================
+// TimeSeries
+// ============================================================================
+
+TimeSeries::TimeSeries(const QString& name, const QString& help, const MetricLabels& labels,
+                       const QString& unit, int capacity)
+    : Metric(name, help, labels), m_unit(unit), m_ring(qMax(1, capacity)) {
+}
+
+void TimeSeries::append(double value) {
+  append(QDateTime::currentMSecsSinceEpoch(), value);
+}
+
+void TimeSeries::append(qint64 timestamp, double value) {
+  QMutexLocker locker(&m_mutex);
+  m_ring[m_head] = {timestamp, value};
+  m_head = (m_head + 1) % m_ring.size();
+  m_size = qMin(m_size + 1, static_cast<int>(m_ring.size()));
+}
+
+QVector<TimeSeries::Sample> TimeSeries::samplesLocked(int lastN) const {
+  const int count = (lastN > 0 && lastN < m_size) ? lastN : m_size;
+  const int capacity = static_cast<int>(m_ring.size());
+  QVector<Sample> result;
+  result.reserve(count);
+  for (int i = count; i > 0; --i) {
+    result.append(m_ring[(m_head - i + capacity) % capacity]);
+  }
+  return result;
+}
+
+QVector<TimeSeries::Sample> TimeSeries::samples(int lastN) const {
+  QMutexLocker locker(&m_mutex);
+  return samplesLocked(lastN);
+}
+
+double TimeSeries::latest() const {
+  QMutexLocker locker(&m_mutex);
+  if (m_size == 0) return 0.0;
+  return m_ring[(m_head - 1 + m_ring.size()) % m_ring.size()].value;
+}
+
+double TimeSeries::average(int lastN) const {
+  const QVector<Sample> window = samples(lastN);
+  if (window.isEmpty()) return 0.0;
+  double sum = 0.0;
+  for (const auto& sample : window) sum += sample.value;
+  return sum / window.size();
+}
+
+double TimeSeries::min(int lastN) const {
+  const QVector<Sample> window = samples(lastN);
+  if (window.isEmpty()) return 0.0;
+  return std::min_element(window.begin(), window.end(), [](const Sample& a, const Sample& b) {
+           return a.value < b.value;
+         })->value;
+}
+
+double TimeSeries::max(int lastN) const {
+  const QVector<Sample> window = samples(lastN);
+  if (window.isEmpty()) return 0.0;
+  return std::max_element(window.begin(), window.end(), [](const Sample& a, const Sample& b) {
+           return a.value < b.value;
+         })->value;
+}
+
+int TimeSeries::size() const {
+  QMutexLocker locker(&m_mutex);
+  return m_size;
+}
+
+int TimeSeries::capacity() const {
+  QMutexLocker locker(&m_mutex);
+  return static_cast<int>(m_ring.size());
+}
+
+void TimeSeries::setCapacity(int capacity) {
+  QMutexLocker locker(&m_mutex);
+  m_ring = QVector<Sample>(qMax(1, capacity));
+  m_head = 0;
+  m_size = 0;
+}
+
+QJsonObject TimeSeries::toJson(int lastN) const {
+  // Copy once under the lock, then derive everything from the copy
+  const QVector<Sample> window = samples(lastN);
+
+  QJsonObject json;
+  json["name"] = name();
+  json["unit"] = m_unit;
+  json["sample_count"] = size();
+
+  QJsonArray samplesJson;
+  double sum = 0.0;
+  double minValue = window.isEmpty() ? 0.0 : window.first().value;
+  double maxValue = minValue;
+  for (const auto& sample : window) {
+    samplesJson.append(QJsonObject{{"timestamp", sample.timestamp}, {"value", sample.value}});
+    sum += sample.value;
+    minValue = qMin(minValue, sample.value);
+    maxValue = qMax(maxValue, sample.value);
+  }
+
+  json["samples"] = samplesJson;
+  json["latest"] = window.isEmpty() ? 0.0 : window.last().value;
+  json["average"] = window.isEmpty() ? 0.0 : sum / window.size();
+  json["min"] = minValue;
+  json["max"] = maxValue;
+  return json;
+}
+
+// ============================================================================
+// MetricsRegistry
+// ============================================================================
+
+MetricsRegistry& MetricsRegistry::instance() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+QString MetricsRegistry::key(const QString& name, const MetricLabels& labels) {
+  QString key = name;
+  for (auto it = labels.constBegin(); it != labels.constEnd(); ++it) {
+    key += QLatin1Char('|') + it.key() + QLatin1Char('=') + it.value();
+  }
+  return key;
+}
+
+Counter& MetricsRegistry::counter(const QString& name, const QString& help,
+                                  const MetricLabels& labels) {
+  QMutexLocker locker(&m_mutex);
+  auto& slot = m_counters[key(name, labels)];
+  if (!slot) slot = std::make_unique<Counter>(name, help, labels);
+  return *slot;
+}
+
+Gauge& MetricsRegistry::gauge(const QString& name, const QString& help,
+                              const MetricLabels& labels) {
+  QMutexLocker locker(&m_mutex);
+  auto& slot = m_gauges[key(name, labels)];
+  if (!slot) slot = std::make_unique<Gauge>(name, help, labels);
+  return *slot;
+}
+
+Histogram& MetricsRegistry::histogram(const QString& name, const QString& help,
+                                      const MetricLabels& labels, double scale) {
+  QMutexLocker locker(&m_mutex);
+  auto& slot = m_histograms[key(name, labels)];
+  if (!slot) slot = std::make_unique<Histogram>(name, help, labels, scale);
+  return *slot;
+}
+
+TimeSeries& MetricsRegistry::timeSeries(const QString& name, const QString& unit, int capacity,
+                                        const QString& help, const MetricLabels& labels) {
+  QMutexLocker locker(&m_mutex);
+  auto& slot = m_timeSeries[key(name, labels)];
+  if (!slot) slot = std::make_unique<TimeSeries>(name, help, labels, unit, capacity);
+  return *slot;
+}
+
+template <typename T>
+QList<const T*> MetricsRegistry::collect(
+    const std::map<QString, std::unique_ptr<T>>& metrics) const {
+  QMutexLocker locker(&m_mutex);
+  QList<const T*> result;
+  result.reserve(static_cast<qsizetype>(metrics.size()));
+  for (const auto& [key, metric] : metrics) {
+    result.append(metric.get());
+  }
+  return result;
+}
+
+QList<const Counter*> MetricsRegistry::counters() const {
+  return collect(m_counters);
+}
+
+QList<const Gauge*> MetricsRegistry::gauges() const {
+  return collect(m_gauges);
+}
+
+QList<const Histogram*> MetricsRegistry::histograms() const {
+  return collect(m_histograms);
+}
+
+QList<const TimeSeries*> MetricsRegistry::timeSeries() const {
+  return collect(m_timeSeries);
+}
+
+QJsonObject MetricsRegistry::toJson() const {
+  auto labelsJson = [](const Metric& metric) {
+    QJsonObject labels;
+    for (auto it = metric.labels().constBegin(); it != metric.labels().constEnd(); ++it) {
+      labels[it.key()] = it.value();
+    }
+    return labels;
+  };
+
+  QJsonArray counterArray;
+  for (const auto* counter : counters()) {
+    counterArray.append(QJsonObject{{"name", counter->name()},
+                                    {"labels", labelsJson(*counter)},
+                                    {"value", static_cast<qint64>(counter->value())}});
+  }
+
+  QJsonArray gaugeArray;
+  for (const auto* gauge : gauges()) {
+    gaugeArray.append(QJsonObject{
+        {"name", gauge->name()}, {"labels", labelsJson(*gauge)}, {"value", gauge->value()}});
+  }
+
+  QJsonArray histogramArray;
+  for (const auto* histogram : histograms()) {
+    const Histogram::Snapshot snapshot = histogram->snapshot();
+    histogramArray.append(QJsonObject{{"name", histogram->name()},
+                                      {"labels", labelsJson(*histogram)},
+                                      {"count", static_cast<qint64>(snapshot.count)},
+                                      {"sum", snapshot.sum},
+                                      {"min", snapshot.min},
+                                      {"max", snapshot.max},
+                                      {"mean", snapshot.mean()},
+                                      {"p50", snapshot.percentile(0.50)},
+                                      {"p95", snapshot.percentile(0.95)},
+                                      {"p99", snapshot.percentile(0.99)}});
+  }
+
+  QJsonObject json;
+  json["counters"] = counterArray;
+  json["gauges"] = gaugeArray;
+  json["histograms"] = histogramArray;
+  return json;
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
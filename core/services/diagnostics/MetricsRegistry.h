@@ -0,0 +1,266 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+
+namespace crankshaft {
+namespace diagnostics {
+
+using MetricLabels = QMap<QString, QString>;
+
+/**
+ * @brief Name, help text and labels shared by every metric kind
+ */
+class Metric {
+ public:
+  Metric(const QString& name, const QString& help, const MetricLabels& labels)
+      : m_name(name), m_help(help), m_labels(labels) {}
+  virtual ~Metric() = default;
+
+  Metric(const Metric&) = delete;
+  Metric& operator=(const Metric&) = delete;
+
+  const QString& name() const {
+    return m_name;
+  }
+  const QString& help() const {
+    return m_help;
+  }
+  const MetricLabels& labels() const {
+    return m_labels;
+  }
+
+ private:
+  QString m_name;
+  QString m_help;
+  MetricLabels m_labels;
+};
+
+/**
+ * @brief Monotonic counter, sharded so concurrent writers do not share a cache line
+ *
+ * add() is a single relaxed fetch_add on the calling thread's shard; value()
+ * sums the shards and is only needed at scrape time.
+ */
+class Counter : public Metric {
+ public:
+  using Metric::Metric;
+
+  void add(quint64 delta = 1);
+  quint64 value() const;
+
+ private:
+  static constexpr int kShards = 8;
+  struct alignas(64) Shard {
+    std::atomic<quint64> value{0};
+  };
+  std::array<Shard, kShards> m_shards;
+};
+
+/**
+ * @brief Last-value gauge backed by a single atomic double
+ */
+class Gauge : public Metric {
+ public:
+  using Metric::Metric;
+
+  void set(double value) {
+    m_value.store(value, std::memory_order_relaxed);
+  }
+  void add(double delta);
+  double value() const {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<double> m_value{0.0};
+};
+
+/**
+ * @brief Log-linear (HDR-style) histogram with fixed buckets
+ *
+ * Values are scaled to integers (e.g. a scale of 1000 stores milliseconds at
+ * microsecond resolution). Each power of two is split into 32 linear
+ * sub-buckets, so any reported percentile is within ~3% of the true value.
+ * record() touches two relaxed atomics plus min/max and a release increment
+ * of the count; percentiles are only computed when a snapshot is taken.
+ */
+class Histogram : public Metric {
+ public:
+  struct Bucket {
+    double upperBound;  // inclusive, in recorded units
+    quint64 count;
+  };
+
+  struct Snapshot {
+    quint64 count{0};
+    double sum{0.0};
+    double min{0.0};
+    double max{0.0};
+    QVector<Bucket> buckets;  // non-empty buckets only, ascending
+
+    double mean() const {
+      return count > 0 ? sum / static_cast<double>(count) : 0.0;
+    }
+    double percentile(double p) const;
+  };
+
+  Histogram(const QString& name, const QString& help, const MetricLabels& labels,
+            double scale = 1000.0);
+
+  void record(double value);
+  Snapshot snapshot() const;
+  quint64 count() const {
+    return m_count.load(std::memory_order_relaxed);
+  }
+  double scale() const {
+    return m_scale;
+  }
+
+  static int bucketIndex(quint64 raw);
+  static quint64 bucketUpperBound(int index);
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxValueBits = 40;  // values above 2^40 raw units are clamped
+  static constexpr int kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+  double m_scale;
+  std::array<std::atomic<quint64>, kBucketCount> m_buckets{};
+  std::atomic<quint64> m_count{0};
+  std::atomic<quint64> m_sumRaw{0};
+  std::atomic<quint64> m_minRaw{~quint64(0)};
+  std::atomic<quint64> m_maxRaw{0};
+};
+
+/**
+ * @brief Fixed-capacity ring of timestamped samples
+ *
+ * Appends overwrite the oldest sample in O(1). Intended for periodic
+ * collection (seconds to minutes), so a mutex is sufficient.
+ */
+class TimeSeries : public Metric {
+ public:
+  struct Sample {
+    qint64 timestamp;  // Unix timestamp (milliseconds)
+    double value;
+  };
+
+  TimeSeries(const QString& name, const QString& help, const MetricLabels& labels,
+             const QString& unit, int capacity);
+
+  void append(double value);
+  void append(qint64 timestamp, double value);
+
+  /**
+   * @brief Oldest-first copy of the last @p lastN samples (all if lastN <= 0)
+   */
+  QVector<Sample> samples(int lastN = -1) const;
+
+  double latest() const;
+  double average(int lastN = -1) const;
+  double min(int lastN = -1) const;
+  double max(int lastN = -1) const;
+  int size() const;
+  int capacity() const;
+
+  /**
+   * @brief Drop all samples and resize the ring
+   */
+  void setCapacity(int capacity);
+
+  const QString& unit() const {
+    return m_unit;
+  }
+
+  QJsonObject toJson(int lastN = -1) const;
+
+ private:
+  QVector<Sample> samplesLocked(int lastN) const;
+
+  QString m_unit;
+  QVector<Sample> m_ring;
+  int m_head{0};  // next write position
+  int m_size{0};
+  mutable QMutex m_mutex;
+};
+
+/**
+ * @brief Process-wide registry of named metrics
+ *
+ * Modules register a metric once (registration takes a lock) and keep the
+ * returned reference; updates afterwards are lock-free. Registering the same
+ * name and labels again returns the existing instance. Metrics live as long
+ * as the registry.
+ */
+class MetricsRegistry {
+ public:
+  static MetricsRegistry& instance();
+
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  Counter& counter(const QString& name, const QString& help = QString(),
+                   const MetricLabels& labels = MetricLabels());
+  Gauge& gauge(const QString& name, const QString& help = QString(),
+               const MetricLabels& labels = MetricLabels());
+  Histogram& histogram(const QString& name, const QString& help = QString(),
+                       const MetricLabels& labels = MetricLabels(), double scale = 1000.0);
+  TimeSeries& timeSeries(const QString& name, const QString& unit, int capacity,
+                         const QString& help = QString(),
+                         const MetricLabels& labels = MetricLabels());
+
+  QList<const Counter*> counters() const;
+  QList<const Gauge*> gauges() const;
+  QList<const Histogram*> histograms() const;
+  QList<const TimeSeries*> timeSeries() const;
+
+  /**
+   * @brief Scrape-time JSON view: counters, gauges and histogram percentiles
+   */
+  QJsonObject toJson() const;
+
+  static QString key(const QString& name, const MetricLabels& labels);
+
+ private:
+  template <typename T>
+  QList<const T*> collect(const std::map<QString, std::unique_ptr<T>>& metrics) const;
+
+  mutable QMutex m_mutex;
+  std::map<QString, std::unique_ptr<Counter>> m_counters;
+  std::map<QString, std::unique_ptr<Gauge>> m_gauges;
+  std::map<QString, std::unique_ptr<Histogram>> m_histograms;
+  std::map<QString, std::unique_ptr<TimeSeries>> m_timeSeries;
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
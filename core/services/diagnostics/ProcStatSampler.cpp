@@ -0,0 +1,455 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProcStatSampler.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+// /proc/<pid>/status is ~1.5 KiB; stat is a single short line
+constexpr size_t kReadBufferSize = 4096;
+
+// The kernel keeps the first 15 bytes of a thread name (TASK_COMM_LEN - 1)
+constexpr int kCommLength = 15;
+
+// Named threads and the group each is reported under. The set is fixed so
+// the thread label stays bounded whatever threads libraries start.
+struct NamedThread {
+  const char* name;
+  const char* group;
+};
+constexpr NamedThread kNamedThreads[] = {
+    {"AASDKThread", "aasdk"},
+    {"ProfileWriter", "profile"},
+    {"Thread (pooled)", "pool"},  // QThreadPool workers
+    {"QDBusConnection", "qt"},
+    {"QQmlThread", "qt"},
+    {"QSGRenderThread", "qt"},
+};
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief pread() the whole file at offset 0; returns an empty view on error
+ */
+std::string_view readAt(int fd, char* buffer, size_t size) {
+  if (fd < 0) return {};
+  ssize_t n;
+  do {
+    n = pread(fd, buffer, size - 1, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) return {};
+  return std::string_view(buffer, static_cast<size_t>(n));
+}
+
+bool parseUnsigned(std::string_view token, quint64* value) {
+  const auto result = std::from_chars(token.data(), token.data() + token.size(), *value);
+  return result.ec == std::errc();
+}
+
+quint64 delta(quint64 current, quint64 previous) {
+  return current >= previous ? current - previous : 0;
+}
+
+}  // namespace
+
+ProcStatSampler& ProcStatSampler::instance() {
+  static ProcStatSampler sampler(&MetricsRegistry::instance());
+  return sampler;
+}
+
+ProcStatSampler::ProcStatSampler(MetricsRegistry* registry)
+    : m_registry(registry),
+      m_statFd(open("/proc/self/stat", O_RDONLY | O_CLOEXEC)),
+      m_taskDirFd(open("/proc/self/task", O_RDONLY | O_DIRECTORY | O_CLOEXEC)),
+      m_pid(static_cast<int>(getpid())) {
+  const long ticks = sysconf(_SC_CLK_TCK);
+  if (ticks > 0) m_clockTicks = ticks;
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  if (pageSize > 0) m_pageSize = pageSize;
+}
+
+ProcStatSampler::~ProcStatSampler() {
+  for (auto it = m_threads.begin(); it != m_threads.end(); ++it) {
+    closeThread(&it.value());
+  }
+  if (m_statFd >= 0) close(m_statFd);
+  if (m_taskDirFd >= 0) close(m_taskDirFd);
+}
+
+void ProcStatSampler::setMinimumInterval(int intervalMs) {
+  QMutexLocker locker(&m_mutex);
+  m_minimumIntervalMs = qMax(0, intervalMs);
+}
+
+ProcStatSampler::Sample ProcStatSampler::lastSample() const {
+  QMutexLocker locker(&m_mutex);
+  return m_lastSample;
+}
+
+ProcStatSampler::Sample ProcStatSampler::sample() {
+  QMutexLocker locker(&m_mutex);
+  if (m_haveBaseline && monotonicNs() - m_lastNs < m_minimumIntervalMs * 1000000LL) {
+    return m_lastSample;
+  }
+
+  Sample result = sampleLocked();
+  if (result.valid && m_registry) {
+    publish(result);
+  }
+  m_lastSample = result;
+  return result;
+}
+
+ProcStatSampler::Sample ProcStatSampler::sampleLocked() {
+  Sample result;
+  char buffer[kReadBufferSize];
+
+  StatFields process;
+  if (!parseStat(readAt(m_statFd, buffer, sizeof(buffer)), &process)) {
+    return result;
+  }
+
+  // getrusage() includes threads that have already exited, unlike summing
+  // the per-task status files
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  const quint64 voluntary = static_cast<quint64>(usage.ru_nvcsw);
+  const quint64 involuntary = static_cast<quint64>(usage.ru_nivcsw);
+
+  const qint64 nowNs = monotonicNs();
+  const quint64 cpuTicks = process.userTicks + process.systemTicks;
+  const bool haveBaseline = m_haveBaseline;
+  const double elapsedSeconds = haveBaseline ? (nowNs - m_lastNs) / 1e9 : 0.0;
+
+  result.valid = true;
+  result.timestamp = QDateTime::currentMSecsSinceEpoch();
+  result.intervalMs = elapsedSeconds * 1000.0;
+  result.rssMb = static_cast<double>(process.rssPages) * m_pageSize / (1024.0 * 1024.0);
+  result.threadCount = process.numThreads;
+
+  if (haveBaseline) {
+    if (elapsedSeconds > 0.0) {
+      result.processCpuPercent = static_cast<double>(delta(cpuTicks, m_lastCpuTicks)) /
+                                 m_clockTicks / elapsedSeconds * 100.0;
+    }
+    result.minorFaults = delta(process.minorFaults, m_lastMinorFaults);
+    result.majorFaults = delta(process.majorFaults, m_lastMajorFaults);
+    result.voluntarySwitches = delta(voluntary, m_lastVoluntarySwitches);
+    result.involuntarySwitches = delta(involuntary, m_lastInvoluntarySwitches);
+  } else {
+    // First sample: report totals since process start so counters start correct
+    result.minorFaults = process.minorFaults;
+    result.majorFaults = process.majorFaults;
+    result.voluntarySwitches = voluntary;
+    result.involuntarySwitches = involuntary;
+  }
+
+  scanThreads(&result, elapsedSeconds, haveBaseline);
+
+  m_haveBaseline = true;
+  m_lastNs = nowNs;
+  m_lastCpuTicks = cpuTicks;
+  m_lastMinorFaults = process.minorFaults;
+  m_lastMajorFaults = process.majorFaults;
+  m_lastVoluntarySwitches = voluntary;
+  m_lastInvoluntarySwitches = involuntary;
+  return result;
+}
+
+void ProcStatSampler::scanThreads(Sample* sample, double elapsedSeconds, bool haveBaseline) {
+  if (m_taskDirFd < 0) return;
+
+  // Re-list the task directory through a duplicate so the persistent fd can
+  // be rewound and reused; fdopendir() takes ownership of the duplicate
+  const int listFd = dup(m_taskDirFd);
+  if (listFd < 0) return;
+  lseek(listFd, 0, SEEK_SET);
+  DIR* dir = fdopendir(listFd);
+  if (!dir) {
+    close(listFd);
+    return;
+  }
+
+  ++m_generation;
+  char buffer[kReadBufferSize];
+
+  while (dirent* entry = readdir(dir)) {
+    int tid = 0;
+    const char* name = entry->d_name;
+    const auto parsed = std::from_chars(name, name + strlen(name), tid);
+    if (parsed.ec != std::errc() || tid <= 0) continue;
+
+    auto it = m_threads.find(tid);
+    bool isNew = false;
+    if (it == m_threads.end()) {
+      ThreadEntry thread;
+      const QByteArray statPath = QByteArray::number(tid) + "/stat";
+      const QByteArray statusPath = QByteArray::number(tid) + "/status";
+      thread.statFd = openat(m_taskDirFd, statPath.constData(), O_RDONLY | O_CLOEXEC);
+      thread.statusFd = openat(m_taskDirFd, statusPath.constData(), O_RDONLY | O_CLOEXEC);
+      if (thread.statFd < 0) {
+        closeThread(&thread);
+        continue;
+      }
+      it = m_threads.insert(tid, thread);
+      isNew = true;
+    }
+
+    ThreadEntry& thread = it.value();
+    StatFields fields;
+    if (!parseStat(readAt(thread.statFd, buffer, sizeof(buffer)), &fields)) {
+      continue;  // exited between readdir() and pread(); swept below
+    }
+    quint64 voluntary = thread.voluntarySwitches;
+    quint64 involuntary = thread.involuntarySwitches;
+    parseContextSwitches(readAt(thread.statusFd, buffer, sizeof(buffer)), &voluntary,
+                         &involuntary);
+
+    const quint64 cpuTicks = fields.userTicks + fields.systemTicks;
+    ThreadStats stats;
+    stats.tid = tid;
+    stats.name = fields.comm;
+    stats.group = threadGroup(fields.comm, tid == m_pid);
+
+    // A thread first seen after the baseline started during the interval, so
+    // everything it has accumulated falls inside it
+    if (haveBaseline) {
+      const quint64 previousTicks = isNew ? 0 : thread.cpuTicks;
+      if (elapsedSeconds > 0.0) {
+        stats.cpuPercent = static_cast<double>(delta(cpuTicks, previousTicks)) / m_clockTicks /
+                           elapsedSeconds * 100.0;
+      }
+      stats.majorFaults = delta(fields.majorFaults, isNew ? 0 : thread.majorFaults);
+      stats.voluntarySwitches = delta(voluntary, isNew ? 0 : thread.voluntarySwitches);
+      stats.involuntarySwitches = delta(involuntary, isNew ? 0 : thread.involuntarySwitches);
+    }
+
+    thread.name = fields.comm;
+    thread.cpuTicks = cpuTicks;
+    thread.majorFaults = fields.majorFaults;
+    thread.voluntarySwitches = voluntary;
+    thread.involuntarySwitches = involuntary;
+    thread.generation = m_generation;
+
+    sample->cpuByGroup[stats.group] += stats.cpuPercent;
+    sample->threads.append(stats);
+  }
+  closedir(dir);
+
+  // Drop threads that have exited
+  for (auto it = m_threads.begin(); it != m_threads.end();) {
+    if (it->generation != m_generation) {
+      closeThread(&it.value());
+      it = m_threads.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ProcStatSampler::publish(const Sample& sample) {
+  m_registry->gauge("cpu_usage_percent", "Process CPU usage percentage")
+      .set(sample.processCpuPercent);
+  m_registry->gauge("memory_usage_mb", "Process memory usage in megabytes").set(sample.rssMb);
+  m_registry->gauge("process_threads", "Number of threads in the process")
+      .set(sample.threadCount);
+  m_registry->counter("process_minor_faults_total", "Minor page faults").add(sample.minorFaults);
+  m_registry->counter("process_major_faults_total", "Major page faults").add(sample.majorFaults);
+  m_registry->counter("process_context_switches_total", "Context switches", {{"kind", "voluntary"}})
+      .add(sample.voluntarySwitches);
+  m_registry
+      ->counter("process_context_switches_total", "Context switches", {{"kind", "involuntary"}})
+      .add(sample.involuntarySwitches);
+
+  // Groups that have gone away read as idle rather than keeping a stale value
+  for (auto it = m_threadGauges.begin(); it != m_threadGauges.end(); ++it) {
+    if (!sample.cpuByGroup.contains(it.key())) it.value()->set(0.0);
+  }
+  for (auto it = sample.cpuByGroup.constBegin(); it != sample.cpuByGroup.constEnd(); ++it) {
+    Gauge*& gauge = m_threadGauges[it.key()];
+    if (!gauge) {
+      gauge = &m_registry->gauge("thread_cpu_percent", "CPU usage per named thread group",
+                                 {{"thread", it.key()}});
+    }
+    gauge->set(it.value());
+  }
+}
+
+void ProcStatSampler::closeThread(ThreadEntry* entry) {
+  if (entry->statFd >= 0) close(entry->statFd);
+  if (entry->statusFd >= 0) close(entry->statusFd);
+  entry->statFd = -1;
+  entry->statusFd = -1;
+}
+
+bool ProcStatSampler::parseStat(std::string_view text, StatFields* fields) {
+  // "<pid> (<comm>) <state> ..." - comm may itself contain spaces and ')'
+  const size_t commStart = text.find('(');
+  const size_t commEnd = text.rfind(')');
+  if (commStart == std::string_view::npos || commEnd == std::string_view::npos ||
+      commEnd < commStart) {
+    return false;
+  }
+  fields->comm =
+      QString::fromUtf8(text.data() + commStart + 1, static_cast<int>(commEnd - commStart - 1));
+
+  // Tokens after the comm start at field 3 (state); see proc(5)
+  enum Field {
+    kMinorFaults = 10,
+    kMajorFaults = 12,
+    kUserTicks = 14,
+    kSystemTicks = 15,
+    kNumThreads = 20,
+    kRssPages = 24,
+  };
+
+  std::string_view rest = text.substr(commEnd + 1);
+  int field = 2;
+  size_t pos = 0;
+  while (pos < rest.size() && field < kRssPages) {
+    while (pos < rest.size() && (rest[pos] == ' ' || rest[pos] == '\n')) ++pos;
+    const size_t end = rest.find_first_of(" \n", pos);
+    const std::string_view token =
+        rest.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+    if (token.empty()) break;
+    ++field;
+    pos += token.size();
+
+    quint64 value = 0;
+    switch (field) {
+      case kMinorFaults:
+        if (!parseUnsigned(token, &fields->minorFaults)) return false;
+        break;
+      case kMajorFaults:
+        if (!parseUnsigned(token, &fields->majorFaults)) return false;
+        break;
+      case kUserTicks:
+        if (!parseUnsigned(token, &fields->userTicks)) return false;
+        break;
+      case kSystemTicks:
+        if (!parseUnsigned(token, &fields->systemTicks)) return false;
+        break;
+      case kNumThreads:
+        if (!parseUnsigned(token, &value)) return false;
+        fields->numThreads = static_cast<int>(value);
+        break;
+      case kRssPages:
+        if (!parseUnsigned(token, &fields->rssPages)) return false;
+        break;
+      default:
+        break;
+    }
+  }
+  return field >= kRssPages;
+}
+
+bool ProcStatSampler::parseContextSwitches(std::string_view text, quint64* voluntary,
+                                           quint64* involuntary) {
+  static constexpr std::string_view kVoluntary = "voluntary_ctxt_switches:";
+  static constexpr std::string_view kInvoluntary = "nonvoluntary_ctxt_switches:";
+
+  auto valueAfter = [&text](std::string_view key, quint64* value) {
+    size_t pos = 0;
+    // Match at line start so "voluntary" does not hit "nonvoluntary"
+    while ((pos = text.find(key, pos)) != std::string_view::npos) {
+      if (pos == 0 || text[pos - 1] == '\n') break;
+      pos += key.size();
+    }
+    if (pos == std::string_view::npos) return false;
+    pos += key.size();
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) ++pos;
+    const size_t end = text.find('\n', pos);
+    return parseUnsigned(text.substr(pos, end == std::string_view::npos ? end : end - pos), value);
+  };
+
+  const bool haveVoluntary = valueAfter(kVoluntary, voluntary);
+  const bool haveInvoluntary = valueAfter(kInvoluntary, involuntary);
+  return haveVoluntary && haveInvoluntary;
+}
+
+QString ProcStatSampler::threadGroup(const QString& comm, bool isMainThread) {
+  if (isMainThread) return QStringLiteral("main");
+  // GStreamer names streaming threads "<element>:<pad>" (e.g. "h264parse0:src")
+  // and its task pool threads "gst..."
+  if (comm.contains(':') || comm.startsWith(QLatin1String("gst"))) {
+    return QStringLiteral("gstreamer");
+  }
+  for (const NamedThread& thread : kNamedThreads) {
+    if (comm == QLatin1String(thread.name).left(kCommLength)) {
+      return QLatin1String(thread.group);
+    }
+  }
+  return QStringLiteral("other");
+}
+
+QJsonObject ProcStatSampler::Sample::toJson() const {
+  QJsonObject json;
+  json["timestamp"] = timestamp;
+  json["interval_ms"] = intervalMs;
+  json["cpu_percent"] = processCpuPercent;
+  json["rss_mb"] = rssMb;
+  json["threads_count"] = threadCount;
+  json["minor_faults"] = static_cast<qint64>(minorFaults);
+  json["major_faults"] = static_cast<qint64>(majorFaults);
+  json["voluntary_switches"] = static_cast<qint64>(voluntarySwitches);
+  json["involuntary_switches"] = static_cast<qint64>(involuntarySwitches);
+
+  QJsonObject groups;
+  for (auto it = cpuByGroup.constBegin(); it != cpuByGroup.constEnd(); ++it) {
+    groups[it.key()] = it.value();
+  }
+  json["cpu_by_thread"] = groups;
+
+  QJsonArray threadList;
+  for (const ThreadStats& thread : threads) {
+    QJsonObject entry;
+    entry["tid"] = thread.tid;
+    entry["name"] = thread.name;
+    entry["group"] = thread.group;
+    entry["cpu_percent"] = thread.cpuPercent;
+    entry["major_faults"] = static_cast<qint64>(thread.majorFaults);
+    entry["voluntary_switches"] = static_cast<qint64>(thread.voluntarySwitches);
+    entry["involuntary_switches"] = static_cast<qint64>(thread.involuntarySwitches);
+    threadList.append(entry);
+  }
+  json["threads"] = threadList;
+  return json;
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,170 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <string_view>
+
+#include "MetricsRegistry.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief procfs-based process and per-thread resource accounting
+ *
+ * Keeps file descriptors to /proc/self/stat and to /proc/self/task/<tid>/stat
+ * and status open between samples and re-reads them with pread(), so a
+ * sample costs a handful of syscalls and never forks. CPU usage, page faults
+ * and context switches are reported as deltas against the previous sample.
+ *
+ * Threads are grouped by name into a fixed set, so the metric's label set
+ * stays bounded: the main thread is "main", GStreamer streaming threads
+ * ("element:pad") are "gstreamer", the threads core names itself (QThread
+ * object names such as "AASDKThread" or "ProfileWriter") have a group each,
+ * and every other thread is "other". Results are published to the registry
+ * as thread_cpu_percent{thread="<group>"} plus process-level gauges and
+ * counters; Sample::threads keeps each thread's own name.
+ */
+class ProcStatSampler {
+ public:
+  /**
+   * @brief Fields of interest from a /proc/<pid>/stat line
+   */
+  struct StatFields {
+    QString comm;
+    quint64 minorFaults{0};
+    quint64 majorFaults{0};
+    quint64 userTicks{0};
+    quint64 systemTicks{0};
+    int numThreads{0};
+    quint64 rssPages{0};
+  };
+
+  /**
+   * @brief Per-thread deltas since the previous sample
+   */
+  struct ThreadStats {
+    int tid{0};
+    QString name;
+    QString group;
+    double cpuPercent{0.0};
+    quint64 majorFaults{0};
+    quint64 voluntarySwitches{0};
+    quint64 involuntarySwitches{0};
+  };
+
+  struct Sample {
+    bool valid{false};
+    qint64 timestamp{0};            // Unix timestamp (milliseconds)
+    double intervalMs{0.0};         // wall time covered by the deltas, 0 for the first sample
+    double processCpuPercent{0.0};  // 100 = one core fully busy
+    double rssMb{0.0};
+    int threadCount{0};
+    quint64 minorFaults{0};
+    quint64 majorFaults{0};
+    quint64 voluntarySwitches{0};
+    quint64 involuntarySwitches{0};
+    QVector<ThreadStats> threads;
+    QMap<QString, double> cpuByGroup;
+
+    QJsonObject toJson() const;
+  };
+
+  /**
+   * @brief Sampler publishing to the process-wide registry
+   */
+  static ProcStatSampler& instance();
+
+  /**
+   * @param registry Registry to publish to, or nullptr to only return samples
+   */
+  explicit ProcStatSampler(MetricsRegistry* registry = nullptr);
+  ~ProcStatSampler();
+
+  ProcStatSampler(const ProcStatSampler&) = delete;
+  ProcStatSampler& operator=(const ProcStatSampler&) = delete;
+
+  /**
+   * @brief Read procfs and compute deltas against the previous sample
+   *
+   * Calls closer together than the minimum interval return the previous
+   * sample, so several consumers can share one sampler without shrinking
+   * the interval below the kernel's tick resolution.
+   */
+  Sample sample();
+  Sample lastSample() const;
+
+  void setMinimumInterval(int intervalMs);
+
+  static bool parseStat(std::string_view text, StatFields* fields);
+  static bool parseContextSwitches(std::string_view text, quint64* voluntary,
+                                   quint64* involuntary);
+  static QString threadGroup(const QString& comm, bool isMainThread);
+
+ private:
+  struct ThreadEntry {
+    int statFd{-1};
+    int statusFd{-1};
+    QString name;
+    quint64 cpuTicks{0};
+    quint64 majorFaults{0};
+    quint64 voluntarySwitches{0};
+    quint64 involuntarySwitches{0};
+    quint64 generation{0};
+  };
+
+  Sample sampleLocked();
+  void scanThreads(Sample* sample, double elapsedSeconds, bool haveBaseline);
+  void publish(const Sample& sample);
+  static void closeThread(ThreadEntry* entry);
+
+  MetricsRegistry* m_registry;
+  mutable QMutex m_mutex;
+
+  int m_statFd{-1};
+  int m_taskDirFd{-1};
+  int m_pid{0};
+  long m_clockTicks{100};
+  long m_pageSize{4096};
+  int m_minimumIntervalMs{250};
+
+  QHash<int, ThreadEntry> m_threads;
+  quint64 m_generation{0};
+
+  bool m_haveBaseline{false};
+  qint64 m_lastNs{0};
+  quint64 m_lastCpuTicks{0};
+  quint64 m_lastMinorFaults{0};
+  quint64 m_lastMajorFaults{0};
+  quint64 m_lastVoluntarySwitches{0};
+  quint64 m_lastInvoluntarySwitches{0};
+  Sample m_lastSample;
+
+  QHash<QString, Gauge*> m_threadGauges;
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
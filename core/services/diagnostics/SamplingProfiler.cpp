@@ -0,0 +1,481 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SamplingProfiler.h"
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+#include <cerrno>
+#include <cstring>
+
+#include "../logging/Logger.h"
+#include "StackTrace.h"
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Bounded multi-producer, single-consumer ring of captured stacks
+ *
+ * Producers are SIGPROF handlers on any thread; the consumer is the
+ * profiler's owning thread. Each slot carries a sequence number (Vyukov's
+ * bounded queue), so claiming and publishing a slot is a CAS plus a store
+ * and a full ring drops the sample instead of blocking.
+ */
+struct SampleRing {
+  static constexpr quint64 kCapacity = 2048;  // power of two; ~1 MiB
+
+  struct Slot {
+    std::atomic<quint64> sequence{0};
+    int tid{0};
+    int depth{0};
+    void* frames[SamplingProfiler::kMaxDepth];
+  };
+
+  SampleRing() : slots(new Slot[kCapacity]) {
+    for (quint64 i = 0; i < kCapacity; ++i) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  std::unique_ptr<Slot[]> slots;
+  alignas(64) std::atomic<quint64> writePos{0};
+  alignas(64) quint64 readPos{0};
+  std::atomic<quint64> dropped{0};
+  std::atomic<quint64> handled{0};
+  std::atomic<quint64> handlerNs{0};
+};
+
+namespace {
+
+constexpr int kDrainIntervalMs = 50;
+
+std::atomic<SampleRing*> g_ring{nullptr};
+std::atomic<int> g_handlersRunning{0};
+bool g_handlerInstalled = false;
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+quint64 threadCpuNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<quint64>(ts.tv_sec) * 1000000000ULL + static_cast<quint64>(ts.tv_nsec);
+}
+
+/**
+ * @brief Per-thread CPU clock id for an arbitrary tid (see clock_getcpuclockid(3))
+ */
+clockid_t threadCpuClock(int tid) {
+  constexpr clockid_t kPerThreadSched = 6;  // CPUCLOCK_PERTHREAD_MASK | CPUCLOCK_SCHED
+  return static_cast<clockid_t>((~static_cast<unsigned>(tid)) << 3) | kPerThreadSched;
+}
+
+/**
+ * @brief SIGPROF handler: async-signal-safe, no allocation, no locks
+ */
+void onSigprof(int, siginfo_t*, void* context) {
+  const int savedErrno = errno;
+  // seq_cst pairs with stop(): either stop() sees this handler counted or
+  // the handler sees the ring already unpublished (store-load ordering)
+  g_handlersRunning.fetch_add(1, std::memory_order_seq_cst);
+  SampleRing* ring = g_ring.load(std::memory_order_seq_cst);
+  if (ring) {
+    const quint64 beginNs = threadCpuNs();
+
+    quint64 pos = ring->writePos.load(std::memory_order_relaxed);
+    SampleRing::Slot* slot = nullptr;
+    for (;;) {
+      SampleRing::Slot& candidate = ring->slots[pos & (SampleRing::kCapacity - 1)];
+      const quint64 sequence = candidate.sequence.load(std::memory_order_acquire);
+      const qint64 diff = static_cast<qint64>(sequence - pos);
+      if (diff == 0) {
+        if (ring->writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          slot = &candidate;
+          break;
+        }
+      } else if (diff < 0) {
+        break;  // full
+      } else {
+        pos = ring->writePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    if (slot) {
+      const int depth =
+          stacktrace::captureFromSignal(slot->frames, SamplingProfiler::kMaxDepth, context);
+      slot->depth = depth;
+      slot->tid = static_cast<int>(syscall(SYS_gettid));
+      slot->sequence.store(pos + 1, std::memory_order_release);
+      ring->handled.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ring->handlerNs.fetch_add(threadCpuNs() - beginNs, std::memory_order_relaxed);
+  }
+  g_handlersRunning.fetch_sub(1, std::memory_order_release);
+  errno = savedErrno;
+}
+
+}  // namespace
+
+QJsonObject SamplingProfiler::Result::toJson() const {
+  QJsonObject json;
+  json["valid"] = valid;
+  json["path"] = outputPath;
+  json["duration_ms"] = durationMs;
+  json["samples"] = static_cast<qint64>(samples);
+  json["dropped"] = static_cast<qint64>(dropped);
+  json["unique_stacks"] = uniqueStacks;
+  json["threads"] = threads;
+  json["frequency_hz"] = finalFrequencyHz;
+  json["handler_ns_per_sample"] = handlerNsPerSample;
+  json["overhead_percent"] = overheadPercent;
+  if (!error.isEmpty()) json["error"] = error;
+  return json;
+}
+
+SamplingProfiler::SamplingProfiler(QObject* parent) : QObject(parent) {
+  m_drainTimer.setInterval(kDrainIntervalMs);
+  connect(&m_drainTimer, &QTimer::timeout, this, [this]() {
+    drain();
+    armNewThreads();
+  });
+  m_stopTimer.setSingleShot(true);
+  connect(&m_stopTimer, &QTimer::timeout, this, [this]() {
+    Logger::instance().info("[Profiler] Duration limit reached, stopping");
+    stop();
+  });
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  if (m_running) stop();
+}
+
+bool SamplingProfiler::isRunning() const {
+  return m_running;
+}
+
+bool SamplingProfiler::start(const Options& options, QString* error) {
+  auto fail = [error](const QString& message) {
+    if (error) *error = message;
+    Logger::instance().warning(QString("[Profiler] Not started: %1").arg(message));
+    return false;
+  };
+
+  if (m_running) return fail("already running");
+  if (g_ring.load() != nullptr) return fail("another profiler is running");
+  if (options.frequencyHz <= 0) return fail("frequency must be positive");
+
+  m_options = options;
+  m_options.frequencyHz = qMin(options.frequencyHz, kMaxFrequencyHz);
+  if (m_options.outputPath.isEmpty()) {
+    m_options.outputPath =
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/profiles/" +
+        QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".folded";
+  }
+
+  if (!g_handlerInstalled) {
+    // Installed once and left in place: a timer signal already queued when a
+    // session stops must not hit SIGPROF's default action (terminate)
+    struct sigaction action {};
+    action.sa_sigaction = onSigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+      return fail(QString("sigaction failed: %1").arg(strerror(errno)));
+    }
+    g_handlerInstalled = true;
+  }
+
+  m_ring = std::make_unique<SampleRing>();
+  m_stacks.clear();
+  m_threadNames.clear();
+  m_samples = 0;
+  g_ring.store(m_ring.get(), std::memory_order_release);
+
+  m_running = true;
+  m_frequencyHz = m_options.frequencyHz;
+  m_startNs = monotonicNs();
+  m_stopNs = 0;
+  m_lastBudgetCheckNs = m_startNs;
+  m_lastBudgetHandlerNs = 0;
+  armNewThreads();
+
+  if (m_timers.isEmpty()) {
+    g_ring.store(nullptr, std::memory_order_release);
+    m_running = false;
+    m_ring.reset();
+    return fail("could not create any sampling timers");
+  }
+
+  m_drainTimer.start();
+  if (m_options.maxDurationMs > 0) m_stopTimer.start(m_options.maxDurationMs);
+
+  Logger::instance().info(QString("[Profiler] Sampling %1 thread(s) at %2 Hz (%3 clock) -> %4")
+                              .arg(m_timers.size())
+                              .arg(m_frequencyHz)
+                              .arg(m_options.clock == Clock::Cpu ? "cpu" : "wall")
+                              .arg(m_options.outputPath));
+  emit started(m_frequencyHz);
+  return true;
+}
+
+SamplingProfiler::Result SamplingProfiler::stop() {
+  if (!m_running) {
+    Result result;
+    result.error = "not running";
+    return result;
+  }
+
+  m_drainTimer.stop();
+  m_stopTimer.stop();
+  for (void* timer : std::as_const(m_timers)) {
+    timer_delete(static_cast<timer_t>(timer));
+  }
+  m_timers.clear();
+
+  // Unpublish the ring, then wait for handlers already inside it; both
+  // seq_cst, see onSigprof()
+  g_ring.store(nullptr, std::memory_order_seq_cst);
+  while (g_handlersRunning.load(std::memory_order_seq_cst) > 0) {
+    QThread::usleep(100);
+  }
+
+  m_stopNs = monotonicNs();
+  m_running = false;
+  drain();
+
+  Result result = buildResult();
+  QString error;
+  if (writeFolded(m_options.outputPath, &result.uniqueStacks, &error)) {
+    result.valid = true;
+  } else {
+    result.error = error;
+  }
+  m_ring.reset();
+  m_stacks.clear();
+
+  Logger::instance().info(
+      QString("[Profiler] Stopped: %1 samples (%2 dropped), %3 stacks, overhead %4% -> %5")
+          .arg(result.samples)
+          .arg(result.dropped)
+          .arg(result.uniqueStacks)
+          .arg(result.overheadPercent, 0, 'f', 3)
+          .arg(result.valid ? result.outputPath : result.error));
+  emit finished(result.toJson());
+  return result;
+}
+
+SamplingProfiler::Result SamplingProfiler::status() const {
+  Result result = buildResult();
+  result.valid = m_running;
+  return result;
+}
+
+SamplingProfiler::Result SamplingProfiler::buildResult() const {
+  Result result;
+  result.outputPath = m_options.outputPath;
+  result.finalFrequencyHz = m_frequencyHz;
+  result.samples = m_samples;
+  result.uniqueStacks = m_stacks.size();
+  result.threads = m_threadNames.size();
+  if (!m_ring) return result;
+
+  const qint64 endNs = m_running ? monotonicNs() : m_stopNs;
+  const qint64 elapsedNs = qMax<qint64>(1, endNs - m_startNs);
+  const quint64 handled = m_ring->handled.load(std::memory_order_relaxed);
+  const quint64 handlerNs = m_ring->handlerNs.load(std::memory_order_relaxed);
+  result.durationMs = elapsedNs / 1000000;
+  result.dropped = m_ring->dropped.load(std::memory_order_relaxed);
+  result.handlerNsPerSample = handled > 0 ? static_cast<double>(handlerNs) / handled : 0.0;
+  result.overheadPercent = static_cast<double>(handlerNs) / elapsedNs * 100.0;
+  return result;
+}
+
+void SamplingProfiler::drain() {
+  if (!m_ring) return;
+
+  SampleRing& ring = *m_ring;
+  for (;;) {
+    SampleRing::Slot& slot = ring.slots[ring.readPos & (SampleRing::kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != ring.readPos + 1) break;
+
+    QByteArray key(reinterpret_cast<const char*>(&slot.tid), sizeof(slot.tid));
+    key.append(reinterpret_cast<const char*>(slot.frames), slot.depth * sizeof(void*));
+    ++m_stacks[key];
+    ++m_samples;
+    threadName(slot.tid);  // resolve while the thread is likely still alive
+
+    slot.sequence.store(ring.readPos + SampleRing::kCapacity, std::memory_order_release);
+    ++ring.readPos;
+  }
+
+  if (!m_running) return;
+
+  // Keep handler time within budget by halving the rate
+  const qint64 nowNs = monotonicNs();
+  if (nowNs - m_lastBudgetCheckNs >= 1000000000LL) {
+    const quint64 handlerNs = ring.handlerNs.load(std::memory_order_relaxed);
+    const double percent = static_cast<double>(handlerNs - m_lastBudgetHandlerNs) /
+                           (nowNs - m_lastBudgetCheckNs) * 100.0;
+    m_lastBudgetCheckNs = nowNs;
+    m_lastBudgetHandlerNs = handlerNs;
+    if (percent > m_options.overheadBudgetPercent && m_frequencyHz > 1) {
+      Logger::instance().warning(
+          QString("[Profiler] Overhead %1% over budget, sampling rate %2 -> %3 Hz")
+              .arg(percent, 0, 'f', 2)
+              .arg(m_frequencyHz)
+              .arg(m_frequencyHz / 2));
+      setFrequency(m_frequencyHz / 2);
+    }
+  }
+}
+
+void SamplingProfiler::armNewThreads() {
+  if (!m_running) return;
+
+  const QStringList entries =
+      QDir("/proc/self/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+  QSet<int> alive;
+  for (const QString& entry : entries) {
+    bool ok = false;
+    const int tid = entry.toInt(&ok);
+    if (!ok) continue;
+    alive.insert(tid);
+    if (m_timers.contains(tid) || m_timers.size() >= kMaxThreads) continue;
+
+    sigevent event{};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = tid;
+    const clockid_t clock =
+        m_options.clock == Clock::Cpu ? threadCpuClock(tid) : CLOCK_MONOTONIC;
+
+    timer_t timer;
+    if (timer_create(clock, &event, &timer) != 0) continue;  // thread may have exited
+    m_timers.insert(tid, timer);
+
+    const long intervalNs = 1000000000L / m_frequencyHz;
+    itimerspec spec{};
+    spec.it_interval.tv_sec = intervalNs / 1000000000L;
+    spec.it_interval.tv_nsec = intervalNs % 1000000000L;
+    spec.it_value = spec.it_interval;
+    timer_settime(timer, 0, &spec, nullptr);
+  }
+
+  // Threads that have exited no longer need a timer
+  for (auto it = m_timers.begin(); it != m_timers.end();) {
+    if (!alive.contains(it.key())) {
+      timer_delete(static_cast<timer_t>(it.value()));
+      it = m_timers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void SamplingProfiler::setFrequency(int frequencyHz) {
+  m_frequencyHz = qBound(1, frequencyHz, kMaxFrequencyHz);
+  const long intervalNs = 1000000000L / m_frequencyHz;
+  itimerspec spec{};
+  spec.it_interval.tv_sec = intervalNs / 1000000000L;
+  spec.it_interval.tv_nsec = intervalNs % 1000000000L;
+  spec.it_value = spec.it_interval;
+  for (void* timer : std::as_const(m_timers)) {
+    timer_settime(static_cast<timer_t>(timer), 0, &spec, nullptr);
+  }
+}
+
+QString SamplingProfiler::threadName(int tid) {
+  auto it = m_threadNames.find(tid);
+  if (it != m_threadNames.end()) return it.value();
+
+  QFile comm(QString("/proc/self/task/%1/comm").arg(tid));
+  QString name = comm.open(QIODevice::ReadOnly) ? QString::fromUtf8(comm.readAll()).trimmed()
+                                                : QString();
+  if (tid == static_cast<int>(getpid())) name = "main";
+  if (name.isEmpty()) name = QString("thread-%1").arg(tid);
+  name.replace(';', ':').replace(' ', '_');
+  m_threadNames.insert(tid, name);
+  return name;
+}
+
+bool SamplingProfiler::writeFolded(const QString& path, int* stacks, QString* error) {
+  // Symbolise each distinct address once; merge stacks that only differed by tid
+  QHash<quintptr, QString> symbols;
+  QHash<QString, quint64> folded;
+  for (auto it = m_stacks.constBegin(); it != m_stacks.constEnd(); ++it) {
+    const QByteArray& key = it.key();
+    int tid = 0;
+    memcpy(&tid, key.constData(), sizeof(tid));
+    const int depth = static_cast<int>((key.size() - sizeof(tid)) / sizeof(void*));
+    auto* frames = reinterpret_cast<void* const*>(key.constData() + sizeof(tid));
+
+    QStringList names;
+    names.reserve(depth + 1);
+    names.append(threadName(tid));
+    for (int i = depth - 1; i >= 0; --i) {  // outermost caller first
+      void* frame = nullptr;
+      memcpy(&frame, frames + i, sizeof(frame));
+      QString& symbol = symbols[reinterpret_cast<quintptr>(frame)];
+      if (symbol.isEmpty()) symbol = stacktrace::symbolise(frame, i > 0);
+      names.append(symbol);
+    }
+    folded[names.join(';')] += it.value();
+  }
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    if (error) *error = file.errorString();
+    return false;
+  }
+  for (auto it = folded.constBegin(); it != folded.constEnd(); ++it) {
+    file.write(it.key().toUtf8() + ' ' + QByteArray::number(it.value()) + '\n');
+  }
+  if (!file.commit()) {
+    if (error) *error = file.errorString();
+    return false;
+  }
+  if (stacks) *stacks = folded.size();
+  return true;
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,136 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+namespace crankshaft {
+namespace diagnostics {
+
+struct SampleRing;
+
+/**
+ * @brief Opt-in in-process sampling profiler producing folded stacks
+ *
+ * Every thread of the process gets a POSIX timer (timer_create with
+ * SIGEV_THREAD_ID) on its own CPU-time clock, or on the monotonic clock in
+ * wall mode, which delivers SIGPROF to that thread. The signal handler
+ * walks the stack's frame pointers into a fixed-size lock-free ring; it
+ * never allocates or locks. The owning thread drains the ring periodically,
+ * aggregates identical stacks and, on stop(), symbolises them with dladdr()
+ * and writes one "thread;outer;...;leaf count" line per stack - the folded
+ * format read by flamegraph.pl, speedscope and inferno.
+ *
+ * Overhead is bounded: the rate is capped at kMaxFrequencyHz, at most
+ * kMaxThreads threads are sampled, a session stops itself after its
+ * duration limit, and if the time spent in the handler exceeds the
+ * overhead budget the sampling rate is halved. Time in the handler is
+ * measured and reported with the results.
+ *
+ * Symbol names require the executable to export its symbols (ENABLE_EXPORTS
+ * / -rdynamic); otherwise frames appear as module+offset. Only one profiler
+ * can run per process, since SIGPROF has a single handler.
+ */
+class SamplingProfiler : public QObject {
+  Q_OBJECT
+
+ public:
+  enum class Clock {
+    Cpu,   // per-thread CPU time: where the CPU goes
+    Wall,  // monotonic time: also shows blocked threads
+  };
+
+  struct Options {
+    int frequencyHz{99};
+    int maxDurationMs{60000};
+    Clock clock{Clock::Cpu};
+    double overheadBudgetPercent{2.0};  // of one core, before the rate is halved
+    QString outputPath;                 // default: AppDataLocation/profiles/<timestamp>.folded
+  };
+
+  struct Result {
+    bool valid{false};
+    QString outputPath;
+    qint64 durationMs{0};
+    quint64 samples{0};
+    quint64 dropped{0};
+    int uniqueStacks{0};  // distinct folded lines (raw addresses while running)
+    int threads{0};
+    int finalFrequencyHz{0};
+    double handlerNsPerSample{0.0};
+    double overheadPercent{0.0};  // handler time as a share of one core
+    QString error;
+
+    QJsonObject toJson() const;
+  };
+
+  static constexpr int kMaxFrequencyHz = 1000;
+  static constexpr int kMaxThreads = 64;
+  static constexpr int kMaxDepth = 64;
+
+  explicit SamplingProfiler(QObject* parent = nullptr);
+  ~SamplingProfiler() override;
+
+  bool start(const Options& options, QString* error = nullptr);
+  Result stop();
+  bool isRunning() const;
+
+  /**
+   * @brief Progress of the running session (samples so far, overhead)
+   */
+  Result status() const;
+
+ signals:
+  void started(int frequencyHz);
+  void finished(const QJsonObject& result);  // Result::toJson(), also after auto-stop
+
+ private:
+  void drain();
+  void armNewThreads();
+  void setFrequency(int frequencyHz);
+  Result buildResult() const;
+  QString threadName(int tid);
+  bool writeFolded(const QString& path, int* stacks, QString* error);
+
+  Options m_options;
+  bool m_running{false};
+  int m_frequencyHz{0};
+  qint64 m_startNs{0};
+  qint64 m_stopNs{0};
+  std::unique_ptr<SampleRing> m_ring;
+  QHash<int, void*> m_timers;  // tid -> timer_t
+  QHash<int, QString> m_threadNames;
+  QHash<QByteArray, quint64> m_stacks;  // tid + frame addresses (raw bytes) -> count
+  quint64 m_samples{0};
+  QTimer m_drainTimer;
+  QTimer m_stopTimer;
+  qint64 m_lastBudgetCheckNs{0};
+  quint64 m_lastBudgetHandlerNs{0};
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,148 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StackTrace.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <QFileInfo>
+#include <cstdint>
+#include <cstdlib>
+
+namespace crankshaft {
+namespace diagnostics {
+namespace stacktrace {
+
+namespace {
+
+// A frame further than this above the interrupted stack pointer is garbage
+constexpr uintptr_t kMaxStackBytes = 8 * 1024 * 1024;
+constexpr uintptr_t kProbePageSize = 4096;  // smallest page size; probing finer is harmless
+
+struct Registers {
+  uintptr_t pc{0};
+  uintptr_t fp{0};
+  uintptr_t sp{0};
+};
+
+bool interruptedRegisters(void* context, Registers* regs) {
+  auto* uc = static_cast<ucontext_t*>(context);
+  if (!uc) return false;
+#if defined(__x86_64__)
+  regs->pc = uc->uc_mcontext.gregs[REG_RIP];
+  regs->fp = uc->uc_mcontext.gregs[REG_RBP];
+  regs->sp = uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__i386__)
+  regs->pc = uc->uc_mcontext.gregs[REG_EIP];
+  regs->fp = uc->uc_mcontext.gregs[REG_EBP];
+  regs->sp = uc->uc_mcontext.gregs[REG_ESP];
+#elif defined(__aarch64__)
+  regs->pc = uc->uc_mcontext.pc;
+  regs->fp = uc->uc_mcontext.regs[29];
+  regs->sp = uc->uc_mcontext.sp;
+#elif defined(__arm__)
+  // The 32-bit ARM frame record layout is compiler-specific; report the PC only
+  regs->pc = uc->uc_mcontext.arm_pc;
+#else
+  return false;
+#endif
+  return regs->pc != 0;
+}
+
+/**
+ * @brief True if the word at address can be read, without risking a fault
+ *
+ * process_vm_readv() on our own pid fails with EFAULT instead of raising
+ * SIGSEGV. One probe covers a page; checkedPage remembers the last one.
+ */
+bool readable(uintptr_t address, uintptr_t* checkedPage) {
+  const uintptr_t page = address & ~(kProbePageSize - 1);
+  if (page == *checkedPage) return true;
+  uintptr_t word = 0;
+  iovec local{&word, sizeof(word)};
+  iovec remote{reinterpret_cast<void*>(address), sizeof(word)};
+  if (process_vm_readv(getpid(), &local, 1, &remote, 1, 0) != sizeof(word)) return false;
+  *checkedPage = page;
+  return true;
+}
+
+}  // namespace
+
+int captureFromSignal(void** frames, int maxFrames, void* context) {
+  Registers regs;
+  if (maxFrames <= 0 || !interruptedRegisters(context, &regs)) return 0;
+
+  int depth = 0;
+  frames[depth++] = reinterpret_cast<void*>(regs.pc);
+
+  // Frame record: [fp] = caller's fp, [fp + 1 word] = return address
+  uintptr_t fp = regs.fp;
+  uintptr_t checkedPage = 0;
+  while (depth < maxFrames) {
+    if (fp < regs.sp || fp - regs.sp > kMaxStackBytes || fp % sizeof(uintptr_t) != 0) break;
+    if (!readable(fp, &checkedPage) || !readable(fp + sizeof(uintptr_t), &checkedPage)) break;
+
+    const auto* record = reinterpret_cast<const uintptr_t*>(fp);
+    const uintptr_t callerFp = record[0];
+    const uintptr_t returnAddress = record[1];
+    if (returnAddress == 0) break;
+    frames[depth++] = reinterpret_cast<void*>(returnAddress);
+    if (callerFp <= fp) break;  // stacks grow down, so callers sit higher
+    fp = callerFp;
+  }
+  return depth;
+}
+
+QString symbolise(void* address, bool isReturnAddress) {
+  // Return addresses point after the call; look up the call itself
+  void* lookup = isReturnAddress ? static_cast<char*>(address) - 1 : address;
+  Dl_info info{};
+  if (dladdr(lookup, &info) && info.dli_sname) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    QString name = QString::fromUtf8(status == 0 && demangled ? demangled : info.dli_sname);
+    free(demangled);
+    return name.replace(';', ':');
+  }
+  if (info.dli_fname && info.dli_fbase) {
+    const quintptr offset = reinterpret_cast<quintptr>(address) -
+                            reinterpret_cast<quintptr>(info.dli_fbase);
+    return QString("%1+0x%2")
+        .arg(QFileInfo(QString::fromLocal8Bit(info.dli_fname)).fileName())
+        .arg(offset, 0, 16);
+  }
+  return QString("0x%1").arg(reinterpret_cast<quintptr>(address), 0, 16);
+}
+
+QStringList symbolise(void* const* frames, int depth) {
+  QStringList names;
+  names.reserve(depth);
+  for (int i = 0; i < depth; ++i) {
+    names.append(symbolise(frames[i], i > 0));
+  }
+  return names;
+}
+
+}  // namespace stacktrace
+}  // namespace diagnostics
+}  // namespace crankshaft
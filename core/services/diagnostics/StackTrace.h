@@ -0,0 +1,67 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+namespace crankshaft {
+namespace diagnostics {
+
+/**
+ * @brief Stack capture from signal handlers and symbolisation, shared by
+ * SamplingProfiler and StallWatchdog
+ */
+namespace stacktrace {
+
+/**
+ * @brief Capture the interrupted thread's stack from inside a signal handler
+ *
+ * Walks the frame-pointer chain from the registers saved in the ucontext, so
+ * frames[0] is the interrupted instruction. Async-signal-safe: no unwinder,
+ * loader lock or allocation is involved (backtrace() takes the loader lock in
+ * dl_iterate_phdr and can deadlock a thread interrupted inside dlopen). Every
+ * stack page is checked with process_vm_readv() before it is read.
+ *
+ * Code built without frame pointers (-fno-omit-frame-pointer) ends the chain
+ * early or skips callers; the walk stops at the first frame that does not
+ * lie above the previous one on the interrupted stack.
+ *
+ * @param context The ucontext_t* passed to an SA_SIGINFO handler
+ * @return Number of frames stored
+ */
+int captureFromSignal(void** frames, int maxFrames, void* context);
+
+/**
+ * @brief Function name for an address, demangled, or module+0xoffset
+ *
+ * @param isReturnAddress True for caller frames: the address after the call
+ *        is looked up one byte earlier so it resolves to the calling function
+ */
+QString symbolise(void* address, bool isReturnAddress);
+
+/**
+ * @brief Symbolise a captured stack, innermost frame first
+ */
+QStringList symbolise(void* const* frames, int depth);
+
+}  // namespace stacktrace
+}  // namespace diagnostics
+}  // namespace crankshaft
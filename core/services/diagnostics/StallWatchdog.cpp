@@ -0,0 +1,455 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StallWatchdog.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <QMetaEnum>
+#include <QTimer>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "../logging/Logger.h"
+#include "FlightRecorder.h"
+#include "StackTrace.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+namespace {
+
+constexpr int kMaxStackDepth = 64;
+constexpr int kCaptureTimeoutMs = 100;
+
+// One stack capture at a time, handed from the stalled thread's signal
+// handler to the watchdog thread. g_captureTid names the thread that should
+// capture; whoever swaps it back to 0 (the handler, or the watchdog giving
+// up) owns the capture.
+void* g_captureFrames[kMaxStackDepth];
+std::atomic<int> g_captureTid{0};
+std::atomic<int> g_captureDepth{-1};
+std::atomic<bool> g_captureHandlerInstalled{false};
+
+// Real-time signals are queued and unused by Qt; SIGRTMIN itself is often
+// taken by threading or timer libraries
+int captureSignal() {
+  return SIGRTMIN + 3;
+}
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int currentTid() {
+  return static_cast<int>(syscall(SYS_gettid));
+}
+
+void onCaptureSignal(int, siginfo_t*, void* context) {
+  const int savedErrno = errno;
+  int self = currentTid();
+  if (g_captureTid.compare_exchange_strong(self, 0, std::memory_order_acq_rel)) {
+    const int depth = stacktrace::captureFromSignal(g_captureFrames, kMaxStackDepth, context);
+    g_captureDepth.store(depth, std::memory_order_release);
+  }
+  errno = savedErrno;
+}
+
+bool installCaptureHandler() {
+  if (g_captureHandlerInstalled.load()) return true;
+  struct sigaction action {};
+  action.sa_sigaction = onCaptureSignal;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(captureSignal(), &action, nullptr) != 0) return false;
+  g_captureHandlerInstalled.store(true);
+  return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Stamps a loop's heartbeat from a timer running in that loop
+ *
+ * Retires itself once the loop's generation moves on (unwatched, or the
+ * watchdog stopped).
+ */
+class LoopBeacon : public QObject {
+ public:
+  LoopBeacon(std::shared_ptr<StallWatchdog::Loop> loop, int heartbeatMs)
+      : m_loop(std::move(loop)), m_generation(m_loop->generation.load()) {
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(heartbeatMs);
+    connect(m_timer, &QTimer::timeout, this, [this]() { beat(); });
+  }
+
+  void begin() {
+    beat();
+    m_timer->start();
+  }
+
+ private:
+  void beat() {
+    if (m_loop->generation.load(std::memory_order_relaxed) != m_generation) {
+      m_timer->stop();
+      deleteLater();
+      return;
+    }
+    if (m_loop->tid.load(std::memory_order_relaxed) == 0) {
+      m_loop->tid.store(currentTid(), std::memory_order_relaxed);
+    }
+    m_loop->lastBeatNs.store(monotonicNs(), std::memory_order_release);
+  }
+
+  std::shared_ptr<StallWatchdog::Loop> m_loop;
+  const int m_generation;
+  QTimer* m_timer;
+};
+
+StallWatchdog& StallWatchdog::instance() {
+  static StallWatchdog watchdog(&MetricsRegistry::instance());
+  return watchdog;
+}
+
+StallWatchdog::StallWatchdog(MetricsRegistry* registry, QObject* parent)
+    : QObject(parent), m_registry(registry) {
+}
+
+StallWatchdog::~StallWatchdog() {
+  stop();
+}
+
+bool StallWatchdog::start(const Options& options) {
+  if (m_running.load()) return true;
+
+  m_options = options;
+  m_options.heartbeatMs = qMax(1, m_options.heartbeatMs);
+  m_options.thresholdMs = qMax(m_options.heartbeatMs * 2, m_options.thresholdMs);
+
+  if (!installCaptureHandler()) {
+    Logger::instance().warning(
+        QString("[StallWatchdog] Cannot install stack capture handler: %1")
+            .arg(QString::fromLocal8Bit(strerror(errno))));
+  }
+
+  m_mainLoop = std::make_shared<Loop>();
+  m_mainLoop->name = "main";
+  m_mainLoop->thread = thread();
+  if (QCoreApplication* app = QCoreApplication::instance(); app && app->thread() == thread()) {
+    app->installEventFilter(this);
+  }
+
+  QList<std::shared_ptr<Loop>> loops;
+  {
+    QMutexLocker locker(&m_loopsMutex);
+    m_loops.prepend(m_mainLoop);
+    loops = m_loops;
+  }
+  for (const std::shared_ptr<Loop>& loop : loops) {
+    loop->stalled = false;
+    attachBeacon(loop);
+  }
+
+  m_lastDumpNs = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stopping = false;
+  }
+  m_running.store(true);
+  m_thread = std::thread([this]() { run(); });
+
+  Logger::instance().info(QString("[StallWatchdog] Watching %1 loop(s): heartbeat %2 ms, "
+                                  "threshold %3 ms")
+                              .arg(loops.size())
+                              .arg(m_options.heartbeatMs)
+                              .arg(m_options.thresholdMs));
+  return true;
+}
+
+void StallWatchdog::stop() {
+  if (!m_running.load()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+
+  if (QCoreApplication* app = QCoreApplication::instance()) {
+    app->removeEventFilter(this);
+  }
+
+  // Registered threads stay registered for the next start(); their beacons retire
+  QMutexLocker locker(&m_loopsMutex);
+  m_loops.removeOne(m_mainLoop);
+  m_mainLoop->generation.fetch_add(1);
+  for (const std::shared_ptr<Loop>& loop : m_loops) {
+    loop->generation.fetch_add(1);
+  }
+  m_mainLoop.reset();
+  m_running.store(false);
+}
+
+bool StallWatchdog::isRunning() const {
+  return m_running.load();
+}
+
+void StallWatchdog::watchThread(QThread* thread, const QString& name) {
+  if (!thread || thread == this->thread()) return;  // the main loop is always watched
+
+  auto loop = std::make_shared<Loop>();
+  loop->name = name;
+  loop->thread = thread;
+  {
+    QMutexLocker locker(&m_loopsMutex);
+    for (int i = m_loops.size() - 1; i >= 0; --i) {
+      if (m_loops[i]->thread == thread) {
+        m_loops[i]->generation.fetch_add(1);
+        m_loops.removeAt(i);
+      }
+    }
+    m_loops.append(loop);
+  }
+  if (m_running.load()) attachBeacon(loop);
+}
+
+void StallWatchdog::unwatchThread(QThread* thread) {
+  QMutexLocker locker(&m_loopsMutex);
+  for (int i = m_loops.size() - 1; i >= 0; --i) {
+    if (m_loops[i]->thread == thread && m_loops[i] != m_mainLoop) {
+      m_loops[i]->generation.fetch_add(1);
+      m_loops.removeAt(i);
+    }
+  }
+}
+
+quint64 StallWatchdog::stallCount() const {
+  return m_stallCount.load();
+}
+
+bool StallWatchdog::eventFilter(QObject* watched, QEvent* event) {
+  // Runs for every event delivered on the main thread: a few relaxed stores,
+  // plus the receiver's name for the events that run slots and timers
+  Loop* loop = m_mainLoop.get();
+  if (loop) {
+    loop->receiverClass.store(watched->metaObject()->className(), std::memory_order_relaxed);
+    QObject* parent = watched->parent();
+    loop->parentClass.store(parent ? parent->metaObject()->className() : nullptr,
+                            std::memory_order_relaxed);
+    loop->eventType.store(event->type(), std::memory_order_relaxed);
+    if (event->type() == QEvent::Timer || event->type() == QEvent::MetaCall) {
+      const QString name = watched->objectName();
+      std::lock_guard<std::mutex> lock(loop->receiverNameMutex);
+      loop->receiverName = name;
+    }
+  }
+  return false;
+}
+
+void StallWatchdog::attachBeacon(const std::shared_ptr<Loop>& loop) {
+  loop->tid.store(0);
+  loop->lastBeatNs.store(0);
+
+  auto* beacon = new LoopBeacon(loop, m_options.heartbeatMs);
+  if (loop->thread == thread()) {
+    beacon->setParent(this);
+    beacon->begin();
+    return;
+  }
+
+  beacon->moveToThread(loop->thread);
+  // A finished thread no longer beats, and is not stalled either
+  connect(
+      loop->thread, &QThread::finished, beacon, [loop]() { loop->lastBeatNs.store(0); },
+      Qt::DirectConnection);
+  connect(loop->thread, &QThread::finished, beacon, &QObject::deleteLater);
+  QMetaObject::invokeMethod(beacon, [beacon]() { beacon->begin(); }, Qt::QueuedConnection);
+}
+
+void StallWatchdog::run() {
+  const auto period = std::chrono::milliseconds(qMax(5, m_options.heartbeatMs / 2));
+  std::unique_lock<std::mutex> lock(m_wakeMutex);
+  while (!m_wake.wait_for(lock, period, [this]() { return m_stopping; })) {
+    lock.unlock();
+    QList<std::shared_ptr<Loop>> loops;
+    {
+      QMutexLocker locker(&m_loopsMutex);
+      loops = m_loops;
+    }
+    const qint64 nowNs = monotonicNs();
+    for (const std::shared_ptr<Loop>& loop : loops) {
+      checkLoop(*loop, nowNs);
+    }
+    lock.lock();
+  }
+}
+
+void StallWatchdog::checkLoop(Loop& loop, qint64 nowNs) {
+  const qint64 beatNs = loop.lastBeatNs.load(std::memory_order_acquire);
+  if (beatNs == 0) {
+    loop.stalled = false;
+    return;
+  }
+
+  if (!loop.stalled) {
+    if (nowNs - beatNs >= static_cast<qint64>(m_options.thresholdMs) * 1000000LL) {
+      loop.stalled = true;
+      loop.stallBeatNs = beatNs;
+      onStallStart(loop, nowNs);
+    }
+    return;
+  }
+  if (beatNs == loop.stallBeatNs) return;
+
+  // Beating again. The gap between the two beats includes one ordinary
+  // heartbeat interval, which is not part of the stall.
+  loop.stalled = false;
+  const double gapMs = static_cast<double>(beatNs - loop.stallBeatNs) / 1e6;
+  const double durationMs = qMax(0.0, gapMs - m_options.heartbeatMs);
+
+  QVariantMap stall;
+  stall["loop"] = loop.name;
+  stall["duration_ms"] = durationMs;
+  stall["threshold_ms"] = m_options.thresholdMs;
+  stall["thread_id"] = loop.tid.load();
+  stall["activity"] = loop.activity;
+  stall["stack"] = loop.stack;
+  stall["flight_dump"] = loop.flightDump;
+  stall["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+  QMetaObject::invokeMethod(this, [this, stall]() { reportStall(stall); }, Qt::QueuedConnection);
+}
+
+void StallWatchdog::onStallStart(Loop& loop, qint64 nowNs) {
+  m_stallCount.fetch_add(1);
+  const qint64 sinceBeatMs = (nowNs - loop.stallBeatNs) / 1000000LL;
+  const int tid = loop.tid.load();
+
+  loop.activity.clear();
+  if (const char* receiver = loop.receiverClass.load(std::memory_order_relaxed)) {
+    loop.activity["receiver"] = QString::fromLatin1(receiver);
+    const char* parent = loop.parentClass.load(std::memory_order_relaxed);
+    loop.activity["parent"] = parent ? QString::fromLatin1(parent) : QString();
+    const int type = loop.eventType.load(std::memory_order_relaxed);
+    const char* key = QMetaEnum::fromType<QEvent::Type>().valueToKey(type);
+    loop.activity["event"] = key ? QString::fromLatin1(key) : QString::number(type);
+    std::lock_guard<std::mutex> lock(loop.receiverNameMutex);
+    loop.activity["object_name"] = loop.receiverName;
+  }
+
+  loop.stack = captureStack(tid);
+
+  const uint32_t stalledMs = static_cast<uint32_t>(sinceBeatMs);
+  FlightRecorder::instance().record(flight::Event::LoopStall, 0, stalledMs,
+                                    static_cast<uint64_t>(tid));
+
+  // Dumps are for the first stall of a burst; the rest only reach the ring
+  loop.flightDump.clear();
+  const qint64 intervalNs = static_cast<qint64>(m_options.dumpIntervalMs) * 1000000LL;
+  if (m_options.dumpFlightRecorder && (m_lastDumpNs == 0 || nowNs - m_lastDumpNs >= intervalNs)) {
+    m_lastDumpNs = nowNs;
+    loop.flightDump = writeStallDump(static_cast<uint16_t>(qMin<uint32_t>(stalledMs, 65535)));
+  }
+}
+
+QStringList StallWatchdog::captureStack(int tid) {
+  if (tid <= 0 || !g_captureHandlerInstalled.load()) return QStringList();
+
+  g_captureDepth.store(-1, std::memory_order_relaxed);
+  g_captureTid.store(tid, std::memory_order_release);
+  if (syscall(SYS_tgkill, getpid(), tid, captureSignal()) != 0) {
+    g_captureTid.store(0);
+    return QStringList();
+  }
+
+  const qint64 deadlineNs = monotonicNs() + kCaptureTimeoutMs * 1000000LL;
+  while (g_captureDepth.load(std::memory_order_acquire) < 0 && monotonicNs() < deadlineNs) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (g_captureDepth.load(std::memory_order_acquire) < 0) {
+    int expected = tid;
+    if (g_captureTid.compare_exchange_strong(expected, 0)) {
+      return QStringList();  // the handler never ran (signal blocked, thread exiting)
+    }
+    // The handler claimed the capture and is finishing it
+    while (g_captureDepth.load(std::memory_order_acquire) < 0) std::this_thread::yield();
+  }
+  return stacktrace::symbolise(g_captureFrames, g_captureDepth.load());
+}
+
+QString StallWatchdog::writeStallDump(uint16_t stalledMs) {
+  // Runs on the watchdog thread: no Logger, failures just leave no dump
+  FlightRecorder& recorder = FlightRecorder::instance();
+  const QString directory = recorder.dumpDirectory();
+  if (!QDir().mkpath(directory)) return QString();
+
+  const QString path =
+      directory +
+      QString("/stall-%1.bin").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz"));
+  const int fd = ::open(QFile::encodeName(path).constData(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return QString();
+  const bool ok = recorder.writeDump(fd, flight::DumpReason::Stall, stalledMs);
+  ::close(fd);
+  if (!ok) {
+    QFile::remove(path);
+    return QString();
+  }
+  return path;
+}
+
+void StallWatchdog::reportStall(const QVariantMap& stall) {
+  const QString loop = stall.value("loop").toString();
+  const double durationMs = stall.value("duration_ms").toDouble();
+  if (m_registry) {
+    m_registry->histogram("event_loop_stall_ms", "Event loop stall duration in milliseconds",
+                          {{"loop", loop}})
+        .record(durationMs);
+    m_registry->counter("event_loop_stalls_total", "Event loop stalls", {{"loop", loop}}).add(1);
+  }
+
+  const QStringList stack = stall.value("stack").toStringList();
+  const QVariantMap activity = stall.value("activity").toMap();
+  QString where = stack.isEmpty() ? QString("unknown") : stack.first();
+  if (!activity.isEmpty()) {
+    where += QString(" (%1 event to %2)")
+                 .arg(activity.value("event").toString(), activity.value("receiver").toString());
+  }
+  Logger::instance().warning(QString("[StallWatchdog] %1 loop stalled for %2 ms in %3")
+                                 .arg(loop)
+                                 .arg(durationMs, 0, 'f', 1)
+                                 .arg(where));
+  emit stallEnded(stall);
+}
+
+}  // namespace diagnostics
+}  // namespace crankshaft
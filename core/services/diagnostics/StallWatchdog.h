@@ -0,0 +1,153 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVariantMap>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "MetricsRegistry.h"
+
+namespace crankshaft {
+namespace diagnostics {
+
+class LoopBeacon;
+
+/**
+ * @brief Detects stalled event loops and captures what they were doing
+ *
+ * Each watched loop runs a beacon timer that stamps a heartbeat every
+ * heartbeatMs. A watchdog thread checks the stamps; when a loop has not
+ * beaten for thresholdMs it is stalled, and the watchdog:
+ *  - sends the loop's thread a signal whose handler captures its stack,
+ *  - notes the event being delivered (main loop only, via an application
+ *    event filter: receiver class, its parent's class and the event type),
+ *  - records a flight recorder event and, at most once per dump interval,
+ *    dumps the flight recorder.
+ *
+ * When the loop beats again the stall's duration goes into the
+ * event_loop_stall_ms{loop} histogram and stallEnded() is emitted on the
+ * watchdog object's thread; main.cpp publishes it as diagnostics/stall.
+ */
+class StallWatchdog : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Options {
+    int heartbeatMs{20};
+    int thresholdMs{250};
+    bool dumpFlightRecorder{true};
+    int dumpIntervalMs{60000};  // minimum time between stall dumps
+  };
+
+  static StallWatchdog& instance();
+
+  explicit StallWatchdog(MetricsRegistry* registry = nullptr, QObject* parent = nullptr);
+  ~StallWatchdog() override;
+
+  /**
+   * @brief Start watching; the thread this object lives in is watched as "main"
+   */
+  bool start(const Options& options);
+  void stop();
+  bool isRunning() const;
+
+  /**
+   * @brief Watch another thread's event loop; safe to call before start()
+   *
+   * Call from this object's thread. The thread may not be running yet; its
+   * beacon starts with its event loop. Watching stops when the thread
+   * finishes; watch it again after restarting it.
+   */
+  void watchThread(QThread* thread, const QString& name);
+  void unwatchThread(QThread* thread);
+
+  quint64 stallCount() const;
+
+ signals:
+  /**
+   * @brief A stall ended: loop, duration_ms, threshold_ms, thread_id,
+   * activity {receiver, parent, event}, stack, flight_dump
+   */
+  void stallEnded(const QVariantMap& stall);
+
+ protected:
+  bool eventFilter(QObject* watched, QEvent* event) override;
+
+ private:
+  friend class LoopBeacon;
+
+  // Per-loop state shared by the loop's beacon, the watchdog thread and this object
+  struct Loop {
+    QString name;
+    QThread* thread{nullptr};
+    std::atomic<int> generation{0};     // bumped to retire the loop's beacon
+    std::atomic<qint64> lastBeatNs{0};  // 0: not beating yet, or the thread has finished
+    std::atomic<int> tid{0};
+    // Main loop only: the latest event delivered; class names have static storage
+    std::atomic<const char*> receiverClass{nullptr};
+    std::atomic<const char*> parentClass{nullptr};
+    std::atomic<int> eventType{0};
+    std::mutex receiverNameMutex;
+    QString receiverName;  // objectName of timer and queued-call receivers
+
+    // Watchdog thread only
+    bool stalled{false};
+    qint64 stallBeatNs{0};
+    QStringList stack;
+    QVariantMap activity;
+    QString flightDump;
+  };
+
+  void attachBeacon(const std::shared_ptr<Loop>& loop);
+  void run();
+  void checkLoop(Loop& loop, qint64 nowNs);
+  void onStallStart(Loop& loop, qint64 nowNs);
+  QStringList captureStack(int tid);
+  QString writeStallDump(uint16_t stalledMs);
+  void reportStall(const QVariantMap& stall);
+
+  MetricsRegistry* m_registry;
+  Options m_options;
+  std::shared_ptr<Loop> m_mainLoop;
+
+  mutable QMutex m_loopsMutex;
+  QList<std::shared_ptr<Loop>> m_loops;
+
+  std::thread m_thread;
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  bool m_stopping{false};
+  std::atomic<bool> m_running{false};
+  std::atomic<quint64> m_stallCount{0};
+  qint64 m_lastDumpNs{0};
+};
+
+}  // namespace diagnostics
+}  // namespace crankshaft
@@ -0,0 +1,164 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StartupTracer.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <ctime>
+
+namespace {
+
+thread_local int t_depth = 0;
+
+// Bounds memory if finish() is never called
+constexpr int kMaxSpans = 4096;
+
+}  // namespace
+
+StartupTracer& StartupTracer::instance() {
+  static StartupTracer tracer;
+  return tracer;
+}
+
+StartupTracer::StartupTracer() : m_originNs(nowNs()) {
+}
+
+qint64 StartupTracer::nowNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+qint64 StartupTracer::currentThreadId() {
+  static thread_local const qint64 tid = static_cast<qint64>(::syscall(SYS_gettid));
+  return tid;
+}
+
+void StartupTracer::record(const QByteArray& name, qint64 startNs, qint64 endNs, int depth) {
+  if (!isRecording()) return;
+
+  Span span;
+  span.name = name;
+  span.startNs = startNs;
+  span.durationNs = qMax<qint64>(0, endNs - startNs);
+  span.threadId = currentThreadId();
+  span.depth = depth;
+
+  QMutexLocker locker(&m_mutex);
+  if (m_spans.size() < kMaxSpans) {
+    m_spans.append(span);
+  }
+}
+
+void StartupTracer::mark(const QByteArray& name) {
+  const qint64 now = nowNs();
+  record(name, now, now, t_depth);
+}
+
+void StartupTracer::finish() {
+  m_recording.store(false, std::memory_order_relaxed);
+}
+
+void StartupTracer::reset() {
+  QMutexLocker locker(&m_mutex);
+  m_spans.clear();
+  m_originNs = nowNs();
+  m_recording.store(true, std::memory_order_relaxed);
+}
+
+QList<StartupTracer::Span> StartupTracer::spans() const {
+  QMutexLocker locker(&m_mutex);
+  return m_spans;
+}
+
+QByteArray StartupTracer::toChromeTrace() const {
+  QMutexLocker locker(&m_mutex);
+  const qint64 pid = ::getpid();
+
+  QJsonArray events;
+  for (const auto& span : m_spans) {
+    QJsonObject event;
+    event["name"] = QString::fromUtf8(span.name);
+    event["cat"] = "startup";
+    event["ph"] = span.durationNs > 0 ? "X" : "i";
+    // Chrome trace timestamps are microseconds; keep sub-microsecond precision
+    event["ts"] = static_cast<double>(span.startNs - m_originNs) / 1000.0;
+    if (span.durationNs > 0) {
+      event["dur"] = static_cast<double>(span.durationNs) / 1000.0;
+    } else {
+      event["s"] = "t";
+    }
+    event["pid"] = pid;
+    event["tid"] = span.threadId;
+    event["args"] = QJsonObject{{"depth", span.depth}};
+    events.append(event);
+  }
+
+  QJsonObject root;
+  root["traceEvents"] = events;
+  root["displayTimeUnit"] = "ms";
+  return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool StartupTracer::writeChromeTrace(const QString& path) const {
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  file.write(toChromeTrace());
+  return file.commit();
+}
+
+QVariantMap StartupTracer::summary() const {
+  QMutexLocker locker(&m_mutex);
+
+  QVariantMap phases;
+  qint64 endNs = m_originNs;
+  for (const auto& span : m_spans) {
+    endNs = qMax(endNs, span.startNs + span.durationNs);
+    if (span.depth != 0 || span.durationNs == 0) continue;
+    const QString name = QString::fromUtf8(span.name);
+    phases[name] = phases.value(name).toDouble() + span.durationNs / 1e6;
+  }
+
+  QVariantMap result;
+  result["phases"] = phases;
+  result["spanCount"] = m_spans.size();
+  result["totalMs"] = (endNs - m_originNs) / 1e6;
+  return result;
+}
+
+StartupPhase::StartupPhase(const char* name) : m_name(name) {
+  if (!StartupTracer::instance().isRecording()) return;
+  m_depth = t_depth++;
+  m_startNs = StartupTracer::nowNs();
+}
+
+StartupPhase::~StartupPhase() {
+  if (m_depth < 0) return;
+  --t_depth;
+  StartupTracer::instance().record(QByteArray(m_name), m_startNs, StartupTracer::nowNs(), m_depth);
+}
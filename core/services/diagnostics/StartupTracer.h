@@ -0,0 +1,132 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+#include <atomic>
+
+/**
+ * @brief Structured startup phase tracer
+ *
+ * Records named spans with CLOCK_MONOTONIC timestamps, the kernel thread id
+ * and nesting depth. Spans are collected from process start until finish()
+ * is called (normally at READY), after which recording is a no-op so code
+ * paths that also run later (profile reloads, service restarts) cost nothing.
+ *
+ * The trace can be written in Chrome trace event format (load it in
+ * chrome://tracing or https://ui.perfetto.dev), and summary() condenses
+ * the top-level phases into a map suitable for the EventBus.
+ */
+class StartupTracer {
+ public:
+  struct Span {
+    QByteArray name;
+    qint64 startNs{0};
+    qint64 durationNs{0};
+    qint64 threadId{0};
+    int depth{0};
+  };
+
+  static StartupTracer& instance();
+
+  /**
+   * @brief Monotonic clock in nanoseconds (same clock for all threads)
+   */
+  static qint64 nowNs();
+
+  /**
+   * @brief Kernel thread id of the calling thread
+   */
+  static qint64 currentThreadId();
+
+  bool isRecording() const {
+    return m_recording.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Record a completed span (for work that does not fit a scope)
+   */
+  void record(const QByteArray& name, qint64 startNs, qint64 endNs, int depth = 0);
+
+  /**
+   * @brief Record a zero-length marker
+   */
+  void mark(const QByteArray& name);
+
+  /**
+   * @brief Stop recording; the collected spans stay available
+   */
+  void finish();
+
+  /**
+   * @brief Drop all spans and start recording again
+   */
+  void reset();
+
+  QList<Span> spans() const;
+
+  /**
+   * @brief Chrome trace event JSON ("X" complete events, "i" instants)
+   */
+  QByteArray toChromeTrace() const;
+
+  /**
+   * @brief Atomically write toChromeTrace() to @p path
+   */
+  bool writeChromeTrace(const QString& path) const;
+
+  /**
+   * @brief Top-level (depth 0) phase durations in milliseconds, plus total
+   */
+  QVariantMap summary() const;
+
+ private:
+  StartupTracer();
+
+  mutable QMutex m_mutex;
+  QList<Span> m_spans;
+  qint64 m_originNs;
+  std::atomic<bool> m_recording{true};
+};
+
+/**
+ * @brief RAII startup phase marker
+ *
+ * Nested phases on the same thread are recorded with increasing depth.
+ * When the tracer is no longer recording the constructor and destructor
+ * reduce to a relaxed atomic load.
+ */
+class StartupPhase {
+ public:
+  explicit StartupPhase(const char* name);
+  ~StartupPhase();
+
+  StartupPhase(const StartupPhase&) = delete;
+  StartupPhase& operator=(const StartupPhase&) = delete;
+
+ private:
+  const char* m_name;
+  qint64 m_startNs{0};
+  int m_depth{-1};
+};
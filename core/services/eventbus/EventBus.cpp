@@ -21,6 +21,8 @@
 
 #include <QMutexLocker>
 
+#include "../diagnostics/FlightRecorder.h"
+
 EventBus& EventBus::instance() {
   static EventBus instance;
   return instance;
@@ -28,5 +30,8 @@ EventBus& EventBus::instance() {
 
 void EventBus::publish(const QString& topic, const QVariantMap& payload) {
   QMutexLocker locker(&m_mutex);
+  crankshaft::diagnostics::FlightRecorder::instance().record(
+      crankshaft::diagnostics::flight::Event::EventBusPublish, 0,
+      crankshaft::diagnostics::FlightRecorder::topicHash(topic), ++m_publishCount);
   emit messagePublished(topic, payload);
 }
@@ -40,4 +40,5 @@ class EventBus : public QObject {
   EventBus& operator=(const EventBus&) = delete;
 
   QMutex m_mutex;
+  quint64 m_publishCount{0};
 };
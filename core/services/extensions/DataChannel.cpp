@@ -0,0 +1,145 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DataChannel.h"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "../diagnostics/MetricsRegistry.h"
+
+namespace {
+
+QString errnoString(const char* what) {
+  return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(strerror(errno)));
+}
+
+}  // namespace
+
+DataChannel::DataChannel(const QString& extensionId, quint32 capacity)
+    : m_extensionId(extensionId), m_capacity(capacity) {}
+
+DataChannel::~DataChannel() {
+  if (m_mapping) munmap(m_mapping, mappingSize());
+  if (m_memoryFd >= 0) close(m_memoryFd);
+  if (m_eventFd >= 0) close(m_eventFd);
+}
+
+std::unique_ptr<DataChannel> DataChannel::create(const QString& extensionId, quint32 capacity,
+                                                 crankshaft::diagnostics::MetricsRegistry* registry,
+                                                 QString* error) {
+  if (!datachannel::isValidCapacity(capacity)) {
+    if (error) {
+      *error = QStringLiteral("Capacity must be a power of two between %1 and %2 bytes")
+                   .arg(datachannel::kMinCapacity)
+                   .arg(datachannel::kMaxCapacity);
+    }
+    return nullptr;
+  }
+
+  std::unique_ptr<DataChannel> channel(new DataChannel(extensionId, capacity));
+  const QByteArray name = QStringLiteral("crankshaft-channel-%1").arg(extensionId).toUtf8();
+  channel->m_memoryFd = memfd_create(name.constData(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (channel->m_memoryFd < 0) {
+    if (error) *error = errnoString("memfd_create");
+    return nullptr;
+  }
+  if (ftruncate(channel->m_memoryFd, static_cast<off_t>(channel->mappingSize())) != 0 ||
+      fcntl(channel->m_memoryFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+    if (error) *error = errnoString("memfd sizing");
+    return nullptr;
+  }
+
+  void* mapping = mmap(nullptr, channel->mappingSize(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                       channel->m_memoryFd, 0);
+  if (mapping == MAP_FAILED) {
+    if (error) *error = errnoString("mmap");
+    return nullptr;
+  }
+  channel->m_mapping = mapping;
+
+  // Non-blocking so a reader that never drains it cannot stall a publisher
+  channel->m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (channel->m_eventFd < 0) {
+    if (error) *error = errnoString("eventfd");
+    return nullptr;
+  }
+
+  channel->m_header = datachannel::initialise(mapping, capacity);
+  channel->m_producer = std::make_unique<datachannel::Producer>(channel->m_header);
+
+  if (registry) {
+    const crankshaft::diagnostics::MetricLabels labels{{QStringLiteral("extension"), extensionId}};
+    channel->m_recordsCounter =
+        &registry->counter(QStringLiteral("extension_channel_records_total"),
+                           QStringLiteral("Records written to an extension data channel"), labels);
+    channel->m_droppedCounter = &registry->counter(
+        QStringLiteral("extension_channel_dropped_total"),
+        QStringLiteral("Records dropped because an extension data channel was full"), labels);
+  }
+  return channel;
+}
+
+bool DataChannel::publish(quint16 topic, datachannel::Kind kind, const void* data, quint32 size,
+                          quint64 timestampNs, quint32 format, quint32 meta) {
+  bool wakeReader = false;
+  bool written;
+  {
+    QMutexLocker locker(&m_mutex);
+    written =
+        m_producer->publish(topic, kind, data, size, timestampNs, format, meta, &wakeReader);
+  }
+
+  if (!written) {
+    if (m_droppedCounter) m_droppedCounter->add();
+    return false;
+  }
+  if (m_recordsCounter) m_recordsCounter->add();
+  if (wakeReader) {
+    const uint64_t one = 1;
+    // EAGAIN only means the counter is already non-zero, i.e. a wakeup is pending
+    [[maybe_unused]] const ssize_t ignored = write(m_eventFd, &one, sizeof(one));
+  }
+  return true;
+}
+
+quint64 DataChannel::published() const {
+  return m_header->published.load(std::memory_order_relaxed);
+}
+
+quint64 DataChannel::dropped() const {
+  return m_header->dropped.load(std::memory_order_relaxed);
+}
+
+QJsonObject DataChannel::status() const {
+  const quint64 write = m_header->writeIndex.load(std::memory_order_relaxed);
+  const quint64 read = m_header->readIndex.load(std::memory_order_relaxed);
+  QJsonObject obj;
+  obj.insert(QStringLiteral("capacity"), static_cast<qint64>(m_capacity));
+  obj.insert(QStringLiteral("published"), static_cast<qint64>(published()));
+  obj.insert(QStringLiteral("dropped"), static_cast<qint64>(dropped()));
+  obj.insert(QStringLiteral("pending_bytes"),
+             static_cast<qint64>(read <= write ? write - read : 0));
+  return obj;
+}
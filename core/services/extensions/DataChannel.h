@@ -0,0 +1,107 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATACHANNEL_H
+#define DATACHANNEL_H
+
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <memory>
+
+#include "DataChannelFormat.h"
+
+namespace crankshaft {
+namespace diagnostics {
+class Counter;
+class MetricsRegistry;
+}
+}  // namespace crankshaft
+
+/**
+ * @brief Core end of one extension's shared-memory ring
+ *
+ * The ring lives in a sealed memfd (it can be neither shrunk nor grown, so the
+ * extension cannot fault the core by truncating it) and the reader is woken
+ * through an eventfd, only when it announced that it is asleep. Both
+ * descriptors are handed to the extension once, during negotiation.
+ * publish() may be called from any thread.
+ */
+class DataChannel {
+ public:
+  /**
+   * @param registry Receives extension_channel_{records,dropped}_total{extension}
+   * @return The channel, or nullptr with error set
+   */
+  static std::unique_ptr<DataChannel> create(
+      const QString& extensionId, quint32 capacity,
+      crankshaft::diagnostics::MetricsRegistry* registry = nullptr, QString* error = nullptr);
+  ~DataChannel();
+
+  DataChannel(const DataChannel&) = delete;
+  DataChannel& operator=(const DataChannel&) = delete;
+
+  /**
+   * @brief Copy one record into the ring, waking the reader if needed
+   * @return False when the record was dropped for lack of space
+   */
+  bool publish(quint16 topic, datachannel::Kind kind, const void* data, quint32 size,
+               quint64 timestampNs, quint32 format = 0, quint32 meta = 0);
+
+  QString extensionId() const {
+    return m_extensionId;
+  }
+  int memoryFd() const {
+    return m_memoryFd;
+  }
+  int eventFd() const {
+    return m_eventFd;
+  }
+  quint32 capacity() const {
+    return m_capacity;
+  }
+  quint64 mappingSize() const {
+    return datachannel::mappingSize(m_capacity);
+  }
+
+  quint64 published() const;
+  quint64 dropped() const;
+
+  /**
+   * @brief capacity, published, dropped and the bytes the reader has yet to consume
+   */
+  QJsonObject status() const;
+
+ private:
+  DataChannel(const QString& extensionId, quint32 capacity);
+
+  QString m_extensionId;
+  quint32 m_capacity;
+  int m_memoryFd{-1};
+  int m_eventFd{-1};
+  void* m_mapping{nullptr};
+  datachannel::ChannelHeader* m_header{nullptr};
+  std::unique_ptr<datachannel::Producer> m_producer;
+  QMutex m_mutex;  // one writer at a time
+
+  crankshaft::diagnostics::Counter* m_recordsCounter{nullptr};
+  crankshaft::diagnostics::Counter* m_droppedCounter{nullptr};
+};
+
+#endif  // DATACHANNEL_H
@@ -0,0 +1,378 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATACHANNELFORMAT_H
+#define DATACHANNELFORMAT_H
+
+// Shared-memory layout of an extension data channel, plus the producer and
+// consumer halves of the ring. Deliberately free of Qt so extensions can
+// include it on its own.
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace datachannel {
+
+constexpr uint32_t kMagic = 0x48434443;  // "CDCH"
+constexpr uint16_t kVersion = 1;
+constexpr uint32_t kMinCapacity = 4096;
+constexpr uint32_t kMaxCapacity = 64u << 20;
+
+enum class Kind : uint16_t {
+  Telemetry = 1,  // payload is one or more TelemetrySample
+  Blob = 2,       // opaque payload; format and meta describe it
+  Padding = 0xffff,
+};
+
+// Blob formats. A decoded video frame carries width << 16 | height in meta.
+constexpr uint32_t fourcc(char a, char b, char c, char d) {
+  return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 |
+         static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+constexpr uint32_t kFormatRgba = fourcc('R', 'G', 'B', 'A');
+constexpr uint32_t kFormatPcmS16 = fourcc('S', '1', '6', 'L');
+
+/**
+ * @brief One telemetry value at its native rate
+ *
+ * signal identifies the value within the topic (e.g. a DBC signal index);
+ * flags is topic-defined, bit 0 meaning "value invalid".
+ */
+struct TelemetrySample {
+  uint64_t timestampNs;  // CLOCK_MONOTONIC
+  uint32_t signal;
+  uint32_t flags;
+  double value;
+};
+static_assert(sizeof(TelemetrySample) == 24, "telemetry samples must stay 24 bytes");
+
+/**
+ * @brief Header in front of every record in the ring
+ *
+ * The payload follows, padded to 8 bytes. sequence counts every record the
+ * core tried to publish on this channel, dropped ones included, so a gap in
+ * sequence is exactly the number of records lost.
+ */
+struct RecordHeader {
+  uint32_t size;  // payload bytes
+  uint16_t kind;
+  uint16_t topic;  // id from the negotiation reply
+  uint64_t sequence;
+  uint64_t timestampNs;  // CLOCK_MONOTONIC
+  uint32_t format;
+  uint32_t meta;
+};
+static_assert(sizeof(RecordHeader) == 32, "record headers must stay 32 bytes");
+static_assert(std::is_trivially_copyable_v<RecordHeader>);
+
+/**
+ * @brief Start of the mapping; the ring of `capacity` bytes follows
+ *
+ * Indices are byte offsets that only grow; the position in the ring is the
+ * index modulo capacity. Producer and consumer fields live on separate cache
+ * lines.
+ */
+struct ChannelHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  uint32_t capacity;    // power of two
+  uint32_t maxPayload;  // larger records are always dropped
+
+  alignas(64) std::atomic<uint64_t> writeIndex;
+  std::atomic<uint64_t> published;
+  std::atomic<uint64_t> dropped;
+
+  alignas(64) std::atomic<uint64_t> readIndex;
+  std::atomic<uint32_t> readerWaiting;  // set before the reader sleeps on the eventfd
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+static_assert(sizeof(ChannelHeader) % 64 == 0);
+
+inline bool isValidCapacity(uint32_t capacity) {
+  return capacity >= kMinCapacity && capacity <= kMaxCapacity &&
+         (capacity & (capacity - 1)) == 0;
+}
+
+inline size_t mappingSize(uint32_t capacity) {
+  return sizeof(ChannelHeader) + capacity;
+}
+
+inline uint32_t recordSpan(uint32_t payloadSize) {
+  return static_cast<uint32_t>(sizeof(RecordHeader)) + ((payloadSize + 7u) & ~7u);
+}
+
+/**
+ * @brief Lay out an empty channel in freshly mapped (zeroed) memory
+ */
+inline ChannelHeader* initialise(void* memory, uint32_t capacity) {
+  auto* header = new (memory) ChannelHeader{};
+  header->magic = kMagic;
+  header->version = kVersion;
+  header->headerSize = sizeof(ChannelHeader);
+  header->capacity = capacity;
+  header->maxPayload = capacity / 2 - static_cast<uint32_t>(sizeof(RecordHeader));
+  return header;
+}
+
+/**
+ * @brief Check a mapping received from the core before reading from it
+ */
+inline ChannelHeader* attach(void* memory, size_t size, std::string* error = nullptr) {
+  auto* header = static_cast<ChannelHeader*>(memory);
+  const char* problem = nullptr;
+  if (size < sizeof(ChannelHeader) || header->magic != kMagic) {
+    problem = "not a data channel";
+  } else if (header->version != kVersion || header->headerSize != sizeof(ChannelHeader)) {
+    problem = "unsupported data channel version";
+  } else if (!isValidCapacity(header->capacity) || mappingSize(header->capacity) > size) {
+    problem = "data channel capacity does not match the mapping";
+  }
+  if (problem) {
+    if (error) *error = problem;
+    return nullptr;
+  }
+  return header;
+}
+
+/**
+ * @brief Writing half, used by the core; one writer at a time
+ *
+ * Never blocks: a record that does not fit in the free space is dropped and
+ * counted. The write position is kept privately, so a reader scribbling on
+ * the shared header can lose data but cannot steer writes outside the ring.
+ */
+class Producer {
+ public:
+  explicit Producer(ChannelHeader* header)
+      : m_header(header),
+        m_data(reinterpret_cast<uint8_t*>(header) + sizeof(ChannelHeader)),
+        m_capacity(header->capacity),
+        m_maxPayload(header->maxPayload),
+        m_write(header->writeIndex.load(std::memory_order_relaxed)) {}
+
+  /**
+   * @brief Claim space for a record and return where its payload goes
+   * @return nullptr when the record was dropped; it still used a sequence number
+   */
+  uint8_t* reserve(uint16_t topic, Kind kind, uint32_t size, uint64_t timestampNs,
+                   uint32_t format = 0, uint32_t meta = 0) {
+    const uint64_t sequence = m_sequence++;
+    if (size > m_maxPayload) return drop();
+
+    const uint32_t span = recordSpan(size);
+    const uint64_t read = m_header->readIndex.load(std::memory_order_acquire);
+    const uint32_t position = static_cast<uint32_t>(m_write & (m_capacity - 1));
+    const uint32_t tail = m_capacity - position;
+    const uint32_t skip = tail < span ? tail : 0;  // records never straddle the end
+    if (read > m_write || m_write + skip + span - read > m_capacity) return drop();
+
+    if (skip >= sizeof(RecordHeader)) {
+      RecordHeader padding{};
+      padding.size = skip - static_cast<uint32_t>(sizeof(RecordHeader));
+      padding.kind = static_cast<uint16_t>(Kind::Padding);
+      std::memcpy(m_data + position, &padding, sizeof(padding));
+    }
+
+    uint8_t* record = m_data + ((m_write + skip) & (m_capacity - 1));
+    RecordHeader header{size,        static_cast<uint16_t>(kind), topic, sequence,
+                        timestampNs, format,                      meta};
+    std::memcpy(record, &header, sizeof(header));
+    m_pending = m_write + skip + span;
+    return record + sizeof(RecordHeader);
+  }
+
+  /**
+   * @brief Make the reserved record visible to the reader
+   * @return True when the reader is asleep and the eventfd must be written
+   */
+  bool commit() {
+    m_write = m_pending;
+    m_header->writeIndex.store(m_write, std::memory_order_seq_cst);
+    m_header->published.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the store-then-load in Consumer::prepareToWait()
+    return m_header->readerWaiting.load(std::memory_order_seq_cst) != 0 &&
+           m_header->readerWaiting.exchange(0, std::memory_order_seq_cst) != 0;
+  }
+
+  /**
+   * @brief reserve() and commit() with a copy of @p data
+   * @return False when the record was dropped
+   */
+  bool publish(uint16_t topic, Kind kind, const void* data, uint32_t size, uint64_t timestampNs,
+               uint32_t format, uint32_t meta, bool* wakeReader) {
+    uint8_t* payload = reserve(topic, kind, size, timestampNs, format, meta);
+    if (!payload) {
+      *wakeReader = false;
+      return false;
+    }
+    if (size > 0) std::memcpy(payload, data, size);
+    *wakeReader = commit();
+    return true;
+  }
+
+ private:
+  uint8_t* drop() {
+    m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  ChannelHeader* m_header;
+  uint8_t* m_data;
+  uint32_t m_capacity;
+  uint32_t m_maxPayload;
+  uint64_t m_write;
+  uint64_t m_pending{0};
+  uint64_t m_sequence{0};
+};
+
+/**
+ * @brief Reading half, used by the extension
+ *
+ * Records are read in place: the pointer from next() stays valid until
+ * release(). Before sleeping on the eventfd call prepareToWait(); sleep only
+ * if it returns true, and drain the eventfd counter after waking.
+ */
+class Consumer {
+ public:
+  explicit Consumer(ChannelHeader* header)
+      : m_header(header),
+        m_data(reinterpret_cast<const uint8_t*>(header) + sizeof(ChannelHeader)),
+        m_capacity(header->capacity) {}
+
+  const RecordHeader* next() {
+    uint64_t read = m_header->readIndex.load(std::memory_order_relaxed);
+    const uint64_t write = m_header->writeIndex.load(std::memory_order_acquire);
+    while (read < write) {
+      const uint32_t position = static_cast<uint32_t>(read & (m_capacity - 1));
+      const uint32_t tail = m_capacity - position;
+      const auto* record = reinterpret_cast<const RecordHeader*>(m_data + position);
+      if (tail < sizeof(RecordHeader) || record->kind == static_cast<uint16_t>(Kind::Padding)) {
+        read += tail;
+        m_header->readIndex.store(read, std::memory_order_release);
+        continue;
+      }
+      if (record->sequence > m_expected) m_lost += record->sequence - m_expected;
+      m_expected = record->sequence + 1;
+      m_next = read + recordSpan(record->size);
+      return record;
+    }
+    return nullptr;
+  }
+
+  static const uint8_t* payload(const RecordHeader* record) {
+    return reinterpret_cast<const uint8_t*>(record + 1);
+  }
+
+  void release() {
+    m_header->readIndex.store(m_next, std::memory_order_release);
+  }
+
+  /**
+   * @brief Announce that the reader is about to sleep
+   * @return False if records arrived meanwhile; read them instead of sleeping
+   */
+  bool prepareToWait() {
+    m_header->readerWaiting.store(1, std::memory_order_seq_cst);
+    if (m_header->writeIndex.load(std::memory_order_seq_cst) !=
+        m_header->readIndex.load(std::memory_order_relaxed)) {
+      m_header->readerWaiting.store(0, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  // Records this reader never saw, from gaps in the sequence
+  uint64_t lost() const {
+    return m_lost;
+  }
+
+ private:
+  ChannelHeader* m_header;
+  const uint8_t* m_data;
+  uint32_t m_capacity;
+  uint64_t m_next{0};
+  uint64_t m_expected{0};
+  uint64_t m_lost{0};
+};
+
+/**
+ * @brief Extension side of the negotiation
+ *
+ * Connects to the core's SOCK_SEQPACKET socket, sends @p request (JSON:
+ * extension_id, topics, capacity) and receives the JSON reply in @p reply
+ * together with the channel's memfd and eventfd. The caller maps memfd
+ * read-write, MAP_SHARED, for its full size.
+ *
+ * @return False on a socket error, or when the reply carried no descriptors
+ * (the reply then holds the core's error)
+ */
+inline bool negotiate(const char* socketPath, const std::string& request, std::string* reply,
+                      int* memoryFd, int* eventFd) {
+  const int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd < 0) return false;
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) !=
+          static_cast<ssize_t>(request.size())) {
+    ::close(fd);
+    return false;
+  }
+
+  char buffer[4096];
+  iovec iov{buffer, sizeof(buffer)};
+  alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  const ssize_t received = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+  ::close(fd);
+  if (received <= 0) return false;
+  reply->assign(buffer, static_cast<size_t>(received));
+
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int))) {
+      int fds[2];
+      std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+      *memoryFd = fds[0];
+      *eventFd = fds[1];
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace datachannel
+
+#endif  // DATACHANNELFORMAT_H
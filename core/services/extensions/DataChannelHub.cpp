@@ -0,0 +1,404 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DataChannelHub.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+
+#include "../diagnostics/MetricsRegistry.h"
+#include "../logging/Logger.h"
+
+namespace {
+
+constexpr int kRequestTimeoutMs = 2000;
+constexpr int kMaxRequestBytes = 4096;
+
+quint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<quint64>(ts.tv_sec) * 1000000000ull + static_cast<quint64>(ts.tv_nsec);
+}
+
+}  // namespace
+
+DataChannelHub& DataChannelHub::instance() {
+  static DataChannelHub hub(&crankshaft::diagnostics::MetricsRegistry::instance());
+  return hub;
+}
+
+DataChannelHub::DataChannelHub(crankshaft::diagnostics::MetricsRegistry* registry,
+                               QObject* parent)
+    : QObject(parent), m_registry(registry) {}
+
+DataChannelHub::~DataChannelHub() {
+  stopListening();
+  QWriteLocker locker(&m_lock);
+  m_channels.clear();
+  rebuildSubscribers();
+}
+
+int DataChannelHub::registerTopic(const QString& topic, quint32 maxRecordBytes) {
+  QMutexLocker locker(&m_topicMutex);
+  const auto it = m_topicIds.constFind(topic);
+  if (it != m_topicIds.constEnd()) {
+    m_topicMaxRecord[it.value()] = qMax(m_topicMaxRecord.at(it.value()), maxRecordBytes);
+    return it.value();
+  }
+  if (m_topicNames.size() >= kMaxTopics) return -1;
+  const int id = m_topicNames.size();
+  m_topicNames.append(topic);
+  m_topicMaxRecord.append(maxRecordBytes);
+  m_topicIds.insert(topic, id);
+  return id;
+}
+
+int DataChannelHub::topicId(const QString& topic) const {
+  QMutexLocker locker(&m_topicMutex);
+  return m_topicIds.value(topic, -1);
+}
+
+QString DataChannelHub::topicName(int topicId) const {
+  QMutexLocker locker(&m_topicMutex);
+  return m_topicNames.value(topicId);
+}
+
+int DataChannelHub::publish(int topicId, datachannel::Kind kind, const void* data, quint32 size,
+                            quint32 format, quint32 meta, quint64 timestampNs) {
+  if (!hasSubscribers(topicId)) return 0;
+  if (timestampNs == 0) timestampNs = monotonicNs();
+
+  QReadLocker locker(&m_lock);
+  int written = 0;
+  for (DataChannel* channel : m_subscribers[topicId]) {
+    if (channel->publish(static_cast<quint16>(topicId), kind, data, size, timestampNs, format,
+                         meta)) {
+      ++written;
+    }
+  }
+  return written;
+}
+
+int DataChannelHub::publishTelemetry(int topicId, const datachannel::TelemetrySample* samples,
+                                     int count) {
+  if (count <= 0) return 0;
+  return publish(topicId, datachannel::Kind::Telemetry, samples,
+                 static_cast<quint32>(count * sizeof(datachannel::TelemetrySample)), 0, 0,
+                 samples[0].timestampNs);
+}
+
+DataChannel* DataChannelHub::open(const Request& request, QString* error) {
+  QString reason;
+  if (request.extensionId.isEmpty()) {
+    reason = QStringLiteral("extension_id is required");
+  } else if (request.topics.isEmpty()) {
+    reason = QStringLiteral("At least one topic is required");
+  } else if (m_authorizer && !m_authorizer(request, &reason)) {
+    if (reason.isEmpty()) reason = QStringLiteral("Request refused");
+  }
+
+  quint64 mask = 0;
+  quint32 capacity = request.capacity;
+  if (reason.isEmpty()) {
+    QMutexLocker locker(&m_topicMutex);
+    for (const QString& topic : request.topics) {
+      const int id = m_topicIds.value(topic, -1);
+      if (id < 0) {
+        reason = QStringLiteral("Unknown topic: %1").arg(topic);
+        break;
+      }
+      const quint32 required = capacityFor(m_topicMaxRecord.at(id));
+      if (required == 0) {
+        reason = QStringLiteral("Records of %1 exceed the largest channel").arg(topic);
+        break;
+      }
+      capacity = qMax(capacity, required);
+      mask |= quint64(1) << id;
+    }
+  }
+
+  std::unique_ptr<DataChannel> channel;
+  if (reason.isEmpty()) {
+    channel = DataChannel::create(request.extensionId, capacity, m_registry, &reason);
+  }
+  if (!channel) {
+    if (error) *error = reason;
+    emit requestRejected(request.extensionId, reason);
+    return nullptr;
+  }
+
+  DataChannel* opened = channel.get();
+  bool replaced = false;
+  {
+    QWriteLocker locker(&m_lock);
+    replaced = m_channels.erase(request.extensionId) > 0;
+    m_channels[request.extensionId] = Channel{std::move(channel), request.topics, mask};
+    rebuildSubscribers();
+  }
+
+  if (replaced) emit channelClosed(request.extensionId);
+  Logger::instance().info(QString("[DataChannelHub] Opened %1 byte channel for %2: %3")
+                              .arg(capacity)
+                              .arg(request.extensionId, request.topics.join(", ")));
+  emit channelOpened(request.extensionId, request.topics);
+  return opened;
+}
+
+bool DataChannelHub::close(const QString& extensionId) {
+  {
+    QWriteLocker locker(&m_lock);
+    if (m_channels.erase(extensionId) == 0) return false;
+    rebuildSubscribers();
+  }
+  emit channelClosed(extensionId);
+  return true;
+}
+
+void DataChannelHub::closeAll() {
+  QStringList closed;
+  {
+    QWriteLocker locker(&m_lock);
+    for (const auto& entry : m_channels) closed.append(entry.first);
+    m_channels.clear();
+    rebuildSubscribers();
+  }
+  for (const QString& extensionId : closed) emit channelClosed(extensionId);
+}
+
+bool DataChannelHub::isOpen(const QString& extensionId) const {
+  QReadLocker locker(&m_lock);
+  return m_channels.count(extensionId) > 0;
+}
+
+QJsonObject DataChannelHub::status(const QString& extensionId) const {
+  QReadLocker locker(&m_lock);
+  const auto it = m_channels.find(extensionId);
+  if (it == m_channels.end()) return QJsonObject();
+  QJsonObject obj = it->second.channel->status();
+  obj.insert(QStringLiteral("topics"), QJsonArray::fromStringList(it->second.topics));
+  return obj;
+}
+
+void DataChannelHub::setAuthorizer(Authorizer authorizer) {
+  m_authorizer = std::move(authorizer);
+}
+
+quint32 DataChannelHub::capacityFor(quint32 maxRecordBytes) {
+  // A record may take at most half the ring (see datachannel::initialise)
+  const quint64 needed = 2 * (quint64(maxRecordBytes) + sizeof(datachannel::RecordHeader));
+  quint64 capacity = datachannel::kMinCapacity;
+  while (capacity < needed) capacity <<= 1;
+  return capacity <= datachannel::kMaxCapacity ? static_cast<quint32>(capacity) : 0;
+}
+
+void DataChannelHub::rebuildSubscribers() {
+  quint64 subscribed = 0;
+  for (auto& list : m_subscribers) list.clear();
+  for (const auto& entry : m_channels) {
+    const Channel& channel = entry.second;
+    for (int id = 0; id < kMaxTopics; ++id) {
+      if (channel.mask & (quint64(1) << id)) m_subscribers[id].append(channel.channel.get());
+    }
+    subscribed |= channel.mask;
+  }
+  m_subscribed.store(subscribed, std::memory_order_relaxed);
+}
+
+QString DataChannelHub::defaultSocketPath() {
+  QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+  if (runtimeDir.isEmpty()) runtimeDir = QDir::tempPath();
+  return runtimeDir + QStringLiteral("/crankshaft/data.sock");
+}
+
+QString DataChannelHub::socketPath() const {
+  return m_socketPath;
+}
+
+bool DataChannelHub::listen(const QString& path, QString* error) {
+  stopListening();
+  const QString socketPath = path.isEmpty() ? defaultSocketPath() : path;
+  const QByteArray encoded = QFile::encodeName(socketPath);
+
+  sockaddr_un address{};
+  if (encoded.size() >= static_cast<int>(sizeof(address.sun_path))) {
+    if (error) *error = QStringLiteral("Socket path too long: %1").arg(socketPath);
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, encoded.constData(), encoded.size());
+
+  QDir().mkpath(QFileInfo(socketPath).absolutePath());
+  ::unlink(encoded.constData());  // left behind by an earlier run
+
+  const int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      ::chmod(encoded.constData(), 0600) != 0 || ::listen(fd, 8) != 0) {
+    if (error) {
+      *error = QStringLiteral("Cannot listen on %1: %2")
+                   .arg(socketPath, QString::fromLocal8Bit(strerror(errno)));
+    }
+    if (fd >= 0) ::close(fd);
+    return false;
+  }
+
+  m_listenFd = fd;
+  m_socketPath = socketPath;
+  m_listenNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+  connect(m_listenNotifier, &QSocketNotifier::activated, this, &DataChannelHub::acceptClients);
+  Logger::instance().info(QString("[DataChannelHub] Listening on %1").arg(socketPath));
+  return true;
+}
+
+void DataChannelHub::stopListening() {
+  const QList<int> clients = m_clients.keys();
+  for (int fd : clients) dropClient(fd);
+  if (m_listenFd < 0) return;
+
+  delete m_listenNotifier;
+  m_listenNotifier = nullptr;
+  ::close(m_listenFd);
+  m_listenFd = -1;
+  ::unlink(QFile::encodeName(m_socketPath).constData());
+  m_socketPath.clear();
+}
+
+void DataChannelHub::acceptClients() {
+  for (;;) {
+    const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;
+
+    const quint64 serial = ++m_nextClientSerial;
+    auto* notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this, fd]() { handleRequest(fd); });
+    m_clients.insert(fd, Client{notifier, serial});
+
+    // A client that connects and never asks must not hold the descriptor forever
+    QTimer::singleShot(kRequestTimeoutMs, this, [this, fd, serial]() {
+      const auto it = m_clients.constFind(fd);
+      if (it != m_clients.constEnd() && it->serial == serial) dropClient(fd);
+    });
+  }
+}
+
+void DataChannelHub::handleRequest(int fd) {
+  char buffer[kMaxRequestBytes];
+  const ssize_t received = ::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+  if (received < 0 && (errno == EAGAIN || errno == EINTR)) return;
+  if (received <= 0) {
+    dropClient(fd);
+    return;
+  }
+
+  Request request;
+  ucred credentials{};
+  socklen_t credentialsSize = sizeof(credentials);
+  if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &credentialsSize) == 0) {
+    request.pid = credentials.pid;
+  }
+
+  QJsonParseError parseError;
+  const QJsonDocument doc =
+      QJsonDocument::fromJson(QByteArray(buffer, static_cast<int>(received)), &parseError);
+  const QJsonObject body = doc.object();
+  request.extensionId = body.value(QStringLiteral("extension_id")).toString();
+  for (const QJsonValue& topic : body.value(QStringLiteral("topics")).toArray()) {
+    request.topics.append(topic.toString());
+  }
+  request.capacity = static_cast<quint32>(
+      body.value(QStringLiteral("capacity")).toInteger(static_cast<qint64>(kDefaultCapacity)));
+
+  QJsonObject reply;
+  QString error;
+  DataChannel* channel = nullptr;
+  if (!doc.isObject()) {
+    error = QStringLiteral("Request is not a JSON object: %1").arg(parseError.errorString());
+    emit requestRejected(QString(), error);
+  } else if (request.pid <= 0) {
+    error = QStringLiteral("Peer credentials unavailable");
+    emit requestRejected(request.extensionId, error);
+  } else {
+    channel = open(request, &error);
+  }
+
+  if (channel) {
+    reply.insert(QStringLiteral("ok"), true);
+    reply.insert(QStringLiteral("version"), static_cast<int>(datachannel::kVersion));
+    reply.insert(QStringLiteral("capacity"), static_cast<qint64>(channel->capacity()));
+    reply.insert(QStringLiteral("map_size"), static_cast<qint64>(channel->mappingSize()));
+    QJsonObject topics;
+    for (const QString& topic : request.topics) topics.insert(topic, topicId(topic));
+    reply.insert(QStringLiteral("topics"), topics);
+  } else {
+    reply.insert(QStringLiteral("ok"), false);
+    reply.insert(QStringLiteral("error"), error);
+    Logger::instance().warning(QString("[DataChannelHub] Refused channel for %1 (pid %2): %3")
+                                   .arg(request.extensionId)
+                                   .arg(request.pid)
+                                   .arg(error));
+  }
+  sendReply(fd, reply, channel);
+  dropClient(fd);
+}
+
+void DataChannelHub::sendReply(int fd, const QJsonObject& body, const DataChannel* channel) {
+  const QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+  iovec iov{const_cast<char*>(payload.constData()), static_cast<size_t>(payload.size())};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+
+  alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+  if (channel) {
+    const int fds[2] = {channel->memoryFd(), channel->eventFd()};
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  }
+  if (::sendmsg(fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+    Logger::instance().warning(
+        QString("[DataChannelHub] Reply failed: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+  }
+}
+
+void DataChannelHub::dropClient(int fd) {
+  const auto it = m_clients.find(fd);
+  if (it == m_clients.end()) return;
+  it->notifier->setEnabled(false);
+  it->notifier->deleteLater();
+  m_clients.erase(it);
+  ::close(fd);
+}
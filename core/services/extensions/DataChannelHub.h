@@ -0,0 +1,183 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATACHANNELHUB_H
+#define DATACHANNELHUB_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QStringList>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include "DataChannel.h"
+
+class QSocketNotifier;
+
+/**
+ * @brief Routes high-rate topics to extensions over shared-memory channels
+ *
+ * An extension connects to the hub's SOCK_SEQPACKET socket and sends one
+ * JSON request ({"extension_id", "topics", "capacity"}). The hub identifies
+ * the peer with SO_PEERCRED, asks the authorizer (ExtensionManager checks the
+ * pid and the manifest permissions) and answers with a JSON reply carrying
+ * the topic ids, plus the channel's memfd and eventfd as SCM_RIGHTS.
+ *
+ * Producers register a topic once with registerTopic(), declaring their
+ * largest record, test hasSubscribers() (one relaxed load) and only then build
+ * and publish the record, which is copied straight into every subscribed ring.
+ * Nothing is serialised and nothing passes through the event loop, so this can
+ * be called from the thread that produced the data.
+ *
+ * Extensions can only subscribe to registered topics, so the topic table is
+ * bounded by the producers built into the core, and a ring is always large
+ * enough for the largest record of its topics.
+ */
+class DataChannelHub : public QObject {
+  Q_OBJECT
+
+ public:
+  static constexpr int kMaxTopics = 64;
+  static constexpr quint32 kDefaultCapacity = 1u << 20;
+
+  struct Request {
+    QString extensionId;
+    QStringList topics;
+    quint32 capacity{kDefaultCapacity};
+    qint64 pid{-1};  // from SO_PEERCRED; -1 for in-process callers
+  };
+
+  // Returns false with error set to refuse a request
+  using Authorizer = std::function<bool(const Request& request, QString* error)>;
+
+  static DataChannelHub& instance();
+
+  explicit DataChannelHub(crankshaft::diagnostics::MetricsRegistry* registry = nullptr,
+                          QObject* parent = nullptr);
+  ~DataChannelHub() override;
+
+  /**
+   * @brief Make @p topic available to subscribers
+   *
+   * Registering again keeps the id and raises the largest record size if
+   * needed; rings opened afterwards are sized for it.
+   * @param maxRecordBytes Largest payload the producer will publish
+   * @return The topic id, stable for the hub's lifetime; -1 once kMaxTopics
+   *         topics exist
+   */
+  int registerTopic(const QString& topic, quint32 maxRecordBytes);
+
+  // -1 if no producer registered @p topic
+  int topicId(const QString& topic) const;
+  QString topicName(int topicId) const;
+
+  bool hasSubscribers(int topicId) const {
+    return topicId >= 0 && topicId < kMaxTopics &&
+           (m_subscribed.load(std::memory_order_relaxed) & (quint64(1) << topicId)) != 0;
+  }
+
+  /**
+   * @brief Copy one record into every channel subscribed to the topic
+   * @param timestampNs CLOCK_MONOTONIC; 0 stamps the record now
+   * @return Channels the record was written to (drops excluded)
+   */
+  int publish(int topicId, datachannel::Kind kind, const void* data, quint32 size,
+              quint32 format = 0, quint32 meta = 0, quint64 timestampNs = 0);
+  int publishTelemetry(int topicId, const datachannel::TelemetrySample* samples, int count);
+
+  /**
+   * @brief Create (or replace) the channel of request.extensionId
+   *
+   * The authorizer, if set, is consulted first. Every topic must be
+   * registered, and the ring is enlarged beyond request.capacity if a topic's
+   * largest record would not fit.
+   * @return The channel, owned by the hub, or nullptr with error set
+   */
+  DataChannel* open(const Request& request, QString* error = nullptr);
+  bool close(const QString& extensionId);
+  void closeAll();
+  bool isOpen(const QString& extensionId) const;
+
+  /**
+   * @brief Channel counters plus the subscribed topics; empty when not open
+   */
+  QJsonObject status(const QString& extensionId) const;
+
+  void setAuthorizer(Authorizer authorizer);
+
+  /**
+   * @brief Accept negotiation requests on a Unix socket
+   * @param path Defaults to $XDG_RUNTIME_DIR/crankshaft/data.sock
+   */
+  bool listen(const QString& path = QString(), QString* error = nullptr);
+  void stopListening();
+  QString socketPath() const;
+  static QString defaultSocketPath();
+
+ signals:
+  void channelOpened(const QString& extensionId, const QStringList& topics);
+  void channelClosed(const QString& extensionId);
+  void requestRejected(const QString& extensionId, const QString& error);
+
+ private:
+  struct Channel {
+    std::unique_ptr<DataChannel> channel;
+    QStringList topics;
+    quint64 mask{0};
+  };
+
+  struct Client {
+    QSocketNotifier* notifier;
+    quint64 serial;
+  };
+
+  static quint32 capacityFor(quint32 maxRecordBytes);
+  void rebuildSubscribers();  // m_lock held for writing
+  void acceptClients();
+  void handleRequest(int fd);
+  void sendReply(int fd, const QJsonObject& body, const DataChannel* channel);
+  void dropClient(int fd);
+
+  crankshaft::diagnostics::MetricsRegistry* m_registry;
+  Authorizer m_authorizer;
+
+  mutable QMutex m_topicMutex;
+  QHash<QString, int> m_topicIds;
+  QStringList m_topicNames;
+  QList<quint32> m_topicMaxRecord;
+
+  mutable QReadWriteLock m_lock;
+  std::map<QString, Channel> m_channels;
+  std::array<QList<DataChannel*>, kMaxTopics> m_subscribers;
+  std::atomic<quint64> m_subscribed{0};
+
+  int m_listenFd{-1};
+  QString m_socketPath;
+  QSocketNotifier* m_listenNotifier{nullptr};
+  QHash<int, Client> m_clients;
+  quint64 m_nextClientSerial{0};
+};
+
+#endif  // DATACHANNELHUB_H
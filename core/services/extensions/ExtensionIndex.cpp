@@ -0,0 +1,432 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ExtensionIndex.h"
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <cerrno>
+#include <cstring>
+
+#include "../logging/Logger.h"
+
+namespace {
+
+const QString kIndexFile = QStringLiteral(".index.json");
+const QString kManifestFile = QStringLiteral("manifest.json");
+
+// Installs copy files one by one; wait for the burst of events to settle
+constexpr int kDebounceMs = 100;
+
+constexpr uint32_t kRootEvents = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+constexpr uint32_t kDirectoryEvents =
+    IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+}  // namespace
+
+ExtensionIndex::ExtensionIndex(const QString& extensionsDir, Validator validator,
+                               int validatorVersion, QObject* parent)
+    : QObject(parent),
+      m_extensionsDir(extensionsDir),
+      m_validator(std::move(validator)),
+      m_validatorVersion(validatorVersion),
+      m_debounce(new QTimer(this)) {
+  m_debounce->setSingleShot(true);
+  m_debounce->setInterval(kDebounceMs);
+  connect(m_debounce, &QTimer::timeout, this, &ExtensionIndex::flushPending);
+}
+
+ExtensionIndex::~ExtensionIndex() {
+  stopWatching();
+}
+
+QString ExtensionIndex::indexPath() const {
+  return m_extensionsDir + QStringLiteral("/") + kIndexFile;
+}
+
+QString ExtensionIndex::manifestPath(const QString& directory) const {
+  return m_extensionsDir + QStringLiteral("/") + directory + QStringLiteral("/") + kManifestFile;
+}
+
+int ExtensionIndex::build() {
+  QElapsedTimer timer;
+  timer.start();
+
+  bool changed = !load();
+  const QStringList directories =
+      QDir(m_extensionsDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+  const QSet<QString> present(directories.cbegin(), directories.cend());
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (present.contains(it.key())) {
+      ++it;
+    } else {
+      it = m_entries.erase(it);
+      changed = true;
+    }
+  }
+
+  changed = rescan(directories, false, false) || changed;
+  m_lastReused = static_cast<int>(m_entries.size()) - m_lastScanned;
+  if (changed) {
+    save();
+  }
+
+  Logger::instance().info(QString("[ExtensionIndex] %1 extensions indexed, %2 manifests read in "
+                                  "%3 ms")
+                              .arg(m_entries.size())
+                              .arg(m_lastScanned)
+                              .arg(timer.elapsed()));
+  return m_lastScanned;
+}
+
+void ExtensionIndex::refresh(const QString& directory) {
+  if (rescan({directory}, false, true)) {
+    save();
+  }
+}
+
+bool ExtensionIndex::statManifest(const QString& path, qint64* mtimeNs, qint64* size) {
+  struct stat st {};
+  if (::stat(QFile::encodeName(path).constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  *mtimeNs = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+  *size = static_cast<qint64>(st.st_size);
+  return true;
+}
+
+ExtensionIndex::Entry ExtensionIndex::scanDirectory(const QString& manifestPath,
+                                                    const QString& directory,
+                                                    const Validator& validator) {
+  Entry entry;
+  entry.directory = directory;
+  // stat before reading: a write racing with us then shows up as a changed
+  // mtime on the next scan instead of being cached as current
+  if (!statManifest(manifestPath, &entry.mtimeNs, &entry.size)) {
+    return entry;
+  }
+  QFile file(manifestPath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return entry;
+  }
+  const QByteArray data = file.readAll();
+  entry.hash = QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+
+  const QJsonDocument doc = QJsonDocument::fromJson(data);
+  if (!doc.isObject()) {
+    return entry;
+  }
+  const QJsonObject manifest = doc.object();
+  entry.id = manifest.value(QStringLiteral("id")).toString();
+  entry.version = manifest.value(QStringLiteral("version")).toString();
+  entry.valid = !validator || validator(manifest);
+  if (entry.valid) {
+    entry.manifest = manifest;
+  }
+  return entry;
+}
+
+bool ExtensionIndex::rescan(const QStringList& directories, bool notify, bool force) {
+  bool changed = false;
+  QStringList removed;
+  QStringList removedIds;
+  QStringList toScan;
+  for (const QString& directory : directories) {
+    qint64 mtimeNs = 0;
+    qint64 size = 0;
+    if (!statManifest(manifestPath(directory), &mtimeNs, &size)) {
+      auto it = m_entries.find(directory);
+      if (it != m_entries.end()) {
+        removed.append(directory);
+        removedIds.append(it->id);
+        m_entries.erase(it);
+        changed = true;
+      }
+      continue;
+    }
+    const auto it = m_entries.constFind(directory);
+    if (force || it == m_entries.constEnd() || it->mtimeNs != mtimeNs || it->size != size) {
+      toScan.append(directory);
+    }
+  }
+
+  QVector<Entry> results(toScan.size());
+  if (toScan.size() == 1) {
+    results[0] = scanDirectory(manifestPath(toScan[0]), toScan[0], m_validator);
+  } else if (!toScan.isEmpty()) {
+    // Reading a manifest is mostly waiting on flash, so use a few more threads than cores
+    QThreadPool pool;
+    pool.setObjectName("ExtensionIndexPool");
+    pool.setMaxThreadCount(qMin(static_cast<int>(toScan.size()),
+                                qMax(4, QThread::idealThreadCount() * 2)));
+    for (int i = 0; i < toScan.size(); ++i) {
+      const QString path = manifestPath(toScan[i]);
+      const QString directory = toScan[i];
+      Entry* slot = results.data() + i;
+      pool.start([slot, path, directory, this]() {
+        *slot = scanDirectory(path, directory, m_validator);
+      });
+    }
+    pool.waitForDone();
+  }
+  m_lastScanned = static_cast<int>(toScan.size());
+
+  QStringList updated;
+  for (const Entry& entry : results) {
+    const auto it = m_entries.constFind(entry.directory);
+    if (it == m_entries.constEnd() || it->hash != entry.hash || it->valid != entry.valid) {
+      updated.append(entry.directory);
+      changed = true;
+    } else if (it->mtimeNs != entry.mtimeNs || it->size != entry.size) {
+      changed = true;  // touched but identical: only the stat data is new
+    }
+    m_entries.insert(entry.directory, entry);
+  }
+
+  if (notify) {
+    for (int i = 0; i < removed.size(); ++i) {
+      emit entryRemoved(removed[i], removedIds[i]);
+    }
+    for (const QString& directory : updated) {
+      emit entryChanged(directory);
+    }
+  }
+  return changed;
+}
+
+bool ExtensionIndex::load() {
+  m_entries.clear();
+  QFile file(indexPath());
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  if (root.value(QStringLiteral("version")).toInt() != kFormatVersion) {
+    return false;
+  }
+  // Verdicts of another validator are not ours to reuse
+  if (root.value(QStringLiteral("validator")).toInt() != m_validatorVersion) {
+    return false;
+  }
+
+  const QJsonObject entries = root.value(QStringLiteral("entries")).toObject();
+  for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+    const QJsonObject obj = it.value().toObject();
+    Entry entry;
+    entry.directory = it.key();
+    entry.id = obj.value(QStringLiteral("id")).toString();
+    entry.version = obj.value(QStringLiteral("version")).toString();
+    entry.hash = obj.value(QStringLiteral("hash")).toString().toLatin1();
+    entry.mtimeNs = obj.value(QStringLiteral("mtime_ns")).toInteger();
+    entry.size = obj.value(QStringLiteral("size")).toInteger();
+    entry.valid = obj.value(QStringLiteral("valid")).toBool();
+    entry.manifest = obj.value(QStringLiteral("manifest")).toObject();
+    if (entry.valid && entry.manifest.isEmpty()) {
+      continue;  // damaged entry: rescan it
+    }
+    m_entries.insert(entry.directory, entry);
+  }
+  return true;
+}
+
+bool ExtensionIndex::save() const {
+  QJsonObject entries;
+  for (const Entry& entry : m_entries) {
+    QJsonObject obj;
+    obj.insert(QStringLiteral("id"), entry.id);
+    obj.insert(QStringLiteral("version"), entry.version);
+    obj.insert(QStringLiteral("hash"), QString::fromLatin1(entry.hash));
+    obj.insert(QStringLiteral("mtime_ns"), entry.mtimeNs);
+    obj.insert(QStringLiteral("size"), entry.size);
+    obj.insert(QStringLiteral("valid"), entry.valid);
+    if (entry.valid) {
+      obj.insert(QStringLiteral("manifest"), entry.manifest);
+    }
+    entries.insert(entry.directory, obj);
+  }
+  QJsonObject root;
+  root.insert(QStringLiteral("version"), kFormatVersion);
+  root.insert(QStringLiteral("validator"), m_validatorVersion);
+  root.insert(QStringLiteral("entries"), entries);
+
+  QSaveFile file(indexPath());
+  if (!file.open(QIODevice::WriteOnly)) {
+    Logger::instance().warning(
+        QString("[ExtensionIndex] Cannot write %1: %2").arg(indexPath(), file.errorString()));
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  return file.commit();
+}
+
+QList<ExtensionIndex::Entry> ExtensionIndex::entries() const {
+  return m_entries.values();
+}
+
+ExtensionIndex::Entry ExtensionIndex::entry(const QString& directory) const {
+  return m_entries.value(directory);
+}
+
+bool ExtensionIndex::contains(const QString& directory) const {
+  return m_entries.contains(directory);
+}
+
+int ExtensionIndex::lastScanned() const {
+  return m_lastScanned;
+}
+
+int ExtensionIndex::lastReused() const {
+  return m_lastReused;
+}
+
+bool ExtensionIndex::watch() {
+  if (m_inotifyFd >= 0) {
+    return true;
+  }
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyFd < 0) {
+    Logger::instance().warning(QString("[ExtensionIndex] inotify unavailable: %1")
+                                   .arg(QString::fromLocal8Bit(strerror(errno))));
+    return false;
+  }
+  m_rootWatch =
+      inotify_add_watch(m_inotifyFd, QFile::encodeName(m_extensionsDir).constData(), kRootEvents);
+  if (m_rootWatch < 0) {
+    Logger::instance().warning(QString("[ExtensionIndex] Cannot watch %1: %2")
+                                   .arg(m_extensionsDir, QString::fromLocal8Bit(strerror(errno))));
+    stopWatching();
+    return false;
+  }
+
+  const QStringList directories =
+      QDir(m_extensionsDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+  for (const QString& directory : directories) {
+    addWatch(directory);
+  }
+  m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+  connect(m_notifier, &QSocketNotifier::activated, this, &ExtensionIndex::readEvents);
+  return true;
+}
+
+void ExtensionIndex::stopWatching() {
+  m_debounce->stop();
+  m_pending.clear();
+  m_pendingFullScan = false;
+  delete m_notifier;
+  m_notifier = nullptr;
+  if (m_inotifyFd >= 0) {
+    ::close(m_inotifyFd);  // drops every watch
+  }
+  m_inotifyFd = -1;
+  m_rootWatch = -1;
+  m_watches.clear();
+}
+
+bool ExtensionIndex::isWatching() const {
+  return m_inotifyFd >= 0;
+}
+
+void ExtensionIndex::addWatch(const QString& directory) {
+  const QString path = m_extensionsDir + QStringLiteral("/") + directory;
+  const int wd = inotify_add_watch(m_inotifyFd, QFile::encodeName(path).constData(),
+                                   kDirectoryEvents);
+  if (wd >= 0) {
+    m_watches.insert(wd, directory);  // a renamed directory keeps its wd
+  }
+}
+
+void ExtensionIndex::readEvents() {
+  alignas(inotify_event) char buffer[4096];
+  for (;;) {
+    const ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      break;
+    }
+    for (const char* p = buffer; p < buffer + length;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(p);
+      p += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        m_pendingFullScan = true;
+        continue;
+      }
+      const QString name = event->len > 0 ? QFile::decodeName(event->name) : QString();
+      if (event->wd == m_rootWatch) {
+        if (!(event->mask & IN_ISDIR) || name.startsWith(QLatin1Char('.'))) {
+          continue;
+        }
+        if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          addWatch(name);
+        }
+        m_pending.insert(name);
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        m_watches.remove(event->wd);
+        continue;
+      }
+      const QString directory = m_watches.value(event->wd);
+      if (!directory.isEmpty() && name == kManifestFile) {
+        m_pending.insert(directory);
+      }
+    }
+  }
+  if (m_pendingFullScan || !m_pending.isEmpty()) {
+    m_debounce->start();
+  }
+}
+
+void ExtensionIndex::flushPending() {
+  QSet<QString> directories = m_pending;
+  m_pending.clear();
+  if (m_pendingFullScan) {
+    // Events were lost: look at everything, including entries whose directory vanished
+    m_pendingFullScan = false;
+    for (const QString& directory :
+         QDir(m_extensionsDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+      addWatch(directory);
+      directories.insert(directory);
+    }
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+      directories.insert(it.key());
+    }
+  }
+
+  QStringList list(directories.cbegin(), directories.cend());
+  list.sort();
+  // The events say these manifests were written, even if a same-size rewrite
+  // within one timestamp tick left mtime and size alone
+  if (rescan(list, true, true)) {
+    save();
+  }
+}
@@ -0,0 +1,141 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXTENSIONINDEX_H
+#define EXTENSIONINDEX_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <functional>
+
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * @brief Cached index of the manifests under the extensions directory
+ *
+ * The index file (.index.json in the extensions directory) remembers, per
+ * extension subdirectory, the manifest's id, version, SHA-256, mtime and size
+ * along with the parsed manifest and whether it validated. At startup only a
+ * stat() per manifest is needed: directories whose manifest changed, appeared
+ * or has no entry yet are read, hashed, parsed and validated in parallel on a
+ * small thread pool, and the rest come from the index. The index also records
+ * the validator's version; when it differs every manifest is validated again.
+ * The index file is rewritten only when an entry actually changed.
+ *
+ * After watch() the directory is followed with inotify, so an extension
+ * copied in or deleted while the core runs is picked up by rescanning just
+ * its directory.
+ */
+class ExtensionIndex : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Entry {
+    QString directory;  // subdirectory of the extensions directory
+    QString id;
+    QString version;
+    QByteArray hash;  // hex SHA-256 of manifest.json
+    qint64 mtimeNs{0};
+    qint64 size{0};
+    bool valid{false};     // parsed and passed the validator
+    QJsonObject manifest;  // empty unless valid
+  };
+
+  // Runs on pool threads; must not touch shared state
+  using Validator = std::function<bool(const QJsonObject& manifest)>;
+
+  /**
+   * @param validatorVersion Identifies the validator's rules; cached verdicts
+   *        from another version are discarded
+   */
+  ExtensionIndex(const QString& extensionsDir, Validator validator, int validatorVersion = 0,
+                 QObject* parent = nullptr);
+  ~ExtensionIndex() override;
+
+  /**
+   * @brief Load the index file, rescan what changed and save
+   * @return Number of manifests that had to be read
+   */
+  int build();
+
+  /**
+   * @brief Rescan one directory now, without emitting entryChanged/entryRemoved
+   *
+   * For changes the caller made itself (install, uninstall), so the inotify
+   * events they cause later find nothing new.
+   */
+  void refresh(const QString& directory);
+
+  bool watch();
+  void stopWatching();
+  bool isWatching() const;
+
+  QList<Entry> entries() const;
+  Entry entry(const QString& directory) const;
+  bool contains(const QString& directory) const;
+
+  QString indexPath() const;
+  int lastScanned() const;  // manifests read by the last build or rescan
+  int lastReused() const;   // manifests taken from the index by the last build
+
+  static constexpr int kFormatVersion = 1;
+
+ signals:
+  // A manifest appeared or its content changed while watching
+  void entryChanged(const QString& directory);
+  void entryRemoved(const QString& directory, const QString& id);
+
+ private:
+  static Entry scanDirectory(const QString& manifestPath, const QString& directory,
+                             const Validator& validator);
+  static bool statManifest(const QString& path, qint64* mtimeNs, qint64* size);
+
+  QString manifestPath(const QString& directory) const;
+  // Reads manifests whose mtime or size changed (all of them with force);
+  // notify emits for content changes only. True if an entry changed.
+  bool rescan(const QStringList& directories, bool notify, bool force);
+  bool load();
+  bool save() const;
+  void addWatch(const QString& directory);
+  void readEvents();
+  void flushPending();
+
+  QString m_extensionsDir;
+  Validator m_validator;
+  int m_validatorVersion;
+  QMap<QString, Entry> m_entries;
+  int m_lastScanned{0};
+  int m_lastReused{0};
+
+  int m_inotifyFd{-1};
+  int m_rootWatch{-1};
+  QHash<int, QString> m_watches;  // watch descriptor -> directory
+  QSocketNotifier* m_notifier{nullptr};
+  QTimer* m_debounce;
+  QSet<QString> m_pending;
+  bool m_pendingFullScan{false};
+};
+
+#endif  // EXTENSIONINDEX_H
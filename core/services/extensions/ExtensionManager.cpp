@@ -20,17 +20,70 @@
 #include "ExtensionManager.h"
 
 #include <signal.h>
+#include <unistd.h>
 
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonParseError>
-#include <QProcess>
 #include <QRegularExpression>
 #include <QStandardPaths>
 
+#include "../diagnostics/MetricsRegistry.h"
+
+namespace {
+
+// True if pid is ancestor or one of its descendants, so an entrypoint script
+// can hand the channel to the program it starts
+bool isSameOrDescendant(qint64 pid, qint64 ancestor) {
+  for (int depth = 0; depth < 16 && pid > 1; ++depth) {
+    if (pid == ancestor) {
+      return true;
+    }
+    QFile stat(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) {
+      return false;
+    }
+    // pid (comm) state ppid ...; comm may contain spaces and parentheses
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 2) {
+      return false;
+    }
+    pid = fields.at(1).toLongLong();
+  }
+  return false;
+}
+
+}  // namespace
+
 ExtensionManager::ExtensionManager(const QString &extensionsDir, QObject *parent)
-    : QObject(parent) {
+    : QObject(parent),
+      m_supervisor(
+          new ExtensionSupervisor(&crankshaft::diagnostics::MetricsRegistry::instance(), this)),
+      m_governor(
+          new ResourceGovernor(&crankshaft::diagnostics::MetricsRegistry::instance(), this)),
+      m_dataChannels(&DataChannelHub::instance()) {
+  connect(m_supervisor, &ExtensionSupervisor::started, this, &ExtensionManager::onProcessStarted);
+  connect(m_supervisor, &ExtensionSupervisor::exited, this, &ExtensionManager::onProcessExited);
+  connect(m_supervisor, &ExtensionSupervisor::spawnFailed, this,
+          [this](const QString &extensionId, const QString &error) {
+            emit extensionError(extensionId,
+                                QStringLiteral("Failed to start process: %1").arg(error));
+          });
+  connect(m_supervisor, &ExtensionSupervisor::crashLoopDetected, this,
+          [this](const QString &extensionId, int crashes) {
+            emit extensionError(
+                extensionId,
+                QStringLiteral("Crash loop: %1 crashes, restarts suspended").arg(crashes));
+          });
+  m_governor->start();
+  m_dataChannels->setAuthorizer(
+      [this](const DataChannelHub::Request &request, QString *error) {
+        return authorizeDataChannel(request, error);
+      });
+
   if (extensionsDir.isEmpty()) {
     m_extensionsDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
                       QStringLiteral("/crankshaft/extensions");
@@ -44,41 +97,34 @@ ExtensionManager::ExtensionManager(const QString &extensionsDir, QObject *parent
     dir.mkpath(m_extensionsDir);
   }
 
-  // Load existing extensions
-  QDir extensionsPath(m_extensionsDir);
-  QStringList subdirs = extensionsPath.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-
-  for (const QString &subdir : subdirs) {
-    QString manifestPath =
-        m_extensionsDir + QStringLiteral("/") + subdir + QStringLiteral("/manifest.json");
-    QFile manifestFile(manifestPath);
-    if (manifestFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-      QJsonParseError parseError;
-      QJsonDocument doc = QJsonDocument::fromJson(manifestFile.readAll(), &parseError);
-      manifestFile.close();
-
-      if (!doc.isNull() && doc.isObject()) {
-        ExtensionInfo info =
-            parseManifest(doc.object(), m_extensionsDir + QStringLiteral("/") + subdir);
-        if (!info.id.isEmpty()) {
-          m_extensions.insert(info.id, info);
-        }
-      }
+  // Load installed extensions from the index; only new or changed manifests
+  // are read, in parallel
+  m_index = new ExtensionIndex(m_extensionsDir, &ExtensionManager::validateManifest,
+                               kManifestRulesVersion, this);
+  m_index->build();
+  const QList<ExtensionIndex::Entry> entries = m_index->entries();
+  for (const ExtensionIndex::Entry &entry : entries) {
+    if (!entry.valid) {
+      qWarning() << "Skipping invalid extension manifest in" << entry.directory;
+      continue;
     }
+    ExtensionInfo info =
+        parseManifest(entry.manifest, m_extensionsDir + QStringLiteral("/") + entry.directory);
+    m_extensions.insert(info.id, info);
   }
+
+  connect(m_index, &ExtensionIndex::entryChanged, this, &ExtensionManager::onIndexEntryChanged);
+  connect(m_index, &ExtensionIndex::entryRemoved, this, &ExtensionManager::onIndexEntryRemoved);
+  m_index->watch();
 }
 
 ExtensionManager::~ExtensionManager() {
-  // Stop all running extensions
-  for (auto it = m_processes.begin(); it != m_processes.end(); ++it) {
-    QProcess *process = it.value();
-    if (process && process->state() == QProcess::Running) {
-      process->terminate();
-      if (!process->waitForFinished(3000)) {
-        process->kill();
-      }
-    }
-    delete process;
+  // Stop all running extensions, sharing one grace period
+  m_supervisor->stopAll();
+
+  m_dataChannels->setAuthorizer(nullptr);
+  for (auto it = m_extensions.constBegin(); it != m_extensions.constEnd(); ++it) {
+    m_dataChannels->close(it.key());
   }
 }
 
@@ -90,6 +136,8 @@ ExtensionManager::ExtensionInfo ExtensionManager::parseManifest(const QJsonObjec
   info.version = manifest.value(QStringLiteral("version")).toString();
   info.entrypoint = manifest.value(QStringLiteral("entrypoint")).toString();
   info.installDir = installDir;
+  info.resourceClass =
+      manifest.value(QStringLiteral("resource_class")).toString(QStringLiteral("normal"));
   info.isRunning = false;
   info.pid = -1;
 
@@ -128,13 +176,23 @@ bool ExtensionManager::validateManifest(const QJsonObject &manifest) {
   QJsonArray permissions = manifest.value(QStringLiteral("permissions")).toArray();
   QStringList allowedPermissions{QStringLiteral("ui.tile"),         QStringLiteral("media.source"),
                                  QStringLiteral("service.control"), QStringLiteral("network"),
-                                 QStringLiteral("storage"),         QStringLiteral("diagnostics")};
+                                 QStringLiteral("storage"),         QStringLiteral("diagnostics"),
+                                 QStringLiteral("data.channel")};
   for (const QJsonValue &perm : permissions) {
     if (!allowedPermissions.contains(perm.toString())) {
       return false;
     }
   }
 
+  // Optional resource class for the governor
+  if (manifest.contains(QStringLiteral("resource_class"))) {
+    static const QStringList resourceClasses{QStringLiteral("background"), QStringLiteral("normal"),
+                                             QStringLiteral("interactive")};
+    if (!resourceClasses.contains(manifest.value(QStringLiteral("resource_class")).toString())) {
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -176,6 +234,12 @@ QString ExtensionManager::installExtension(const QString &manifestJson, const QS
   ExtensionInfo info = parseManifest(doc.object(), installPath);
   m_extensions.insert(id, info);
 
+  // Index it now so the inotify events from the write above find nothing new
+  const QString directory = indexedDirectory(installPath);
+  if (!directory.isEmpty()) {
+    m_index->refresh(directory);
+  }
+
   emit extensionInstalled(id);
   return QString();  // Empty string indicates success
 }
@@ -186,12 +250,26 @@ QString ExtensionManager::uninstallExtension(const QString &extensionId) {
     return QStringLiteral("Extension not found: %1").arg(extensionId);
   }
 
-  // Stop if running
-  if (it.value().isRunning) {
-    QString stopResult = stopExtension(extensionId);
-    if (!stopResult.isEmpty()) {
-      return stopResult;
-    }
+  // A supervised process stops asynchronously and may still be running from
+  // its directory; onProcessExited removes it once it is gone
+  m_restartAfterExit.remove(extensionId);
+  if (m_supervisor->stop(extensionId)) {
+    m_removeAfterExit.insert(extensionId);
+    return QString();
+  }
+
+  // Stop if running, and cancel any pending restart
+  QString stopResult = stopExtension(extensionId);
+  if (!stopResult.isEmpty()) {
+    return stopResult;
+  }
+  return removeExtension(extensionId);
+}
+
+QString ExtensionManager::removeExtension(const QString &extensionId) {
+  auto it = m_extensions.find(extensionId);
+  if (it == m_extensions.end()) {
+    return QStringLiteral("Extension not found: %1").arg(extensionId);
   }
 
   // Remove directory
@@ -200,43 +278,35 @@ QString ExtensionManager::uninstallExtension(const QString &extensionId) {
     return QStringLiteral("Failed to remove extension directory");
   }
 
+  const QString directory = indexedDirectory(it.value().installDir);
+  if (!directory.isEmpty()) {
+    m_index->refresh(directory);
+  }
+
   m_extensions.erase(it);
   emit extensionUninstalled(extensionId);
   return QString();
 }
 
-qint64 ExtensionManager::startProcess(const QString &extensionId, const ExtensionInfo &info) {
-  QProcess *process = new QProcess();
-
+ExtensionSupervisor::Spec ExtensionManager::processSpec(const ExtensionInfo &info) const {
+  ExtensionSupervisor::Spec spec;
+  spec.id = info.id;
+  spec.command = info.entrypoint;
   // Set working directory to extension install directory
-  process->setWorkingDirectory(info.installDir);
-
-  // Connect signals
-  connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-          &ExtensionManager::onProcessFinished);
-  connect(process, QOverload<QProcess::ProcessError>::of(&QProcess::errorOccurred), this,
-          &ExtensionManager::onProcessError);
-
-  // Start process
-  process->start(info.entrypoint);
+  spec.workingDirectory = info.installDir;
+  spec.cgroupPath = cgroupPath(info.id);
+  return spec;
+}
 
-  if (!process->waitForStarted()) {
-    emit extensionError(extensionId, QStringLiteral("Failed to start process"));
-    delete process;
+qint64 ExtensionManager::startProcess(const QString &extensionId, const ExtensionInfo &info) {
+  // The supervisor reports the start (and any automatic restart) through
+  // onProcessStarted, which records the pid and sets up cgroup limits
+  QString error;
+  qint64 pid = m_supervisor->start(processSpec(info), &error);
+  if (pid <= 0) {
+    emit extensionError(extensionId, QStringLiteral("Failed to start process: %1").arg(error));
     return -1;
   }
-
-  qint64 pid = process->processId();
-
-  // Store process mapping
-  m_processToExtension.insert(process, extensionId);
-  m_processes.insert(extensionId, process);
-
-  // Set up cgroup limits
-  if (!setupCgroupLimits(pid, extensionId)) {
-    qWarning() << "Failed to setup cgroup limits for extension:" << extensionId;
-  }
-
   return pid;
 }
 
@@ -249,18 +319,34 @@ QString ExtensionManager::startExtension(const QString &extensionId) {
   if (it.value().isRunning) {
     return QStringLiteral("Extension already running: %1").arg(extensionId);
   }
+  if (m_removeAfterExit.contains(extensionId)) {
+    return QStringLiteral("Extension is being uninstalled: %1").arg(extensionId);
+  }
 
   qint64 pid = startProcess(extensionId, it.value());
   if (pid > 0) {
-    it.value().isRunning = true;
-    it.value().pid = pid;
-    emit extensionStarted(extensionId, pid);
     return QString();
   }
 
   return QStringLiteral("Failed to start extension process");
 }
 
+int ExtensionManager::startExtensions(const QStringList &extensionIds) {
+  QList<ExtensionSupervisor::Spec> specs;
+  for (auto it = m_extensions.cbegin(); it != m_extensions.cend(); ++it) {
+    if (it.value().isRunning) {
+      continue;
+    }
+    if (!extensionIds.isEmpty() && !extensionIds.contains(it.key())) {
+      continue;
+    }
+    specs.append(processSpec(it.value()));
+  }
+
+  m_supervisor->startBatched(specs);
+  return specs.size();
+}
+
 bool ExtensionManager::stopProcess(qint64 pid) {
   if (pid <= 0) {
     return false;
@@ -268,15 +354,12 @@ bool ExtensionManager::stopProcess(qint64 pid) {
 
   // Try graceful terminate first
   if (kill(pid, SIGTERM) == 0) {
-    // Wait a bit for graceful shutdown
-    QProcess dummy;
-    dummy.start(QStringLiteral("sh"), QStringList()
-                                          << QStringLiteral("-c") << QStringLiteral("sleep 2"));
-    dummy.waitForFinished();
-
-    // Check if process is still running
-    if (kill(pid, 0) != 0) {
-      return true;  // Process terminated gracefully
+    // Wait up to 2s for graceful shutdown
+    for (int waited = 0; waited < 2000; waited += 20) {
+      if (kill(pid, 0) != 0) {
+        return true;  // Process terminated gracefully
+      }
+      usleep(20000);
     }
   }
 
@@ -291,22 +374,18 @@ QString ExtensionManager::stopExtension(const QString &extensionId) {
     return QStringLiteral("Extension not found: %1").arg(extensionId);
   }
 
+  // Also cancels a pending automatic restart. A supervised process reports
+  // its exit through onProcessExited, which emits extensionStopped.
+  if (m_supervisor->stop(extensionId)) {
+    return QString();
+  }
+
   if (!extIt.value().isRunning) {
     return QString();  // Not running, no error
   }
 
-  auto procIt = m_processes.find(extensionId);
-  if (procIt != m_processes.end()) {
-    QProcess *process = procIt.value();
-    process->terminate();
-    if (!process->waitForFinished(3000)) {
-      process->kill();
-      process->waitForFinished();
-    }
-  } else {
-    // Process not in our map, try killing by PID
-    stopProcess(extIt.value().pid);
-  }
+  // Process not supervised, try killing by PID
+  stopProcess(extIt.value().pid);
 
   extIt.value().isRunning = false;
   extIt.value().pid = -1;
@@ -316,6 +395,16 @@ QString ExtensionManager::stopExtension(const QString &extensionId) {
 }
 
 QString ExtensionManager::restartExtension(const QString &extensionId) {
+  if (!m_extensions.contains(extensionId)) {
+    return QStringLiteral("Extension not found: %1").arg(extensionId);
+  }
+
+  // A supervised process stops asynchronously; onProcessExited starts it again
+  if (m_supervisor->stop(extensionId)) {
+    m_restartAfterExit.insert(extensionId);
+    return QString();
+  }
+
   QString stopResult = stopExtension(extensionId);
   if (!stopResult.isEmpty()) {
     return stopResult;
@@ -360,6 +449,7 @@ QJsonObject ExtensionManager::getExtensionInfo(const QString &extensionId) {
   obj.insert(QStringLiteral("name"), it.value().name);
   obj.insert(QStringLiteral("version"), it.value().version);
   obj.insert(QStringLiteral("entrypoint"), it.value().entrypoint);
+  obj.insert(QStringLiteral("resource_class"), it.value().resourceClass);
   obj.insert(QStringLiteral("is_running"), it.value().isRunning);
   if (it.value().isRunning) {
     obj.insert(QStringLiteral("pid"), static_cast<qint64>(it.value().pid));
@@ -371,9 +461,98 @@ QJsonObject ExtensionManager::getExtensionInfo(const QString &extensionId) {
   }
   obj.insert(QStringLiteral("permissions"), permsArray);
 
+  QJsonObject supervision = m_supervisor->status(extensionId);
+  if (!supervision.isEmpty()) {
+    obj.insert(QStringLiteral("supervisor"), supervision);
+  }
+
+  QJsonObject dataChannel = m_dataChannels->status(extensionId);
+  if (!dataChannel.isEmpty()) {
+    obj.insert(QStringLiteral("data_channel"), dataChannel);
+  }
+
   return obj;
 }
 
+ExtensionSupervisor *ExtensionManager::supervisor() const {
+  return m_supervisor;
+}
+
+ResourceGovernor *ExtensionManager::governor() const {
+  return m_governor;
+}
+
+ExtensionIndex *ExtensionManager::index() const {
+  return m_index;
+}
+
+QString ExtensionManager::indexedDirectory(const QString &installDir) const {
+  const QFileInfo info(installDir);
+  const QString extensionsDir = QDir(m_extensionsDir).absolutePath();
+  if (QDir::cleanPath(info.absolutePath()) != QDir::cleanPath(extensionsDir)) {
+    return QString();
+  }
+  return info.fileName();
+}
+
+DataChannelHub *ExtensionManager::dataChannels() const {
+  return m_dataChannels;
+}
+
+QString ExtensionManager::listenForDataChannels(const QString &socketPath) {
+  QString error;
+  if (!m_dataChannels->listen(socketPath, &error)) {
+    return error;
+  }
+  return QString();
+}
+
+QString ExtensionManager::topicPermission(const QString &topic) {
+  if (topic.startsWith(QStringLiteral("media/"))) {
+    return QStringLiteral("media.source");
+  }
+  if (topic.startsWith(QStringLiteral("diagnostics/"))) {
+    return QStringLiteral("diagnostics");
+  }
+  return QString();
+}
+
+bool ExtensionManager::authorizeDataChannel(const DataChannelHub::Request &request,
+                                            QString *error) {
+  auto it = m_extensions.constFind(request.extensionId);
+  if (it == m_extensions.constEnd()) {
+    *error = QStringLiteral("Extension not installed: %1").arg(request.extensionId);
+    return false;
+  }
+
+  const QString channelPermission = QStringLiteral("data.channel");
+  if (!it.value().permissions.contains(channelPermission)) {
+    emit permissionDenied(request.extensionId, channelPermission);
+    *error = QStringLiteral("Missing permission: %1").arg(channelPermission);
+    return false;
+  }
+  for (const QString &topic : request.topics) {
+    const QString permission = topicPermission(topic);
+    if (!permission.isEmpty() && !it.value().permissions.contains(permission)) {
+      emit permissionDenied(request.extensionId, permission);
+      *error = QStringLiteral("Topic %1 needs permission: %2").arg(topic, permission);
+      return false;
+    }
+  }
+
+  // Requests from the socket carry the peer's pid; in-process callers do not
+  if (request.pid > 0) {
+    const qint64 pid = m_supervisor->pid(request.extensionId);
+    if (pid <= 0 || !isSameOrDescendant(request.pid, pid)) {
+      *error = QStringLiteral("Process %1 is not extension %2")
+                   .arg(request.pid)
+                   .arg(request.extensionId);
+      return false;
+    }
+  }
+  return true;
+}
+
 bool ExtensionManager::hasPermission(const QString &extensionId, const QString &permission) {
   auto it = m_extensions.find(extensionId);
   if (it == m_extensions.end()) {
@@ -403,40 +582,32 @@ bool ExtensionManager::setupCgroupLimits(qint64 pid, const QString &extensionId)
     return false;
   }
 
-  // cgroup v2 unified hierarchy path
-  QString cgroupPath = QStringLiteral("/sys/fs/cgroup/crankshaft-extensions-%1").arg(extensionId);
+  QString cgroup = cgroupPath(extensionId);
 
   // Try to create cgroup
-  QProcess mkdir;
-  mkdir.start(QStringLiteral("mkdir"), QStringList() << QStringLiteral("-p") << cgroupPath);
-  if (!mkdir.waitForFinished()) {
+  if (!QDir().mkpath(cgroup)) {
     return false;
   }
 
   // Add PID to cgroup
-  QFile pidsFile(cgroupPath + QStringLiteral("/cgroup.procs"));
+  QFile pidsFile(cgroup + QStringLiteral("/cgroup.procs"));
   if (!pidsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
     return false;
   }
   pidsFile.write(QString::number(pid).toUtf8());
   pidsFile.close();
 
-  // Apply resource limits
-  return applyCgroupLimits(cgroupPath, EXTENSION_CPU_QUOTA_US, EXTENSION_MEMORY_LIMIT);
+  // Hard memory ceiling; CPU, IO and memory.high are the governor's
+  return applyCgroupLimits(cgroup, EXTENSION_MEMORY_LIMIT);
 }
 
-bool ExtensionManager::applyCgroupLimits(const QString &cgroupPath, qint64 cpuQuotaUs,
-                                         qint64 memoryLimitBytes) {
-  bool success = true;
+QString ExtensionManager::cgroupPath(const QString &extensionId) {
+  // cgroup v2 unified hierarchy path
+  return QStringLiteral("/sys/fs/cgroup/crankshaft-extensions-%1").arg(extensionId);
+}
 
-  // Set CPU limits (cpu.max: quota period)
-  QFile cpuFile(cgroupPath + QStringLiteral("/cpu.max"));
-  if (cpuFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-    cpuFile.write(QString(QStringLiteral("%1 1000000")).arg(cpuQuotaUs).toUtf8());
-    cpuFile.close();
-  } else {
-    success = false;
-  }
+bool ExtensionManager::applyCgroupLimits(const QString &cgroupPath, qint64 memoryLimitBytes) {
+  bool success = true;
 
   // Set memory limits
   QFile memFile(cgroupPath + QStringLiteral("/memory.max"));
@@ -450,70 +621,81 @@ bool ExtensionManager::applyCgroupLimits(const QString &cgroupPath, qint64 cpuQu
   return success;
 }
 
-void ExtensionManager::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus) {
-  QProcess *process = qobject_cast<QProcess *>(sender());
-  if (!process) {
+void ExtensionManager::onProcessStarted(const QString &extensionId, qint64 pid) {
+  auto extIt = m_extensions.find(extensionId);
+  if (extIt == m_extensions.end()) {
     return;
   }
 
-  auto it = m_processToExtension.find(process);
-  if (it == m_processToExtension.end()) {
-    return;
+  extIt.value().isRunning = true;
+  extIt.value().pid = pid;
+
+  // Set up cgroup limits, then let the governor adjust them with system state
+  if (setupCgroupLimits(pid, extensionId)) {
+    m_governor->track(extensionId, cgroupPath(extensionId),
+                      ResourceGovernor::resourceClassFromString(extIt.value().resourceClass));
+  } else {
+    qWarning() << "Failed to setup cgroup limits for extension:" << extensionId;
   }
 
-  QString extensionId = it.value();
+  emit extensionStarted(extensionId, pid);
+}
 
+void ExtensionManager::onProcessExited(const QString &extensionId, int exitCode, bool crashed) {
   // Update extension state
   auto extIt = m_extensions.find(extensionId);
   if (extIt != m_extensions.end()) {
     extIt.value().isRunning = false;
     extIt.value().pid = -1;
   }
+  m_governor->untrack(extensionId);
 
-  // Clean up process
-  auto procIt = m_processes.find(extensionId);
-  if (procIt != m_processes.end()) {
-    delete procIt.value();
-    m_processes.erase(procIt);
-  }
-  m_processToExtension.erase(it);
+  // The mapping died with the process; a restarted one negotiates again
+  m_dataChannels->close(extensionId);
 
-  // Emit signal based on exit status
-  if (exitStatus == QProcess::CrashExit) {
+  // Emit signal based on exit status; the supervisor decides about restarting
+  if (crashed) {
     emit extensionCrashed(extensionId, exitCode);
   } else {
     emit extensionStopped(extensionId);
   }
-}
 
-void ExtensionManager::onProcessError(QProcess::ProcessError error) {
-  QProcess *process = qobject_cast<QProcess *>(sender());
-  if (!process) {
-    return;
+  if (m_removeAfterExit.remove(extensionId)) {
+    const QString error = removeExtension(extensionId);
+    if (!error.isEmpty()) {
+      emit extensionError(extensionId, error);
+    }
+  } else if (m_restartAfterExit.remove(extensionId) && m_extensions.contains(extensionId)) {
+    startExtension(extensionId);  // failures are reported through extensionError
   }
+}
 
-  auto it = m_processToExtension.find(process);
-  if (it == m_processToExtension.end()) {
+void ExtensionManager::onIndexEntryChanged(const QString &directory) {
+  // An extension copied into (or edited in) the extensions directory
+  const ExtensionIndex::Entry entry = m_index->entry(directory);
+  if (!entry.valid) {
+    qWarning() << "Ignoring invalid extension manifest in" << directory;
     return;
   }
 
-  QString extensionId = it.value();
-  QString errorMsg;
-
-  switch (error) {
-    case QProcess::FailedToStart:
-      errorMsg = QStringLiteral("Failed to start extension process");
-      break;
-    case QProcess::Crashed:
-      errorMsg = QStringLiteral("Extension process crashed");
-      break;
-    case QProcess::Timedout:
-      errorMsg = QStringLiteral("Extension process timed out");
-      break;
-    default:
-      errorMsg = QStringLiteral("Unknown process error");
-      break;
+  ExtensionInfo info =
+      parseManifest(entry.manifest, m_extensionsDir + QStringLiteral("/") + directory);
+  auto it = m_extensions.find(info.id);
+  if (it != m_extensions.end()) {
+    info.isRunning = it.value().isRunning;
+    info.pid = it.value().pid;
   }
+  m_extensions.insert(info.id, info);
+  emit extensionInstalled(info.id);
+}
 
-  emit extensionError(extensionId, errorMsg);
+void ExtensionManager::onIndexEntryRemoved(const QString &directory, const QString &id) {
+  // An extension directory deleted behind our back
+  auto it = m_extensions.find(id);
+  if (it == m_extensions.end() || indexedDirectory(it.value().installDir) != directory) {
+    return;
+  }
+  stopExtension(id);
+  m_extensions.remove(id);
+  emit extensionUninstalled(id);
 }
@@ -25,9 +25,14 @@
 #include <QJsonObject>
 #include <QMap>
 #include <QObject>
-#include <QProcess>
+#include <QSet>
 #include <QTemporaryDir>
 
+#include "DataChannelHub.h"
+#include "ExtensionIndex.h"
+#include "ExtensionSupervisor.h"
+#include "ResourceGovernor.h"
+
 class ExtensionManager : public QObject {
   Q_OBJECT
 
@@ -40,6 +45,7 @@ class ExtensionManager : public QObject {
     QStringList permissions;
     QStringList backgroundServices;
     QString installDir;
+    QString resourceClass;  // background, normal or interactive
     qint64 pid;  // Process ID if running
     bool isRunning;
   };
@@ -51,7 +57,8 @@ class ExtensionManager : public QObject {
   // Returns: error message (empty if successful)
   Q_INVOKABLE QString installExtension(const QString &manifestJson, const QString &targetDir);
 
-  // Uninstall an extension
+  // Uninstall an extension. A running one is stopped first and its files are
+  // removed once it has exited; extensionUninstalled() follows the removal.
   Q_INVOKABLE QString uninstallExtension(const QString &extensionId);
 
   // Start an extension process
@@ -63,6 +70,10 @@ class ExtensionManager : public QObject {
   // Restart an extension process
   Q_INVOKABLE QString restartExtension(const QString &extensionId);
 
+  // Start installed extensions (all when the list is empty) in small batches,
+  // for boot. Returns: number of extensions queued
+  Q_INVOKABLE int startExtensions(const QStringList &extensionIds = QStringList());
+
   // List all installed extensions
   Q_INVOKABLE QJsonArray listExtensions();
 
@@ -75,6 +86,28 @@ class ExtensionManager : public QObject {
   // Get all extensions with a specific permission
   Q_INVOKABLE QJsonArray getExtensionsWithPermission(const QString &permission);
 
+  // Process supervision: restart policy, exits, resource usage
+  ExtensionSupervisor *supervisor() const;
+
+  // Adjusts running extensions' cgroups with driving, projection and PSI
+  // pressure; connect driving and projection state to its slots
+  ResourceGovernor *governor() const;
+
+  // Cached manifest index, watched for extensions added or removed on disk
+  ExtensionIndex *index() const;
+
+  // Shared-memory data channels. Requests are authorised against the
+  // "data.channel" permission, the permission each topic needs and the
+  // requesting process, which must be the extension's (or a descendant).
+  DataChannelHub *dataChannels() const;
+
+  // Accept data channel requests on a Unix socket (default:
+  // $XDG_RUNTIME_DIR/crankshaft/data.sock). Returns: error message (empty if successful)
+  Q_INVOKABLE QString listenForDataChannels(const QString &socketPath = QString());
+
+  // Permission a data channel topic needs on top of "data.channel" (empty if none)
+  static QString topicPermission(const QString &topic);
+
  signals:
   void extensionInstalled(const QString &extensionId);
   void extensionUninstalled(const QString &extensionId);
@@ -85,35 +118,58 @@ class ExtensionManager : public QObject {
   void permissionDenied(const QString &extensionId, const QString &permission);
 
  private slots:
-  void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
-  void onProcessError(QProcess::ProcessError error);
+  void onProcessStarted(const QString &extensionId, qint64 pid);
+  void onProcessExited(const QString &extensionId, int exitCode, bool crashed);
+  void onIndexEntryChanged(const QString &directory);
+  void onIndexEntryRemoved(const QString &directory, const QString &id);
 
  private:
   // Parse extension manifest from JSON
   ExtensionInfo parseManifest(const QJsonObject &manifest, const QString &installDir);
 
-  // Validate manifest against schema
-  bool validateManifest(const QJsonObject &manifest);
+  // Validate manifest against schema; called from index scan threads
+  static bool validateManifest(const QJsonObject &manifest);
+  // Bump whenever validateManifest() decides differently, so the index
+  // re-validates the manifests it cached
+  static constexpr int kManifestRulesVersion = 2;
+
+  // Name of installDir in the extensions directory, empty if it is elsewhere
+  QString indexedDirectory(const QString &installDir) const;
+
+  // Delete a stopped extension's files and forget it
+  QString removeExtension(const QString &extensionId);
 
   // Set up cgroup v2 resource limits for extension process
   bool setupCgroupLimits(qint64 pid, const QString &extensionId);
 
+  // cgroup v2 directory for an extension
+  static QString cgroupPath(const QString &extensionId);
+
+  // DataChannelHub authorizer
+  bool authorizeDataChannel(const DataChannelHub::Request &request, QString *error);
+
+  // Supervisor spec for an extension
+  ExtensionSupervisor::Spec processSpec(const ExtensionInfo &info) const;
+
   // Start supervised process with error handling
   qint64 startProcess(const QString &extensionId, const ExtensionInfo &info);
 
   // Stop process gracefully with fallback to kill
   bool stopProcess(qint64 pid);
 
-  // Apply resource limits to cgroup
-  bool applyCgroupLimits(const QString &cgroupPath, qint64 cpuQuotaUs, qint64 memoryLimitBytes);
+  // Apply the hard memory limit to cgroup
+  bool applyCgroupLimits(const QString &cgroupPath, qint64 memoryLimitBytes);
 
   QString m_extensionsDir;
   QMap<QString, ExtensionInfo> m_extensions;
-  QMap<QString, QProcess *> m_processes;
-  QMap<QProcess *, QString> m_processToExtension;  // Reverse mapping for signal handlers
-
-  // Cgroup resource limits (can be configured)
-  static constexpr qint64 EXTENSION_CPU_QUOTA_US = 500000;             // 0.5s per 1s
+  QSet<QString> m_restartAfterExit;  // restartExtension() waiting for the old process
+  QSet<QString> m_removeAfterExit;   // uninstallExtension() waiting for the process to exit
+  ExtensionSupervisor *m_supervisor;
+  ExtensionIndex *m_index;
+  ResourceGovernor *m_governor;
+  DataChannelHub *m_dataChannels;
+
+  // Hard cgroup memory limit; everything else is set by the governor
   static constexpr qint64 EXTENSION_MEMORY_LIMIT = 512 * 1024 * 1024;  // 512 MB
 };
 
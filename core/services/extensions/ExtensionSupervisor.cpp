@@ -0,0 +1,663 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ExtensionSupervisor.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QVector>
+#include <cerrno>
+#include <cstring>
+
+#include "../diagnostics/MetricsRegistry.h"
+#include "../logging/Logger.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+using crankshaft::diagnostics::MetricsRegistry;
+
+namespace {
+
+constexpr quint64 kWakeToken = 1;
+constexpr quint64 kStatsToken = 2;
+constexpr int kReapPollMs = 200;
+constexpr int kKillWaitMs = 2000;
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+qint64 monotonicMs() {
+  return monotonicNs() / 1000000LL;
+}
+
+const char* stateName(int state) {
+  static const char* const kNames[] = {"stopped", "running", "backing_off", "crash_loop",
+                                       "stopping"};
+  return kNames[state];
+}
+
+QByteArray readSmallFile(const QString& path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+  return file.readAll();
+}
+
+// "key value" lines, as in cpu.stat and memory.stat
+bool findKey(const QByteArray& text, const QByteArray& key, quint64* value) {
+  for (const QByteArray& line : text.split('\n')) {
+    if (line.startsWith(key) && line.size() > key.size() && line.at(key.size()) == ' ') {
+      bool ok = false;
+      const quint64 parsed = line.mid(key.size() + 1).trimmed().toULongLong(&ok);
+      if (ok) *value = parsed;
+      return ok;
+    }
+  }
+  return false;
+}
+
+void armTimer(int fd, int intervalMs) {
+  itimerspec spec{};
+  spec.it_interval.tv_sec = intervalMs / 1000;
+  spec.it_interval.tv_nsec = static_cast<long>(intervalMs % 1000) * 1000000L;
+  spec.it_value = spec.it_interval;
+  timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+}  // namespace
+
+ExtensionSupervisor::ExtensionSupervisor(MetricsRegistry* registry, QObject* parent)
+    : QObject(parent), m_registry(registry) {
+  m_reapTimer = new QTimer(this);
+  m_reapTimer->setInterval(kReapPollMs);
+  connect(m_reapTimer, &QTimer::timeout, this, &ExtensionSupervisor::reapWithoutPidfd);
+
+  m_bootTimer = new QTimer(this);
+  connect(m_bootTimer, &QTimer::timeout, this, &ExtensionSupervisor::startNextBatch);
+
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  m_statsFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (m_epollFd < 0 || m_wakeFd < 0 || m_statsFd < 0) {
+    Logger::instance().warning(
+        QString("[ExtensionSupervisor] epoll setup failed (%1); reaping on a timer")
+            .arg(QString::fromLocal8Bit(strerror(errno))));
+    return;
+  }
+
+  epoll_event wake{};
+  wake.events = EPOLLIN;
+  wake.data.u64 = kWakeToken;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &wake);
+  epoll_event stats{};
+  stats.events = EPOLLIN;
+  stats.data.u64 = kStatsToken;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_statsFd, &stats);
+  armTimer(m_statsFd, m_policy.statsIntervalMs);
+
+  m_thread = std::thread([this]() { run(); });
+}
+
+ExtensionSupervisor::~ExtensionSupervisor() {
+  // Owners that care about the exits stop everything themselves first
+  blockSignals(true);
+  stopAll();
+
+  // No event loop from here on: wait out the grace period, kill the rest, reap
+  QList<QString> stopping;
+  for (auto it = m_children.cbegin(); it != m_children.cend(); ++it) {
+    if (it.value().state == State::Stopping) stopping.append(it.key());
+  }
+  waitForAll(stopping, m_policy.stopGraceMs);
+  for (const QString& id : stopping) signalChild(m_children[id], SIGKILL);
+  waitForAll(stopping, kKillWaitMs);
+  for (const QString& id : stopping) {
+    int exitCode = 0;
+    bool crashed = false;
+    reap(m_children[id], &exitCode, &crashed, true);
+    m_children[id].state = State::Stopped;
+  }
+
+  if (m_thread.joinable()) {
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = ::write(m_wakeFd, &one, sizeof(one));
+    m_thread.join();
+  }
+  for (int fd : {m_statsFd, m_wakeFd, m_epollFd}) {
+    if (fd >= 0) ::close(fd);
+  }
+}
+
+void ExtensionSupervisor::setPolicy(const Policy& policy) {
+  m_policy = policy;
+  m_bootTimer->setInterval(m_policy.bootBatchIntervalMs);
+  if (m_statsFd >= 0) armTimer(m_statsFd, qMax(100, m_policy.statsIntervalMs));
+}
+
+ExtensionSupervisor::Policy ExtensionSupervisor::policy() const {
+  return m_policy;
+}
+
+qint64 ExtensionSupervisor::start(const Spec& spec, QString* error) {
+  Child& child = m_children[spec.id];
+  if (child.state == State::Running) {
+    if (error) *error = QString("already running");
+    return -1;
+  }
+
+  // A start by hand gets a clean slate, including out of a crash loop
+  child.spec = spec;
+  child.consecutiveCrashes = 0;
+  child.crashTimesMs.clear();
+  ++child.restartToken;
+
+  QString spawnError;
+  if (!spawn(child, &spawnError)) {
+    child.state = State::Stopped;
+    if (error) *error = spawnError;
+    return -1;
+  }
+  return child.pid;
+}
+
+void ExtensionSupervisor::startBatched(const QList<Spec>& specs) {
+  for (const Spec& spec : specs) m_bootQueue.enqueue(spec);
+  if (!m_bootTimer->isActive() && !m_bootQueue.isEmpty()) {
+    m_bootTimer->start(m_policy.bootBatchIntervalMs);
+    startNextBatch();
+  }
+}
+
+void ExtensionSupervisor::startNextBatch() {
+  for (int i = 0; i < qMax(1, m_policy.bootBatchSize) && !m_bootQueue.isEmpty(); ++i) {
+    const Spec spec = m_bootQueue.dequeue();
+    if (isRunning(spec.id)) continue;
+    QString error;
+    if (start(spec, &error) < 0) emit spawnFailed(spec.id, error);
+  }
+  if (m_bootQueue.isEmpty()) m_bootTimer->stop();
+}
+
+bool ExtensionSupervisor::spawn(Child& child, QString* error) {
+  QStringList arguments = QProcess::splitCommand(child.spec.command);
+  if (arguments.isEmpty()) {
+    *error = QString("empty command");
+    return false;
+  }
+  const QString program = arguments.takeFirst();
+  QString path;
+  if (program.contains('/')) {
+    path = QDir(child.spec.workingDirectory).absoluteFilePath(program);
+  } else {
+    path = QStandardPaths::findExecutable(program);
+  }
+  if (path.isEmpty() || !QFileInfo(path).isExecutable()) {
+    *error = QString("program not found: %1").arg(program);
+    return false;
+  }
+
+  // Everything the child needs is prepared before fork(): afterwards only
+  // async-signal-safe calls are allowed
+  const QByteArray programPath = QFile::encodeName(path);
+  const QByteArray workingDirectory = QFile::encodeName(child.spec.workingDirectory);
+  QList<QByteArray> argumentBytes{QFile::encodeName(program)};
+  for (const QString& argument : arguments) argumentBytes.append(argument.toLocal8Bit());
+  QVector<char*> argv;
+  for (QByteArray& argument : argumentBytes) argv.append(argument.data());
+  argv.append(nullptr);
+  sigset_t emptyMask;
+  sigemptyset(&emptyMask);
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    *error = QString("fork failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+    return false;
+  }
+  if (pid == 0) {
+    // Handlers reset on exec, the mask does not
+    sigprocmask(SIG_SETMASK, &emptyMask, nullptr);
+    if (!workingDirectory.isEmpty() && chdir(workingDirectory.constData()) != 0) _exit(127);
+    execv(programPath.constData(), argv.data());
+    _exit(127);
+  }
+
+  child.pid = pid;
+  child.state = State::Running;
+  child.startedMs = monotonicMs();
+  child.serial = m_nextSerial++;
+  child.pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+  if (child.pidfd >= 0 && m_epollFd >= 0) {
+    fcntl(child.pidfd, F_SETFD, FD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = child.serial;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, child.pidfd, &event);
+  } else {
+    m_reapTimer->start();
+  }
+
+  if (!child.spec.cgroupPath.isEmpty()) {
+    QMutexLocker locker(&m_usageMutex);
+    m_cgroups.insert(child.spec.id, child.spec.cgroupPath);
+  }
+  emit started(child.spec.id, pid);
+  return true;
+}
+
+void ExtensionSupervisor::signalChild(const Child& child, int signo) const {
+  // Through the pidfd the signal cannot reach a recycled pid
+  if (child.pidfd >= 0 && syscall(SYS_pidfd_send_signal, child.pidfd, signo, nullptr, 0) == 0) {
+    return;
+  }
+  kill(child.pid, signo);
+}
+
+void ExtensionSupervisor::waitForAll(const QList<QString>& ids, int timeoutMs) const {
+  // One poll() over every pidfd, so the children share the deadline
+  QVector<pollfd> fds;
+  QList<pid_t> withoutPidfd;
+  for (const QString& id : ids) {
+    const Child child = m_children.value(id);
+    if (child.pidfd >= 0) {
+      fds.append(pollfd{child.pidfd, POLLIN, 0});
+    } else {
+      withoutPidfd.append(child.pid);
+    }
+  }
+
+  const qint64 deadline = monotonicMs() + timeoutMs;
+  for (;;) {
+    int waiting = 0;
+    for (pollfd& fd : fds) {
+      if (fd.revents != 0) {
+        fd.fd = -1;  // exited; poll() skips negative descriptors
+      } else if (fd.fd >= 0) {
+        ++waiting;
+      }
+    }
+    // No pidfd: look for the exit without reaping it
+    for (auto it = withoutPidfd.begin(); it != withoutPidfd.end();) {
+      siginfo_t info{};
+      if (waitid(P_PID, *it, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0) {
+        it = withoutPidfd.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    waiting += withoutPidfd.size();
+
+    const int remaining = static_cast<int>(qMax<qint64>(0, deadline - monotonicMs()));
+    if (waiting == 0 || remaining == 0) return;
+    const int timeout = withoutPidfd.isEmpty() ? remaining : qMin(remaining, 10);
+    if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) return;
+  }
+}
+
+bool ExtensionSupervisor::reap(Child& child, int* exitCode, bool* crashed, bool block) {
+  int status = 0;
+  pid_t result;
+  do {
+    result = waitpid(child.pid, &status, block ? 0 : WNOHANG);
+  } while (result < 0 && errno == EINTR);
+  if (result == 0) return false;
+
+  if (result < 0) {
+    // Someone else reaped it; the exit status is lost
+    *exitCode = -1;
+    *crashed = true;
+  } else if (WIFSIGNALED(status)) {
+    *exitCode = 128 + WTERMSIG(status);
+    *crashed = true;
+  } else {
+    *exitCode = WEXITSTATUS(status);
+    *crashed = *exitCode != 0;
+  }
+
+  if (child.pidfd >= 0) ::close(child.pidfd);  // also drops it from the epoll set
+  child.pidfd = -1;
+  child.pid = -1;
+  child.serial = 0;
+  {
+    QMutexLocker locker(&m_usageMutex);
+    m_cgroups.remove(child.spec.id);
+  }
+  return true;
+}
+
+void ExtensionSupervisor::onChildExited(quint64 serial) {
+  for (auto it = m_children.begin(); it != m_children.end(); ++it) {
+    Child& child = it.value();
+    if (child.serial != serial) continue;
+    if (child.state != State::Running && child.state != State::Stopping) continue;
+
+    int exitCode = 0;
+    bool crashed = false;
+    if (!reap(child, &exitCode, &crashed, false)) return;
+    finishExit(child, exitCode, crashed);
+    return;
+  }
+  // Not found: already reaped
+}
+
+void ExtensionSupervisor::reapWithoutPidfd() {
+  bool waiting = false;
+  for (auto it = m_children.begin(); it != m_children.end(); ++it) {
+    Child& child = it.value();
+    if (child.state != State::Running && child.state != State::Stopping) continue;
+    if (child.pidfd >= 0) continue;
+
+    int exitCode = 0;
+    bool crashed = false;
+    if (!reap(child, &exitCode, &crashed, false)) {
+      waiting = true;
+      continue;
+    }
+    finishExit(child, exitCode, crashed);
+  }
+  if (!waiting) m_reapTimer->stop();
+}
+
+void ExtensionSupervisor::finishExit(Child& child, int exitCode, bool crashed) {
+  const QString id = child.spec.id;
+  const bool stopping = child.state == State::Stopping;
+  child.state = State::Stopped;
+  if (stopping) {
+    // Our own SIGTERM or SIGKILL is the expected end; any other failure is a
+    // crash, but stop() has cancelled restarts
+    crashed = crashed && exitCode != 128 + SIGTERM && exitCode != 128 + SIGKILL;
+    emit exited(id, exitCode, crashed);
+    return;
+  }
+  emit exited(id, exitCode, crashed);
+  if (crashed) handleCrash(child, exitCode);
+}
+
+void ExtensionSupervisor::handleCrash(Child& child, int exitCode) {
+  const QString id = child.spec.id;
+  const qint64 now = monotonicMs();
+  ++child.crashes;
+  if (m_registry) {
+    m_registry->counter("extension_crashes_total", "Extension process crashes", {{"extension", id}})
+        .add(1);
+  }
+
+  if (now - child.startedMs >= m_policy.stableRunMs) child.consecutiveCrashes = 0;
+  ++child.consecutiveCrashes;
+  child.crashTimesMs.append(now);
+  while (!child.crashTimesMs.isEmpty() &&
+         now - child.crashTimesMs.first() > m_policy.crashLoopWindowMs) {
+    child.crashTimesMs.removeFirst();
+  }
+
+  if (child.crashTimesMs.size() >= m_policy.crashLoopCount) {
+    child.state = State::CrashLoop;
+    Logger::instance().warning(
+        QString("[ExtensionSupervisor] %1 crashed %2 times in %3 s (last exit %4); "
+                "not restarting until started again")
+            .arg(id)
+            .arg(child.crashTimesMs.size())
+            .arg(m_policy.crashLoopWindowMs / 1000)
+            .arg(exitCode));
+    emit crashLoopDetected(id, child.crashTimesMs.size());
+    return;
+  }
+  if (!m_policy.restartOnCrash) return;
+
+  // initial, 2x, 4x, ... capped
+  const int shift = qMin(child.consecutiveCrashes - 1, 20);
+  const int delayMs = static_cast<int>(
+      qMin<qint64>(m_policy.maxBackoffMs, static_cast<qint64>(m_policy.initialBackoffMs) << shift));
+  child.state = State::BackingOff;
+  const quint64 token = ++child.restartToken;
+  QTimer::singleShot(delayMs, this, [this, id, token]() { restart(id, token); });
+
+  Logger::instance().info(QString("[ExtensionSupervisor] %1 exited with %2; restarting in %3 ms")
+                              .arg(id)
+                              .arg(exitCode)
+                              .arg(delayMs));
+  emit restartScheduled(id, delayMs);
+}
+
+void ExtensionSupervisor::restart(const QString& id, quint64 token) {
+  auto it = m_children.find(id);
+  if (it == m_children.end()) return;
+  Child& child = it.value();
+  if (child.state != State::BackingOff || child.restartToken != token) return;
+
+  QString error;
+  if (!spawn(child, &error)) {
+    child.state = State::Stopped;
+    emit spawnFailed(id, error);
+    return;
+  }
+  ++child.restarts;
+  if (m_registry) {
+    m_registry->counter("extension_restarts_total", "Automatic extension restarts",
+                        {{"extension", id}})
+        .add(1);
+  }
+}
+
+bool ExtensionSupervisor::stop(const QString& id) {
+  auto it = m_children.find(id);
+  if (it == m_children.end()) return false;
+  Child& child = it.value();
+  ++child.restartToken;  // cancels a pending restart
+  if (child.state == State::Stopping) return true;
+  if (child.state != State::Running) {
+    child.state = State::Stopped;
+    return false;
+  }
+
+  // The exit arrives through the pidfd (or the reap timer) like any other
+  child.state = State::Stopping;
+  signalChild(child, SIGTERM);
+  const quint64 serial = child.serial;
+  QTimer::singleShot(m_policy.stopGraceMs, this,
+                     [this, id, serial]() { killAfterGrace(id, serial); });
+  return true;
+}
+
+void ExtensionSupervisor::killAfterGrace(const QString& id, quint64 serial) {
+  auto it = m_children.find(id);
+  if (it == m_children.end()) return;
+  const Child& child = it.value();
+  if (child.state != State::Stopping || child.serial != serial) return;
+
+  Logger::instance().warning(
+      QString("[ExtensionSupervisor] %1 ignored SIGTERM for %2 ms; killing it")
+          .arg(id)
+          .arg(m_policy.stopGraceMs));
+  signalChild(child, SIGKILL);
+}
+
+void ExtensionSupervisor::stopAll() {
+  m_bootQueue.clear();
+  m_bootTimer->stop();
+
+  // Everything is signalled now, so the grace periods run concurrently
+  for (const QString& id : m_children.keys()) stop(id);
+}
+
+bool ExtensionSupervisor::isRunning(const QString& id) const {
+  auto it = m_children.constFind(id);
+  return it != m_children.constEnd() && it.value().state == State::Running;
+}
+
+qint64 ExtensionSupervisor::pid(const QString& id) const {
+  return isRunning(id) ? m_children.value(id).pid : -1;
+}
+
+ExtensionSupervisor::Usage ExtensionSupervisor::usage(const QString& id) const {
+  QMutexLocker locker(&m_usageMutex);
+  return m_usage.value(id);
+}
+
+QJsonObject ExtensionSupervisor::status(const QString& id) const {
+  auto it = m_children.constFind(id);
+  if (it == m_children.constEnd()) return QJsonObject();
+
+  const Child& child = it.value();
+  QJsonObject status{{"state", stateName(static_cast<int>(child.state))},
+                     {"restarts", static_cast<qint64>(child.restarts)},
+                     {"crashes", static_cast<qint64>(child.crashes)}};
+  const Usage current = usage(id);
+  if (current.valid) {
+    status["usage"] = QJsonObject{{"cpu_percent", current.cpuPercent},
+                                  {"cpu_usage_us", static_cast<qint64>(current.cpuUsageUs)},
+                                  {"memory_bytes", static_cast<qint64>(current.memoryBytes)},
+                                  {"rss_bytes", static_cast<qint64>(current.anonBytes)},
+                                  {"io_read_bytes", static_cast<qint64>(current.ioReadBytes)},
+                                  {"io_write_bytes", static_cast<qint64>(current.ioWriteBytes)}};
+  }
+  return status;
+}
+
+void ExtensionSupervisor::run() {
+  epoll_event events[16];
+  for (;;) {
+    const int count = epoll_wait(m_epollFd, events, 16, -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    for (int i = 0; i < count; ++i) {
+      const quint64 token = events[i].data.u64;
+      if (token == kWakeToken) return;
+      if (token == kStatsToken) {
+        uint64_t expirations = 0;
+        if (::read(m_statsFd, &expirations, sizeof(expirations)) > 0) sampleUsage();
+        continue;
+      }
+      // A pidfd became readable: the process exited. Reaping happens on the
+      // owning thread, which also owns the bookkeeping.
+      QMetaObject::invokeMethod(
+          this, [this, token]() { onChildExited(token); }, Qt::QueuedConnection);
+    }
+  }
+}
+
+void ExtensionSupervisor::sampleUsage() {
+  QHash<QString, QString> cgroups;
+  {
+    QMutexLocker locker(&m_usageMutex);
+    cgroups = m_cgroups;
+  }
+
+  QHash<QString, Usage> sampled;
+  for (auto it = cgroups.constBegin(); it != cgroups.constEnd(); ++it) {
+    sampled.insert(it.key(), sampleCgroup(it.key(), it.value()));
+  }
+  for (auto it = m_lastCpu.begin(); it != m_lastCpu.end();) {
+    if (cgroups.contains(it.key())) {
+      ++it;
+    } else {
+      it = m_lastCpu.erase(it);
+    }
+  }
+
+  QMutexLocker locker(&m_usageMutex);
+  // Keep the last sample of stopped extensions, mark it stale
+  for (auto it = m_usage.begin(); it != m_usage.end(); ++it) {
+    if (!sampled.contains(it.key())) it.value().cpuPercent = 0.0;
+  }
+  for (auto it = sampled.constBegin(); it != sampled.constEnd(); ++it) {
+    m_usage.insert(it.key(), it.value());
+  }
+}
+
+ExtensionSupervisor::Usage ExtensionSupervisor::sampleCgroup(const QString& id,
+                                                             const QString& path) {
+  Usage usage;
+  quint64 usageUs = 0;
+  if (!parseCpuStat(readSmallFile(path + "/cpu.stat"), &usageUs)) return usage;
+  usage.valid = true;
+  usage.cpuUsageUs = usageUs;
+  usage.memoryBytes = readSmallFile(path + "/memory.current").trimmed().toULongLong();
+  parseMemoryStat(readSmallFile(path + "/memory.stat"), &usage.anonBytes);
+  parseIoStat(readSmallFile(path + "/io.stat"), &usage.ioReadBytes, &usage.ioWriteBytes);
+
+  const qint64 now = monotonicNs();
+  auto last = m_lastCpu.constFind(id);
+  if (last != m_lastCpu.constEnd() && now > last.value().atNs &&
+      usageUs >= last.value().usageUs) {
+    usage.cpuPercent = 100.0 * static_cast<double>(usageUs - last.value().usageUs) * 1000.0 /
+                       static_cast<double>(now - last.value().atNs);
+  }
+  m_lastCpu.insert(id, CpuSample{usageUs, now});
+
+  if (m_registry) {
+    // Registry lookups are locked and metric values atomic, so this thread
+    // can publish directly
+    const crankshaft::diagnostics::MetricLabels labels{{"extension", id}};
+    m_registry->gauge("extension_cpu_percent", "Extension CPU use, percent of one core", labels)
+        .set(usage.cpuPercent);
+    m_registry->gauge("extension_memory_bytes", "Extension cgroup memory.current", labels)
+        .set(static_cast<double>(usage.memoryBytes));
+    m_registry->gauge("extension_rss_bytes", "Extension anonymous memory", labels)
+        .set(static_cast<double>(usage.anonBytes));
+    m_registry->gauge("extension_io_read_bytes", "Extension block I/O read", labels)
+        .set(static_cast<double>(usage.ioReadBytes));
+    m_registry->gauge("extension_io_write_bytes", "Extension block I/O written", labels)
+        .set(static_cast<double>(usage.ioWriteBytes));
+  }
+  return usage;
+}
+
+bool ExtensionSupervisor::parseCpuStat(const QByteArray& text, quint64* usageUs) {
+  return findKey(text, "usage_usec", usageUs);
+}
+
+bool ExtensionSupervisor::parseMemoryStat(const QByteArray& text, quint64* anonBytes) {
+  return findKey(text, "anon", anonBytes);
+}
+
+void ExtensionSupervisor::parseIoStat(const QByteArray& text, quint64* readBytes,
+                                      quint64* writeBytes) {
+  // One line per device: "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0"
+  *readBytes = 0;
+  *writeBytes = 0;
+  for (const QByteArray& line : text.split('\n')) {
+    for (const QByteArray& field : line.split(' ')) {
+      if (field.startsWith("rbytes=")) *readBytes += field.mid(7).toULongLong();
+      if (field.startsWith("wbytes=")) *writeBytes += field.mid(7).toULongLong();
+    }
+  }
+}
@@ -0,0 +1,208 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXTENSIONSUPERVISOR_H
+#define EXTENSIONSUPERVISOR_H
+
+#include <sys/types.h>
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QTimer>
+#include <thread>
+
+namespace crankshaft {
+namespace diagnostics {
+class MetricsRegistry;
+}
+}  // namespace crankshaft
+
+/**
+ * @brief Spawns extension processes and watches them from one thread
+ *
+ * Each child gets a pidfd registered with an epoll set; a dedicated thread
+ * waits on it and hands exits to this object's thread, where they are reaped.
+ * There is no per-process QObject, signal plumbing or polling. The same thread
+ * samples each running extension's cgroup (cpu.stat, memory.current,
+ * memory.stat, io.stat) and publishes it to the metrics registry as
+ * extension_*{extension} gauges.
+ *
+ * A crash (killed by a signal, or a non-zero exit) is restarted after an
+ * exponential backoff; too many crashes within the crash-loop window stop
+ * the restarts until the extension is started again by hand. Kernels without
+ * pidfd_open() (before 5.3) fall back to reaping on a timer.
+ */
+class ExtensionSupervisor : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Spec {
+    QString id;
+    QString command;  // program and arguments, quoted like a shell (no expansion)
+    QString workingDirectory;
+    QString cgroupPath;  // resource usage is sampled from here when set
+  };
+
+  struct Policy {
+    bool restartOnCrash{true};
+    int initialBackoffMs{500};
+    int maxBackoffMs{30000};
+    int stableRunMs{30000};  // a run this long resets the backoff
+    int crashLoopCount{5};   // this many crashes within the window stop restarts
+    int crashLoopWindowMs{60000};
+    int stopGraceMs{3000};  // SIGTERM to SIGKILL
+    int bootBatchSize{3};
+    int bootBatchIntervalMs{200};
+    int statsIntervalMs{5000};
+  };
+
+  struct Usage {
+    bool valid{false};
+    double cpuPercent{0.0};  // of one core, over the last sampling interval
+    quint64 cpuUsageUs{0};
+    quint64 memoryBytes{0};  // memory.current, including page cache
+    quint64 anonBytes{0};    // anonymous memory: the cgroup's RSS
+    quint64 ioReadBytes{0};
+    quint64 ioWriteBytes{0};
+  };
+
+  explicit ExtensionSupervisor(crankshaft::diagnostics::MetricsRegistry* registry = nullptr,
+                               QObject* parent = nullptr);
+  ~ExtensionSupervisor() override;
+
+  void setPolicy(const Policy& policy);
+  Policy policy() const;
+
+  /**
+   * @brief Spawn now; clears any crash history from earlier runs
+   * @return The pid, or -1 with error set
+   */
+  qint64 start(const Spec& spec, QString* error = nullptr);
+
+  /**
+   * @brief Queue for start, bootBatchSize at a time, bootBatchIntervalMs apart
+   *
+   * Keeps a boot with many extensions from forking them all in one go
+   * while the core is still starting its own services.
+   */
+  void startBatched(const QList<Spec>& specs);
+
+  /**
+   * @brief SIGTERM now, SIGKILL from a timer after the grace period; also
+   * cancels a pending restart
+   *
+   * Returns at once; the exit is reaped like any other and reported through
+   * exited(). An exit by SIGTERM or SIGKILL is not a crash, but a non-zero
+   * exit status while stopping is. A stopped process is never restarted.
+   *
+   * @return True if a process is running or already stopping
+   */
+  bool stop(const QString& id);
+
+  /**
+   * @brief stop() every extension, sharing one grace period
+   */
+  void stopAll();
+
+  bool isRunning(const QString& id) const;
+  qint64 pid(const QString& id) const;
+  Usage usage(const QString& id) const;
+
+  /**
+   * @brief state (running, stopping, backing_off, crash_loop, stopped), restarts,
+   * crashes and the latest resource usage
+   */
+  QJsonObject status(const QString& id) const;
+
+  // cgroup v2 file parsers, exposed for tests
+  static bool parseCpuStat(const QByteArray& text, quint64* usageUs);
+  static bool parseMemoryStat(const QByteArray& text, quint64* anonBytes);
+  static void parseIoStat(const QByteArray& text, quint64* readBytes, quint64* writeBytes);
+
+ signals:
+  void started(const QString& id, qint64 pid);
+  void exited(const QString& id, int exitCode, bool crashed);
+  void restartScheduled(const QString& id, int delayMs);
+  void crashLoopDetected(const QString& id, int crashes);
+  void spawnFailed(const QString& id, const QString& error);
+
+ private:
+  enum class State { Stopped, Running, BackingOff, CrashLoop, Stopping };
+
+  struct Child {
+    Spec spec;
+    State state{State::Stopped};
+    pid_t pid{-1};
+    int pidfd{-1};
+    quint64 serial{0};  // epoll token of the current run
+    qint64 startedMs{0};
+    int consecutiveCrashes{0};
+    QList<qint64> crashTimesMs;
+    quint64 restarts{0};
+    quint64 crashes{0};
+    quint64 restartToken{0};
+  };
+
+  struct CpuSample {
+    quint64 usageUs{0};
+    qint64 atNs{0};
+  };
+
+  bool spawn(Child& child, QString* error);
+  void killAfterGrace(const QString& id, quint64 serial);
+  void waitForAll(const QList<QString>& ids, int timeoutMs) const;
+  void signalChild(const Child& child, int signo) const;
+  bool reap(Child& child, int* exitCode, bool* crashed, bool block);
+  void finishExit(Child& child, int exitCode, bool crashed);
+  void onChildExited(quint64 serial);
+  void reapWithoutPidfd();
+  void handleCrash(Child& child, int exitCode);
+  void restart(const QString& id, quint64 token);
+  void startNextBatch();
+  void run();
+  void sampleUsage();
+  Usage sampleCgroup(const QString& id, const QString& path);
+
+  crankshaft::diagnostics::MetricsRegistry* m_registry;
+  Policy m_policy;
+  QMap<QString, Child> m_children;
+  quint64 m_nextSerial{16};  // values below are epoll tokens for the wake and stats fds
+  QTimer* m_reapTimer;       // only used without pidfd support
+  QTimer* m_bootTimer;
+  QQueue<Spec> m_bootQueue;
+
+  int m_epollFd{-1};
+  int m_wakeFd{-1};
+  int m_statsFd{-1};
+  std::thread m_thread;
+
+  // Shared with the supervisor thread
+  mutable QMutex m_usageMutex;
+  QHash<QString, QString> m_cgroups;  // running extension -> cgroup path
+  QHash<QString, Usage> m_usage;
+  QHash<QString, CpuSample> m_lastCpu;  // supervisor thread only
+};
+
+#endif  // EXTENSIONSUPERVISOR_H
@@ -0,0 +1,464 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResourceGovernor.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+
+#include "../diagnostics/MetricsRegistry.h"
+#include "../logging/Logger.h"
+
+using crankshaft::diagnostics::MetricsRegistry;
+
+namespace {
+
+const char* const kResources[] = {"cpu", "memory", "io"};
+
+constexpr qint64 kMiB = 1024 * 1024;
+
+bool writeControl(const QString& path, const QByteArray& value) {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    return false;
+  }
+  return file.write(value) == value.size();
+}
+
+QByteArray maxOr(qint64 value) {
+  return value < 0 ? QByteArrayLiteral("max") : QByteArray::number(value);
+}
+
+}  // namespace
+
+ResourceGovernor::ResourceGovernor(MetricsRegistry* registry, QObject* parent)
+    : QObject(parent),
+      m_registry(registry),
+      m_pressureDir(QStringLiteral("/proc/pressure")),
+      m_pollTimer(new QTimer(this)) {
+  m_pollTimer->setInterval(m_thresholds.pollIntervalMs);
+  connect(m_pollTimer, &QTimer::timeout, this, &ResourceGovernor::samplePressure);
+}
+
+ResourceGovernor::~ResourceGovernor() {
+  stop();
+}
+
+void ResourceGovernor::setThresholds(const Thresholds& thresholds) {
+  m_thresholds = thresholds;
+  m_pollTimer->setInterval(m_thresholds.pollIntervalMs);
+  if (m_started) {
+    disarmTriggers();
+    armTriggers();
+    updatePollTimer();
+  }
+}
+
+ResourceGovernor::Thresholds ResourceGovernor::thresholds() const {
+  return m_thresholds;
+}
+
+void ResourceGovernor::setPressureDirectory(const QString& path) {
+  m_pressureDir = path;
+}
+
+bool ResourceGovernor::start() {
+  if (m_started) {
+    return true;
+  }
+  if (!QFile::exists(m_pressureDir + QStringLiteral("/cpu"))) {
+    Logger::instance().warning(
+        QString("[ResourceGovernor] %1 not available, governing by driving state only")
+            .arg(m_pressureDir));
+    return false;
+  }
+  m_started = true;
+  if (!armTriggers()) {
+    Logger::instance().info(
+        QString("[ResourceGovernor] PSI triggers not permitted, polling every %1 ms")
+            .arg(m_thresholds.pollIntervalMs));
+  }
+  samplePressure();
+  updatePollTimer();
+  return true;
+}
+
+void ResourceGovernor::stop() {
+  m_started = false;
+  disarmTriggers();
+  m_pollTimer->stop();
+}
+
+bool ResourceGovernor::armTriggers() {
+  const QByteArray trigger = QByteArray("some ") + QByteArray::number(m_thresholds.triggerStallUs) +
+                             ' ' + QByteArray::number(m_thresholds.triggerWindowUs);
+  for (const char* resource : kResources) {
+    const QByteArray path = QFile::encodeName(m_pressureDir + QLatin1Char('/') + resource);
+    const int fd = ::open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+    // The trigger string is written with its terminating NUL
+    if (::write(fd, trigger.constData(), trigger.size() + 1) < 0) {
+      ::close(fd);
+      continue;
+    }
+    // PSI signals a breached trigger as POLLPRI
+    auto* notifier = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+    connect(notifier, &QSocketNotifier::activated, this, &ResourceGovernor::onTriggered);
+    m_triggerFds.append(fd);
+    m_triggerNotifiers.append(notifier);
+  }
+  return !m_triggerFds.isEmpty();
+}
+
+void ResourceGovernor::disarmTriggers() {
+  qDeleteAll(m_triggerNotifiers);
+  m_triggerNotifiers.clear();
+  for (int fd : m_triggerFds) {
+    ::close(fd);
+  }
+  m_triggerFds.clear();
+}
+
+void ResourceGovernor::updatePollTimer() {
+  // Triggers only fire on the way up; relief has to be polled for
+  const bool poll = m_started && (m_triggerFds.isEmpty() || m_underPressure);
+  if (poll && !m_pollTimer->isActive()) {
+    m_pollTimer->start();
+  } else if (!poll) {
+    m_pollTimer->stop();
+  }
+}
+
+void ResourceGovernor::track(const QString& id, const QString& cgroupPath,
+                             ResourceClass resourceClass) {
+  Governed& governed = m_governed[id];
+  governed = Governed();
+  governed.cgroupPath = cgroupPath;
+  governed.resourceClass = resourceClass;
+  apply(id, governed);
+}
+
+void ResourceGovernor::untrack(const QString& id) {
+  m_governed.remove(id);
+}
+
+bool ResourceGovernor::isTracked(const QString& id) const {
+  return m_governed.contains(id);
+}
+
+ResourceGovernor::Level ResourceGovernor::level() const {
+  return m_level;
+}
+
+bool ResourceGovernor::isDriving() const {
+  return m_driving;
+}
+
+bool ResourceGovernor::isProjectionActive() const {
+  return m_projectionActive;
+}
+
+bool ResourceGovernor::isUnderPressure() const {
+  return m_underPressure;
+}
+
+void ResourceGovernor::setDriving(bool driving) {
+  if (m_driving != driving) {
+    m_driving = driving;
+    reevaluate();
+  }
+}
+
+void ResourceGovernor::setProjectionActive(bool active) {
+  if (m_projectionActive != active) {
+    m_projectionActive = active;
+    reevaluate();
+  }
+}
+
+bool ResourceGovernor::readPressure(double* highest) {
+  *highest = 0.0;
+  bool any = false;
+  for (const char* resource : kResources) {
+    QFile file(m_pressureDir + QLatin1Char('/') + resource);
+    Pressure pressure;
+    if (file.open(QIODevice::ReadOnly) && parsePressure(file.readAll(), &pressure)) {
+      *highest = qMax(*highest, pressure.someAvg10);
+      any = true;
+    }
+    m_pressure.insert(QString::fromLatin1(resource), pressure);
+  }
+  return any;
+}
+
+void ResourceGovernor::setUnderPressure(bool underPressure) {
+  if (underPressure != m_underPressure) {
+    m_underPressure = underPressure;
+    m_quietPolls = 0;
+    reevaluate();
+    updatePollTimer();
+  }
+}
+
+void ResourceGovernor::samplePressure() {
+  double highest = 0.0;
+  if (!readPressure(&highest)) {
+    return;
+  }
+
+  // Hysteresis, so a load hovering around one threshold does not flap, and a
+  // dwell before relief: avg10 dips between the short bursts that breach a
+  // trigger, and every transition rewrites the cgroup files
+  if (!m_underPressure) {
+    setUnderPressure(highest > m_thresholds.highPercent);
+    return;
+  }
+  m_quietPolls = highest < m_thresholds.lowPercent ? m_quietPolls + 1 : 0;
+  if (m_quietPolls >= m_thresholds.releasePolls) {
+    setUnderPressure(false);
+  }
+}
+
+void ResourceGovernor::onTriggered() {
+  // A breached trigger is the start of pressure, whatever avg10 says yet: it
+  // lags a short stall burst by seconds. Polling takes over to find relief.
+  double highest = 0.0;
+  readPressure(&highest);
+  m_quietPolls = 0;
+  setUnderPressure(true);
+}
+
+void ResourceGovernor::reevaluate() {
+  const Level level = levelFor(m_driving, m_projectionActive, m_underPressure);
+  if (level == m_level) {
+    return;
+  }
+  m_level = level;
+  for (auto it = m_governed.begin(); it != m_governed.end(); ++it) {
+    apply(it.key(), it.value());
+  }
+  if (m_registry) {
+    m_registry
+        ->gauge("extension_governor_level", "Extension resource level: 0 relaxed, 2 strict")
+        .set(static_cast<double>(level));
+  }
+  Logger::instance().info(
+      QString("[ResourceGovernor] Level %1 (driving=%2, projection=%3, pressure=%4)")
+          .arg(toString(level))
+          .arg(m_driving)
+          .arg(m_projectionActive)
+          .arg(m_underPressure));
+  emit levelChanged(level);
+}
+
+void ResourceGovernor::apply(const QString& id, Governed& governed) {
+  const Limits limits = limitsFor(governed.resourceClass, m_level);
+  if (governed.hasApplied && governed.applied == limits) {
+    return;
+  }
+
+  const QString& path = governed.cgroupPath;
+  const Limits& old = governed.applied;
+  const bool all = !governed.hasApplied;
+  bool ok = true;
+  int writes = 0;
+  if (all || old.cpuQuotaUs != limits.cpuQuotaUs) {
+    ok = writeControl(path + QStringLiteral("/cpu.max"),
+                      maxOr(limits.cpuQuotaUs) + ' ' + QByteArray::number(kCpuPeriodUs)) &&
+         ok;
+    ++writes;
+  }
+  if (all || old.cpuWeight != limits.cpuWeight) {
+    ok = writeControl(path + QStringLiteral("/cpu.weight"),
+                      QByteArray::number(limits.cpuWeight)) &&
+         ok;
+    ++writes;
+  }
+  if (all || old.ioWeight != limits.ioWeight) {
+    ok = writeControl(path + QStringLiteral("/io.weight"),
+                      "default " + QByteArray::number(limits.ioWeight)) &&
+         ok;
+    ++writes;
+  }
+  if (all || old.memoryHighBytes != limits.memoryHighBytes) {
+    ok = writeControl(path + QStringLiteral("/memory.high"), maxOr(limits.memoryHighBytes)) && ok;
+    ++writes;
+  }
+
+  governed.applied = limits;
+  governed.hasApplied = true;
+  if (m_registry) {
+    m_registry->counter("extension_governor_writes_total", "cgroup control files written")
+        .add(writes);
+  }
+  // Controllers missing from the parent's subtree_control fail every time
+  if (!ok && !governed.warned) {
+    governed.warned = true;
+    Logger::instance().warning(
+        QString("[ResourceGovernor] Could not apply limits to %1 (%2)").arg(id, path));
+  }
+}
+
+QJsonObject ResourceGovernor::status() const {
+  QJsonObject pressure;
+  for (auto it = m_pressure.constBegin(); it != m_pressure.constEnd(); ++it) {
+    if (it.value().valid) {
+      pressure.insert(it.key(), it.value().someAvg10);
+    }
+  }
+
+  QJsonObject extensions;
+  for (auto it = m_governed.constBegin(); it != m_governed.constEnd(); ++it) {
+    const Limits& limits = it.value().applied;
+    QJsonObject obj;
+    obj.insert(QStringLiteral("class"), toString(it.value().resourceClass));
+    obj.insert(QStringLiteral("cpu_quota_us"), limits.cpuQuotaUs);
+    obj.insert(QStringLiteral("cpu_weight"), limits.cpuWeight);
+    obj.insert(QStringLiteral("io_weight"), limits.ioWeight);
+    obj.insert(QStringLiteral("memory_high"), limits.memoryHighBytes);
+    extensions.insert(it.key(), obj);
+  }
+
+  QJsonObject obj;
+  obj.insert(QStringLiteral("level"), toString(m_level));
+  obj.insert(QStringLiteral("driving"), m_driving);
+  obj.insert(QStringLiteral("projection"), m_projectionActive);
+  obj.insert(QStringLiteral("under_pressure"), m_underPressure);
+  obj.insert(QStringLiteral("pressure_some_avg10"), pressure);
+  obj.insert(QStringLiteral("psi_triggers"), static_cast<int>(m_triggerFds.size()));
+  obj.insert(QStringLiteral("extensions"), extensions);
+  return obj;
+}
+
+ResourceGovernor::Level ResourceGovernor::levelFor(bool driving, bool projectionActive,
+                                                   bool underPressure) {
+  const int reasons = int(driving) + int(projectionActive) + int(underPressure);
+  if (reasons >= 2) {
+    return Level::Strict;
+  }
+  return reasons == 1 ? Level::Constrained : Level::Relaxed;
+}
+
+ResourceGovernor::Limits ResourceGovernor::limitsFor(ResourceClass resourceClass, Level level) {
+  // {cpu.max quota per 100 ms, cpu.weight, io.weight, memory.high}. The core
+  // and media run at the default weight of 100, so weights below that lose
+  // contended time; memory.high reclaims before the 512 MB memory.max kills.
+  switch (level) {
+    case Level::Relaxed:
+      switch (resourceClass) {
+        case ResourceClass::Background:
+          return {25000, 50, 50, -1};
+        case ResourceClass::Normal:
+          return {50000, 100, 100, -1};
+        case ResourceClass::Interactive:
+          return {100000, 100, 100, -1};
+      }
+      break;
+    case Level::Constrained:
+      switch (resourceClass) {
+        case ResourceClass::Background:
+          return {10000, 10, 10, 128 * kMiB};
+        case ResourceClass::Normal:
+          return {25000, 40, 40, 256 * kMiB};
+        case ResourceClass::Interactive:
+          return {50000, 80, 80, 384 * kMiB};
+      }
+      break;
+    case Level::Strict:
+      switch (resourceClass) {
+        case ResourceClass::Background:
+          return {5000, 1, 1, 64 * kMiB};
+        case ResourceClass::Normal:
+          return {10000, 10, 10, 128 * kMiB};
+        case ResourceClass::Interactive:
+          return {25000, 25, 25, 256 * kMiB};
+      }
+      break;
+  }
+  return {};
+}
+
+ResourceGovernor::ResourceClass ResourceGovernor::resourceClassFromString(const QString& name) {
+  if (name == QLatin1String("background")) {
+    return ResourceClass::Background;
+  }
+  if (name == QLatin1String("interactive")) {
+    return ResourceClass::Interactive;
+  }
+  return ResourceClass::Normal;
+}
+
+QString ResourceGovernor::toString(ResourceClass resourceClass) {
+  switch (resourceClass) {
+    case ResourceClass::Background:
+      return QStringLiteral("background");
+    case ResourceClass::Interactive:
+      return QStringLiteral("interactive");
+    case ResourceClass::Normal:
+      break;
+  }
+  return QStringLiteral("normal");
+}
+
+QString ResourceGovernor::toString(Level level) {
+  switch (level) {
+    case Level::Constrained:
+      return QStringLiteral("constrained");
+    case Level::Strict:
+      return QStringLiteral("strict");
+    case Level::Relaxed:
+      break;
+  }
+  return QStringLiteral("relaxed");
+}
+
+bool ResourceGovernor::parsePressure(const QByteArray& text, Pressure* pressure) {
+  // some avg10=1.53 avg60=0.87 avg300=0.22 total=12345678
+  // full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+  *pressure = Pressure();
+  bool sawSome = false;
+  for (const QByteArray& line : text.split('\n')) {
+    const QList<QByteArray> fields = line.simplified().split(' ');
+    if (fields.size() < 2 || !fields.at(1).startsWith("avg10=")) {
+      continue;
+    }
+    bool ok = false;
+    const double avg10 = fields.at(1).mid(6).toDouble(&ok);
+    if (!ok) {
+      continue;
+    }
+    if (fields.at(0) == "some") {
+      pressure->someAvg10 = avg10;
+      sawSome = true;
+    } else if (fields.at(0) == "full") {
+      pressure->fullAvg10 = avg10;
+    }
+  }
+  pressure->valid = sawSome;
+  return sawSome;
+}
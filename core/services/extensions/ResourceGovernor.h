@@ -0,0 +1,184 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCEGOVERNOR_H
+#define RESOURCEGOVERNOR_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QSocketNotifier;
+class QTimer;
+
+namespace crankshaft {
+namespace diagnostics {
+class MetricsRegistry;
+}
+}  // namespace crankshaft
+
+/**
+ * @brief Adjusts extension cgroups so media and Android Auto win under load
+ *
+ * Each running extension's cgroup v2 cpu.max, cpu.weight, io.weight and
+ * memory.high are set from its manifest's resource class and the current
+ * level. Driving, an active Android Auto projection and system pressure each
+ * raise the level by one: Relaxed when parked and idle, Constrained with one
+ * of them, Strict with two or more. memory.max stays at the hard limit the
+ * extension was started with.
+ *
+ * Pressure comes from /proc/pressure (PSI). A breached stall trigger on cpu,
+ * memory or io starts pressure at once; from then on avg10 is polled until
+ * it has stayed below lowPercent for releasePolls polls in a row, counted
+ * from the last breached trigger. Where triggers are not permitted, avg10 is
+ * polled all the time and pressure starts above highPercent. Only values
+ * that changed are written.
+ *
+ * Connect DrivingModeService::drivingModeChanged to setDriving() and the
+ * projection state to setProjectionActive().
+ */
+class ResourceGovernor : public QObject {
+  Q_OBJECT
+
+ public:
+  enum class ResourceClass { Background, Normal, Interactive };
+  enum class Level { Relaxed, Constrained, Strict };
+  Q_ENUM(ResourceClass)
+  Q_ENUM(Level)
+
+  struct Limits {
+    qint64 cpuQuotaUs{-1};  // per kCpuPeriodUs; -1 writes "max"
+    int cpuWeight{100};
+    int ioWeight{100};
+    qint64 memoryHighBytes{-1};  // -1 writes "max"
+
+    bool operator==(const Limits& other) const {
+      return cpuQuotaUs == other.cpuQuotaUs && cpuWeight == other.cpuWeight &&
+             ioWeight == other.ioWeight && memoryHighBytes == other.memoryHighBytes;
+    }
+    bool operator!=(const Limits& other) const {
+      return !(*this == other);
+    }
+  };
+
+  struct Thresholds {
+    double highPercent{20.0};  // without triggers: some avg10 above this is pressure
+    double lowPercent{5.0};    // pressure ends once every avg10 is below this...
+    int releasePolls{3};       // ...for this many polls in a row
+    int pollIntervalMs{2000};
+    qint64 triggerStallUs{150000};    // PSI trigger: this much stall...
+    qint64 triggerWindowUs{2000000};  // ...within this window
+  };
+
+  struct Pressure {
+    bool valid{false};
+    double someAvg10{0.0};
+    double fullAvg10{0.0};
+  };
+
+  static constexpr qint64 kCpuPeriodUs = 100000;
+
+  explicit ResourceGovernor(crankshaft::diagnostics::MetricsRegistry* registry = nullptr,
+                            QObject* parent = nullptr);
+  ~ResourceGovernor() override;
+
+  void setThresholds(const Thresholds& thresholds);
+  Thresholds thresholds() const;
+
+  // Where cpu, memory and io pressure files are read (default /proc/pressure)
+  void setPressureDirectory(const QString& path);
+
+  /**
+   * @brief Start watching pressure
+   * @return False if PSI is unavailable; driving and projection still apply
+   */
+  bool start();
+  void stop();
+
+  // Govern a started extension's cgroup; limits are applied at once
+  void track(const QString& id, const QString& cgroupPath, ResourceClass resourceClass);
+  void untrack(const QString& id);
+  bool isTracked(const QString& id) const;
+
+  Level level() const;
+  bool isDriving() const;
+  bool isProjectionActive() const;
+  bool isUnderPressure() const;
+
+  // level, inputs, latest pressure and each extension's applied limits
+  QJsonObject status() const;
+
+  static Level levelFor(bool driving, bool projectionActive, bool underPressure);
+  static Limits limitsFor(ResourceClass resourceClass, Level level);
+  static ResourceClass resourceClassFromString(const QString& name);
+  static QString toString(ResourceClass resourceClass);
+  static QString toString(Level level);
+
+  // /proc/pressure file parser, exposed for tests
+  static bool parsePressure(const QByteArray& text, Pressure* pressure);
+
+ public slots:
+  void setDriving(bool driving);
+  void setProjectionActive(bool active);
+
+  // Read the pressure files now and re-evaluate
+  void samplePressure();
+
+ signals:
+  void levelChanged(ResourceGovernor::Level level);
+
+ private:
+  struct Governed {
+    QString cgroupPath;
+    ResourceClass resourceClass{ResourceClass::Normal};
+    Limits applied;
+    bool hasApplied{false};
+    bool warned{false};
+  };
+
+  void reevaluate();
+  void apply(const QString& id, Governed& governed);
+  bool readPressure(double* highest);
+  void setUnderPressure(bool underPressure);
+  void onTriggered();
+  bool armTriggers();
+  void disarmTriggers();
+  void updatePollTimer();
+
+  crankshaft::diagnostics::MetricsRegistry* m_registry;
+  Thresholds m_thresholds;
+  QString m_pressureDir;
+  QHash<QString, Governed> m_governed;
+
+  bool m_driving{false};
+  bool m_projectionActive{false};
+  bool m_underPressure{false};
+  int m_quietPolls{0};  // consecutive polls below lowPercent while under pressure
+  Level m_level{Level::Relaxed};
+  QHash<QString, Pressure> m_pressure;  // resource -> latest sample
+
+  bool m_started{false};
+  QList<int> m_triggerFds;
+  QList<QSocketNotifier*> m_triggerNotifiers;
+  QTimer* m_pollTimer;
+};
+
+#endif  // RESOURCEGOVERNOR_H
@@ -25,7 +25,10 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
 #include <QUuid>
 #include <fstream>
 
@@ -41,8 +44,55 @@ using nlohmann::json;
 namespace json_schema = nlohmann::json_schema;
 #endif
 
+#include "../diagnostics/StartupTracer.h"
 #include "../logging/Logger.h"
 
+namespace {
+
+// Coalescing window for profile writes. Bursts of mutations (UI sliders,
+// bulk device edits) inside this window collapse into a single write.
+constexpr int kDefaultSaveDelayMs = 250;
+
+// Backoff for retrying a failed background write (read-only or full disk)
+constexpr int kMinRetryDelayMs = 1000;
+constexpr int kMaxRetryDelayMs = 60000;
+
+bool writeJsonAtomically(const QString& path, const QJsonArray& array) {
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    Logger::instance().error(
+        QString("ProfileManager: Cannot open %1 for writing: %2").arg(path, file.errorString()));
+    return false;
+  }
+
+  const QByteArray data = QJsonDocument(array).toJson();
+  if (file.write(data) != data.size()) {
+    Logger::instance().error(
+        QString("ProfileManager: Failed to write %1: %2").arg(path, file.errorString()));
+    file.cancelWriting();
+    return false;
+  }
+
+  // commit() flushes, fsyncs and renames over the previous file
+  if (!file.commit()) {
+    Logger::instance().error(
+        QString("ProfileManager: Failed to commit %1: %2").arg(path, file.errorString()));
+    return false;
+  }
+  return true;
+}
+
+template <typename Profile>
+QJsonArray toJsonArray(const QMap<QString, Profile>& profiles) {
+  QJsonArray array;
+  for (const auto& profile : profiles) {
+    array.append(profile.toJsonObject());
+  }
+  return array;
+}
+
+}  // namespace
+
 ProfileManager::ProfileManager(const QString& configDir, QObject* parent)
     : QObject(parent), m_configDir(configDir) {
   // Ensure config directory exists
@@ -51,6 +101,21 @@ ProfileManager::ProfileManager(const QString& configDir, QObject* parent)
     dir.mkpath(".");
   }
 
+  m_saveTimer = new QTimer(this);
+  m_saveTimer->setSingleShot(true);
+  m_saveDelayMs = kDefaultSaveDelayMs;
+  m_saveTimer->setInterval(m_saveDelayMs);
+  connect(m_saveTimer, &QTimer::timeout, this, [this]() { writePendingChanges(false); });
+
+  // Serialisation and disk I/O happen off the caller's thread; the writer
+  // object only ever runs queued lambdas, so writes are strictly ordered.
+  m_writerThread = new QThread(this);
+  m_writerThread->setObjectName("ProfileWriter");
+  m_writer = new QObject();
+  m_writer->moveToThread(m_writerThread);
+  connect(m_writerThread, &QThread::finished, m_writer, &QObject::deleteLater);
+  m_writerThread->start(QThread::LowPriority);
+
   loadProfiles();
 
   // If no profiles exist, create defaults
@@ -61,7 +126,9 @@ ProfileManager::ProfileManager(const QString& configDir, QObject* parent)
 }
 
 ProfileManager::~ProfileManager() {
-  saveProfiles();
+  flush();
+  m_writerThread->quit();
+  m_writerThread->wait();
 }
 
 void ProfileManager::initializeDefaultProfiles() {
@@ -117,6 +184,8 @@ void ProfileManager::initializeDefaultProfiles() {
   bluetoothDevice.enabled = true;
   bluetoothDevice.useMock = true;
   bluetoothDevice.description = "Bluetooth connectivity";
+  // Pairing is rare; only start the stack once the UI actually asks for it
+  bluetoothDevice.activation = DeviceConfig::ActivationPolicy::OnDemand;
   devHostProfile.devices.append(bluetoothDevice);
 
   DeviceConfig wifiDevice;
@@ -125,6 +194,8 @@ void ProfileManager::initializeDefaultProfiles() {
   wifiDevice.enabled = true;
   wifiDevice.useMock = true;
   wifiDevice.description = "WiFi connectivity";
+  wifiDevice.activation = DeviceConfig::ActivationPolicy::Deferred;
+  wifiDevice.activationDelayMs = 5000;
   devHostProfile.devices.append(wifiDevice);
 
   m_hostProfiles[devHostProfile.id] = devHostProfile;
@@ -156,7 +227,28 @@ void ProfileManager::initializeDefaultProfiles() {
 
 // --- Serialization helpers for profiles ---
 
-QString HostProfile::toJson() const {
+QString DeviceConfig::activationPolicyToString(ActivationPolicy policy) {
+  switch (policy) {
+    case ActivationPolicy::Deferred:
+      return "deferred";
+    case ActivationPolicy::OnDemand:
+      return "on-demand";
+    case ActivationPolicy::Eager:
+    default:
+      return "eager";
+  }
+}
+
+DeviceConfig::ActivationPolicy DeviceConfig::activationPolicyFromString(const QString& value) {
+  const QString policy = value.trimmed().toLower();
+  if (policy == "deferred") return ActivationPolicy::Deferred;
+  if (policy == "on-demand" || policy == "ondemand" || policy == "lazy") {
+    return ActivationPolicy::OnDemand;
+  }
+  return ActivationPolicy::Eager;
+}
+
+QJsonObject HostProfile::toJsonObject() const {
   QJsonObject obj;
   obj["id"] = id;
   obj["name"] = name;
@@ -184,6 +276,12 @@ QString HostProfile::toJson() const {
     dobj["enabled"] = d.enabled;
     dobj["useMock"] = d.useMock;
     dobj["description"] = d.description;
+    if (d.activation != DeviceConfig::ActivationPolicy::Eager) {
+      dobj["activation"] = DeviceConfig::activationPolicyToString(d.activation);
+    }
+    if (d.activationDelayMs > 0) {
+      dobj["activationDelayMs"] = d.activationDelayMs;
+    }
 
     QVariantMap settingsMap;
     for (auto sit = d.settings.constBegin(); sit != d.settings.constEnd(); ++sit) {
@@ -195,7 +293,11 @@ QString HostProfile::toJson() const {
   }
   obj["devices"] = devArray;
 
-  return QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+  return obj;
+}
+
+QString HostProfile::toJson() const {
+  return QString::fromUtf8(QJsonDocument(toJsonObject()).toJson(QJsonDocument::Compact));
 }
 
 HostProfile HostProfile::fromJson(const QString& json) {
@@ -235,6 +337,8 @@ HostProfile HostProfile::fromJson(const QString& json) {
     d.enabled = dobj.value("enabled").toBool(true);
     d.useMock = dobj.value("useMock").toBool(true);
     d.description = dobj.value("description").toString();
+    d.activation = DeviceConfig::activationPolicyFromString(dobj.value("activation").toString());
+    d.activationDelayMs = qMax(0, dobj.value("activationDelayMs").toInt(0));
 
     QJsonObject s = dobj.value("settings").toObject();
     QVariantMap sm = s.toVariantMap();
@@ -253,7 +357,7 @@ HostProfile HostProfile::fromJson(const QString& json) {
   return hp;
 }
 
-QString VehicleProfile::toJson() const {
+QJsonObject VehicleProfile::toJsonObject() const {
   QJsonObject obj;
   obj["id"] = id;
   obj["name"] = name;
@@ -284,7 +388,11 @@ QString VehicleProfile::toJson() const {
     mocks.insert(it.key(), it.value());
   obj["mockDefaults"] = QJsonObject::fromVariantMap(mocks);
 
-  return QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+  return obj;
+}
+
+QString VehicleProfile::toJson() const {
+  return QString::fromUtf8(QJsonDocument(toJsonObject()).toJson(QJsonDocument::Compact));
 }
 
 VehicleProfile VehicleProfile::fromJson(const QString& json) {
@@ -339,7 +447,8 @@ bool ProfileManager::createHostProfile(const HostProfile& profile) {
   m_hostProfiles[newProfile.id] = newProfile;
   Logger::instance().info(
       QString("ProfileManager: Host profile created: %1 (%2)").arg(newProfile.name, newProfile.id));
-  return saveProfiles();
+  markDirty(HostProfilesDirty);
+  return true;
 }
 
 bool ProfileManager::updateHostProfile(const HostProfile& profile) {
@@ -355,7 +464,8 @@ bool ProfileManager::updateHostProfile(const HostProfile& profile) {
 
   Logger::instance().info(QString("ProfileManager: Host profile updated: %1").arg(profile.id));
   emit hostProfileChanged(profile.id);
-  return saveProfiles();
+  markDirty(HostProfilesDirty);
+  return true;
 }
 
 bool ProfileManager::deleteHostProfile(const QString& profileId) {
@@ -371,7 +481,8 @@ bool ProfileManager::deleteHostProfile(const QString& profileId) {
   }
 
   Logger::instance().info(QString("ProfileManager: Host profile deleted: %1").arg(profileId));
-  return saveProfiles();
+  markDirty(HostProfilesDirty);
+  return true;
 }
 
 HostProfile ProfileManager::getHostProfile(const QString& profileId) const {
@@ -408,7 +519,8 @@ bool ProfileManager::setActiveHostProfile(const QString& profileId) {
   Logger::instance().info(QString("ProfileManager: Active host profile changed to: %1 (%2)")
                               .arg(newProfile.name, profileId));
   emit hostProfileChanged(profileId);
-  return saveProfiles();
+  markDirty(HostProfilesDirty);
+  return true;
 }
 
 HostProfile ProfileManager::getActiveHostProfile() const {
@@ -429,7 +541,8 @@ bool ProfileManager::createVehicleProfile(const VehicleProfile& profile) {
   m_vehicleProfiles[newProfile.id] = newProfile;
   Logger::instance().info(QString("ProfileManager: Vehicle profile created: %1 (%2)")
                               .arg(newProfile.name, newProfile.id));
-  return saveProfiles();
+  markDirty(VehicleProfilesDirty);
+  return true;
 }
 
 bool ProfileManager::updateVehicleProfile(const VehicleProfile& profile) {
@@ -445,7 +558,8 @@ bool ProfileManager::updateVehicleProfile(const VehicleProfile& profile) {
 
   Logger::instance().info(QString("ProfileManager: Vehicle profile updated: %1").arg(profile.id));
   emit vehicleProfileChanged(profile.id);
-  return saveProfiles();
+  markDirty(VehicleProfilesDirty);
+  return true;
 }
 
 bool ProfileManager::deleteVehicleProfile(const QString& profileId) {
@@ -462,7 +576,8 @@ bool ProfileManager::deleteVehicleProfile(const QString& profileId) {
   }
 
   Logger::instance().info(QString("ProfileManager: Vehicle profile deleted: %1").arg(profileId));
-  return saveProfiles();
+  markDirty(VehicleProfilesDirty);
+  return true;
 }
 
 VehicleProfile ProfileManager::getVehicleProfile(const QString& profileId) const {
@@ -499,7 +614,8 @@ bool ProfileManager::setActiveVehicleProfile(const QString& profileId) {
   Logger::instance().info(QString("ProfileManager: Active vehicle profile changed to: %1 (%2)")
                               .arg(newProfile.name, profileId));
   emit vehicleProfileChanged(profileId);
-  return saveProfiles();
+  markDirty(VehicleProfilesDirty);
+  return true;
 }
 
 VehicleProfile ProfileManager::getActiveVehicleProfile() const {
@@ -523,7 +639,8 @@ bool ProfileManager::addDeviceToHostProfile(const QString& profileId, const Devi
   Logger::instance().info(
       QString("ProfileManager: Device added to host profile %1: %2").arg(profileId, device.name));
   emit deviceConfigChanged(profileId, device.name);
-  return saveProfiles();
+  markDirty(HostProfilesDirty);
+  return true;
 }
 
 bool ProfileManager::removeDeviceFromHostProfile(const QString& profileId,
@@ -543,7 +660,8 @@ bool ProfileManager::removeDeviceFromHostProfile(const QString& profileId,
   Logger::instance().info(QString("ProfileManager: Device removed from host profile %1: %2")
                               .arg(profileId, deviceName));
   emit deviceConfigChanged(profileId, deviceName);
-  return saveProfiles();
+  markDirty(HostProfilesDirty);
+  return true;
 }
 
 bool ProfileManager::setDeviceEnabled(const QString& profileId, const QString& deviceName,
@@ -560,7 +678,8 @@ bool ProfileManager::setDeviceEnabled(const QString& profileId, const QString& d
       Logger::instance().debug(QString("ProfileManager: Device %1 in profile %2 set to %3")
                                    .arg(deviceName, profileId, enabled ? "enabled" : "disabled"));
       emit deviceConfigChanged(profileId, deviceName);
-      return saveProfiles();
+      markDirty(HostProfilesDirty);
+      return true;
     }
   }
 
@@ -581,7 +700,8 @@ bool ProfileManager::setDeviceUseMock(const QString& profileId, const QString& d
       Logger::instance().debug(QString("ProfileManager: Device %1 in profile %2 set to use %3")
                                    .arg(deviceName, profileId, useMock ? "mock" : "real"));
       emit deviceConfigChanged(profileId, deviceName);
-      return saveProfiles();
+      markDirty(HostProfilesDirty);
+      return true;
     }
   }
 
@@ -596,6 +716,7 @@ QList<DeviceConfig> ProfileManager::getProfileDevices(const QString& profileId)
 }
 
 bool ProfileManager::loadProfiles() {
+  StartupPhase loadPhase("ProfileManager::loadProfiles");
   QString hostProfilesPath = QDir(m_configDir).filePath("host_profiles.json");
   QString vehicleProfilesPath = QDir(m_configDir).filePath("vehicle_profiles.json");
 
@@ -618,11 +739,13 @@ bool ProfileManager::loadProfiles() {
   // Load host profiles
   QFile hostFile(hostProfilesPath);
   if (hostFile.exists() && hostFile.open(QIODevice::ReadOnly)) {
+    StartupPhase hostPhase("host profiles");
     QJsonDocument doc = QJsonDocument::fromJson(hostFile.readAll());
     // Try validating the whole document against the host_profiles schema first.
     bool wholeDocValid = false;
     if (doc.isArray()) {
       try {
+        StartupPhase schemaPhase("host profiles: schema validation");
         // locate schema file (resolve via source dir or runtime fallbacks)
         QString schemaPath = resolveSchema("host_profiles.schema.json");
         std::ifstream f(schemaPath.toStdString());
@@ -718,10 +841,12 @@ bool ProfileManager::loadProfiles() {
   // Load vehicle profiles
   QFile vehicleFile(vehicleProfilesPath);
   if (vehicleFile.exists() && vehicleFile.open(QIODevice::ReadOnly)) {
+    StartupPhase vehiclePhase("vehicle profiles");
     QJsonDocument doc = QJsonDocument::fromJson(vehicleFile.readAll());
     bool wholeDocValid = false;
     if (doc.isArray()) {
       try {
+        StartupPhase schemaPhase("vehicle profiles: schema validation");
         QString schemaPath = resolveSchema("vehicle_profiles.schema.json");
         std::ifstream f(schemaPath.toStdString());
 #if CRANKSHAFT_JSON_SCHEMA_VALIDATOR
@@ -811,34 +936,116 @@ bool ProfileManager::loadProfiles() {
 }
 
 bool ProfileManager::saveProfiles() {
-  QString hostProfilesPath = QDir(m_configDir).filePath("host_profiles.json");
-  QString vehicleProfilesPath = QDir(m_configDir).filePath("vehicle_profiles.json");
+  m_dirtyFlags |= HostProfilesDirty | VehicleProfilesDirty;
+  return flush();
+}
+
+bool ProfileManager::flush() {
+  m_saveTimer->stop();
+  // Wait for any background write still in flight; what it failed to write
+  // is pending again and goes out with this flush
+  QMetaObject::invokeMethod(m_writer, []() {}, Qt::BlockingQueuedConnection);
+  m_dirtyFlags |= m_failedFlags.exchange(0);
+  writePendingChanges(true);
+  return m_dirtyFlags == 0;
+}
+
+bool ProfileManager::hasPendingChanges() const {
+  return m_dirtyFlags != 0;
+}
 
-  // Save host profiles
-  QJsonArray hostArray;
-  for (const auto& profile : m_hostProfiles) {
-    QString item = profile.toJson();
-    QJsonDocument doc = QJsonDocument::fromJson(item.toUtf8());
-    if (doc.isObject()) hostArray.append(doc.object());
+void ProfileManager::setSaveDelay(int milliseconds) {
+  m_saveDelayMs = qMax(0, milliseconds);
+  if (m_retryDelayMs == 0) {
+    m_saveTimer->setInterval(m_saveDelayMs);
   }
-  QFile hostFile(hostProfilesPath);
-  if (hostFile.open(QIODevice::WriteOnly)) {
-    hostFile.write(QJsonDocument(hostArray).toJson());
-    hostFile.close();
+}
+
+void ProfileManager::markDirty(int flags) {
+  m_dirtyFlags |= flags;
+  // Do not restart a running timer: a continuous stream of edits must not
+  // postpone the write indefinitely.
+  if (!m_saveTimer->isActive()) {
+    m_saveTimer->start();
   }
+}
 
-  // Save vehicle profiles
-  QJsonArray vehicleArray;
-  for (const auto& profile : m_vehicleProfiles) {
-    QString item = profile.toJson();
-    QJsonDocument doc = QJsonDocument::fromJson(item.toUtf8());
-    if (doc.isObject()) vehicleArray.append(doc.object());
+void ProfileManager::writePendingChanges(bool synchronous) {
+  const int flags = m_dirtyFlags;
+  if (flags == 0) {
+    return;
   }
-  QFile vehicleFile(vehicleProfilesPath);
-  if (vehicleFile.open(QIODevice::WriteOnly)) {
-    vehicleFile.write(QJsonDocument(vehicleArray).toJson());
-    vehicleFile.close();
+
+  const QString hostProfilesPath = QDir(m_configDir).filePath("host_profiles.json");
+  const QString vehicleProfilesPath = QDir(m_configDir).filePath("vehicle_profiles.json");
+
+  // Implicitly shared snapshots: copying is O(1) and later mutations on this
+  // thread detach instead of racing with the writer.
+  const QMap<QString, HostProfile> hostProfiles = m_hostProfiles;
+  const QMap<QString, VehicleProfile> vehicleProfiles = m_vehicleProfiles;
+  m_dirtyFlags = 0;
+
+  // Returns the flags of the profile sets that could not be written
+  auto write = [flags, hostProfiles, vehicleProfiles, hostProfilesPath, vehicleProfilesPath]() {
+    int failed = 0;
+    if ((flags & HostProfilesDirty) &&
+        !writeJsonAtomically(hostProfilesPath, toJsonArray(hostProfiles))) {
+      failed |= HostProfilesDirty;
+    }
+    if ((flags & VehicleProfilesDirty) &&
+        !writeJsonAtomically(vehicleProfilesPath, toJsonArray(vehicleProfiles))) {
+      failed |= VehicleProfilesDirty;
+    }
+    return failed;
+  };
+
+  if (synchronous) {
+    // Blocking queued call keeps ordering with any write already in flight
+    int failed = 0;
+    QMetaObject::invokeMethod(
+        m_writer, [&failed, &write]() { failed = write(); }, Qt::BlockingQueuedConnection);
+    if (failed) {
+      m_dirtyFlags |= failed;
+      emit saveFailed(profilePaths(failed));
+    }
+    return;
   }
 
-  return true;
+  QMetaObject::invokeMethod(
+      m_writer,
+      [this, write]() {
+        // Failed sets stay dirty and are retried; a flush() that gets there
+        // first takes the flags itself
+        m_failedFlags.fetch_or(write());
+        QMetaObject::invokeMethod(this, &ProfileManager::onBackgroundWriteFinished,
+                                  Qt::QueuedConnection);
+      },
+      Qt::QueuedConnection);
+}
+
+void ProfileManager::onBackgroundWriteFinished() {
+  const int failed = m_failedFlags.exchange(0);
+  if (failed == 0) {
+    if (m_retryDelayMs != 0) {
+      m_retryDelayMs = 0;
+      m_saveTimer->setInterval(m_saveDelayMs);
+    }
+    return;
+  }
+  m_dirtyFlags |= failed;
+  // Retry on the save timer, backing off while the disk keeps refusing
+  m_retryDelayMs = qBound(kMinRetryDelayMs, m_retryDelayMs * 2, kMaxRetryDelayMs);
+  m_saveTimer->start(m_retryDelayMs);
+  emit saveFailed(profilePaths(failed));
+}
+
+QStringList ProfileManager::profilePaths(int flags) const {
+  QStringList paths;
+  if (flags & HostProfilesDirty) {
+    paths.append(QDir(m_configDir).filePath("host_profiles.json"));
+  }
+  if (flags & VehicleProfilesDirty) {
+    paths.append(QDir(m_configDir).filePath("vehicle_profiles.json"));
+  }
+  return paths;
 }
@@ -20,22 +20,44 @@
 #pragma once
 
 #include <QDateTime>
+#include <QJsonObject>
 #include <QList>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
+#include <atomic>
 #include <memory>
 
+class QThread;
+class QTimer;
+
 /**
  * @brief Device configuration entry in a profile
  */
 struct DeviceConfig {
+  /**
+   * @brief When ServiceManager brings the device's service up
+   *
+   * Eager:    started with the other services at boot (default)
+   * Deferred: started once boot has settled, activationDelayMs has elapsed
+   *           and the main thread is idle
+   * OnDemand: started on the first subscription or service command that
+   *           targets the service's topic namespace
+   */
+  enum class ActivationPolicy { Eager, Deferred, OnDemand };
+
   QString name;
   QString type;  // DeviceInterfaceType as string
   bool enabled{true};
   bool useMock{true};
+  ActivationPolicy activation{ActivationPolicy::Eager};
+  int activationDelayMs{0};
   QMap<QString, QVariant> settings;
   QString description;
+
+  static QString activationPolicyToString(ActivationPolicy policy);
+  static ActivationPolicy activationPolicyFromString(const QString& value);
 };
 
 /**
@@ -59,6 +81,7 @@ struct HostProfile {
   QString osVersion;
   QMap<QString, QVariant> properties;
 
+  QJsonObject toJsonObject() const;
   QString toJson() const;
   static HostProfile fromJson(const QString& json);
 };
@@ -94,6 +117,7 @@ struct VehicleProfile {
   QMap<QString, QVariant> properties;
   QMap<QString, QVariant> mockDefaults;
 
+  QJsonObject toJsonObject() const;
   QString toJson() const;
   static VehicleProfile fromJson(const QString& json);
 };
@@ -103,6 +127,15 @@ struct VehicleProfile {
  *
  * Manages creation, persistence, and activation of host and vehicle profiles.
  * Allows switching between different configurations at runtime.
+ *
+ * Mutations only mark the affected profile set dirty; a short coalescing
+ * window batches bursts of changes into a single write. Writes are serialised
+ * on a dedicated thread and committed atomically (write-to-temp, fsync,
+ * rename), so a power cut never leaves a truncated profile file behind.
+ * Call flush() before shutdown to force pending changes to disk. A write that
+ * fails leaves its profile set dirty and emits saveFailed(); a failed
+ * background write is retried, after 1 s and then twice as long each time up
+ * to a minute, until one succeeds.
  */
 class ProfileManager : public QObject {
   Q_OBJECT
@@ -139,18 +172,46 @@ class ProfileManager : public QObject {
   // Persistence
   bool loadProfiles();
   bool saveProfiles();
+  // Write pending changes and wait for it; false if any profile file could not be written
+  bool flush();
+  bool hasPendingChanges() const;
+  void setSaveDelay(int milliseconds);
 
  signals:
   void hostProfileChanged(const QString& profileId);
   void vehicleProfileChanged(const QString& profileId);
   void deviceConfigChanged(const QString& profileId, const QString& deviceName);
 
+  /**
+   * @brief A profile file could not be written; the changes stay pending
+   *        and a background write is retried
+   * @param paths Files that failed
+   */
+  void saveFailed(const QStringList& paths);
+
  private:
+  enum DirtyFlag {
+    HostProfilesDirty = 0x1,
+    VehicleProfilesDirty = 0x2,
+  };
+
   void initializeDefaultProfiles();
+  void markDirty(int flags);
+  void writePendingChanges(bool synchronous);
+  void onBackgroundWriteFinished();
+  QStringList profilePaths(int flags) const;
 
   QString m_configDir;
   QMap<QString, HostProfile> m_hostProfiles;
   QMap<QString, VehicleProfile> m_vehicleProfiles;
   QString m_activeHostProfileId;
   QString m_activeVehicleProfileId;
+
+  int m_dirtyFlags{0};
+  QTimer* m_saveTimer{nullptr};
+  int m_saveDelayMs{0};
+  int m_retryDelayMs{0};  // non-zero while retrying a failed background write
+  QThread* m_writerThread{nullptr};
+  QObject* m_writer{nullptr};
+  std::atomic<int> m_failedFlags{0};  // set by the writer thread, taken on this one
 };
@@ -19,20 +19,127 @@
 
 #include "ServiceManager.h"
 
+#include <gst/gst.h>
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QTimer>
+
 #include "../../hal/multimedia/MediaPipeline.h"
 #include "../../hal/wireless/BluetoothManager.h"
 #include "../../hal/wireless/WiFiManager.h"
 #include "../android_auto/AndroidAutoService.h"
+#include "../android_auto/SensorFeeder.h"
+#include "../diagnostics/StartupTracer.h"
+#include "../eventbus/EventBus.h"
 #include "../logging/Logger.h"
 #include "../profile/ProfileManager.h"
 
+namespace {
+
+bool isAndroidAutoDevice(const DeviceConfig& device) {
+  return device.type == "AndroidAuto" || device.name == "AndroidAuto";
+}
+
+bool isWiFiDevice(const DeviceConfig& device) {
+  return device.type == "WiFi" || device.name == "WiFi";
+}
+
+bool isBluetoothDevice(const DeviceConfig& device) {
+  return device.type == "Bluetooth" || device.name == "Bluetooth";
+}
+
+/**
+ * Initialise GStreamer and load the plugins the Android Auto media path uses.
+ * gst_init() scans the plugin registry and loading a feature dlopen()s its
+ * plugin; both are thread-safe and are most of the cost of the first
+ * MediaPipeline start and decoder setup, which then find everything loaded.
+ */
+bool warmUpGStreamer() {
+  GError* error = nullptr;
+  if (!gst_init_check(nullptr, nullptr, &error)) {
+    Logger::instance().warning(QString("[ServiceManager] GStreamer init failed: %1")
+                                   .arg(error ? error->message : "unknown error"));
+    g_clear_error(&error);
+    return false;
+  }
+
+  static const char* const kFeatures[] = {
+      "appsrc",       "appsink",    "h264parse",    "avdec_h264", "decodebin",
+      "videoconvert", "videoscale", "audioconvert", "volume",     "autoaudiosink"};
+  for (const char* name : kFeatures) {
+    // Missing plugins are reported by the pipeline that needs them
+    GstPluginFeature* feature = gst_registry_lookup_feature(gst_registry_get(), name);
+    if (!feature) continue;
+    if (GstPluginFeature* loaded = gst_plugin_feature_load(feature)) {
+      gst_object_unref(loaded);
+    }
+    gst_object_unref(feature);
+  }
+  return true;
+}
+
+/**
+ * Services this device must wait for, from its "dependsOn" setting
+ * (either a JSON array or a comma separated string).
+ */
+QStringList deviceDependencies(const DeviceConfig& device) {
+  const QVariant value = device.settings.value("dependsOn");
+  QStringList deps = value.typeId() == QMetaType::QString
+                         ? value.toString().split(',', Qt::SkipEmptyParts)
+                         : value.toStringList();
+  for (auto& dep : deps) dep = dep.trimmed();
+  deps.removeAll(QString());
+  return deps;
+}
+
+/**
+ * Topic prefix a service publishes under; subscriptions to it wake the
+ * service when it is activated on demand. Overridable via "topicNamespace".
+ */
+QString topicNamespace(const DeviceConfig& device) {
+  const QString configured = device.settings.value("topicNamespace").toString();
+  if (!configured.isEmpty()) return configured;
+  if (isAndroidAutoDevice(device)) return "android-auto";
+  if (isWiFiDevice(device)) return "wifi";
+  if (isBluetoothDevice(device)) return "bluetooth";
+  return device.name.toLower();
+}
+
+/**
+ * Blocking system bus round-trip; safe to call from a worker thread.
+ */
+bool isSystemBusServiceRegistered(const QString& serviceName) {
+  QDBusConnection bus = QDBusConnection::systemBus();
+  if (!bus.isConnected() || !bus.interface()) {
+    return false;
+  }
+  return bus.interface()->isServiceRegistered(serviceName).value();
+}
+
+}  // namespace
+
 ServiceManager::ServiceManager(ProfileManager* profileManager, QObject* parent)
     : QObject(parent),
       m_profileManager(profileManager),
       m_androidAutoService(nullptr),
       m_wifiManager(nullptr),
       m_bluetoothManager(nullptr),
-      m_mediaPipeline(nullptr) {
+      m_mediaPipeline(nullptr),
+      m_idleProbe(new QTimer(this)) {
+  m_idleProbe->setSingleShot(true);
+  m_idleProbe->setTimerType(Qt::PreciseTimer);
+  m_idleProbe->setInterval(kIdleProbeIntervalMs);
+  connect(m_idleProbe, &QTimer::timeout, this, &ServiceManager::onIdleProbe);
+
+  // The UI's theme doubles as the sensor channel's night mode
+  connect(&EventBus::instance(), &EventBus::messagePublished, this,
+          [this](const QString& topic, const QVariantMap& payload) {
+            if (topic == "ui/theme/changed") {
+              setNightMode(payload.value("mode").toString() == "dark");
+            }
+          });
+
   if (!m_profileManager) {
     Logger::instance().error("[ServiceManager] ProfileManager is null");
     return;
@@ -58,15 +165,17 @@ bool ServiceManager::startAllServices() {
     return false;
   }
 
+  StartupPhase phase("ServiceManager::startAllServices");
+  cancelPendingStartup();
+
   HostProfile activeProfile = m_profileManager->getActiveHostProfile();
   Logger::instance().info(QString("[ServiceManager] Starting services for profile: %1 (%2)")
                               .arg(activeProfile.name, activeProfile.id));
   Logger::instance().info(QString("[ServiceManager] Profile has %1 device(s) configured")
                               .arg(activeProfile.devices.size()));
 
-  bool anyStarted = false;
-  int successCount = 0;
-  int failCount = 0;
+  m_startupGraph = new ServiceStartupGraph(this);
+  int scheduled = 0;
 
   for (const auto& device : activeProfile.devices) {
     Logger::instance().info(
@@ -82,45 +191,229 @@ bool ServiceManager::startAllServices() {
       continue;
     }
 
-    bool started = false;
-    if (device.type == "AndroidAuto" || device.name == "AndroidAuto") {
-      started = startAndroidAutoService(device);
-    } else if (device.type == "WiFi" || device.name == "WiFi") {
-      started = startWiFiService(device);
-    } else if (device.type == "Bluetooth" || device.name == "Bluetooth") {
-      started = startBluetoothService(device);
-    } else {
+    if (!isAndroidAutoDevice(device) && !isWiFiDevice(device) && !isBluetoothDevice(device)) {
       Logger::instance().warning(
           QString("[ServiceManager]   → Unknown device type: %1 (skipping)").arg(device.type));
       continue;
     }
 
-    if (started) {
-      successCount++;
-      anyStarted = true;
-      emit serviceStarted(device.name, true);
-    } else {
-      failCount++;
-      emit serviceStarted(device.name, false);
+    if (device.activation != DeviceConfig::ActivationPolicy::Eager) {
+      Logger::instance().info(
+          QString("[ServiceManager]   → Holding back %1 (activation: %2, namespace: %3)")
+              .arg(device.name)
+              .arg(DeviceConfig::activationPolicyToString(device.activation))
+              .arg(topicNamespace(device)));
+      m_pendingServices.insert(device.name, device);
+      continue;
     }
+
+    addToGraph(m_startupGraph, device);
+    ++scheduled;
   }
 
+  connect(m_startupGraph, &ServiceStartupGraph::serviceReady, this,
+          [this](const QString& name, bool success, qint64 elapsedMs) {
+            emit serviceStarted(name, success);
+            emit serviceReady(name, success, elapsedMs);
+          });
+  connect(m_startupGraph, &ServiceStartupGraph::finished, this,
+          [this](int succeeded, int failed, qint64 elapsedMs) {
+            Logger::instance().info(
+                QString("[ServiceManager] Service startup complete: %1 started, %2 failed (%3ms)")
+                    .arg(succeeded)
+                    .arg(failed)
+                    .arg(elapsedMs));
+            Logger::instance().info(
+                QString("[ServiceManager] Services running: AndroidAuto=%1, WiFi=%2, Bluetooth=%3")
+                    .arg(m_androidAutoService ? "yes" : "no")
+                    .arg(m_wifiManager ? "yes" : "no")
+                    .arg(m_bluetoothManager ? "yes" : "no"));
+            scheduleDeferredServices();
+            emit allServicesStarted(succeeded, failed, elapsedMs);
+          });
+
+  // A readiness handler may reload services and replace m_startupGraph
+  ServiceStartupGraph* graph = m_startupGraph;
+  graph->start(m_startupMode);
+
+  if (m_startupMode == ServiceStartupGraph::Mode::Sequential) {
+    return !getRunningServices().isEmpty();
+  }
+  return scheduled > 0 || !m_pendingServices.isEmpty();
+}
+
+void ServiceManager::addToGraph(ServiceStartupGraph* graph, const DeviceConfig& device) {
+  // Blocking work that does not touch QObjects (GStreamer plugin loading,
+  // system bus probes) runs on the pool; service objects are always created
+  // on this thread.
+  ServiceStartupGraph::Step prepare;
+  if (isAndroidAutoDevice(device) &&
+      (!device.useMock || !device.settings.value("replay.file").toString().isEmpty())) {
+    prepare = []() { return warmUpGStreamer(); };
+  } else if (!device.useMock && isWiFiDevice(device)) {
+    prepare = []() { return isSystemBusServiceRegistered("org.freedesktop.NetworkManager"); };
+  } else if (!device.useMock && isBluetoothDevice(device)) {
+    prepare = []() { return isSystemBusServiceRegistered("org.bluez"); };
+  }
+
+  graph->addService(device.name, deviceDependencies(device), prepare,
+                    [this, device]() { return startDevice(device); });
+}
+
+void ServiceManager::cancelPendingStartup() {
+  // Invalidate deferred timers and any on-demand activation still in flight
+  ++m_activationGeneration;
+  m_pendingServices.clear();
+  m_idleQueue.clear();
+  m_idleProbe->stop();
+  for (const auto& graph : std::as_const(m_activationGraphs)) {
+    if (graph) {
+      graph->cancel();
+      graph->deleteLater();
+    }
+  }
+  m_activationGraphs.clear();
+
+  if (!m_startupGraph) {
+    return;
+  }
+  if (!m_startupGraph->isFinished()) {
+    Logger::instance().info("[ServiceManager] Cancelling in-progress service startup");
+  }
+  m_startupGraph->cancel();
+  m_startupGraph->disconnect(this);
+  m_startupGraph->deleteLater();
+  m_startupGraph = nullptr;
+}
+
+void ServiceManager::scheduleDeferredServices() {
+  const quint64 generation = m_activationGeneration;
+  for (auto it = m_pendingServices.constBegin(); it != m_pendingServices.constEnd(); ++it) {
+    if (it->activation != DeviceConfig::ActivationPolicy::Deferred) continue;
+
+    const QString name = it.key();
+    Logger::instance().info(QString("[ServiceManager] %1 will start when idle, %2ms from now at "
+                                    "the earliest")
+                                .arg(name)
+                                .arg(it->activationDelayMs));
+    QTimer::singleShot(it->activationDelayMs, this, [this, name, generation]() {
+      if (generation == m_activationGeneration) {
+        queueForIdle(name);
+      }
+    });
+  }
+}
+
+void ServiceManager::queueForIdle(const QString& deviceName) {
+  if (!m_pendingServices.contains(deviceName) || m_idleQueue.contains(deviceName)) {
+    return;
+  }
+  m_idleQueue.append(deviceName);
+  if (!m_idleProbe->isActive()) {
+    m_quietProbes = 0;
+    m_idleWaitClock.start();
+    m_idleProbeClock.start();
+    m_idleProbe->start();
+  }
+}
+
+void ServiceManager::onIdleProbe() {
+  // Services started on demand in the meantime have nothing left to wait for
+  while (!m_idleQueue.isEmpty() && !m_pendingServices.contains(m_idleQueue.first())) {
+    m_idleQueue.removeFirst();
+  }
+  if (m_idleQueue.isEmpty()) {
+    return;
+  }
+
+  // A probe is late when the event loop had other work queued ahead of it
+  const qint64 lateMs = m_idleProbeClock.elapsed() - kIdleProbeIntervalMs;
+  m_quietProbes = lateMs <= kIdleProbeSlackMs ? m_quietProbes + 1 : 0;
+  const bool waitedTooLong = m_idleWaitClock.elapsed() >= kIdleWaitLimitMs;
+  if (m_quietProbes >= kIdleProbesRequired || waitedTooLong) {
+    const QString name = m_idleQueue.takeFirst();
+    activatePendingService(name, waitedTooLong ? "deferred, never idle" : "deferred, idle");
+    m_quietProbes = 0;
+    m_idleWaitClock.restart();
+  }
+
+  if (!m_idleQueue.isEmpty()) {
+    m_idleProbeClock.restart();
+    m_idleProbe->start();
+  }
+}
+
+bool ServiceManager::activatePendingService(const QString& deviceName, const QString& reason) {
+  if (!m_pendingServices.contains(deviceName)) {
+    return false;
+  }
+
+  const DeviceConfig device = m_pendingServices.take(deviceName);
   Logger::instance().info(
-      QString("[ServiceManager] Service startup complete: %1 started, %2 failed")
-          .arg(successCount)
-          .arg(failCount));
-  Logger::instance().info(
-      QString("[ServiceManager] Services running: AndroidAuto=%1, WiFi=%2, Bluetooth=%3")
-          .arg(m_androidAutoService ? "yes" : "no")
-          .arg(m_wifiManager ? "yes" : "no")
-          .arg(m_bluetoothManager ? "yes" : "no"));
+      QString("[ServiceManager] Activating %1 (%2)").arg(deviceName, reason));
+
+  // Same path as boot: blocking probes stay off the main thread, and a
+  // service without a prepare step is activated before start() returns.
+  auto* graph = new ServiceStartupGraph(this);
+  addToGraph(graph, device);
+  connect(graph, &ServiceStartupGraph::serviceReady, this,
+          [this](const QString& name, bool success, qint64 elapsedMs) {
+            emit serviceStarted(name, success);
+            emit serviceReady(name, success, elapsedMs);
+          });
+  connect(graph, &ServiceStartupGraph::finished, graph, &QObject::deleteLater);
+  m_activationGraphs.append(graph);
+  m_activationGraphs.removeAll(nullptr);
+
+  graph->start(m_startupMode);
+  return true;
+}
 
-  return anyStarted;
+QStringList ServiceManager::getPendingServices() const {
+  return m_pendingServices.keys();
+}
+
+bool ServiceManager::activateForTopic(const QString& topic) {
+  QString prefix = topic;
+  if (prefix.endsWith("/*") || prefix.endsWith("/#")) {
+    prefix.chop(2);
+  }
+  if (prefix.isEmpty() || prefix == "*" || prefix == "#") {
+    return false;
+  }
+
+  QStringList matched;
+  for (auto it = m_pendingServices.constBegin(); it != m_pendingServices.constEnd(); ++it) {
+    const QString ns = topicNamespace(it.value());
+    if (prefix == ns || prefix.startsWith(ns + "/")) {
+      matched.append(it.key());
+    }
+  }
+
+  for (const auto& name : matched) {
+    activatePendingService(name, QString("first use: %1").arg(topic));
+  }
+  return !matched.isEmpty();
+}
+
+bool ServiceManager::startDevice(const DeviceConfig& device) {
+  if (isAndroidAutoDevice(device)) {
+    return startAndroidAutoService(device);
+  }
+  if (isWiFiDevice(device)) {
+    return startWiFiService(device);
+  }
+  if (isBluetoothDevice(device)) {
+    return startBluetoothService(device);
+  }
+  return false;
 }
 
 void ServiceManager::stopAllServices() {
   Logger::instance().info("[ServiceManager] Stopping all services...");
 
+  cancelPendingStartup();
+
   stopAndroidAutoService();
   stopWiFiService();
   stopBluetoothService();
@@ -159,15 +452,9 @@ bool ServiceManager::startService(const QString& deviceName) {
 
       Logger::instance().info(QString("[ServiceManager] Starting service: %1").arg(deviceName));
 
-      bool started = false;
-      if (device.type == "AndroidAuto" || device.name == "AndroidAuto") {
-        started = startAndroidAutoService(device);
-      } else if (device.type == "WiFi" || device.name == "WiFi") {
-        started = startWiFiService(device);
-      } else if (device.type == "Bluetooth" || device.name == "Bluetooth") {
-        started = startBluetoothService(device);
-      }
-
+      // An explicit start supersedes any deferred or on-demand activation
+      m_pendingServices.remove(device.name);
+      const bool started = startDevice(device);
       emit serviceStarted(deviceName, started);
       return started;
     }
@@ -181,6 +468,9 @@ bool ServiceManager::startService(const QString& deviceName) {
 bool ServiceManager::stopService(const QString& deviceName) {
   Logger::instance().info(QString("[ServiceManager] Stopping service: %1").arg(deviceName));
 
+  // A stopped service must not be woken up again by lazy activation
+  m_pendingServices.remove(deviceName);
+
   if (deviceName == "AndroidAuto") {
     stopAndroidAutoService();
   } else if (deviceName == "WiFi") {
@@ -233,12 +523,28 @@ void ServiceManager::onProfileChanged(const QString& profileId) {
 void ServiceManager::onDeviceConfigChanged(const QString& profileId, const QString& deviceName) {
   // Only reload if this is the active profile
   HostProfile activeProfile = m_profileManager->getActiveHostProfile();
-  if (activeProfile.id == profileId) {
-    Logger::instance().info(
-        QString("[ServiceManager] Device config changed: %1, restarting service...")
-            .arg(deviceName));
-    restartService(deviceName);
+  if (activeProfile.id != profileId) {
+    return;
   }
+
+  if (m_pendingServices.contains(deviceName)) {
+    // Not started yet: refresh the held-back config instead of starting it
+    m_pendingServices.remove(deviceName);
+    for (const auto& device : activeProfile.devices) {
+      if (device.name != deviceName || !device.enabled) continue;
+      if (device.activation == DeviceConfig::ActivationPolicy::Eager) {
+        startService(deviceName);
+      } else {
+        m_pendingServices.insert(deviceName, device);
+      }
+    }
+    return;
+  }
+
+  Logger::instance().info(
+      QString("[ServiceManager] Device config changed: %1, restarting service...")
+          .arg(deviceName));
+  restartService(deviceName);
 }
 
 bool ServiceManager::startAndroidAutoService(const DeviceConfig& device) {
@@ -285,6 +591,11 @@ bool ServiceManager::startAndroidAutoService(const DeviceConfig& device) {
       QString("[ServiceManager]      AndroidAuto service started successfully (%1)")
           .arg(device.useMock ? "Mock mode" : "Real mode"));
 
+  if (SensorFeeder* feeder = sensorFeeder()) {
+    feeder->setDriving(m_driving);
+    feeder->setNightMode(m_nightMode);
+  }
+
   // Log channel configuration if available
   if (device.settings.contains("channels.video")) {
     Logger::instance().info(
@@ -336,6 +647,30 @@ bool ServiceManager::startBluetoothService(const DeviceConfig& device) {
   return false;
 }
 
+SensorFeeder* ServiceManager::sensorFeeder() const {
+  return m_androidAutoService ? m_androidAutoService->sensorFeeder() : nullptr;
+}
+
+void ServiceManager::updateVehicleState(const VehicleState& state) {
+  if (SensorFeeder* feeder = sensorFeeder()) {
+    feeder->updateVehicleState(state);
+  }
+}
+
+void ServiceManager::setDriving(bool driving) {
+  m_driving = driving;
+  if (SensorFeeder* feeder = sensorFeeder()) {
+    feeder->setDriving(driving);
+  }
+}
+
+void ServiceManager::setNightMode(bool night) {
+  m_nightMode = night;
+  if (SensorFeeder* feeder = sensorFeeder()) {
+    feeder->setNightMode(night);
+  }
+}
+
 void ServiceManager::stopAndroidAutoService() {
   if (m_androidAutoService) {
     Logger::instance().info("[ServiceManager] Stopping AndroidAuto service");
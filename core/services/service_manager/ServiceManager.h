@@ -19,16 +19,25 @@
 
 #pragma once
 
+#include <QElapsedTimer>
+#include <QMap>
 #include <QObject>
+#include <QPointer>
+#include <QStringList>
 #include <memory>
 
+#include "../profile/ProfileManager.h"
+#include "../vehicle/VehicleStateFilter.h"
+#include "ServiceStartupGraph.h"
+
 // Forward declarations
 class ProfileManager;
 class AndroidAutoService;
+class SensorFeeder;
 class WiFiManager;
 class BluetoothManager;
 class MediaPipeline;
-struct DeviceConfig;
+class QTimer;
 
 /**
  * @brief Service lifecycle manager
@@ -36,20 +45,60 @@ struct DeviceConfig;
  * Manages starting, stopping, and reloading services based on
  * ProfileManager device configurations. Allows dynamic service
  * management from UI without requiring application restart.
+ *
+ * Services are started through a ServiceStartupGraph. A device may list the
+ * services it needs in its "dependsOn" setting; independent services start
+ * concurrently and each one reports readiness as soon as it settles.
+ *
+ * Devices whose activation policy is deferred or on-demand are held back
+ * at boot. Deferred services start once the eager ones have settled, their
+ * delay has elapsed and the main thread has gone idle: a probe timer has to
+ * fire on time several times in a row. They start one at a time, each after
+ * a fresh idle period, and after kIdleWaitLimitMs at the latest. On-demand
+ * services start when a client first subscribes to their topic namespace or
+ * issues a command for them.
+ *
+ * The AndroidAuto service's sensor channel is fed from here: connect the
+ * fused vehicle state and the driving mode to updateVehicleState() and
+ * setDriving(). Night mode follows the UI theme ("ui/theme/changed" on the
+ * EventBus, "dark" meaning night). Driving and night mode are kept, so a
+ * service started later begins with the current values.
  */
 class ServiceManager : public QObject {
   Q_OBJECT
 
  public:
+  // Idle detection for deferred activation
+  static constexpr int kIdleProbeIntervalMs = 50;
+  static constexpr int kIdleProbeSlackMs = 10;  // a probe later than this means busy
+  static constexpr int kIdleProbesRequired = 3;
+  static constexpr int kIdleWaitLimitMs = 30000;  // start anyway after this
+
   explicit ServiceManager(ProfileManager* profileManager, QObject* parent = nullptr);
   ~ServiceManager() override;
 
   /**
    * @brief Start all services based on active profile
-   * @return true if at least one service started successfully
+   *
+   * In parallel mode this returns as soon as startup has been scheduled;
+   * serviceReady() and allServicesStarted() report progress. In sequential
+   * mode all services have settled by the time this returns.
+   *
+   * @return true if at least one service was scheduled (parallel) or
+   *         started successfully (sequential)
    */
   bool startAllServices();
 
+  /**
+   * @brief Select parallel (default) or sequential service startup
+   */
+  void setStartupMode(ServiceStartupGraph::Mode mode) {
+    m_startupMode = mode;
+  }
+  ServiceStartupGraph::Mode startupMode() const {
+    return m_startupMode;
+  }
+
   /**
    * @brief Stop all running services
    */
@@ -94,6 +143,21 @@ class ServiceManager : public QObject {
    */
   QStringList getRunningServices() const;
 
+  /**
+   * @brief Get list of enabled services waiting for deferred or on-demand activation
+   */
+  QStringList getPendingServices() const;
+
+  /**
+   * @brief Start every pending service whose topic namespace covers @p topic
+   *
+   * Called for incoming subscriptions. Root wildcards ("*", "#") never wake
+   * services; "android-auto/*" wakes the AndroidAuto service.
+   *
+   * @return true if at least one service was activated
+   */
+  bool activateForTopic(const QString& topic);
+
   // Service instance getters (for external access if needed)
   AndroidAutoService* getAndroidAutoService() const {
     return m_androidAutoService;
@@ -127,6 +191,19 @@ class ServiceManager : public QObject {
    */
   void serviceStopped(const QString& deviceName);
 
+  /**
+   * @brief Emitted as each service settles during startAllServices()
+   * @param deviceName Device name
+   * @param success Whether startup was successful
+   * @param elapsedMs Time since startAllServices() was called
+   */
+  void serviceReady(const QString& deviceName, bool success, qint64 elapsedMs);
+
+  /**
+   * @brief Emitted once every service scheduled by startAllServices() has settled
+   */
+  void allServicesStarted(int succeeded, int failed, qint64 elapsedMs);
+
  public slots:
   /**
    * @brief Slot to handle profile changes
@@ -140,7 +217,22 @@ class ServiceManager : public QObject {
    */
   void onDeviceConfigChanged(const QString& profileId, const QString& deviceName);
 
+  /**
+   * @brief Sensor channel inputs, passed on to the AndroidAuto service's feeder
+   */
+  void updateVehicleState(const VehicleState& state);
+  void setDriving(bool driving);
+  void setNightMode(bool night);
+
  private:
+  bool startDevice(const DeviceConfig& device);
+  void addToGraph(ServiceStartupGraph* graph, const DeviceConfig& device);
+  void cancelPendingStartup();
+  void scheduleDeferredServices();
+  void queueForIdle(const QString& deviceName);
+  void onIdleProbe();
+  bool activatePendingService(const QString& deviceName, const QString& reason);
+
   bool startAndroidAutoService(const DeviceConfig& device);
   bool startWiFiService(const DeviceConfig& device);
   bool startBluetoothService(const DeviceConfig& device);
@@ -149,6 +241,7 @@ class ServiceManager : public QObject {
   void stopWiFiService();
   void stopBluetoothService();
   void stopMediaPipeline();
+  SensorFeeder* sensorFeeder() const;
 
   ProfileManager* m_profileManager;
 
@@ -157,4 +250,23 @@ class ServiceManager : public QObject {
   WiFiManager* m_wifiManager;
   BluetoothManager* m_bluetoothManager;
   MediaPipeline* m_mediaPipeline;
+
+  // Sensor channel state for AndroidAuto services started later
+  bool m_driving{false};
+  bool m_nightMode{false};
+
+  ServiceStartupGraph* m_startupGraph{nullptr};
+  ServiceStartupGraph::Mode m_startupMode{ServiceStartupGraph::Mode::Parallel};
+
+  // Lazy activation
+  QMap<QString, DeviceConfig> m_pendingServices;
+  QList<QPointer<ServiceStartupGraph>> m_activationGraphs;
+  quint64 m_activationGeneration{0};
+
+  // Deferred services whose delay has elapsed, in the order they start
+  QStringList m_idleQueue;
+  QTimer* m_idleProbe;
+  QElapsedTimer m_idleProbeClock;  // since the probe was armed
+  QElapsedTimer m_idleWaitClock;   // since the head of the queue began waiting
+  int m_quietProbes{0};
 };
@@ -0,0 +1,234 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ServiceStartupGraph.h"
+
+#include <QThread>
+
+#include "../diagnostics/StartupTracer.h"
+#include "../logging/Logger.h"
+
+ServiceStartupGraph::ServiceStartupGraph(QObject* parent) : QObject(parent) {
+  // Startup work is mostly blocking I/O, so a few more threads than cores is fine
+  m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+  m_pool.setObjectName("ServiceStartupPool");
+}
+
+ServiceStartupGraph::~ServiceStartupGraph() {
+  cancel();
+  m_pool.waitForDone();
+}
+
+void ServiceStartupGraph::setMaxParallelism(int threads) {
+  m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+void ServiceStartupGraph::addService(const QString& name, const QStringList& dependencies,
+                                     Step prepare, Step activate) {
+  if (m_started) {
+    Logger::instance().warning(
+        QString("[ServiceStartupGraph] Cannot add %1: startup already in progress").arg(name));
+    return;
+  }
+
+  Node node;
+  node.dependencies = dependencies;
+  node.prepare = std::move(prepare);
+  node.activate = std::move(activate);
+  if (!m_nodes.contains(name)) {
+    m_order.append(name);
+  }
+  m_nodes.insert(name, node);
+}
+
+bool ServiceStartupGraph::start(Mode mode) {
+  if (m_started) {
+    return false;
+  }
+  m_started = true;
+  m_mode = mode;
+  m_timer.start();
+
+  // Drop dependencies on services that are not part of this graph
+  for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
+    QStringList known;
+    for (const auto& dep : it->dependencies) {
+      if (m_nodes.contains(dep)) {
+        known.append(dep);
+      } else {
+        Logger::instance().debug(
+            QString("[ServiceStartupGraph] %1: ignoring unknown dependency %2").arg(it.key(), dep));
+      }
+    }
+    it->dependencies = known;
+  }
+
+  if (hasCycle()) {
+    Logger::instance().error("[ServiceStartupGraph] Dependency cycle detected; not starting");
+    m_finished = true;
+    emit finished(0, m_nodes.size(), m_timer.elapsed());
+    return false;
+  }
+
+  Logger::instance().info(QString("[ServiceStartupGraph] Starting %1 service(s) (%2, %3 threads)")
+                              .arg(m_nodes.size())
+                              .arg(mode == Mode::Parallel ? "parallel" : "sequential")
+                              .arg(m_pool.maxThreadCount()));
+
+  scheduleRunnable();
+  return !m_nodes.isEmpty();
+}
+
+void ServiceStartupGraph::cancel() {
+  m_cancelled = true;
+}
+
+bool ServiceStartupGraph::hasCycle() const {
+  // Iterative DFS with white/grey/black colouring
+  QMap<QString, int> colour;  // 0 = unvisited, 1 = on stack, 2 = done
+  for (const auto& root : m_order) {
+    if (colour.value(root) != 0) continue;
+
+    QList<QPair<QString, int>> stack;
+    stack.append({root, 0});
+    colour[root] = 1;
+    while (!stack.isEmpty()) {
+      auto& [name, next] = stack.last();
+      const QStringList& deps = m_nodes.constFind(name)->dependencies;
+      if (next < deps.size()) {
+        const QString dep = deps.at(next++);
+        const int c = colour.value(dep);
+        if (c == 1) return true;
+        if (c == 0) {
+          colour[dep] = 1;
+          stack.append({dep, 0});
+        }
+      } else {
+        colour[name] = 2;
+        stack.removeLast();
+      }
+    }
+  }
+  return false;
+}
+
+bool ServiceStartupGraph::dependenciesSettled(const Node& node) const {
+  for (const auto& dep : node.dependencies) {
+    if (m_nodes.constFind(dep)->state != NodeState::Done) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ServiceStartupGraph::scheduleRunnable() {
+  // Settling a node inline can make others runnable, so sweep until stable
+  bool progressed = true;
+  while (progressed && !m_cancelled) {
+    progressed = false;
+    for (const auto& name : m_order) {
+      Node& node = m_nodes[name];
+      if (node.state != NodeState::Waiting || !dependenciesSettled(node)) continue;
+
+      node.state = NodeState::Preparing;
+      progressed = true;
+      if (m_mode == Mode::Parallel && node.prepare) {
+        runPrepare(name);
+      } else {
+        bool prepared = true;
+        if (node.prepare) {
+          const qint64 startNs = StartupTracer::nowNs();
+          prepared = node.prepare();
+          StartupTracer::instance().record((name + ": prepare").toUtf8(), startNs,
+                                           StartupTracer::nowNs(), 1);
+        }
+        settle(name, prepared);
+      }
+      if (m_cancelled) return;
+    }
+  }
+
+  if (m_finished || m_cancelled) return;
+  for (const auto& node : m_nodes) {
+    if (node.state != NodeState::Done) return;
+  }
+  m_finished = true;
+  Logger::instance().info(
+      QString("[ServiceStartupGraph] All services settled in %1ms (%2 ok, %3 failed)")
+          .arg(m_timer.elapsed())
+          .arg(m_succeeded)
+          .arg(m_failed));
+  emit finished(m_succeeded, m_failed, m_timer.elapsed());
+}
+
+void ServiceStartupGraph::runPrepare(const QString& name) {
+  Step prepare = m_nodes[name].prepare;
+  m_pool.start([this, name, prepare]() {
+    // Runs on a pool thread: report back to the owner thread, never log here
+    const qint64 startNs = StartupTracer::nowNs();
+    bool prepared = false;
+    try {
+      prepared = prepare();
+    } catch (...) {
+      prepared = false;
+    }
+    StartupTracer::instance().record((name + ": prepare").toUtf8(), startNs,
+                                     StartupTracer::nowNs(), 1);
+    QMetaObject::invokeMethod(
+        this, [this, name, prepared]() { onPrepared(name, prepared); }, Qt::QueuedConnection);
+  });
+}
+
+void ServiceStartupGraph::onPrepared(const QString& name, bool prepared) {
+  if (m_cancelled) return;
+  settle(name, prepared);
+  scheduleRunnable();
+}
+
+void ServiceStartupGraph::settle(const QString& name, bool prepared) {
+  Node& node = m_nodes[name];
+
+  for (const auto& dep : node.dependencies) {
+    if (!m_nodes[dep].success) {
+      Logger::instance().warning(
+          QString("[ServiceStartupGraph] %1: dependency %2 failed, starting anyway")
+              .arg(name, dep));
+    }
+  }
+
+  bool success = prepared;
+  if (!prepared) {
+    Logger::instance().warning(QString("[ServiceStartupGraph] %1: prepare step failed").arg(name));
+  } else if (node.activate) {
+    const qint64 startNs = StartupTracer::nowNs();
+    success = node.activate();
+    StartupTracer::instance().record((name + ": activate").toUtf8(), startNs,
+                                     StartupTracer::nowNs(), 1);
+  }
+
+  node.state = NodeState::Done;
+  node.success = success;
+  success ? ++m_succeeded : ++m_failed;
+
+  const qint64 elapsed = m_timer.elapsed();
+  Logger::instance().info(QString("[ServiceStartupGraph] %1 %2 after %3ms")
+                              .arg(name, success ? "ready" : "failed")
+                              .arg(elapsed));
+  emit serviceReady(name, success, elapsed);
+}
@@ -0,0 +1,129 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief Dependency-aware service startup scheduler
+ *
+ * Each service is registered with the names of the services it depends on
+ * and two optional steps:
+ *  - prepare:  blocking, thread-safe work (D-Bus probing, device discovery)
+ *              that runs on a worker thread in parallel mode;
+ *  - activate: QObject creation and wiring, always run on the thread that
+ *              owns the graph (normally the main thread).
+ *
+ * A service becomes runnable once all of its dependencies have settled.
+ * Dependencies are ordering constraints: a failed dependency is reported
+ * but does not cancel its dependents, so a missing WiFi adapter never
+ * blocks Android Auto over USB. Unknown dependency names are ignored.
+ *
+ * In sequential mode every step runs inline, in dependency order, and
+ * start() returns only after finished() has been emitted.
+ */
+class ServiceStartupGraph : public QObject {
+  Q_OBJECT
+
+ public:
+  using Step = std::function<bool()>;
+
+  enum class Mode { Parallel, Sequential };
+
+  explicit ServiceStartupGraph(QObject* parent = nullptr);
+  ~ServiceStartupGraph() override;
+
+  /**
+   * @brief Register a service node
+   * @param name Unique service name
+   * @param dependencies Names of services that must settle first
+   * @param prepare Worker-thread step (may be empty)
+   * @param activate Owner-thread step (may be empty)
+   */
+  void addService(const QString& name, const QStringList& dependencies, Step prepare,
+                  Step activate);
+
+  /**
+   * @brief Begin starting all registered services
+   * @return false if the graph is empty or contains a dependency cycle
+   */
+  bool start(Mode mode);
+
+  /**
+   * @brief Stop scheduling further steps; in-flight prepares are discarded
+   */
+  void cancel();
+
+  bool isFinished() const {
+    return m_finished;
+  }
+  int maxParallelism() const {
+    return m_pool.maxThreadCount();
+  }
+  void setMaxParallelism(int threads);
+
+ signals:
+  /**
+   * @brief Emitted as soon as an individual service has settled
+   * @param name Service name
+   * @param success Whether prepare and activate both succeeded
+   * @param elapsedMs Time since start() was called
+   */
+  void serviceReady(const QString& name, bool success, qint64 elapsedMs);
+
+  /**
+   * @brief Emitted once every service has settled
+   */
+  void finished(int succeeded, int failed, qint64 elapsedMs);
+
+ private:
+  enum class NodeState { Waiting, Preparing, Done };
+
+  struct Node {
+    QStringList dependencies;
+    Step prepare;
+    Step activate;
+    NodeState state{NodeState::Waiting};
+    bool success{false};
+  };
+
+  bool hasCycle() const;
+  void scheduleRunnable();
+  bool dependenciesSettled(const Node& node) const;
+  void runPrepare(const QString& name);
+  void onPrepared(const QString& name, bool prepared);
+  void settle(const QString& name, bool success);
+
+  QMap<QString, Node> m_nodes;
+  QStringList m_order;  // registration order, used for deterministic scheduling
+  QThreadPool m_pool;
+  QElapsedTimer m_timer;
+  Mode m_mode{Mode::Parallel};
+  int m_succeeded{0};
+  int m_failed{0};
+  bool m_started{false};
+  bool m_finished{false};
+  bool m_cancelled{false};
+};
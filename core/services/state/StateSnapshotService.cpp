@@ -0,0 +1,223 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StateSnapshotService.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+#include "../logging/Logger.h"
+
+namespace {
+
+constexpr int kSnapshotVersion = 1;
+
+// The snapshot is sent to every client on connect; keep it compact
+constexpr int kMaxEntries = 64;
+
+// State of the previous boot's session (projection, driving); restored for
+// context but never current
+const QStringList kSessionTopics = {"android-auto/status/#", "driving-mode/#"};
+
+bool matches(const QStringList& patterns, const QString& topic) {
+  for (const auto& pattern : patterns) {
+    if (topic == pattern || pattern == "*") return true;
+    if (pattern.endsWith("/*") || pattern.endsWith("/#")) {
+      if (topic.startsWith(pattern.left(pattern.length() - 1))) return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+StateSnapshotService::StateSnapshotService(const QString& path, QObject* parent)
+    : QObject(parent),
+      m_path(path.isEmpty()
+                 ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+                       "/state_snapshot.json"
+                 : path),
+      m_trackedTopics(defaultTrackedTopics()) {
+}
+
+QStringList StateSnapshotService::defaultTrackedTopics() {
+  // Only topics something in core publishes; a pattern nobody publishes
+  // would just add an always-empty section
+  return {"android-auto/status/#", "profiles/host/active", "profiles/host/changed",
+          "profiles/vehicle/changed", "driving-mode/#"};
+}
+
+void StateSnapshotService::setTrackedTopics(const QStringList& patterns) {
+  m_trackedTopics = patterns;
+}
+
+QStringList StateSnapshotService::trackedTopics() const {
+  return m_trackedTopics;
+}
+
+QString StateSnapshotService::path() const {
+  return m_path;
+}
+
+bool StateSnapshotService::isTracked(const QString& topic) const {
+  return matches(m_trackedTopics, topic);
+}
+
+bool StateSnapshotService::record(const QString& topic, const QVariantMap& payload) {
+  if (!isTracked(topic)) return false;
+
+  auto it = m_entries.find(topic);
+  if (it == m_entries.end()) {
+    if (m_entries.size() >= kMaxEntries) {
+      Logger::instance().debug(
+          QString("[StateSnapshot] Snapshot full, not retaining %1").arg(topic));
+      return false;
+    }
+    it = m_entries.insert(topic, Entry());
+  }
+
+  it->payload = payload;
+  it->timestamp = QDateTime::currentSecsSinceEpoch();
+  it->sequence = ++m_sequence;
+  it->restored = false;
+  it->stale = false;
+  m_dirty = true;
+  return true;
+}
+
+bool StateSnapshotService::contains(const QString& topic) const {
+  return m_entries.contains(topic);
+}
+
+StateSnapshotService::Entry StateSnapshotService::entry(const QString& topic) const {
+  return m_entries.value(topic);
+}
+
+int StateSnapshotService::size() const {
+  return m_entries.size();
+}
+
+void StateSnapshotService::clear() {
+  m_entries.clear();
+  m_dirty = true;
+}
+
+QJsonObject StateSnapshotService::toMessage() const {
+  QList<QMap<QString, Entry>::const_iterator> ordered;
+  ordered.reserve(m_entries.size());
+  for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+    ordered.append(it);
+  }
+  std::sort(ordered.begin(), ordered.end(),
+            [](const auto& a, const auto& b) { return a->sequence < b->sequence; });
+
+  QJsonArray events;
+  for (const auto& it : ordered) {
+    QJsonObject event;
+    event["topic"] = it.key();
+    event["payload"] = QJsonObject::fromVariantMap(it->payload);
+    event["timestamp"] = it->timestamp;
+    event["restored"] = it->restored;
+    event["stale"] = it->stale;
+    events.append(event);
+  }
+
+  QJsonObject message;
+  message["type"] = "snapshot";
+  message["version"] = kSnapshotVersion;
+  message["events"] = events;
+  message["timestamp"] = QDateTime::currentSecsSinceEpoch();
+  return message;
+}
+
+bool StateSnapshotService::load() {
+  QFile file(m_path);
+  if (!file.exists()) {
+    return false;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    Logger::instance().warning(
+        QString("[StateSnapshot] Failed to open snapshot %1: %2").arg(m_path, file.errorString()));
+    return false;
+  }
+
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  if (root.value("version").toInt() != kSnapshotVersion) {
+    Logger::instance().warning(
+        QString("[StateSnapshot] Ignoring snapshot %1 with unknown version").arg(m_path));
+    return false;
+  }
+
+  // Entries are re-sequenced in saved order; live values already present win
+  int restored = 0;
+  for (const auto& value : root.value("events").toArray()) {
+    const QJsonObject event = value.toObject();
+    const QString topic = event.value("topic").toString();
+    if (topic.isEmpty() || !isTracked(topic) || m_entries.contains(topic)) continue;
+    if (m_entries.size() >= kMaxEntries) break;
+
+    Entry entry;
+    entry.payload = event.value("payload").toObject().toVariantMap();
+    entry.timestamp = event.value("timestamp").toInteger();
+    entry.sequence = ++m_sequence;
+    entry.restored = true;
+    entry.stale = matches(kSessionTopics, topic);
+    m_entries.insert(topic, entry);
+    ++restored;
+  }
+
+  Logger::instance().info(
+      QString("[StateSnapshot] Restored %1 topic(s) from %2").arg(restored).arg(m_path));
+  return true;
+}
+
+bool StateSnapshotService::save() {
+  if (!m_dirty) {
+    return true;
+  }
+
+  QDir().mkpath(QFileInfo(m_path).absolutePath());
+  QSaveFile file(m_path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    Logger::instance().error(
+        QString("[StateSnapshot] Failed to write snapshot %1: %2").arg(m_path, file.errorString()));
+    return false;
+  }
+
+  QJsonObject root = toMessage();
+  root.remove("type");
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  if (!file.commit()) {
+    Logger::instance().error(QString("[StateSnapshot] Failed to commit snapshot %1: %2")
+                                 .arg(m_path, file.errorString()));
+    return false;
+  }
+
+  m_dirty = false;
+  Logger::instance().info(
+      QString("[StateSnapshot] Saved %1 topic(s) to %2").arg(m_entries.size()).arg(m_path));
+  return true;
+}
@@ -0,0 +1,101 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * @brief Last-known UI state, retained per topic
+ *
+ * Keeps the most recent payload of a small set of state topics (Android Auto
+ * status, active and changed profiles, driving mode) so a UI
+ * that connects can be populated from one batched "snapshot" message instead
+ * of waiting for each service to publish again. The snapshot is persisted on
+ * shutdown and restored on the next boot; restored entries are flagged so
+ * clients can tell them apart from values published during this run.
+ * Restored Android Auto status and driving mode describe a session that has
+ * ended, so they are also flagged stale.
+ */
+class StateSnapshotService : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Entry {
+    QVariantMap payload;
+    qint64 timestamp{0};  // epoch seconds of the last update
+    quint64 sequence{0};  // update order, so replay preserves causality
+    bool restored{false};
+    bool stale{false};  // restored session state that no longer holds
+  };
+
+  explicit StateSnapshotService(const QString& path = QString(), QObject* parent = nullptr);
+
+  /**
+   * @brief Topic patterns to retain ('x/*' and 'x/#' wildcards, as for subscriptions)
+   */
+  void setTrackedTopics(const QStringList& patterns);
+  [[nodiscard]] QStringList trackedTopics() const;
+  [[nodiscard]] static QStringList defaultTrackedTopics();
+
+  /**
+   * @brief Retain @p payload if @p topic is tracked; returns whether it was
+   */
+  bool record(const QString& topic, const QVariantMap& payload);
+
+  [[nodiscard]] bool contains(const QString& topic) const;
+  [[nodiscard]] Entry entry(const QString& topic) const;
+  [[nodiscard]] int size() const;
+  void clear();
+
+  /**
+   * @brief Snapshot message:
+   *        {"type":"snapshot","events":[{topic,payload,timestamp,restored,stale}]}
+   *
+   * Events are ordered by update sequence, so replaying them in order yields
+   * the same final state a live subscriber would have seen.
+   */
+  [[nodiscard]] QJsonObject toMessage() const;
+
+  /**
+   * @brief Restore a snapshot written by save(); entries are marked restored
+   */
+  bool load();
+
+  /**
+   * @brief Atomically persist the snapshot (no-op if nothing changed)
+   */
+  bool save();
+
+  [[nodiscard]] QString path() const;
+
+ private:
+  [[nodiscard]] bool isTracked(const QString& topic) const;
+
+  QString m_path;
+  QStringList m_trackedTopics;
+  QMap<QString, Entry> m_entries;
+  quint64 m_sequence{0};
+  bool m_dirty{false};
+};
@@ -0,0 +1,178 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DbcDatabase.h"
+
+#include <QFile>
+#include <QRegularExpression>
+
+#include "../logging/Logger.h"
+
+namespace {
+
+// BO_ <id> <name>: <length> <transmitter>
+const QRegularExpression kMessagePattern(R"(^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+))");
+
+// SG_ <name> [M|mN|mNM] : <start>|<length>@<order><sign> (<factor>,<offset>) [<min>|<max>] "<unit>"
+const QRegularExpression kSignalPattern(
+    R"(^SG_\s+(\w+)\s*(M|m\d+M?)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*)"
+    R"(\(\s*([^,\s]+)\s*,\s*([^)\s]+)\s*\)\s*\[\s*([^|\s]+)\s*\|\s*([^\]\s]+)\s*\]\s*"([^"]*)")");
+
+// VAL_ <id> <signal> <value> "<name>" ... ;
+const QRegularExpression kValueTablePattern(R"(^VAL_\s+(\d+)\s+(\w+)\s+(.*);)");
+const QRegularExpression kValueNamePattern(R"((-?\d+)\s+"([^"]*)")");
+
+}  // namespace
+
+bool DbcDatabase::load(const QString& path, QString* error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) *error = QString("Cannot open DBC file %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  return parse(file.readAll(), error);
+}
+
+bool DbcDatabase::parse(const QByteArray& text, QString* error) {
+  clear();
+  const QList<QByteArray> lines = text.split('\n');
+  DbcMessage* current = nullptr;
+  for (int number = 0; number < lines.size(); ++number) {
+    const QString line = QString::fromLatin1(lines[number]).trimmed();
+    auto fail = [&](const QString& reason) {
+      if (error) *error = QString("DBC line %1: %2").arg(number + 1).arg(reason);
+      clear();
+      return false;
+    };
+    auto skip = [&](const QString& reason) {
+      Logger::instance().warning(
+          QString("[DbcDatabase] Skipping signal on line %1: %2").arg(number + 1).arg(reason));
+    };
+
+    if (line.startsWith("BO_ ")) {
+      const QRegularExpressionMatch match = kMessagePattern.match(line);
+      if (!match.hasMatch()) {
+        return fail("malformed message definition");
+      }
+      const quint32 dbcId = match.captured(1).toUInt();
+      if (m_byId.contains(dbcId)) {
+        return fail(QString("duplicate message ID %1").arg(dbcId));
+      }
+      DbcMessage message;
+      message.extended = dbcId & kExtendedFlag;
+      message.id = dbcId & ~kExtendedFlag;
+      message.name = match.captured(2);
+      message.length = match.captured(3).toInt();
+      if (message.length > 64) {
+        return fail(QString("message %1 longer than 64 bytes").arg(message.name));
+      }
+      m_byId.insert(dbcId, m_messages.size());
+      m_messages.append(message);
+      current = &m_messages.last();
+    } else if (line.startsWith("SG_ ")) {
+      const QRegularExpressionMatch match = kSignalPattern.match(line);
+      if (!current) {
+        skip("no message to attach it to");
+        continue;
+      }
+      if (!match.hasMatch()) {
+        skip("unsupported signal definition");
+        continue;
+      }
+      DbcSignal definition;
+      definition.name = match.captured(1);
+      const QString multiplex = match.captured(2);
+      definition.multiplexer = multiplex == "M";
+      if (multiplex.startsWith('m')) {
+        // "mNM" also selects nested signals; only its own presence is decoded
+        definition.multiplexValue = multiplex.mid(1).remove('M').toInt();
+      }
+      definition.startBit = match.captured(3).toInt();
+      definition.length = match.captured(4).toInt();
+      definition.bigEndian = match.captured(5) == "0";
+      definition.isSigned = match.captured(6) == "-";
+      definition.factor = match.captured(7).toDouble();
+      definition.offset = match.captured(8).toDouble();
+      definition.minimum = match.captured(9).toDouble();
+      definition.maximum = match.captured(10).toDouble();
+      definition.unit = match.captured(11);
+      if (definition.length < 1 || definition.length > 64) {
+        skip(QString("signal %1 has length %2").arg(definition.name).arg(definition.length));
+        continue;
+      }
+      current->signalDefs.append(definition);
+    } else if (line.startsWith("VAL_ ")) {
+      const QRegularExpressionMatch match = kValueTablePattern.match(line);
+      if (!match.hasMatch()) {
+        continue;  // value tables are optional; skip what we cannot read
+      }
+      const int messageIndex = m_byId.value(match.captured(1).toUInt(), -1);
+      if (messageIndex < 0) {
+        continue;
+      }
+      for (DbcSignal& definition : m_messages[messageIndex].signalDefs) {
+        if (definition.name != match.captured(2)) {
+          continue;
+        }
+        auto pairs = kValueNamePattern.globalMatch(match.captured(3));
+        while (pairs.hasNext()) {
+          const QRegularExpressionMatch pair = pairs.next();
+          definition.valueNames.insert(pair.captured(1).toLongLong(), pair.captured(2));
+        }
+      }
+    } else if (!line.isEmpty() && !line.startsWith("SG_")) {
+      current = nullptr;  // signals only follow their message
+    }
+  }
+  return true;
+}
+
+void DbcDatabase::clear() {
+  m_messages.clear();
+  m_byId.clear();
+}
+
+const QVector<DbcMessage>& DbcDatabase::messages() const {
+  return m_messages;
+}
+
+const DbcMessage* DbcDatabase::message(quint32 id, bool extended) const {
+  const int index = m_byId.value(id | (extended ? kExtendedFlag : 0), -1);
+  return index < 0 ? nullptr : &m_messages[index];
+}
+
+bool DbcDatabase::findSignal(const QString& name, int* messageIndex, int* signalIndex) const {
+  const int dot = name.indexOf('.');
+  const QString messageName = dot < 0 ? QString() : name.left(dot);
+  const QString signalName = dot < 0 ? name : name.mid(dot + 1);
+  for (int m = 0; m < m_messages.size(); ++m) {
+    if (!messageName.isEmpty() && m_messages[m].name != messageName) {
+      continue;
+    }
+    const QVector<DbcSignal>& defs = m_messages[m].signalDefs;
+    for (int s = 0; s < defs.size(); ++s) {
+      if (defs[s].name == signalName) {
+        *messageIndex = m;
+        *signalIndex = s;
+        return true;
+      }
+    }
+  }
+  return false;
+}
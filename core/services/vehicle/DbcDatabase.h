@@ -0,0 +1,89 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Signal definition from a DBC SG_ line
+ */
+struct DbcSignal {
+  QString name;
+  int startBit{0};       // DBC numbering: LSB for Intel, MSB for Motorola
+  int length{0};         // bits
+  bool bigEndian{false};  // @0 (Motorola) rather than @1 (Intel)
+  bool isSigned{false};
+  double factor{1.0};
+  double offset{0.0};
+  double minimum{0.0};
+  double maximum{0.0};
+  QString unit;
+  bool multiplexer{false};            // the "M" selector of a multiplexed message
+  int multiplexValue{-1};             // "mN" or "mNM": only present when the selector is N
+  QHash<qint64, QString> valueNames;  // VAL_ table, e.g. gear positions
+};
+
+/**
+ * @brief Message definition from a DBC BO_ line
+ */
+struct DbcMessage {
+  quint32 id{0};  // without the extended-frame bit
+  bool extended{false};
+  QString name;
+  int length{0};  // bytes
+  QVector<DbcSignal> signalDefs;
+};
+
+/**
+ * @brief CAN database (Vector DBC) loader
+ *
+ * Reads the message (BO_), signal (SG_) and value table (VAL_) sections;
+ * everything else in the file (nodes, comments, attributes) is skipped.
+ * A signal line that cannot be decoded is skipped with a warning; only a
+ * malformed or duplicate message fails the load. Extended multiplexing
+ * ("mNM") is read as a signal present when the top selector is N, without
+ * its nested signals' SG_MUL_VAL_ ranges.
+ * Signals can be looked up by "Signal" or, where names repeat across
+ * messages, by "Message.Signal".
+ */
+class DbcDatabase {
+ public:
+  // Bit 31 of a DBC message ID marks a 29-bit identifier
+  static constexpr quint32 kExtendedFlag = 0x80000000u;
+
+  bool load(const QString& path, QString* error = nullptr);
+  bool parse(const QByteArray& text, QString* error = nullptr);
+  void clear();
+
+  const QVector<DbcMessage>& messages() const;
+  const DbcMessage* message(quint32 id, bool extended) const;
+
+  /**
+   * @brief Locate a signal by "Signal" or "Message.Signal"
+   * @return false if there is no such signal
+   */
+  bool findSignal(const QString& name, int* messageIndex, int* signalIndex) const;
+
+ private:
+  QVector<DbcMessage> m_messages;
+  QHash<quint32, int> m_byId;  // DBC ID (with kExtendedFlag) -> message index
+};
@@ -0,0 +1,41 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <array>
+
+/**
+ * @brief Row-major matrix with its size fixed at compile time
+ *
+ * Storage is an inline std::array, so matrices live on the stack or inside
+ * their owner and copying one never allocates.
+ */
+template <int Rows, int Cols>
+struct FixedMatrix {
+  std::array<double, Rows * Cols> m{};
+
+  double& operator()(int row, int col) {
+    return m[row * Cols + col];
+  }
+  double operator()(int row, int col) const {
+    return m[row * Cols + col];
+  }
+};
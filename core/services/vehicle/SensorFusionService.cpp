@@ -0,0 +1,245 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SensorFusionService.h"
+
+#include <time.h>
+
+#include <QTimer>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+
+#include "../eventbus/EventBus.h"
+#include "../extensions/DataChannelHub.h"
+#include "../logging/Logger.h"
+#include "VehicleSignalService.h"
+
+namespace {
+
+constexpr float kMphPerMetreSecond = 2.236936f;
+constexpr float kSpeedChangeMph = 0.1f;
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+}  // namespace
+
+SensorFusionService::SensorFusionService(QObject* parent)
+    : QObject(parent),
+      m_queued(0),
+      m_state(m_filter.state()),
+      m_publishedSpeedMph(-1.0f),
+      m_lastEventBusNs(0),
+      m_rateHz(kDefaultRateHz),
+      m_timer(new QTimer(this)),
+      m_stateTopic(DataChannelHub::instance().registerTopic(
+          QStringLiteral("vehicle/state"),
+          StateSignalCount * sizeof(datachannel::TelemetrySample))) {
+  m_timer->setTimerType(Qt::PreciseTimer);
+  m_timer->setInterval(1000 / m_rateHz);
+  connect(m_timer, &QTimer::timeout, this, [this]() { step(monotonicNs()); });
+}
+
+SensorFusionService::~SensorFusionService() = default;
+
+void SensorFusionService::attach(GPSDevice* gps) {
+  connect(gps, &GPSDevice::locationUpdated, this, &SensorFusionService::pushGps);
+}
+
+void SensorFusionService::attach(VehicleSignalService* vehicle) {
+  connect(vehicle, &VehicleSignalService::speedSampled, this,
+          &SensorFusionService::pushWheelSpeed);
+}
+
+void SensorFusionService::setRateHz(int rateHz) {
+  m_rateHz = qBound(1, rateHz, 1000);
+  m_timer->setInterval(1000 / m_rateHz);
+}
+
+int SensorFusionService::rateHz() const {
+  return m_rateHz;
+}
+
+void SensorFusionService::setTuning(const VehicleStateFilter::Tuning& tuning) {
+  m_filter.setTuning(tuning);
+}
+
+void SensorFusionService::start() {
+  if (m_timer->isActive()) {
+    return;
+  }
+  m_timer->start();
+  Logger::instance().info(QString("SensorFusionService: Fusing at %1 Hz").arg(m_rateHz));
+}
+
+void SensorFusionService::stop() {
+  m_timer->stop();
+}
+
+bool SensorFusionService::isRunning() const {
+  return m_timer->isActive();
+}
+
+void SensorFusionService::pushGps(const GPSLocation& location) {
+  Sample sample;
+  sample.kind = Sample::Kind::Gps;
+  sample.timestampNs = location.receivedNs > 0 ? location.receivedNs : monotonicNs();
+  sample.gps.latitude = location.latitude;
+  sample.gps.longitude = location.longitude;
+  sample.gps.speed = location.speed;
+  sample.gps.heading = location.heading;
+  sample.gps.hdop = location.hdop;
+  sample.gps.valid = location.fixType != QLatin1String("none");
+  sample.gps.timestampNs = sample.timestampNs;
+  enqueue(sample);
+}
+
+void SensorFusionService::pushWheelSpeed(double metresPerSecond, qint64 timestampNs) {
+  Sample sample;
+  sample.kind = Sample::Kind::WheelSpeed;
+  sample.timestampNs = timestampNs;
+  sample.wheelSpeed = metresPerSecond;
+  enqueue(sample);
+}
+
+void SensorFusionService::pushImu(const ImuSample& imu) {
+  Sample sample;
+  sample.kind = Sample::Kind::Imu;
+  sample.timestampNs = imu.timestampNs;
+  sample.imu = imu;
+  enqueue(sample);
+}
+
+bool SensorFusionService::enqueue(const Sample& sample) {
+  if (m_queued == kQueueCapacity) {
+    if (m_stats.queueDropped++ == 0) {
+      Logger::instance().warning(
+          "SensorFusionService: Sample queue full, is the step timer running?");
+    }
+    return false;
+  }
+  m_queue[m_queued++] = sample;
+  return true;
+}
+
+void SensorFusionService::step(qint64 nowNs) {
+  // Devices deliver in their own order; the filter wants one timeline
+  const auto begin = m_queue.begin();
+  std::sort(begin, begin + m_queued, [](const Sample& a, const Sample& b) {
+    return a.timestampNs < b.timestampNs;
+  });
+
+  int applied = 0;
+  for (; applied < m_queued && m_queue[applied].timestampNs <= nowNs; ++applied) {
+    const Sample& sample = m_queue[applied];
+    switch (sample.kind) {
+      case Sample::Kind::Gps:
+        m_filter.updateGps(sample.gps);
+        break;
+      case Sample::Kind::WheelSpeed:
+        m_filter.updateWheelSpeed(sample.wheelSpeed, sample.timestampNs);
+        break;
+      case Sample::Kind::Imu:
+        m_filter.updateImu(sample.imu);
+        break;
+    }
+  }
+  // Samples stamped after nowNs wait for the next step
+  std::copy(begin + applied, begin + m_queued, begin);
+  m_queued -= applied;
+  m_stats.samplesApplied += applied;
+
+  m_filter.predictTo(nowNs);
+  m_state = m_filter.state();
+  ++m_stats.steps;
+  emit stateUpdated(m_state);
+  if (DataChannelHub::instance().hasSubscribers(m_stateTopic)) {
+    publishToDataChannels(m_state);
+  }
+
+  if (m_state.flags & VehicleState::SpeedValid) {
+    const float speedMph = m_state.speed * kMphPerMetreSecond;
+    if (std::fabs(speedMph - m_publishedSpeedMph) >= kSpeedChangeMph) {
+      m_publishedSpeedMph = speedMph;
+      emit vehicleSpeedUpdated(speedMph);
+    }
+  }
+
+  if (nowNs - m_lastEventBusNs >= kEventBusIntervalMs * 1000000LL) {
+    m_lastEventBusNs = nowNs;
+    publishToEventBus(m_state);
+  }
+}
+
+void SensorFusionService::publishToEventBus(const VehicleState& state) {
+  QVariantMap payload;
+  payload["latitude"] = state.latitude;
+  payload["longitude"] = state.longitude;
+  payload["speed"] = state.speed;
+  payload["heading"] = state.heading;
+  payload["heading_rate"] = state.headingRate;
+  payload["acceleration"] = state.acceleration;
+  payload["position_accuracy"] = state.positionAccuracy;
+  payload["heading_accuracy"] = state.headingAccuracy;
+  payload["speed_accuracy"] = state.speedAccuracy;
+  payload["position_valid"] = (state.flags & VehicleState::PositionValid) != 0;
+  payload["heading_valid"] = (state.flags & VehicleState::HeadingValid) != 0;
+  payload["speed_valid"] = (state.flags & VehicleState::SpeedValid) != 0;
+  payload["dead_reckoning"] = (state.flags & VehicleState::DeadReckoning) != 0;
+  payload["stationary"] = (state.flags & VehicleState::Stationary) != 0;
+  payload["timestamp_ns"] = state.timestampNs;
+  EventBus::instance().publish("vehicle/state", payload);
+}
+
+void SensorFusionService::publishToDataChannels(const VehicleState& state) {
+  const quint64 timestampNs = static_cast<quint64>(state.timestampNs);
+  const quint32 positionFlags = (state.flags & VehicleState::PositionValid) ? 0 : 1;
+  const quint32 headingFlags = (state.flags & VehicleState::HeadingValid) ? 0 : 1;
+  const quint32 speedFlags = (state.flags & VehicleState::SpeedValid) ? 0 : 1;
+  const std::array<datachannel::TelemetrySample, StateSignalCount> samples = {{
+      {timestampNs, Latitude, positionFlags, state.latitude},
+      {timestampNs, Longitude, positionFlags, state.longitude},
+      {timestampNs, Speed, speedFlags, state.speed},
+      {timestampNs, Heading, headingFlags, state.heading},
+      {timestampNs, HeadingRate, headingFlags, state.headingRate},
+      {timestampNs, Acceleration, speedFlags, state.acceleration},
+      {timestampNs, PositionAccuracy, positionFlags, state.positionAccuracy},
+      {timestampNs, HeadingAccuracy, headingFlags, state.headingAccuracy},
+      {timestampNs, SpeedAccuracy, speedFlags, state.speedAccuracy},
+      {timestampNs, Flags, 0, static_cast<double>(state.flags)},
+  }};
+  DataChannelHub::instance().publishTelemetry(m_stateTopic, samples.data(), StateSignalCount);
+}
+
+VehicleState SensorFusionService::state() const {
+  return m_state;
+}
+
+const VehicleStateFilter& SensorFusionService::filter() const {
+  return m_filter;
+}
+
+SensorFusionService::Stats SensorFusionService::stats() const {
+  return m_stats;
+}
@@ -0,0 +1,164 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QObject>
+#include <array>
+
+#include "../../hal/functional/GPSDevice.h"
+#include "../../hal/functional/ImuSample.h"
+#include "VehicleStateFilter.h"
+
+class QTimer;
+class VehicleSignalService;
+
+/**
+ * @brief Fuses GPS, CAN wheel speed and IMU samples into one vehicle state
+ *
+ * Inputs are queued as they arrive, each with its CLOCK_MONOTONIC timestamp
+ * from the device layer. A fixed-rate step (default 50 Hz) applies the
+ * queued samples to a VehicleStateFilter in timestamp order, advances the
+ * filter to the current time and publishes the result. Samples from
+ * different devices may therefore arrive late or out of order within the
+ * filter's lag window. The queue and the filter are fixed size, so a step
+ * never touches the heap; only the EventBus publication (every
+ * kEventBusIntervalMs) builds a QVariantMap.
+ *
+ * Through GPS outages the state is dead-reckoned from wheel speed and the
+ * gyro, and flagged VehicleState::DeadReckoning.
+ *
+ * Published:
+ *   - stateUpdated() every step
+ *   - vehicleSpeedUpdated() when the fused speed changes by 0.1 mph or more
+ *   - EventBus "vehicle/state" with {latitude, longitude, speed, heading,
+ *     heading_rate, acceleration, position_accuracy, heading_accuracy,
+ *     speed_accuracy, position_valid, heading_valid, speed_valid,
+ *     dead_reckoning, stationary, timestamp_ns}
+ *   - data channel topic "vehicle/state" every step, one Telemetry record
+ *     with a sample per StateSignal, for extensions that want the full rate
+ *
+ * Example:
+ *   auto fusion = new SensorFusionService(this);
+ *   fusion->attach(gpsDevice);
+ *   fusion->attach(vehicleSignals);  // needs "dbc.speedSignal"
+ *   // IMU drivers hand their ImuSample stream to pushImu()
+ *   connect(fusion, &SensorFusionService::vehicleSpeedUpdated,
+ *           drivingMode, &DrivingModeService::onVehicleSpeedUpdated);
+ *   fusion->start();
+ */
+class SensorFusionService : public QObject {
+  Q_OBJECT
+
+ public:
+  static constexpr int kDefaultRateHz = 50;
+  static constexpr int kQueueCapacity = 256;
+  static constexpr int kEventBusIntervalMs = 100;
+
+  /**
+   * @brief Sample signals of the "vehicle/state" data channel records
+   *
+   * Bit 0 of a sample's flags marks a value without a valid source (see
+   * VehicleState::Flag); Flags carries VehicleState::flags itself.
+   */
+  enum StateSignal : quint32 {
+    Latitude,
+    Longitude,
+    Speed,
+    Heading,
+    HeadingRate,
+    Acceleration,
+    PositionAccuracy,
+    HeadingAccuracy,
+    SpeedAccuracy,
+    Flags,
+    StateSignalCount
+  };
+
+  struct Stats {
+    quint64 steps{0};
+    quint64 samplesApplied{0};
+    quint64 queueDropped{0};  // queue full between two steps
+  };
+
+  explicit SensorFusionService(QObject* parent = nullptr);
+  ~SensorFusionService() override;
+
+  void attach(GPSDevice* gps);
+  void attach(VehicleSignalService* vehicle);
+
+  void setRateHz(int rateHz);
+  int rateHz() const;
+
+  void setTuning(const VehicleStateFilter::Tuning& tuning);
+
+  void start();
+  void stop();
+  bool isRunning() const;
+
+  /**
+   * @brief Apply the samples taken up to nowNs, advance the filter to nowNs
+   *        and publish the state
+   *
+   * Called by the step timer with the current time; replay and tests call it
+   * with log time instead.
+   */
+  void step(qint64 nowNs);
+
+  VehicleState state() const;
+  const VehicleStateFilter& filter() const;
+  Stats stats() const;
+
+ public slots:
+  void pushGps(const GPSLocation& location);
+  void pushWheelSpeed(double metresPerSecond, qint64 timestampNs);
+  void pushImu(const ImuSample& sample);
+
+ signals:
+  void stateUpdated(const VehicleState& state);
+  void vehicleSpeedUpdated(float speedMph);
+
+ private:
+  struct Sample {
+    enum class Kind : quint8 { Gps, WheelSpeed, Imu };
+    Kind kind;
+    qint64 timestampNs;
+    union {
+      VehicleStateFilter::GpsFix gps;
+      double wheelSpeed;
+      ImuSample imu;
+    };
+  };
+
+  bool enqueue(const Sample& sample);
+  void publishToEventBus(const VehicleState& state);
+  void publishToDataChannels(const VehicleState& state);
+
+  VehicleStateFilter m_filter;
+  std::array<Sample, kQueueCapacity> m_queue;
+  int m_queued;
+  VehicleState m_state;
+  float m_publishedSpeedMph;
+  qint64 m_lastEventBusNs;
+  int m_rateHz;
+  QTimer* m_timer;
+  int m_stateTopic;
+  Stats m_stats;
+};
@@ -0,0 +1,152 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SignalDecoder.h"
+
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+quint64 load64(const quint8* data, int byteOffset, bool bigEndian) {
+  quint8 bytes[8];
+  if (byteOffset <= CANFrame::kMaxFdLength - 8) {
+    memcpy(bytes, data + byteOffset, 8);
+  } else {
+    // Near the end of a 64-byte FD payload; pad with zeros
+    memset(bytes, 0, sizeof(bytes));
+    memcpy(bytes, data + byteOffset, CANFrame::kMaxFdLength - byteOffset);
+  }
+  return bigEndian ? qFromBigEndian<quint64>(bytes) : qFromLittleEndian<quint64>(bytes);
+}
+
+}  // namespace
+
+SignalDecoder::SignalDecoder(const DbcDatabase* database) : m_database(database) {}
+
+void SignalDecoder::reset(const DbcDatabase* database) {
+  m_database = database;
+  m_plans.clear();
+  m_slotInfo.clear();
+  m_values.clear();
+}
+
+int SignalDecoder::subscribe(const QString& name, QString* error) {
+  int messageIndex = -1;
+  int signalIndex = -1;
+  if (!m_database || !m_database->findSignal(name, &messageIndex, &signalIndex)) {
+    if (error) *error = QString("Unknown signal %1").arg(name);
+    return -1;
+  }
+  for (int slot = 0; slot < m_slotInfo.size(); ++slot) {
+    if (m_slotInfo[slot].messageIndex == messageIndex &&
+        m_slotInfo[slot].signalIndex == signalIndex) {
+      return slot;  // already subscribed
+    }
+  }
+
+  const DbcMessage& message = m_database->messages()[messageIndex];
+  const DbcSignal& definition = message.signalDefs[signalIndex];
+  Plan plan;
+  if (!compile(definition, &plan, error)) {
+    return -1;
+  }
+
+  MessagePlan& messagePlan =
+      m_plans[message.id | (message.extended ? DbcDatabase::kExtendedFlag : 0)];
+  if (definition.multiplexValue >= 0 && !messagePlan.multiplexed) {
+    for (const DbcSignal& candidate : message.signalDefs) {
+      if (candidate.multiplexer && compile(candidate, &messagePlan.multiplexer, error)) {
+        messagePlan.multiplexed = true;
+        break;
+      }
+    }
+    if (!messagePlan.multiplexed) {
+      if (error) *error = QString("Signal %1 has no multiplexer to select it").arg(name);
+      return -1;
+    }
+  }
+
+  plan.slot = m_slotInfo.size();
+  const int lastByte = definition.bigEndian
+                           ? (plan.byteOffset * 8 + (63 - plan.shift)) / 8
+                           : (definition.startBit + definition.length - 1) / 8;
+  messagePlan.minLength = qMax(messagePlan.minLength, lastByte + 1);
+  messagePlan.plans.append(plan);
+  m_slotInfo.append({messageIndex, signalIndex});
+  m_values.append(Value());
+  return plan.slot;
+}
+
+int SignalDecoder::slotCount() const {
+  return m_slotInfo.size();
+}
+
+QString SignalDecoder::slotName(int slot) const {
+  return definition(slot).name;
+}
+
+const DbcSignal& SignalDecoder::definition(int slot) const {
+  const SlotInfo& info = m_slotInfo[slot];
+  return m_database->messages()[info.messageIndex].signalDefs[info.signalIndex];
+}
+
+SignalDecoder::Value SignalDecoder::value(int slot) const {
+  return m_values.value(slot);
+}
+
+bool SignalDecoder::compile(const DbcSignal& definition, Plan* plan, QString* error) {
+  plan->bigEndian = definition.bigEndian;
+  plan->isSigned = definition.isSigned;
+  plan->length = definition.length;
+  plan->multiplexValue = definition.multiplexValue;
+  plan->factor = definition.factor;
+  plan->offset = definition.offset;
+  plan->mask = definition.length == 64 ? ~quint64(0) : (quint64(1) << definition.length) - 1;
+
+  if (definition.bigEndian) {
+    // Motorola: startBit is the MSB in the DBC's sawtooth numbering. Count
+    // bits from the MSB of byte 0 instead, so the signal is contiguous.
+    const int msb = (definition.startBit / 8) * 8 + (7 - definition.startBit % 8);
+    const int lsb = msb + definition.length - 1;
+    plan->byteOffset = msb / 8;
+    plan->shift = 63 - (lsb - plan->byteOffset * 8);
+  } else {
+    plan->byteOffset = definition.startBit / 8;
+    plan->shift = definition.startBit % 8;
+  }
+
+  const int lastBit = definition.bigEndian ? 63 - plan->shift : plan->shift + plan->length - 1;
+  if (plan->shift < 0 || lastBit > 63 || plan->byteOffset >= CANFrame::kMaxFdLength) {
+    if (error) {
+      *error = QString("Signal %1 does not fit one aligned 64-bit load").arg(definition.name);
+    }
+    return false;
+  }
+  return true;
+}
+
+qint64 SignalDecoder::extract(const Plan& plan, const quint8* data) {
+  const quint64 bits = (load64(data, plan.byteOffset, plan.bigEndian) >> plan.shift) & plan.mask;
+  if (plan.isSigned && plan.length < 64) {
+    const quint64 sign = quint64(1) << (plan.length - 1);
+    return static_cast<qint64>((bits ^ sign) - sign);
+  }
+  return static_cast<qint64>(bits);
+}
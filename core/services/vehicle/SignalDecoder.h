@@ -0,0 +1,142 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "../../hal/functional/CANFrame.h"
+#include "DbcDatabase.h"
+
+/**
+ * @brief Decodes subscribed DBC signals from CAN frames
+ *
+ * Subscribing compiles a signal into an extraction plan: the byte to load
+ * from, the shift and mask after one 64-bit load, sign extension, scale and
+ * offset. Plans are grouped per message behind an ID hash, so a frame costs
+ * one lookup and, for each subscribed signal in it, a load, shift, mask and
+ * compare; frames nobody subscribed to cost only the lookup. Each subscribed
+ * signal gets a slot holding its latest value.
+ */
+class SignalDecoder {
+ public:
+  struct Plan {
+    int slot{-1};
+    int byteOffset{0};   // first byte of the 64-bit load
+    int shift{0};        // right shift after the load
+    quint64 mask{0};
+    bool bigEndian{false};
+    bool isSigned{false};
+    int length{0};
+    int multiplexValue{-1};
+    double factor{1.0};
+    double offset{0.0};
+  };
+
+  struct Value {
+    bool valid{false};
+    qint64 raw{0};
+    double physical{0.0};
+    qint64 timestampNs{0};
+  };
+
+  explicit SignalDecoder(const DbcDatabase* database = nullptr);
+
+  // Drop all subscriptions and switch databases
+  void reset(const DbcDatabase* database);
+
+  /**
+   * @brief Subscribe to a signal by "Signal" or "Message.Signal"
+   * @return Slot index, or -1 with error set
+   */
+  int subscribe(const QString& name, QString* error = nullptr);
+
+  int slotCount() const;
+  QString slotName(int slot) const;
+  const DbcSignal& definition(int slot) const;
+  Value value(int slot) const;
+
+  /**
+   * @brief Decode a frame, calling onChange(slot, value) for every subscribed
+   *        signal whose raw value differs from the last one seen
+   * @return Number of subscribed signals decoded from the frame
+   */
+  template <typename Callback>
+  int decode(const CANFrame& frame, Callback&& onChange);
+
+  /**
+   * @brief Build the extraction plan for a signal
+   * @return false if the signal cannot be extracted with one 64-bit load
+   */
+  static bool compile(const DbcSignal& definition, Plan* plan, QString* error = nullptr);
+
+  static qint64 extract(const Plan& plan, const quint8* data);
+
+ private:
+  struct MessagePlan {
+    int minLength{0};  // bytes a frame needs to carry every planned signal
+    bool multiplexed{false};
+    Plan multiplexer;
+    QVector<Plan> plans;
+  };
+
+  struct SlotInfo {
+    int messageIndex;
+    int signalIndex;
+  };
+
+  const DbcDatabase* m_database;
+  QHash<quint32, MessagePlan> m_plans;  // DBC ID (with extended flag) -> plans
+  QVector<SlotInfo> m_slotInfo;
+  QVector<Value> m_values;
+};
+
+template <typename Callback>
+int SignalDecoder::decode(const CANFrame& frame, Callback&& onChange) {
+  const auto it = m_plans.constFind(frame.id | (frame.extended ? DbcDatabase::kExtendedFlag : 0));
+  if (it == m_plans.constEnd() || frame.rtr || frame.length < it->minLength) {
+    return 0;
+  }
+
+  qint64 selector = -1;
+  if (it->multiplexed) {
+    selector = extract(it->multiplexer, frame.data);
+  }
+
+  int decoded = 0;
+  for (const Plan& plan : it->plans) {
+    if (plan.multiplexValue >= 0 && plan.multiplexValue != selector) {
+      continue;
+    }
+    const qint64 raw = extract(plan, frame.data);
+    Value& value = m_values[plan.slot];
+    ++decoded;
+    value.timestampNs = frame.timestampNs;
+    if (value.valid && value.raw == raw) {
+      continue;
+    }
+    value.valid = true;
+    value.raw = raw;
+    value.physical = static_cast<double>(raw) * plan.factor + plan.offset;
+    onChange(plan.slot, value);
+  }
+  return decoded;
+}
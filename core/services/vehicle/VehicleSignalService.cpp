@@ -0,0 +1,283 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VehicleSignalService.h"
+
+#include <time.h>
+
+#include <QFile>
+#include <QTimer>
+#include <QVariantMap>
+
+#include "../../hal/functional/CANDevice.h"
+#include "../eventbus/EventBus.h"
+#include "../logging/Logger.h"
+#include "../profile/ProfileManager.h"
+
+namespace {
+
+constexpr double kMetresPerSecondPerMph = 0.44704;
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Factor from a speed unit to mph, 0 if the unit is not a speed
+double toMphFactor(const QString& unit) {
+  const QString normalized = unit.trimmed().toLower();
+  if (normalized == "mph") return 1.0;
+  if (normalized == "km/h" || normalized == "kph" || normalized == "kmh") return 0.621371;
+  if (normalized == "m/s") return 2.236936;
+  return 0.0;
+}
+
+}  // namespace
+
+VehicleSignalService::VehicleSignalService(QObject* parent)
+    : QObject(parent),
+      m_decoder(&m_database),
+      m_speedSlot(-1),
+      m_speedToMph(1.0),
+      m_speedSampledNs(0),
+      m_flushTimer(new QTimer(this)),
+      m_flushDueNs(0),
+      m_framesDecoded(0),
+      m_valuesPublished(0) {
+  m_flushTimer->setSingleShot(true);
+  connect(m_flushTimer, &QTimer::timeout, this, &VehicleSignalService::flushPending);
+}
+
+VehicleSignalService::~VehicleSignalService() = default;
+
+bool VehicleSignalService::configure(const VehicleProfile& profile, QString* error) {
+  const QString path = profile.properties.value("dbc.file").toString();
+  if (path.isEmpty()) {
+    if (error) *error = QString("Vehicle profile %1 has no dbc.file").arg(profile.name);
+    return false;
+  }
+  if (!loadDbc(path, error)) {
+    return false;
+  }
+
+  const int defaultRateMs =
+      profile.properties.value("dbc.rateLimitMs", kDefaultRateLimitMs).toInt();
+  const QVariantMap rateLimits = profile.properties.value("dbc.rateLimitsMs").toMap();
+  QStringList names = profile.properties.value("dbc.signals").toStringList();
+  const QString speedSignal = profile.properties.value("dbc.speedSignal").toString();
+  if (!speedSignal.isEmpty() && !names.contains(speedSignal)) {
+    names.append(speedSignal);
+  }
+  for (const QString& name : names) {
+    if (!subscribe(name, rateLimits.value(name, defaultRateMs).toInt(), error)) {
+      return false;
+    }
+  }
+  if (!speedSignal.isEmpty() &&
+      !setSpeedSignal(speedSignal, profile.properties.value("dbc.speedUnit").toString(), error)) {
+    return false;
+  }
+
+  Logger::instance().info(QString("VehicleSignalService: %1 decoding %2 signals from %3")
+                              .arg(profile.name)
+                              .arg(m_slotStates.size())
+                              .arg(path));
+  return true;
+}
+
+bool VehicleSignalService::loadDbc(const QString& path, QString* error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) *error = QString("Cannot open DBC file %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  return loadDbcText(file.readAll(), error);
+}
+
+bool VehicleSignalService::loadDbcText(const QByteArray& text, QString* error) {
+  DbcDatabase database;
+  if (!database.parse(text, error)) {
+    return false;
+  }
+  m_database = database;
+  m_decoder.reset(&m_database);
+  m_slotStates.clear();
+  m_speedSlot = -1;
+  return true;
+}
+
+bool VehicleSignalService::subscribe(const QString& name, int rateLimitMs, QString* error) {
+  const int slot = m_decoder.subscribe(name, error);
+  if (slot < 0) {
+    Logger::instance().warning(QString("VehicleSignalService: cannot decode %1").arg(name));
+    return false;
+  }
+  if (slot == m_slotStates.size()) {
+    SlotState state;
+    state.name = m_decoder.slotName(slot);
+    state.topic = QString("vehicle/signals/%1").arg(state.name);
+    m_slotStates.append(state);
+  }
+  m_slotStates[slot].intervalNs = static_cast<qint64>(qMax(0, rateLimitMs)) * 1000000LL;
+  return true;
+}
+
+bool VehicleSignalService::setSpeedSignal(const QString& name, const QString& unit,
+                                          QString* error) {
+  const int slot = m_decoder.subscribe(name, error);
+  if (slot < 0) {
+    return false;
+  }
+  if (slot == m_slotStates.size()) {
+    subscribe(name);
+  }
+  const double factor = toMphFactor(unit.isEmpty() ? m_decoder.definition(slot).unit : unit);
+  if (factor == 0.0) {
+    if (error) *error = QString("Speed signal %1 has no speed unit").arg(name);
+    return false;
+  }
+  m_speedSlot = slot;
+  m_speedToMph = factor;
+  return true;
+}
+
+void VehicleSignalService::attach(CANDevice* device) {
+  // Direct: the batch only lives for the duration of the emission
+  connect(device, &CANDevice::framesReceived, this, &VehicleSignalService::processFrames,
+          Qt::DirectConnection);
+}
+
+void VehicleSignalService::processFrames(const CANFrame* frames, int count) {
+  if (m_slotStates.isEmpty()) {
+    return;
+  }
+  const qint64 nowNs = monotonicNs();
+  for (int i = 0; i < count; ++i) {
+    if (m_decoder.decode(frames[i], [this, nowNs](int slot, const SignalDecoder::Value&) {
+          onValueChanged(slot, nowNs);
+        }) > 0) {
+      ++m_framesDecoded;
+    }
+  }
+
+  if (m_speedSlot >= 0) {
+    // Only the newest sample of the batch; the decoder stamps unchanged values too
+    const SignalDecoder::Value speed = m_decoder.value(m_speedSlot);
+    if (speed.valid && speed.timestampNs != m_speedSampledNs) {
+      m_speedSampledNs = speed.timestampNs;
+      emit speedSampled(speed.physical * m_speedToMph * kMetresPerSecondPerMph, speed.timestampNs);
+    }
+  }
+}
+
+void VehicleSignalService::onValueChanged(int slot, qint64 nowNs) {
+  SlotState& state = m_slotStates[slot];
+  if (!state.published || nowNs - state.lastPublishedNs >= state.intervalNs) {
+    state.lastPublishedNs = nowNs;
+    state.published = true;
+    state.pending = false;
+    publish(slot);
+    return;
+  }
+  // Too soon: keep the newest value and publish it when the interval is up
+  if (!state.pending) {
+    state.pending = true;
+    scheduleFlush(state.lastPublishedNs + state.intervalNs);
+  }
+}
+
+void VehicleSignalService::publish(int slot) {
+  const SignalDecoder::Value value = m_decoder.value(slot);
+  const DbcSignal& definition = m_decoder.definition(slot);
+  const SlotState& state = m_slotStates[slot];
+
+  QVariantMap payload;
+  payload["value"] = value.physical;
+  payload["raw"] = value.raw;
+  payload["unit"] = definition.unit;
+  payload["timestamp_ns"] = value.timestampNs;
+  const auto label = definition.valueNames.constFind(value.raw);
+  if (label != definition.valueNames.constEnd()) {
+    payload["label"] = *label;
+  }
+  ++m_valuesPublished;
+  EventBus::instance().publish(state.topic, payload);
+  emit signalChanged(state.name, value.physical);
+
+  if (slot == m_speedSlot) {
+    emit vehicleSpeedUpdated(static_cast<float>(value.physical * m_speedToMph));
+  }
+}
+
+void VehicleSignalService::flushPending() {
+  const qint64 nowNs = monotonicNs();
+  qint64 nextDueNs = 0;
+  for (int slot = 0; slot < m_slotStates.size(); ++slot) {
+    SlotState& state = m_slotStates[slot];
+    if (!state.pending) {
+      continue;
+    }
+    const qint64 dueNs = state.lastPublishedNs + state.intervalNs;
+    if (dueNs <= nowNs) {
+      state.pending = false;
+      state.lastPublishedNs = nowNs;
+      publish(slot);
+    } else if (nextDueNs == 0 || dueNs < nextDueNs) {
+      nextDueNs = dueNs;
+    }
+  }
+  m_flushDueNs = 0;
+  if (nextDueNs != 0) {
+    scheduleFlush(nextDueNs);
+  }
+}
+
+void VehicleSignalService::scheduleFlush(qint64 dueNs) {
+  if (m_flushTimer->isActive() && m_flushDueNs != 0 && m_flushDueNs <= dueNs) {
+    return;  // an earlier flush will pick this one up
+  }
+  m_flushDueNs = dueNs;
+  const qint64 delayNs = qMax<qint64>(0, dueNs - monotonicNs());
+  m_flushTimer->start(static_cast<int>((delayNs + 999999) / 1000000));
+}
+
+double VehicleSignalService::value(const QString& name, bool* valid) const {
+  for (int slot = 0; slot < m_slotStates.size(); ++slot) {
+    if (m_slotStates[slot].name == name || m_decoder.slotName(slot) == name) {
+      const SignalDecoder::Value value = m_decoder.value(slot);
+      if (valid) *valid = value.valid;
+      return value.physical;
+    }
+  }
+  if (valid) *valid = false;
+  return 0.0;
+}
+
+quint64 VehicleSignalService::framesDecoded() const {
+  return m_framesDecoded;
+}
+
+quint64 VehicleSignalService::valuesPublished() const {
+  return m_valuesPublished;
+}
+
+const DbcDatabase& VehicleSignalService::database() const {
+  return m_database;
+}
@@ -0,0 +1,150 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include "../../hal/functional/CANFrame.h"
+#include "DbcDatabase.h"
+#include "SignalDecoder.h"
+
+class CANDevice;
+class QTimer;
+struct VehicleProfile;
+
+/**
+ * @brief Turns CAN frames into named vehicle signals
+ *
+ * Loads the DBC file referenced by the active vehicle profile, decodes the
+ * subscribed signals from CANDevice frame batches and publishes changed
+ * values on the EventBus as "vehicle/signals/<Signal>" with
+ * {value, raw, unit, label, timestamp_ns}. Each signal is rate limited: a
+ * change inside the signal's interval is held back and the latest value is
+ * published once the interval has passed, so the last state always arrives.
+ *
+ * Vehicle profile properties:
+ *   - "dbc.file": Path of the DBC file
+ *   - "dbc.signals": Signals to decode ("Signal" or "Message.Signal")
+ *   - "dbc.rateLimitMs": Default minimum publish interval (default 100)
+ *   - "dbc.rateLimitsMs": Per-signal intervals, e.g. {"VehicleSpeed": 50}
+ *   - "dbc.speedSignal": Signal reported through vehicleSpeedUpdated()
+ *   - "dbc.speedUnit": "km/h", "mph" or "m/s" (default: the DBC unit)
+ *
+ * Every decoded speed sample is also reported through speedSampled() for
+ * consumers that need each measurement, such as SensorFusionService.
+ *
+ * Example:
+ *   auto vehicle = new VehicleSignalService(this);
+ *   vehicle->configure(profileManager->getActiveVehicleProfile());
+ *   vehicle->attach(canDevice);
+ *   connect(vehicle, &VehicleSignalService::vehicleSpeedUpdated,
+ *           drivingMode, &DrivingModeService::onVehicleSpeedUpdated);
+ */
+class VehicleSignalService : public QObject {
+  Q_OBJECT
+
+ public:
+  static constexpr int kDefaultRateLimitMs = 100;
+
+  explicit VehicleSignalService(QObject* parent = nullptr);
+  ~VehicleSignalService() override;
+
+  /**
+   * @brief Load the profile's DBC file and subscribe to its signals
+   * @return false if the DBC cannot be loaded or a signal is unknown
+   */
+  bool configure(const VehicleProfile& profile, QString* error = nullptr);
+
+  bool loadDbc(const QString& path, QString* error = nullptr);
+  bool loadDbcText(const QByteArray& text, QString* error = nullptr);
+
+  /**
+   * @brief Decode a signal from now on
+   * @param rateLimitMs Minimum interval between publications (0: every change)
+   */
+  bool subscribe(const QString& name, int rateLimitMs = kDefaultRateLimitMs,
+                 QString* error = nullptr);
+
+  /**
+   * @brief Report a subscribed signal through vehicleSpeedUpdated()
+   * @param unit "km/h", "mph" or "m/s"; empty uses the DBC unit
+   */
+  bool setSpeedSignal(const QString& name, const QString& unit = QString(),
+                      QString* error = nullptr);
+
+  // Decode frames from this device's framesReceived batches
+  void attach(CANDevice* device);
+
+  /**
+   * @brief Latest decoded physical value of a subscribed signal
+   * @param valid Set to whether the signal has been seen yet
+   */
+  double value(const QString& name, bool* valid = nullptr) const;
+
+  quint64 framesDecoded() const;
+  quint64 valuesPublished() const;
+
+  const DbcDatabase& database() const;
+
+ public slots:
+  void processFrames(const CANFrame* frames, int count);
+
+ signals:
+  /**
+   * @brief Emitted with every publication (rate limited like the EventBus)
+   */
+  void signalChanged(const QString& name, double value);
+
+  void vehicleSpeedUpdated(float speedMph);
+
+  /**
+   * @brief Emitted for each frame batch carrying the speed signal, changed
+   *        or not and without rate limiting, with the frame's timestamp
+   */
+  void speedSampled(double metresPerSecond, qint64 timestampNs);
+
+ private:
+  struct SlotState {
+    QString name;
+    QString topic;
+    qint64 intervalNs{0};
+    qint64 lastPublishedNs{0};
+    bool published{false};
+    bool pending{false};
+  };
+
+  void onValueChanged(int slot, qint64 nowNs);
+  void publish(int slot);
+  void flushPending();
+  void scheduleFlush(qint64 dueNs);
+
+  DbcDatabase m_database;
+  SignalDecoder m_decoder;
+  QVector<SlotState> m_slotStates;
+  int m_speedSlot;
+  double m_speedToMph;
+  qint64 m_speedSampledNs;
+  QTimer* m_flushTimer;
+  qint64 m_flushDueNs;
+  quint64 m_framesDecoded;
+  quint64 m_valuesPublished;
+};
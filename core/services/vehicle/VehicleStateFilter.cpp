@@ -0,0 +1,435 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "VehicleStateFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegreesToRadians = kPi / 180.0;
+constexpr double kRadiansToDegrees = 180.0 / kPi;
+constexpr double kMetresPerDegreeLatitude = 6378137.0 * kDegreesToRadians;
+constexpr double kReoriginDistance = 5000.0;
+
+// Standstill must last this long before IMU offsets are learned from it
+constexpr qint64 kSettleNs = 500000000LL;
+// Offsets converge as a running mean, then follow a moving average this long
+constexpr int kBiasWindowSamples = 500;
+// Variance of the zero heading rate and acceleration applied at standstill
+constexpr double kStandstillVariance = 1e-4;
+
+// Decaying values are rounded to zero below this, long before they would
+// become denormals, which are many times slower to compute with
+constexpr double kNegligible = 1e-30;
+
+struct Coupling {
+  int row;
+  int col;
+  double value;
+};
+
+// Initial variance of unknown states
+constexpr double kUnknownPosition = 1e8;
+constexpr double kUnknownHeading = kPi * kPi;
+constexpr double kUnknownSpeed = 100.0;
+constexpr double kUnknownHeadingRate = 1.0;
+constexpr double kUnknownAcceleration = 4.0;
+
+double wrapDegrees(double degrees) {
+  double wrapped = std::fmod(degrees, 360.0);
+  return wrapped < 0 ? wrapped + 360.0 : wrapped;
+}
+
+}  // namespace
+
+VehicleStateFilter::VehicleStateFilter() {
+  reset();
+}
+
+void VehicleStateFilter::setTuning(const Tuning& tuning) {
+  m_tuning = tuning;
+}
+
+const VehicleStateFilter::Tuning& VehicleStateFilter::tuning() const {
+  return m_tuning;
+}
+
+void VehicleStateFilter::reset() {
+  m_x = StateVector();
+  resetMotion();
+  m_timeNs = 0;
+  m_started = false;
+  m_hasOrigin = false;
+  m_originLatitude = 0.0;
+  m_originLongitude = 0.0;
+  m_metresPerDegreeLongitude = kMetresPerDegreeLatitude;
+  m_lastGpsNs = 0;
+  m_rejectedFixes = 0;
+  m_stationary = false;
+  m_stationarySinceNs = 0;
+  m_lastWheelSpeedNs = 0;
+  m_gyroBias = 0.0;
+  m_accelBias = 0.0;
+  m_biasSamples = 0;
+  m_stats = Stats();
+}
+
+void VehicleStateFilter::resetMotion() {
+  // The position is kept but no longer trusted until the next fix
+  const double east = m_x(East, 0);
+  const double north = m_x(North, 0);
+  m_x = StateVector();
+  m_x(East, 0) = east;
+  m_x(North, 0) = north;
+  m_p = Covariance();
+  m_p(East, East) = kUnknownPosition;
+  m_p(North, North) = kUnknownPosition;
+  m_p(Heading, Heading) = kUnknownHeading;
+  m_p(Speed, Speed) = kUnknownSpeed;
+  m_p(HeadingRate, HeadingRate) = kUnknownHeadingRate;
+  m_p(Acceleration, Acceleration) = kUnknownAcceleration;
+}
+
+void VehicleStateFilter::predictTo(qint64 timestampNs) {
+  if (!m_started) {
+    m_started = true;
+    m_timeNs = timestampNs;
+    return;
+  }
+  if (timestampNs <= m_timeNs) {
+    return;
+  }
+  if (timestampNs - m_timeNs > m_tuning.maxGapNs) {
+    // Suspended or starved of input: the motion since is unknown
+    resetMotion();
+    ++m_stats.resets;
+    m_timeNs = timestampNs;
+    return;
+  }
+  while (m_timeNs < timestampNs) {
+    const qint64 dtNs = std::min(m_tuning.maxStepNs, timestampNs - m_timeNs);
+    step(static_cast<double>(dtNs) * 1e-9);
+    m_timeNs += dtNs;
+  }
+}
+
+void VehicleStateFilter::step(double dt) {
+  const double speed = m_x(Speed, 0);
+  const double headingRate = m_x(HeadingRate, 0);
+  const double midHeading = m_x(Heading, 0) + 0.5 * headingRate * dt;
+  const double s = std::sin(midHeading);
+  const double c = std::cos(midHeading);
+
+  m_x(East, 0) += speed * s * dt;
+  m_x(North, 0) += speed * c * dt;
+  m_x(Heading, 0) = wrapAngle(m_x(Heading, 0) + headingRate * dt);
+  m_x(Speed, 0) = std::max(0.0, speed + m_x(Acceleration, 0) * dt);
+  // Turning and accelerating do not last: without a gyro or accelerometer
+  // both relax to zero instead of wandering off through a GPS outage
+  const double decay = std::exp(-dt / m_tuning.rateTimeConstant);
+  for (const int index : {HeadingRate, Acceleration}) {
+    const double decayed = m_x(index, 0) * decay;
+    m_x(index, 0) = std::fabs(decayed) < kNegligible ? 0.0 : decayed;
+  }
+
+  // F is the identity plus these few terms, so F P Fᵀ comes down to adding
+  // multiples of rows, then of columns, instead of two full matrix products
+  const Coupling couplings[] = {
+      {East, Heading, speed * c * dt},
+      {East, Speed, s * dt},
+      {East, HeadingRate, 0.5 * speed * c * dt * dt},
+      {North, Heading, -speed * s * dt},
+      {North, Speed, c * dt},
+      {North, HeadingRate, -0.5 * speed * s * dt * dt},
+      {Heading, HeadingRate, dt},
+      {Speed, Acceleration, dt},
+      {HeadingRate, HeadingRate, decay - 1.0},
+      {Acceleration, Acceleration, decay - 1.0},
+  };
+  Covariance fp = m_p;
+  for (const Coupling& term : couplings) {
+    for (int col = 0; col < kStateCount; ++col) {
+      fp(term.row, col) += term.value * m_p(term.col, col);
+    }
+  }
+  m_p = fp;
+  for (const Coupling& term : couplings) {
+    for (int row = 0; row < kStateCount; ++row) {
+      m_p(row, term.row) += term.value * fp(row, term.col);
+    }
+  }
+
+  m_p(East, East) += m_tuning.positionNoise * dt;
+  m_p(North, North) += m_tuning.positionNoise * dt;
+  m_p(Heading, Heading) += m_tuning.headingNoise * dt;
+  m_p(Speed, Speed) += m_tuning.speedNoise * dt;
+  m_p(HeadingRate, HeadingRate) += m_tuning.headingRateNoise * dt;
+  m_p(Acceleration, Acceleration) += m_tuning.accelerationNoise * dt;
+  // Keep rounding from making the covariance asymmetric, and flush
+  // correlations that decayed to nothing
+  for (int row = 0; row < kStateCount; ++row) {
+    for (int col = row + 1; col < kStateCount; ++col) {
+      double mean = 0.5 * (m_p(row, col) + m_p(col, row));
+      if (std::fabs(mean) < kNegligible) {
+        mean = 0.0;
+      }
+      m_p(row, col) = mean;
+      m_p(col, row) = mean;
+    }
+  }
+
+  if (m_hasOrigin && (std::fabs(m_x(East, 0)) > kReoriginDistance ||
+                      std::fabs(m_x(North, 0)) > kReoriginDistance)) {
+    double latitude = 0.0;
+    double longitude = 0.0;
+    toGeodetic(m_x(East, 0), m_x(North, 0), &latitude, &longitude);
+    setOrigin(latitude, longitude);
+    m_x(East, 0) = 0.0;
+    m_x(North, 0) = 0.0;
+  }
+  ++m_stats.predictions;
+}
+
+bool VehicleStateFilter::accept(qint64 timestampNs) {
+  if (m_started && timestampNs < m_timeNs - m_tuning.maxLagNs) {
+    ++m_stats.staleDropped;
+    return false;
+  }
+  predictTo(timestampNs);
+  return true;
+}
+
+bool VehicleStateFilter::update(int index, double measurement, double variance,
+                                double gateSigmas) {
+  double innovation = measurement - m_x(index, 0);
+  if (index == Heading) {
+    innovation = wrapAngle(innovation);
+  }
+  const double s = m_p(index, index) + variance;
+  if (gateSigmas > 0 && innovation * innovation > gateSigmas * gateSigmas * s) {
+    return false;
+  }
+
+  // H is a unit row, so K is a column of P and the update is an outer product
+  double gain[kStateCount];
+  double row[kStateCount];
+  for (int i = 0; i < kStateCount; ++i) {
+    gain[i] = m_p(i, index) / s;
+    row[i] = m_p(index, i);
+  }
+  for (int r = 0; r < kStateCount; ++r) {
+    m_x(r, 0) += gain[r] * innovation;
+    for (int c = 0; c < kStateCount; ++c) {
+      m_p(r, c) -= gain[r] * row[c];
+    }
+  }
+  m_x(Heading, 0) = wrapAngle(m_x(Heading, 0));
+  m_x(Speed, 0) = std::max(0.0, m_x(Speed, 0));
+  return true;
+}
+
+void VehicleStateFilter::resetPosition(double east, double north, double variance) {
+  m_x(East, 0) = east;
+  m_x(North, 0) = north;
+  for (int i = 0; i < kStateCount; ++i) {
+    m_p(East, i) = m_p(i, East) = 0.0;
+    m_p(North, i) = m_p(i, North) = 0.0;
+  }
+  m_p(East, East) = variance;
+  m_p(North, North) = variance;
+}
+
+bool VehicleStateFilter::updateGps(const GpsFix& fix) {
+  if (!fix.valid || !accept(fix.timestampNs)) {
+    return false;
+  }
+
+  const double sigma =
+      std::max(m_tuning.gpsPositionSigmaMin, m_tuning.gpsPositionSigmaPerHdop * fix.hdop);
+  const double variance = sigma * sigma;
+  if (!m_hasOrigin) {
+    setOrigin(fix.latitude, fix.longitude);
+    resetPosition(0.0, 0.0, variance);
+  } else {
+    double east = 0.0;
+    double north = 0.0;
+    toLocal(fix.latitude, fix.longitude, &east, &north);
+    const double de = east - m_x(East, 0);
+    const double dn = north - m_x(North, 0);
+    const double distance = de * de / (m_p(East, East) + variance) +
+                            dn * dn / (m_p(North, North) + variance);
+    if (distance > m_tuning.gateSigmas * m_tuning.gateSigmas) {
+      ++m_stats.gpsRejected;
+      if (++m_rejectedFixes < m_tuning.maxRejectedFixes) {
+        return false;  // multipath or a glitch; the next fixes decide
+      }
+      // Consistently elsewhere: the dead-reckoned position was wrong
+      resetPosition(east, north, variance);
+      ++m_stats.resets;
+    } else {
+      update(East, east, variance);
+      update(North, north, variance);
+    }
+  }
+  m_rejectedFixes = 0;
+
+  update(Speed, fix.speed, m_tuning.gpsSpeedSigma * m_tuning.gpsSpeedSigma);
+  if (fix.speed >= m_tuning.gpsHeadingMinSpeed) {
+    // Course comes from the velocity vector: its error shrinks with speed
+    const double headingSigma = std::atan2(m_tuning.gpsSpeedSigma, fix.speed) + kDegreesToRadians;
+    update(Heading, fix.heading * kDegreesToRadians, headingSigma * headingSigma);
+  }
+  m_lastGpsNs = fix.timestampNs;
+  ++m_stats.gpsUpdates;
+  return true;
+}
+
+bool VehicleStateFilter::updateWheelSpeed(double metresPerSecond, qint64 timestampNs) {
+  if (!accept(timestampNs)) {
+    return false;
+  }
+  const bool stationary = metresPerSecond <= m_tuning.stationarySpeed;
+  if (stationary && !m_stationary) {
+    m_stationarySinceNs = timestampNs;
+  }
+  m_stationary = stationary;
+  m_lastWheelSpeedNs = timestampNs;
+
+  update(Speed, metresPerSecond, m_tuning.wheelSpeedSigma * m_tuning.wheelSpeedSigma);
+  if (stationary) {
+    // A vehicle at rest neither turns nor accelerates
+    update(HeadingRate, 0.0, kStandstillVariance);
+    update(Acceleration, 0.0, kStandstillVariance);
+  }
+  ++m_stats.wheelSpeedUpdates;
+  return true;
+}
+
+bool VehicleStateFilter::updateImu(const ImuSample& sample) {
+  if (!accept(sample.timestampNs)) {
+    return false;
+  }
+  const double yawRate = sample.gyro[2];
+  const double acceleration = sample.accel[0];
+
+  const bool settled = m_stationary && m_timeNs - m_lastWheelSpeedNs < m_tuning.gpsTimeoutNs &&
+                       m_timeNs - m_stationarySinceNs >= kSettleNs;
+  if (settled) {
+    m_biasSamples = std::min(m_biasSamples + 1, kBiasWindowSamples);
+    const double weight = 1.0 / m_biasSamples;
+    m_gyroBias += weight * (yawRate - m_gyroBias);
+    m_accelBias += weight * (acceleration - m_accelBias);
+  }
+
+  // The gyro turns counter-clockwise positive; heading grows clockwise
+  update(HeadingRate, -(yawRate - m_gyroBias), m_tuning.gyroSigma * m_tuning.gyroSigma);
+  update(Acceleration, acceleration - m_accelBias, m_tuning.accelSigma * m_tuning.accelSigma);
+  ++m_stats.imuUpdates;
+  return true;
+}
+
+VehicleState VehicleStateFilter::state() const {
+  VehicleState state{};
+  if (m_hasOrigin) {
+    toGeodetic(m_x(East, 0), m_x(North, 0), &state.latitude, &state.longitude);
+  }
+  state.speed = static_cast<float>(m_x(Speed, 0));
+  state.heading = static_cast<float>(wrapDegrees(m_x(Heading, 0) * kRadiansToDegrees));
+  state.headingRate = static_cast<float>(m_x(HeadingRate, 0) * kRadiansToDegrees);
+  state.acceleration = static_cast<float>(m_x(Acceleration, 0));
+
+  const double positionAccuracy = std::sqrt(0.5 * (m_p(East, East) + m_p(North, North)));
+  state.positionAccuracy = static_cast<float>(positionAccuracy);
+  state.headingAccuracy = static_cast<float>(std::sqrt(m_p(Heading, Heading)) * kRadiansToDegrees);
+  state.speedAccuracy = static_cast<float>(std::sqrt(m_p(Speed, Speed)));
+
+  quint8 flags = 0;
+  if (m_hasOrigin && positionAccuracy < kMaxPositionAccuracy) {
+    flags |= VehicleState::PositionValid;
+  }
+  if (state.headingAccuracy < 10.0f) {
+    flags |= VehicleState::HeadingValid;
+  }
+  if (state.speedAccuracy < 1.0f) {
+    flags |= VehicleState::SpeedValid;
+  }
+  if (m_hasOrigin && m_timeNs - m_lastGpsNs > m_tuning.gpsTimeoutNs) {
+    flags |= VehicleState::DeadReckoning;
+  }
+  if (m_stationary && m_timeNs - m_lastWheelSpeedNs < m_tuning.gpsTimeoutNs) {
+    flags |= VehicleState::Stationary;
+  }
+  state.flags = flags;
+  state.timestampNs = m_timeNs;
+  return state;
+}
+
+qint64 VehicleStateFilter::timeNs() const {
+  return m_timeNs;
+}
+
+bool VehicleStateFilter::hasOrigin() const {
+  return m_hasOrigin;
+}
+
+const VehicleStateFilter::StateVector& VehicleStateFilter::stateVector() const {
+  return m_x;
+}
+
+const VehicleStateFilter::Covariance& VehicleStateFilter::covariance() const {
+  return m_p;
+}
+
+VehicleStateFilter::Stats VehicleStateFilter::stats() const {
+  return m_stats;
+}
+
+double VehicleStateFilter::wrapAngle(double radians) {
+  double wrapped = std::fmod(radians + kPi, 2.0 * kPi);
+  if (wrapped < 0) {
+    wrapped += 2.0 * kPi;
+  }
+  return wrapped - kPi;
+}
+
+void VehicleStateFilter::setOrigin(double latitude, double longitude) {
+  m_originLatitude = latitude;
+  m_originLongitude = longitude;
+  m_metresPerDegreeLongitude =
+      kMetresPerDegreeLatitude * std::max(1e-6, std::cos(latitude * kDegreesToRadians));
+  m_hasOrigin = true;
+}
+
+void VehicleStateFilter::toLocal(double latitude, double longitude, double* east,
+                                 double* north) const {
+  *east = wrapDegrees(longitude - m_originLongitude + 180.0) - 180.0;
+  *east *= m_metresPerDegreeLongitude;
+  *north = (latitude - m_originLatitude) * kMetresPerDegreeLatitude;
+}
+
+void VehicleStateFilter::toGeodetic(double east, double north, double* latitude,
+                                    double* longitude) const {
+  *latitude = m_originLatitude + north / kMetresPerDegreeLatitude;
+  *longitude =
+      wrapDegrees(m_originLongitude + east / m_metresPerDegreeLongitude + 180.0) - 180.0;
+}
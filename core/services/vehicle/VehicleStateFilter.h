@@ -0,0 +1,203 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QMetaType>
+#include <QtGlobal>
+#include <type_traits>
+
+#include "../../hal/functional/ImuSample.h"
+#include "FixedMatrix.h"
+
+/**
+ * @brief Fused vehicle state at one instant
+ *
+ * Plain data, small enough to copy into every consumer. Angles follow the
+ * GPS convention: heading is degrees clockwise from true north.
+ */
+struct VehicleState {
+  enum Flag : quint8 {
+    PositionValid = 0x01,  // a GPS fix has been seen and the position is still usable
+    HeadingValid = 0x02,
+    SpeedValid = 0x04,
+    DeadReckoning = 0x08,  // no GPS fix recently; position is extrapolated
+    Stationary = 0x10,     // wheel speed reports standstill
+  };
+
+  double latitude;         // Degrees
+  double longitude;        // Degrees
+  float speed;             // m/s along the heading
+  float heading;           // Degrees clockwise from true north, 0-360
+  float headingRate;       // deg/s, positive turning right
+  float acceleration;      // Longitudinal, m/s²
+  float positionAccuracy;  // Metres, one sigma
+  float headingAccuracy;   // Degrees, one sigma
+  float speedAccuracy;     // m/s, one sigma
+  quint8 flags;
+  qint64 timestampNs;  // CLOCK_MONOTONIC
+};
+
+static_assert(std::is_trivially_copyable<VehicleState>::value, "VehicleState must stay plain data");
+
+Q_DECLARE_METATYPE(VehicleState)
+
+/**
+ * @brief Extended Kalman filter for planar vehicle motion
+ *
+ * The state is position (east/north metres from a local origin), heading,
+ * speed, heading rate and longitudinal acceleration. Heading rate and
+ * acceleration relax towards zero between measurements. GPS position, speed
+ * and course, wheel speed, and IMU yaw rate and longitudinal acceleration
+ * each observe one state directly, so every measurement is a scalar update
+ * and no matrix is ever inverted. Covariance and transition matrices are
+ * FixedMatrix members: nothing allocates after construction.
+ *
+ * Every input carries a CLOCK_MONOTONIC timestamp. The filter is advanced to
+ * a measurement's time before it is applied; a measurement up to maxLagNs
+ * older than the filter is applied as if current, anything older is dropped.
+ * Without GPS, wheel speed and the gyro keep the position moving (dead
+ * reckoning) while its uncertainty grows. At standstill the IMU's gyro and
+ * accelerometer offsets are learned and removed from later samples.
+ *
+ * The local origin is the first fix; it follows the vehicle once it is more
+ * than 5 km away, which keeps the flat-earth projection accurate.
+ */
+class VehicleStateFilter {
+ public:
+  enum StateIndex { East, North, Heading, Speed, HeadingRate, Acceleration, kStateCount };
+
+  using StateVector = FixedMatrix<kStateCount, 1>;
+  using Covariance = FixedMatrix<kStateCount, kStateCount>;
+
+  struct GpsFix {
+    double latitude;   // Degrees
+    double longitude;  // Degrees
+    double speed;      // m/s
+    double heading;    // Degrees clockwise from true north
+    double hdop;
+    bool valid;  // false for "no fix" epochs
+    qint64 timestampNs;
+  };
+
+  struct Tuning {
+    // Process noise spectral densities (variance per second)
+    double positionNoise{0.05};
+    double headingNoise{1e-4};
+    double speedNoise{0.05};
+    double headingRateNoise{0.01};  // (rad/s²)²
+    double accelerationNoise{1.0};  // (m/s³)²
+    double rateTimeConstant{2.0};   // seconds for heading rate and acceleration to relax
+
+    // Measurement noise, one sigma
+    double gpsPositionSigmaPerHdop{3.0};  // metres per unit of HDOP...
+    double gpsPositionSigmaMin{2.0};      // ...but no better than this
+    double gpsSpeedSigma{0.3};
+    double gpsHeadingMinSpeed{1.5};  // course below this speed is noise
+    double wheelSpeedSigma{0.15};
+    double gyroSigma{0.02};
+    double accelSigma{0.5};
+
+    double gateSigmas{5.0};        // GPS position innovations beyond this are outliers...
+    int maxRejectedFixes{5};       // ...until this many in a row move the position to GPS
+    double stationarySpeed{0.05};  // wheel speed at or below this is standstill
+
+    qint64 maxLagNs{250000000LL};       // older measurements are dropped
+    qint64 maxGapNs{5000000000LL};      // a longer gap resets the motion states
+    qint64 maxStepNs{20000000LL};       // prediction substep
+    qint64 gpsTimeoutNs{2000000000LL};  // then the state is dead reckoning
+  };
+
+  struct Stats {
+    quint64 predictions{0};  // substeps propagated
+    quint64 gpsUpdates{0};
+    quint64 wheelSpeedUpdates{0};
+    quint64 imuUpdates{0};
+    quint64 staleDropped{0};  // older than maxLagNs
+    quint64 gpsRejected{0};   // failed the innovation gate
+    quint64 resets{0};
+  };
+
+  VehicleStateFilter();
+
+  void setTuning(const Tuning& tuning);
+  const Tuning& tuning() const;
+
+  // Forget everything, including the origin
+  void reset();
+
+  /**
+   * @brief Propagate the state to a later time
+   *
+   * The first call only sets the clock. Earlier times are ignored.
+   */
+  void predictTo(qint64 timestampNs);
+
+  // Each applies one measurement; false if it was dropped or rejected
+  bool updateGps(const GpsFix& fix);
+  bool updateWheelSpeed(double metresPerSecond, qint64 timestampNs);
+  bool updateImu(const ImuSample& sample);
+
+  VehicleState state() const;
+
+  qint64 timeNs() const;
+  bool hasOrigin() const;
+  const StateVector& stateVector() const;
+  const Covariance& covariance() const;
+  Stats stats() const;
+
+  // Smallest equivalent angle in [-pi, pi)
+  static double wrapAngle(double radians);
+
+  // Beyond this one-sigma position error the position is no longer reported valid
+  static constexpr double kMaxPositionAccuracy = 100.0;
+
+ private:
+  bool accept(qint64 timestampNs);
+  void step(double dt);
+  bool update(int index, double measurement, double variance, double gateSigmas = 0.0);
+  void resetPosition(double east, double north, double variance);
+  void resetMotion();
+  void setOrigin(double latitude, double longitude);
+  void toLocal(double latitude, double longitude, double* east, double* north) const;
+  void toGeodetic(double east, double north, double* latitude, double* longitude) const;
+
+  Tuning m_tuning;
+  StateVector m_x;
+  Covariance m_p;
+  qint64 m_timeNs;
+  bool m_started;
+
+  bool m_hasOrigin;
+  double m_originLatitude;
+  double m_originLongitude;
+  double m_metresPerDegreeLongitude;
+  qint64 m_lastGpsNs;
+  int m_rejectedFixes;
+
+  bool m_stationary;
+  qint64 m_stationarySinceNs;
+  qint64 m_lastWheelSpeedNs;
+  double m_gyroBias;   // rad/s about z, counter-clockwise
+  double m_accelBias;  // m/s² along x
+  int m_biasSamples;
+
+  Stats m_stats;
+};
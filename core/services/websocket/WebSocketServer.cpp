@@ -27,15 +27,29 @@
 #include <QSslKey>
 
 #include "../android_auto/AndroidAutoService.h"
+#include "../diagnostics/FlightRecorder.h"
+#include "../diagnostics/SamplingProfiler.h"
+#include "../diagnostics/StartupTracer.h"
 #include "../eventbus/EventBus.h"
 #include "../logging/Logger.h"
 #include "../service_manager/ServiceManager.h"
+#include "../state/StateSnapshotService.h"
+
+namespace {
+
+// Bounds the work a single subscribe_many message can trigger
+constexpr int kMaxTopicsPerSubscribe = 64;
+
+}  // namespace
 
 WebSocketServer::WebSocketServer(quint16 port, QObject* parent)
     : QObject(parent),
       m_server(new QWebSocketServer("CrankshaftCore", QWebSocketServer::NonSecureMode, this)),
       m_serviceManager(nullptr),
+      m_stateSnapshot(nullptr),
+      m_profiler(nullptr),
       m_secureModeEnabled(false) {
+  StartupPhase phase("WebSocketServer::listen");
   Logger::instance().info(QString("Initializing WebSocket server on port %1...").arg(port));
 
   if (m_server->listen(QHostAddress::Any, port)) {
@@ -58,10 +72,51 @@ bool WebSocketServer::isListening() const {
 }
 
 void WebSocketServer::setServiceManager(ServiceManager* serviceManager) {
+  if (m_serviceManager) {
+    disconnect(m_serviceManager, nullptr, this, nullptr);
+  }
   m_serviceManager = serviceManager;
+  if (m_serviceManager) {
+    connect(m_serviceManager, &ServiceManager::serviceReady, this,
+            &WebSocketServer::onServiceReady);
+    connect(m_serviceManager, &ServiceManager::allServicesStarted, this,
+            &WebSocketServer::onAllServicesStarted);
+  }
   Logger::instance().info("[WebSocketServer] ServiceManager registered");
 }
 
+void WebSocketServer::setStateSnapshot(StateSnapshotService* snapshot) {
+  m_stateSnapshot = snapshot;
+}
+
+void WebSocketServer::setProfiler(crankshaft::diagnostics::SamplingProfiler* profiler) {
+  m_profiler = profiler;
+}
+
+void WebSocketServer::onServiceReady(const QString& serviceName, bool success, qint64 elapsedMs) {
+  QVariantMap payload;
+  payload["service"] = serviceName;
+  payload["success"] = success;
+  payload["elapsedMs"] = elapsedMs;
+  broadcastEvent("system/services/ready", payload);
+
+  // Services come up independently, so wire each one as soon as it is ready
+  if (success && serviceName == "AndroidAuto") {
+    setupAndroidAutoConnections();
+  }
+}
+
+void WebSocketServer::onAllServicesStarted(int succeeded, int failed, qint64 elapsedMs) {
+  QVariantMap payload;
+  payload["succeeded"] = succeeded;
+  payload["failed"] = failed;
+  payload["elapsedMs"] = elapsedMs;
+  if (m_serviceManager) {
+    payload["running"] = m_serviceManager->getRunningServices();
+  }
+  broadcastEvent("system/services/all-ready", payload);
+}
+
 void WebSocketServer::initializeServiceConnections() {
   if (!m_serviceManager) {
     Logger::instance().debug("[WebSocketServer] ServiceManager not available");
@@ -85,6 +140,20 @@ void WebSocketServer::onNewConnection() {
 
   m_clients.append(client);
   m_subscriptions[client] = QStringList();
+
+  // Hand the client everything it needs to render before any subscription
+  sendSnapshot(client);
+}
+
+void WebSocketServer::sendSnapshot(QWebSocket* client) const {
+  if (!m_stateSnapshot || !client) {
+    return;
+  }
+
+  const QJsonObject message = m_stateSnapshot->toMessage();
+  client->sendTextMessage(QJsonDocument(message).toJson(QJsonDocument::Compact));
+  Logger::instance().info(QString("[WebSocketServer] Sent state snapshot (%1 topic(s))")
+                              .arg(message.value("events").toArray().size()));
 }
 
 void WebSocketServer::onTextMessageReceived(const QString& message) {
@@ -113,6 +182,12 @@ void WebSocketServer::onTextMessageReceived(const QString& message) {
   if (type == "subscribe") {
     QString topic = obj.value("topic").toString();
     handleSubscribe(client, topic);
+  } else if (type == "subscribe_many") {
+    QStringList topics;
+    for (const auto& value : obj.value("topics").toArray()) {
+      topics.append(value.toString());
+    }
+    handleSubscribeMany(client, topics);
   } else if (type == "unsubscribe") {
     QString topic = obj.value("topic").toString();
     handleUnsubscribe(client, topic);
@@ -155,6 +230,11 @@ void WebSocketServer::handleSubscribe(QWebSocket* client, const QString& topic)
       Logger::instance().debug(QString("[WebSocketServer]   - %1").arg(sub));
     }
 
+    // First subscription to a lazily activated service's namespace starts it
+    if (m_serviceManager) {
+      m_serviceManager->activateForTopic(topic);
+    }
+
     // Send current Android Auto state when subscribing to android-auto topics
     if (topic.startsWith("android-auto") && m_serviceManager) {
       AndroidAutoService* aaService = m_serviceManager->getAndroidAutoService();
@@ -183,12 +263,26 @@ void WebSocketServer::handleSubscribe(QWebSocket* client, const QString& topic)
   }
 }
 
+void WebSocketServer::handleSubscribeMany(QWebSocket* client, const QStringList& topics) {
+  Logger::instance().info(
+      QString("[WebSocketServer] Client subscribing to %1 topic(s)").arg(topics.size()));
+  for (const auto& topic : topics) {
+    handleSubscribe(client, topic);
+  }
+}
+
 void WebSocketServer::handlePublish(const QString& topic, const QVariantMap& payload) {
   EventBus::instance().publish(topic, payload);
 }
 
 void WebSocketServer::handleServiceCommand(QWebSocket* client, const QString& command,
                                            const QVariantMap& params) {
+  // Diagnostics commands work without the ServiceManager
+  if (command.startsWith("profile_") || command == "dump_flight_recorder") {
+    handleDiagnosticsCommand(client, command, params);
+    return;
+  }
+
   if (!m_serviceManager) {
     Logger::instance().warning("[WebSocketServer] ServiceManager not available for command: " +
                                command);
@@ -247,6 +341,7 @@ void WebSocketServer::handleServiceCommand(QWebSocket* client, const QString& co
   } else if (command == "get_running_services") {
     QStringList services = m_serviceManager->getRunningServices();
     response["services"] = QJsonArray::fromStringList(services);
+    response["pending"] = QJsonArray::fromStringList(m_serviceManager->getPendingServices());
     success = true;
     Logger::instance().info(
         QString("[WebSocketServer] Running services query: %1").arg(services.join(", ")));
@@ -264,7 +359,71 @@ void WebSocketServer::handleServiceCommand(QWebSocket* client, const QString& co
   client->sendTextMessage(QJsonDocument(response).toJson(QJsonDocument::Compact));
 }
 
+void WebSocketServer::handleDiagnosticsCommand(QWebSocket* client, const QString& command,
+                                               const QVariantMap& params) {
+  using crankshaft::diagnostics::FlightRecorder;
+  using crankshaft::diagnostics::SamplingProfiler;
+
+  QJsonObject response;
+  response["type"] = "service_response";
+  response["command"] = command;
+  bool success = false;
+  QString error;
+
+  if (command == "dump_flight_recorder") {
+    // Always a generated name in dumpDirectory(); clients must not pick files on this host
+    FlightRecorder& recorder = FlightRecorder::instance();
+    const QString path =
+        recorder.dump(QString(), crankshaft::diagnostics::flight::DumpReason::Manual, &error);
+    success = !path.isEmpty();
+    if (success) {
+      QJsonObject dump;
+      dump["path"] = path;
+      dump["records"] =
+          static_cast<qint64>(qMin(recorder.recordCount(), FlightRecorder::kCapacity));
+      response["flight_recorder"] = dump;
+    }
+  } else if (!m_profiler) {
+    error = "Profiler not available";
+  } else if (command == "profile_start") {
+    SamplingProfiler::Options options;
+    options.frequencyHz = params.value("frequency_hz", options.frequencyHz).toInt();
+    options.maxDurationMs =
+        params.value("duration_s", options.maxDurationMs / 1000).toInt() * 1000;
+    options.clock = params.value("clock").toString() == "wall" ? SamplingProfiler::Clock::Wall
+                                                              : SamplingProfiler::Clock::Cpu;
+    // outputPath stays empty: clients must not pick files on this host
+    success = m_profiler->start(options, &error);
+    if (success) {
+      response["profile"] = m_profiler->status().toJson();
+    }
+  } else if (command == "profile_stop") {
+    const SamplingProfiler::Result result = m_profiler->stop();
+    response["profile"] = result.toJson();
+    success = result.valid;
+    error = result.error;
+  } else {
+    error = "Unknown command: " + command;
+  }
+
+  Logger::instance().info(QString("[WebSocketServer] Diagnostics command '%1': %2")
+                              .arg(command)
+                              .arg(success ? "success" : error));
+
+  response["success"] = success;
+  if (!error.isEmpty()) {
+    response["error"] = error;
+  }
+  response["timestamp"] = QDateTime::currentSecsSinceEpoch();
+
+  client->sendTextMessage(QJsonDocument(response).toJson(QJsonDocument::Compact));
+}
+
 void WebSocketServer::broadcastEvent(const QString& topic, const QVariantMap& payload) {
+  if (m_stateSnapshot) {
+    m_stateSnapshot->record(topic, payload);
+  }
+
   Logger::instance().info(
       QString("[WebSocketServer] broadcastEvent called - Topic: %1").arg(topic));
   Logger::instance().info(
@@ -283,6 +442,8 @@ void WebSocketServer::broadcastEvent(const QString& topic, const QVariantMap& pa
   Logger::instance().info(
       QString("[WebSocketServer] Number of connected clients: %1").arg(m_clients.size()));
 
+  quint16 sentTo = 0;
+  qint64 queuedBytes = 0;
   for (auto* client : std::as_const(m_clients)) {
     bool shouldSend = false;
     Logger::instance().debug(QString("[WebSocketServer] Checking subscriptions for client %1")
@@ -304,10 +465,18 @@ void WebSocketServer::broadcastEvent(const QString& topic, const QVariantMap& pa
       Logger::instance().info(
           QString("[WebSocketServer] Sending event to client (matched subscription)"));
       client->sendTextMessage(message);
+      ++sentTo;
+      queuedBytes += client->bytesToWrite();
     } else {
       Logger::instance().debug(QString("[WebSocketServer] Client has no matching subscription"));
     }
   }
+
+  if (sentTo > 0) {
+    crankshaft::diagnostics::FlightRecorder::instance().record(
+        crankshaft::diagnostics::flight::Event::WsQueue, sentTo,
+        static_cast<uint32_t>(message.size()), static_cast<uint64_t>(queuedBytes));
+  }
 }
 
 bool WebSocketServer::topicMatches(const QString& topic, const QString& pattern) const {
@@ -351,6 +520,12 @@ void WebSocketServer::setupAndroidAutoConnections() {
     return;
   }
 
+  if (m_connectedAndroidAutoService == aaService) {
+    Logger::instance().debug("[WebSocketServer] Android Auto signals already connected");
+    return;
+  }
+  m_connectedAndroidAutoService = aaService;
+
   Logger::instance().info(
       "[WebSocketServer] Setting up Android Auto service signal connections...");
 
@@ -417,8 +592,8 @@ void WebSocketServer::onAndroidAutoError(const QString& error) {
 
 bool WebSocketServer::validateMessage(const QJsonObject& obj, QString& error) const {
   static const QSet<QString> allowedTypes = {
-      QStringLiteral("subscribe"), QStringLiteral("unsubscribe"), QStringLiteral("publish"),
-      QStringLiteral("service_command")};
+      QStringLiteral("subscribe"), QStringLiteral("subscribe_many"), QStringLiteral("unsubscribe"),
+      QStringLiteral("publish"), QStringLiteral("service_command")};
 
   const QString type = obj.value("type").toString();
   if (type.isEmpty() || !allowedTypes.contains(type)) {
@@ -434,6 +609,24 @@ bool WebSocketServer::validateMessage(const QJsonObject& obj, QString& error) co
     }
   }
 
+  if (type == "subscribe_many") {
+    const QJsonArray topics = obj.value("topics").toArray();
+    if (!obj.value("topics").isArray() || topics.isEmpty()) {
+      error = QStringLiteral("missing_topics");
+      return false;
+    }
+    if (topics.size() > kMaxTopicsPerSubscribe) {
+      error = QStringLiteral("too_many_topics");
+      return false;
+    }
+    for (const auto& topic : topics) {
+      if (!topic.isString() || topic.toString().isEmpty()) {
+        error = QStringLiteral("invalid_topics");
+        return false;
+      }
+    }
+  }
+
   if (type == "publish") {
     if (!obj.contains("payload") || !obj.value("payload").isObject()) {
       error = QStringLiteral("invalid_payload");
@@ -459,7 +652,8 @@ bool WebSocketServer::validateServiceCommand(const QString& command, QString& er
   static const QSet<QString> allowedCommands = {
       QStringLiteral("reload_services"), QStringLiteral("start_service"),
       QStringLiteral("stop_service"), QStringLiteral("restart_service"),
-      QStringLiteral("get_running_services")};
+      QStringLiteral("get_running_services"), QStringLiteral("profile_start"),
+      QStringLiteral("profile_stop"), QStringLiteral("dump_flight_recorder")};
 
   if (!allowedCommands.contains(command)) {
     error = QStringLiteral("unauthorised_command");
@@ -21,12 +21,19 @@
 
 #include <QList>
 #include <QObject>
+#include <QPointer>
 #include <QSslConfiguration>
 #include <QWebSocket>
 #include <QWebSocketServer>
 
 // Forward declarations
 class ServiceManager;
+class StateSnapshotService;
+namespace crankshaft {
+namespace diagnostics {
+class SamplingProfiler;
+}
+}  // namespace crankshaft
 
 #include "../android_auto/AndroidAutoService.h"
 
@@ -48,6 +55,12 @@ class WebSocketServer : public QObject {
   void setServiceManager(ServiceManager* serviceManager);
   void initializeServiceConnections();  // Call after services are started
 
+  // Retained state sent to clients as one "snapshot" message on connect
+  void setStateSnapshot(StateSnapshotService* snapshot);
+
+  // On-demand profiling through the profile_start / profile_stop commands
+  void setProfiler(crankshaft::diagnostics::SamplingProfiler* profiler);
+
  private slots:
   void onNewConnection();
   void onTextMessageReceived(const QString& message);
@@ -59,6 +72,10 @@ class WebSocketServer : public QObject {
   void onAndroidAutoDisconnected();
   void onAndroidAutoError(const QString& error);
 
+  // Service lifecycle events
+  void onServiceReady(const QString& serviceName, bool success, qint64 elapsedMs);
+  void onAllServicesStarted(int succeeded, int failed, qint64 elapsedMs);
+
  private:
   // Message validation helpers
   [[nodiscard]] bool validateMessage(const QJsonObject& obj, QString& error) const;
@@ -66,9 +83,13 @@ class WebSocketServer : public QObject {
   void sendError(QWebSocket* client, const QString& message) const;
 
   void handleSubscribe(QWebSocket* client, const QString& topic);
+  void handleSubscribeMany(QWebSocket* client, const QStringList& topics);
+  void sendSnapshot(QWebSocket* client) const;
   void handleUnsubscribe(QWebSocket* client, const QString& topic);
   void handlePublish(const QString& topic, const QVariantMap& payload);
   void handleServiceCommand(QWebSocket* client, const QString& command, const QVariantMap& params);
+  void handleDiagnosticsCommand(QWebSocket* client, const QString& command,
+                                const QVariantMap& params);
   [[nodiscard]] bool topicMatches(const QString& topic, const QString& pattern) const;
   void setupAndroidAutoConnections();
 
@@ -76,6 +97,9 @@ class WebSocketServer : public QObject {
   QList<QWebSocket*> m_clients;
   QMap<QWebSocket*, QStringList> m_subscriptions;
   ServiceManager* m_serviceManager;
+  QPointer<AndroidAutoService> m_connectedAndroidAutoService;
+  StateSnapshotService* m_stateSnapshot;
+  crankshaft::diagnostics::SamplingProfiler* m_profiler;
   bool m_secureModeEnabled;
   QString m_certificatePath;
   QString m_keyPath;
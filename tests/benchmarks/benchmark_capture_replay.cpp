@@ -0,0 +1,247 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Capture replay benchmark
+//
+// Replays a capture's first byte stream into a GPSDevice and its first CAN
+// stream into a CANDevice, each through its own ReplayTransport, and reports
+// records, megabytes and CPU per second of wall time. Without --capture, a
+// capture of --epochs NMEA epochs and --can-frames CAN frames is written
+// first, which also times CaptureWriter. --speed 0 (the default) replays as
+// fast as the devices take it; 1 replays at the recorded pace.
+
+#include <time.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <memory>
+
+#include "hal/functional/CANDevice.h"
+#include "hal/functional/GPSDevice.h"
+#include "hal/transport/ReplayTransport.h"
+#include "services/diagnostics/CaptureReader.h"
+#include "services/diagnostics/CaptureWriter.h"
+
+using crankshaft::diagnostics::CaptureReader;
+using crankshaft::diagnostics::CaptureWriter;
+namespace capture = crankshaft::diagnostics::capture;
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+qint64 cpuNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+QByteArray gpsCycle(int epoch) {
+  const QByteArray time =
+      QString("12%1%2.%3")
+          .arg(epoch / 600 % 60, 2, 10, QChar('0'))
+          .arg(epoch / 10 % 60, 2, 10, QChar('0'))
+          .arg(epoch % 10 * 10, 2, 10, QChar('0'))
+          .toLatin1();
+  return sentence("GNRMC," + time + ",A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A") +
+         sentence("GNVTG,084.4,T,,M,022.4,N,041.5,K,A") +
+         sentence("GNGGA," + time + ",4807.038,N,01131.000,E,1,12,0.9,545.4,M,46.9,M,,") +
+         sentence("GNGSA,A,3,01,02,03,,,,,,,,,,1.5,0.9,1.2") +
+         sentence("GPGSV,1,1,03,01,40,083,46,02,17,308,41,03,07,344,39");
+}
+
+/**
+ * Write a synthetic capture: NMEA in 64-byte reads, as a UART at 115200 baud
+ * delivers it, and CAN frames in batches of 32, as recvmmsg() does.
+ */
+bool synthesise(const QString& path, int epochs, int canFrames) {
+  CaptureWriter writer;
+  QString error;
+  if (!writer.open(path, capture::kDefaultChunkBytes, &error)) {
+    err << error << Qt::endl;
+    return false;
+  }
+  const int gps = writer.addStream(capture::StreamKind::Bytes, "gps", {115200, 0, 0, 0});
+  const int can = writer.addStream(capture::StreamKind::CanFrames, "can0");
+
+  QElapsedTimer clock;
+  clock.start();
+  const qint64 cpuStart = cpuNs();
+  QByteArray nmea;
+  for (int epoch = 0; epoch < epochs; ++epoch) {
+    nmea += gpsCycle(epoch);
+  }
+  for (qsizetype offset = 0; offset < nmea.size(); offset += 64) {
+    const QByteArray read = nmea.mid(offset, 64);
+    writer.append(gps, {read.constData(), static_cast<size_t>(read.size())});
+  }
+  capture::CanFrameRecord batch[32] = {};
+  for (int sent = 0; sent < canFrames;) {
+    int count = 0;
+    for (; count < 32 && sent < canFrames; ++count, ++sent) {
+      batch[count].id = 0x100 + sent % 0x400;
+      batch[count].length = 8;
+      batch[count].data[0] = static_cast<uint8_t>(sent);
+    }
+    writer.append(can, {reinterpret_cast<const char*>(batch), count * sizeof(batch[0])});
+  }
+  writer.close();
+
+  const double seconds = clock.nsecsElapsed() / 1e9;
+  const CaptureWriter::Stats stats = writer.stats();
+  out << QString("Wrote %1 records, %2 MB in %3 chunks: %4 MB/s, %5 ms CPU, %6 dropped")
+             .arg(stats.records)
+             .arg(stats.bytes / 1e6, 0, 'f', 1)
+             .arg(stats.chunks)
+             .arg(stats.bytes / 1e6 / seconds, 0, 'f', 0)
+             .arg((cpuNs() - cpuStart) / 1e6, 0, 'f', 0)
+             .arg(stats.droppedRecords)
+      << Qt::endl;
+  return true;
+}
+
+QString firstStream(const CaptureReader& reader, capture::StreamKind kind) {
+  for (const capture::StreamInfo& info : reader.streams()) {
+    if (info.kind == static_cast<uint16_t>(kind)) {
+      return QString::fromUtf8(info.name);
+    }
+  }
+  return QString();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_capture_replay");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Capture replay throughput benchmark");
+  parser.addHelpOption();
+  QCommandLineOption captureOption("capture", "Capture to replay (default: synthesise one)",
+                                   "path");
+  QCommandLineOption epochsOption("epochs", "NMEA epochs to synthesise", "n", "50000");
+  QCommandLineOption framesOption("can-frames", "CAN frames to synthesise", "n", "1000000");
+  QCommandLineOption speedOption("speed", "Replay speed, 0 for as fast as possible", "x", "0");
+  parser.addOptions({captureOption, epochsOption, framesOption, speedOption});
+  parser.process(app);
+
+  QTemporaryDir dir;
+  QString path = parser.value(captureOption);
+  if (path.isEmpty()) {
+    path = dir.filePath("synthetic.cap");
+    if (!synthesise(path, qMax(1, parser.value(epochsOption).toInt()),
+                    qMax(0, parser.value(framesOption).toInt()))) {
+      return 2;
+    }
+  }
+
+  CaptureReader reader;
+  QString error;
+  if (!reader.open(path, &error)) {
+    err << error << Qt::endl;
+    return 2;
+  }
+  const QString gpsStream = firstStream(reader, capture::StreamKind::Bytes);
+  const QString canStream = firstStream(reader, capture::StreamKind::CanFrames);
+  reader.close();
+
+  std::unique_ptr<ReplayTransport> gpsReplay;
+  std::unique_ptr<ReplayTransport> canReplay;
+  std::unique_ptr<GPSDevice> gps;
+  std::unique_ptr<CANDevice> can;
+  quint64 fixes = 0;
+  quint64 frames = 0;
+  int running = 0;
+  QEventLoop loop;
+  auto replay = [&](const QString& stream) {
+    auto transport = std::make_unique<ReplayTransport>(path, stream);
+    transport->configure("speed", parser.value(speedOption).toDouble());
+    QObject::connect(transport.get(), &ReplayTransport::replayFinished, &loop, [&]() {
+      if (--running == 0) loop.quit();
+    });
+    ++running;
+    return transport;
+  };
+  if (!gpsStream.isEmpty()) {
+    gpsReplay = replay(gpsStream);
+    gps = std::make_unique<GPSDevice>(gpsReplay.get());
+    gps->setConfig("protocol", "nmea");
+    QObject::connect(gps.get(), &GPSDevice::locationUpdated, &loop, [&]() { ++fixes; });
+  }
+  if (!canStream.isEmpty()) {
+    canReplay = replay(canStream);
+    can = std::make_unique<CANDevice>(canReplay.get());
+    QObject::connect(can.get(), &CANDevice::framesReceived, &loop,
+                     [&](const CANFrame*, int count) { frames += count; });
+  }
+  if (running == 0) {
+    err << path << " has no byte or CAN streams" << Qt::endl;
+    return 2;
+  }
+
+  QElapsedTimer clock;
+  clock.start();
+  const qint64 cpuStart = cpuNs();
+  if ((gps && !gps->initialize()) || (can && !can->initialize())) {
+    err << "Cannot open " << path << Qt::endl;
+    return 2;
+  }
+  loop.exec();
+  const double seconds = qMax(1e-9, clock.nsecsElapsed() / 1e9);
+  const double cpuPct = 100.0 * (cpuNs() - cpuStart) / (seconds * 1e9);
+
+  out << QString("%1 %2 %3 %4 %5 %6")
+             .arg("stream", -24)
+             .arg("records/s", 11)
+             .arg("MB/s", 8)
+             .arg("decoded", 10)
+             .arg("decoded/s", 11)
+             .arg("seconds", 8)
+      << Qt::endl;
+  auto row = [&](const QString& name, const ReplayTransport& transport, quint64 decoded) {
+    const ReplayTransport::Stats stats = transport.stats();
+    out << QString("%1 %2 %3 %4 %5 %6")
+               .arg(name.left(24), -24)
+               .arg(stats.records / seconds, 11, 'f', 0)
+               .arg(stats.bytesDelivered / 1e6 / seconds, 8, 'f', 1)
+               .arg(decoded, 10)
+               .arg(decoded / seconds, 11, 'f', 0)
+               .arg(seconds, 8, 'f', 2)
+        << Qt::endl;
+  };
+  if (gpsReplay) row(gpsStream + " (fixes)", *gpsReplay, fixes);
+  if (canReplay) row(canStream + " (frames)", *canReplay, frames);
+  out << QString("Process CPU: %1 %").arg(cpuPct, 0, 'f', 1) << Qt::endl;
+  return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// DBC signal decoding benchmark
+//
+// Generates a DBC with --messages messages of eight signals each (Intel and
+// Motorola, signed and unsigned), subscribes to --subscribed of them and
+// replays a capture in which every message ID occurs, pinned to one core.
+// Reports frames per second and ns per frame for the bare SignalDecoder and
+// for VehicleSignalService, which adds change detection, rate limiting and
+// EventBus publishing. With --min-fps, exits non-zero when the service path
+// is slower than that.
+
+#include <sched.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <cstring>
+
+#include "services/vehicle/SignalDecoder.h"
+#include "services/vehicle/VehicleSignalService.h"
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+QByteArray makeDbc(int messages) {
+  QByteArray dbc = "VERSION \"\"\n\nBU_: ECU\n\n";
+  for (int m = 0; m < messages; ++m) {
+    dbc += QString("BO_ %1 Message%2: 8 ECU\n").arg(0x100 + m).arg(m).toLatin1();
+    for (int s = 0; s < 8; ++s) {
+      // Alternate byte order and sign; eight 8-bit signals fill the payload
+      const bool motorola = s % 2 == 1;
+      const int startBit = motorola ? s * 8 + 7 : s * 8;
+      dbc += QString(" SG_ Signal%1_%2 : %3|8@%4%5 (0.5,-10) [0|0] \"\" ECU\n")
+                 .arg(m)
+                 .arg(s)
+                 .arg(startBit)
+                 .arg(motorola ? 0 : 1)
+                 .arg(s % 3 == 0 ? '-' : '+')
+                 .toLatin1();
+    }
+    dbc += "\n";
+  }
+  return dbc;
+}
+
+QVector<CANFrame> makeCapture(int messages, int frames) {
+  QVector<CANFrame> capture(frames);
+  QRandomGenerator random(42);
+  for (int i = 0; i < frames; ++i) {
+    CANFrame& frame = capture[i];
+    memset(&frame, 0, sizeof(frame));
+    frame.id = 0x100 + static_cast<quint32>(i % messages);
+    frame.length = 8;
+    // Mostly steady values with occasional changes, like a real bus
+    for (int b = 0; b < 8; ++b) {
+      frame.data[b] = static_cast<quint8>(random.bounded(8) == 0 ? random.bounded(256) : b);
+    }
+    frame.timestampNs = i;
+  }
+  return capture;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_dbc_decode");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("DBC signal decoding throughput benchmark");
+  parser.addHelpOption();
+  QCommandLineOption messagesOption("messages", "Messages in the DBC", "n", "64");
+  QCommandLineOption subscribedOption("subscribed", "Signals subscribed to", "n", "48");
+  QCommandLineOption framesOption("frames", "Frames per pass", "n", "200000");
+  QCommandLineOption cpuOption("cpu", "Core to pin to", "n", "0");
+  QCommandLineOption minFpsOption("min-fps", "Fail if the service path decodes fewer frames/s",
+                                  "n");
+  parser.addOptions({messagesOption, subscribedOption, framesOption, cpuOption, minFpsOption});
+  parser.process(app);
+
+  const int messages = qBound(1, parser.value(messagesOption).toInt(), 2048);
+  const int subscribed = qBound(1, parser.value(subscribedOption).toInt(), messages * 8);
+  const int frames = qMax(1, parser.value(framesOption).toInt());
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(parser.value(cpuOption).toInt(), &cpus);
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+    err << "Could not pin to CPU " << parser.value(cpuOption) << "; running unpinned" << Qt::endl;
+  }
+
+  const QByteArray dbc = makeDbc(messages);
+  const QVector<CANFrame> capture = makeCapture(messages, frames);
+  QStringList names;
+  for (int i = 0; i < subscribed; ++i) {
+    // Spread subscriptions across messages, as a profile would
+    names << QString("Signal%1_%2").arg(i % messages).arg((i / messages) % 8);
+  }
+
+  DbcDatabase database;
+  QString error;
+  if (!database.parse(dbc, &error)) {
+    err << error << Qt::endl;
+    return 2;
+  }
+  SignalDecoder decoder(&database);
+  for (const QString& name : names) {
+    decoder.subscribe(name);
+  }
+  quint64 changes = 0;
+  QElapsedTimer timer;
+  timer.start();
+  for (const CANFrame& frame : capture) {
+    decoder.decode(frame, [&changes](int, const SignalDecoder::Value&) { ++changes; });
+  }
+  const qint64 decoderNs = timer.nsecsElapsed();
+
+  VehicleSignalService service;
+  service.loadDbcText(dbc);
+  for (const QString& name : names) {
+    service.subscribe(name);
+  }
+  constexpr int kBatch = 64;
+  timer.restart();
+  for (int offset = 0; offset < frames; offset += kBatch) {
+    service.processFrames(capture.constData() + offset, qMin(kBatch, frames - offset));
+  }
+  const qint64 serviceNs = timer.nsecsElapsed();
+
+  auto report = [frames](const char* name, qint64 ns) {
+    out << QString("%1 %2 frames/s %3 ns/frame")
+               .arg(name, -22)
+               .arg(frames / (ns / 1e9), 12, 'f', 0)
+               .arg(static_cast<double>(ns) / frames, 8, 'f', 1)
+        << Qt::endl;
+  };
+  out << QString("%1 messages, %2 subscribed signals, %3 frames")
+             .arg(messages)
+             .arg(decoder.slotCount())
+             .arg(frames)
+      << Qt::endl;
+  report("SignalDecoder", decoderNs);
+  report("VehicleSignalService", serviceNs);
+  out << QString("%1 value changes, %2 published after rate limiting")
+             .arg(changes)
+             .arg(service.valuesPublished())
+      << Qt::endl;
+
+  if (parser.isSet(minFpsOption) &&
+      frames / (serviceNs / 1e9) < parser.value(minFpsOption).toDouble()) {
+    err << "Service path below " << parser.value(minFpsOption) << " frames/s" << Qt::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Extension resource governor benchmark
+//
+// Forks CPU-hog "extensions" into an extension cgroup governed by
+// ResourceGovernor and drives a mock Android Auto video source (a 30 fps
+// timer that fills an RGBA frame, like MockAndroidAutoService) on the main
+// thread. Frame timing is reported for each phase: no hogs, hogs while
+// parked, hogs while projecting and hogs while projecting and driving.
+// Needs a writable cgroup v2 hierarchy (root, or a delegated subtree via
+// --cgroup). With --max-late-pct, exits non-zero when the strict phase
+// misses more frames than that.
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+#include "services/extensions/ResourceGovernor.h"
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+struct FrameStats {
+  int frames{0};
+  int late{0};  // finished more than a whole frame period late: a dropped frame
+  double p50{0};
+  double p99{0};
+  double max{0};
+};
+
+double percentile(const QList<double>& sorted, double p) {
+  if (sorted.isEmpty()) return 0.0;
+  const int index = static_cast<int>(std::ceil(p * sorted.size())) - 1;
+  return sorted.at(std::clamp(index, 0, static_cast<int>(sorted.size()) - 1));
+}
+
+/**
+ * Run the mock video source for the given time. A frame's lateness is how much
+ * longer than the timer interval it took to finish after the previous one.
+ */
+FrameStats runFrames(int fps, int seconds) {
+  const qint64 periodNs = (1000 / fps) * 1000000LL;
+  QByteArray frame(800 * 480 * 4, Qt::Uninitialized);
+  QList<double> lateness;
+  quint32 checksum = 0;
+
+  QElapsedTimer clock;
+  QEventLoop loop;
+  QTimer timer;
+  timer.setTimerType(Qt::PreciseTimer);
+  timer.setInterval(1000 / fps);
+  qint64 previous = 0;
+  QObject::connect(&timer, &QTimer::timeout, &loop, [&]() {
+    // Stand-in for decode and colour conversion
+    char* pixels = frame.data();
+    const char shade = static_cast<char>(lateness.size());
+    for (int i = 0; i < frame.size(); i += 4) {
+      pixels[i] = shade;
+      pixels[i + 1] = static_cast<char>(i >> 8);
+      pixels[i + 2] = static_cast<char>(shade ^ i);
+      pixels[i + 3] = static_cast<char>(0xff);
+    }
+    checksum += static_cast<quint8>(pixels[frame.size() / 2]);
+
+    const qint64 now = clock.nsecsElapsed();
+    lateness.append(qMax<qint64>(0, now - previous - periodNs) / 1e6);
+    previous = now;
+  });
+  QTimer::singleShot(seconds * 1000, &loop, &QEventLoop::quit);
+  clock.start();
+  timer.start();
+  loop.exec();
+  timer.stop();
+
+  FrameStats stats;
+  stats.frames = static_cast<int>(lateness.size());
+  stats.late = static_cast<int>(std::count_if(lateness.cbegin(), lateness.cend(),
+                                              [periodNs](double ms) {
+                                                return ms > periodNs / 1e6;
+                                              }));
+  std::sort(lateness.begin(), lateness.end());
+  stats.p50 = percentile(lateness, 0.5);
+  stats.p99 = percentile(lateness, 0.99);
+  stats.max = lateness.isEmpty() ? 0.0 : lateness.last();
+  Q_UNUSED(checksum);
+  return stats;
+}
+
+bool writeFile(const QString& path, const QByteArray& data) {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) return false;
+  return file.write(data) == data.size();
+}
+
+QList<pid_t> spawnHogs(int count, const QString& cgroup) {
+  QList<pid_t> pids;
+  for (int i = 0; i < count; ++i) {
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+      for (volatile unsigned long spin = 0;; spin = spin + 1) {
+      }
+    }
+    if (pid < 0) break;
+    pids.append(pid);
+    if (!writeFile(cgroup + "/cgroup.procs", QByteArray::number(pid))) {
+      err << "Could not move hog " << pid << " into " << cgroup << Qt::endl;
+    }
+  }
+  return pids;
+}
+
+void killHogs(const QList<pid_t>& pids) {
+  for (pid_t pid : pids) {
+    ::kill(pid, SIGKILL);
+  }
+  for (pid_t pid : pids) {
+    ::waitpid(pid, nullptr, 0);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_governor_hog");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Extension resource governor CPU-hog benchmark");
+  parser.addHelpOption();
+  QCommandLineOption cgroupOption("cgroup", "Extension cgroup to create and govern", "path",
+                                  "/sys/fs/cgroup/crankshaft-extensions-benchmark-hog");
+  QCommandLineOption hogsOption("hogs", "CPU-hog processes (default: one per core)", "n");
+  QCommandLineOption classOption("class", "Resource class of the hog extension", "class",
+                                 "normal");
+  QCommandLineOption secondsOption("seconds", "Duration of each phase", "s", "5");
+  QCommandLineOption fpsOption("fps", "Mock video frame rate", "fps", "30");
+  QCommandLineOption maxLateOption("max-late-pct",
+                                   "Fail if the strict phase misses more frames than this", "pct");
+  parser.addOptions(
+      {cgroupOption, hogsOption, classOption, secondsOption, fpsOption, maxLateOption});
+  parser.process(app);
+
+  const QString cgroup = parser.value(cgroupOption);
+  const int hogs = parser.isSet(hogsOption) ? parser.value(hogsOption).toInt()
+                                            : QThread::idealThreadCount();
+  const int seconds = qMax(1, parser.value(secondsOption).toInt());
+  const int fps = std::clamp(parser.value(fpsOption).toInt(), 1, 60);
+
+  // Controllers have to be enabled in the parent for the child's files to exist
+  writeFile(QFileInfo(cgroup).absolutePath() + "/cgroup.subtree_control", "+cpu +io +memory");
+  if (!QDir().mkpath(cgroup) || !QFile::exists(cgroup + "/cgroup.procs")) {
+    err << "Cannot create cgroup " << cgroup << " (needs cgroup v2 and root or delegation)"
+        << Qt::endl;
+    return 2;
+  }
+
+  ResourceGovernor governor;
+  struct Phase {
+    const char* name;
+    bool hogs;
+    bool projection;
+    bool driving;
+  };
+  const Phase phases[] = {
+      {"baseline (no hogs)", false, false, false},
+      {"hogs, parked", true, false, false},
+      {"hogs, projecting", true, true, false},
+      {"hogs, projecting + driving", true, true, true},
+  };
+
+  out << QString("%1 %2 %3 %4 %5 %6 %7")
+             .arg("Phase", -28)
+             .arg("level", -12)
+             .arg("frames", 7)
+             .arg("late", 6)
+             .arg("p50 ms", 8)
+             .arg("p99 ms", 8)
+             .arg("max ms", 8)
+      << Qt::endl;
+
+  FrameStats strict;
+  for (const Phase& phase : phases) {
+    governor.setProjectionActive(phase.projection);
+    governor.setDriving(phase.driving);
+    QList<pid_t> pids;
+    if (phase.hogs) {
+      pids = spawnHogs(hogs, cgroup);
+      governor.track("benchmark-hog", cgroup,
+                     ResourceGovernor::resourceClassFromString(parser.value(classOption)));
+    }
+    const FrameStats stats = runFrames(fps, seconds);
+    killHogs(pids);
+    governor.untrack("benchmark-hog");
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7")
+               .arg(phase.name, -28)
+               .arg(ResourceGovernor::toString(governor.level()), -12)
+               .arg(stats.frames, 7)
+               .arg(stats.late, 6)
+               .arg(stats.p50, 8, 'f', 2)
+               .arg(stats.p99, 8, 'f', 2)
+               .arg(stats.max, 8, 'f', 2)
+        << Qt::endl;
+    strict = stats;
+  }
+
+  QDir().rmdir(cgroup);
+
+  if (parser.isSet(maxLateOption) && strict.frames > 0) {
+    const double latePct = 100.0 * strict.late / strict.frames;
+    if (latePct > parser.value(maxLateOption).toDouble()) {
+      err << "Strict phase missed " << latePct << "% of frames" << Qt::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
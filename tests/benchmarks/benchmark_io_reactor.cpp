@@ -0,0 +1,258 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// HAL I/O reactor benchmark
+//
+// Streams NMEA (10 epochs/s) and SLCAN text (--can-fps frames/s) into a
+// GPSDevice and a CANDevice through two pseudo-terminals, once with the
+// transports' own QSocketNotifiers and once on an IoReactor thread. Reports
+// main-thread event-loop wakeups and CPU time per second, process CPU, the
+// GPS fixes and CAN frames delivered, and how long decoded CAN frames took
+// to reach the main thread.
+
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QAbstractEventDispatcher>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+
+#include "hal/functional/CANDevice.h"
+#include "hal/functional/GPSDevice.h"
+#include "hal/transport/IoReactor.h"
+#include "hal/transport/UARTTransport.h"
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+qint64 cpuNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+struct Pty {
+  int master{-1};
+  QString slave;
+};
+
+Pty openPty() {
+  Pty pty;
+  pty.master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (pty.master < 0 || grantpt(pty.master) != 0 || unlockpt(pty.master) != 0) {
+    return Pty();
+  }
+  termios tio{};
+  tcgetattr(pty.master, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(pty.master, TCSANOW, &tio);
+  pty.slave = QString::fromLocal8Bit(ptsname(pty.master));
+  return pty;
+}
+
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+QByteArray gpsCycle(int epoch) {
+  const QByteArray time =
+      QString("12%1%2.%3")
+          .arg(epoch / 600 % 60, 2, 10, QChar('0'))
+          .arg(epoch / 10 % 60, 2, 10, QChar('0'))
+          .arg(epoch % 10 * 10, 2, 10, QChar('0'))
+          .toLatin1();
+  return sentence("GNRMC," + time + ",A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A") +
+         sentence("GNVTG,084.4,T,,M,022.4,N,041.5,K,A") +
+         sentence("GNGGA," + time + ",4807.038,N,01131.000,E,1,12,0.9,545.4,M,46.9,M,,") +
+         sentence("GNGSA,A,3,01,02,03,,,,,,,,,,1.5,0.9,1.2") +
+         sentence("GPGSV,1,1,03,01,40,083,46,02,17,308,41,03,07,344,39");
+}
+
+// Writes GPS epochs and CAN frames to the pty masters, 1 ms at a time
+class PacedWriter : public QThread {
+ public:
+  PacedWriter(int gpsFd, int canFd, int canFps)
+      : m_gpsFd(gpsFd), m_canFd(canFd), m_canFps(canFps) {}
+
+  void stop() {
+    m_stop = true;
+  }
+
+ protected:
+  void run() override {
+    QElapsedTimer clock;
+    clock.start();
+    qint64 epochs = 0;
+    qint64 frames = 0;
+    QByteArray text;
+    while (!m_stop) {
+      const qint64 elapsed = clock.nsecsElapsed();
+      for (; epochs < elapsed / 100000000LL + 1; ++epochs) {
+        const QByteArray cycle = gpsCycle(static_cast<int>(epochs));
+        [[maybe_unused]] const ssize_t written = ::write(m_gpsFd, cycle.constData(), cycle.size());
+      }
+      text.clear();
+      for (; frames < elapsed * m_canFps / 1000000000LL; ++frames) {
+        text += "t" + QByteArray::number(frames % 0x800, 16).rightJustified(3, '0') +
+                "80011223344556677\r";
+      }
+      if (!text.isEmpty()) {
+        [[maybe_unused]] const ssize_t written = ::write(m_canFd, text.constData(), text.size());
+      }
+      QThread::usleep(1000);
+    }
+  }
+
+ private:
+  int m_gpsFd;
+  int m_canFd;
+  qint64 m_canFps;
+  std::atomic<bool> m_stop{false};
+};
+
+struct Result {
+  double seconds{0};
+  quint64 mainWakeups{0};
+  qint64 mainCpuNs{0};
+  qint64 processCpuNs{0};
+  quint64 fixes{0};
+  quint64 frames{0};
+  qint64 frameDelayNs{0};  // summed over frames
+};
+
+Result run(const Pty& gpsPty, const Pty& canPty, IoReactor* reactor, int canFps, int seconds) {
+  Result result;
+  UARTTransport gpsPort(gpsPty.slave);
+  UARTTransport canPort(canPty.slave);
+  gpsPort.setReactor(reactor);
+  canPort.setReactor(reactor);
+  GPSDevice gps(&gpsPort);
+  gps.setConfig("protocol", "nmea");
+  CANDevice can(&canPort);
+  if (!gps.initialize() || !can.initialize()) {
+    err << "Cannot open the pseudo-terminals" << Qt::endl;
+    return result;
+  }
+
+  QObject context;
+  QObject::connect(&gps, &GPSDevice::locationUpdated, &context,
+                   [&](const GPSLocation&) { ++result.fixes; });
+  QObject::connect(&can, &CANDevice::framesReceived, &context,
+                   [&](const CANFrame* frames, int count) {
+                     const qint64 now = cpuNs(CLOCK_MONOTONIC);
+                     for (int i = 0; i < count; ++i) {
+                       result.frameDelayNs += now - frames[i].timestampNs;
+                     }
+                     result.frames += static_cast<quint64>(count);
+                   });
+  QObject::connect(QAbstractEventDispatcher::instance(), &QAbstractEventDispatcher::awake,
+                   &context, [&]() { ++result.mainWakeups; });
+
+  PacedWriter writer(gpsPty.master, canPty.master, canFps);
+  writer.start();
+  QElapsedTimer clock;
+  const qint64 mainStart = cpuNs(CLOCK_THREAD_CPUTIME_ID);
+  const qint64 processStart = cpuNs(CLOCK_PROCESS_CPUTIME_ID);
+  clock.start();
+  QEventLoop loop;
+  QTimer::singleShot(seconds * 1000, &loop, &QEventLoop::quit);
+  loop.exec();
+  result.seconds = clock.nsecsElapsed() / 1e9;
+  result.mainCpuNs = cpuNs(CLOCK_THREAD_CPUTIME_ID) - mainStart;
+  result.processCpuNs = cpuNs(CLOCK_PROCESS_CPUTIME_ID) - processStart;
+  writer.stop();
+  writer.wait();
+
+  gpsPort.close();
+  canPort.close();
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_io_reactor");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("HAL I/O reactor benchmark");
+  parser.addHelpOption();
+  QCommandLineOption secondsOption("seconds", "Duration of each run", "s", "5");
+  QCommandLineOption canOption("can-fps", "SLCAN frames per second", "fps", "2000");
+  parser.addOptions({secondsOption, canOption});
+  parser.process(app);
+
+  const int seconds = qMax(1, parser.value(secondsOption).toInt());
+  const int canFps = qMax(1, parser.value(canOption).toInt());
+
+  const Pty gpsPty = openPty();
+  const Pty canPty = openPty();
+  if (gpsPty.slave.isEmpty() || canPty.slave.isEmpty()) {
+    err << "Cannot create pseudo-terminals" << Qt::endl;
+    return 2;
+  }
+
+  out << QString("%1 %2 %3 %4 %5 %6 %7")
+             .arg("mode", -10)
+             .arg("main wakeups/s", 15)
+             .arg("main cpu %", 11)
+             .arg("cpu %", 7)
+             .arg("fixes/s", 8)
+             .arg("frames/s", 9)
+             .arg("frame delay us", 15)
+      << Qt::endl;
+
+  IoReactor reactor;
+  for (IoReactor* mode : {static_cast<IoReactor*>(nullptr), &reactor}) {
+    const Result result = run(gpsPty, canPty, mode, canFps, seconds);
+    if (result.seconds <= 0) {
+      return 1;
+    }
+    const double delayUs =
+        result.frames ? result.frameDelayNs / 1e3 / static_cast<double>(result.frames) : 0.0;
+    out << QString("%1 %2 %3 %4 %5 %6 %7")
+               .arg(mode ? "reactor" : "notifier", -10)
+               .arg(result.mainWakeups / result.seconds, 15, 'f', 1)
+               .arg(100.0 * result.mainCpuNs / (result.seconds * 1e9), 11, 'f', 2)
+               .arg(100.0 * result.processCpuNs / (result.seconds * 1e9), 7, 'f', 2)
+               .arg(result.fixes / result.seconds, 8, 'f', 1)
+               .arg(result.frames / result.seconds, 9, 'f', 0)
+               .arg(delayUs, 15, 'f', 1)
+        << Qt::endl;
+  }
+
+  ::close(gpsPty.master);
+  ::close(canPty.master);
+  return 0;
+}
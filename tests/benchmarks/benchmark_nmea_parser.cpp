@@ -0,0 +1,180 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NMEA parser throughput benchmark
+//
+// Feeds recorded NMEA logs (one or more files given on the command line, as
+// captured with e.g. `cat /dev/ttyACM0 > drive.nmea`) through NmeaParser in
+// transport-sized chunks and reports throughput, time per sentence, epochs
+// and heap allocations per sentence. Without a log, a synthetic
+// multi-constellation capture (RMC, VTG, GGA, two GSA and two GSV per epoch)
+// is used. The log is repeated until at least --min-bytes have been parsed.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "hal/functional/NmeaParser.h"
+
+namespace {
+
+std::atomic<quint64> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+QByteArray makeCapture(int epochs) {
+  QByteArray capture;
+  for (int i = 0; i < epochs; ++i) {
+    const int tenths = i % 864000;
+    const QByteArray time = QString("%1%2%3.%4")
+                                .arg(tenths / 36000, 2, 10, QChar('0'))
+                                .arg(tenths / 600 % 60, 2, 10, QChar('0'))
+                                .arg(tenths / 10 % 60, 2, 10, QChar('0'))
+                                .arg(tenths % 10)
+                                .toLatin1();
+    const QByteArray latitude = QByteArray::number(4807.038 + (i % 1000) * 0.0001, 'f', 5);
+    capture += sentence("GNRMC," + time + ",A," + latitude +
+                        ",N,01131.00000,E,022.4,084.4,230394,,,A");
+    capture += sentence("GNVTG,084.4,T,,M,022.4,N,041.5,K,A");
+    capture += sentence("GNGGA," + time + "," + latitude +
+                        ",N,01131.00000,E,1,12,0.9,545.4,M,46.9,M,,");
+    capture += sentence("GNGSA,A,3,01,02,03,04,05,06,07,,,,,,1.5,0.9,1.2");
+    capture += sentence("GNGSA,A,3,65,66,67,68,69,,,,,,,,1.5,0.9,1.2");
+    capture += sentence("GPGSV,2,1,07,01,40,083,46,02,17,308,41,03,07,344,39,04,55,120,44");
+    capture += sentence("GLGSV,2,1,05,65,30,120,40,66,12,200,35,67,45,010,42,68,22,270,38");
+  }
+  return capture;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_nmea_parser");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("NMEA parser throughput benchmark");
+  parser.addHelpOption();
+  parser.addPositionalArgument("logs", "Recorded NMEA logs (default: synthetic capture)");
+  QCommandLineOption epochsOption("epochs", "Epochs in the synthetic capture", "n", "100000");
+  QCommandLineOption chunkOption("chunk", "Bytes per simulated transport read", "bytes", "512");
+  QCommandLineOption minBytesOption("min-bytes", "Parse at least this much in total", "bytes",
+                                    "50000000");
+  parser.addOptions({epochsOption, chunkOption, minBytesOption});
+  parser.process(app);
+
+  QByteArray capture;
+  for (const QString& path : parser.positionalArguments()) {
+    QFile log(path);
+    if (!log.open(QIODevice::ReadOnly)) {
+      err << "Cannot read " << path << Qt::endl;
+      return 2;
+    }
+    capture += log.readAll();
+  }
+  if (capture.isEmpty()) {
+    capture = makeCapture(qMax(1, parser.value(epochsOption).toInt()));
+  }
+  const int chunk = qBound(1, parser.value(chunkOption).toInt(), NmeaParser::kCapacity / 2);
+  const qint64 minBytes = parser.value(minBytesOption).toLongLong();
+  const int passes = static_cast<int>(qMax<qint64>(1, minBytes / capture.size()));
+
+  NmeaParser nmea;
+  NmeaParser::Epoch epochs[16];
+  double checksum = 0;
+  QElapsedTimer timer;
+  const quint64 allocations = g_allocations.load();
+  timer.start();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (qsizetype offset = 0; offset < capture.size(); offset += chunk) {
+      nmea.append(capture.constData() + offset,
+                  static_cast<int>(qMin<qsizetype>(chunk, capture.size() - offset)));
+      int count = 0;
+      while ((count = nmea.parse(epochs, 16)) > 0) {
+        for (int i = 0; i < count; ++i) {
+          checksum += epochs[i].latitude + epochs[i].speed;
+        }
+      }
+    }
+  }
+  const qint64 elapsedNs = timer.nsecsElapsed();
+  const quint64 allocated = g_allocations.load() - allocations;
+
+  const NmeaParser::Stats stats = nmea.stats();
+  const quint64 lines = stats.sentences + stats.ignored + stats.malformed + stats.checksumErrors;
+  const double seconds = elapsedNs / 1e9;
+  out << QString("bytes parsed:        %1 (%2 passes)")
+             .arg(static_cast<double>(capture.size()) * passes, 0, 'f', 0)
+             .arg(passes)
+      << Qt::endl;
+  out << QString("throughput:          %1 MB/s")
+             .arg(capture.size() * passes / seconds / 1e6, 0, 'f', 1)
+      << Qt::endl;
+  out << QString("sentences/s:         %1").arg(lines / seconds, 0, 'f', 0) << Qt::endl;
+  out << QString("ns/sentence:         %1").arg(elapsedNs / qMax(1.0, double(lines)), 0, 'f', 1)
+      << Qt::endl;
+  out << QString("epochs:              %1 (%2 sentences decoded, %3 ignored)")
+             .arg(stats.epochs)
+             .arg(stats.sentences)
+             .arg(stats.ignored)
+      << Qt::endl;
+  out << QString("rejected:            %1 checksum, %2 malformed")
+             .arg(stats.checksumErrors)
+             .arg(stats.malformed)
+      << Qt::endl;
+  out << QString("allocs/sentence:     %1").arg(allocated / qMax(1.0, double(lines)), 0, 'f', 3)
+      << Qt::endl;
+  Q_UNUSED(checksum);
+  return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Android Auto sensor feed benchmark
+//
+// Feeds SensorFeeder the fused vehicle state at the fusion rate for a
+// simulated drive, with the phone's usual sensor requests (location, speed,
+// compass, night mode and driving status) and night mode and driving state
+// changing now and then. Reports the messages and samples per second the
+// phone receives, and the CPU time the feeder spends per state update and
+// per message. Heap allocations in the loop are counted (there should be
+// none). Encoding into the protobuf message and the aasdk send are not part
+// of this; they need a phone.
+
+#include <time.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#include "services/android_auto/SensorFeeder.h"
+
+namespace {
+
+std::atomic<quint64> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+QTextStream out(stdout);
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSpeed = 15.0;
+constexpr double kRadius = 200.0;
+constexpr double kMetresPerDegree = 6378137.0 * kPi / 180.0;
+
+qint64 cpuTimeNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// A 200 m circle at 15 m/s, as the fusion service would report it
+VehicleState stateAt(qint64 timestampNs) {
+  const double angle = kSpeed / kRadius * timestampNs * 1e-9;
+  VehicleState state{};
+  state.latitude = 48.0 - kRadius * (1.0 - std::cos(angle)) / kMetresPerDegree;
+  state.longitude = 11.0 + kRadius * std::sin(angle) / (kMetresPerDegree * 0.669);
+  state.speed = static_cast<float>(kSpeed);
+  state.heading = static_cast<float>(std::fmod(90.0 + angle * 180.0 / kPi, 360.0));
+  state.positionAccuracy = 2.0f;
+  state.flags = VehicleState::PositionValid | VehicleState::HeadingValid |
+                VehicleState::SpeedValid;
+  state.timestampNs = timestampNs;
+  return state;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_sensor_feeder");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Android Auto sensor feed benchmark");
+  parser.addHelpOption();
+  QCommandLineOption rateOption("rate", "Vehicle state updates per second", "hz", "50");
+  QCommandLineOption secondsOption("seconds", "Simulated drive length", "s", "36000");
+  QCommandLineOption locationOption("location-ms", "Requested location period", "ms", "100");
+  QCommandLineOption speedOption("speed-ms", "Requested speed period", "ms", "100");
+  QCommandLineOption compassOption("compass-ms", "Requested compass period", "ms", "200");
+  parser.addOptions({rateOption, secondsOption, locationOption, speedOption, compassOption});
+  parser.process(app);
+
+  const int rateHz = qBound(1, parser.value(rateOption).toInt(), 1000);
+  const qint64 seconds = qMax(1, parser.value(secondsOption).toInt());
+  const qint64 stepNs = 1000000000LL / rateHz;
+  const qint64 updates = seconds * rateHz;
+
+  SensorFeeder feeder;
+  quint64 messages = 0;
+  qint64 checksum = 0;
+  QObject::connect(&feeder, &SensorFeeder::batchReady, [&](const SensorFeeder::Batch& batch) {
+    ++messages;
+    checksum += batch.latitudeE7 + batch.speedE3 + batch.fields;
+  });
+  feeder.requestSensor(SensorFeeder::Sensor::Location, parser.value(locationOption).toLongLong());
+  feeder.requestSensor(SensorFeeder::Sensor::Speed, parser.value(speedOption).toLongLong());
+  feeder.requestSensor(SensorFeeder::Sensor::Compass, parser.value(compassOption).toLongLong());
+  feeder.requestSensor(SensorFeeder::Sensor::NightMode, 0);
+  feeder.requestSensor(SensorFeeder::Sensor::DrivingStatus, 0);
+
+  const quint64 allocations = g_allocations.load();
+  QElapsedTimer wall;
+  wall.start();
+  const qint64 cpuStart = cpuTimeNs();
+  for (qint64 i = 0; i < updates; ++i) {
+    const qint64 nowNs = (i + 1) * stepNs;
+    feeder.updateVehicleState(stateAt(nowNs));
+    // Dusk and a stop every ten minutes
+    if (i % (600 * rateHz) == 0) {
+      feeder.setNightMode((i / (600 * rateHz)) % 2 == 1);
+      feeder.setDriving(i % (1200 * rateHz) != 0);
+    }
+  }
+  const double cpuNs = static_cast<double>(cpuTimeNs() - cpuStart);
+  const double wallNs = static_cast<double>(wall.nsecsElapsed());
+  const quint64 allocated = g_allocations.load() - allocations;
+
+  const SensorFeeder::Stats stats = feeder.stats();
+  out << QString("state updates:       %1 at %2 Hz (%3 s simulated)")
+             .arg(updates)
+             .arg(rateHz)
+             .arg(seconds)
+      << Qt::endl;
+  out << QString("requested periods:   location %1 ms, speed %2 ms, compass %3 ms")
+             .arg(feeder.periodMs(SensorFeeder::Sensor::Location))
+             .arg(feeder.periodMs(SensorFeeder::Sensor::Speed))
+             .arg(feeder.periodMs(SensorFeeder::Sensor::Compass))
+      << Qt::endl;
+  out << QString("messages/s:          %1").arg(messages / static_cast<double>(seconds), 0, 'f', 2)
+      << Qt::endl;
+  out << QString("samples/s:           %1")
+             .arg(stats.samples / static_cast<double>(seconds), 0, 'f', 2)
+      << Qt::endl;
+  out << QString("cpu ns/update:       %1 (wall %2)")
+             .arg(cpuNs / updates, 0, 'f', 1)
+             .arg(wallNs / updates, 0, 'f', 1)
+      << Qt::endl;
+  out << QString("cpu ns/message:      %1").arg(cpuNs / qMax<quint64>(1, messages), 0, 'f', 1)
+      << Qt::endl;
+  out << QString("cpu at %1 Hz:        %2% of one core")
+             .arg(rateHz)
+             .arg(cpuNs / updates * rateHz / 1e7, 0, 'f', 5)
+      << Qt::endl;
+  out << QString("allocs/message:      %1")
+             .arg(allocated / static_cast<double>(qMax<quint64>(1, messages)), 0, 'f', 3)
+      << Qt::endl;
+  Q_UNUSED(checksum);
+  return 0;
+}
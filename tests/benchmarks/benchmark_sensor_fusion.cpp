@@ -0,0 +1,195 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Sensor fusion step cost benchmark
+//
+// Runs VehicleStateFilter over a synthetic drive (a 200 m circle at 15 m/s)
+// at the fusion rate, with IMU samples at 100 Hz, wheel speed at 25 Hz and
+// GPS at 10 Hz, and reports the cost of one step: predicting to the step
+// time plus the measurements that arrived since the previous one. Each kind
+// of update is also timed on its own, and heap allocations in the loop are
+// counted (there should be none).
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#include "services/vehicle/VehicleStateFilter.h"
+
+namespace {
+
+std::atomic<quint64> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+QTextStream out(stdout);
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSpeed = 15.0;
+constexpr double kRadius = 200.0;
+constexpr double kMetresPerDegree = 6378137.0 * kPi / 180.0;
+constexpr qint64 kImuPeriodNs = 10000000LL;
+constexpr qint64 kWheelPeriodNs = 40000000LL;
+constexpr qint64 kGpsPeriodNs = 100000000LL;
+
+struct Drive {
+  VehicleStateFilter filter;
+  qint64 nextImuNs{0};
+  qint64 nextWheelNs{0};
+  qint64 nextGpsNs{0};
+  double checksum{0};
+
+  // Everything that happened up to nowNs, then the step itself
+  void step(qint64 nowNs) {
+    for (; nextImuNs <= nowNs; nextImuNs += kImuPeriodNs) {
+      ImuSample sample{};
+      sample.accel[1] = static_cast<float>(-kSpeed * kSpeed / kRadius);
+      sample.accel[2] = 9.81f;
+      sample.gyro[2] = static_cast<float>(-kSpeed / kRadius);
+      sample.timestampNs = nextImuNs;
+      filter.updateImu(sample);
+    }
+    for (; nextWheelNs <= nowNs; nextWheelNs += kWheelPeriodNs) {
+      filter.updateWheelSpeed(kSpeed, nextWheelNs);
+    }
+    for (; nextGpsNs <= nowNs; nextGpsNs += kGpsPeriodNs) {
+      filter.updateGps(fixAt(nextGpsNs));
+    }
+    filter.predictTo(nowNs);
+    const VehicleState state = filter.state();
+    checksum += state.speed + state.latitude;
+  }
+
+  // Starting east and turning right: the centre is kRadius south of the start
+  static VehicleStateFilter::GpsFix fixAt(qint64 timestampNs) {
+    const double angle = kSpeed / kRadius * timestampNs * 1e-9;
+    const double metresPerDegreeLongitude = kMetresPerDegree * std::cos(48.0 * kPi / 180.0);
+    VehicleStateFilter::GpsFix fix{};
+    fix.latitude = 48.0 - kRadius * (1.0 - std::cos(angle)) / kMetresPerDegree;
+    fix.longitude = 11.0 + kRadius * std::sin(angle) / metresPerDegreeLongitude;
+    fix.speed = kSpeed;
+    fix.heading = std::fmod(90.0 + angle * 180.0 / kPi, 360.0);
+    fix.hdop = 0.9;
+    fix.valid = true;
+    fix.timestampNs = timestampNs;
+    return fix;
+  }
+};
+
+template <typename Body>
+double nsPerCall(int calls, Body&& body) {
+  QElapsedTimer timer;
+  timer.start();
+  for (int i = 0; i < calls; ++i) {
+    body(i);
+  }
+  return static_cast<double>(timer.nsecsElapsed()) / calls;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_sensor_fusion");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Sensor fusion step cost benchmark");
+  parser.addHelpOption();
+  QCommandLineOption rateOption("rate", "Fusion steps per second", "hz", "50");
+  QCommandLineOption stepsOption("steps", "Steps to run", "n", "1000000");
+  parser.addOptions({rateOption, stepsOption});
+  parser.process(app);
+
+  const int rateHz = qBound(1, parser.value(rateOption).toInt(), 1000);
+  const int steps = qMax(1, parser.value(stepsOption).toInt());
+  const qint64 stepNs = 1000000000LL / rateHz;
+
+  Drive drive;
+  drive.step(0);  // sets the clock and the origin
+  const quint64 allocations = g_allocations.load();
+  const double stepCost = nsPerCall(steps, [&](int i) { drive.step((i + 1) * stepNs); });
+  const quint64 allocated = g_allocations.load() - allocations;
+
+  // The same filter, one kind of work at a time
+  VehicleStateFilter& filter = drive.filter;
+  qint64 now = filter.timeNs();
+  const int calls = qMax(1000, steps / 4);
+  const double predictCost = nsPerCall(calls, [&](int) { filter.predictTo(now += stepNs); });
+  const double imuCost = nsPerCall(calls, [&](int) {
+    ImuSample sample{};
+    sample.gyro[2] = static_cast<float>(-kSpeed / kRadius);
+    sample.timestampNs = now;
+    filter.updateImu(sample);
+  });
+  const double wheelCost = nsPerCall(calls, [&](int) { filter.updateWheelSpeed(kSpeed, now); });
+  const double gpsCost = nsPerCall(calls, [&](int) { filter.updateGps(Drive::fixAt(now)); });
+  const double stateCost = nsPerCall(calls, [&](int) { drive.checksum += filter.state().speed; });
+
+  const VehicleStateFilter::Stats stats = filter.stats();
+  out << QString("steps:               %1 at %2 Hz (%3 s simulated)")
+             .arg(steps)
+             .arg(rateHz)
+             .arg(steps / static_cast<double>(rateHz), 0, 'f', 0)
+      << Qt::endl;
+  out << QString("ns/step:             %1 (%2% of one core at %3 Hz)")
+             .arg(stepCost, 0, 'f', 1)
+             .arg(stepCost * rateHz / 1e7, 0, 'f', 4)
+             .arg(rateHz)
+      << Qt::endl;
+  out << QString("ns/predict (%1 ms):   %2").arg(stepNs / 1000000).arg(predictCost, 0, 'f', 1)
+      << Qt::endl;
+  out << QString("ns/IMU update:       %1").arg(imuCost, 0, 'f', 1) << Qt::endl;
+  out << QString("ns/wheel update:     %1").arg(wheelCost, 0, 'f', 1) << Qt::endl;
+  out << QString("ns/GPS update:       %1").arg(gpsCost, 0, 'f', 1) << Qt::endl;
+  out << QString("ns/state():          %1").arg(stateCost, 0, 'f', 1) << Qt::endl;
+  out << QString("updates:             %1 IMU, %2 wheel, %3 GPS (%4 rejected)")
+             .arg(stats.imuUpdates)
+             .arg(stats.wheelSpeedUpdates)
+             .arg(stats.gpsUpdates)
+             .arg(stats.gpsRejected)
+      << Qt::endl;
+  out << QString("allocs/step:         %1").arg(allocated / static_cast<double>(steps), 0, 'f', 3)
+      << Qt::endl;
+  Q_UNUSED(drive.checksum);
+  return 0;
+}
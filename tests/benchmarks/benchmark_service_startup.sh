@@ -0,0 +1,140 @@
+#!/usr/bin/env bash
+# Project: Crankshaft
+# This file is part of Crankshaft project.
+# Copyright (C) 2025 OpenCarDev Team
+#
+#  Crankshaft is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  Crankshaft is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+
+set -euo pipefail
+
+# Service startup benchmark for Crankshaft core
+# Compares time-to-READY for sequential and parallel service startup.
+# The time is taken from the core's own "[STARTUP] READY" log line.
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(cd "${SCRIPT_DIR}/../.." && pwd)"
+BUILD_DIR="${PROJECT_ROOT}/build"
+
+# Configuration
+CORE_BINARY="${BUILD_DIR}/core/crankshaft-core"
+WS_PORT=9003
+ITERATIONS="${1:-5}"
+READY_TIMEOUT_S=30
+
+# Colours for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+echo -e "${BLUE}═══════════════════════════════════════════════════════════${NC}"
+echo -e "${BLUE}   Crankshaft Service Startup Benchmark${NC}"
+echo -e "${BLUE}═══════════════════════════════════════════════════════════${NC}"
+echo ""
+echo -e "Iterations:  ${ITERATIONS} per mode"
+echo ""
+
+# Check binaries exist
+if [[ ! -f "$CORE_BINARY" ]]; then
+    echo -e "${RED}Error: Core binary not found: $CORE_BINARY${NC}"
+    echo "Build the project first: cmake --build build"
+    exit 1
+fi
+
+LOG_FILE=$(mktemp)
+CORE_PID=""
+
+cleanup() {
+    if [[ -n "${CORE_PID:-}" ]] && kill -0 "$CORE_PID" 2>/dev/null; then
+        kill "$CORE_PID" 2>/dev/null || true
+        wait "$CORE_PID" 2>/dev/null || true
+    fi
+    rm -f "$LOG_FILE"
+}
+trap cleanup EXIT
+
+# Run the core once and print its reported time-to-READY in ms
+run_once() {
+    local mode=$1
+    : > "$LOG_FILE"
+
+    "$CORE_BINARY" --port "$WS_PORT" --startup-mode "$mode" >"$LOG_FILE" 2>&1 &
+    CORE_PID=$!
+
+    local waited=0
+    local ready_ms=""
+    while ((waited < READY_TIMEOUT_S * 10)); do
+        ready_ms=$(grep -o "READY - Total startup time: [0-9]*ms" "$LOG_FILE" 2>/dev/null \
+            | grep -o "[0-9]*" | head -1 || true)
+        [[ -n "$ready_ms" ]] && break
+        sleep 0.1
+        ((waited++)) || true
+    done
+
+    kill "$CORE_PID" 2>/dev/null || true
+    wait "$CORE_PID" 2>/dev/null || true
+    CORE_PID=""
+
+    echo "${ready_ms:-}"
+}
+
+declare -A averages
+
+for mode in sequential parallel; do
+    echo -e "${BLUE}─────────────────────────────────────────────────────────${NC}"
+    echo -e "${BLUE}Mode: ${mode}${NC}"
+
+    total=0
+    count=0
+    min_time=""
+    max_time=""
+    for ((i=1; i<=ITERATIONS; i++)); do
+        ms=$(run_once "$mode")
+        if [[ -z "$ms" ]]; then
+            echo -e "${RED}  Iteration $i: core did not report READY within ${READY_TIMEOUT_S}s${NC}"
+            continue
+        fi
+        echo "  Iteration $i: ${ms}ms"
+        total=$((total + ms))
+        count=$((count + 1))
+        [[ -z "$min_time" || "$ms" -lt "$min_time" ]] && min_time=$ms
+        [[ -z "$max_time" || "$ms" -gt "$max_time" ]] && max_time=$ms
+        sleep 0.5
+    done
+
+    if ((count == 0)); then
+        echo -e "${RED}No successful iterations for ${mode} mode${NC}"
+        exit 1
+    fi
+
+    averages[$mode]=$((total / count))
+    echo "  Average: ${averages[$mode]}ms  Minimum: ${min_time}ms  Maximum: ${max_time}ms"
+done
+
+echo ""
+echo -e "${BLUE}═══════════════════════════════════════════════════════════${NC}"
+echo -e "${BLUE}   Benchmark Results${NC}"
+echo -e "${BLUE}═══════════════════════════════════════════════════════════${NC}"
+echo ""
+echo "Sequential:  ${averages[sequential]}ms"
+echo "Parallel:    ${averages[parallel]}ms"
+
+if ((averages[parallel] <= averages[sequential])); then
+    echo -e "${GREEN}Parallel startup saves $((averages[sequential] - averages[parallel]))ms${NC}"
+    exit 0
+else
+    echo -e "${YELLOW}Parallel startup is $((averages[parallel] - averages[sequential]))ms slower${NC}"
+    exit 1
+fi
@@ -0,0 +1,203 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// SLCAN parser benchmark
+//
+// Decodes the same synthetic SLCAN capture (a mix of 11-bit, 29-bit and
+// remote frames, delivered in transport-sized chunks) with the QString-based
+// parser CANDevice used before and with SlcanParser, and reports time and
+// heap allocations per frame for each. The old parser's per-frame INFO log
+// line is left out so only the decoding is compared.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "hal/functional/SlcanParser.h"
+
+namespace {
+
+std::atomic<quint64> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+QTextStream out(stdout);
+
+struct LegacyMessage {
+  quint32 id;
+  QByteArray data;
+  bool extended;
+  bool rtr;
+  bool fd;
+  QDateTime timestamp;
+};
+
+// CANDevice::parseCANData as it was, minus the log line
+quint64 legacyParse(QByteArray& buffer) {
+  quint64 checksum = 0;
+  int start = 0;
+  int end = buffer.indexOf('\r', start);
+  while (end != -1) {
+    QByteArray frame = buffer.mid(start, end - start);
+    if (frame.startsWith('t') || frame.startsWith('T')) {
+      LegacyMessage message;
+      message.extended = frame.startsWith('T');
+      message.rtr = false;
+      message.fd = false;
+      message.timestamp = QDateTime::currentDateTime();
+      QString frameStr = QString::fromLatin1(frame);
+      bool ok;
+      message.id = frameStr.mid(1, message.extended ? 8 : 3).toUInt(&ok, 16);
+      quint8 len = frameStr.mid(message.extended ? 9 : 4, 1).toUInt(&ok, 16);
+      QString dataStr = frameStr.mid(message.extended ? 10 : 5, len * 2);
+      message.data = QByteArray::fromHex(dataStr.toLatin1());
+      checksum += message.id + static_cast<quint8>(message.data.value(0));
+    }
+    start = end + 1;
+    end = buffer.indexOf('\r', start);
+  }
+  if (start > 0) {
+    buffer.remove(0, start);
+  }
+  return checksum;
+}
+
+QByteArray makeCapture(int frames) {
+  QByteArray capture;
+  char line[SlcanParser::kMaxLineLength + 1];
+  for (int i = 0; i < frames; ++i) {
+    CANFrame frame{};
+    frame.extended = i % 4 == 3;
+    frame.rtr = i % 16 == 5;
+    frame.id = frame.extended ? 0x18DA0000u + static_cast<quint32>(i & 0xFFFF)
+                              : static_cast<quint32>(i & 0x7FF);
+    frame.length = static_cast<quint8>(frame.rtr ? 0 : 1 + i % 8);
+    for (int b = 0; b < frame.length; ++b) {
+      frame.data[b] = static_cast<quint8>(i + b);
+    }
+    capture.append(line, SlcanParser::encode(frame, line));
+  }
+  return capture;
+}
+
+struct Result {
+  double nsPerFrame{0};
+  double allocationsPerFrame{0};
+  quint64 checksum{0};
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_slcan_parser");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("SLCAN parser benchmark: legacy QString parser vs SlcanParser");
+  parser.addHelpOption();
+  QCommandLineOption framesOption("frames", "Frames in the capture", "n", "200000");
+  QCommandLineOption chunkOption("chunk", "Bytes per simulated transport read", "bytes", "512");
+  parser.addOptions({framesOption, chunkOption});
+  parser.process(app);
+
+  const int frames = qMax(1, parser.value(framesOption).toInt());
+  const int chunk = qBound(1, parser.value(chunkOption).toInt(), SlcanParser::kCapacity);
+  const QByteArray capture = makeCapture(frames);
+
+  Result legacy;
+  {
+    QByteArray buffer;
+    buffer.reserve(2 * chunk);
+    QElapsedTimer timer;
+    const quint64 allocations = g_allocations.load();
+    timer.start();
+    for (qsizetype offset = 0; offset < capture.size(); offset += chunk) {
+      buffer.append(capture.constData() + offset, qMin<qsizetype>(chunk, capture.size() - offset));
+      legacy.checksum += legacyParse(buffer);
+    }
+    legacy.nsPerFrame = static_cast<double>(timer.nsecsElapsed()) / frames;
+    legacy.allocationsPerFrame = static_cast<double>(g_allocations.load() - allocations) / frames;
+  }
+
+  Result tokenizer;
+  {
+    SlcanParser slcan;
+    CANFrame decoded[64];
+    QElapsedTimer timer;
+    const quint64 allocations = g_allocations.load();
+    timer.start();
+    for (qsizetype offset = 0; offset < capture.size(); offset += chunk) {
+      slcan.append(capture.constData() + offset,
+                   static_cast<int>(qMin<qsizetype>(chunk, capture.size() - offset)));
+      int count = 0;
+      while ((count = slcan.parse(decoded, 64, timer.nsecsElapsed())) > 0) {
+        for (int i = 0; i < count; ++i) {
+          if (!decoded[i].rtr) {
+            tokenizer.checksum += decoded[i].id + (decoded[i].length ? decoded[i].data[0] : 0);
+          }
+        }
+      }
+    }
+    tokenizer.nsPerFrame = static_cast<double>(timer.nsecsElapsed()) / frames;
+    tokenizer.allocationsPerFrame =
+        static_cast<double>(g_allocations.load() - allocations) / frames;
+  }
+
+  out << QString("%1 %2 %3").arg("parser", -14).arg("ns/frame", 10).arg("allocs/frame", 13)
+      << Qt::endl;
+  out << QString("%1 %2 %3")
+             .arg("legacy", -14)
+             .arg(legacy.nsPerFrame, 10, 'f', 1)
+             .arg(legacy.allocationsPerFrame, 13, 'f', 2)
+      << Qt::endl;
+  out << QString("%1 %2 %3")
+             .arg("SlcanParser", -14)
+             .arg(tokenizer.nsPerFrame, 10, 'f', 1)
+             .arg(tokenizer.allocationsPerFrame, 13, 'f', 2)
+      << Qt::endl;
+  out << QString("speedup %1x").arg(legacy.nsPerFrame / qMax(tokenizer.nsPerFrame, 0.001), 0,
+                                     'f', 1)
+      << Qt::endl;
+
+  // Both must have seen the same data frames
+  return legacy.checksum == tokenizer.checksum ? 0 : 1;
+}
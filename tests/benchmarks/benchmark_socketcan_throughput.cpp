@@ -0,0 +1,160 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// SocketCAN throughput benchmark
+//
+// Pushes frames through a virtual CAN interface from one SocketCANTransport
+// to another and reports received frames per second and process CPU time per
+// thousand frames, once per receive batch size. A batch size of 1 is the
+// one-syscall-per-frame baseline. Needs a vcan interface:
+//   ip link add dev vcan0 type vcan && ip link set up vcan0
+
+#include <net/if.h>
+#include <time.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QTimer>
+#include <cstring>
+
+#include "hal/transport/SocketCANTransport.h"
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+qint64 processCpuNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+struct Result {
+  qint64 received{0};
+  double seconds{0};
+  double cpuMsPer1k{0};
+  quint64 receiveCalls{0};
+  quint64 dropped{0};
+};
+
+Result run(const QString& interface, int batchSize, qint64 frames, int burst) {
+  SocketCANTransport sender(interface);
+  SocketCANTransport receiver(interface);
+  sender.configure("batchSize", 64);
+  receiver.configure("batchSize", batchSize);
+  receiver.configure("filters", QStringList{"100:700"});  // 0x100-0x1FF
+  receiver.configure("receiveBufferBytes", 4 * 1024 * 1024);
+  Result result;
+  if (!sender.open() || !receiver.open()) {
+    return result;
+  }
+
+  QVector<SocketCANTransport::Frame> batch(burst);
+  for (int i = 0; i < burst; ++i) {
+    SocketCANTransport::Frame& frame = batch[i];
+    memset(&frame, 0, sizeof(frame));
+    frame.frame.can_id = 0x100 + (i % 0x100);
+    frame.frame.len = 8;
+    memcpy(frame.frame.data, &i, sizeof(i));
+  }
+
+  SocketCANTransport::Frame drained[256];
+  QObject::connect(&receiver, &SocketCANTransport::framesReceived, [&]() {
+    int count = 0;
+    while ((count = receiver.readFrames(drained, 256)) > 0) {
+      result.received += count;
+    }
+  });
+
+  QEventLoop loop;
+  qint64 sent = 0;
+  QTimer pump;
+  QObject::connect(&pump, &QTimer::timeout, [&]() {
+    // Keep at most a few bursts in flight so the kernel never has to drop
+    if (sent < frames && sent - result.received < 4 * burst) {
+      const int n = static_cast<int>(qMin<qint64>(burst, frames - sent));
+      sent += qMax(0, sender.writeFrames(batch.constData(), n));
+    }
+    if (result.received >= frames) {
+      loop.quit();
+    }
+  });
+  QTimer::singleShot(30000, &loop, &QEventLoop::quit);  // give up on heavy loss
+
+  QElapsedTimer elapsed;
+  const qint64 cpuStart = processCpuNs();
+  elapsed.start();
+  pump.start(0);
+  loop.exec();
+  result.seconds = elapsed.nsecsElapsed() / 1e9;
+  result.cpuMsPer1k = result.received > 0
+                          ? (processCpuNs() - cpuStart) / 1e6 / (result.received / 1000.0)
+                          : 0.0;
+  result.receiveCalls = receiver.stats().receiveCalls;
+  result.dropped = receiver.stats().kernelDropped + receiver.stats().queueDropped;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_socketcan_throughput");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("SocketCAN batched receive throughput benchmark");
+  parser.addHelpOption();
+  QCommandLineOption interfaceOption("interface", "Virtual CAN interface", "name", "vcan0");
+  QCommandLineOption framesOption("frames", "Frames per run", "n", "200000");
+  QCommandLineOption burstOption("burst", "Frames written per event-loop pass", "n", "256");
+  parser.addOptions({interfaceOption, framesOption, burstOption});
+  parser.process(app);
+
+  const QString interface = parser.value(interfaceOption);
+  if (if_nametoindex(interface.toLocal8Bit().constData()) == 0) {
+    err << "No such interface " << interface
+        << " (ip link add dev vcan0 type vcan && ip link set up vcan0)" << Qt::endl;
+    return 2;
+  }
+  const qint64 frames = qMax<qint64>(1, parser.value(framesOption).toLongLong());
+  const int burst = qBound(1, parser.value(burstOption).toInt(), 4096);
+
+  out << QString("%1 %2 %3 %4 %5")
+             .arg("batch", 6)
+             .arg("frames/s", 12)
+             .arg("CPU ms/1k", 10)
+             .arg("recv calls", 11)
+             .arg("dropped", 8)
+      << Qt::endl;
+  for (int batchSize : {1, 8, 64, 256}) {
+    const Result result = run(interface, batchSize, frames, burst);
+    out << QString("%1 %2 %3 %4 %5")
+               .arg(batchSize, 6)
+               .arg(result.seconds > 0 ? result.received / result.seconds : 0.0, 12, 'f', 0)
+               .arg(result.cpuMsPer1k, 10, 'f', 3)
+               .arg(result.receiveCalls, 11)
+               .arg(result.dropped, 8)
+        << Qt::endl;
+  }
+  return 0;
+}
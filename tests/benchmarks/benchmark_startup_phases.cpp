@@ -0,0 +1,265 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Startup phase benchmark and regression harness
+//
+// Launches crankshaft-core N times against a fresh mock profile directory,
+// collects the Chrome trace written via --startup-trace and reports the
+// min/median/p95/max of every phase. With --baseline, exits non-zero when a
+// phase median regresses by more than --threshold-pct (and --min-slack-ms,
+// so sub-millisecond phases do not flap).
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+struct Stats {
+  double min{0};
+  double median{0};
+  double p95{0};
+  double max{0};
+};
+
+Stats computeStats(QList<double> samples) {
+  Stats stats;
+  if (samples.isEmpty()) return stats;
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&samples](double p) {
+    const int index = static_cast<int>(std::ceil(p * samples.size())) - 1;
+    return samples.at(std::clamp(index, 0, static_cast<int>(samples.size()) - 1));
+  };
+  stats.min = samples.first();
+  stats.median = percentile(0.5);
+  stats.p95 = percentile(0.95);
+  stats.max = samples.last();
+  return stats;
+}
+
+bool writeFile(const QString& path, const QByteArray& data) {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+  return file.write(data) == data.size();
+}
+
+/**
+ * Run the core once and return per-phase durations in milliseconds.
+ * Spans with the same name within a run are summed; "READY" is the
+ * trace timestamp of the ready marker.
+ */
+bool runOnce(const QString& corePath, quint16 port, int timeoutMs, QMap<QString, double>* phases) {
+  QTemporaryDir workDir;
+  if (!workDir.isValid()) return false;
+
+  const QString profileDir = workDir.filePath("profiles");
+  const QString configPath = workDir.filePath("crankshaft.json");
+  const QString tracePath = workDir.filePath("startup-trace.json");
+  QDir().mkpath(profileDir);
+
+  // An empty profile directory makes the core write its mock-only defaults
+  QJsonObject config{
+      {"core", QJsonObject{{"websocket", QJsonObject{{"port", port}}},
+                           {"profile", QJsonObject{{"configDir", profileDir}}}}}};
+  if (!writeFile(configPath, QJsonDocument(config).toJson())) return false;
+
+  QProcess core;
+  core.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+  core.setStandardOutputFile(QProcess::nullDevice());
+  core.start(corePath, {"--config", configPath, "--port", QString::number(port),
+                        "--startup-trace", tracePath});
+  if (!core.waitForStarted(5000)) {
+    err << "Failed to start " << corePath << ": " << core.errorString() << Qt::endl;
+    return false;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  while (!QFile::exists(tracePath) && timer.elapsed() < timeoutMs &&
+         core.state() == QProcess::Running) {
+    QThread::msleep(10);
+  }
+
+  core.terminate();
+  if (!core.waitForFinished(5000)) {
+    core.kill();
+    core.waitForFinished(1000);
+  }
+
+  QFile trace(tracePath);
+  if (!trace.open(QIODevice::ReadOnly)) {
+    err << "No startup trace produced within " << timeoutMs << "ms" << Qt::endl;
+    return false;
+  }
+
+  const QJsonArray events =
+      QJsonDocument::fromJson(trace.readAll()).object()["traceEvents"].toArray();
+  for (const auto& value : events) {
+    const QJsonObject event = value.toObject();
+    const QString name = event["name"].toString();
+    if (event["ph"].toString() == "X") {
+      (*phases)[name] += event["dur"].toDouble() / 1000.0;
+    } else if (name == "READY") {
+      (*phases)[name] = event["ts"].toDouble() / 1000.0;
+    }
+  }
+  return phases->contains("READY");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_startup_phases");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Crankshaft core startup phase benchmark");
+  parser.addHelpOption();
+  QCommandLineOption coreOption("core", "Path to crankshaft-core", "path",
+                                "build/core/crankshaft-core");
+  QCommandLineOption iterationsOption("iterations", "Number of launches", "n", "10");
+  QCommandLineOption portOption("port", "First WebSocket port to use", "port", "19080");
+  QCommandLineOption timeoutOption("timeout-ms", "Per-launch READY timeout", "ms", "30000");
+  QCommandLineOption baselineOption("baseline", "Baseline JSON to compare against", "file");
+  QCommandLineOption writeBaselineOption("write-baseline", "Write results as a baseline", "file");
+  QCommandLineOption thresholdOption("threshold-pct", "Allowed median regression in percent",
+                                     "pct", "20");
+  QCommandLineOption slackOption("min-slack-ms", "Regressions smaller than this are ignored", "ms",
+                                 "2");
+  parser.addOptions({coreOption, iterationsOption, portOption, timeoutOption, baselineOption,
+                     writeBaselineOption, thresholdOption, slackOption});
+  parser.process(app);
+
+  const QString corePath = parser.value(coreOption);
+  const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+  const quint16 firstPort = static_cast<quint16>(parser.value(portOption).toUInt());
+  const int timeoutMs = parser.value(timeoutOption).toInt();
+
+  if (!QFile::exists(corePath)) {
+    err << "Core binary not found: " << corePath << Qt::endl;
+    return 2;
+  }
+
+  QMap<QString, QList<double>> samples;
+  for (int i = 0; i < iterations; ++i) {
+    QMap<QString, double> phases;
+    // A distinct port per run avoids TIME_WAIT collisions between launches
+    if (!runOnce(corePath, static_cast<quint16>(firstPort + i), timeoutMs, &phases)) {
+      err << "Iteration " << i + 1 << " failed" << Qt::endl;
+      return 2;
+    }
+    for (auto it = phases.constBegin(); it != phases.constEnd(); ++it) {
+      samples[it.key()].append(it.value());
+    }
+    out << "Iteration " << i + 1 << "/" << iterations << ": READY at " << phases.value("READY")
+        << "ms" << Qt::endl;
+  }
+
+  QMap<QString, Stats> results;
+  for (auto it = samples.constBegin(); it != samples.constEnd(); ++it) {
+    results.insert(it.key(), computeStats(it.value()));
+  }
+
+  out << Qt::endl
+      << QString("%1 %2 %3 %4 %5 %6")
+             .arg("Phase", -56)
+             .arg("n", 4)
+             .arg("min", 9)
+             .arg("median", 9)
+             .arg("p95", 9)
+             .arg("max", 9)
+      << Qt::endl;
+  for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+    out << QString("%1 %2 %3 %4 %5 %6")
+               .arg(it.key().left(56), -56)
+               .arg(samples.value(it.key()).size(), 4)
+               .arg(it->min, 9, 'f', 2)
+               .arg(it->median, 9, 'f', 2)
+               .arg(it->p95, 9, 'f', 2)
+               .arg(it->max, 9, 'f', 2)
+        << Qt::endl;
+  }
+
+  if (parser.isSet(writeBaselineOption)) {
+    QJsonObject phases;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+      phases[it.key()] = QJsonObject{{"median", it->median}, {"p95", it->p95}};
+    }
+    const QJsonObject baseline{{"iterations", iterations}, {"phases", phases}};
+    if (!writeFile(parser.value(writeBaselineOption), QJsonDocument(baseline).toJson())) {
+      err << "Failed to write baseline " << parser.value(writeBaselineOption) << Qt::endl;
+      return 2;
+    }
+  }
+
+  if (!parser.isSet(baselineOption)) return 0;
+
+  QFile baselineFile(parser.value(baselineOption));
+  if (!baselineFile.open(QIODevice::ReadOnly)) {
+    err << "Failed to read baseline " << baselineFile.fileName() << Qt::endl;
+    return 2;
+  }
+  const QJsonObject baseline =
+      QJsonDocument::fromJson(baselineFile.readAll()).object()["phases"].toObject();
+  const double thresholdPct = parser.value(thresholdOption).toDouble();
+  const double slackMs = parser.value(slackOption).toDouble();
+
+  int regressions = 0;
+  out << Qt::endl;
+  for (auto it = baseline.constBegin(); it != baseline.constEnd(); ++it) {
+    if (!results.contains(it.key())) {
+      out << "MISSING  " << it.key() << Qt::endl;
+      continue;
+    }
+    const double before = it.value().toObject()["median"].toDouble();
+    const double now = results.value(it.key()).median;
+    const double allowed = qMax(before * (1.0 + thresholdPct / 100.0), before + slackMs);
+    if (now > allowed) {
+      ++regressions;
+      out << QString("REGRESSED %1: median %2ms > %3ms (baseline %4ms)")
+                 .arg(it.key())
+                 .arg(now, 0, 'f', 2)
+                 .arg(allowed, 0, 'f', 2)
+                 .arg(before, 0, 'f', 2)
+          << Qt::endl;
+    }
+  }
+
+  if (regressions > 0) {
+    out << regressions << " phase(s) regressed beyond " << thresholdPct << "%" << Qt::endl;
+    return 1;
+  }
+  out << "No phase regressed beyond " << thresholdPct << "% / " << slackMs << "ms" << Qt::endl;
+  return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// UART throughput benchmark
+//
+// Streams data into a UARTTransport through a pseudo-terminal, paced at the
+// byte rate of a real line (baud / 10 for 8N1), and reports the rate
+// received, read wakeups per second and process CPU time per second. Each
+// baud rate runs once with lowLatency (a wakeup per arrival) and once with
+// read batching. Ptys ignore the baud rate itself, so the pacing thread
+// stands in for the line. Pass --port to read a real adapter instead, with
+// the far end looped back or streaming.
+
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+
+#include "hal/transport/UARTTransport.h"
+
+namespace {
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+qint64 processCpuNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+struct Result {
+  quint64 bytes{0};
+  quint64 wakeups{0};
+  double seconds{0};
+  double cpuPercent{0};
+};
+
+// Writes to the pty master at the line's byte rate, 1 ms at a time
+class PacedWriter : public QThread {
+ public:
+  PacedWriter(int fd, int baudRate) : m_fd(fd), m_bytesPerSecond(baudRate / 10) {}
+
+  void stop() {
+    m_stop = true;
+  }
+
+ protected:
+  void run() override {
+    QByteArray chunk;
+    QElapsedTimer clock;
+    clock.start();
+    qint64 sent = 0;
+    while (!m_stop) {
+      const qint64 due = clock.nsecsElapsed() * m_bytesPerSecond / 1000000000LL;
+      if (due > sent) {
+        chunk.fill('U', static_cast<int>(due - sent));
+        const ssize_t count = ::write(m_fd, chunk.constData(), chunk.size());
+        if (count > 0) {
+          sent += count;
+        }
+      }
+      QThread::usleep(1000);
+    }
+  }
+
+ private:
+  int m_fd;
+  qint64 m_bytesPerSecond;
+  std::atomic<bool> m_stop{false};
+};
+
+Result run(const QString& port, int masterFd, int baudRate, bool lowLatency, int batchMs,
+           int seconds) {
+  UARTTransport uart(port);
+  uart.setBaudRate(baudRate);
+  uart.configure("readBatchIntervalMs", batchMs);
+  uart.setLowLatency(lowLatency);
+  if (!uart.open()) {
+    err << "Cannot open " << port << Qt::endl;
+    return Result();
+  }
+
+  Result result;
+  QObject::connect(&uart, &Transport::dataReceived, [&]() {
+    result.bytes += static_cast<quint64>(uart.read().size());
+  });
+
+  PacedWriter writer(masterFd, baudRate);
+  if (masterFd >= 0) {
+    writer.start();
+  }
+  QElapsedTimer clock;
+  const qint64 cpuStart = processCpuNs();
+  clock.start();
+  QEventLoop loop;
+  QTimer::singleShot(seconds * 1000, &loop, &QEventLoop::quit);
+  loop.exec();
+  result.seconds = clock.nsecsElapsed() / 1e9;
+  result.cpuPercent = 100.0 * (processCpuNs() - cpuStart) / clock.nsecsElapsed();
+  writer.stop();
+  writer.wait();
+
+  result.wakeups = uart.stats().readWakeups;
+  uart.close();
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_uart_throughput");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("UART transport throughput benchmark");
+  parser.addHelpOption();
+  QCommandLineOption portOption("port", "Real serial port instead of a pty", "path");
+  QCommandLineOption secondsOption("seconds", "Duration of each run", "s", "3");
+  QCommandLineOption batchOption("batch-ms", "readBatchIntervalMs for batched runs", "ms", "5");
+  parser.addOptions({portOption, secondsOption, batchOption});
+  parser.process(app);
+
+  const int seconds = qMax(1, parser.value(secondsOption).toInt());
+  const int batchMs = qMax(1, parser.value(batchOption).toInt());
+
+  int master = -1;
+  QString port = parser.value(portOption);
+  if (port.isEmpty()) {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+      err << "Cannot create a pseudo-terminal" << Qt::endl;
+      return 2;
+    }
+    termios tio{};
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+    port = QString::fromLocal8Bit(ptsname(master));
+  }
+
+  out << QString("%1 %2 %3 %4 %5 %6")
+             .arg("baud", 8)
+             .arg("mode", -12)
+             .arg("bytes/s", 10)
+             .arg("of line", 8)
+             .arg("wakeups/s", 10)
+             .arg("cpu %", 7)
+      << Qt::endl;
+
+  for (int baudRate : {115200, 921600}) {
+    for (bool lowLatency : {true, false}) {
+      const Result result = run(port, master, baudRate, lowLatency, batchMs, seconds);
+      if (result.seconds <= 0) {
+        return 1;
+      }
+      const double bytesPerSecond = result.bytes / result.seconds;
+      out << QString("%1 %2 %3 %4 %5 %6")
+                 .arg(baudRate, 8)
+                 .arg(lowLatency ? "low latency" : QString("batch %1ms").arg(batchMs), -12)
+                 .arg(bytesPerSecond, 10, 'f', 0)
+                 .arg(QString("%1%").arg(100.0 * bytesPerSecond / (baudRate / 10), 0, 'f', 1),
+                      8)
+                 .arg(result.wakeups / result.seconds, 10, 'f', 1)
+                 .arg(result.cpuPercent, 7, 'f', 2)
+          << Qt::endl;
+    }
+  }
+
+  if (master >= 0) {
+    ::close(master);
+  }
+  return 0;
+}
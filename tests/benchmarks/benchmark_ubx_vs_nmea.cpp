@@ -0,0 +1,229 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// UBX vs NMEA benchmark
+//
+// Builds the same sequence of fixes twice: as a u-blox NMEA stream (RMC,
+// VTG, GGA, two GSA and two GSV per epoch) and as UBX (NAV-DOP and NAV-PVT
+// per epoch), then decodes each through the parsers GPSDevice uses, in
+// transport-sized chunks. Reports bytes per fix, the fix rate a serial line
+// can carry at 115200 and 921600 baud, decoded fixes per second and CPU time
+// per fix.
+
+#include <time.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "hal/functional/NmeaParser.h"
+#include "hal/functional/UbxParser.h"
+
+namespace {
+
+QTextStream out(stdout);
+
+qint64 threadCpuNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+QByteArray nmeaCapture(int epochs) {
+  QByteArray capture;
+  for (int i = 0; i < epochs; ++i) {
+    const int tenths = i % 864000;
+    const QByteArray time = QString("%1%2%3.%4")
+                                .arg(tenths / 36000, 2, 10, QChar('0'))
+                                .arg(tenths / 600 % 60, 2, 10, QChar('0'))
+                                .arg(tenths / 10 % 60, 2, 10, QChar('0'))
+                                .arg(tenths % 10)
+                                .toLatin1();
+    const QByteArray latitude = QByteArray::number(4807.038 + (i % 1000) * 0.0001, 'f', 5);
+    capture += sentence("GNRMC," + time + ",A," + latitude +
+                        ",N,01131.00000,E,022.4,084.4,181026,,,A");
+    capture += sentence("GNVTG,084.4,T,,M,022.4,N,041.5,K,A");
+    capture += sentence("GNGGA," + time + "," + latitude +
+                        ",N,01131.00000,E,1,12,0.9,545.4,M,46.9,M,,");
+    capture += sentence("GNGSA,A,3,01,02,03,04,05,06,07,,,,,,1.5,0.9,1.2");
+    capture += sentence("GNGSA,A,3,65,66,67,68,69,,,,,,,,1.5,0.9,1.2");
+    capture += sentence("GPGSV,2,1,07,01,40,083,46,02,17,308,41,03,07,344,39,04,55,120,44");
+    capture += sentence("GLGSV,2,1,05,65,30,120,40,66,12,200,35,67,45,010,42,68,22,270,38");
+  }
+  return capture;
+}
+
+void putU4(QByteArray& payload, int offset, quint32 value) {
+  for (int i = 0; i < 4; ++i) {
+    payload[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+QByteArray ubxCapture(int epochs) {
+  QByteArray capture;
+  QByteArray pvt(92, '\0');
+  QByteArray dop(18, '\0');
+  for (int i = 0; i < epochs; ++i) {
+    const quint32 iTow = 100u * static_cast<quint32>(i);
+    putU4(dop, 0, iTow);
+    dop[6] = static_cast<char>(150);
+    dop[10] = static_cast<char>(120);
+    dop[12] = static_cast<char>(90);
+    putU4(pvt, 0, iTow);
+    pvt[4] = static_cast<char>(0xEA);
+    pvt[5] = 0x07;
+    pvt[11] = 0x07;
+    pvt[20] = 3;
+    pvt[21] = 0x01;
+    pvt[23] = 12;
+    putU4(pvt, 24, 115166666);
+    putU4(pvt, 28, static_cast<quint32>(481173000 + i % 1000 * 17));
+    putU4(pvt, 36, 545400);
+    putU4(pvt, 60, 11528);
+    putU4(pvt, 64, 8440000);
+    capture += UbxParser::frame(UbxParser::kClassNav, UbxParser::kIdNavDop, dop);
+    capture += UbxParser::frame(UbxParser::kClassNav, UbxParser::kIdNavPvt, pvt);
+  }
+  return capture;
+}
+
+struct Result {
+  quint64 fixes{0};
+  double cpuNsPerFix{0};
+  double checksum{0};
+};
+
+Result runNmea(const QByteArray& capture, int chunk, int passes) {
+  Result result;
+  NmeaParser parser;
+  NmeaParser::Epoch epochs[16];
+  const qint64 start = threadCpuNs();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (qsizetype offset = 0; offset < capture.size(); offset += chunk) {
+      parser.append(capture.constData() + offset,
+                    static_cast<int>(qMin<qsizetype>(chunk, capture.size() - offset)));
+      int count = 0;
+      while ((count = parser.parse(epochs, 16)) > 0) {
+        for (int i = 0; i < count; ++i) {
+          result.checksum += epochs[i].latitude;
+        }
+        result.fixes += static_cast<quint64>(count);
+      }
+    }
+  }
+  result.cpuNsPerFix = static_cast<double>(threadCpuNs() - start) / qMax<quint64>(1, result.fixes);
+  return result;
+}
+
+Result runUbx(const QByteArray& capture, int chunk, int passes) {
+  Result result;
+  UbxParser parser;
+  UbxParser::NavPvt pvt;
+  UbxParser::NavDop dop;
+  char text[4096];
+  const qint64 start = threadCpuNs();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (qsizetype offset = 0; offset < capture.size(); offset += chunk) {
+      const char* bytes = capture.constData() + offset;
+      int size = static_cast<int>(qMin<qsizetype>(chunk, capture.size() - offset));
+      int textSize = 0;
+      while (size > 0) {
+        bool ready = false;
+        const int used = parser.feed(bytes, size, text, &textSize, &ready);
+        bytes += used;
+        size -= used;
+        if (!ready) {
+          continue;
+        }
+        if (UbxParser::decodeNavPvt(parser.message(), &pvt)) {
+          result.checksum += pvt.latitude;
+          ++result.fixes;
+        } else if (UbxParser::decodeNavDop(parser.message(), &dop)) {
+          result.checksum += dop.hdop;
+        }
+      }
+    }
+  }
+  result.cpuNsPerFix = static_cast<double>(threadCpuNs() - start) / qMax<quint64>(1, result.fixes);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("benchmark_ubx_vs_nmea");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("GPS fix decoding cost: UBX NAV-PVT vs NMEA");
+  parser.addHelpOption();
+  QCommandLineOption epochsOption("epochs", "Fixes in each capture", "n", "20000");
+  QCommandLineOption passesOption("passes", "Times each capture is decoded", "n", "20");
+  QCommandLineOption chunkOption("chunk", "Bytes per simulated transport read", "bytes", "256");
+  parser.addOptions({epochsOption, passesOption, chunkOption});
+  parser.process(app);
+
+  const int epochs = qMax(1, parser.value(epochsOption).toInt());
+  const int passes = qMax(1, parser.value(passesOption).toInt());
+  const int chunk = qBound(1, parser.value(chunkOption).toInt(), 4096);
+
+  const QByteArray nmea = nmeaCapture(epochs);
+  const QByteArray ubx = ubxCapture(epochs);
+  const Result nmeaResult = runNmea(nmea, chunk, passes);
+  const Result ubxResult = runUbx(ubx, chunk, passes);
+
+  out << QString("%1 %2 %3 %4 %5 %6")
+             .arg("protocol", -9)
+             .arg("bytes/fix", 10)
+             .arg("Hz@115200", 10)
+             .arg("Hz@921600", 10)
+             .arg("fixes/s", 12)
+             .arg("cpu ns/fix", 11)
+      << Qt::endl;
+  const struct {
+    const char* name;
+    const QByteArray& capture;
+    const Result& result;
+  } rows[] = {{"NMEA", nmea, nmeaResult}, {"UBX", ubx, ubxResult}};
+  for (const auto& row : rows) {
+    const double bytesPerFix = static_cast<double>(row.capture.size()) / epochs;
+    out << QString("%1 %2 %3 %4 %5 %6")
+               .arg(row.name, -9)
+               .arg(bytesPerFix, 10, 'f', 1)
+               .arg(11520.0 / bytesPerFix, 10, 'f', 1)  // 8N1: 10 bits per byte
+               .arg(92160.0 / bytesPerFix, 10, 'f', 1)
+               .arg(1e9 / qMax(row.result.cpuNsPerFix, 1.0), 12, 'f', 0)
+               .arg(row.result.cpuNsPerFix, 11, 'f', 1)
+        << Qt::endl;
+  }
+  out << QString("decoded %1 NMEA and %2 UBX fixes")
+             .arg(nmeaResult.fixes)
+             .arg(ubxResult.fixes)
+      << Qt::endl;
+  return 0;
+}
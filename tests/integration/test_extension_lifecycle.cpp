@@ -84,7 +84,7 @@ private slots:
         manifest.insert(QStringLiteral("id"), QStringLiteral("test.start.sample"));
         manifest.insert(QStringLiteral("name"), QStringLiteral("Test Start"));
         manifest.insert(QStringLiteral("version"), QStringLiteral("1.0.0"));
-        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep"));
+        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep 30"));
         
         QJsonArray permissions;
         permissions.append(QStringLiteral("media.source"));
@@ -120,7 +120,7 @@ private slots:
         manifest.insert(QStringLiteral("id"), QStringLiteral("test.stop.sample"));
         manifest.insert(QStringLiteral("name"), QStringLiteral("Test Stop"));
         manifest.insert(QStringLiteral("version"), QStringLiteral("1.0.0"));
-        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep"));
+        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep 30"));
         
         QJsonArray permissions;
         permissions.append(QStringLiteral("ui.tile"));
@@ -139,7 +139,8 @@ private slots:
         
         // Verify no error
         QVERIFY(result.isEmpty());
-        // Note: stopSpy may not fire immediately due to process termination timing
+        // The stop is asynchronous: the exit is reported once the process is reaped
+        QTRY_COMPARE_WITH_TIMEOUT(stopSpy.count(), 1, 2000);
         
         // Verify extension is stopped
         QJsonObject info = m_extensionManager->getExtensionInfo(
@@ -153,7 +154,7 @@ private slots:
         manifest.insert(QStringLiteral("id"), QStringLiteral("test.restart.sample"));
         manifest.insert(QStringLiteral("name"), QStringLiteral("Test Restart"));
         manifest.insert(QStringLiteral("version"), QStringLiteral("1.0.0"));
-        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep"));
+        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep 30"));
         
         QJsonArray permissions;
         manifest.insert(QStringLiteral("permissions"), permissions);
@@ -220,6 +221,33 @@ private slots:
         QVERIFY(!QDir(installDir).exists());
     }
 
+    void testUninstallRunningExtension() {
+        QJsonObject manifest;
+        manifest.insert(QStringLiteral("id"), QStringLiteral("test.uninstall.running"));
+        manifest.insert(QStringLiteral("name"), QStringLiteral("Test Uninstall Running"));
+        manifest.insert(QStringLiteral("version"), QStringLiteral("1.0.0"));
+        manifest.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep 30"));
+        manifest.insert(QStringLiteral("permissions"), QJsonArray());
+        QString manifestJson =
+            QString::fromUtf8(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+
+        const QString id = QStringLiteral("test.uninstall.running");
+        QVERIFY(m_extensionManager->installExtension(manifestJson, QString()).isEmpty());
+        QVERIFY(m_extensionManager->startExtension(id).isEmpty());
+
+        // The files go only after the process has exited
+        QSignalSpy stopSpy(m_extensionManager, &ExtensionManager::extensionStopped);
+        QSignalSpy uninstallSpy(m_extensionManager, &ExtensionManager::extensionUninstalled);
+        QVERIFY(m_extensionManager->uninstallExtension(id).isEmpty());
+        QVERIFY(!m_extensionManager->startExtension(id).isEmpty());
+        QTRY_COMPARE_WITH_TIMEOUT(uninstallSpy.count(), 1, 5000);
+        QCOMPARE(stopSpy.count(), 1);
+
+        QString installDir = m_tempDir->path() + QStringLiteral("/") + id;
+        QVERIFY(!QDir(installDir).exists());
+        QVERIFY(m_extensionManager->getExtensionInfo(id).isEmpty());
+    }
+
     void testPermissionChecking() {
         // Create extension with specific permissions
         QJsonObject manifest;
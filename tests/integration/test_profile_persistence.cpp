@@ -0,0 +1,244 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QString>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "../core/services/profile/ProfileManager.h"
+
+class TestProfilePersistence : public QObject {
+  Q_OBJECT
+
+ private:
+  QString hostProfilesPath(const QTemporaryDir& dir) const {
+    return QDir(dir.path()).filePath(QStringLiteral("host_profiles.json"));
+  }
+
+  QString vehicleProfilesPath(const QTemporaryDir& dir) const {
+    return QDir(dir.path()).filePath(QStringLiteral("vehicle_profiles.json"));
+  }
+
+ private slots:
+  // Test 1: Defaults are written synchronously on first start
+  void testDefaultProfilesWritten() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    ProfileManager manager(dir.path());
+    QVERIFY(QFileInfo::exists(hostProfilesPath(dir)));
+    QVERIFY(QFileInfo::exists(vehicleProfilesPath(dir)));
+    QVERIFY(!manager.hasPendingChanges());
+  }
+
+  // Test 2: A burst of mutations is coalesced and not written immediately
+  void testBurstIsCoalesced() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    ProfileManager manager(dir.path());
+    manager.setSaveDelay(200);
+    const QString profileId = manager.getActiveHostProfile().id;
+    QVERIFY(!profileId.isEmpty());
+    const QDateTime writtenBefore = QFileInfo(hostProfilesPath(dir)).lastModified();
+
+    for (int i = 0; i < 100; ++i) {
+      DeviceConfig device;
+      device.name = QStringLiteral("BurstDevice%1").arg(i);
+      device.type = QStringLiteral("CAN");
+      QVERIFY(manager.addDeviceToHostProfile(profileId, device));
+    }
+
+    // Still inside the coalescing window: nothing has hit the disk yet
+    QVERIFY(manager.hasPendingChanges());
+    QCOMPARE(QFileInfo(hostProfilesPath(dir)).lastModified(), writtenBefore);
+
+    QTRY_VERIFY_WITH_TIMEOUT(!manager.hasPendingChanges(), 2000);
+
+    // Wait for the background writer, then verify via a fresh instance
+    QVERIFY(manager.flush());
+    ProfileManager reloaded(dir.path());
+    QCOMPARE(reloaded.getProfileDevices(profileId).size(),
+             manager.getProfileDevices(profileId).size());
+  }
+
+  // Test 3: flush() persists pending changes synchronously
+  void testFlushWritesImmediately() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    ProfileManager manager(dir.path());
+    manager.setSaveDelay(60000);
+    VehicleProfile profile;
+    profile.name = QStringLiteral("Flush Test Vehicle");
+    QVERIFY(manager.createVehicleProfile(profile));
+    QVERIFY(manager.hasPendingChanges());
+
+    QVERIFY(manager.flush());
+    QVERIFY(!manager.hasPendingChanges());
+
+    ProfileManager reloaded(dir.path());
+    bool found = false;
+    for (const auto& vehicle : reloaded.getAllVehicleProfiles()) {
+      found = found || vehicle.name == profile.name;
+    }
+    QVERIFY(found);
+  }
+
+  // Test 4: Destruction flushes pending changes
+  void testDestructorFlushes() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString profileId;
+    {
+      ProfileManager manager(dir.path());
+      manager.setSaveDelay(60000);
+      HostProfile profile;
+      profile.name = QStringLiteral("Shutdown Host");
+      QVERIFY(manager.createHostProfile(profile));
+      for (const auto& host : manager.getAllHostProfiles()) {
+        if (host.name == profile.name) profileId = host.id;
+      }
+    }
+
+    ProfileManager reloaded(dir.path());
+    QCOMPARE(reloaded.getHostProfile(profileId).name, QStringLiteral("Shutdown Host"));
+  }
+
+  // Test 5: Device activation policies survive a save/load round trip
+  void testActivationPolicyRoundTrip() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString profileId;
+    {
+      ProfileManager manager(dir.path());
+      profileId = manager.getActiveHostProfile().id;
+      DeviceConfig device;
+      device.name = QStringLiteral("LazyDevice");
+      device.type = QStringLiteral("Bluetooth");
+      device.activation = DeviceConfig::ActivationPolicy::Deferred;
+      device.activationDelayMs = 1500;
+      QVERIFY(manager.addDeviceToHostProfile(profileId, device));
+    }
+
+    ProfileManager reloaded(dir.path());
+    bool found = false;
+    for (const auto& device : reloaded.getProfileDevices(profileId)) {
+      if (device.name != QStringLiteral("LazyDevice")) continue;
+      found = true;
+      QVERIFY(device.activation == DeviceConfig::ActivationPolicy::Deferred);
+      QCOMPARE(device.activationDelayMs, 1500);
+    }
+    QVERIFY(found);
+    QVERIFY(DeviceConfig::activationPolicyFromString(QStringLiteral("on-demand")) ==
+            DeviceConfig::ActivationPolicy::OnDemand);
+    QVERIFY(DeviceConfig::activationPolicyFromString(QStringLiteral("bogus")) ==
+            DeviceConfig::ActivationPolicy::Eager);
+  }
+
+  // Test 6: Atomic writes leave no temporary files behind
+  void testNoTemporaryFilesLeft() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+      ProfileManager manager(dir.path());
+      const QString profileId = manager.getActiveHostProfile().id;
+      for (int i = 0; i < 10; ++i) {
+        QVERIFY(manager.setDeviceEnabled(profileId, QStringLiteral("AndroidAuto"), i % 2 == 0));
+        QVERIFY(manager.flush());
+      }
+    }
+
+    const QStringList entries = QDir(dir.path()).entryList(QDir::Files | QDir::Hidden);
+    QCOMPARE(entries.size(), 2);
+    QVERIFY(entries.contains(QStringLiteral("host_profiles.json")));
+    QVERIFY(entries.contains(QStringLiteral("vehicle_profiles.json")));
+  }
+
+  // Test 7: A failed write is reported and the changes stay pending
+  void testFailedWriteIsReported() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    ProfileManager manager(dir.path());
+    manager.setSaveDelay(0);
+    QSignalSpy failures(&manager, &ProfileManager::saveFailed);
+    const QString profileId = manager.getActiveHostProfile().id;
+
+    // A directory in the file's place makes the rename fail
+    QVERIFY(QFile::remove(hostProfilesPath(dir)));
+    QVERIFY(QDir(dir.path()).mkdir(QStringLiteral("host_profiles.json")));
+
+    // Background write
+    QVERIFY(manager.setDeviceEnabled(profileId, QStringLiteral("AndroidAuto"), false));
+    QTRY_COMPARE(failures.count(), 1);
+    QCOMPARE(failures.first().first().toStringList(), QStringList{hostProfilesPath(dir)});
+    QVERIFY(manager.hasPendingChanges());
+
+    // flush() retries and says it failed
+    QVERIFY(!manager.flush());
+    QCOMPARE(failures.count(), 2);
+    QVERIFY(manager.hasPendingChanges());
+
+    QVERIFY(QDir(dir.path()).rmdir(QStringLiteral("host_profiles.json")));
+    QVERIFY(manager.flush());
+    QVERIFY(!manager.hasPendingChanges());
+    ProfileManager reloaded(dir.path());
+    for (const auto& device : reloaded.getProfileDevices(profileId)) {
+      if (device.name == QStringLiteral("AndroidAuto")) QVERIFY(!device.enabled);
+    }
+  }
+
+  // Test 8: A failed background write is retried without another mutation
+  void testFailedWriteIsRetried() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    ProfileManager manager(dir.path());
+    manager.setSaveDelay(0);
+    QSignalSpy failures(&manager, &ProfileManager::saveFailed);
+    const QString profileId = manager.getActiveHostProfile().id;
+
+    QVERIFY(QFile::remove(hostProfilesPath(dir)));
+    QVERIFY(QDir(dir.path()).mkdir(QStringLiteral("host_profiles.json")));
+    QVERIFY(manager.setDeviceEnabled(profileId, QStringLiteral("AndroidAuto"), false));
+    QTRY_COMPARE(failures.count(), 1);
+
+    // The retry waits for the backoff, then writes once the path is usable
+    QVERIFY(QDir(dir.path()).rmdir(QStringLiteral("host_profiles.json")));
+    QVERIFY(manager.hasPendingChanges());
+    QTRY_VERIFY_WITH_TIMEOUT(QFileInfo(hostProfilesPath(dir)).isFile(), 5000);
+    QVERIFY(manager.flush());
+    QCOMPARE(failures.count(), 1);
+    ProfileManager reloaded(dir.path());
+    for (const auto& device : reloaded.getProfileDevices(profileId)) {
+      if (device.name == QStringLiteral("AndroidAuto")) QVERIFY(!device.enabled);
+    }
+  }
+};
+
+QTEST_MAIN(TestProfilePersistence)
+#include "test_profile_persistence.moc"
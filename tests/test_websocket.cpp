@@ -18,16 +18,42 @@
  */
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTest>
+#include <QThread>
+#include <QTimer>
 #include <QWebSocket>
 #include <catch2/catch_all.hpp>
 
 #include "services/eventbus/EventBus.h"
+#include "services/profile/ProfileManager.h"
+#include "services/service_manager/ServiceManager.h"
 #include "services/websocket/WebSocketServer.h"
 
+namespace {
+
+// Make a profile holding only the given mock device and activate it
+void activateProfileWith(ProfileManager& profiles, const QString& name,
+                         DeviceConfig::ActivationPolicy activation, int delayMs = 0) {
+  DeviceConfig device;
+  device.name = name;
+  device.type = name;
+  device.activation = activation;
+  device.activationDelayMs = delayMs;
+  HostProfile profile;
+  profile.id = "activation-test";
+  profile.name = "Activation test";
+  profile.devices = {device};
+  REQUIRE(profiles.createHostProfile(profile));
+  REQUIRE(profiles.setActiveHostProfile(profile.id));
+}
+
+}  // namespace
+
 TEST_CASE("WebSocketServer starts and stops", "[websocket]") {
   int argc = 0;
   char* argv[] = {nullptr};
@@ -170,3 +196,68 @@ TEST_CASE("WebSocketServer multiple clients", "[websocket]") {
   client1.close();
   client2.close();
 }
+
+TEST_CASE("ServiceManager starts on-demand services on first use of their topics", "[services]") {
+  int argc = 0;
+  char* argv[] = {nullptr};
+  QCoreApplication app(argc, argv);
+
+  QTemporaryDir dir;
+  REQUIRE(dir.isValid());
+  ProfileManager profiles(dir.path());
+  activateProfileWith(profiles, "Bluetooth", DeviceConfig::ActivationPolicy::OnDemand);
+  ServiceManager manager(&profiles);
+  QSignalSpy ready(&manager, &ServiceManager::serviceReady);
+
+  manager.startAllServices();
+  REQUIRE(manager.getPendingServices() == QStringList{"Bluetooth"});
+
+  // Root wildcards and other namespaces leave it alone
+  REQUIRE_FALSE(manager.activateForTopic("#"));
+  REQUIRE_FALSE(manager.activateForTopic("*"));
+  REQUIRE_FALSE(manager.activateForTopic("android-auto/status"));
+  REQUIRE_FALSE(manager.activateForTopic("bluetoothx/status"));
+  QTest::qWait(100);
+  REQUIRE(ready.isEmpty());
+  REQUIRE(manager.getPendingServices() == QStringList{"Bluetooth"});
+
+  // A mock service has no prepare step, so it settles before this returns
+  REQUIRE(manager.activateForTopic("bluetooth/devices/#"));
+  REQUIRE(ready.count() == 1);
+  REQUIRE(ready.first().first().toString() == QString("Bluetooth"));
+  REQUIRE(manager.getPendingServices().isEmpty());
+  REQUIRE_FALSE(manager.activateForTopic("bluetooth/devices"));
+}
+
+TEST_CASE("ServiceManager starts deferred services after their delay once idle", "[services]") {
+  int argc = 0;
+  char* argv[] = {nullptr};
+  QCoreApplication app(argc, argv);
+
+  QTemporaryDir dir;
+  REQUIRE(dir.isValid());
+  ProfileManager profiles(dir.path());
+  activateProfileWith(profiles, "WiFi", DeviceConfig::ActivationPolicy::Deferred, 100);
+  ServiceManager manager(&profiles);
+  QSignalSpy ready(&manager, &ServiceManager::serviceReady);
+
+  // Keep the main thread busy well past the delay
+  QTimer hog;
+  hog.setInterval(0);
+  QObject::connect(&hog, &QTimer::timeout, []() { QThread::msleep(100); });
+  hog.start();
+
+  QElapsedTimer clock;
+  clock.start();
+  manager.startAllServices();
+  REQUIRE(manager.getPendingServices() == QStringList{"WiFi"});
+  QTest::qWait(600);
+  REQUIRE(ready.isEmpty());
+
+  hog.stop();
+  REQUIRE(QTest::qWaitFor([&ready]() { return ready.count() == 1; }, 2000));
+  REQUIRE(ready.first().first().toString() == QString("WiFi"));
+  REQUIRE(manager.getPendingServices().isEmpty());
+  REQUIRE(clock.elapsed() >= 600 + ServiceManager::kIdleProbeIntervalMs *
+                                       ServiceManager::kIdleProbesRequired);
+}
@@ -0,0 +1,542 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+#include <QTimeZone>
+#include <cstring>
+
+#include "../core/hal/functional/CANDevice.h"
+#include "../core/hal/functional/GPSDevice.h"
+#include "../core/hal/transport/ReplayTransport.h"
+#include "../core/hal/transport/UARTTransport.h"
+#include "../core/services/android_auto/ReplayAndroidAutoService.h"
+#include "../core/services/diagnostics/CaptureReader.h"
+#include "../core/services/diagnostics/CaptureWriter.h"
+
+using crankshaft::diagnostics::CaptureReader;
+using crankshaft::diagnostics::CaptureWriter;
+namespace capture = crankshaft::diagnostics::capture;
+
+namespace {
+
+// Master side of a pseudo-terminal; the transport opens the slave
+class PtyPair {
+ public:
+  PtyPair() {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_master >= 0 && grantpt(m_master) == 0 && unlockpt(m_master) == 0) {
+      m_slavePath = QString::fromLocal8Bit(ptsname(m_master));
+      termios tio{};
+      tcgetattr(m_master, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(m_master, TCSANOW, &tio);
+    }
+  }
+  ~PtyPair() {
+    if (m_master >= 0) {
+      ::close(m_master);
+    }
+  }
+
+  bool isValid() const {
+    return !m_slavePath.isEmpty();
+  }
+  QString slavePath() const {
+    return m_slavePath;
+  }
+
+  void send(const QByteArray& data) {
+    QCOMPARE(::write(m_master, data.constData(), data.size()), ssize_t(data.size()));
+  }
+
+ private:
+  int m_master{-1};
+  QString m_slavePath;
+};
+
+std::span<const char> bytes(const QByteArray& data) {
+  return {data.constData(), static_cast<size_t>(data.size())};
+}
+
+QByteArray payload(int seed, int size) {
+  QByteArray data(size, Qt::Uninitialized);
+  for (int i = 0; i < size; ++i) {
+    data[i] = static_cast<char>(seed * 31 + i);
+  }
+  return data;
+}
+
+// "$<body>*hh\r\n" with the checksum filled in
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+QByteArray cycle(const QByteArray& time) {
+  return sentence("GNRMC," + time + ",A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A") +
+         sentence("GNGGA," + time + ",4807.038,N,01131.000,E,1,12,0.9,545.4,M,46.9,M,,") +
+         sentence("GNGSA,A,3,01,02,03,,,,,,,,,,1.5,0.9,1.2");
+}
+
+}  // namespace
+
+class TestCaptureReplay : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testRoundTrip() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("session.cap");
+
+    CaptureWriter writer;
+    QVERIFY(writer.open(path, 4096));
+    const int uart = writer.addStream(capture::StreamKind::Bytes, "uart", {115200, 0, 0, 0});
+    const int video = writer.addStream(capture::StreamKind::Video, "aa.video", {800, 480, 30, 0});
+    QCOMPARE(uart, 0);
+    QCOMPARE(video, 1);
+
+    QList<QByteArray> expected;
+    QList<int> streams;
+    for (int i = 0; i < 200; ++i) {
+      const int stream = i % 3 == 0 ? video : uart;
+      expected.append(payload(i, stream == video ? 100 + i * 2 : i % 50));
+      streams.append(stream);
+      QVERIFY(writer.append(stream, bytes(expected.last())));
+    }
+    // Larger than a chunk, and in two parts like a read that wrapped a ring
+    const QByteArray big = payload(999, 10000);
+    QVERIFY(writer.append(video, bytes(big.left(6000)), bytes(big.mid(6000))));
+    expected.append(big);
+    streams.append(video);
+    QVERIFY(!writer.append(7, bytes(big)));  // never declared
+    writer.close();
+    QVERIFY(!writer.append(uart, bytes(big)));
+    QCOMPARE(writer.stats().records, quint64(expected.size()));
+    QCOMPARE(writer.stats().droppedRecords, quint64(0));
+
+    CaptureReader reader;
+    QVERIFY(reader.open(path));
+    QVERIFY(reader.hadIndex());
+    QVERIFY(reader.chunks().size() > 5);  // fewer than the writer will queue
+    QCOMPARE(reader.chunks().size(), qsizetype(writer.stats().chunks));
+    QCOMPARE(reader.streams().size(), 2);
+    QCOMPARE(reader.streamId("aa.video"), video);
+    QCOMPARE(reader.streamId("aa.audio"), -1);
+    const capture::StreamInfo& info = reader.streams().at(video);
+    QCOMPARE(info.kind, quint16(capture::StreamKind::Video));
+    QCOMPARE(info.params[0], 800);
+    QCOMPARE(info.params[2], 30);
+
+    CaptureReader::Record record;
+    quint64 last = 0;
+    int count = 0;
+    while (reader.next(&record)) {
+      QVERIFY(count < expected.size());
+      QCOMPARE(int(record.stream), streams.at(count));
+      QCOMPARE(QByteArray(record.data, record.size), expected.at(count));
+      QCOMPARE(reinterpret_cast<quintptr>(record.data) % 8, quintptr(0));  // read in place
+      QVERIFY(record.timestampNs >= last);
+      last = record.timestampNs;
+      ++count;
+    }
+    QCOMPARE(count, expected.size());
+    QCOMPARE(reader.durationNs(), last);
+
+    reader.rewind();
+    int videoRecords = 0;
+    while (reader.next(&record, video)) {
+      QCOMPARE(int(record.stream), video);
+      ++videoRecords;
+    }
+    QCOMPARE(videoRecords, streams.count(video));
+
+    const quint64 middle = reader.chunks().at(reader.chunks().size() / 2).firstNs + 1;
+    reader.seek(middle);
+    QVERIFY(reader.next(&record));
+    QVERIFY(record.timestampNs >= middle);
+    reader.seek(last + 1);
+    QVERIFY(!reader.next(&record));
+  }
+
+  void testIndexRebuiltAfterCrash() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("crash.cap");
+    {
+      CaptureWriter writer;
+      QVERIFY(writer.open(path, 4096));
+      const int stream = writer.addStream(capture::StreamKind::Bytes, "gps");
+      for (int i = 0; i < 100; ++i) {
+        QVERIFY(writer.append(stream, bytes(payload(i, 200))));
+      }
+    }
+
+    // Cut the index off and leave a chunk the writer never finished
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    capture::FileHeader header;
+    QCOMPARE(file.read(reinterpret_cast<char*>(&header), sizeof(header)), qint64(sizeof(header)));
+    QVERIFY(header.indexOffset > 0);
+    QVERIFY(file.resize(static_cast<qint64>(header.indexOffset)));
+    capture::ChunkHeader torn{};
+    memcpy(torn.magic, capture::kChunkMagic, sizeof(torn.magic));
+    torn.bytes = 100000;
+    QVERIFY(file.seek(file.size()));
+    file.write(reinterpret_cast<const char*>(&torn), sizeof(torn));
+    header.indexOffset = 0;
+    QVERIFY(file.seek(0));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    CaptureReader reader;
+    QVERIFY(reader.open(path));
+    QVERIFY(!reader.hadIndex());
+    QCOMPARE(reader.streamId("gps"), 0);
+    CaptureReader::Record record;
+    int count = 0;
+    while (reader.next(&record)) {
+      QCOMPARE(QByteArray(record.data, record.size), payload(count, 200));
+      ++count;
+    }
+    QCOMPARE(count, 100);
+
+    QVERIFY(!reader.open(dir.filePath("missing.cap")));
+    QVERIFY(!reader.isOpen());
+    QFile junk(dir.filePath("junk.cap"));
+    QVERIFY(junk.open(QIODevice::WriteOnly));
+    junk.write(QByteArray(256, 'x'));
+    junk.close();
+    QString error;
+    QVERIFY(!reader.open(junk.fileName(), &error));
+    QVERIFY(error.contains("not a capture"));
+  }
+
+  void testCorruptRecordSizeStaysInChunk() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("corrupt.cap");
+    {
+      CaptureWriter writer;
+      QVERIFY(writer.open(path));
+      const int stream = writer.addStream(capture::StreamKind::Bytes, "gps");
+      for (int i = 0; i < 3; ++i) {
+        QVERIFY(writer.append(stream, bytes(payload(i, 200))));
+      }
+    }
+
+    // A size that wraps a 32-bit padding calculation, on the second data record
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    qint64 offset = sizeof(capture::FileHeader) + sizeof(capture::ChunkHeader);
+    capture::RecordHeader record{};
+    for (int data = 0;;) {
+      QVERIFY(file.seek(offset));
+      QCOMPARE(file.read(reinterpret_cast<char*>(&record), sizeof(record)),
+               qint64(sizeof(record)));
+      if (record.stream != capture::kDefinitionStream && ++data == 2) {
+        break;
+      }
+      offset += sizeof(record) + capture::paddedSize(record.size);
+    }
+    record.size = 0xfffffffa;
+    QVERIFY(file.seek(offset));
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    file.close();
+
+    CaptureReader reader;
+    QVERIFY(reader.open(path));
+    CaptureReader::Record next;
+    QVERIFY(reader.next(&next));
+    QCOMPARE(QByteArray(next.data, next.size), payload(0, 200));
+    QVERIFY(!reader.next(&next));
+  }
+
+  void testQuietStreamReachesDisk() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    CaptureWriter writer;
+    QVERIFY(writer.open(dir.filePath("quiet.cap")));
+    const int stream = writer.addStream(capture::StreamKind::Bytes, "gps");
+    QVERIFY(writer.append(stream, bytes("$GNRMC")));
+
+    // Far from a full chunk, but on disk within the flush interval
+    QTRY_VERIFY_WITH_TIMEOUT(writer.stats().chunks >= 1, 3000);
+    CaptureReader reader;
+    QVERIFY(reader.open(writer.path()));
+    QVERIFY(!reader.hadIndex());
+    CaptureReader::Record record;
+    QVERIFY(reader.next(&record));
+    QCOMPARE(QByteArray(record.data, record.size), QByteArray("$GNRMC"));
+  }
+
+  void testUartReadsAreRecorded() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    UARTTransport uart(pty.slavePath());
+    QVERIFY(uart.open());
+    CaptureWriter writer;
+    QVERIFY(writer.open(dir.filePath("uart.cap")));
+    QVERIFY(uart.setCapture(&writer, "gps"));
+
+    const QByteArray sent = cycle("123519.00") + cycle("123520.00") + cycle("123521.00");
+    pty.send(sent.left(100));
+    QTRY_COMPARE(uart.stats().bytesRead, quint64(100));
+    pty.send(sent.mid(100));
+    QTRY_COMPARE(uart.stats().bytesRead, quint64(sent.size()));
+    QVERIFY(uart.setCapture(nullptr));
+    pty.send("not recorded");
+    QTRY_COMPARE(uart.stats().bytesRead, quint64(sent.size() + 12));
+    writer.close();
+    uart.close();
+
+    CaptureReader reader;
+    QVERIFY(reader.open(dir.filePath("uart.cap")));
+    QCOMPARE(reader.streams().size(), 1);
+    QCOMPARE(reader.streams().first().kind, quint16(capture::StreamKind::Bytes));
+    QCOMPARE(reader.streams().first().params[0], 9600);
+    QByteArray recorded;
+    CaptureReader::Record record;
+    while (reader.next(&record)) {
+      recorded.append(record.data, record.size);
+    }
+    QCOMPARE(recorded, sent);
+  }
+
+  void testReplayTransportFeedsGps() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("gps.cap");
+    {
+      CaptureWriter writer;
+      QVERIFY(writer.open(path));
+      const int stream = writer.addStream(capture::StreamKind::Bytes, "gps");
+      for (int second = 0; second < 20; ++second) {
+        // Reads rarely end on a sentence boundary
+        const QByteArray time = "1235" + QByteArray::number(second).rightJustified(2, '0');
+        const QByteArray epoch = cycle(time + ".00");
+        QVERIFY(writer.append(stream, bytes(epoch.left(37))));
+        QVERIFY(writer.append(stream, bytes(epoch.mid(37))));
+      }
+    }
+
+    ReplayTransport replay(path, "gps");
+    replay.configure("speed", 0);
+    GPSDevice gps(&replay);
+    gps.setConfig("protocol", "nmea");
+    QSignalSpy finished(&replay, &ReplayTransport::replayFinished);
+    QList<GPSLocation> updates;
+    connect(&gps, &GPSDevice::locationUpdated, this,
+            [&](const GPSLocation& location) { updates.append(location); });
+    QVERIFY(gps.initialize());
+    QVERIFY(replay.isOpen());
+
+    QTRY_COMPARE(finished.count(), 1);
+    QTRY_COMPARE(updates.size(), 20);
+    QCOMPARE(updates.last().timestamp,
+             QDateTime(QDate(1994, 3, 23), QTime(12, 35, 19), QTimeZone::utc()));
+    QCOMPARE(replay.stats().records, quint64(40));
+    QVERIFY(replay.isFinished());
+  }
+
+  void testReplayTransportTurnsCanFramesIntoSlcan() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("can.cap");
+    QList<quint32> expected;
+    {
+      CaptureWriter writer;
+      QVERIFY(writer.open(path));
+      const int stream = writer.addStream(capture::StreamKind::CanFrames, "can0");
+      QVector<capture::CanFrameRecord> batch;
+      for (quint32 id = 0; id < 300; ++id) {
+        capture::CanFrameRecord frame{};
+        frame.id = id % 7 == 0 ? 0x18DAF100 + id : id;
+        frame.flags = id % 7 == 0 ? capture::kCanExtended : 0;
+        frame.length = 8;
+        frame.data[0] = static_cast<uint8_t>(id);
+        batch.append(frame);
+        expected.append(frame.id);
+        if (batch.size() == 50) {
+          QVERIFY(writer.append(stream, {reinterpret_cast<const char*>(batch.constData()),
+                                         batch.size() * sizeof(capture::CanFrameRecord)}));
+          batch.clear();
+        }
+      }
+    }
+
+    ReplayTransport replay(path);
+    replay.configure("speed", 0);
+    CANDevice can(&replay);
+    QList<quint32> ids;
+    bool payloadsMatch = true;
+    connect(&can, &CANDevice::framesReceived, this, [&](const CANFrame* frames, int count) {
+      for (int i = 0; i < count; ++i) {
+        payloadsMatch = payloadsMatch && frames[i].length == 8 &&
+                        frames[i].data[0] == static_cast<quint8>(ids.size()) &&
+                        frames[i].extended == (ids.size() % 7 == 0);
+        ids.append(frames[i].id);
+      }
+    });
+    QVERIFY(can.initialize());
+    QTRY_COMPARE(ids.size(), expected.size());
+    QCOMPARE(ids, expected);
+    QVERIFY(payloadsMatch);
+    QCOMPARE(replay.write("O\r"), qint64(2));  // adapter commands go nowhere
+  }
+
+  void testPacedReplayKeepsRecordedTiming() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("paced.cap");
+    {
+      CaptureWriter writer;
+      QVERIFY(writer.open(path));
+      const int stream = writer.addStream(capture::StreamKind::Bytes, "paced");
+      for (int i = 0; i < 5; ++i) {
+        QVERIFY(writer.append(stream, bytes(QByteArray::number(i))));
+        QThread::msleep(50);
+      }
+    }
+
+    auto replayFor = [&path](double speed, bool loop) {
+      auto replay = std::make_unique<ReplayTransport>(path);
+      replay->configure("speed", speed);
+      replay->configure("loop", loop);
+      return replay;
+    };
+
+    auto paced = replayFor(1.0, false);
+    QByteArray received;
+    connect(paced.get(), &Transport::dataReceived, this,
+            [&]() { received += paced->read(); });
+    QSignalSpy pacedDone(paced.get(), &ReplayTransport::replayFinished);
+    QElapsedTimer clock;
+    clock.start();
+    QVERIFY(paced->open());
+    QTRY_COMPARE(pacedDone.count(), 1);
+    const qint64 pacedMs = clock.elapsed();
+    QCOMPARE(received, QByteArray("01234"));
+    QVERIFY2(pacedMs >= 180, qPrintable(QString::number(pacedMs)));  // four 50 ms gaps
+
+    auto fast = replayFor(0, false);
+    QSignalSpy fastDone(fast.get(), &ReplayTransport::replayFinished);
+    clock.restart();
+    QVERIFY(fast->open());
+    QTRY_COMPARE(fastDone.count(), 1);
+    QVERIFY(clock.elapsed() < pacedMs);
+    QCOMPARE(fast->read(), QByteArray("01234"));
+
+    auto looped = replayFor(0, true);
+    QSignalSpy loopedDone(looped.get(), &ReplayTransport::replayFinished);
+    connect(looped.get(), &Transport::dataReceived, this, [&]() { looped->read(); });
+    QVERIFY(looped->open());
+    QTRY_VERIFY(looped->stats().loops >= 3);
+    QCOMPARE(loopedDone.count(), 0);
+  }
+
+  void testReplayAndroidAutoSession() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("aa.cap");
+    const QByteArray unit1 = payload(1, 5000);
+    const QByteArray unit2 = payload(2, 700);
+    const QByteArray pcm = payload(3, 3840);
+    {
+      CaptureWriter writer;
+      QVERIFY(writer.open(path));
+      const int video = writer.addStream(capture::StreamKind::Video,
+                                         AndroidAutoService::kCaptureVideoStream,
+                                         {800, 480, 30, 0});
+      const int media = writer.addStream(capture::StreamKind::Audio,
+                                         AndroidAutoService::kCaptureMediaAudioStream,
+                                         {48000, 2, 16, 0});
+      const int input = writer.addStream(capture::StreamKind::Input,
+                                         AndroidAutoService::kCaptureInputStream);
+      const capture::InputEvent touch{quint16(capture::InputType::Touch), 0, 120, 340, 0};
+      const capture::InputEvent key{quint16(capture::InputType::Key), 1, 0, 0, 84};
+      QVERIFY(writer.append(video, bytes(unit1)));
+      QVERIFY(writer.append(media, bytes(pcm)));
+      QVERIFY(writer.append(input, {reinterpret_cast<const char*>(&touch), sizeof(touch)}));
+      QVERIFY(writer.append(video, bytes(unit2)));
+      QVERIFY(writer.append(input, {reinterpret_cast<const char*>(&key), sizeof(key)}));
+    }
+
+    ReplayAndroidAutoService missing;
+    missing.configureTransport({{"replay.file", dir.filePath("missing.cap")}});
+    QSignalSpy errors(&missing, &AndroidAutoService::errorOccurred);
+    QVERIFY(!missing.initialise());
+    QCOMPARE(errors.count(), 1);
+
+    ReplayAndroidAutoService service;
+    service.configureTransport({{"replay.file", path}, {"replay.speed", 0}});
+    QVERIFY(service.initialise());
+    QCOMPARE(service.getDisplayResolution(), QSize(800, 480));
+    QCOMPARE(service.getFramerate(), 30);
+
+    int connections = 0;
+    QList<QByteArray> units;
+    connect(&service, &AndroidAutoService::connected, this, [&]() { ++connections; });
+    connect(&service, &AndroidAutoService::videoFrameReady, this,
+            [&](int width, int height, const uint8_t* data, int size) {
+              QCOMPARE(width, 800);
+              QCOMPARE(height, 480);
+              units.append(QByteArray(reinterpret_cast<const char*>(data), size));
+            });
+    QSignalSpy audio(&service, &AndroidAutoService::audioDataReady);
+    QSignalSpy touches(&service, &ReplayAndroidAutoService::touchReplayed);
+    QSignalSpy keys(&service, &ReplayAndroidAutoService::keyReplayed);
+    QSignalSpy finished(&service, &ReplayAndroidAutoService::replayFinished);
+
+    QVERIFY(service.startSearching());
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(connections, 1);
+    QVERIFY(service.isConnected());
+    QCOMPARE(units, (QList<QByteArray>{unit1, unit2}));
+    QCOMPARE(audio.count(), 1);
+    QCOMPARE(audio.first().first().toByteArray(), pcm);
+    QCOMPARE(touches.count(), 1);
+    QCOMPARE(touches.first(), (QList<QVariant>{120, 340, 0}));
+    QCOMPARE(keys.count(), 1);
+    QCOMPARE(keys.first(), (QList<QVariant>{84, 1}));
+    QCOMPARE(service.replayStats().videoUnits, quint64(2));
+    QCOMPARE(service.replayStats().inputEvents, quint64(2));
+
+    QVERIFY(service.disconnect());
+    QCOMPARE(service.getConnectionState(), AndroidAutoService::ConnectionState::DISCONNECTED);
+  }
+};
+
+QTEST_MAIN(TestCaptureReplay)
+#include "test_capture_replay.moc"
@@ -0,0 +1,372 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <atomic>
+#include <thread>
+
+#include "../core/services/diagnostics/MetricsRegistry.h"
+#include "../core/services/extensions/DataChannelHub.h"
+#include "../core/services/extensions/ExtensionManager.h"
+
+namespace {
+
+// The extension's view of a channel: its own mapping of the memfd
+struct Mapping {
+  explicit Mapping(int fd, size_t size) : size(size) {
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  ~Mapping() {
+    if (memory != MAP_FAILED) munmap(memory, size);
+  }
+  datachannel::ChannelHeader* header() const {
+    return datachannel::attach(memory, size);
+  }
+
+  void* memory;
+  size_t size;
+};
+
+bool readable(int fd) {
+  pollfd pfd{fd, POLLIN, 0};
+  return poll(&pfd, 1, 0) == 1;
+}
+
+QString manifest(const QString& id, const QStringList& permissions) {
+  QJsonObject obj;
+  obj.insert(QStringLiteral("id"), id);
+  obj.insert(QStringLiteral("name"), id);
+  obj.insert(QStringLiteral("version"), QStringLiteral("1.0.0"));
+  obj.insert(QStringLiteral("entrypoint"), QStringLiteral("sleep 30"));
+  obj.insert(QStringLiteral("permissions"), QJsonArray::fromStringList(permissions));
+  return QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
+}  // namespace
+
+class TestDataChannel : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testRecordsWrapAndKeepOrder() {
+    auto channel = DataChannel::create(QStringLiteral("ring"), 4096);
+    QVERIFY(channel);
+    Mapping mapping(channel->memoryFd(), channel->mappingSize());
+    QVERIFY(mapping.header());
+    datachannel::Consumer consumer(mapping.header());
+
+    // Odd sizes, drained as we go, so records land on every offset and wrap many times
+    QByteArray payload(700, 'x');
+    quint64 received = 0;
+    for (int i = 0; i < 500; ++i) {
+      const quint32 size = static_cast<quint32>((i * 131) % 700);
+      payload[0] = static_cast<char>(i);
+      QVERIFY(channel->publish(7, datachannel::Kind::Blob, payload.constData(), size, 1000 + i,
+                               0, size));
+      while (const datachannel::RecordHeader* record = consumer.next()) {
+        QCOMPARE(record->topic, quint16(7));
+        QCOMPARE(quint64(record->sequence), received);
+        QCOMPARE(quint64(record->timestampNs), 1000 + received);
+        QCOMPARE(record->meta, record->size);
+        if (record->size > 0) {
+          QCOMPARE(datachannel::Consumer::payload(record)[0], static_cast<uint8_t>(received));
+        }
+        consumer.release();
+        ++received;
+      }
+    }
+    QCOMPARE(received, quint64(500));
+    QCOMPARE(channel->published(), quint64(500));
+    QCOMPARE(channel->dropped(), quint64(0));
+    QCOMPARE(quint64(consumer.lost()), quint64(0));
+  }
+
+  void testFullRingDropsAndCountsGaps() {
+    crankshaft::diagnostics::MetricsRegistry registry;
+    auto channel = DataChannel::create(QStringLiteral("slow"), 4096, &registry);
+    QVERIFY(channel);
+    Mapping mapping(channel->memoryFd(), channel->mappingSize());
+    datachannel::Consumer consumer(mapping.header());
+
+    // 56-byte records: 73 fit in 4 KiB, the rest are dropped without blocking
+    const datachannel::TelemetrySample sample{1, 2, 0, 3.5};
+    int accepted = 0;
+    for (int i = 0; i < 100; ++i) {
+      if (channel->publish(1, datachannel::Kind::Telemetry, &sample, sizeof(sample), 1)) {
+        ++accepted;
+      }
+    }
+    QCOMPARE(accepted, 4096 / 56);
+    QCOMPARE(channel->dropped(), quint64(100 - accepted));
+
+    // A record bigger than half the ring never fits, even when it is empty
+    QByteArray blob(3000, 'b');
+    QVERIFY(!channel->publish(2, datachannel::Kind::Blob, blob.constData(), blob.size(), 1));
+
+    int drained = 0;
+    while (const datachannel::RecordHeader* record = consumer.next()) {
+      const auto* value = reinterpret_cast<const datachannel::TelemetrySample*>(
+          datachannel::Consumer::payload(record));
+      QCOMPARE(value->value, 3.5);
+      consumer.release();
+      ++drained;
+    }
+    QCOMPARE(drained, accepted);
+
+    // The gap shows up in the sequence of the next record that gets through
+    QVERIFY(channel->publish(1, datachannel::Kind::Telemetry, &sample, sizeof(sample), 1));
+    QVERIFY(consumer.next());
+    consumer.release();
+    QCOMPARE(quint64(consumer.lost()), channel->dropped());
+
+    const crankshaft::diagnostics::MetricLabels labels{{"extension", "slow"}};
+    QCOMPARE(registry.counter("extension_channel_dropped_total", QString(), labels).value(),
+             channel->dropped());
+    QCOMPARE(registry.counter("extension_channel_records_total", QString(), labels).value(),
+             quint64(accepted + 1));
+  }
+
+  void testReaderIsWokenOnlyWhenWaiting() {
+    auto channel = DataChannel::create(QStringLiteral("wake"), 4096);
+    QVERIFY(channel);
+    Mapping mapping(channel->memoryFd(), channel->mappingSize());
+    datachannel::Consumer consumer(mapping.header());
+    const char byte = 1;
+
+    QVERIFY(channel->publish(1, datachannel::Kind::Blob, &byte, 1, 1));
+    QVERIFY(!readable(channel->eventFd()));  // reader is not asleep: no syscall
+    QVERIFY(!consumer.prepareToWait());      // data is pending, so it must not sleep
+    QVERIFY(consumer.next());
+    consumer.release();
+
+    QVERIFY(consumer.prepareToWait());
+    QVERIFY(channel->publish(1, datachannel::Kind::Blob, &byte, 1, 2));
+    QVERIFY(readable(channel->eventFd()));
+    quint64 counter = 0;
+    QCOMPARE(read(channel->eventFd(), &counter, sizeof(counter)), ssize_t(sizeof(counter)));
+    QVERIFY(channel->publish(1, datachannel::Kind::Blob, &byte, 1, 3));
+    QVERIFY(!readable(channel->eventFd()));  // one wakeup per sleep
+  }
+
+  void testCapacityIsValidated() {
+    QString error;
+    QVERIFY(!DataChannel::create(QStringLiteral("bad"), 5000, nullptr, &error));
+    QVERIFY(error.contains("power of two"));
+    QVERIFY(!DataChannel::create(QStringLiteral("bad"), 1024, nullptr, &error));
+  }
+
+  void testHubRoutesTopics() {
+    DataChannelHub hub;
+    const quint32 sampleSize = sizeof(datachannel::TelemetrySample);
+    const int speed = hub.registerTopic("vehicle/speed", 2 * sampleSize);
+    const int rpm = hub.registerTopic("vehicle/rpm", sampleSize);
+    QCOMPARE(hub.registerTopic("vehicle/speed", sampleSize), speed);
+    QCOMPARE(hub.topicId("vehicle/speed"), speed);
+    QCOMPARE(hub.topicName(rpm), QString("vehicle/rpm"));
+    QVERIFY(!hub.hasSubscribers(speed));
+    QCOMPARE(hub.publish(speed, datachannel::Kind::Blob, "x", 1), 0);
+
+    QSignalSpy opened(&hub, &DataChannelHub::channelOpened);
+    QSignalSpy closed(&hub, &DataChannelHub::channelClosed);
+    DataChannel* both = hub.open({"dash", {"vehicle/speed", "vehicle/rpm"}, 4096});
+    DataChannel* speedOnly = hub.open({"hud", {"vehicle/speed"}, 4096});
+    QVERIFY(both && speedOnly);
+    QCOMPARE(opened.count(), 2);
+    QVERIFY(hub.hasSubscribers(speed));
+    QVERIFY(hub.hasSubscribers(rpm));
+
+    const datachannel::TelemetrySample samples[2] = {{10, 0, 0, 50.0}, {11, 0, 0, 51.0}};
+    QCOMPARE(hub.publishTelemetry(speed, samples, 2), 2);
+    QCOMPARE(hub.publishTelemetry(rpm, samples, 1), 1);
+    QCOMPARE(both->published(), quint64(2));
+    QCOMPARE(speedOnly->published(), quint64(1));
+
+    Mapping mapping(speedOnly->memoryFd(), speedOnly->mappingSize());
+    datachannel::Consumer consumer(mapping.header());
+    const datachannel::RecordHeader* record = consumer.next();
+    QVERIFY(record);
+    QCOMPARE(record->kind, static_cast<uint16_t>(datachannel::Kind::Telemetry));
+    QCOMPARE(record->topic, static_cast<uint16_t>(speed));
+    QCOMPARE(record->size, quint32(2 * sizeof(datachannel::TelemetrySample)));
+    QCOMPARE(quint64(record->timestampNs), quint64(10));
+
+    const QJsonObject status = hub.status("hud");
+    QCOMPARE(status.value("published").toInt(), 1);
+    QCOMPARE(status.value("topics").toArray().size(), 1);
+
+    QVERIFY(hub.close("hud"));
+    QVERIFY(!hub.close("hud"));
+    QCOMPARE(closed.count(), 1);
+    QCOMPARE(hub.publishTelemetry(speed, samples, 1), 1);
+    hub.closeAll();
+    QVERIFY(!hub.hasSubscribers(speed));
+    QVERIFY(!hub.isOpen("dash"));
+  }
+
+  void testHubOnlyServesRegisteredTopics() {
+    DataChannelHub hub;
+    QString error;
+    QVERIFY(!hub.open({"dash", {"vehicle/made-up"}, 4096}, &error));
+    QVERIFY(error.contains("Unknown topic"));
+    QCOMPARE(hub.topicId("vehicle/made-up"), -1);
+
+    // The ring grows to hold the topic's largest record
+    const quint32 frameSize = 800 * 480 * 4;
+    const int frame = hub.registerTopic("media/video/frame", frameSize);
+    DataChannel* channel = hub.open({"overlay", {"media/video/frame"}, 4096}, &error);
+    QVERIFY2(channel, qPrintable(error));
+    QCOMPARE(channel->capacity(), quint32(4u << 20));
+    const QByteArray pixels(static_cast<int>(frameSize), '\x7f');
+    QCOMPARE(hub.publish(frame, datachannel::Kind::Blob, pixels.constData(), frameSize), 1);
+
+    QCOMPARE(hub.registerTopic("media/huge", datachannel::kMaxCapacity), 1);
+    QVERIFY(!hub.open({"overlay", {"media/huge"}, 4096}, &error));
+    QVERIFY(error.contains("exceed"));
+  }
+
+  void testNegotiationPassesDescriptors() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    DataChannelHub hub;
+    const int speed = hub.registerTopic("vehicle/speed", sizeof(datachannel::TelemetrySample));
+    qint64 authorizedPid = 0;
+    hub.setAuthorizer([&](const DataChannelHub::Request& request, QString* error) {
+      authorizedPid = request.pid;
+      if (request.extensionId != "nav") {
+        *error = "unknown extension";
+        return false;
+      }
+      return true;
+    });
+    const QString path = dir.filePath("data.sock");
+    QString error;
+    QVERIFY2(hub.listen(path, &error), qPrintable(error));
+    QCOMPARE(hub.socketPath(), path);
+
+    // The client blocks on the reply, which the hub sends from this thread's event loop
+    std::atomic<bool> done{false};
+    std::string reply;
+    int memoryFd = -1;
+    int eventFd = -1;
+    bool negotiated = false;
+    std::thread client([&]() {
+      negotiated = datachannel::negotiate(
+          path.toLocal8Bit().constData(),
+          R"({"extension_id":"nav","topics":["vehicle/speed"],"capacity":8192})", &reply,
+          &memoryFd, &eventFd);
+      done = true;
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(done.load(), 3000);
+    client.join();
+
+    QVERIFY2(negotiated, reply.c_str());
+    QCOMPARE(authorizedPid, qint64(getpid()));
+    const QJsonObject body = QJsonDocument::fromJson(QByteArray::fromStdString(reply)).object();
+    QVERIFY(body.value("ok").toBool());
+    QCOMPARE(body.value("capacity").toInt(), 8192);
+    QCOMPARE(body.value("topics").toObject().value("vehicle/speed").toInt(-1), speed);
+
+    // The received descriptors are the channel: what the hub publishes is readable here
+    Mapping mapping(memoryFd, static_cast<size_t>(body.value("map_size").toInteger()));
+    QVERIFY(mapping.header());
+    datachannel::Consumer consumer(mapping.header());
+    QVERIFY(consumer.prepareToWait());
+    const datachannel::TelemetrySample sample{5, 1, 0, 88.0};
+    QCOMPARE(hub.publishTelemetry(speed, &sample, 1), 1);
+    QVERIFY(readable(eventFd));
+    QVERIFY(consumer.next());
+    close(memoryFd);
+    close(eventFd);
+
+    // A refused request gets the error and no descriptors
+    QSignalSpy rejected(&hub, &DataChannelHub::requestRejected);
+    done = false;
+    std::thread refused([&]() {
+      negotiated = datachannel::negotiate(path.toLocal8Bit().constData(),
+                                          R"({"extension_id":"spy","topics":["vehicle/speed"]})",
+                                          &reply, &memoryFd, &eventFd);
+      done = true;
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(done.load(), 3000);
+    refused.join();
+    QVERIFY(!negotiated);
+    QVERIFY(QByteArray::fromStdString(reply).contains("unknown extension"));
+    QCOMPARE(rejected.count(), 1);
+
+    hub.stopListening();
+    QVERIFY(!QFile::exists(path));
+  }
+
+  void testExtensionManagerEnforcesPermissions() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ExtensionManager manager(dir.path());
+    QVERIFY(manager.installExtension(manifest("telemetry", {"data.channel"}), QString()).isEmpty());
+    QVERIFY(manager.installExtension(manifest("plain", {"ui.tile"}), QString()).isEmpty());
+    QVERIFY(manager
+                .installExtension(manifest("overlay", {"data.channel", "media.source"}), QString())
+                .isEmpty());
+    QVERIFY(!manager.installExtension(manifest("bogus", {"data.everything"}), QString()).isEmpty());
+
+    DataChannelHub* hub = manager.dataChannels();
+    hub->registerTopic("vehicle/speed", sizeof(datachannel::TelemetrySample));
+    hub->registerTopic("media/video/frame", 1024);
+    QSignalSpy denied(&manager, &ExtensionManager::permissionDenied);
+    QString error;
+
+    QVERIFY(hub->open({"telemetry", {"vehicle/speed"}, 4096}, &error));
+    QVERIFY(manager.getExtensionInfo("telemetry").contains("data_channel"));
+
+    QVERIFY(!hub->open({"plain", {"vehicle/speed"}, 4096}, &error));
+    QCOMPARE(denied.last().at(1).toString(), QString("data.channel"));
+
+    QVERIFY(!hub->open({"telemetry", {"media/video/frame"}, 4096}, &error));
+    QCOMPARE(denied.last().at(1).toString(), QString("media.source"));
+    QVERIFY(hub->open({"overlay", {"media/video/frame"}, 4096}, &error));
+
+    QVERIFY(!hub->open({"missing", {"vehicle/speed"}, 4096}, &error));
+    QVERIFY(error.contains("not installed"));
+
+    // Over the socket the peer must be the extension's process
+    DataChannelHub::Request request{"telemetry", {"vehicle/speed"}, 4096, getpid()};
+    QVERIFY(!hub->open(request, &error));
+    QVERIFY(error.contains("is not extension"));
+
+    QVERIFY(manager.startExtension("telemetry").isEmpty());
+    request.pid = manager.supervisor()->pid("telemetry");
+    QVERIFY2(hub->open(request, &error), qPrintable(error));
+
+    // The mapping goes away with the process
+    QVERIFY(manager.stopExtension("telemetry").isEmpty());
+    QVERIFY(!hub->isOpen("telemetry"));
+  }
+};
+
+QTEST_MAIN(TestDataChannel)
+#include "test_data_channel.moc"
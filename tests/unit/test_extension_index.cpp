@@ -0,0 +1,206 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <atomic>
+
+#include "../core/services/extensions/ExtensionIndex.h"
+
+namespace {
+
+void writeManifest(const QString& root, const QString& directory, const QString& id,
+                   const QString& version) {
+  QDir().mkpath(root + "/" + directory);
+  QJsonObject manifest;
+  manifest.insert("id", id);
+  manifest.insert("version", version);
+  QFile file(root + "/" + directory + "/manifest.json");
+  QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  file.write(QJsonDocument(manifest).toJson());
+}
+
+bool hasId(const QJsonObject& manifest) {
+  return !manifest.value("id").toString().isEmpty();
+}
+
+}  // namespace
+
+class TestExtensionIndex : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testBuildReusesUnchangedEntries() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    for (int i = 0; i < 24; ++i) {
+      writeManifest(dir.path(), QString("ext%1").arg(i), QString("ext%1").arg(i), "1.0.0");
+    }
+    writeManifest(dir.path(), "broken", QString(), "1.0.0");
+    QDir().mkpath(dir.path() + "/empty");  // no manifest: not an extension
+
+    std::atomic<int> validated{0};
+    auto validator = [&validated](const QJsonObject& manifest) {
+      ++validated;
+      return hasId(manifest);
+    };
+
+    {
+      ExtensionIndex index(dir.path(), validator);
+      QCOMPARE(index.build(), 25);
+      QCOMPARE(validated.load(), 25);
+      QCOMPARE(index.entries().size(), 25);
+      QVERIFY(index.entry("ext3").valid);
+      QCOMPARE(index.entry("ext3").id, QString("ext3"));
+      QCOMPARE(index.entry("ext3").hash.size(), 64);
+      QVERIFY(!index.entry("broken").valid);
+      QVERIFY(!index.contains("empty"));
+      QVERIFY(QFile::exists(index.indexPath()));
+    }
+
+    // A second start only stats the manifests
+    validated = 0;
+    writeManifest(dir.path(), "ext7", "ext7", "2.0.0-rc1");
+    QVERIFY(QDir(dir.path() + "/ext11").removeRecursively());
+    {
+      ExtensionIndex index(dir.path(), validator);
+      QCOMPARE(index.build(), 1);
+      QCOMPARE(index.lastReused(), 23);
+      QCOMPARE(validated.load(), 1);
+      QCOMPARE(index.entry("ext7").version, QString("2.0.0-rc1"));
+      QVERIFY(!index.contains("ext11"));
+      QCOMPARE(index.entry("ext2").manifest.value("id").toString(), QString("ext2"));
+    }
+
+    // A damaged index file is rebuilt from scratch
+    QFile file(dir.path() + "/.index.json");
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("{ not json");
+    file.close();
+    ExtensionIndex index(dir.path(), validator);
+    QCOMPARE(index.build(), 24);
+  }
+
+  void testRefreshDoesNotNotify() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ExtensionIndex index(dir.path(), hasId);
+    index.build();
+    QVERIFY(index.watch());
+    QSignalSpy changed(&index, &ExtensionIndex::entryChanged);
+    QSignalSpy removed(&index, &ExtensionIndex::entryRemoved);
+
+    // What the owner wrote itself is indexed right away; the events it causes are no-ops
+    writeManifest(dir.path(), "own", "own", "1.0.0");
+    index.refresh("own");
+    QVERIFY(index.entry("own").valid);
+    QTest::qWait(300);
+    QCOMPARE(changed.count(), 0);
+
+    QVERIFY(QDir(dir.path() + "/own").removeRecursively());
+    index.refresh("own");
+    QVERIFY(!index.contains("own"));
+    QTest::qWait(300);
+    QCOMPARE(removed.count(), 0);
+  }
+
+  void testWatchPicksUpExternalChanges() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeManifest(dir.path(), "existing", "existing", "1.0.0");
+    ExtensionIndex index(dir.path(), hasId);
+    index.build();
+    QVERIFY(index.watch());
+    QVERIFY(index.isWatching());
+    QSignalSpy changed(&index, &ExtensionIndex::entryChanged);
+    QSignalSpy removed(&index, &ExtensionIndex::entryRemoved);
+
+    // Hot install: a new directory, then its manifest
+    writeManifest(dir.path(), "hot", "hot", "1.0.0");
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 3000);
+    QCOMPARE(changed.first().first().toString(), QString("hot"));
+    QVERIFY(index.entry("hot").valid);
+
+    // An update in place
+    writeManifest(dir.path(), "existing", "existing", "1.1.0");
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 2, 3000);
+    QCOMPARE(index.entry("existing").version, QString("1.1.0"));
+
+    // Hot removal
+    QVERIFY(QDir(dir.path() + "/hot").removeRecursively());
+    QTRY_COMPARE_WITH_TIMEOUT(removed.count(), 1, 3000);
+    QCOMPARE(removed.first().at(0).toString(), QString("hot"));
+    QCOMPARE(removed.first().at(1).toString(), QString("hot"));
+    QVERIFY(!index.contains("hot"));
+
+    // The index file followed along
+    index.stopWatching();
+    ExtensionIndex reloaded(dir.path(), hasId);
+    QCOMPARE(reloaded.build(), 0);
+    QCOMPARE(reloaded.entry("existing").version, QString("1.1.0"));
+  }
+
+  void testUnchangedRescanKeepsIndexFile() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeManifest(dir.path(), "steady", "steady", "1.0.0");
+    ExtensionIndex index(dir.path(), hasId);
+    index.build();
+    QVERIFY(QFile::remove(index.indexPath()));
+
+    // Reading the same manifest again changes nothing, so nothing is written
+    index.refresh("steady");
+    QVERIFY(!QFile::exists(index.indexPath()));
+
+    writeManifest(dir.path(), "steady", "steady", "1.0.1");
+    index.refresh("steady");
+    QVERIFY(QFile::exists(index.indexPath()));
+  }
+
+  void testValidatorVersionInvalidatesCache() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeManifest(dir.path(), "a", "a", "1.0.0");
+    writeManifest(dir.path(), "b", "b", "1.0.0");
+    auto rejectAll = [](const QJsonObject&) { return false; };
+    {
+      ExtensionIndex index(dir.path(), rejectAll, 1);
+      QCOMPARE(index.build(), 2);
+      QVERIFY(!index.entry("a").valid);
+    }
+    {
+      ExtensionIndex index(dir.path(), rejectAll, 1);
+      QCOMPARE(index.build(), 0);
+    }
+
+    // New rules: the cached verdicts are recomputed although no manifest changed
+    ExtensionIndex index(dir.path(), hasId, 2);
+    QCOMPARE(index.build(), 2);
+    QVERIFY(index.entry("a").valid);
+    QVERIFY(index.entry("b").valid);
+  }
+};
+
+QTEST_MAIN(TestExtensionIndex)
+#include "test_extension_index.moc"
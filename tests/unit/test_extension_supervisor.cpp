@@ -0,0 +1,244 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../core/services/diagnostics/MetricsRegistry.h"
+#include "../core/services/extensions/ExtensionSupervisor.h"
+
+namespace {
+
+ExtensionSupervisor::Spec spec(const QString& id, const QString& command) {
+  ExtensionSupervisor::Spec spec;
+  spec.id = id;
+  spec.command = command;
+  spec.workingDirectory = QDir::tempPath();
+  return spec;
+}
+
+}  // namespace
+
+class TestExtensionSupervisor : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testStartAndStop() {
+    ExtensionSupervisor supervisor;
+    QSignalSpy started(&supervisor, &ExtensionSupervisor::started);
+    QSignalSpy exited(&supervisor, &ExtensionSupervisor::exited);
+
+    const qint64 pid = supervisor.start(spec("sleeper", "sleep 30"));
+    QVERIFY(pid > 0);
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(started.first().at(1).toLongLong(), pid);
+    QVERIFY(supervisor.isRunning("sleeper"));
+    QCOMPARE(supervisor.pid("sleeper"), pid);
+
+    QString error;
+    QCOMPARE(supervisor.start(spec("sleeper", "sleep 30"), &error), qint64(-1));
+    QVERIFY(error.contains("already running"));
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(supervisor.stop("sleeper"));
+    QVERIFY(timer.elapsed() < 100);  // does not wait for the exit
+    QVERIFY(!supervisor.isRunning("sleeper"));
+    QCOMPARE(supervisor.status("sleeper").value("state").toString(), QString("stopping"));
+    QVERIFY(supervisor.stop("sleeper"));  // already stopping
+    QTRY_COMPARE_WITH_TIMEOUT(exited.count(), 1, 1000);  // SIGTERM was enough
+    QCOMPARE(exited.first().at(1).toInt(), 128 + SIGTERM);
+    QVERIFY(!exited.first().at(2).toBool());
+    QVERIFY(!supervisor.isRunning("sleeper"));
+    QCOMPARE(supervisor.status("sleeper").value("state").toString(), QString("stopped"));
+    QVERIFY(!supervisor.stop("sleeper"));
+  }
+
+  void testCleanExitIsNotRestarted() {
+    ExtensionSupervisor supervisor;
+    QSignalSpy exited(&supervisor, &ExtensionSupervisor::exited);
+    QSignalSpy restarts(&supervisor, &ExtensionSupervisor::restartScheduled);
+
+    QVERIFY(supervisor.start(spec("oneshot", "sh -c 'exit 0'")) > 0);
+    QTRY_COMPARE_WITH_TIMEOUT(exited.count(), 1, 2000);
+    QCOMPARE(exited.first().at(1).toInt(), 0);
+    QVERIFY(!exited.first().at(2).toBool());
+    QTest::qWait(100);
+    QCOMPARE(restarts.count(), 0);
+    QVERIFY(!supervisor.isRunning("oneshot"));
+  }
+
+  void testCrashRestartsWithBackoff() {
+    crankshaft::diagnostics::MetricsRegistry registry;
+    ExtensionSupervisor supervisor(&registry);
+    ExtensionSupervisor::Policy policy;
+    policy.initialBackoffMs = 50;
+    policy.maxBackoffMs = 150;
+    policy.crashLoopCount = 100;
+    supervisor.setPolicy(policy);
+    QSignalSpy exited(&supervisor, &ExtensionSupervisor::exited);
+    QSignalSpy restarts(&supervisor, &ExtensionSupervisor::restartScheduled);
+
+    QVERIFY(supervisor.start(spec("crasher", "sh -c 'exit 3'")) > 0);
+    QTRY_VERIFY_WITH_TIMEOUT(restarts.count() >= 4, 5000);
+    supervisor.stop("crasher");
+
+    QCOMPARE(exited.first().at(1).toInt(), 3);
+    QVERIFY(exited.first().at(2).toBool());
+    QCOMPARE(restarts.at(0).at(1).toInt(), 50);
+    QCOMPARE(restarts.at(1).at(1).toInt(), 100);
+    QCOMPARE(restarts.at(2).at(1).toInt(), 150);  // capped
+    QCOMPARE(restarts.at(3).at(1).toInt(), 150);
+
+    const QJsonObject status = supervisor.status("crasher");
+    QVERIFY(status.value("restarts").toInt() >= 3);
+    QVERIFY(status.value("crashes").toInt() >= 4);
+    QVERIFY(registry.counter("extension_crashes_total", QString(), {{"extension", "crasher"}})
+                .value() >= 4);
+  }
+
+  void testCrashLoopStopsRestarts() {
+    ExtensionSupervisor supervisor;
+    ExtensionSupervisor::Policy policy;
+    policy.initialBackoffMs = 10;
+    policy.crashLoopCount = 3;
+    supervisor.setPolicy(policy);
+    QSignalSpy started(&supervisor, &ExtensionSupervisor::started);
+    QSignalSpy loops(&supervisor, &ExtensionSupervisor::crashLoopDetected);
+
+    QVERIFY(supervisor.start(spec("looper", "sh -c 'kill -SEGV $$'")) > 0);
+    QTRY_COMPARE_WITH_TIMEOUT(loops.count(), 1, 3000);
+    QCOMPARE(loops.first().at(1).toInt(), 3);
+    QTest::qWait(200);
+    QCOMPARE(started.count(), 3);
+    QCOMPARE(supervisor.status("looper").value("state").toString(), QString("crash_loop"));
+
+    // Starting by hand clears the crash history
+    QVERIFY(supervisor.start(spec("looper", "sleep 30")) > 0);
+    QVERIFY(supervisor.isRunning("looper"));
+  }
+
+  void testStopKillsAfterGracePeriod() {
+    ExtensionSupervisor supervisor;
+    ExtensionSupervisor::Policy policy;
+    policy.stopGraceMs = 200;
+    supervisor.setPolicy(policy);
+    QSignalSpy exited(&supervisor, &ExtensionSupervisor::exited);
+
+    QVERIFY(supervisor.start(spec("stubborn", "sh -c \"trap '' TERM; sleep 30\"")) > 0);
+    QTest::qWait(100);  // let the shell install its trap
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(supervisor.stop("stubborn"));
+    QTRY_COMPARE_WITH_TIMEOUT(exited.count(), 1, 2000);
+    QVERIFY(timer.elapsed() >= 200);
+    QCOMPARE(exited.first().at(1).toInt(), 128 + SIGKILL);
+    QVERIFY(!exited.first().at(2).toBool());
+  }
+
+  void testFailedExitWhileStoppingIsACrash() {
+    ExtensionSupervisor supervisor;
+    QSignalSpy exited(&supervisor, &ExtensionSupervisor::exited);
+    QSignalSpy restarts(&supervisor, &ExtensionSupervisor::restartScheduled);
+
+    QVERIFY(supervisor.start(spec("unclean", "sh -c \"trap 'exit 4' TERM; sleep 5 & wait\"")) > 0);
+    QTest::qWait(100);  // let the shell install its trap
+
+    QVERIFY(supervisor.stop("unclean"));
+    QTRY_COMPARE_WITH_TIMEOUT(exited.count(), 1, 2000);
+    QCOMPARE(exited.first().at(1).toInt(), 4);
+    QVERIFY(exited.first().at(2).toBool());
+    QTest::qWait(100);
+    QCOMPARE(restarts.count(), 0);
+  }
+
+  void testStopCancelsPendingRestart() {
+    ExtensionSupervisor supervisor;
+    ExtensionSupervisor::Policy policy;
+    policy.initialBackoffMs = 300;
+    supervisor.setPolicy(policy);
+    QSignalSpy started(&supervisor, &ExtensionSupervisor::started);
+    QSignalSpy restarts(&supervisor, &ExtensionSupervisor::restartScheduled);
+
+    QVERIFY(supervisor.start(spec("flaky", "sh -c 'exit 1'")) > 0);
+    QTRY_COMPARE_WITH_TIMEOUT(restarts.count(), 1, 2000);
+    QVERIFY(!supervisor.stop("flaky"));  // nothing running, but the restart is cancelled
+    QTest::qWait(500);
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(supervisor.status("flaky").value("state").toString(), QString("stopped"));
+  }
+
+  void testBatchedStart() {
+    ExtensionSupervisor supervisor;
+    ExtensionSupervisor::Policy policy;
+    policy.bootBatchSize = 2;
+    policy.bootBatchIntervalMs = 100;
+    supervisor.setPolicy(policy);
+    QSignalSpy started(&supervisor, &ExtensionSupervisor::started);
+
+    QList<ExtensionSupervisor::Spec> specs;
+    for (int i = 0; i < 5; ++i) specs.append(spec(QString("boot%1").arg(i), "sleep 30"));
+    supervisor.startBatched(specs);
+    QCOMPARE(started.count(), 2);  // the first batch starts right away
+    QTRY_COMPARE_WITH_TIMEOUT(started.count(), 5, 2000);
+    QCOMPARE(started.at(4).at(0).toString(), QString("boot4"));
+
+    QSignalSpy exited(&supervisor, &ExtensionSupervisor::exited);
+    supervisor.stopAll();
+    for (int i = 0; i < 5; ++i) QVERIFY(!supervisor.isRunning(QString("boot%1").arg(i)));
+    QTRY_COMPARE_WITH_TIMEOUT(exited.count(), 5, 1000);  // one shared grace period
+  }
+
+  void testMissingProgram() {
+    ExtensionSupervisor supervisor;
+    QString error;
+    QCOMPARE(supervisor.start(spec("missing", "crankshaft-no-such-program"), &error), qint64(-1));
+    QVERIFY(error.contains("not found"));
+    QVERIFY(!supervisor.isRunning("missing"));
+  }
+
+  void testCgroupParsers() {
+    quint64 usageUs = 0;
+    QVERIFY(ExtensionSupervisor::parseCpuStat(
+        "usage_usec 123456\nuser_usec 100000\nsystem_usec 23456\n", &usageUs));
+    QCOMPARE(usageUs, quint64(123456));
+    QVERIFY(!ExtensionSupervisor::parseCpuStat("", &usageUs));
+
+    quint64 anon = 0;
+    QVERIFY(ExtensionSupervisor::parseMemoryStat("anon_thp 0\nanon 4096\nfile 8192\n", &anon));
+    QCOMPARE(anon, quint64(4096));
+
+    quint64 readBytes = 0;
+    quint64 writeBytes = 0;
+    ExtensionSupervisor::parseIoStat(
+        "8:0 rbytes=100 wbytes=200 rios=1 wios=2 dbytes=0 dios=0\n"
+        "8:16 rbytes=10 wbytes=20 rios=1 wios=1 dbytes=0 dios=0\n",
+        &readBytes, &writeBytes);
+    QCOMPARE(readBytes, quint64(110));
+    QCOMPARE(writeBytes, quint64(220));
+  }
+};
+
+QTEST_MAIN(TestExtensionSupervisor)
+#include "test_extension_supervisor.moc"
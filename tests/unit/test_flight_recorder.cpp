@@ -0,0 +1,171 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <QDir>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+#include <memory>
+
+#include "../core/services/diagnostics/FlightRecorder.h"
+
+using namespace crankshaft::diagnostics;
+
+namespace {
+
+std::vector<flight::Record> readBack(const QString& path, flight::DumpHeader* header) {
+  std::vector<flight::Record> records;
+  std::string error;
+  if (!flight::readDump(path.toStdString(), header, &records, &error)) {
+    qWarning("%s", error.c_str());
+  }
+  return records;
+}
+
+}  // namespace
+
+class TestFlightRecorder : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testDumpRoundTrip() {
+    QTemporaryDir dir;
+    auto recorder = std::make_unique<FlightRecorder>();
+    recorder->record(flight::Event::AaState, 5, 2);
+    recorder->record(flight::Event::DecoderPop, 0, (1280u << 16) | 720u, 42);
+
+    const QString path = recorder->dump(dir.filePath("manual.bin"));
+    QCOMPARE(path, dir.filePath("manual.bin"));
+
+    flight::DumpHeader header{};
+    const std::vector<flight::Record> records = readBack(path, &header);
+    QCOMPARE(header.pid, static_cast<uint32_t>(getpid()));
+    QCOMPARE(header.reason, static_cast<uint16_t>(flight::DumpReason::Manual));
+    QCOMPARE(header.head, uint64_t(3));
+    QCOMPARE(records.size(), size_t(3));
+
+    QCOMPARE(records[0].event, static_cast<uint16_t>(flight::Event::AaState));
+    QCOMPARE(records[0].code, uint16_t(5));
+    QCOMPARE(records[0].a, uint32_t(2));
+    QCOMPARE(records[1].a >> 16, uint32_t(1280));
+    QCOMPARE(records[1].b, uint64_t(42));
+    QCOMPARE(records[2].event, static_cast<uint16_t>(flight::Event::Marker));
+    QVERIFY(records[0].timestampNs <= records[1].timestampNs);
+    QVERIFY(records[1].timestampNs <= header.dumpMonotonicNs);
+    QCOMPARE(records[0].tid, records[2].tid);
+  }
+
+  void testRingKeepsNewestRecords() {
+    QTemporaryDir dir;
+    auto recorder = std::make_unique<FlightRecorder>();
+    const uint64_t total = FlightRecorder::kCapacity + 100;
+    for (uint64_t i = 0; i < total; ++i) {
+      recorder->record(flight::Event::DecoderPush, 0, 0, i);
+    }
+    const QString path = recorder->dump(dir.filePath("wrapped.bin"));
+
+    flight::DumpHeader header{};
+    const std::vector<flight::Record> records = readBack(path, &header);
+    QCOMPARE(records.size(), size_t(FlightRecorder::kCapacity));
+    // The dump marker took one more slot, so the oldest survivor is #101
+    QCOMPARE(records.front().b, uint64_t(101));
+    QCOMPARE(records[records.size() - 2].b, total - 1);
+    QCOMPARE(records.back().event, static_cast<uint16_t>(flight::Event::Marker));
+  }
+
+  void testConcurrentWriters() {
+    QTemporaryDir dir;
+    auto recorder = std::make_unique<FlightRecorder>();
+    constexpr int kThreads = 4;
+    constexpr uint64_t kPerThread = 3000;
+
+    QList<QThread*> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.append(QThread::create([&recorder, t]() {
+        for (uint64_t i = 0; i < kPerThread; ++i) {
+          recorder->record(flight::Event::WsQueue, static_cast<uint16_t>(t), 0, i);
+        }
+      }));
+      threads.last()->start();
+    }
+    for (QThread* thread : threads) {
+      QVERIFY(thread->wait(5000));
+    }
+    qDeleteAll(threads);
+
+    flight::DumpHeader header{};
+    const std::vector<flight::Record> records =
+        readBack(recorder->dump(dir.filePath("threads.bin")), &header);
+    QCOMPARE(records.size(), size_t(kThreads * kPerThread + 1));
+
+    // Each writer's records appear complete and in its own order
+    QVector<uint64_t> next(kThreads, 0);
+    for (const flight::Record& record : records) {
+      if (record.event != static_cast<uint16_t>(flight::Event::WsQueue)) continue;
+      QCOMPARE(record.b, next[record.code]);
+      ++next[record.code];
+    }
+    for (uint64_t count : next) QCOMPARE(count, kPerThread);
+  }
+
+  void testTopicHashMatchesDecoder() {
+    const char topic[] = "android-auto/status";
+    QCOMPARE(FlightRecorder::topicHash(QString::fromLatin1(topic)),
+             flight::topicHash(topic, sizeof(topic) - 1));
+    QVERIFY(FlightRecorder::topicHash("a/b") != FlightRecorder::topicHash("a/c"));
+  }
+
+  void testCrashWritesDump() {
+    QTemporaryDir dir;
+    const pid_t child = fork();
+    QVERIFY(child >= 0);
+    if (child == 0) {
+      FlightRecorder& recorder = FlightRecorder::instance();
+      if (!recorder.installCrashHandler(dir.path())) _exit(1);
+      recorder.record(flight::Event::AaState, 7, 5);
+      abort();
+    }
+
+    int status = 0;
+    QCOMPARE(waitpid(child, &status, 0), child);
+    QVERIFY(WIFSIGNALED(status));
+    QCOMPARE(WTERMSIG(status), SIGABRT);
+
+    const QStringList dumps = QDir(dir.path()).entryList({"crash-*.bin"}, QDir::Files);
+    QCOMPARE(dumps.size(), 1);
+    QVERIFY(QDir(dir.path()).entryList({".crash-*"}, QDir::Files | QDir::Hidden).isEmpty());
+
+    flight::DumpHeader header{};
+    const std::vector<flight::Record> records =
+        readBack(dir.filePath(dumps.first()), &header);
+    QCOMPARE(header.reason, static_cast<uint16_t>(flight::DumpReason::Crash));
+    QCOMPARE(header.detail, static_cast<uint16_t>(SIGABRT));
+    QVERIFY(records.size() >= 2);
+    const flight::Record& state = records[records.size() - 2];
+    QCOMPARE(state.event, static_cast<uint16_t>(flight::Event::AaState));
+    QCOMPARE(state.code, uint16_t(7));
+  }
+};
+
+QTEST_MAIN(TestFlightRecorder)
+#include "test_flight_recorder.moc"
@@ -0,0 +1,342 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+#include <QTimeZone>
+#include <atomic>
+
+#include "../core/hal/functional/CANDevice.h"
+#include "../core/hal/functional/GPSDevice.h"
+#include "../core/hal/mocks/transport/MockTransport.h"
+#include "../core/hal/transport/IoReactor.h"
+#include "../core/hal/transport/UARTTransport.h"
+
+namespace {
+
+// Master side of a pseudo-terminal; the transport opens the slave
+class PtyPair {
+ public:
+  PtyPair() {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_master >= 0 && grantpt(m_master) == 0 && unlockpt(m_master) == 0) {
+      m_slavePath = QString::fromLocal8Bit(ptsname(m_master));
+      termios tio{};
+      tcgetattr(m_master, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(m_master, TCSANOW, &tio);
+    }
+  }
+  ~PtyPair() {
+    if (m_master >= 0) {
+      ::close(m_master);
+    }
+  }
+
+  bool isValid() const {
+    return !m_slavePath.isEmpty();
+  }
+  QString slavePath() const {
+    return m_slavePath;
+  }
+
+  void send(const QByteArray& data) {
+    QCOMPARE(::write(m_master, data.constData(), data.size()), ssize_t(data.size()));
+  }
+
+  // Hangs up the slave side, like unplugging a USB adapter
+  void closeMaster() {
+    ::close(m_master);
+    m_master = -1;
+  }
+
+ private:
+  int m_master{-1};
+  QString m_slavePath;
+};
+
+// Non-blocking pipe; the reactor watches the read end
+class Pipe {
+ public:
+  Pipe() {
+    if (::pipe2(m_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+      m_fds[0] = m_fds[1] = -1;
+    }
+  }
+  ~Pipe() {
+    closeWriteEnd();
+    if (m_fds[0] >= 0) ::close(m_fds[0]);
+  }
+
+  int readFd() const {
+    return m_fds[0];
+  }
+  void send(const QByteArray& data) {
+    QCOMPARE(::write(m_fds[1], data.constData(), data.size()), ssize_t(data.size()));
+  }
+  void closeWriteEnd() {
+    if (m_fds[1] >= 0) ::close(m_fds[1]);
+    m_fds[1] = -1;
+  }
+
+ private:
+  int m_fds[2];
+};
+
+class PipeHandler : public IoReactor::Handler {
+ public:
+  PipeHandler(IoReactor* reactor, int fd) : m_reactor(reactor), m_fd(fd) {}
+
+  void onReactorReadable() override {
+    inside.store(true);
+    onReactorThread.store(m_reactor->isReactorThread());
+    char buffer[256];
+    ssize_t count;
+    while ((count = ::read(m_fd, buffer, sizeof(buffer))) > 0) {
+      bytes.fetch_add(static_cast<int>(count));
+    }
+    lastBytes.store(bytes.load());
+    if (holdMs > 0) {
+      QThread::msleep(holdMs);
+    }
+    if (restMs > 0) {
+      m_reactor->rest(m_fd, restMs * 1000000LL);
+    }
+    inside.store(false);
+    calls.fetch_add(1);
+  }
+
+  std::atomic<int> calls{0};
+  std::atomic<int> bytes{0};
+  std::atomic<int> lastBytes{0};
+  std::atomic<bool> inside{false};
+  std::atomic<bool> onReactorThread{false};
+  int holdMs{0};
+  int restMs{0};
+
+ private:
+  IoReactor* m_reactor;
+  int m_fd;
+};
+
+// "$<body>*hh\r\n" with the checksum filled in
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+QByteArray cycle(const QByteArray& time) {
+  return sentence("GNRMC," + time + ",A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A") +
+         sentence("GNGGA," + time + ",4807.038,N,01131.000,E,1,12,0.9,545.4,M,46.9,M,,") +
+         sentence("GNGSA,A,3,01,02,03,,,,,,,,,,1.5,0.9,1.2");
+}
+
+}  // namespace
+
+class TestIoReactor : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testHandlerRunsOnReactorThread() {
+    IoReactor reactor;
+    QVERIFY(reactor.isValid());
+    QVERIFY(!reactor.isReactorThread());
+    Pipe pipe;
+    PipeHandler handler(&reactor, pipe.readFd());
+    QVERIFY(reactor.add(pipe.readFd(), &handler));
+    QVERIFY(!reactor.add(pipe.readFd(), &handler));
+
+    pipe.send("hello");
+    QTRY_COMPARE(handler.bytes.load(), 5);
+    QVERIFY(handler.onReactorThread.load());
+    QCOMPARE(reactor.stats().dispatches, quint64(handler.calls.load()));
+    reactor.remove(pipe.readFd());
+  }
+
+  void testRestBatchesReads() {
+    IoReactor reactor;
+    Pipe pipe;
+    PipeHandler handler(&reactor, pipe.readFd());
+    handler.restMs = 200;
+    QVERIFY(reactor.add(pipe.readFd(), &handler));
+
+    pipe.send("a");
+    QTRY_COMPARE(handler.calls.load(), 1);
+    // Everything sent while resting is read in one go afterwards
+    for (int i = 0; i < 10; ++i) {
+      pipe.send("b");
+    }
+    QTest::qWait(50);
+    QCOMPARE(handler.calls.load(), 1);
+    QTRY_COMPARE(handler.calls.load(), 2);
+    QCOMPARE(handler.lastBytes.load(), 11);
+    QCOMPARE(reactor.stats().rests, quint64(2));
+    reactor.remove(pipe.readFd());
+  }
+
+  void testRemoveWaitsForHandler() {
+    IoReactor reactor;
+    Pipe pipe;
+    PipeHandler handler(&reactor, pipe.readFd());
+    handler.holdMs = 100;
+    QVERIFY(reactor.add(pipe.readFd(), &handler));
+
+    pipe.send("x");
+    QTRY_VERIFY(handler.inside.load());
+    reactor.remove(pipe.readFd());
+    QVERIFY(!handler.inside.load());
+    QCOMPARE(handler.calls.load(), 1);
+
+    // Removed: nothing more is dispatched, and the fd can be added again
+    pipe.send("y");
+    QTest::qWait(50);
+    QCOMPARE(handler.calls.load(), 1);
+    handler.holdMs = 0;
+    QVERIFY(reactor.add(pipe.readFd(), &handler));
+    QTRY_COMPARE(handler.bytes.load(), 2);
+    reactor.remove(pipe.readFd());
+  }
+
+  void testHangupIsDispatchedOnce() {
+    IoReactor reactor;
+    Pipe pipe;
+    PipeHandler handler(&reactor, pipe.readFd());
+    QVERIFY(reactor.add(pipe.readFd(), &handler));
+
+    pipe.send("bye");
+    pipe.closeWriteEnd();
+    QTRY_COMPARE(reactor.stats().hangups, quint64(1));
+    const int calls = handler.calls.load();
+    QTest::qWait(50);
+    QCOMPARE(handler.calls.load(), calls);
+    QCOMPARE(handler.bytes.load(), 3);
+    reactor.remove(pipe.readFd());
+  }
+
+  void testDefaultReadInto() {
+    MockTransport transport;
+    char buffer[4];
+    QCOMPARE(transport.readInto(buffer), qint64(-1));
+    QVERIFY(transport.open());
+    transport.injectData("abcdef");
+    QCOMPARE(transport.readInto(buffer), qint64(4));
+    QCOMPARE(QByteArray(buffer, 4), QByteArray("abcd"));
+    QCOMPARE(transport.readInto(buffer), qint64(2));
+    QCOMPARE(transport.readInto(buffer), qint64(0));
+    QVERIFY(!transport.setReactor(&IoReactor::instance()));
+    QVERIFY(transport.setReactor(nullptr));
+  }
+
+  void testGpsParsedOnReactorThread() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    IoReactor reactor;
+    UARTTransport uart(pty.slavePath());
+    QVERIFY(uart.setReactor(&reactor));
+    QVERIFY(uart.open());
+    GPSDevice gps(&uart);
+    gps.setConfig("protocol", "nmea");
+    QVERIFY(gps.initialize());
+
+    QList<GPSLocation> updates;
+    QList<QThread*> threads;
+    connect(&gps, &GPSDevice::locationUpdated, this, [&](const GPSLocation& location) {
+      updates.append(location);
+      threads.append(QThread::currentThread());
+    });
+
+    pty.send(cycle("123519.00") + cycle("123520.00"));
+    pty.send(cycle("123521.00"));
+    QTRY_COMPARE(updates.size(), 3);
+    QCOMPARE(threads, QList<QThread*>(3, QThread::currentThread()));
+    QCOMPARE(updates.last().timestamp,
+             QDateTime(QDate(1994, 3, 23), QTime(12, 35, 21), QTimeZone::utc()));
+    QVERIFY(reactor.stats().rests >= 1);  // read batching carries over
+
+    uart.close();
+    QCOMPARE(gps.parserStats().epochs, quint64(3));
+  }
+
+  void testCanFramesReachOwnerThreadInOrder() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    IoReactor reactor;
+    UARTTransport uart(pty.slavePath());
+    QVERIFY(uart.open());
+    CANDevice can(&uart);
+    QVERIFY(can.initialize());
+    QVERIFY(uart.setReactor(&reactor));
+
+    QList<quint32> ids;
+    bool ownerThread = true;
+    connect(&can, &CANDevice::framesReceived, this, [&](const CANFrame* frames, int count) {
+      ownerThread = ownerThread && QThread::currentThread() == thread();
+      for (int i = 0; i < count; ++i) {
+        ids.append(frames[i].id);
+      }
+    });
+
+    QByteArray text;
+    QList<quint32> expected;
+    for (quint32 id = 0; id < 300; ++id) {
+      text += QString("t%1101\r").arg(id, 3, 16, QChar('0')).toLatin1();
+      expected.append(id);
+    }
+    pty.send(text);
+    QTRY_COMPARE(ids.size(), expected.size());
+    QCOMPARE(ids, expected);
+    QVERIFY(ownerThread);
+    QCOMPARE(can.handoffDropped(), quint64(0));
+
+    // Back on the transport's own thread
+    QVERIFY(uart.setReactor(nullptr));
+    ids.clear();
+    pty.send("t7FF0\r");
+    QTRY_COMPARE(ids, QList<quint32>{0x7FF});
+    uart.close();
+  }
+
+  void testUartHangupClosesPort() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    IoReactor reactor;
+    UARTTransport uart(pty.slavePath());
+    QVERIFY(uart.setReactor(&reactor));
+    QVERIFY(uart.open());
+    QSignalSpy disconnectedSpy(&uart, &Transport::disconnected);
+
+    pty.closeMaster();
+    QTRY_COMPARE(disconnectedSpy.count(), 1);
+    QCOMPARE(uart.getState(), TransportState::DISCONNECTED);
+    QTest::qWait(50);
+    QCOMPARE(disconnectedSpy.count(), 1);
+  }
+};
+
+QTEST_MAIN(TestIoReactor)
+#include "test_io_reactor.moc"
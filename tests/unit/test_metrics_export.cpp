@@ -0,0 +1,198 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QBuffer>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QTest>
+
+#include "../core/services/diagnostics/MetricsExporter.h"
+#include "../core/services/diagnostics/MetricsHttpServer.h"
+
+using namespace crankshaft::diagnostics;
+
+namespace {
+
+/**
+ * @brief Write-only device that records the size of every write
+ */
+class RecordingDevice : public QIODevice {
+ public:
+  RecordingDevice() {
+    open(QIODevice::WriteOnly);
+  }
+
+  QByteArray data;
+  QVector<qint64> writes;
+
+ protected:
+  qint64 readData(char*, qint64) override {
+    return -1;
+  }
+  qint64 writeData(const char* bytes, qint64 size) override {
+    data.append(bytes, size);
+    writes.append(size);
+    return size;
+  }
+};
+
+QByteArray httpGet(quint16 port, const QByteArray& request) {
+  QTcpSocket client;
+  client.connectToHost(QHostAddress::LocalHost, port);
+  if (!client.waitForConnected(2000)) return QByteArray();
+  client.write(request);
+
+  QByteArray response;
+  QObject::connect(&client, &QTcpSocket::readyRead, [&]() { response += client.readAll(); });
+  QTest::qWaitFor([&client]() { return client.state() == QAbstractSocket::UnconnectedState; },
+                  5000);
+  response += client.readAll();
+  return response;
+}
+
+}  // namespace
+
+class TestMetricsExport : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testHistogramExportsCumulativeBuckets() {
+    MetricsRegistry registry;
+    Histogram& histogram = registry.histogram("decode_ms", "Decode time", {{"codec", "h264"}});
+    for (double value : {0.7, 3.0, 7.0, 30.0, 300.0}) histogram.record(value);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(MetricsExporter(registry).writePrometheus(&buffer) > 0);
+    const QByteArray text = buffer.data();
+
+    QVERIFY(text.contains("# TYPE crankshaft_decode_ms histogram\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"0.5\"} 0\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"1\"} 1\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"5\"} 2\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"10\"} 3\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"50\"} 4\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"500\"} 5\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_bucket{codec=\"h264\",le=\"+Inf\"} 5\n"));
+    QVERIFY(text.contains("crankshaft_decode_ms_count{codec=\"h264\"} 5\n"));
+  }
+
+  void testFamiliesAreContiguous() {
+    MetricsRegistry registry;
+    registry.gauge("queue", "Queue depth", {{"name", "video"}}).set(1);
+    registry.gauge("queue_bytes", "Queue bytes").set(2);
+    registry.gauge("queue", "Queue depth", {{"name", "audio"}}).set(3);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    MetricsExporter(registry).writePrometheus(&buffer);
+    const QList<QByteArray> lines = buffer.data().split('\n');
+
+    QStringList families;
+    for (const QByteArray& line : lines) {
+      if (line.isEmpty() || line.startsWith('#')) continue;
+      const int brace = line.indexOf('{');
+      const QString family = QString::fromUtf8(line.left(brace >= 0 ? brace : line.indexOf(' ')));
+      if (families.isEmpty() || families.last() != family) families.append(family);
+    }
+    QCOMPARE(families, QStringList({"crankshaft_queue", "crankshaft_queue_bytes"}));
+    QCOMPARE(buffer.data().count("# TYPE crankshaft_queue gauge"), 1);
+  }
+
+  void testCsvStreamsInChunks() {
+    MetricsRegistry registry;
+    constexpr int kSeries = 30;
+    constexpr int kSamples = 1440;
+    for (int s = 0; s < kSeries; ++s) {
+      TimeSeries& series = registry.timeSeries(QString("series_%1").arg(s), "ms", kSamples);
+      for (int i = 0; i < kSamples; ++i) series.append(1700000000000LL + i * 60000LL, i * 0.5);
+    }
+
+    RecordingDevice device;
+    const qint64 written = MetricsExporter(registry).writeCsv(&device);
+    QCOMPARE(written, qint64(device.data.size()));
+    QVERIFY(device.writes.size() > 1);
+    for (qint64 size : device.writes) {
+      QVERIFY(size < MetricsExporter::kChunkSize + 256);
+    }
+
+    const QList<QByteArray> rows = device.data.trimmed().split('\n');
+    QCOMPARE(rows.size(), kSeries * kSamples + 1);
+    QCOMPARE(rows.first(), QByteArray("metric,labels,unit,timestamp,value"));
+    QCOMPARE(rows.last(), QByteArray("series_9,,ms,1700086340000,719.5"));
+  }
+
+  void testCsvQuotesLabels() {
+    MetricsRegistry registry;
+    registry.timeSeries("latency", "ms", 4, QString(), {{"endpoint", "/a,b"}}).append(10, 1.5);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    MetricsExporter(registry).writeCsv(&buffer);
+    QVERIFY(buffer.data().contains("latency,\"endpoint=/a,b\",ms,10,1.5\n"));
+  }
+
+  void testHttpScrape() {
+    MetricsRegistry registry;
+    registry.counter("scrape_test_total", "Test counter").add(42);
+
+    MetricsHttpServer server(registry);
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    QVERIFY(server.port() != 0);
+
+    const QByteArray metrics = httpGet(server.port(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    QVERIFY2(metrics.startsWith("HTTP/1.0 200 OK\r\n"), metrics.constData());
+    QVERIFY(metrics.contains("Content-Type: text/plain; version=0.0.4"));
+    QVERIFY(metrics.contains("\r\n\r\n# HELP crankshaft_scrape_test_total Test counter\n"));
+    QVERIFY(metrics.contains("crankshaft_scrape_test_total 42\n"));
+
+    const QByteArray missing = httpGet(server.port(), "GET /nope HTTP/1.1\r\n\r\n");
+    QVERIFY(missing.startsWith("HTTP/1.0 404 Not Found\r\n"));
+
+    const QByteArray post = httpGet(server.port(), "POST /metrics HTTP/1.1\r\n\r\n");
+    QVERIFY(post.startsWith("HTTP/1.0 405 Method Not Allowed\r\n"));
+  }
+
+  void testHttpScrapeStreamsLargeCsv() {
+    MetricsRegistry registry;
+    constexpr int kSeries = 20;
+    constexpr int kSamples = 1440;
+    for (int s = 0; s < kSeries; ++s) {
+      TimeSeries& series = registry.timeSeries(QString("series_%1").arg(s), "ms", kSamples);
+      for (int i = 0; i < kSamples; ++i) series.append(1700000000000LL + i * 60000LL, i * 0.5);
+    }
+    RecordingDevice expected;
+    const qint64 bodySize = MetricsExporter(registry).writeCsv(&expected);
+    QVERIFY(bodySize > 4 * MetricsHttpServer::kMaxBufferedBytes);
+
+    MetricsHttpServer server(registry);
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    QSignalSpy scraped(&server, &MetricsHttpServer::scraped);
+
+    const QByteArray response = httpGet(server.port(), "GET /metrics.csv HTTP/1.1\r\n\r\n");
+    const int headerEnd = response.indexOf("\r\n\r\n");
+    QVERIFY(headerEnd > 0);
+    QCOMPARE(response.mid(headerEnd + 4), expected.data);
+    QCOMPARE(scraped.size(), 1);
+    QCOMPARE(scraped.first().at(1).toLongLong(), bodySize);
+  }
+};
+
+QTEST_MAIN(TestMetricsExport)
+#include "test_metrics_export.moc"
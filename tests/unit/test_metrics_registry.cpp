@@ -0,0 +1,155 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QTest>
+#include <QThread>
+#include <cmath>
+#include <vector>
+
+#include "../core/services/diagnostics/MetricsEndpoint.h"
+#include "../core/services/diagnostics/MetricsRegistry.h"
+
+using namespace crankshaft::diagnostics;
+
+class TestMetricsRegistry : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testCounterConcurrentAdds() {
+    MetricsRegistry registry;
+    Counter& counter = registry.counter("events_total", "Events");
+
+    constexpr int kThreads = 8;
+    constexpr int kAddsPerThread = 100000;
+    std::vector<QThread*> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.push_back(QThread::create([&counter]() {
+        for (int i = 0; i < kAddsPerThread; ++i) counter.add();
+      }));
+      threads.back()->start();
+    }
+    for (QThread* thread : threads) {
+      QVERIFY(thread->wait(10000));
+      delete thread;
+    }
+
+    QCOMPARE(counter.value(), quint64(kThreads) * kAddsPerThread);
+  }
+
+  void testRegistrationIsIdempotent() {
+    MetricsRegistry registry;
+    Counter& a = registry.counter("requests_total", "", {{"endpoint", "/health"}});
+    Counter& b = registry.counter("requests_total", "", {{"endpoint", "/health"}});
+    Counter& c = registry.counter("requests_total", "", {{"endpoint", "/metrics"}});
+    QCOMPARE(&a, &b);
+    QVERIFY(&a != &c);
+    QCOMPARE(registry.counters().size(), 2);
+  }
+
+  void testGauge() {
+    MetricsRegistry registry;
+    Gauge& gauge = registry.gauge("queue_depth");
+    gauge.set(4.5);
+    gauge.add(-1.5);
+    QCOMPARE(gauge.value(), 3.0);
+  }
+
+  void testHistogramBucketsAreContiguous() {
+    quint64 expectedLower = 0;
+    for (int index = 0; index < 600; ++index) {
+      const quint64 upper = Histogram::bucketUpperBound(index);
+      QCOMPARE(Histogram::bucketIndex(expectedLower), index);
+      QCOMPARE(Histogram::bucketIndex(upper), index);
+      expectedLower = upper + 1;
+    }
+  }
+
+  void testHistogramPercentilesWithinRelativeError() {
+    MetricsRegistry registry;
+    Histogram& histogram = registry.histogram("latency_ms");
+    for (int i = 1; i <= 10000; ++i) {
+      histogram.record(i / 10.0);  // 0.1ms .. 1000ms uniformly
+    }
+
+    const Histogram::Snapshot snapshot = histogram.snapshot();
+    QCOMPARE(snapshot.count, quint64(10000));
+    QCOMPARE(snapshot.min, 0.1);
+    QCOMPARE(snapshot.max, 1000.0);
+    QVERIFY(std::abs(snapshot.mean() - 500.05) < 0.01);
+
+    for (double p : {0.5, 0.9, 0.95, 0.99}) {
+      const double expected = p * 1000.0;
+      const double actual = snapshot.percentile(p);
+      const QString message =
+          QString("p%1 = %2, expected ~%3").arg(p * 100).arg(actual).arg(expected);
+      QVERIFY2(std::abs(actual - expected) / expected < 0.035, qPrintable(message));
+    }
+  }
+
+  void testTimeSeriesRingWraps() {
+    MetricsRegistry registry;
+    TimeSeries& series = registry.timeSeries("temperature", "C", 4);
+    for (int i = 1; i <= 10; ++i) {
+      series.append(i * 1000, i);
+    }
+
+    QCOMPARE(series.size(), 4);
+    const QVector<TimeSeries::Sample> samples = series.samples();
+    QCOMPARE(samples.size(), 4);
+    QCOMPARE(samples.first().value, 7.0);
+    QCOMPARE(samples.last().value, 10.0);
+    QCOMPARE(series.latest(), 10.0);
+    QCOMPARE(series.average(2), 9.5);
+    QCOMPARE(series.min(), 7.0);
+    QCOMPARE(series.max(), 10.0);
+  }
+
+  void testEndpointLatencyBreakdown() {
+    MetricsRegistry registry;
+    MetricsEndpoint endpoint(registry);
+    for (int i = 1; i <= 100; ++i) {
+      endpoint.recordRequestLatency("/api/play", i);
+    }
+
+    const QJsonObject breakdown =
+        endpoint.getMetrics().value("latency_breakdown").toObject().value("/api/play").toObject();
+    QCOMPARE(breakdown.value("count").toInt(), 100);
+    QVERIFY(std::abs(breakdown.value("p50").toDouble() - 50.0) <= 2.0);
+    QVERIFY(std::abs(breakdown.value("p99").toDouble() - 99.0) <= 3.0);
+  }
+
+  void testPrometheusExportIncludesRegisteredMetrics() {
+    MetricsRegistry registry;
+    MetricsEndpoint endpoint(registry);
+    endpoint.setPrometheusEnabled(true);
+    registry.counter("frames_total", "Frames", {{"stream", "video"}}).add(3);
+    endpoint.recordMemoryUsage(128.0);
+    endpoint.recordRequestLatency("/api/play", 4.0);
+
+    const QString text = endpoint.exportPrometheus();
+    QVERIFY(text.contains("# TYPE crankshaft_frames_total counter"));
+    QVERIFY(text.contains("crankshaft_frames_total{stream=\"video\"} 3"));
+    QVERIFY(text.contains("crankshaft_memory_usage_mb 128"));
+    QVERIFY(text.contains("crankshaft_request_latency_ms_count{endpoint=\"/api/play\"} 1"));
+    QVERIFY(!text.contains("crankshaft_request_latency_ms_count "));
+  }
+};
+
+QTEST_MAIN(TestMetricsRegistry)
+#include "test_metrics_registry.moc"
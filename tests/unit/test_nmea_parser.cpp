@@ -0,0 +1,230 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QTest>
+#include <QTimeZone>
+#include <cmath>
+
+#include "../core/hal/functional/GPSDevice.h"
+#include "../core/hal/functional/NmeaParser.h"
+#include "../core/hal/mocks/transport/MockTransport.h"
+
+namespace {
+
+// "$<body>*hh\r\n" with the checksum filled in
+QByteArray sentence(const QByteArray& body) {
+  quint8 checksum = 0;
+  for (char c : body) {
+    checksum ^= static_cast<quint8>(c);
+  }
+  return "$" + body + "*" + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() +
+         "\r\n";
+}
+
+// One u-blox style multi-constellation cycle
+QByteArray cycle(const QByteArray& time) {
+  return sentence("GNRMC," + time + ",A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A") +
+         sentence("GNVTG,084.4,T,,M,022.4,N,041.5,K,A") +
+         sentence("GNGGA," + time + ",4807.038,N,01131.000,E,1,12,0.9,545.4,M,46.9,M,,") +
+         sentence("GNGSA,A,3,01,02,03,,,,,,,,,,1.5,0.9,1.2") +
+         sentence("GNGSA,A,3,65,66,,,,,,,,,,,1.5,0.9,1.2") +
+         sentence("GPGSV,1,1,03,01,40,083,46,02,17,308,41,03,07,344,39") +
+         sentence("GLGSV,1,1,02,65,30,120,40,66,12,200,35");
+}
+
+int feed(NmeaParser& parser, const QByteArray& text, NmeaParser::Epoch* epochs,
+         int maxEpochs = 8) {
+  parser.append(text.constData(), static_cast<int>(text.size()));
+  return parser.parse(epochs, maxEpochs);
+}
+
+}  // namespace
+
+class TestNmeaParser : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testNumbers() {
+    double value = 0;
+    QVERIFY(NmeaParser::parseDecimal("-12.345", &value));
+    QCOMPARE(value, -12.345);
+    QVERIFY(NmeaParser::parseDecimal("0.0001", &value));
+    QCOMPARE(value, 0.0001);
+    QVERIFY(NmeaParser::parseDecimal("545", &value));
+    QCOMPARE(value, 545.0);
+    QVERIFY(!NmeaParser::parseDecimal("", &value));
+    QVERIFY(!NmeaParser::parseDecimal(".", &value));
+    QVERIFY(!NmeaParser::parseDecimal("1.2.3", &value));
+    QVERIFY(!NmeaParser::parseDecimal("1,5", &value));
+
+    QVERIFY(NmeaParser::parseCoordinate("4807.038", "N", &value));
+    QVERIFY(std::fabs(value - (48 + 7.038 / 60)) < 1e-12);
+    QVERIFY(NmeaParser::parseCoordinate("01131.000", "W", &value));
+    QVERIFY(std::fabs(value + (11 + 31.0 / 60)) < 1e-12);
+    QVERIFY(!NmeaParser::parseCoordinate("4875.000", "N", &value));  // 75 minutes
+    QVERIFY(!NmeaParser::parseCoordinate("4807.038", "X", &value));
+  }
+
+  void testChecksum() {
+    QVERIFY(NmeaParser::verifyChecksum(
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47"));
+    QVERIFY(NmeaParser::verifyChecksum(
+        "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6a"));
+    QVERIFY(!NmeaParser::verifyChecksum(
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*48"));
+    QVERIFY(!NmeaParser::verifyChecksum("$GPGGA,123519"));
+
+    NmeaParser parser;
+    NmeaParser::Epoch epochs[4];
+    QByteArray corrupt = sentence("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,,M,,");
+    corrupt[20] = '9';
+    QCOMPARE(feed(parser, corrupt + "no dollar\r\n" + sentence("GPTXT,01,01,02,hello"), epochs),
+             0);
+    QCOMPARE(parser.stats().checksumErrors, quint64(1));
+    QCOMPARE(parser.stats().malformed, quint64(1));
+    QCOMPARE(parser.stats().ignored, quint64(1));
+    QCOMPARE(parser.stats().sentences, quint64(0));
+  }
+
+  void testCycleMergesIntoOneEpoch() {
+    NmeaParser parser;
+    NmeaParser::Epoch epochs[8];
+
+    // The first cycle is only known to be over when the next one starts
+    QCOMPARE(feed(parser, cycle("123519.00"), epochs), 0);
+    QCOMPARE(feed(parser, cycle("123520.00"), epochs), 2);
+
+    const NmeaParser::Epoch& epoch = epochs[0];
+    QCOMPARE(epoch.timeMs, ((12 * 60 + 35) * 60 + 19) * 1000);
+    QVERIFY(epoch.fields & NmeaParser::Date);
+    QCOMPARE(epoch.year, quint16(1994));
+    QCOMPARE(epoch.month, quint8(3));
+    QCOMPARE(epoch.day, quint8(23));
+    QVERIFY(epoch.fields & NmeaParser::Position);
+    QVERIFY(std::fabs(epoch.latitude - (48 + 7.038 / 60)) < 1e-12);
+    QVERIFY(std::fabs(epoch.longitude - (11 + 31.0 / 60)) < 1e-12);
+    QCOMPARE(epoch.altitude, 545.4);
+    QVERIFY(std::fabs(epoch.speed - 41.5 / 3.6) < 1e-9);  // VTG km/h over RMC knots
+    QCOMPARE(epoch.course, 84.4);
+    QCOMPARE(epoch.satellites, quint8(12));
+    QCOMPARE(epoch.fixMode, quint8(3));
+    QCOMPARE(epoch.hdop, 0.9);
+    QCOMPARE(epoch.vdop, 1.2);
+    QCOMPARE(epoch.pdop, 1.5);
+
+    // From then on the second GSA closes each epoch as it arrives
+    QCOMPARE(epochs[1].timeMs, ((12 * 60 + 35) * 60 + 20) * 1000);
+    const QByteArray next = cycle("123521.50");
+    const int gsaEnd = static_cast<int>(next.indexOf("GPGSV")) - 1;
+    QCOMPARE(feed(parser, next.left(gsaEnd), epochs), 1);
+    QCOMPARE(epochs[0].timeMs, ((12 * 60 + 35) * 60 + 21) * 1000 + 500);
+    QCOMPARE(feed(parser, next.mid(gsaEnd), epochs), 0);
+
+    QCOMPARE(parser.stats().epochs, quint64(3));
+    QCOMPARE(parser.stats().sentences, quint64(15));
+    QCOMPARE(parser.stats().ignored, quint64(6));  // GSV
+  }
+
+  void testStreamedByteByByte() {
+    NmeaParser parser;
+    NmeaParser::Epoch epochs[2];
+    const QByteArray stream = cycle("000001") + cycle("000002") + cycle("000003");
+    int total = 0;
+    for (char c : stream) {
+      parser.append(&c, 1);
+      total += parser.parse(epochs, 2);
+    }
+    QCOMPARE(total, 3);
+    QCOMPARE(epochs[0].timeMs, 3000);
+    QCOMPARE(parser.stats().checksumErrors, quint64(0));
+    QCOMPARE(parser.buffered(), 0);
+  }
+
+  void testNoFixAndSingleSentenceReceiver() {
+    NmeaParser parser;
+    NmeaParser::Epoch epochs[4];
+    QCOMPARE(feed(parser, sentence("GPGGA,000001,,,,,0,00,99.9,,M,,M,,"), epochs), 0);
+
+    // A new GGA ends the epoch, and GGA is learned as the last of a cycle
+    QCOMPARE(feed(parser, sentence("GPGGA,000002,,,,,0,00,99.9,,M,,M,,"), epochs), 2);
+    QVERIFY(!(epochs[0].fields & NmeaParser::Position));
+    QCOMPARE(epochs[0].quality, quint8(0));
+
+    QCOMPARE(feed(parser,
+                  sentence("GPGGA,000003,5140.1234,N,00009.5678,W,1,08,0.9,100.0,M,47.0,M,,"),
+                  epochs),
+             1);
+    QVERIFY(epochs[0].fields & NmeaParser::Position);
+    QVERIFY(epochs[0].longitude < 0);
+    QVERIFY(!parser.finishEpoch(epochs));
+
+    // A void RMC carries time and date but no position
+    NmeaParser rmc;
+    feed(rmc, sentence("GPRMC,000004,V,,,,,,,010125,,,N"), epochs);
+    QVERIFY(rmc.finishEpoch(epochs));
+    QVERIFY(epochs[0].fields & NmeaParser::Date);
+    QVERIFY(!(epochs[0].fields & NmeaParser::Position));
+    QCOMPARE(epochs[0].year, quint16(2025));
+  }
+
+  void testOverlongLineIsDropped() {
+    NmeaParser parser;
+    NmeaParser::Epoch epochs[4];
+    const QByteArray junk(NmeaParser::kMaxSentenceLength + 50, 'x');
+    QCOMPARE(feed(parser, junk, epochs), 0);
+    QCOMPARE(parser.buffered(), 0);
+    QCOMPARE(feed(parser, "tail of junk\r\n" + sentence("GPGGA,000001,,,,,0,00,,,M,,M,,"), epochs),
+             0);
+    QVERIFY(parser.finishEpoch(epochs));
+    QCOMPARE(parser.stats().malformed, quint64(1));
+  }
+
+  void testDeviceEmitsOncePerEpoch() {
+    MockTransport transport;
+    GPSDevice device(&transport);
+    QVERIFY(device.initialize());
+
+    QList<GPSLocation> updates;
+    QList<quint8> satellites;
+    connect(&device, &GPSDevice::locationUpdated, this,
+            [&](const GPSLocation& location) { updates.append(location); });
+    connect(&device, &GPSDevice::satellitesChanged, this,
+            [&](quint8 count) { satellites.append(count); });
+
+    transport.injectData(cycle("123519.00"));
+    transport.injectData(cycle("123520.00"));
+    const QByteArray third = cycle("123521.00");
+    transport.injectData(third.left(100));
+    transport.injectData(third.mid(100));
+    QCOMPARE(updates.size(), 3);
+    QCOMPARE(satellites, QList<quint8>{12});
+
+    const GPSLocation location = device.getCurrentLocation();
+    QVERIFY(std::fabs(location.latitude - (48 + 7.038 / 60)) < 1e-9);
+    QCOMPARE(location.altitude, 545.4);
+    QCOMPARE(location.fixType, QString("3D"));
+    QCOMPARE(location.vdop, 1.2);
+    QCOMPARE(location.timestamp,
+             QDateTime(QDate(1994, 3, 23), QTime(12, 35, 21), QTimeZone::utc()));
+    QCOMPARE(device.parserStats().epochs, quint64(3));
+  }
+};
+
+QTEST_MAIN(TestNmeaParser)
+#include "test_nmea_parser.moc"
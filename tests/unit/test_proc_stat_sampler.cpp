@@ -0,0 +1,132 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QElapsedTimer>
+#include <QTest>
+#include <QThread>
+#include <atomic>
+
+#include "../core/services/diagnostics/ProcStatSampler.h"
+
+using namespace crankshaft::diagnostics;
+
+class TestProcStatSampler : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testParseStatWithAwkwardComm() {
+    const char* line =
+        "4242 (queue0:src) x) S 1 4242 4242 0 -1 4194560 1500 0 7 0 120 30 0 0 20 0 5 0 "
+        "123456 104857600 2560 18446744073709551615\n";
+
+    ProcStatSampler::StatFields fields;
+    QVERIFY(ProcStatSampler::parseStat(line, &fields));
+    QCOMPARE(fields.comm, QStringLiteral("queue0:src) x"));
+    QCOMPARE(fields.minorFaults, quint64(1500));
+    QCOMPARE(fields.majorFaults, quint64(7));
+    QCOMPARE(fields.userTicks, quint64(120));
+    QCOMPARE(fields.systemTicks, quint64(30));
+    QCOMPARE(fields.numThreads, 5);
+    QCOMPARE(fields.rssPages, quint64(2560));
+
+    QVERIFY(!ProcStatSampler::parseStat("4242 (short) S 1 2 3", &fields));
+    QVERIFY(!ProcStatSampler::parseStat("", &fields));
+  }
+
+  void testParseContextSwitches() {
+    const char* status =
+        "Name:\tAASDKThread\n"
+        "State:\tS (sleeping)\n"
+        "voluntary_ctxt_switches:\t1234\n"
+        "nonvoluntary_ctxt_switches:\t56\n";
+
+    quint64 voluntary = 0;
+    quint64 involuntary = 0;
+    QVERIFY(ProcStatSampler::parseContextSwitches(status, &voluntary, &involuntary));
+    QCOMPARE(voluntary, quint64(1234));
+    QCOMPARE(involuntary, quint64(56));
+  }
+
+  void testThreadGroups() {
+    QCOMPARE(ProcStatSampler::threadGroup("crankshaft-core", true), QStringLiteral("main"));
+    QCOMPARE(ProcStatSampler::threadGroup("h264parse0:src", false), QStringLiteral("gstreamer"));
+    QCOMPARE(ProcStatSampler::threadGroup("AASDKThread", false), QStringLiteral("aasdk"));
+    QCOMPARE(ProcStatSampler::threadGroup("Thread (pooled)", false), QStringLiteral("pool"));
+    // Unknown names share one group, so the label set stays bounded
+    QCOMPARE(ProcStatSampler::threadGroup("BusyWorker", false), QStringLiteral("other"));
+    QCOMPARE(ProcStatSampler::threadGroup("worker-4711", false), QStringLiteral("other"));
+  }
+
+  void testBusyThreadIsAttributed() {
+    MetricsRegistry registry;
+    ProcStatSampler sampler(&registry);
+    sampler.setMinimumInterval(0);
+
+    const ProcStatSampler::Sample baseline = sampler.sample();
+    QVERIFY(baseline.valid);
+    QVERIFY(baseline.rssMb > 0.0);
+
+    std::atomic<bool> stop{false};
+    QThread* worker = QThread::create([&stop]() {
+      volatile quint64 spin = 0;
+      while (!stop.load(std::memory_order_relaxed)) spin = spin + 1;
+    });
+    worker->setObjectName("AASDKThread");  // a named group of its own
+    worker->start();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 400) QThread::msleep(20);
+    const ProcStatSampler::Sample sample = sampler.sample();
+
+    stop = true;
+    QVERIFY(worker->wait(5000));
+    delete worker;
+
+    QVERIFY(sample.valid);
+    QVERIFY(sample.intervalMs > 0.0);
+    QVERIFY(sample.threadCount >= 2);
+    QVERIFY(sample.cpuByGroup.contains("main"));
+    QVERIFY2(sample.cpuByGroup.value("aasdk") > 25.0,
+             qPrintable(QString("Worker at %1%").arg(sample.cpuByGroup.value("aasdk"))));
+    QVERIFY(sample.processCpuPercent >= sample.cpuByGroup.value("aasdk") * 0.5);
+
+    Gauge& gauge = registry.gauge("thread_cpu_percent", QString(), {{"thread", "aasdk"}});
+    QCOMPARE(gauge.value(), sample.cpuByGroup.value("aasdk"));
+
+    // The worker has exited, so its group reads as idle on the next sample
+    QThread::msleep(20);
+    sampler.sample();
+    QCOMPARE(gauge.value(), 0.0);
+  }
+
+  void testMinimumIntervalReturnsCachedSample() {
+    ProcStatSampler sampler;
+    sampler.setMinimumInterval(60000);
+
+    const ProcStatSampler::Sample first = sampler.sample();
+    const ProcStatSampler::Sample second = sampler.sample();
+    QVERIFY(first.valid);
+    QCOMPARE(second.timestamp, first.timestamp);
+    QCOMPARE(second.intervalMs, 0.0);
+  }
+};
+
+QTEST_MAIN(TestProcStatSampler)
+#include "test_proc_stat_sampler.moc"
@@ -0,0 +1,250 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <limits>
+
+#include "../core/services/diagnostics/MetricsRegistry.h"
+#include "../core/services/extensions/ResourceGovernor.h"
+
+using crankshaft::diagnostics::MetricsRegistry;
+
+namespace {
+
+QByteArray readControl(const QString& cgroup, const QString& name) {
+  QFile file(cgroup + "/" + name);
+  return file.open(QIODevice::ReadOnly) ? file.readAll().trimmed() : QByteArray();
+}
+
+void writePressure(const QString& dir, const QString& resource, double someAvg10) {
+  QFile file(dir + "/" + resource);
+  QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  file.write(QString("some avg10=%1 avg60=0.00 avg300=0.00 total=1000\n"
+                     "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n")
+                 .arg(someAvg10, 0, 'f', 2)
+                 .toUtf8());
+}
+
+}  // namespace
+
+class TestResourceGovernor : public QObject {
+  Q_OBJECT
+
+  using Class = ResourceGovernor::ResourceClass;
+  using Level = ResourceGovernor::Level;
+
+ private slots:
+  void testParsePressure() {
+    ResourceGovernor::Pressure pressure;
+    QVERIFY(ResourceGovernor::parsePressure("some avg10=12.50 avg60=3.00 avg300=1.00 total=99\n"
+                                            "full avg10=4.25 avg60=1.00 avg300=0.50 total=12\n",
+                                            &pressure));
+    QVERIFY(pressure.valid);
+    QCOMPARE(pressure.someAvg10, 12.5);
+    QCOMPARE(pressure.fullAvg10, 4.25);
+
+    // Kernels before 5.13 have no full line for cpu
+    QVERIFY(ResourceGovernor::parsePressure("some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n",
+                                            &pressure));
+    QCOMPARE(pressure.fullAvg10, 0.0);
+
+    QVERIFY(!ResourceGovernor::parsePressure("", &pressure));
+    QVERIFY(!ResourceGovernor::parsePressure("garbage\n", &pressure));
+    QVERIFY(!pressure.valid);
+  }
+
+  void testLevels() {
+    QCOMPARE(ResourceGovernor::levelFor(false, false, false), Level::Relaxed);
+    QCOMPARE(ResourceGovernor::levelFor(true, false, false), Level::Constrained);
+    QCOMPARE(ResourceGovernor::levelFor(false, true, false), Level::Constrained);
+    QCOMPARE(ResourceGovernor::levelFor(false, false, true), Level::Constrained);
+    QCOMPARE(ResourceGovernor::levelFor(true, true, false), Level::Strict);
+    QCOMPARE(ResourceGovernor::levelFor(false, true, true), Level::Strict);
+    QCOMPARE(ResourceGovernor::levelFor(true, true, true), Level::Strict);
+  }
+
+  void testLimitsTightenWithLevelAndClass() {
+    const QList<Class> classes{Class::Background, Class::Normal, Class::Interactive};
+    const QList<Level> levels{Level::Relaxed, Level::Constrained, Level::Strict};
+    auto memory = [](qint64 bytes) {
+      return bytes < 0 ? std::numeric_limits<qint64>::max() : bytes;  // "max"
+    };
+
+    for (Class resourceClass : classes) {
+      for (int i = 1; i < levels.size(); ++i) {
+        const auto looser = ResourceGovernor::limitsFor(resourceClass, levels[i - 1]);
+        const auto tighter = ResourceGovernor::limitsFor(resourceClass, levels[i]);
+        QVERIFY(tighter.cpuQuotaUs > 0);
+        QVERIFY(tighter.cpuQuotaUs < looser.cpuQuotaUs);
+        QVERIFY(tighter.cpuWeight < looser.cpuWeight);
+        QVERIFY(tighter.ioWeight < looser.ioWeight);
+        QVERIFY(memory(tighter.memoryHighBytes) < memory(looser.memoryHighBytes));
+      }
+    }
+    for (Level level : levels) {
+      for (int i = 1; i < classes.size(); ++i) {
+        const auto lower = ResourceGovernor::limitsFor(classes[i - 1], level);
+        const auto higher = ResourceGovernor::limitsFor(classes[i], level);
+        QVERIFY(lower.cpuQuotaUs < higher.cpuQuotaUs);
+        QVERIFY(lower.cpuWeight <= higher.cpuWeight);
+      }
+    }
+    // Nothing an extension can do while projecting outweighs the core
+    for (Class resourceClass : classes) {
+      QVERIFY(ResourceGovernor::limitsFor(resourceClass, Level::Constrained).cpuWeight < 100);
+    }
+
+    QCOMPARE(ResourceGovernor::resourceClassFromString("background"), Class::Background);
+    QCOMPARE(ResourceGovernor::resourceClassFromString("interactive"), Class::Interactive);
+    QCOMPARE(ResourceGovernor::resourceClassFromString("bogus"), Class::Normal);
+  }
+
+  void testTrackAppliesAndFollowsState() {
+    QTemporaryDir cgroup;
+    QVERIFY(cgroup.isValid());
+    ResourceGovernor governor;
+    QSignalSpy levels(&governor, &ResourceGovernor::levelChanged);
+
+    governor.track("nav", cgroup.path(), Class::Normal);
+    QVERIFY(governor.isTracked("nav"));
+    QCOMPARE(readControl(cgroup.path(), "cpu.max"), QByteArray("50000 100000"));
+    QCOMPARE(readControl(cgroup.path(), "cpu.weight"), QByteArray("100"));
+    QCOMPARE(readControl(cgroup.path(), "io.weight"), QByteArray("default 100"));
+    QCOMPARE(readControl(cgroup.path(), "memory.high"), QByteArray("max"));
+
+    governor.setProjectionActive(true);
+    QCOMPARE(governor.level(), Level::Constrained);
+    QCOMPARE(readControl(cgroup.path(), "cpu.max"), QByteArray("25000 100000"));
+    QCOMPARE(readControl(cgroup.path(), "cpu.weight"), QByteArray("40"));
+    QCOMPARE(readControl(cgroup.path(), "memory.high"), QByteArray::number(256 * 1024 * 1024));
+
+    governor.setDriving(true);
+    QCOMPARE(governor.level(), Level::Strict);
+    QCOMPARE(readControl(cgroup.path(), "cpu.max"), QByteArray("10000 100000"));
+    QCOMPARE(readControl(cgroup.path(), "io.weight"), QByteArray("default 10"));
+
+    governor.setProjectionActive(false);
+    governor.setDriving(false);
+    QCOMPARE(governor.level(), Level::Relaxed);
+    QCOMPARE(readControl(cgroup.path(), "cpu.max"), QByteArray("50000 100000"));
+    QCOMPARE(readControl(cgroup.path(), "memory.high"), QByteArray("max"));
+
+    QCOMPARE(levels.count(), 4);
+    QCOMPARE(levels.at(1).first().value<Level>(), Level::Strict);
+
+    const QJsonObject status = governor.status();
+    QCOMPARE(status.value("level").toString(), QString("relaxed"));
+    const QJsonObject nav = status.value("extensions").toObject().value("nav").toObject();
+    QCOMPARE(nav.value("class").toString(), QString("normal"));
+    QCOMPARE(nav.value("cpu_quota_us").toInteger(), qint64(50000));
+  }
+
+  void testOnlyChangesAreWritten() {
+    QTemporaryDir cgroup;
+    QVERIFY(cgroup.isValid());
+    MetricsRegistry registry;
+    ResourceGovernor governor(&registry);
+    auto writes = [&registry]() {
+      return registry.counter("extension_governor_writes_total").value();
+    };
+
+    governor.track("music", cgroup.path(), Class::Interactive);
+    QCOMPARE(writes(), quint64(4));
+    governor.setDriving(true);
+    QCOMPARE(writes(), quint64(8));
+    governor.setDriving(true);
+    QCOMPARE(writes(), quint64(8));
+    QCOMPARE(registry.gauge("extension_governor_level").value(), 1.0);
+
+    // A stopped extension's cgroup is left alone
+    governor.untrack("music");
+    QVERIFY(!governor.isTracked("music"));
+    governor.setDriving(false);
+    QCOMPARE(writes(), quint64(8));
+  }
+
+  void testPressureHysteresis() {
+    QTemporaryDir cgroup;
+    QTemporaryDir pressure;
+    QVERIFY(cgroup.isValid() && pressure.isValid());
+    writePressure(pressure.path(), "cpu", 0.0);
+    writePressure(pressure.path(), "memory", 0.0);
+    writePressure(pressure.path(), "io", 0.0);
+
+    ResourceGovernor governor;
+    governor.setPressureDirectory(pressure.path());
+    governor.track("hog", cgroup.path(), Class::Background);
+    governor.samplePressure();
+    QVERIFY(!governor.isUnderPressure());
+
+    writePressure(pressure.path(), "memory", 35.0);
+    governor.samplePressure();
+    QVERIFY(governor.isUnderPressure());
+    QCOMPARE(governor.level(), Level::Constrained);
+    QCOMPARE(readControl(cgroup.path(), "cpu.max"), QByteArray("10000 100000"));
+
+    // Between the watermarks nothing changes
+    writePressure(pressure.path(), "memory", 10.0);
+    governor.samplePressure();
+    QVERIFY(governor.isUnderPressure());
+
+    // Relief has to last releasePolls polls in a row
+    const int releasePolls = governor.thresholds().releasePolls;
+    writePressure(pressure.path(), "memory", 2.0);
+    for (int i = 1; i < releasePolls; ++i) {
+      governor.samplePressure();
+      QVERIFY(governor.isUnderPressure());
+    }
+    writePressure(pressure.path(), "memory", 6.0);
+    governor.samplePressure();
+    writePressure(pressure.path(), "memory", 2.0);
+    for (int i = 1; i < releasePolls; ++i) {
+      governor.samplePressure();
+      QVERIFY(governor.isUnderPressure());
+    }
+    governor.samplePressure();
+    QVERIFY(!governor.isUnderPressure());
+    QCOMPARE(governor.level(), Level::Relaxed);
+    QCOMPARE(readControl(cgroup.path(), "cpu.max"), QByteArray("25000 100000"));
+
+    // Pressure while projecting goes straight to strict
+    governor.setProjectionActive(true);
+    writePressure(pressure.path(), "cpu", 50.0);
+    governor.samplePressure();
+    QCOMPARE(governor.level(), Level::Strict);
+    QCOMPARE(governor.status().value("pressure_some_avg10").toObject().value("cpu").toDouble(),
+             50.0);
+  }
+
+  void testStartWithoutPsi() {
+    QTemporaryDir empty;
+    QVERIFY(empty.isValid());
+    ResourceGovernor governor;
+    governor.setPressureDirectory(empty.path());
+    QVERIFY(!governor.start());
+    governor.setDriving(true);
+    QCOMPARE(governor.level(), Level::Constrained);
+  }
+};
+
+QTEST_MAIN(TestResourceGovernor)
+#include "test_resource_governor.moc"
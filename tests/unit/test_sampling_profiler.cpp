@@ -0,0 +1,121 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+#include <atomic>
+
+#include "../core/services/diagnostics/SamplingProfiler.h"
+
+using namespace crankshaft::diagnostics;
+
+// Exported with a plain name so the folded output can be checked for it
+extern "C" __attribute__((noinline)) void crankshaftProfilerBurnCpu(std::atomic<bool>* stop) {
+  volatile quint64 spin = 0;
+  while (!stop->load(std::memory_order_relaxed)) spin = spin + 1;
+}
+
+class TestSamplingProfiler : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testBusyThreadAppearsInFoldedOutput() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("profile.folded");
+
+    std::atomic<bool> stop{false};
+    QThread* worker = QThread::create([&stop]() { crankshaftProfilerBurnCpu(&stop); });
+    worker->setObjectName("BurnWorker");
+    worker->start();
+    QTest::qWait(20);  // let the thread appear in /proc/self/task
+
+    SamplingProfiler profiler;
+    QSignalSpy finished(&profiler, &SamplingProfiler::finished);
+    SamplingProfiler::Options options;
+    options.frequencyHz = 200;
+    options.outputPath = path;
+    QVERIFY(profiler.start(options));
+    QVERIFY(profiler.isRunning());
+
+    QString error;
+    QVERIFY(!profiler.start(options, &error));
+    QCOMPARE(error, QStringLiteral("already running"));
+
+    QTest::qWait(500);
+    QVERIFY(profiler.status().samples > 0);
+    const SamplingProfiler::Result result = profiler.stop();
+
+    stop = true;
+    QVERIFY(worker->wait(5000));
+    delete worker;
+
+    QVERIFY2(result.valid, qPrintable(result.error));
+    QVERIFY(!profiler.isRunning());
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(result.outputPath, path);
+    QVERIFY2(result.samples >= 20, qPrintable(QString("%1 samples").arg(result.samples)));
+    QVERIFY(result.handlerNsPerSample > 0.0);
+    QVERIFY(result.overheadPercent < 5.0);
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    QCOMPARE(lines.size(), result.uniqueStacks);
+
+    static const QRegularExpression kFolded("^[^ ;]+(;[^;]+)* \\d+$");
+    quint64 total = 0;
+    quint64 burning = 0;
+    for (const QString& line : lines) {
+      QVERIFY2(kFolded.match(line).hasMatch(), qPrintable(line));
+      const quint64 count = line.section(' ', -1).toULongLong();
+      total += count;
+      if (line.startsWith("BurnWorker;") && line.contains("crankshaftProfilerBurnCpu")) {
+        burning += count;
+      }
+    }
+    QCOMPARE(total, result.samples);
+    QVERIFY2(burning > total / 2, qPrintable(QString("%1 of %2").arg(burning).arg(total)));
+  }
+
+  void testStopWhenIdleReportsError() {
+    SamplingProfiler profiler;
+    const SamplingProfiler::Result result = profiler.stop();
+    QVERIFY(!result.valid);
+    QCOMPARE(result.error, QStringLiteral("not running"));
+  }
+
+  void testFrequencyIsCapped() {
+    QTemporaryDir dir;
+    SamplingProfiler profiler;
+    SamplingProfiler::Options options;
+    options.frequencyHz = 100000;
+    options.outputPath = dir.filePath("capped.folded");
+    QVERIFY(profiler.start(options));
+    QCOMPARE(profiler.status().finalFrequencyHz, SamplingProfiler::kMaxFrequencyHz);
+    QVERIFY(profiler.stop().valid);
+  }
+};
+
+QTEST_MAIN(TestSamplingProfiler)
+#include "test_sampling_profiler.moc"
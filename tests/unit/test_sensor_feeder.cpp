@@ -0,0 +1,234 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include <QDateTime>
+#include <QTest>
+#include <QVector>
+#include <cstdlib>
+#include <limits>
+
+#include "../core/services/android_auto/SensorFeeder.h"
+
+namespace {
+
+constexpr qint64 kMs = 1000000LL;
+constexpr qint64 kStepNs = 20 * kMs;
+
+using Sensor = SensorFeeder::Sensor;
+using Batch = SensorFeeder::Batch;
+
+qint64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+VehicleState drivingState(qint64 timestampNs) {
+  VehicleState state{};
+  state.latitude = 52.5200066;
+  state.longitude = 13.4049540;
+  state.speed = 13.5f;
+  state.heading = 271.25f;
+  state.positionAccuracy = 2.5f;
+  state.flags = VehicleState::PositionValid | VehicleState::HeadingValid |
+                VehicleState::SpeedValid;
+  state.timestampNs = timestampNs;
+  return state;
+}
+
+// Stands in for the phone end of the sensor channel
+struct MockPhone {
+  explicit MockPhone(SensorFeeder* feeder) {
+    QObject::connect(feeder, &SensorFeeder::batchReady,
+                     [this](const Batch& batch) { batches.append(batch); });
+  }
+
+  int count(quint8 field) const {
+    int n = 0;
+    for (const Batch& batch : batches) {
+      n += (batch.fields & field) ? 1 : 0;
+    }
+    return n;
+  }
+
+  // Shortest time between two samples of one sensor
+  qint64 minIntervalNs(quint8 field) const {
+    qint64 previous = -1;
+    qint64 shortest = std::numeric_limits<qint64>::max();
+    for (const Batch& batch : batches) {
+      if (!(batch.fields & field)) continue;
+      if (previous >= 0) shortest = qMin(shortest, batch.timestampNs - previous);
+      previous = batch.timestampNs;
+    }
+    return shortest;
+  }
+
+  QVector<Batch> batches;
+};
+
+}  // namespace
+
+class TestSensorFeeder : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testRequests() {
+    SensorFeeder feeder;
+    QVERIFY(feeder.requestSensor(Sensor::Location, 1000));
+    QVERIFY(feeder.requestSensor(Sensor::Speed, 5));
+    QVERIFY(feeder.requestSensor(Sensor::Compass, 0));
+    QVERIFY(!feeder.requestSensor(static_cast<Sensor>(4), 100));  // RPM
+    QVERIFY(!SensorFeeder::isSupported(static_cast<Sensor>(21)));
+
+    QCOMPARE(feeder.periodMs(Sensor::Location), qint64(1000));
+    QCOMPARE(feeder.periodMs(Sensor::Speed), SensorFeeder::kMinPeriodMs);
+    QVERIFY(feeder.periodMs(Sensor::Compass) > 0);
+    QVERIFY(feeder.isActive(Sensor::Compass));
+    QVERIFY(!feeder.isActive(Sensor::NightMode));
+
+    feeder.stopSensor(Sensor::Compass);
+    QVERIFY(!feeder.isActive(Sensor::Compass));
+    feeder.stopAll();
+    QVERIFY(!feeder.isActive(Sensor::Location));
+  }
+
+  void testRatesFollowRequests() {
+    SensorFeeder feeder;
+    MockPhone phone(&feeder);
+    const qint64 startNs = monotonicNs();
+
+    // Nothing is sent before the phone asks
+    feeder.updateVehicleState(drivingState(startNs - kStepNs));
+    QVERIFY(phone.batches.isEmpty());
+
+    feeder.requestSensor(Sensor::Location, 1000);
+    feeder.requestSensor(Sensor::Speed, 100);
+    feeder.requestSensor(Sensor::Compass, 200);
+
+    // 10 s of fused state at 50 Hz, stepped with a little timer jitter
+    for (qint64 t = 0; t < 10000 * kMs; t += kStepNs) {
+      const qint64 jitter = (t / kStepNs) % 3 == 0 ? 2 * kMs : 0;
+      feeder.updateVehicleState(drivingState(startNs + t + jitter));
+    }
+
+    QCOMPARE(phone.count(Batch::HasLocation), 10);
+    QCOMPARE(phone.count(Batch::HasSpeed), 100);
+    QCOMPARE(phone.count(Batch::HasCompass), 50);
+    const qint64 slack = SensorFeeder::kScheduleSlackNs;
+    QVERIFY(phone.minIntervalNs(Batch::HasLocation) >= 1000 * kMs - slack);
+    QVERIFY(phone.minIntervalNs(Batch::HasSpeed) >= 100 * kMs - slack);
+    QVERIFY(phone.minIntervalNs(Batch::HasCompass) >= 200 * kMs - slack);
+
+    // Harmonic periods share batches: one message per speed sample
+    QCOMPARE(phone.batches.size(), 100);
+    QCOMPARE(feeder.stats().batches, quint64(100));
+    QCOMPARE(feeder.stats().samples, quint64(160));
+
+    const Batch& first = phone.batches.first();
+    QCOMPARE(first.fields & Batch::HasLocation, int(Batch::HasLocation));
+    QCOMPARE(first.latitudeE7, 525200066);
+    QCOMPARE(first.longitudeE7, 134049540);
+    QCOMPARE(first.accuracyE3, quint32(2500));
+    QCOMPARE(first.speedE3, 13500);
+    QCOMPARE(first.bearingE6, 271250000);
+    QVERIFY(first.fields & Batch::SpeedValid);
+    QVERIFY(first.fields & Batch::BearingValid);
+    // Location time is wall clock
+    const qint64 wallMs = QDateTime::currentMSecsSinceEpoch();
+    QVERIFY(std::llabs(static_cast<qint64>(first.timestampMs) - wallMs) < 60000);
+  }
+
+  void testOnlyValidAndNewDataIsSent() {
+    SensorFeeder feeder;
+    MockPhone phone(&feeder);
+    feeder.requestSensor(Sensor::Location, 100);
+    feeder.requestSensor(Sensor::Speed, 100);
+
+    // Wheel speed but no fix yet
+    VehicleState state = drivingState(monotonicNs());
+    state.flags = VehicleState::SpeedValid;
+    feeder.updateVehicleState(state);
+    QCOMPARE(phone.batches.size(), 1);
+    QCOMPARE(phone.batches.last().fields, quint8(Batch::HasSpeed | Batch::SpeedValid));
+
+    // The fix arrives: location goes out at once, speed waits for its period
+    state.flags |= VehicleState::PositionValid;
+    state.timestampNs += kStepNs;
+    feeder.updateVehicleState(state);
+    QCOMPARE(phone.batches.size(), 2);
+    QCOMPARE(phone.batches.last().fields, quint8(Batch::HasLocation | Batch::SpeedValid));
+
+    // The newer speed goes out once its period is up, then nothing more
+    // until a newer state arrives, however long the wait
+    feeder.flush(state.timestampNs + 1000 * kMs);
+    QCOMPARE(phone.batches.size(), 3);
+    QCOMPARE(phone.batches.last().fields, quint8(Batch::HasSpeed | Batch::SpeedValid));
+    feeder.flush(state.timestampNs + 10000 * kMs);
+    QCOMPARE(phone.batches.size(), 3);
+
+    // Heading stays invalid, so the location carries no bearing
+    state.timestampNs += 10000 * kMs;
+    feeder.updateVehicleState(state);
+    QCOMPARE(phone.batches.size(), 4);
+    QCOMPARE(phone.batches.last().fields,
+             quint8(Batch::HasLocation | Batch::HasSpeed | Batch::SpeedValid));
+    QCOMPARE(phone.count(Batch::HasSpeed), 3);
+  }
+
+  void testEventSensors() {
+    SensorFeeder feeder;
+    MockPhone phone(&feeder);
+
+    // Changes nobody asked for go nowhere
+    feeder.setNightMode(true);
+    feeder.setDriving(true);
+    QVERIFY(phone.batches.isEmpty());
+
+    // The current values follow a start request
+    feeder.requestSensor(Sensor::NightMode, 0);
+    feeder.requestSensor(Sensor::DrivingStatus, 0);
+    feeder.flush(monotonicNs());
+    QCOMPARE(phone.batches.size(), 1);
+    QCOMPARE(phone.batches.last().fields, quint8(Batch::HasNightMode | Batch::HasDrivingStatus));
+    QCOMPARE(phone.batches.last().nightMode, true);
+    QCOMPARE(phone.batches.last().drivingStatus, SensorFeeder::kDrivingFullyRestricted);
+
+    // Then each change, once
+    feeder.setNightMode(false);
+    feeder.setNightMode(false);
+    QCOMPARE(phone.batches.size(), 2);
+    QCOMPARE(phone.batches.last().fields, quint8(Batch::HasNightMode));
+    QCOMPARE(phone.batches.last().nightMode, false);
+
+    feeder.setDriving(false);
+    QCOMPARE(phone.batches.size(), 3);
+    QCOMPARE(phone.batches.last().drivingStatus, SensorFeeder::kDrivingUnrestricted);
+
+    // A new session starts from nothing
+    feeder.stopAll();
+    feeder.setNightMode(true);
+    feeder.flush(monotonicNs());
+    QCOMPARE(phone.batches.size(), 3);
+  }
+};
+
+QTEST_MAIN(TestSensorFeeder)
+#include "test_sensor_feeder.moc"
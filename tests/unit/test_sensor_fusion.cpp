@@ -0,0 +1,406 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <sys/mman.h>
+
+#include <QSignalSpy>
+#include <QTest>
+#include <QVector>
+#include <cmath>
+#include <functional>
+#include <random>
+
+#include "../core/services/eventbus/EventBus.h"
+#include "../core/services/extensions/DataChannelHub.h"
+#include "../core/services/vehicle/SensorFusionService.h"
+#include "../core/services/vehicle/VehicleStateFilter.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kLatitude = 48.1173;
+constexpr double kLongitude = 11.5167;
+constexpr double kMetresPerDegree = 6378137.0 * kPi / 180.0;
+constexpr qint64 kMs = 1000000LL;
+constexpr qint64 kStepNs = 20 * kMs;
+
+// One recorded sample: GPS fix (10 Hz), wheel speed (25 Hz) or IMU (100 Hz)
+struct LogRecord {
+  enum Kind { Gps, WheelSpeed, Imu } kind;
+  qint64 timestampNs;
+  double values[5];
+};
+
+// Where the vehicle really was, for comparison with the fused state
+struct Truth {
+  qint64 timestampNs;
+  double east;
+  double north;
+  double speed;
+  double heading;  // degrees
+};
+
+struct DriveLog {
+  QVector<LogRecord> records;
+  QVector<Truth> truth;  // every 20 ms
+};
+
+/**
+ * A recorded test drive: 5 s parked, away north, a 90° right turn, east
+ * through a tunnel without GPS, then braking to a stop. The sensors have the
+ * noise and offsets of cheap automotive parts.
+ */
+DriveLog recordDrive(qint64 tunnelStartNs, qint64 tunnelEndNs) {
+  std::mt19937 random(47);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  const double metresPerDegreeLongitude = kMetresPerDegree * std::cos(kLatitude * kPi / 180.0);
+
+  DriveLog log;
+  double east = 0.0;
+  double north = 0.0;
+  double heading = 0.0;  // radians clockwise from north
+  double speed = 0.0;
+  const qint64 tickNs = 5 * kMs;
+  const double dt = 1e-3 * tickNs / kMs;
+  for (qint64 t = 1000 * kMs; t <= 120000 * kMs; t += tickNs) {
+    const double seconds = t * 1e-9;
+    double acceleration = 0.0;
+    double turnRate = 0.0;
+    if (seconds >= 5 && seconds < 15) {
+      acceleration = 1.5;
+    } else if (seconds >= 30 && seconds < 40) {
+      turnRate = 9.0 * kPi / 180.0;
+    } else if (seconds >= 105 && seconds < 115) {
+      acceleration = -1.5;
+    }
+    heading += turnRate * dt;
+    speed = std::max(0.0, speed + acceleration * dt);
+    east += speed * std::sin(heading) * dt;
+    north += speed * std::cos(heading) * dt;
+
+    const qint64 tick = t / tickNs;
+    if (tick % 2 == 0) {
+      // Mounting offsets: 0.01 rad/s gyro, 0.1 m/s² accelerometer
+      log.records.append({LogRecord::Imu,
+                          t,
+                          {acceleration + 0.1 + 0.05 * noise(random), 0.0, 9.81,
+                           -turnRate + 0.01 + 0.005 * noise(random), 0.0}});
+    }
+    if (tick % 8 == 0) {
+      const double wheel = speed > 0 ? std::max(0.0, speed + 0.05 * noise(random)) : 0.0;
+      log.records.append({LogRecord::WheelSpeed, t, {wheel, 0, 0, 0, 0}});
+    }
+    if (tick % 20 == 0 && (t < tunnelStartNs || t >= tunnelEndNs)) {
+      const double course = heading * 180.0 / kPi + (speed > 1 ? 1.0 : 30.0) * noise(random);
+      log.records.append({LogRecord::Gps,
+                          t,
+                          {kLatitude + (north + 2.0 * noise(random)) / kMetresPerDegree,
+                           kLongitude + (east + 2.0 * noise(random)) / metresPerDegreeLongitude,
+                           std::max(0.0, speed + 0.2 * noise(random)),
+                           std::fmod(course + 360.0, 360.0), 0.8}});
+    }
+    if (t % kStepNs == 0) {
+      log.truth.append({t, east, north, speed, std::fmod(heading * 180.0 / kPi + 360.0, 360.0)});
+    }
+  }
+  return log;
+}
+
+GPSLocation toLocation(const LogRecord& record) {
+  GPSLocation location;
+  location.latitude = record.values[0];
+  location.longitude = record.values[1];
+  location.altitude = 520.0;
+  location.speed = record.values[2];
+  location.heading = record.values[3];
+  location.satellites = 9;
+  location.fixType = "3D";
+  location.hdop = record.values[4];
+  location.vdop = 1.2;
+  location.receivedNs = record.timestampNs;
+  return location;
+}
+
+/**
+ * Replay a log into the service as its devices would deliver it: in
+ * per-device bursts, so samples within a step arrive out of order.
+ */
+void replay(SensorFusionService& fusion, const DriveLog& log,
+            const std::function<void(const VehicleState&, const Truth&)>& check) {
+  int next = 0;
+  for (const Truth& truth : log.truth) {
+    int end = next;
+    while (end < log.records.size() && log.records[end].timestampNs <= truth.timestampNs) {
+      ++end;
+    }
+    for (const LogRecord::Kind kind : {LogRecord::Gps, LogRecord::Imu, LogRecord::WheelSpeed}) {
+      for (int i = next; i < end; ++i) {
+        const LogRecord& record = log.records[i];
+        if (record.kind != kind) {
+          continue;
+        }
+        if (kind == LogRecord::Gps) {
+          fusion.pushGps(toLocation(record));
+        } else if (kind == LogRecord::WheelSpeed) {
+          fusion.pushWheelSpeed(record.values[0], record.timestampNs);
+        } else {
+          ImuSample sample{};
+          for (int axis = 0; axis < 3; ++axis) {
+            sample.accel[axis] = static_cast<float>(record.values[axis]);
+          }
+          sample.gyro[2] = static_cast<float>(record.values[3]);
+          sample.timestampNs = record.timestampNs;
+          fusion.pushImu(sample);
+        }
+      }
+    }
+    next = end;
+    fusion.step(truth.timestampNs);
+    check(fusion.state(), truth);
+  }
+}
+
+double positionError(const VehicleState& state, const Truth& truth) {
+  const double east = (state.longitude - kLongitude) * kMetresPerDegree *
+                      std::cos(kLatitude * kPi / 180.0);
+  const double north = (state.latitude - kLatitude) * kMetresPerDegree;
+  return std::hypot(east - truth.east, north - truth.north);
+}
+
+double headingError(double a, double b) {
+  return std::fabs(std::remainder(a - b, 360.0));
+}
+
+VehicleStateFilter::GpsFix fixAt(double east, double north, double speed, double heading,
+                                 qint64 timestampNs) {
+  VehicleStateFilter::GpsFix fix{};
+  fix.latitude = kLatitude + north / kMetresPerDegree;
+  fix.longitude = kLongitude + east / (kMetresPerDegree * std::cos(kLatitude * kPi / 180.0));
+  fix.speed = speed;
+  fix.heading = heading;
+  fix.hdop = 0.8;
+  fix.valid = true;
+  fix.timestampNs = timestampNs;
+  return fix;
+}
+
+}  // namespace
+
+class TestSensorFusion : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testWrapAngle() {
+    QVERIFY(std::fabs(VehicleStateFilter::wrapAngle(3 * kPi / 2) + kPi / 2) < 1e-12);
+    QVERIFY(std::fabs(VehicleStateFilter::wrapAngle(-3 * kPi / 2) - kPi / 2) < 1e-12);
+    QCOMPARE(VehicleStateFilter::wrapAngle(-kPi), -kPi);
+    QVERIFY(std::fabs(VehicleStateFilter::wrapAngle(kPi) + kPi) < 1e-12);
+  }
+
+  void testGpsOnly() {
+    // Straight east at 10 m/s with exact fixes: speed and heading lock on
+    VehicleStateFilter filter;
+    for (int i = 0; i <= 100; ++i) {
+      QVERIFY(filter.updateGps(fixAt(i * 1.0, 0.0, 10.0, 90.0, i * 100 * kMs)));
+    }
+    VehicleState state = filter.state();
+    QVERIFY(state.flags & VehicleState::PositionValid);
+    QVERIFY(state.flags & VehicleState::HeadingValid);
+    QVERIFY(state.flags & VehicleState::SpeedValid);
+    QVERIFY(!(state.flags & VehicleState::DeadReckoning));
+    QVERIFY(std::fabs(state.speed - 10.0f) < 0.1f);
+    QVERIFY(headingError(state.heading, 90.0) < 1.0);
+    QVERIFY(std::fabs(state.longitude - fixAt(100.0, 0, 0, 0, 0).longitude) < 1e-5);
+
+    // Three seconds later without a fix the position has moved on by itself
+    filter.predictTo(13000 * kMs);
+    const float speedAccuracy = state.speedAccuracy;
+    state = filter.state();
+    QVERIFY(state.flags & VehicleState::PositionValid);
+    QVERIFY(state.flags & VehicleState::DeadReckoning);
+    QVERIFY(state.speedAccuracy > speedAccuracy);  // nothing measures speed any more
+    QVERIFY(std::fabs(state.longitude - fixAt(130.0, 0, 0, 0, 0).longitude) < 2e-5);
+    QCOMPARE(state.timestampNs, 13000 * kMs);
+  }
+
+  void testOutlierAndStaleSamples() {
+    VehicleStateFilter filter;
+    for (int i = 0; i <= 50; ++i) {
+      filter.updateGps(fixAt(0.0, i * 1.0, 10.0, 0.0, i * 100 * kMs));
+    }
+    // A multipath fix 300 m off is ignored...
+    QVERIFY(!filter.updateGps(fixAt(300.0, 51.0, 10.0, 0.0, 5100 * kMs)));
+    QCOMPARE(filter.stats().gpsRejected, quint64(1));
+    QVERIFY(filter.updateGps(fixAt(0.0, 52.0, 10.0, 0.0, 5200 * kMs)));
+
+    // ...but a receiver that keeps insisting wins after maxRejectedFixes
+    for (int i = 0; i < filter.tuning().maxRejectedFixes; ++i) {
+      filter.updateGps(fixAt(300.0, 53.0 + i, 10.0, 0.0, (5300 + i * 100) * kMs));
+    }
+    QCOMPARE(filter.stats().resets, quint64(1));
+    const VehicleState state = filter.state();
+    QVERIFY(std::fabs(state.longitude - fixAt(300.0, 0, 0, 0, 0).longitude) < 1e-5);
+
+    // Late samples within the lag window still count, older ones do not
+    const qint64 now = filter.timeNs();
+    QVERIFY(filter.updateWheelSpeed(10.0, now - 100 * kMs));
+    QVERIFY(!filter.updateWheelSpeed(10.0, now - 400 * kMs));
+    QCOMPARE(filter.stats().staleDropped, quint64(1));
+    QCOMPARE(filter.timeNs(), now);
+
+    // A long silence (suspend) forgets the motion but not the origin
+    filter.predictTo(now + 60000 * kMs);
+    QVERIFY(!(filter.state().flags & VehicleState::PositionValid));
+    QVERIFY(filter.hasOrigin());
+    QCOMPARE(filter.stats().resets, quint64(2));
+  }
+
+  void testReplayedDriveWithTunnel() {
+    const qint64 tunnelStart = 60000 * kMs;
+    const qint64 tunnelEnd = 90000 * kMs;
+    const DriveLog log = recordDrive(tunnelStart, tunnelEnd);
+
+    SensorFusionService fusion;
+    QSignalSpy states(&fusion, &SensorFusionService::stateUpdated);
+    QSignalSpy speeds(&fusion, &SensorFusionService::vehicleSpeedUpdated);
+    QSignalSpy bus(&EventBus::instance(), &EventBus::messagePublished);
+
+    double worstWithGps = 0.0;
+    double worstInTunnel = 0.0;
+    double worstHeading = 0.0;
+    double worstSpeed = 0.0;
+    int deadReckoningSteps = 0;
+    int deadReckoningOutside = 0;
+    replay(fusion, log, [&](const VehicleState& state, const Truth& truth) {
+      if (truth.timestampNs < 3000 * kMs) {
+        return;  // converging
+      }
+      const double error = positionError(state, truth);
+      const bool inTunnel = truth.timestampNs >= tunnelStart && truth.timestampNs < tunnelEnd;
+      if (inTunnel) {
+        worstInTunnel = std::max(worstInTunnel, error);
+      } else if (truth.timestampNs < tunnelStart || truth.timestampNs >= tunnelEnd + 2000 * kMs) {
+        worstWithGps = std::max(worstWithGps, error);
+      }
+      if (state.flags & VehicleState::DeadReckoning) {
+        ++(inTunnel ? deadReckoningSteps : deadReckoningOutside);
+      }
+      if (truth.speed > 2.0) {
+        worstHeading = std::max(worstHeading, headingError(state.heading, truth.heading));
+      }
+      worstSpeed = std::max(worstSpeed, std::fabs(state.speed - truth.speed));
+    });
+
+    // 450 m through the tunnel on wheel speed and gyro alone
+    QVERIFY2(worstInTunnel < 10.0, qPrintable(QString::number(worstInTunnel)));
+    QVERIFY2(worstWithGps < 3.0, qPrintable(QString::number(worstWithGps)));
+    QVERIFY2(worstHeading < 3.0, qPrintable(QString::number(worstHeading)));
+    QVERIFY2(worstSpeed < 0.5, qPrintable(QString::number(worstSpeed)));
+    // Flagged once the last fix, 100 ms before the tunnel, is over gpsTimeoutNs
+    // old, until the first fix after it
+    const qint64 firstFlagged =
+        tunnelStart - 100 * kMs + fusion.filter().tuning().gpsTimeoutNs + kStepNs;
+    QCOMPARE(deadReckoningSteps, static_cast<int>((tunnelEnd - firstFlagged) / kStepNs));
+    QCOMPARE(deadReckoningOutside, 0);
+
+    // Parked at the end: the gyro offset was learned, the heading holds
+    const VehicleState last = fusion.state();
+    QVERIFY(last.flags & VehicleState::Stationary);
+    QVERIFY(std::fabs(last.speed) < 0.1f);
+    QVERIFY(std::fabs(last.headingRate) < 0.2f);
+
+    // Two minutes of updates later the covariance is still a covariance
+    const VehicleStateFilter::Covariance& p = fusion.filter().covariance();
+    for (int row = 0; row < VehicleStateFilter::kStateCount; ++row) {
+      QVERIFY(p(row, row) > 0.0);
+      for (int col = 0; col < row; ++col) {
+        const double bound = std::sqrt(p(row, row) * p(col, col));
+        QVERIFY(std::fabs(p(row, col) - p(col, row)) <= 1e-9 * bound);
+        QVERIFY(std::fabs(p(row, col)) <= bound * (1.0 + 1e-9));
+      }
+    }
+
+    QCOMPARE(states.count(), log.truth.size());
+    QCOMPARE(fusion.stats().steps, quint64(log.truth.size()));
+    QCOMPARE(fusion.stats().samplesApplied, quint64(log.records.size()));
+    QCOMPARE(fusion.stats().queueDropped, quint64(0));
+    QCOMPARE(fusion.filter().stats().staleDropped, quint64(0));
+    QVERIFY(speeds.count() > 10);
+    QVERIFY(std::fabs(speeds.last().first().toFloat()) < 0.2f);
+
+    int published = 0;
+    for (const QList<QVariant>& message : bus) {
+      if (message.at(0).toString() == "vehicle/state") {
+        ++published;
+      }
+    }
+    QVERIFY(std::abs(published - static_cast<int>(log.truth.size()) / 5) <= 1);
+  }
+
+  void testSamplesAfterStepWait() {
+    SensorFusionService fusion;
+    fusion.pushWheelSpeed(5.0, 1000 * kMs);
+    fusion.pushWheelSpeed(6.0, 1040 * kMs);  // ahead of the step below
+    fusion.step(1020 * kMs);
+    QCOMPARE(fusion.stats().samplesApplied, quint64(1));
+    QCOMPARE(fusion.filter().stats().wheelSpeedUpdates, quint64(1));
+    fusion.step(1040 * kMs);
+    QCOMPARE(fusion.stats().samplesApplied, quint64(2));
+    QVERIFY(fusion.state().speed > 5.0f);
+  }
+
+  void testStateOnDataChannel() {
+    SensorFusionService fusion;
+    DataChannelHub& hub = DataChannelHub::instance();
+    const int topic = hub.topicId("vehicle/state");
+    QVERIFY(topic >= 0);
+    DataChannel* channel = hub.open({"nav", {"vehicle/state"}, 4096});
+    QVERIFY(channel);
+    void* memory = mmap(nullptr, channel->mappingSize(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                        channel->memoryFd(), 0);
+    QVERIFY(memory != MAP_FAILED);
+    datachannel::Consumer consumer(datachannel::attach(memory, channel->mappingSize()));
+
+    fusion.pushWheelSpeed(5.0, 1000 * kMs);
+    fusion.step(1020 * kMs);
+    const datachannel::RecordHeader* record = consumer.next();
+    QVERIFY(record);
+    QCOMPARE(record->topic, static_cast<uint16_t>(topic));
+    QCOMPARE(record->kind, static_cast<uint16_t>(datachannel::Kind::Telemetry));
+    QCOMPARE(record->size, quint32(SensorFusionService::StateSignalCount *
+                                   sizeof(datachannel::TelemetrySample)));
+    const auto* samples = reinterpret_cast<const datachannel::TelemetrySample*>(
+        datachannel::Consumer::payload(record));
+    const datachannel::TelemetrySample& speed = samples[SensorFusionService::Speed];
+    QCOMPARE(speed.signal, quint32(SensorFusionService::Speed));
+    QCOMPARE(speed.value, static_cast<double>(fusion.state().speed));
+    QCOMPARE(speed.flags, (fusion.state().flags & VehicleState::SpeedValid) ? 0u : 1u);
+    QCOMPARE(samples[SensorFusionService::Latitude].flags, 1u);  // no GPS fix yet
+    QCOMPARE(samples[SensorFusionService::Flags].value,
+             static_cast<double>(fusion.state().flags));
+    consumer.release();
+
+    munmap(memory, channel->mappingSize());
+    hub.close("nav");
+  }
+};
+
+QTEST_MAIN(TestSensorFusion)
+#include "test_sensor_fusion.moc"
@@ -0,0 +1,164 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+#include <atomic>
+
+#include "../core/services/service_manager/ServiceStartupGraph.h"
+
+class TestServiceStartupGraph : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testDependencyOrder() {
+    for (auto mode : {ServiceStartupGraph::Mode::Sequential, ServiceStartupGraph::Mode::Parallel}) {
+      ServiceStartupGraph graph;
+      QStringList activated;
+      auto activate = [&activated](const QString& name) {
+        return [&activated, name]() {
+          activated.append(name);
+          return true;
+        };
+      };
+
+      graph.addService("AndroidAuto", {"WiFi", "Bluetooth"}, {}, activate("AndroidAuto"));
+      graph.addService("WiFi", {}, []() { return true; }, activate("WiFi"));
+      graph.addService("Bluetooth", {"WiFi"}, []() { return true; }, activate("Bluetooth"));
+
+      QSignalSpy finishedSpy(&graph, &ServiceStartupGraph::finished);
+      QVERIFY(graph.start(mode));
+      QTRY_COMPARE(finishedSpy.count(), 1);
+
+      QCOMPARE(activated, QStringList({"WiFi", "Bluetooth", "AndroidAuto"}));
+      QCOMPARE(finishedSpy.first().at(0).toInt(), 3);
+      QCOMPARE(finishedSpy.first().at(1).toInt(), 0);
+    }
+  }
+
+  void testIndependentPreparesRunConcurrently() {
+    ServiceStartupGraph graph;
+    graph.setMaxParallelism(4);
+
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    auto slowPrepare = [&running, &peak]() {
+      const int now = ++running;
+      int expected = peak.load();
+      while (now > expected && !peak.compare_exchange_weak(expected, now)) {
+      }
+      QThread::msleep(200);
+      --running;
+      return true;
+    };
+
+    for (const char* name : {"A", "B", "C"}) {
+      graph.addService(name, {}, slowPrepare, []() { return true; });
+    }
+
+    QSignalSpy finishedSpy(&graph, &ServiceStartupGraph::finished);
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(graph.start(ServiceStartupGraph::Mode::Parallel));
+    QTRY_COMPARE(finishedSpy.count(), 1);
+
+    QVERIFY(peak.load() > 1);
+    QVERIFY(timer.elapsed() < 550);  // well under 3 x 200ms
+  }
+
+  void testSequentialFinishesBeforeReturn() {
+    ServiceStartupGraph graph;
+    bool prepareOnCallerThread = false;
+    QThread* caller = QThread::currentThread();
+    graph.addService(
+        "WiFi", {},
+        [&prepareOnCallerThread, caller]() {
+          prepareOnCallerThread = QThread::currentThread() == caller;
+          return true;
+        },
+        []() { return true; });
+
+    QSignalSpy finishedSpy(&graph, &ServiceStartupGraph::finished);
+    QVERIFY(graph.start(ServiceStartupGraph::Mode::Sequential));
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(graph.isFinished());
+    QVERIFY(prepareOnCallerThread);
+  }
+
+  void testFailedPrepareSkipsActivateButNotDependents() {
+    ServiceStartupGraph graph;
+    bool wifiActivated = false;
+    bool aaActivated = false;
+    graph.addService("WiFi", {}, []() { return false; }, [&wifiActivated]() {
+      wifiActivated = true;
+      return true;
+    });
+    graph.addService("AndroidAuto", {"WiFi"}, {}, [&aaActivated]() {
+      aaActivated = true;
+      return true;
+    });
+
+    QSignalSpy readySpy(&graph, &ServiceStartupGraph::serviceReady);
+    QSignalSpy finishedSpy(&graph, &ServiceStartupGraph::finished);
+    QVERIFY(graph.start(ServiceStartupGraph::Mode::Parallel));
+    QTRY_COMPARE(finishedSpy.count(), 1);
+
+    QVERIFY(!wifiActivated);
+    QVERIFY(aaActivated);
+    QCOMPARE(readySpy.count(), 2);
+    QCOMPARE(readySpy.at(0).at(0).toString(), QStringLiteral("WiFi"));
+    QCOMPARE(readySpy.at(0).at(1).toBool(), false);
+    QCOMPARE(finishedSpy.first().at(1).toInt(), 1);
+  }
+
+  void testCycleIsRejected() {
+    ServiceStartupGraph graph;
+    graph.addService("A", {"B"}, {}, []() { return true; });
+    graph.addService("B", {"A"}, {}, []() { return true; });
+
+    QSignalSpy finishedSpy(&graph, &ServiceStartupGraph::finished);
+    QVERIFY(!graph.start(ServiceStartupGraph::Mode::Parallel));
+    QCOMPARE(finishedSpy.count(), 1);
+  }
+
+  void testCancelStopsActivation() {
+    ServiceStartupGraph graph;
+    bool activated = false;
+    graph.addService(
+        "Slow", {}, []() {
+          QThread::msleep(100);
+          return true;
+        },
+        [&activated]() {
+          activated = true;
+          return true;
+        });
+
+    QVERIFY(graph.start(ServiceStartupGraph::Mode::Parallel));
+    graph.cancel();
+    QTest::qWait(250);
+    QVERIFY(!activated);
+    QVERIFY(!graph.isFinished());
+  }
+};
+
+QTEST_MAIN(TestServiceStartupGraph)
+#include "test_service_startup_graph.moc"
@@ -0,0 +1,209 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QSignalSpy>
+#include <QTest>
+#include <cstring>
+
+#include "../core/hal/functional/CANDevice.h"
+#include "../core/hal/functional/SlcanParser.h"
+#include "../core/hal/mocks/transport/MockTransport.h"
+
+namespace {
+
+int feed(SlcanParser& parser, const QByteArray& text, CANFrame* frames, int maxFrames) {
+  parser.append(text.constData(), static_cast<int>(text.size()));
+  return parser.parse(frames, maxFrames, 42);
+}
+
+}  // namespace
+
+class TestSlcanParser : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testStandardAndExtendedFrames() {
+    SlcanParser parser;
+    CANFrame frames[8];
+    QCOMPARE(feed(parser, "t12381122334455667788\rT18DAF1103020c0d\r", frames, 8), 2);
+
+    QCOMPARE(frames[0].id, quint32(0x123));
+    QVERIFY(!frames[0].extended);
+    QCOMPARE(frames[0].length, quint8(8));
+    QCOMPARE(frames[0].data[0], quint8(0x11));
+    QCOMPARE(frames[0].data[7], quint8(0x88));
+    QCOMPARE(frames[0].timestampNs, qint64(42));
+
+    QCOMPARE(frames[1].id, quint32(0x18DAF110));
+    QVERIFY(frames[1].extended);
+    QCOMPARE(frames[1].length, quint8(3));
+    QCOMPARE(frames[1].data[1], quint8(0x0c));  // lower case hex
+    QCOMPARE(parser.stats().frames, quint64(2));
+    QCOMPARE(parser.buffered(), 0);
+  }
+
+  void testRemoteFdAndTimestampedFrames() {
+    SlcanParser parser;
+    CANFrame frames[8];
+    QByteArray fd = "b7E0A";
+    for (int i = 0; i < 16; ++i) {
+      fd += "AB";
+    }
+    // Remote frame with DLC, 16-byte FD frame with BRS, frame with adapter timestamp
+    QCOMPARE(feed(parser, "r7DF8\r" + fd + "\rt1001FF1A2B\r", frames, 8), 3);
+
+    QVERIFY(frames[0].rtr);
+    QCOMPARE(frames[0].length, quint8(8));
+
+    QVERIFY(frames[1].fd && frames[1].bitRateSwitch);
+    QCOMPARE(frames[1].length, quint8(16));
+    QCOMPARE(frames[1].data[15], quint8(0xAB));
+
+    QCOMPARE(frames[2].id, quint32(0x100));
+    QCOMPARE(frames[2].length, quint8(1));
+    QCOMPARE(frames[2].data[0], quint8(0xFF));
+  }
+
+  void testLinesSplitAcrossReads() {
+    SlcanParser parser;
+    CANFrame frames[4];
+    QCOMPARE(feed(parser, "t12", frames, 4), 0);
+    QCOMPARE(feed(parser, "3201", frames, 4), 0);
+    QCOMPARE(feed(parser, "02\rt4", frames, 4), 1);
+    QCOMPARE(frames[0].id, quint32(0x123));
+    QCOMPARE(frames[0].data[1], quint8(0x02));
+    QCOMPARE(parser.buffered(), 2);
+  }
+
+  void testRingWrapsAround() {
+    SlcanParser parser;
+    CANFrame frames[1];
+    const QByteArray line = "T1FFFFFFF81122334455667788\r";
+    // Enough lines to wrap the ring several times, parsed as they arrive
+    for (int i = 0; i < 3 * SlcanParser::kCapacity / line.size(); ++i) {
+      QCOMPARE(feed(parser, line, frames, 1), 1);
+      QCOMPARE(frames[0].id, quint32(0x1FFFFFFF));
+      QCOMPARE(frames[0].data[7], quint8(0x88));
+    }
+    QCOMPARE(parser.stats().malformed, quint64(0));
+  }
+
+  void testMalformedAndResponses() {
+    SlcanParser parser;
+    CANFrame frames[8];
+    // Acks, version, BEL, bad hex, short data, DLC 9 on classic, 12-bit id
+    QCOMPARE(feed(parser, "\rz\rV1013\r\at12G100\rt1232AA\rt1239\rtFFF0\rt1000\r", frames, 8),
+             1);
+    QCOMPARE(frames[0].id, quint32(0x100));
+    QCOMPARE(frames[0].length, quint8(0));
+    QCOMPARE(parser.stats().malformed, quint64(4));
+    QCOMPARE(parser.stats().errorResponses, quint64(1));
+
+    // A line with no terminator is dropped, and parsing resyncs after it
+    QCOMPARE(feed(parser, QByteArray(500, '1'), frames, 8), 0);
+    QCOMPARE(feed(parser, "\rt00111F\r", frames, 8), 1);
+    QCOMPARE(frames[0].id, quint32(0x001));
+    QCOMPARE(parser.stats().malformed, quint64(5));
+  }
+
+  void testEncodeRoundTrip() {
+    char text[SlcanParser::kMaxLineLength + 1];
+    CANFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = 0x7E0;
+    frame.length = 2;
+    frame.data[0] = 0x01;
+    frame.data[1] = 0x0D;
+    QCOMPARE(QByteArray(text, SlcanParser::encode(frame, text)), QByteArray("t7E02010D\r"));
+
+    frame.extended = true;
+    frame.fd = true;
+    frame.bitRateSwitch = true;
+    frame.id = 0x18DB33F1;
+    frame.length = 10;  // padded to 12 (DLC 9)
+    const int length = SlcanParser::encode(frame, text);
+    QCOMPARE(QByteArray(text, 10), QByteArray("B18DB33F19"));
+
+    SlcanParser parser;
+    CANFrame decoded[1];
+    QCOMPARE(feed(parser, QByteArray(text, length), decoded, 1), 1);
+    QCOMPARE(decoded[0].id, frame.id);
+    QCOMPARE(decoded[0].length, quint8(12));
+    QCOMPARE(decoded[0].data[1], quint8(0x0D));
+
+    frame.fd = false;
+    frame.length = 9;
+    QCOMPARE(SlcanParser::encode(frame, text), 0);
+  }
+
+  void testDeviceDeliversBatches() {
+    MockTransport transport;
+    CANDevice device(&transport);
+    QVERIFY(device.initialize());
+
+    QList<quint32> ids;
+    QList<int> batchSizes;
+    connect(&device, &CANDevice::framesReceived, this,
+            [&](const CANFrame* frames, int count) {
+              batchSizes.append(count);
+              for (int i = 0; i < count; ++i) {
+                ids.append(frames[i].id);
+              }
+            });
+    transport.injectData("t1000\rt2011AA\rt30");
+    transport.injectData("22BBCC\r");
+    QCOMPARE(ids, (QList<quint32>{0x100, 0x201, 0x302}));
+    QCOMPARE(batchSizes, (QList<int>{2, 1}));
+
+    // The per-frame message form still works for existing consumers
+    QSignalSpy messages(&device, &CANDevice::messageReceived);
+    transport.injectData("t4001EE\r");
+    QCOMPARE(messages.count(), 1);
+    const CANMessage message = messages.first().first().value<CANMessage>();
+    QCOMPARE(message.id, quint32(0x400));
+    QCOMPARE(message.data, QByteArray("\xEE", 1));
+
+    CANFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = 0x7DF;
+    frame.length = 1;
+    frame.data[0] = 0x02;
+    transport.clearWrittenData();
+    QVERIFY(device.sendFrame(frame));
+    QCOMPARE(transport.getWrittenData(), QByteArray("t7DF102\r"));
+
+    // BRS comes from the message, not from the FD flag
+    CANMessage fdMessage;
+    fdMessage.id = 0x7DF;
+    fdMessage.data = QByteArray("\x02", 1);
+    fdMessage.extended = false;
+    fdMessage.rtr = false;
+    fdMessage.fd = true;
+    transport.clearWrittenData();
+    QVERIFY(device.sendMessage(fdMessage));
+    QVERIFY(transport.getWrittenData().startsWith("d7DF"));
+    fdMessage.bitRateSwitch = true;
+    transport.clearWrittenData();
+    QVERIFY(device.sendMessage(fdMessage));
+    QVERIFY(transport.getWrittenData().startsWith("b7DF"));
+  }
+};
+
+QTEST_MAIN(TestSlcanParser)
+#include "test_slcan_parser.moc"
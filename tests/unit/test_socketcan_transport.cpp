@@ -0,0 +1,192 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/can/error.h>
+#include <net/if.h>
+
+#include <QSignalSpy>
+#include <QTest>
+#include <cstring>
+
+#include "../core/hal/transport/SocketCANTransport.h"
+
+namespace {
+
+constexpr const char* kInterface = "vcan0";
+
+SocketCANTransport::Frame makeFrame(canid_t id, const QByteArray& data) {
+  SocketCANTransport::Frame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.frame.can_id = id;
+  frame.frame.len = static_cast<__u8>(data.size());
+  memcpy(frame.frame.data, data.constData(), data.size());
+  return frame;
+}
+
+}  // namespace
+
+class TestSocketCANTransport : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testParseFilterStrings() {
+    QVector<can_filter> filters;
+    QVERIFY(SocketCANTransport::parseFilters(
+        QStringList{"123:7FF", "12345678:1FFFFFFF", "100~700"}, &filters));
+    QCOMPARE(filters.size(), 3);
+
+    // 11-bit filters also match on the frame format
+    QCOMPARE(filters[0].can_id, canid_t(0x123));
+    QCOMPARE(filters[0].can_mask, canid_t(0x7FF | CAN_EFF_FLAG));
+
+    QCOMPARE(filters[1].can_id, canid_t(0x12345678 | CAN_EFF_FLAG));
+    QCOMPARE(filters[1].can_mask, canid_t(0x1FFFFFFF | CAN_EFF_FLAG));
+
+    QCOMPARE(filters[2].can_id, canid_t(0x100 | CAN_INV_FILTER));
+    QCOMPARE(filters[2].can_mask, canid_t(0x700 | CAN_EFF_FLAG));
+
+    // No filters receives everything
+    QVERIFY(SocketCANTransport::parseFilters(QVariant(), &filters));
+    QVERIFY(filters.isEmpty());
+  }
+
+  void testParseFilterMaps() {
+    QVector<can_filter> filters;
+    const QVariantList entries{
+        QVariantMap{{"id", "0x3E9"}},
+        QVariantMap{{"id", 0x18DAF110}, {"mask", "0x1FFFFF00"}},
+        QVariantMap{{"id", "0x7DF"}, {"invert", true}},
+    };
+    QVERIFY(SocketCANTransport::parseFilters(entries, &filters));
+    QCOMPARE(filters.size(), 3);
+    QCOMPARE(filters[0].can_id, canid_t(0x3E9));
+    QCOMPARE(filters[0].can_mask, canid_t(CAN_SFF_MASK | CAN_EFF_FLAG));
+    QCOMPARE(filters[1].can_id, canid_t(0x18DAF110 | CAN_EFF_FLAG));
+    QCOMPARE(filters[1].can_mask, canid_t(0x1FFFFF00 | CAN_EFF_FLAG));
+    QCOMPARE(filters[2].can_id, canid_t(0x7DF | CAN_INV_FILTER));
+  }
+
+  void testParseFilterErrors() {
+    QVector<can_filter> filters;
+    QString error;
+    QVERIFY(!SocketCANTransport::parseFilters(QStringList{"123"}, &filters, &error));
+    QVERIFY(error.contains("123"));
+    QVERIFY(!SocketCANTransport::parseFilters(QStringList{"xyz:7FF"}, &filters, &error));
+    QVERIFY(!SocketCANTransport::parseFilters(QVariantList{QVariantMap{{"id", "nope"}}},
+                                              &filters, &error));
+
+    // A bad filter leaves the configured ones alone
+    SocketCANTransport transport(kInterface);
+    QVERIFY(transport.configure("filters", QStringList{"123:7FF"}));
+    QVERIFY(!transport.configure("filters", QStringList{"oops"}));
+    QCOMPARE(transport.getConfiguration("filters").toStringList(), QStringList{"123:7FF"});
+  }
+
+  void testDescribeErrorFrame() {
+    can_frame frame{};
+    frame.can_id = CAN_ERR_FLAG | CAN_ERR_BUSOFF;
+    QCOMPARE(SocketCANTransport::describeErrorFrame(frame), QString("bus-off"));
+
+    frame.can_id = CAN_ERR_FLAG | CAN_ERR_CRTL | CAN_ERR_ACK;
+    frame.data[1] = CAN_ERR_CRTL_RX_PASSIVE;
+    QCOMPARE(SocketCANTransport::describeErrorFrame(frame), QString("error passive, no ACK"));
+
+    frame.can_id = CAN_ERR_FLAG;
+    QCOMPARE(SocketCANTransport::describeErrorFrame(frame), QString("unknown error"));
+  }
+
+  void testOpenMissingInterface() {
+    SocketCANTransport transport("nosuchcan0");
+    QSignalSpy errors(&transport, &Transport::errorOccurred);
+    QVERIFY(!transport.open());
+    QVERIFY(transport.getState() == TransportState::ERROR);
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(transport.writeFrames(nullptr, 0), -1);
+  }
+
+  void testLoopbackWithKernelFilter() {
+    if (if_nametoindex(kInterface) == 0) {
+      QSKIP("vcan0 not present (ip link add dev vcan0 type vcan && ip link set up vcan0)");
+    }
+
+    SocketCANTransport sender(kInterface);
+    SocketCANTransport receiver(kInterface);
+    QVERIFY(receiver.configure("filters", QStringList{"123:7FF", "18DAF110:1FFFFFFF"}));
+    QVERIFY(receiver.configure("batchSize", 8));
+    QVERIFY(sender.open());
+    QVERIFY(receiver.open());
+    QSignalSpy batches(&receiver, &SocketCANTransport::framesReceived);
+
+    QVector<SocketCANTransport::Frame> frames;
+    for (int i = 0; i < 20; ++i) {
+      frames.append(makeFrame(0x123, QByteArray(1, static_cast<char>(i))));
+      frames.append(makeFrame(0x456, QByteArray(8, 'x')));  // filtered by the kernel
+    }
+    frames.append(makeFrame(0x18DAF110 | CAN_EFF_FLAG, QByteArray("\x02\x01\x0c", 3)));
+    QCOMPARE(sender.writeFrames(frames.constData(), frames.size()), frames.size());
+
+    QTRY_COMPARE(receiver.framesAvailable(), 21);
+    QVERIFY(!batches.isEmpty());
+
+    SocketCANTransport::Frame received[32];
+    QCOMPARE(receiver.readFrames(received, 32), 21);
+    for (int i = 0; i < 20; ++i) {
+      QCOMPARE(received[i].frame.can_id, canid_t(0x123));
+      QCOMPARE(received[i].frame.data[0], static_cast<__u8>(i));
+      QVERIFY(received[i].timestampNs > 0);
+      QVERIFY(!received[i].fd);
+    }
+    QCOMPARE(received[20].frame.can_id, canid_t(0x18DAF110 | CAN_EFF_FLAG));
+    QCOMPARE(received[20].frame.len, static_cast<__u8>(3));
+    QVERIFY(received[20].timestampNs >= received[0].timestampNs);
+
+    const SocketCANTransport::Stats stats = receiver.stats();
+    QCOMPARE(stats.framesReceived, quint64(21));
+    QVERIFY(stats.receiveCalls >= 3);  // 21 frames in batches of at most 8
+    QCOMPARE(sender.stats().framesSent, quint64(frames.size()));
+  }
+
+  void testByteInterfaceUsesCanFrames() {
+    if (if_nametoindex(kInterface) == 0) {
+      QSKIP("vcan0 not present");
+    }
+
+    SocketCANTransport sender(kInterface);
+    SocketCANTransport receiver(kInterface);
+    QVERIFY(sender.open());
+    QVERIFY(receiver.open());
+
+    can_frame frame{};
+    frame.can_id = 0x7E8;
+    frame.len = 2;
+    frame.data[0] = 0x41;
+    frame.data[1] = 0x0D;
+    const QByteArray record(reinterpret_cast<const char*>(&frame), CAN_MTU);
+    QCOMPARE(sender.write(record + record), qint64(2 * CAN_MTU));
+
+    QTRY_COMPARE(receiver.bytesAvailable(), qint64(2 * CAN_MTU));
+    const QByteArray data = receiver.read(CAN_MTU);
+    QCOMPARE(data.size(), qsizetype(CAN_MTU));
+    QCOMPARE(reinterpret_cast<const can_frame*>(data.constData())->can_id, canid_t(0x7E8));
+    QCOMPARE(receiver.framesAvailable(), 1);
+  }
+};
+
+QTEST_MAIN(TestSocketCANTransport)
+#include "test_socketcan_transport.moc"
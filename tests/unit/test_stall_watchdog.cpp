@@ -0,0 +1,173 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+#include <QThread>
+#include <QTimer>
+#include <chrono>
+
+#include "../core/services/diagnostics/FlightRecorder.h"
+#include "../core/services/diagnostics/StallWatchdog.h"
+
+using namespace crankshaft::diagnostics;
+
+// Exported with a plain name so the captured stack can be checked for it.
+// Spins rather than sleeps so the interrupted instruction is in this frame.
+extern "C" __attribute__((noinline)) void crankshaftStallBlockFor(int ms) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+namespace {
+
+bool stackMentions(const QVariantMap& stall, const QString& function) {
+  for (const QString& frame : stall.value("stack").toStringList()) {
+    if (frame.contains(function)) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+class TestStallWatchdog : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void initTestCase() {
+    // Keeps stall dumps out of the real application data directory
+    QStandardPaths::setTestModeEnabled(true);
+  }
+
+  void testMainLoopStallIsReported() {
+    MetricsRegistry registry;
+    StallWatchdog watchdog(&registry);
+    QSignalSpy stalls(&watchdog, &StallWatchdog::stallEnded);
+
+    StallWatchdog::Options options;
+    options.heartbeatMs = 10;
+    options.thresholdMs = 100;
+    QVERIFY(watchdog.start(options));
+    QTest::qWait(200);
+    QCOMPARE(watchdog.stallCount(), quint64(0));
+
+    QTimer blocker;
+    blocker.setObjectName("StallingTimer");
+    blocker.setSingleShot(true);
+    connect(&blocker, &QTimer::timeout, this, []() { crankshaftStallBlockFor(400); });
+    blocker.start(10);
+
+    QTRY_COMPARE_WITH_TIMEOUT(stalls.count(), 1, 3000);
+    watchdog.stop();
+    QCOMPARE(watchdog.stallCount(), quint64(1));
+
+    const QVariantMap stall = stalls.first().first().toMap();
+    QCOMPARE(stall.value("loop").toString(), QString("main"));
+    QCOMPARE(stall.value("threshold_ms").toInt(), 100);
+    QVERIFY(stall.value("thread_id").toInt() > 0);
+    const double durationMs = stall.value("duration_ms").toDouble();
+    QVERIFY2(durationMs >= 300 && durationMs < 2000, qPrintable(QString::number(durationMs)));
+    QVERIFY2(stackMentions(stall, "crankshaftStallBlockFor"),
+             qPrintable(stall.value("stack").toStringList().join(" <- ")));
+
+    const QVariantMap activity = stall.value("activity").toMap();
+    QCOMPARE(activity.value("event").toString(), QString("Timer"));
+    QCOMPARE(activity.value("receiver").toString(), QString("QTimer"));
+    QCOMPARE(activity.value("object_name").toString(), QString("StallingTimer"));
+
+    QCOMPARE(registry.histogram("event_loop_stall_ms", QString(), {{"loop", "main"}}).count(),
+             quint64(1));
+
+    // The stall went into the ring and triggered a stall dump
+    const QString dumpPath = stall.value("flight_dump").toString();
+    QVERIFY(!dumpPath.isEmpty());
+    flight::DumpHeader header{};
+    std::vector<flight::Record> records;
+    std::string error;
+    QVERIFY2(flight::readDump(dumpPath.toStdString(), &header, &records, &error), error.c_str());
+    QCOMPARE(header.reason, static_cast<uint16_t>(flight::DumpReason::Stall));
+    QVERIFY(records.size() >= 2);
+    const flight::Record& record = records[records.size() - 2];
+    QCOMPARE(record.event, static_cast<uint16_t>(flight::Event::LoopStall));
+    QVERIFY(record.a >= 100);
+    QFile::remove(dumpPath);
+  }
+
+  void testWatchedThreadStallIsReported() {
+    QThread worker;
+    worker.setObjectName("StallWorker");
+    QObject context;
+    context.moveToThread(&worker);
+
+    MetricsRegistry registry;
+    StallWatchdog watchdog(&registry);
+    QSignalSpy stalls(&watchdog, &StallWatchdog::stallEnded);
+    watchdog.watchThread(&worker, "worker");
+    worker.start();
+
+    StallWatchdog::Options options;
+    options.heartbeatMs = 10;
+    options.thresholdMs = 100;
+    options.dumpFlightRecorder = false;
+    QVERIFY(watchdog.start(options));
+    QTest::qWait(100);
+
+    QMetaObject::invokeMethod(&context, []() { crankshaftStallBlockFor(300); });
+    QTRY_COMPARE_WITH_TIMEOUT(stalls.count(), 1, 3000);
+
+    const QVariantMap stall = stalls.first().first().toMap();
+    QCOMPARE(stall.value("loop").toString(), QString("worker"));
+    QVERIFY(stall.value("duration_ms").toDouble() >= 200);
+    QVERIFY(stackMentions(stall, "crankshaftStallBlockFor"));
+    // Activity is only tracked for the main loop
+    QVERIFY(stall.value("activity").toMap().isEmpty());
+    QVERIFY(stall.value("flight_dump").toString().isEmpty());
+    QCOMPARE(registry.histogram("event_loop_stall_ms", QString(), {{"loop", "worker"}}).count(),
+             quint64(1));
+
+    // A finished thread is not a stalled one
+    worker.quit();
+    QVERIFY(worker.wait(2000));
+    QTest::qWait(200);
+    watchdog.stop();
+    QCOMPARE(watchdog.stallCount(), quint64(1));
+  }
+
+  void testRestartAfterStop() {
+    StallWatchdog watchdog;
+    StallWatchdog::Options options;
+    options.heartbeatMs = 10;
+    options.thresholdMs = 100;
+    options.dumpFlightRecorder = false;
+    QVERIFY(watchdog.start(options));
+    QVERIFY(watchdog.start(options));  // already running
+    watchdog.stop();
+    QVERIFY(!watchdog.isRunning());
+    QVERIFY(watchdog.start(options));
+    QTest::qWait(150);
+    QCOMPARE(watchdog.stallCount(), quint64(0));
+    watchdog.stop();
+  }
+};
+
+QTEST_MAIN(TestStallWatchdog)
+#include "test_stall_watchdog.moc"
@@ -0,0 +1,126 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "../core/services/state/StateSnapshotService.h"
+
+class TestStateSnapshot : public QObject {
+  Q_OBJECT
+
+ private:
+  static QString snapshotPath(const QTemporaryDir& dir) {
+    return QDir(dir.path()).filePath(QStringLiteral("state_snapshot.json"));
+  }
+
+ private slots:
+  void testOnlyTrackedTopicsAreRetained() {
+    QTemporaryDir dir;
+    StateSnapshotService snapshot(snapshotPath(dir));
+
+    QVERIFY(snapshot.record("android-auto/status/state-changed", {{"state", 5}}));
+    QVERIFY(snapshot.record("profiles/vehicle/changed", {{"profile", "sedan"}}));
+    QVERIFY(snapshot.record("profiles/host/active", {{"id", "dev"}}));
+    QVERIFY(snapshot.record("driving-mode/status", {{"driving", false}}));
+    QVERIFY(!snapshot.record("ui/theme/changed", {{"mode", "dark"}}));
+    QVERIFY(!snapshot.record("android-auto", {}));
+    // Nothing in core publishes these
+    QVERIFY(!snapshot.record("media/status/position", {{"positionMs", 1234}}));
+    QCOMPARE(snapshot.size(), 4);
+
+    QVERIFY(snapshot.record("profiles/vehicle/changed", {{"profile", "estate"}}));
+    QCOMPARE(snapshot.size(), 4);
+    QCOMPARE(snapshot.entry("profiles/vehicle/changed").payload.value("profile").toString(),
+             QStringLiteral("estate"));
+  }
+
+  void testMessagePreservesUpdateOrder() {
+    QTemporaryDir dir;
+    StateSnapshotService snapshot(snapshotPath(dir));
+
+    snapshot.record("android-auto/status/connected", {{"connected", true}});
+    snapshot.record("profiles/host/changed", {{"profile", "dev"}});
+    snapshot.record("android-auto/status/disconnected", {{"connected", false}});
+
+    const QJsonObject message = snapshot.toMessage();
+    QCOMPARE(message.value("type").toString(), QStringLiteral("snapshot"));
+    const QJsonArray events = message.value("events").toArray();
+    QCOMPARE(events.size(), 3);
+    QCOMPARE(events.at(0).toObject().value("topic").toString(),
+             QStringLiteral("android-auto/status/connected"));
+    QCOMPARE(events.at(2).toObject().value("topic").toString(),
+             QStringLiteral("android-auto/status/disconnected"));
+  }
+
+  void testSaveAndRestore() {
+    QTemporaryDir dir;
+    {
+      StateSnapshotService snapshot(snapshotPath(dir));
+      snapshot.record("profiles/host/changed", {{"profile", "dev"}, {"name", "Development"}});
+      snapshot.record("android-auto/status/state-changed", {{"state", 5}});
+      snapshot.record("driving-mode/status", {{"driving", true}});
+      QVERIFY(snapshot.save());
+    }
+    QVERIFY(QFileInfo::exists(snapshotPath(dir)));
+
+    StateSnapshotService restored(snapshotPath(dir));
+    QVERIFY(restored.load());
+    QCOMPARE(restored.size(), 3);
+    const auto entry = restored.entry("profiles/host/changed");
+    QVERIFY(entry.restored);
+    QVERIFY(!entry.stale);
+    QCOMPARE(entry.payload.value("name").toString(), QStringLiteral("Development"));
+
+    // The previous boot's projection and driving state no longer hold
+    QVERIFY(restored.entry("android-auto/status/state-changed").stale);
+    QVERIFY(restored.entry("driving-mode/status").stale);
+    const QJsonArray events = restored.toMessage().value("events").toArray();
+    QVERIFY(events.at(1).toObject().value("stale").toBool());
+
+    // A live update clears the restored and stale flags
+    restored.record("profiles/host/changed", {{"profile", "test"}});
+    QVERIFY(!restored.entry("profiles/host/changed").restored);
+    restored.record("driving-mode/status", {{"driving", false}});
+    QVERIFY(!restored.entry("driving-mode/status").stale);
+  }
+
+  void testCustomTrackedTopics() {
+    QTemporaryDir dir;
+    StateSnapshotService snapshot(snapshotPath(dir));
+    snapshot.setTrackedTopics({"navigation/*"});
+
+    QVERIFY(snapshot.record("navigation/route", {{"eta", 12}}));
+    QVERIFY(!snapshot.record("media/status/position", {{"positionMs", 1}}));
+  }
+
+  void testMissingSnapshotIsNotAnError() {
+    QTemporaryDir dir;
+    StateSnapshotService snapshot(snapshotPath(dir));
+    QVERIFY(!snapshot.load());
+    QCOMPARE(snapshot.size(), 0);
+    QVERIFY(snapshot.save());
+  }
+};
+
+QTEST_MAIN(TestStateSnapshot)
+#include "test_state_snapshot.moc"
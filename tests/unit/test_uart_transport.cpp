@@ -0,0 +1,257 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../core/hal/transport/UARTTransport.h"
+
+namespace {
+
+// Master side of a pseudo-terminal; the transport opens the slave
+class PtyPair {
+ public:
+  PtyPair() {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_master >= 0 && grantpt(m_master) == 0 && unlockpt(m_master) == 0) {
+      m_slavePath = QString::fromLocal8Bit(ptsname(m_master));
+      termios tio{};
+      tcgetattr(m_master, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(m_master, TCSANOW, &tio);
+    }
+  }
+  ~PtyPair() {
+    if (m_master >= 0) {
+      ::close(m_master);
+    }
+  }
+
+  bool isValid() const {
+    return !m_slavePath.isEmpty();
+  }
+  QString slavePath() const {
+    return m_slavePath;
+  }
+
+  void send(const QByteArray& data) {
+    QCOMPARE(::write(m_master, data.constData(), data.size()), ssize_t(data.size()));
+  }
+
+  // Hangs up the slave side, like unplugging a USB adapter
+  void closeMaster() {
+    ::close(m_master);
+    m_master = -1;
+  }
+
+  QByteArray receive() {
+    QByteArray data;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = ::read(m_master, buffer, sizeof(buffer))) > 0) {
+      data.append(buffer, count);
+    }
+    return data;
+  }
+
+ private:
+  int m_master{-1};
+  QString m_slavePath;
+};
+
+}  // namespace
+
+class TestUARTTransport : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testSpeedFor() {
+    QCOMPARE(UARTTransport::speedFor(9600), quint32(B9600));
+    QCOMPARE(UARTTransport::speedFor(115200), quint32(B115200));
+    QCOMPARE(UARTTransport::speedFor(921600), quint32(B921600));
+    QCOMPARE(UARTTransport::speedFor(12345), quint32(0));
+
+    UARTTransport uart("/dev/null");
+    QVERIFY(!uart.setBaudRate(12345));
+    QVERIFY(!uart.setDataBits(9));
+    QVERIFY(!uart.setParity("mark"));
+    QCOMPARE(uart.getConfiguration("baudRate").toInt(), 9600);
+  }
+
+  void testOpenAppliesTermios() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    UARTTransport uart(pty.slavePath());
+    QVERIFY(uart.setBaudRate(921600));
+    QSignalSpy connected(&uart, &Transport::connected);
+    QVERIFY(uart.open());
+    QVERIFY(uart.isOpen());
+    QCOMPARE(connected.count(), 1);
+
+    // Ptys keep the speed and VMIN/VTIME but force CS8 without parity
+    termios tio{};
+    const int fd = ::open(pty.slavePath().toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+    QVERIFY(fd >= 0);
+    QVERIFY(tcgetattr(fd, &tio) == 0);
+    ::close(fd);
+    QCOMPARE(cfgetospeed(&tio), speed_t(B921600));
+    QCOMPARE(int(tio.c_cc[VMIN]), 1);
+    QCOMPARE(int(tio.c_cc[VTIME]), 0);
+    QVERIFY(!(tio.c_lflag & ICANON));
+
+    // Applied live while open
+    QVERIFY(uart.configure("baudRate", 115200));
+    const int again = ::open(pty.slavePath().toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+    QVERIFY(tcgetattr(again, &tio) == 0);
+    ::close(again);
+    QCOMPARE(cfgetospeed(&tio), speed_t(B115200));
+
+    uart.close();
+    QVERIFY(!uart.isOpen());
+  }
+
+  void testOpenMissingPortFails() {
+    UARTTransport uart("/dev/does-not-exist");
+    QSignalSpy errors(&uart, &Transport::errorOccurred);
+    QVERIFY(!uart.open());
+    QCOMPARE(uart.getState(), TransportState::ERROR);
+    QCOMPARE(errors.count(), 1);
+  }
+
+  void testWritesAreCoalesced() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    UARTTransport uart(pty.slavePath());
+    QVERIFY(uart.open());
+
+    for (int i = 0; i < 10; ++i) {
+      QCOMPARE(uart.write("$PMTK"), qint64(5));
+    }
+    QCOMPARE(uart.stats().writeCalls, quint64(0));
+    QTRY_COMPARE(uart.stats().bytesWritten, quint64(50));
+    QCOMPARE(uart.stats().writeCalls, quint64(1));
+    QByteArray sent;
+    QTRY_COMPARE((sent += pty.receive()).size(), 50);
+
+    // Reaching the coalesce threshold writes at once
+    uart.configure("writeCoalesceBytes", 16);
+    uart.write(QByteArray(16, 'x'));
+    QCOMPARE(uart.stats().writeCalls, quint64(2));
+
+    // flush() pushes out what is pending without the event loop
+    uart.write("tail");
+    uart.flush();
+    QCOMPARE(uart.stats().bytesWritten, quint64(70));
+
+    uart.setLowLatency(true);
+    uart.write("now");
+    QCOMPARE(uart.stats().writeCalls, quint64(4));
+  }
+
+  void testReadsAreBatched() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    UARTTransport uart(pty.slavePath());
+    uart.configure("readBatchIntervalMs", 50);
+    QVERIFY(uart.open());
+    QSignalSpy received(&uart, &Transport::dataReceived);
+
+    pty.send("$GPGGA,");
+    QTRY_COMPARE(received.count(), 1);
+
+    // Arrivals while the notifier rests come in one wakeup
+    for (int i = 0; i < 10; ++i) {
+      pty.send("123,");
+      QTest::qWait(2);
+    }
+    QTRY_COMPARE(uart.bytesAvailable(), qint64(47));
+    QVERIFY(uart.stats().readWakeups <= 3);
+    QCOMPARE(uart.read(7), QByteArray("$GPGGA,"));
+    QCOMPARE(uart.read().size(), 40);
+    QCOMPARE(uart.bytesAvailable(), qint64(0));
+  }
+
+  void testRingOverflowKeepsNewest() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    UARTTransport uart(pty.slavePath());
+    uart.configure("rxBufferBytes", 256);
+    uart.configure("readBatchIntervalMs", 0);
+    QCOMPARE(uart.getConfiguration("rxBufferBytes").toInt(), 256);
+    QVERIFY(uart.open());
+
+    QByteArray data;
+    for (int i = 0; i < 300; ++i) {
+      data.append(char('a' + i % 26));
+    }
+    pty.send(data);
+    QTRY_COMPARE(uart.stats().bytesRead, quint64(300));
+    QVERIFY(uart.stats().overflowBytes > 0);
+    QCOMPARE(quint64(uart.bytesAvailable()) + uart.stats().overflowBytes, quint64(300));
+    const qint64 kept = uart.bytesAvailable();
+    QCOMPARE(uart.read(), data.right(kept));
+
+    // Wrapped reads come back in order
+    pty.send(data.left(200));
+    QTRY_COMPARE(uart.bytesAvailable(), qint64(200));
+    QCOMPARE(uart.read(), data.left(200));
+  }
+
+  void testHangupClosesPort() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    UARTTransport uart(pty.slavePath());
+    uart.configure("readBatchIntervalMs", 0);
+    QVERIFY(uart.open());
+    QSignalSpy disconnectedSpy(&uart, &Transport::disconnected);
+    QSignalSpy errorSpy(&uart, &Transport::errorOccurred);
+
+    pty.send("$GPGGA");
+    QTRY_COMPARE(uart.bytesAvailable(), qint64(6));
+    pty.closeMaster();
+    QTRY_COMPARE(disconnectedSpy.count(), 1);
+    QCOMPARE(uart.getState(), TransportState::DISCONNECTED);
+    QCOMPARE(errorSpy.count(), 1);
+    QVERIFY(!uart.isOpen());
+  }
+
+  void testWriteAfterHangup() {
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    UARTTransport uart(pty.slavePath());
+    uart.configure("lowLatency", true);  // write() goes straight to the port
+    QVERIFY(uart.open());
+    QSignalSpy disconnectedSpy(&uart, &Transport::disconnected);
+    QSignalSpy errorSpy(&uart, &Transport::errorOccurred);
+
+    pty.closeMaster();
+    QCOMPARE(uart.write("$PUBX,00*33\r\n"), qint64(13));  // queued, then EIO
+    QTRY_COMPARE(disconnectedSpy.count(), 1);
+    QCOMPARE(errorSpy.count(), 1);
+    QVERIFY(!uart.isOpen());
+    QCOMPARE(uart.write("$PUBX,00*33\r\n"), qint64(-1));
+  }
+};
+
+QTEST_MAIN(TestUARTTransport)
+#include "test_uart_transport.moc"
@@ -0,0 +1,275 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QSignalSpy>
+#include <QTest>
+#include <QTimeZone>
+#include <cmath>
+
+#include "../core/hal/functional/GPSDevice.h"
+#include "../core/hal/functional/UbxParser.h"
+#include "../core/hal/mocks/transport/MockTransport.h"
+
+namespace {
+
+void putU2(QByteArray& payload, int offset, quint16 value) {
+  payload[offset] = static_cast<char>(value & 0xFF);
+  payload[offset + 1] = static_cast<char>(value >> 8);
+}
+
+void putU4(QByteArray& payload, int offset, quint32 value) {
+  for (int i = 0; i < 4; ++i) {
+    payload[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+// NAV-PVT for 2026-10-18 12:34:<second> UTC, 3D fix
+QByteArray navPvt(quint32 iTow, int second, qint32 latE7, qint32 lonE7) {
+  QByteArray payload(92, '\0');
+  putU4(payload, 0, iTow);
+  putU2(payload, 4, 2026);
+  payload[6] = 10;
+  payload[7] = 18;
+  payload[8] = 12;
+  payload[9] = 34;
+  payload[10] = static_cast<char>(second);
+  payload[11] = 0x07;  // valid date, time, fully resolved
+  putU4(payload, 16, static_cast<quint32>(-250000));  // -0.25 ms
+  payload[20] = 3;
+  payload[21] = 0x01;  // gnssFixOK
+  payload[23] = 17;
+  putU4(payload, 24, static_cast<quint32>(lonE7));
+  putU4(payload, 28, static_cast<quint32>(latE7));
+  putU4(payload, 36, 545400);   // hMSL, mm
+  putU4(payload, 40, 1500);     // hAcc, mm
+  putU4(payload, 60, 13889);    // gSpeed, mm/s
+  putU4(payload, 64, 8440000);  // headMot, 1e-5 deg
+  putU2(payload, 76, 150);      // pDOP
+  return UbxParser::frame(UbxParser::kClassNav, UbxParser::kIdNavPvt, payload);
+}
+
+QByteArray navDop(quint32 iTow) {
+  QByteArray payload(18, '\0');
+  putU4(payload, 0, iTow);
+  putU2(payload, 6, 150);  // pDOP
+  putU2(payload, 10, 120);  // vDOP
+  putU2(payload, 12, 90);   // hDOP
+  return UbxParser::frame(UbxParser::kClassNav, UbxParser::kIdNavDop, payload);
+}
+
+struct Fed {
+  QList<UbxParser::Message> messages;
+  QList<QByteArray> payloads;  // copies; message payloads are reused
+  QByteArray text;
+};
+
+Fed feed(UbxParser& parser, const QByteArray& data, int chunk) {
+  Fed fed;
+  QByteArray text(data.size(), '\0');
+  for (int start = 0; start < data.size(); start += chunk) {
+    const char* bytes = data.constData() + start;
+    int size = qMin(chunk, static_cast<int>(data.size()) - start);
+    int textSize = 0;
+    while (size > 0) {
+      bool ready = false;
+      const int used = parser.feed(bytes, size, text.data(), &textSize, &ready);
+      bytes += used;
+      size -= used;
+      if (ready) {
+        fed.messages.append(parser.message());
+        fed.payloads.append(QByteArray(reinterpret_cast<const char*>(parser.message().payload),
+                                       parser.message().length));
+      }
+    }
+    fed.text.append(text.constData(), textSize);
+  }
+  return fed;
+}
+
+}  // namespace
+
+class TestUbxParser : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testEncodeKnownFrames() {
+    // From the u-blox protocol specification examples
+    QCOMPARE(UbxParser::cfgRate(5),
+             QByteArray::fromHex("b5 62 06 08 06 00 c8 00 01 00 01 00 de 6a"));
+    QCOMPARE(UbxParser::frame(UbxParser::kClassMon, UbxParser::kIdMonVer),
+             QByteArray::fromHex("b5620a0400000e34"));
+    QCOMPARE(UbxParser::cfgMsg(0xF0, 0x00, 0),
+             QByteArray::fromHex("b5 62 06 01 03 00 f0 00 00 fa 0f"));
+  }
+
+  void testValset() {
+    const QByteArray valset = UbxParser::cfgValset(25, true);
+    QCOMPARE(valset.size(), 4 + 6 + 4 * 5 + 12 * 5 + UbxParser::kOverhead);
+    QCOMPARE(quint8(valset[3]), UbxParser::kIdCfgValset);
+    QCOMPARE(quint8(valset[7]), quint8(0x01));  // RAM layer
+    // CFG-RATE-MEAS = 40 ms
+    QCOMPARE(valset.mid(10, 6), QByteArray::fromHex("01 00 21 30 28 00"));
+    QCOMPARE(UbxParser::cfgValset(10, false).size(), 4 + 6 + 4 * 5 + UbxParser::kOverhead);
+
+    // Every frame of the setup sequence is well formed
+    UbxParser parser;
+    const Fed fed = feed(parser, UbxParser::configuration(10, true), 4096);
+    QCOMPARE(fed.messages.size(), 1 + 2 + 6 + 1);
+    QVERIFY(fed.text.isEmpty());
+  }
+
+  void testFramingAroundText() {
+    const QByteArray stream = "$GPTXT,01,01,02,hello*00\r\n" + navPvt(1000, 1, 481173000, 0) +
+                              "\xB5 stray sync\r\n" + navDop(2000) + navPvt(2000, 2, 0, 0);
+    for (int chunk : {1, 7, 4096}) {
+      UbxParser parser;
+      const Fed fed = feed(parser, stream, chunk);
+      QCOMPARE(fed.messages.size(), 3);
+      QCOMPARE(fed.text, QByteArray("$GPTXT,01,01,02,hello*00\r\n\xB5 stray sync\r\n"));
+      QCOMPARE(fed.messages[1].id, UbxParser::kIdNavDop);
+      QCOMPARE(parser.stats().frames, quint64(3));
+      QCOMPARE(parser.stats().checksumErrors, quint64(0));
+    }
+  }
+
+  void testChecksumAndOversizedFrames() {
+    QByteArray corrupt = navPvt(1000, 1, 0, 0);
+    corrupt[30] = static_cast<char>(corrupt[30] ^ 0x01);
+    QByteArray oversized = UbxParser::frame(0x01, 0x35, QByteArray(1500, 'x'));
+
+    UbxParser parser;
+    const Fed fed = feed(parser, corrupt + oversized + navPvt(2000, 2, 0, 0), 64);
+    QCOMPARE(fed.messages.size(), 1);
+    QCOMPARE(parser.stats().checksumErrors, quint64(1));
+    QCOMPARE(parser.stats().oversized, quint64(1));
+  }
+
+  void testDecodeNavPvt() {
+    UbxParser parser;
+    const Fed fed = feed(parser, navPvt(123456, 56, 481173000, -1234567890), 4096);
+    QCOMPARE(fed.messages.size(), 1);
+    UbxParser::Message message = fed.messages.first();
+    message.payload = reinterpret_cast<const quint8*>(fed.payloads.first().constData());
+
+    UbxParser::NavPvt pvt;
+    QVERIFY(UbxParser::decodeNavPvt(message, &pvt));
+    QCOMPARE(pvt.iTowMs, quint32(123456));
+    QCOMPARE(pvt.year, quint16(2026));
+    QCOMPARE(pvt.second, quint8(56));
+    QVERIFY(pvt.validDate && pvt.validTime && pvt.gnssFixOk);
+    QCOMPARE(pvt.fixType, quint8(3));
+    QCOMPARE(pvt.satellites, quint8(17));
+    QVERIFY(std::fabs(pvt.latitude - 48.1173) < 1e-9);
+    QVERIFY(std::fabs(pvt.longitude + 123.456789) < 1e-9);
+    QCOMPARE(pvt.altitude, 545.4);
+    QCOMPARE(pvt.speed, 13.889);
+    QVERIFY(std::fabs(pvt.heading - 84.4) < 1e-9);
+    QCOMPARE(pvt.pdop, 1.5);
+
+    UbxParser::NavDop dop;
+    QVERIFY(!UbxParser::decodeNavDop(message, &dop));
+    message.length = 40;
+    QVERIFY(!UbxParser::decodeNavPvt(message, &pvt));
+  }
+
+  void testDeviceDetectsAndConfiguresReceiver() {
+    MockTransport transport;
+    GPSDevice device(&transport);
+    QSignalSpy detected(&device, &GPSDevice::protocolDetected);
+    QVERIFY(device.initialize());
+
+    // Auto detection polls for the receiver version
+    QCOMPARE(transport.getWrittenData(), UbxParser::frame(UbxParser::kClassMon,
+                                                          UbxParser::kIdMonVer));
+    transport.clearWrittenData();
+
+    QList<GPSLocation> updates;
+    connect(&device, &GPSDevice::locationUpdated, this,
+            [&](const GPSLocation& location) { updates.append(location); });
+
+    // Recorded start-up: NMEA until the answer arrives, then UBX epochs with
+    // the last NMEA sentences still interleaved
+    const QByteArray gga = "$GPGGA,123400,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*4E\r\n";
+    QByteArray stream = gga + gga;
+    stream += UbxParser::frame(UbxParser::kClassMon, UbxParser::kIdMonVer,
+                               QByteArray("ROM SPG 5.10 (7b202e)").leftJustified(40, '\0'));
+    for (int second = 1; second <= 3; ++second) {
+      const quint32 iTow = 1000u * static_cast<quint32>(second);
+      stream += navDop(iTow) + navPvt(iTow, second, 481173000 + second, 115166666) + gga;
+    }
+    for (int start = 0; start < stream.size(); start += 13) {
+      transport.injectData(stream.mid(start, 13));
+    }
+
+    QCOMPARE(detected.count(), 2);
+    QCOMPARE(detected.at(0).first().value<GPSDevice::Protocol>(), GPSDevice::Protocol::NMEA);
+    QCOMPARE(device.protocol(), GPSDevice::Protocol::UBX);
+    QCOMPARE(transport.getWrittenData(), UbxParser::configuration(10, true));
+
+    // Two NMEA epochs before the switch, then one update per NAV-PVT
+    QCOMPARE(updates.size(), 2 + 3);
+    const GPSLocation location = updates.last();
+    QVERIFY(std::fabs(location.latitude - 48.1173003) < 1e-9);
+    QVERIFY(std::fabs(location.longitude - 11.5166666) < 1e-9);
+    QCOMPARE(location.altitude, 545.4);
+    QCOMPARE(location.speed, 13.889);
+    QCOMPARE(location.satellites, quint8(17));
+    QCOMPARE(location.fixType, QString("3D"));
+    QCOMPARE(location.hdop, 0.9);
+    QCOMPARE(location.vdop, 1.2);
+    QCOMPARE(location.timestamp,
+             QDateTime(QDate(2026, 10, 18), QTime(12, 34, 3), QTimeZone::utc()));
+    QCOMPARE(device.ubxStats().frames, quint64(1 + 2 * 3));
+
+    // Changing the rate reconfigures the receiver
+    transport.clearWrittenData();
+    QVERIFY(device.setConfig("updateRateHz", 25));
+    QCOMPARE(transport.getWrittenData(), UbxParser::configuration(25, true));
+  }
+
+  void testRateFitsBaudRate() {
+    // 126 bytes of NAV-PVT and NAV-DOP per epoch against 960 bytes/s
+    QCOMPARE(UbxParser::maxRateHz(9600, true), 7);
+    QCOMPARE(UbxParser::maxRateHz(9600, false), 1);
+    QCOMPARE(UbxParser::maxRateHz(115200, true), 25);
+    QCOMPARE(UbxParser::maxRateHz(0, true), 25);
+
+    MockTransport transport;
+    transport.configure("baudRate", 9600);
+    GPSDevice device(&transport);
+    device.setConfig("protocol", "ubx");
+    QVERIFY(device.initialize());
+    QCOMPARE(transport.getWrittenData(), UbxParser::configuration(7, true));
+  }
+
+  void testNmeaOnlyDoesNotProbe() {
+    MockTransport transport;
+    GPSDevice device(&transport);
+    device.setConfig("protocol", "nmea");
+    QVERIFY(device.initialize());
+    QVERIFY(transport.getWrittenData().isEmpty());
+
+    transport.injectData(UbxParser::frame(UbxParser::kClassMon, UbxParser::kIdMonVer));
+    QCOMPARE(device.protocol(), GPSDevice::Protocol::Unknown);
+    QCOMPARE(device.ubxStats().frames, quint64(0));
+  }
+};
+
+QTEST_MAIN(TestUbxParser)
+#include "test_ubx_parser.moc"
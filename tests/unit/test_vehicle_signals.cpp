@@ -0,0 +1,276 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <cstring>
+
+#include "../core/hal/functional/CANDevice.h"
+#include "../core/hal/mocks/transport/MockTransport.h"
+#include "../core/services/eventbus/EventBus.h"
+#include "../core/services/profile/ProfileManager.h"
+#include "../core/services/vehicle/DbcDatabase.h"
+#include "../core/services/vehicle/SignalDecoder.h"
+#include "../core/services/vehicle/VehicleSignalService.h"
+
+namespace {
+
+const QByteArray kDbc = R"(VERSION ""
+
+NS_ :
+    CM_
+    VAL_
+
+BU_: ECU GW
+
+BO_ 256 Speed: 8 ECU
+ SG_ VehicleSpeed : 0|16@1+ (0.01,0) [0|655.35] "km/h" GW
+ SG_ Acceleration : 16|12@1- (0.01,0) [-20.48|20.47] "m/s2" GW
+ SG_ EngineRpm : 39|16@0+ (0.25,0) [0|16383.75] "rpm" GW
+
+BO_ 2566844416 Transmission: 4 ECU
+ SG_ Gear : 0|4@1+ (1,0) [0|15] "" GW
+
+BO_ 512 Lights: 8 ECU
+ SG_ Page M : 0|8@1+ (1,0) [0|255] "" GW
+ SG_ Headlights m1 : 8|1@1+ (1,0) [0|1] "" GW
+ SG_ Wipers m2 : 8|2@1+ (1,0) [0|3] "" GW
+
+CM_ SG_ 256 VehicleSpeed "Wheel-based speed";
+VAL_ 2566844416 Gear 0 "P" 1 "R" 2 "N" 3 "D" ;
+)";
+
+CANFrame makeFrame(quint32 id, bool extended, const QByteArray& data, qint64 timestampNs = 1) {
+  CANFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.id = id;
+  frame.extended = extended;
+  frame.length = static_cast<quint8>(data.size());
+  memcpy(frame.data, data.constData(), data.size());
+  frame.timestampNs = timestampNs;
+  return frame;
+}
+
+QList<QVariantMap> payloadsFor(const QSignalSpy& spy, const QString& topic) {
+  QList<QVariantMap> payloads;
+  for (const QList<QVariant>& arguments : spy) {
+    if (arguments.at(0).toString() == topic) {
+      payloads.append(arguments.at(1).toMap());
+    }
+  }
+  return payloads;
+}
+
+}  // namespace
+
+class TestVehicleSignals : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void testParseDbc() {
+    DbcDatabase database;
+    QString error;
+    QVERIFY2(database.parse(kDbc, &error), qPrintable(error));
+    QCOMPARE(database.messages().size(), 3);
+
+    const DbcMessage* speed = database.message(256, false);
+    QVERIFY(speed);
+    QCOMPARE(speed->signalDefs.size(), 3);
+    QCOMPARE(speed->signalDefs[0].factor, 0.01);
+    QCOMPARE(speed->signalDefs[0].unit, QString("km/h"));
+    QVERIFY(speed->signalDefs[1].isSigned);
+    QVERIFY(speed->signalDefs[2].bigEndian);
+
+    const DbcMessage* transmission = database.message(0x18FF0000, true);
+    QVERIFY(transmission);
+    QVERIFY(!database.message(0x18FF0000, false));
+    QCOMPARE(transmission->signalDefs[0].valueNames.value(3), QString("D"));
+
+    int message = -1;
+    int signal = -1;
+    QVERIFY(database.findSignal("Lights.Wipers", &message, &signal));
+    QCOMPARE(database.messages()[message].signalDefs[signal].multiplexValue, 2);
+    QVERIFY(database.messages()[message].signalDefs[0].multiplexer);
+    QVERIFY(!database.findSignal("Speed.Gear", &message, &signal));
+
+    // Signals that cannot be decoded are skipped; the rest of the file loads
+    QVERIFY2(database.parse("BO_ 1 Mixed: 8 ECU\n"
+                            " SG_ X : 0|0@1+ (1,0) [0|0] \"\" GW\n"
+                            " SG_ Y : 0|8@1+ (1,0) [0|255] \"\" GW\n"
+                            " SG_ Mode m3M : 8|4@1+ (1,0) [0|15] \"\" GW\n"
+                            " SG_ Z m3 : 12|8@1+ 1,0 [0|255] \"\" GW\n",
+                            &error),
+             qPrintable(error));
+    const DbcMessage* mixed = database.message(1, false);
+    QVERIFY(mixed);
+    QCOMPARE(mixed->signalDefs.size(), 2);
+    QCOMPARE(mixed->signalDefs[0].name, QString("Y"));
+    QCOMPARE(mixed->signalDefs[1].multiplexValue, 3);
+    QVERIFY(!mixed->signalDefs[1].multiplexer);
+
+    QVERIFY(!database.parse("BO_ 1 A: 8 ECU\nBO_ 1 B: 8 ECU\n", &error));
+    QVERIFY(error.contains("line 2"));
+  }
+
+  void testDecodeSubscribedSignals() {
+    DbcDatabase database;
+    QVERIFY(database.parse(kDbc));
+    SignalDecoder decoder(&database);
+    const int speed = decoder.subscribe("VehicleSpeed");
+    const int acceleration = decoder.subscribe("Acceleration");
+    const int rpm = decoder.subscribe("EngineRpm");
+    QVERIFY(speed >= 0 && acceleration >= 0 && rpm >= 0);
+    QCOMPARE(decoder.subscribe("VehicleSpeed"), speed);
+    QCOMPARE(decoder.subscribe("Nope"), -1);
+
+    // 88.88 km/h, -1.00 m/s2 (0xF9C), 3000 rpm big-endian in bytes 4-5
+    const QByteArray data("\xB8\x22\x9C\x0F\x2E\xE0\x00\x00", 8);
+    QList<int> changed;
+    auto onChange = [&changed](int slot, const SignalDecoder::Value&) { changed.append(slot); };
+    QCOMPARE(decoder.decode(makeFrame(256, false, data), onChange), 3);
+    QCOMPARE(changed.size(), 3);
+    QCOMPARE(decoder.value(speed).physical, 88.88);
+    QCOMPARE(decoder.value(acceleration).physical, -1.0);
+    QCOMPARE(decoder.value(rpm).physical, 3000.0);
+
+    // Same frame again: decoded, but nothing changed
+    changed.clear();
+    QCOMPARE(decoder.decode(makeFrame(256, false, data), onChange), 3);
+    QVERIFY(changed.isEmpty());
+
+    // Unsubscribed and truncated frames cost nothing
+    QCOMPARE(decoder.decode(makeFrame(0x300, false, data), onChange), 0);
+    QCOMPARE(decoder.decode(makeFrame(256, false, data.left(4)), onChange), 0);
+  }
+
+  void testMultiplexedAndExtended() {
+    DbcDatabase database;
+    QVERIFY(database.parse(kDbc));
+    SignalDecoder decoder(&database);
+    const int headlights = decoder.subscribe("Headlights");
+    const int wipers = decoder.subscribe("Lights.Wipers");
+    const int gear = decoder.subscribe("Gear");
+    auto ignore = [](int, const SignalDecoder::Value&) {};
+
+    QCOMPARE(decoder.decode(makeFrame(512, false, QByteArray("\x01\x01", 2)), ignore), 1);
+    QCOMPARE(decoder.value(headlights).raw, qint64(1));
+    QVERIFY(!decoder.value(wipers).valid);
+    QCOMPARE(decoder.decode(makeFrame(512, false, QByteArray("\x02\x03", 2)), ignore), 1);
+    QCOMPARE(decoder.value(wipers).raw, qint64(3));
+    QCOMPARE(decoder.value(headlights).raw, qint64(1));
+
+    // The same ID as an 11-bit frame is a different message
+    QCOMPARE(decoder.decode(makeFrame(0x18FF0000, false, QByteArray(4, '\x03')), ignore), 0);
+    QCOMPARE(decoder.decode(makeFrame(0x18FF0000, true, QByteArray(4, '\x03')), ignore), 1);
+    QCOMPARE(decoder.value(gear).raw, qint64(3));
+  }
+
+  void testPublishesChangesOnEventBus() {
+    VehicleSignalService service;
+    QVERIFY(service.loadDbcText(kDbc));
+    QVERIFY(service.subscribe("Gear", 0));
+    QSignalSpy bus(&EventBus::instance(), &EventBus::messagePublished);
+
+    const CANFrame frames[] = {
+        makeFrame(0x18FF0000, true, QByteArray("\x00\x00\x00\x00", 4)),
+        makeFrame(0x18FF0000, true, QByteArray("\x00\x00\x00\x00", 4)),
+        makeFrame(0x18FF0000, true, QByteArray("\x03\x00\x00\x00", 4)),
+    };
+    service.processFrames(frames, 3);
+
+    const QList<QVariantMap> gears = payloadsFor(bus, "vehicle/signals/Gear");
+    QCOMPARE(gears.size(), 2);
+    QCOMPARE(gears[0].value("label").toString(), QString("P"));
+    QCOMPARE(gears[1].value("label").toString(), QString("D"));
+    QCOMPARE(gears[1].value("value").toDouble(), 3.0);
+    QCOMPARE(service.framesDecoded(), quint64(3));
+  }
+
+  void testRateLimitKeepsLatestValue() {
+    VehicleSignalService service;
+    QVERIFY(service.loadDbcText(kDbc));
+    QVERIFY(service.subscribe("VehicleSpeed", 50));
+    QSignalSpy changes(&service, &VehicleSignalService::signalChanged);
+
+    for (int kph = 10; kph <= 50; kph += 10) {
+      const quint16 raw = static_cast<quint16>(kph * 100);
+      const CANFrame frame = makeFrame(256, false, QByteArray(reinterpret_cast<const char*>(&raw),
+                                                              2) + QByteArray(6, '\0'));
+      service.processFrames(&frame, 1);
+    }
+    // The first change goes out at once, the burst collapses into its last value
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(changes.at(0).at(1).toDouble(), 10.0);
+    QTRY_COMPARE(changes.count(), 2);
+    QCOMPARE(changes.at(1).at(1).toDouble(), 50.0);
+    QTest::qWait(80);
+    QCOMPARE(changes.count(), 2);
+  }
+
+  void testProfileSpeedFeedsDrivingMode() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("vehicle.dbc");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(kDbc);
+    file.close();
+
+    VehicleProfile profile;
+    profile.name = "Test";
+    profile.properties["dbc.file"] = path;
+    profile.properties["dbc.signals"] = QStringList{"Gear"};
+    profile.properties["dbc.speedSignal"] = "VehicleSpeed";
+    profile.properties["dbc.rateLimitMs"] = 0;
+
+    VehicleSignalService service;
+    QString error;
+    QVERIFY2(service.configure(profile, &error), qPrintable(error));
+    QSignalSpy speeds(&service, &VehicleSignalService::vehicleSpeedUpdated);
+    QSignalSpy samples(&service, &VehicleSignalService::speedSampled);
+
+    // Frames arrive through CANDevice batches, here from an SLCAN adapter
+    MockTransport transport;
+    CANDevice device(&transport);
+    QVERIFY(device.initialize());
+    service.attach(&device);
+    transport.injectData("t10081027000000000000\r");  // 0x2710 = 100.00 km/h
+
+    QCOMPARE(speeds.count(), 1);
+    QVERIFY(qAbs(speeds.first().first().toFloat() - 62.1371f) < 0.01f);
+    QCOMPARE(samples.count(), 1);
+    QVERIFY(qAbs(samples.first().at(0).toDouble() - 27.7778) < 0.001);
+    QVERIFY(samples.first().at(1).toLongLong() > 0);
+
+    // An unchanged speed is still a measurement for sensor fusion
+    transport.injectData("t10081027000000000000\r");
+    QCOMPARE(speeds.count(), 1);
+    QCOMPARE(samples.count(), 2);
+    bool valid = false;
+    QCOMPARE(service.value("VehicleSpeed", &valid), 100.0);
+    QVERIFY(valid);
+
+    profile.properties["dbc.speedSignal"] = "Gear";
+    QVERIFY(!service.configure(profile, &error));  // not a speed
+  }
+};
+
+QTEST_MAIN(TestVehicleSignals)
+#include "test_vehicle_signals.moc"
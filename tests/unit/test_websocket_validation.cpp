@@ -17,6 +17,7 @@
  *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTest>
@@ -26,6 +27,7 @@ class WebSocketServerValidator {
  public:
   static bool validateMessage(const QJsonObject& obj, QString& error) {
     static const QSet<QString> allowedTypes = {QStringLiteral("subscribe"),
+                                                QStringLiteral("subscribe_many"),
                                                 QStringLiteral("unsubscribe"),
                                                 QStringLiteral("publish"),
                                                 QStringLiteral("service_command")};
@@ -44,6 +46,24 @@ class WebSocketServerValidator {
       }
     }
 
+    if (type == "subscribe_many") {
+      const QJsonArray topics = obj.value("topics").toArray();
+      if (!obj.value("topics").isArray() || topics.isEmpty()) {
+        error = QStringLiteral("missing_topics");
+        return false;
+      }
+      if (topics.size() > 64) {
+        error = QStringLiteral("too_many_topics");
+        return false;
+      }
+      for (const auto& topic : topics) {
+        if (!topic.isString() || topic.toString().isEmpty()) {
+          error = QStringLiteral("invalid_topics");
+          return false;
+        }
+      }
+    }
+
     if (type == "publish") {
       if (!obj.contains("payload") || !obj.value("payload").isObject()) {
         error = QStringLiteral("invalid_payload");
@@ -70,7 +90,10 @@ class WebSocketServerValidator {
                                                    QStringLiteral("start_service"),
                                                    QStringLiteral("stop_service"),
                                                    QStringLiteral("restart_service"),
-                                                   QStringLiteral("get_running_services")};
+                                                   QStringLiteral("get_running_services"),
+                                                   QStringLiteral("profile_start"),
+                                                   QStringLiteral("profile_stop"),
+                                                   QStringLiteral("dump_flight_recorder")};
 
     if (!allowedCommands.contains(command)) {
       error = QStringLiteral("unauthorised_command");
@@ -110,6 +133,54 @@ class TestWebSocketValidation : public QObject {
     QCOMPARE(error, "missing_topic");
   }
 
+  // Subscribe-many message tests
+  void testSubscribeManyValid() {
+    QJsonObject msg;
+    msg["type"] = "subscribe_many";
+    msg["topics"] = QJsonArray{"ui/*", "system/*", "android-auto/status/#"};
+    QString error;
+    QVERIFY(WebSocketServerValidator::validateMessage(msg, error));
+  }
+
+  void testSubscribeManyMissingTopics() {
+    QJsonObject msg;
+    msg["type"] = "subscribe_many";
+    QString error;
+    QVERIFY(!WebSocketServerValidator::validateMessage(msg, error));
+    QCOMPARE(error, "missing_topics");
+  }
+
+  void testSubscribeManyEmptyTopics() {
+    QJsonObject msg;
+    msg["type"] = "subscribe_many";
+    msg["topics"] = QJsonArray();
+    QString error;
+    QVERIFY(!WebSocketServerValidator::validateMessage(msg, error));
+    QCOMPARE(error, "missing_topics");
+  }
+
+  void testSubscribeManyInvalidTopic() {
+    QJsonObject msg;
+    msg["type"] = "subscribe_many";
+    msg["topics"] = QJsonArray{"ui/*", ""};
+    QString error;
+    QVERIFY(!WebSocketServerValidator::validateMessage(msg, error));
+    QCOMPARE(error, "invalid_topics");
+  }
+
+  void testSubscribeManyTooManyTopics() {
+    QJsonArray topics;
+    for (int i = 0; i < 65; ++i) {
+      topics.append(QString("topic/%1").arg(i));
+    }
+    QJsonObject msg;
+    msg["type"] = "subscribe_many";
+    msg["topics"] = topics;
+    QString error;
+    QVERIFY(!WebSocketServerValidator::validateMessage(msg, error));
+    QCOMPARE(error, "too_many_topics");
+  }
+
   // Unsubscribe message tests
   void testUnsubscribeValid() {
     QJsonObject msg;
@@ -254,6 +325,21 @@ class TestWebSocketValidation : public QObject {
     QVERIFY(WebSocketServerValidator::validateServiceCommand("get_running_services", error));
   }
 
+  void testAllowedServiceCommand_ProfileStart() {
+    QString error;
+    QVERIFY(WebSocketServerValidator::validateServiceCommand("profile_start", error));
+  }
+
+  void testAllowedServiceCommand_ProfileStop() {
+    QString error;
+    QVERIFY(WebSocketServerValidator::validateServiceCommand("profile_stop", error));
+  }
+
+  void testAllowedServiceCommand_DumpFlightRecorder() {
+    QString error;
+    QVERIFY(WebSocketServerValidator::validateServiceCommand("dump_flight_recorder", error));
+  }
+
   void testUnauthorisedServiceCommand() {
     QString error;
     QVERIFY(!WebSocketServerValidator::validateServiceCommand("delete_service", error));
@@ -0,0 +1,193 @@
+/*
+ * Project: Crankshaft
+ * This file is part of Crankshaft project.
+ * Copyright (C) 2025 OpenCarDev Team
+ *
+ *  Crankshaft is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Crankshaft is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Crankshaft. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Offline decoder for crankshaft-core flight recorder dumps: prints the
+// records as a timeline relative to the moment of the dump.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "FlightRecordFormat.h"
+
+using namespace crankshaft::diagnostics::flight;
+
+namespace {
+
+const char* const kAaStates[] = {"DISCONNECTED", "SEARCHING", "CONNECTING", "AUTHENTICATING",
+                                 "SECURING",     "CONNECTED", "DISCONNECTING", "ERROR"};
+const char* const kMixerChannels[] = {"MEDIA", "SYSTEM", "SPEECH", "TELEPHONY"};
+
+template <size_t N>
+const char* nameOf(const char* const (&names)[N], uint32_t value) {
+  return value < N ? names[value] : "?";
+}
+
+void usage(const char* argv0) {
+  std::fprintf(stderr,
+               "Usage: %s [--csv] [--topics FILE] DUMP\n"
+               "  --csv          one row per record instead of a timeline\n"
+               "  --topics FILE  topic names, one per line, to label EventBus publishes\n",
+               argv0);
+}
+
+std::string wallClock(uint64_t realtimeNs) {
+  const time_t seconds = static_cast<time_t>(realtimeNs / 1000000000ULL);
+  tm utc{};
+  gmtime_r(&seconds, &utc);
+  char text[40];
+  const size_t length = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+  std::snprintf(text + length, sizeof(text) - length, ".%03uZ",
+                static_cast<unsigned>(realtimeNs / 1000000ULL % 1000));
+  return text;
+}
+
+std::string describe(const Record& record, const std::map<uint32_t, std::string>& topics,
+                     uint64_t* lastPopNs) {
+  char text[160];
+  switch (static_cast<Event>(record.event)) {
+    case Event::Marker:
+      std::snprintf(text, sizeof(text), "dump (%s, detail %" PRIu32 ")", reasonName(record.code),
+                    record.a);
+      break;
+    case Event::AaState:
+      std::snprintf(text, sizeof(text), "%s -> %s", nameOf(kAaStates, record.a),
+                    nameOf(kAaStates, record.code));
+      break;
+    case Event::DecoderPush:
+      std::snprintf(text, sizeof(text), "frame %" PRIu64 " in, %" PRIu32 " bytes", record.b,
+                    record.a);
+      break;
+    case Event::DecoderPop: {
+      // The gap between decoded frames is what a user sees as a freeze
+      const double gapMs = *lastPopNs ? (record.timestampNs - *lastPopNs) / 1e6 : 0.0;
+      *lastPopNs = record.timestampNs;
+      std::snprintf(text, sizeof(text), "frame %" PRIu64 " out, %ux%u, gap %.1f ms", record.b,
+                    record.a >> 16, record.a & 0xffff, gapMs);
+      break;
+    }
+    case Event::MixerUnderrun:
+      std::snprintf(text, sizeof(text), "%s short by %" PRIu32 " bytes (%" PRIu64 " buffered)",
+                    nameOf(kMixerChannels, record.code), record.a, record.b);
+      break;
+    case Event::WsQueue:
+      std::snprintf(text, sizeof(text),
+                    "%u client(s), message %" PRIu32 " bytes, %" PRIu64 " bytes queued",
+                    record.code, record.a, record.b);
+      break;
+    case Event::EventBusPublish: {
+      const auto topic = topics.find(record.a);
+      if (topic != topics.end()) {
+        std::snprintf(text, sizeof(text), "%s (#%" PRIu64 ")", topic->second.c_str(), record.b);
+      } else {
+        std::snprintf(text, sizeof(text), "topic %08" PRIx32 " (#%" PRIu64 ")", record.a,
+                      record.b);
+      }
+      break;
+    }
+    case Event::LoopStall:
+      std::snprintf(text, sizeof(text), "thread %" PRIu64 " unresponsive for %" PRIu32 " ms",
+                    record.b, record.a);
+      break;
+    default:
+      std::snprintf(text, sizeof(text), "code %u a %" PRIu32 " b %" PRIu64, record.code,
+                    record.a, record.b);
+      break;
+  }
+  return text;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool csv = false;
+  std::string topicsPath;
+  std::string dumpPath;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--csv") {
+      csv = true;
+    } else if (arg == "--topics" && i + 1 < argc) {
+      topicsPath = argv[++i];
+    } else if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return 0;
+    } else if (dumpPath.empty() && arg[0] != '-') {
+      dumpPath = arg;
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (dumpPath.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::map<uint32_t, std::string> topics;
+  if (!topicsPath.empty()) {
+    std::ifstream input(topicsPath);
+    for (std::string line; std::getline(input, line);) {
+      if (!line.empty()) topics[topicHash(line.data(), line.size())] = line;
+    }
+  }
+
+  DumpHeader header{};
+  std::vector<Record> records;
+  std::string error;
+  if (!readDump(dumpPath, &header, &records, &error)) {
+    std::fprintf(stderr, "%s: %s\n", dumpPath.c_str(), error.c_str());
+    return 1;
+  }
+
+  uint64_t lastPopNs = 0;
+  if (csv) {
+    std::printf("offset_ms,wall_clock,tid,event,code,a,b,description\n");
+  } else {
+    std::printf("# pid %" PRIu32 ", %s dump", header.pid, reasonName(header.reason));
+    if (header.reason == static_cast<uint16_t>(DumpReason::Crash)) {
+      std::printf(" (signal %u)", header.detail);
+    }
+    std::printf(" at %s\n", wallClock(header.dumpRealtimeNs).c_str());
+    std::printf("# %zu records shown, %" PRIu64 " written, ring holds %" PRIu64 "\n",
+                records.size(), header.head, header.capacity);
+  }
+
+  for (const Record& record : records) {
+    // Negative offsets: how long before the dump the event happened
+    const double offsetMs =
+        -static_cast<double>(header.dumpMonotonicNs - record.timestampNs) / 1e6;
+    const std::string text = describe(record, topics, &lastPopNs);
+    if (csv) {
+      const uint64_t wallNs = header.dumpRealtimeNs - (header.dumpMonotonicNs - record.timestampNs);
+      std::printf("%.3f,%s,%" PRIu32 ",%s,%u,%" PRIu32 ",%" PRIu64 ",\"%s\"\n", offsetMs,
+                  wallClock(wallNs).c_str(), record.tid, eventName(record.event), record.code,
+                  record.a, record.b, text.c_str());
+    } else {
+      std::printf("%12.3f ms  %7" PRIu32 "  %-16s  %s\n", offsetMs, record.tid,
+                  eventName(record.event), text.c_str());
+    }
+  }
+  return 0;
+}
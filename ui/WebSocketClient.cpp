@@ -20,6 +20,7 @@
 #include "WebSocketClient.h"
 
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTimer>
@@ -65,6 +66,41 @@ void WebSocketClient::subscribe(const QString& topic) {
   }
 }
 
+void WebSocketClient::subscribeMany(const QStringList& topics) {
+  QStringList added;
+  for (const auto& topic : topics) {
+    if (!topic.isEmpty() && !m_subscriptions.contains(topic)) {
+      m_subscriptions.append(topic);
+      added.append(topic);
+    }
+  }
+
+  if (added.isEmpty()) {
+    return;
+  }
+  if (isConnected()) {
+    sendSubscribeMany(added);
+  } else {
+    qDebug() << "[WebSocketClient] Not connected -" << added.size()
+             << "subscription(s) will be sent on connect";
+  }
+}
+
+void WebSocketClient::sendSubscribeMany(const QStringList& topics) {
+  int messages = 0;
+  for (qsizetype i = 0; i < topics.size(); i += kMaxTopicsPerMessage) {
+    QJsonObject obj;
+    obj["type"] = "subscribe_many";
+    obj["topics"] = QJsonArray::fromStringList(topics.mid(i, kMaxTopicsPerMessage));
+
+    QJsonDocument doc(obj);
+    m_socket->sendTextMessage(doc.toJson(QJsonDocument::Compact));
+    ++messages;
+  }
+  qDebug() << "[WebSocketClient] Subscribed to" << topics.size() << "topic(s) in" << messages
+           << "message(s)";
+}
+
 void WebSocketClient::unsubscribe(const QString& topic) {
   m_subscriptions.removeAll(topic);
 
@@ -99,11 +135,9 @@ void WebSocketClient::onConnected() {
   qDebug() << "[WebSocketClient] WebSocket connected!";
   emit connectedChanged();
 
-  // Re-subscribe to all topics
-  qDebug() << "[WebSocketClient] Re-subscribing to" << m_subscriptions.size() << "topics";
-  for (const auto& topic : std::as_const(m_subscriptions)) {
-    qDebug() << "[WebSocketClient] Re-subscribing to:" << topic;
-    subscribe(topic);
+  // Re-subscribe to all topics in as few round trips as the server allows
+  if (!m_subscriptions.isEmpty()) {
+    sendSubscribeMany(m_subscriptions);
   }
 }
 
@@ -134,7 +168,25 @@ void WebSocketClient::onTextMessageReceived(const QString& message) {
     qDebug() << "[WebSocketClient] Event received - Topic:" << topic;
     qDebug() << "[WebSocketClient] Payload:" << payload;
     emit eventReceived(topic, payload);
+  } else if (type == "snapshot") {
+    applySnapshot(obj);
+  }
+}
+
+void WebSocketClient::applySnapshot(const QJsonObject& snapshot) {
+  // Replay retained state as ordinary events so existing handlers populate
+  // screens immediately; live events that follow simply overwrite them.
+  const QJsonArray events = snapshot.value("events").toArray();
+  qDebug() << "[WebSocketClient] Applying state snapshot with" << events.size() << "event(s)";
+  for (const auto& value : events) {
+    const QJsonObject event = value.toObject();
+    QVariantMap payload = event.value("payload").toObject().toVariantMap();
+    if (event.value("restored").toBool()) {
+      payload.insert("restored", true);
+    }
+    emit eventReceived(event.value("topic").toString(), payload);
   }
+  emit snapshotReceived(events.size());
 }
 
 void WebSocketClient::onError(QAbstractSocket::SocketError error) {
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <QJsonObject>
 #include <QObject>
 #include <QUrl>
 #include <QVariantMap>
@@ -32,6 +33,7 @@ class WebSocketClient : public QObject {
   explicit WebSocketClient(const QUrl& url, QObject* parent = nullptr);
 
   Q_INVOKABLE void subscribe(const QString& topic);
+  Q_INVOKABLE void subscribeMany(const QStringList& topics);
   Q_INVOKABLE void unsubscribe(const QString& topic);
   Q_INVOKABLE void publish(const QString& topic, const QVariantMap& payload);
 
@@ -39,6 +41,7 @@ class WebSocketClient : public QObject {
 
  signals:
   void eventReceived(const QString& topic, const QVariantMap& payload);
+  void snapshotReceived(int eventCount);
   void connectedChanged();
   void errorOccurred(const QString& error);
 
@@ -49,7 +52,12 @@ class WebSocketClient : public QObject {
   void onError(QAbstractSocket::SocketError error);
 
  private:
+  static constexpr int kMaxTopicsPerMessage = 64;  // the server rejects larger batches
+
   void reconnect();
+  // Sends subscribe_many messages of at most kMaxTopicsPerMessage topics each
+  void sendSubscribeMany(const QStringList& topics);
+  void applySnapshot(const QJsonObject& snapshot);
 
   QWebSocket* m_socket;
   QUrl m_url;
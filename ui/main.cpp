@@ -82,8 +82,7 @@ int main(int argc, char* argv[]) {
   WebSocketClient* wsClient = new WebSocketClient(QUrl(serverUrl));
 
   // Subscribe to common topics
-  wsClient->subscribe("ui/*");
-  wsClient->subscribe("system/*");
+  wsClient->subscribeMany({"ui/*", "system/*"});
   qInfo() << "[STARTUP]" << startupTimer.elapsed() << "ms elapsed: WebSocket client created";
 
   // Create QML engine